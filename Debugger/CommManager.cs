@@ -16,6 +16,10 @@ namespace Debugger
         public const uint DebugCodeReportRegisterFile = 8;
         public const uint DebugCodeReportBaseRegister = 9;
         public const uint DebugCodeReportRegisterContestion = 10;
+        public const uint DebugCodeReportRegisterSnapshot = 11;
+
+        public const uint RegisterSnapshotVersion = 1;
+        public const uint RegisterSnapshotFlagFull = 1;
 
         private NamedPipeServerStream? _steppingPipe;
         private NamedPipeServerStream? _infoPipe;
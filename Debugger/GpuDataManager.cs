@@ -64,6 +64,10 @@ namespace Debugger
 
                         RegistersDirty = true;
                     }
+                    else if(dataHeader.DataCode == CommManager.DebugCodeReportRegisterSnapshot)
+                    {
+                        ReadRegisterSnapshot(dataHeader.DataLength);
+                    }
                     else if(dataHeader.DataCode == CommManager.DebugCodeReportBaseRegister)
                     {
                         uint sm = _commManager.InfoReader.ReadUInt32();
@@ -103,5 +107,42 @@ namespace Debugger
 
             }
         }
+
+        // Applies a register file snapshot, see RegisterFileSnapshot.hpp for the wire format.
+        private void ReadRegisterSnapshot(uint dataLength)
+        {
+            BinaryReader reader = _commManager.InfoReader;
+
+            uint version = reader.ReadUInt32();
+
+            if(version != CommManager.RegisterSnapshotVersion)
+            {
+                // We don't know how to read this version, skip the rest of the snapshot.
+                reader.ReadBytes((int)(dataLength - sizeof(uint)));
+                return;
+            }
+
+            uint sm = reader.ReadUInt32();
+            reader.ReadUInt32(); // Flags, full snapshots are a single run covering every register.
+            uint runCount = reader.ReadUInt32();
+
+            for(uint run = 0; run < runCount; ++run)
+            {
+                uint baseRegister = reader.ReadUInt16();
+                uint registerCount = reader.ReadUInt16();
+
+                for(uint i = 0; i < registerCount; ++i)
+                {
+                    Registers[sm, baseRegister + i] = reader.ReadUInt32();
+                }
+
+                for(uint i = 0; i < registerCount; ++i)
+                {
+                    RegisterContestion[sm, baseRegister + i] = reader.ReadByte();
+                }
+            }
+
+            RegistersDirty = true;
+        }
     }
 }
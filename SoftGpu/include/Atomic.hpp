@@ -0,0 +1,32 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#pragma once
+
+#include <NumTypes.hpp>
+
+enum class EAtomicOperation : u8
+{
+    Add = 0,
+    Min,
+    Max,
+    And,
+    Or,
+    Xor,
+    Exchange,
+    CompareExchange
+};
+
+// Compare exchange takes the value to compare against and the value to store, the rest take a single operand.
+[[nodiscard]] inline u32 AtomicOperandCount(const EAtomicOperation operation, const bool wide) noexcept
+{
+    const u32 wordCount = wide ? 2 : 1;
+    return operation == EAtomicOperation::CompareExchange ? wordCount * 2 : wordCount;
+}
+
+// Applies operation to the 1 or 2 words at memory, low word first, and returns what they held in previous.
+// Min and Max compare as signed integers when signedCompare is set.
+void ApplyAtomicOperation(EAtomicOperation operation, bool wide, bool signedCompare, u32* memory, const u32* operands, u32* previous) noexcept;
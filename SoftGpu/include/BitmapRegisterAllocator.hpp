@@ -0,0 +1,153 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#pragma once
+
+#include <Objects.hpp>
+#include <NumTypes.hpp>
+
+#include <bit>
+#include <cassert>
+
+/**
+ * \brief A bitmap allocator for registers.
+ *
+ *   This hands out the same 2048, 1536, 1024, 768, 512, and 256 blocks
+ * at the same offsets as the buddy RegisterAllocator, but tracks the
+ * register file as 16 chunks of 256 registers in a single free mask.
+ * A block may start on any chunk as long as it doesn't cross into the
+ * other 2048 column, which is exactly the set of placements in the
+ * buddy allocator's table.
+ *
+ *   Allocation ANDs the free mask with shifted copies of itself to find
+ * every chunk that starts a free run long enough, and takes the lowest
+ * one with a count trailing zeros. Freeing sets the bits again, which
+ * coalesces with any free neighbours for free. Neither walks a list.
+ *
+ * Chunk bit i covers registers [i * 256, i * 256 + 255], bits 0-7 are
+ * the first column and bits 8-15 the second.
+ */
+class BitmapRegisterAllocator final
+{
+    DEFAULT_DESTRUCT(BitmapRegisterAllocator);
+    DELETE_CM(BitmapRegisterAllocator);
+public:
+    static inline constexpr u32 CHUNK_REGISTER_COUNT = 256;
+    static inline constexpr u32 CHUNK_COUNT = 16;
+    static inline constexpr u32 COLUMN_CHUNK_COUNT = 8;
+    static inline constexpr u16 ALL_CHUNKS_FREE = 0xFFFF;
+    static inline constexpr u16 INVALID_REGISTER = 0xFFFF;
+public:
+    BitmapRegisterAllocator() noexcept
+        : m_FreeChunks(ALL_CHUNKS_FREE)
+    { }
+
+    void Reset() noexcept
+    {
+        m_FreeChunks = ALL_CHUNKS_FREE;
+    }
+
+    // Register Count uses 1 based indexing.
+    [[nodiscard]] u16 AllocateRegisterBlock(const u16 registerCount) noexcept
+    {
+        if(registerCount >= CHUNK_REGISTER_COUNT * COLUMN_CHUNK_COUNT)
+        {
+            return INVALID_REGISTER;
+        }
+
+        const u32 chunkCount = BlockChunkCount(registerCount);
+        const u32 candidates = FreeRunStarts(m_FreeChunks, chunkCount);
+
+        if(!candidates)
+        {
+            return INVALID_REGISTER;
+        }
+
+        const u32 chunk = static_cast<u32>(::std::countr_zero(candidates));
+
+        m_FreeChunks &= static_cast<u16>(~(ChunkMask(chunkCount) << chunk));
+
+        return static_cast<u16>(chunk * CHUNK_REGISTER_COUNT);
+    }
+
+    // Register count uses 1 based indexing.
+    void FreeRegisterBlock(const u16 registerBase, const u16 registerCount) noexcept
+    {
+        const u32 chunk = registerBase / CHUNK_REGISTER_COUNT;
+        const u32 blockMask = ChunkMask(BlockChunkCount(registerCount)) << chunk;
+
+        // Freeing a block that isn't allocated means the caller lost track of it.
+        assert((m_FreeChunks & blockMask) == 0);
+
+        m_FreeChunks |= static_cast<u16>(blockMask);
+    }
+
+    [[nodiscard]] bool CheckFree() const noexcept
+    {
+        return m_FreeChunks == ALL_CHUNKS_FREE;
+    }
+
+    [[nodiscard]] u32 FreeRegisterCount() const noexcept
+    {
+        return static_cast<u32>(::std::popcount(m_FreeChunks)) * CHUNK_REGISTER_COUNT;
+    }
+
+    // The largest block, in chunks, that could be allocated right now.
+    [[nodiscard]] u32 LargestFreeBlock() const noexcept
+    {
+        return LargestFreeRun(m_FreeChunks);
+    }
+
+    [[nodiscard]] u16 FreeChunks() const noexcept { return m_FreeChunks; }
+
+    // Rounds up to the block classes the buddy allocator uses, 1280 and 1792 don't exist.
+    [[nodiscard]] static u32 BlockChunkCount(const u16 registerCount) noexcept
+    {
+        static constexpr u8 ChunkCounts[COLUMN_CHUNK_COUNT] = { 1, 2, 3, 4, 6, 6, 8, 8 };
+
+        return ChunkCounts[(registerCount / CHUNK_REGISTER_COUNT) & (COLUMN_CHUNK_COUNT - 1)];
+    }
+
+    // Bit i is set if chunks i through i + chunkCount - 1 are all free, and a block starting there stays in its column.
+    [[nodiscard]] static u32 FreeRunStarts(const u16 freeChunks, const u32 chunkCount) noexcept
+    {
+        u32 candidates = freeChunks & StartMask(chunkCount);
+
+        for(u32 i = 1; i < chunkCount; ++i)
+        {
+            candidates &= static_cast<u32>(freeChunks) >> i;
+        }
+
+        return candidates;
+    }
+
+    [[nodiscard]] static u32 LargestFreeRun(const u16 freeChunks) noexcept
+    {
+        for(u32 chunkCount = COLUMN_CHUNK_COUNT; chunkCount > 0; --chunkCount)
+        {
+            if(FreeRunStarts(freeChunks, chunkCount))
+            {
+                return chunkCount;
+            }
+        }
+
+        return 0;
+    }
+private:
+    [[nodiscard]] static constexpr u32 ChunkMask(const u32 chunkCount) noexcept
+    {
+        return (1u << chunkCount) - 1;
+    }
+
+    // The chunks a block of chunkCount can start on without crossing a column.
+    [[nodiscard]] static constexpr u32 StartMask(const u32 chunkCount) noexcept
+    {
+        const u32 columnStarts = ChunkMask(COLUMN_CHUNK_COUNT - chunkCount + 1);
+        return columnStarts | (columnStarts << COLUMN_CHUNK_COUNT);
+    }
+private:
+    u16 m_FreeChunks;
+};
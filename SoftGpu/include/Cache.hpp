@@ -8,6 +8,7 @@
 
 #include <cstring>
 #include <array>
+#include <bit>
 
 #include <Objects.hpp>
 #include <NumTypes.hpp>
@@ -15,6 +16,18 @@
 #include <BitVector.hpp>
 
 #include "IPConfig.hpp"
+#include "Atomic.hpp"
+#include "CacheReplacement.hpp"
+#include "CacheMissClassifier.hpp"
+
+#if HAS_X86_INTRINSICS
+#include <immintrin.h>
+#endif
+
+// Whether the L1 holds every line the L0s hold, evicting from the L1 then invalidates the L0 copies.
+#ifndef SOFT_GPU_L1_INCLUSIVE
+    #define SOFT_GPU_L1_INCLUSIVE 1
+#endif
 
 enum class MesiState : u8
 {
@@ -24,22 +37,57 @@ enum class MesiState : u8
     Invalid = 0
 };
 
-template<uSys IndexBits>
+/**
+ * \brief The counters kept by each cache.
+ *
+ *   Every miss is counted as exactly one of the miss classes, see
+ * CacheMissClassifier. Snoops are counted by the cache receiving them,
+ * and a snoop hit is one which found the line valid. Writebacks are
+ * every line written to the next level, whether evicted, flushed,
+ * written through, or given up to a snoop. The MESI transitions follow
+ * MesiTransition, only changes of state are counted, and a line being
+ * replaced counts as becoming invalid and then being filled.
+ */
+enum class ECacheStatistic : u8
+{
+    // Reads and writes which found their line valid, upgrades from shared included.
+    Hits = 0,
+    // Reads and writes which had to fill their line.
+    Misses,
+    CompulsoryMisses,
+    CapacityMisses,
+    ConflictMisses,
+    CoherenceMisses,
+    SnoopsReceived,
+    SnoopHits,
+    Writebacks,
+    // Lines lost to another cache's write, or to an inclusive outer cache evicting them.
+    Invalidations,
+    Flushes,
+    // Lines the flushes wrote back.
+    FlushWritebacks,
+    // Lines filled by prefetches, those a read or write then hit, and those evicted or invalidated first.
+    PrefetchFills,
+    UsefulPrefetches,
+    UselessPrefetches,
+    // 16 counters, from * 4 + to with the MesiState values.
+    MesiTransitions = 16,
+    Count = MesiTransitions + 16
+};
+
 struct CacheLine final
 {
     DEFAULT_DESTRUCT(CacheLine);
     DELETE_CM(CacheLine);
 public:
     MesiState Mesi : 2;
-    u64 Tag : 61 - IndexBits; // 3 bits of offset, IndexBits bits of set index
-    u64 External : 1; // Was this from external memory?
-    u64 Pad : 8; // Because we're at a high level we'll pad the structure to be nice.
+    u8 Prefetched : 1; // Filled by a prefetch and not yet used by a demand access.
+    u8 Pad : 5; // Because we're at a high level we'll pad the structure to be nice.
     u32 Data[8]; // 32 bytes / 8 words per cache line.
 
     CacheLine() noexcept
         : Mesi(MesiState::Invalid)
-        , Tag{ }
-        , External{ }
+        , Prefetched(0)
         , Pad{ }
         , Data{ }
     { }
@@ -47,12 +95,77 @@ public:
     void Reset()
     {
         Mesi = MesiState::Invalid;
-        Tag = { };
-        External = { };
+        Prefetched = 0;
         Pad = { };
     }
 };
 
+// The tag of a line packed with its external bit, as a set stores it.
+[[nodiscard]] inline u64 PackCacheTag(const u64 tag, const bool external) noexcept
+{
+    return (tag << 1) | (external ? 1 : 0);
+}
+
+// Returns the first index of key in tags, comparing as many at once as the vector width allows, or Count if it isn't there.
+template<uSys Count>
+[[nodiscard]] uSys FindPackedTag(const u64 (&tags)[Count], const u64 key) noexcept
+{
+    uSys i = 0;
+
+#if HAS_X86_INTRINSICS && defined(__AVX2__)
+    const __m256i keys = _mm256_set1_epi64x(static_cast<i64>(key));
+
+    for(; i + 4 <= Count; i += 4)
+    {
+        const __m256i packedTags = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&tags[i]));
+        const u32 matches = static_cast<u32>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(packedTags, keys))));
+
+        if(matches)
+        {
+            return i + static_cast<uSys>(::std::countr_zero(matches));
+        }
+    }
+#elif HAS_X86_INTRINSICS
+    const __m128i keys = _mm_set1_epi64x(static_cast<i64>(key));
+
+    for(; i + 2 <= Count; i += 2)
+    {
+        const __m128i packedTags = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&tags[i]));
+        // SSE2 only compares 32 bit lanes, an entry matches when both of its halves do.
+        const u32 matches = static_cast<u32>(_mm_movemask_epi8(_mm_cmpeq_epi32(packedTags, keys)));
+
+        if((matches & 0x00FF) == 0x00FF)
+        {
+            return i;
+        }
+
+        if((matches & 0xFF00) == 0xFF00)
+        {
+            return i + 1;
+        }
+    }
+#endif
+
+    for(; i < Count; ++i)
+    {
+        if(tags[i] == key)
+        {
+            return i;
+        }
+    }
+
+    return Count;
+}
+
+/**
+ * \brief The lines of a single set, with their tags kept apart from them.
+ *
+ *   The tag of each way is packed with its external bit into a single
+ * word, and the words of every way are stored contiguously, so a lookup
+ * compares the whole set at once instead of walking the lines. The tag
+ * is the address without its 3 bits of offset and IndexBits bits of set
+ * index, so it always fits beside the external bit.
+ */
 template<uSys IndexBits, uSys NumSetLines>
 struct CacheSet final
 {
@@ -60,15 +173,57 @@ struct CacheSet final
     DEFAULT_DESTRUCT(CacheSet);
     DELETE_CM(CacheSet);
 public:
-    CacheLine<IndexBits> SetLines[NumSetLines];
+    u64 Tags[NumSetLines];
+    CacheLine SetLines[NumSetLines];
 
     void Reset()
     {
         for(uSys i = 0; i < NumSetLines; ++i)
         {
+            Tags[i] = 0;
             SetLines[i].Reset();
         }
     }
+
+    [[nodiscard]] static u64 PackTag(const u64 tag, const bool external) noexcept
+    {
+        return PackCacheTag(tag, external);
+    }
+
+    [[nodiscard]] u64 GetTag(const uSys way) const noexcept
+    {
+        return Tags[way] >> 1;
+    }
+
+    [[nodiscard]] bool IsExternal(const uSys way) const noexcept
+    {
+        return Tags[way] & 1;
+    }
+
+    void SetTag(const uSys way, const u64 tag, const bool external) noexcept
+    {
+        Tags[way] = PackTag(tag, external);
+    }
+
+    // Returns the first way holding the tag, whatever its MESI state, or NumSetLines if no way does.
+    [[nodiscard]] uSys FindLine(const u64 tag, const bool external) const noexcept
+    {
+        return FindPackedTag(Tags, PackTag(tag, external));
+    }
+
+    // The line by line walk, kept as the reference FindLine must agree with.
+    [[nodiscard]] uSys FindLineScalar(const u64 tag, const bool external) const noexcept
+    {
+        for(uSys i = 0; i < NumSetLines; ++i)
+        {
+            if(GetTag(i) == tag && IsExternal(i) == external)
+            {
+                return i;
+            }
+        }
+
+        return NumSetLines;
+    }
 };
 
 class CacheController;
@@ -191,22 +346,15 @@ private:
         }
     }
 
-    [[nodiscard]] CacheLine<IndexBits>* GetCacheLine(const u64 address, const bool external) noexcept
+    [[nodiscard]] CacheLine* GetCacheLine(const u64 address, const bool external) noexcept
     {
         const u64 setIndex = (address >> 3) & ((1 << IndexBits) - 1);
         const u64 tag = address >> (IndexBits + 3);
 
         CacheSet<IndexBits, NumSetLines>& targetSet = m_Sets[setIndex];
+        const uSys way = targetSet.FindLine(tag, external);
 
-        for(uSys i = 0; i < NumSetLines; ++i)
-        {
-            if(targetSet.SetLines[i].Tag == tag && targetSet.SetLines[i].External == external)
-            {
-                return &targetSet.SetLines[i];
-            }
-        }
-
-        return nullptr;
+        return way == NumSetLines ? nullptr : &targetSet.SetLines[way];
     }
 private:
     Receiver* m_Parent;
@@ -230,7 +378,8 @@ private:
     u32 m_RollingSelector;
 };
 
-template<uSys IndexBits, uSys NumSetLines>
+// Once every way of a set is valid, ReplacementPolicy picks the line a fill replaces, see CacheReplacement.hpp.
+template<uSys IndexBits, uSys NumSetLines, template<uSys> typename ReplacementPolicy = TreePlruReplacement>
 class Cache final
 {
     DEFAULT_DESTRUCT(Cache);
@@ -241,6 +390,8 @@ private:
     SENSITIVITY_DECL(p_Reset_n, p_Clock);
 
     SIGNAL_ENTITIES();
+public:
+    static inline constexpr bool CLASSIFY_MISSES = SOFT_GPU_CACHE_MISS_CLASSIFICATION;
 public:
     Cache(
         Receiver* const parent,
@@ -252,7 +403,9 @@ public:
         , p_Clock(0)
         , p_Pad0{}
         , m_Sets{ }
-        , m_RollingSelector(0)
+        , m_Replacement{ }
+        , m_MissClassifier()
+        , m_Statistics{ }
     { }
 
     void SetResetN(const bool reset_n) noexcept
@@ -271,22 +424,54 @@ public:
 
     void Reset()
     {
-        m_RollingSelector = 0;
-
-        for(uSys i = 0; i < ::std::size(m_Sets); ++i)
-        {
-            m_Sets[i].Reset();
-        }
+        ResetSets();
+        ResetStatistics();
     }
 
     [[nodiscard]] u32 Read(u64 address, bool external) noexcept;
     void Write(u64 address, u32 value, bool external, bool writeThrough) noexcept;
+    // Reads wordCount words starting at address, which must all be in the same line, with a single lookup.
+    void ReadLine(u64 address, u32 wordCount, bool external, u32* values) noexcept;
+    // Writes wordCount words starting at address, which must all be in the same line, with a single lookup.
+    void WriteLine(u64 address, u32 wordCount, const u32* values, bool external, bool writeThrough) noexcept;
+    // Applies an atomic operation to the 1 or 2 words at address, with the line held modified so no other cache has a copy.
+    void Atomic(u64 address, EAtomicOperation operation, bool wide, bool signedCompare, const u32* operands, u32* previous, bool external, bool writeThrough) noexcept;
+    // Whether a read of address would hit, this doesn't change any state.
+    [[nodiscard]] bool Contains(u64 address, bool external) noexcept;
+    // Fills the line holding address for reading without counting an access, if it isn't already here.
+    void Prefetch(u64 address, bool external) noexcept;
     // void FillCacheLine(u64 address, const u32* data) noexcept;
     void Flush() noexcept;
+    // Writes back the line holding address if it's modified, keeping it exclusive.
+    void FlushLine(u64 address, bool external) noexcept;
 
     bool SnoopBusRead(u32 requestorLine, u64 address, bool external, u32* dataBus) noexcept;
     bool SnoopBusReadX(u32 requestorLine, u64 address, bool external, u32* dataBus) noexcept;
     void SnoopBusUpgrade(u32 requestorLine, u64 address, bool external) noexcept;
+    // Invalidates the line for an inclusive outer level evicting it. Returns true, having copied it into data, if it was modified.
+    [[nodiscard]] bool SnoopBackInvalidate(u64 address, bool external, u32* data) noexcept;
+
+    [[nodiscard]] u64 Statistic(const ECacheStatistic statistic) const noexcept
+    {
+        return m_Statistics[static_cast<u32>(statistic)];
+    }
+
+    [[nodiscard]] u64 MesiTransitions(const MesiState from, const MesiState to) const noexcept
+    {
+        return m_Statistics[MesiTransition(from, to)];
+    }
+
+    [[nodiscard]] u64 Hits() const noexcept { return Statistic(ECacheStatistic::Hits); }
+    [[nodiscard]] u64 Misses() const noexcept { return Statistic(ECacheStatistic::Misses); }
+    [[nodiscard]] u64 PrefetchFills() const noexcept { return Statistic(ECacheStatistic::PrefetchFills); }
+    [[nodiscard]] u64 UsefulPrefetches() const noexcept { return Statistic(ECacheStatistic::UsefulPrefetches); }
+    [[nodiscard]] u64 UselessPrefetches() const noexcept { return Statistic(ECacheStatistic::UselessPrefetches); }
+
+    // The miss classes carry on from what the cache holds, only the counts are cleared.
+    void ResetStatistics() noexcept
+    {
+        (void) ::std::memset(m_Statistics, 0, sizeof(m_Statistics));
+    }
 private:
     PROCESSES_DECL()
     {
@@ -297,34 +482,138 @@ private:
     {
         if(!BIT_TO_BOOL(p_Reset_n))
         {
-            m_RollingSelector = 0;
+            ResetSets();
+        }
+    }
 
-            for(uSys i = 0; i < ::std::size(m_Sets); ++i)
-            {
-                m_Sets[i].Reset();
-            }
+    void ResetSets() noexcept
+    {
+        for(uSys i = 0; i < ::std::size(m_Sets); ++i)
+        {
+            m_Sets[i].Reset();
+            m_Replacement[i].Reset();
+        }
+
+        if constexpr(CLASSIFY_MISSES)
+        {
+            m_MissClassifier.Reset();
         }
     }
 
-    [[nodiscard]] CacheLine<IndexBits>* GetCacheLine(const u64 address, const bool external) noexcept
+    [[nodiscard]] static u32 MesiTransition(const MesiState from, const MesiState to) noexcept
+    {
+        return static_cast<u32>(ECacheStatistic::MesiTransitions) + static_cast<u32>(from) * 4 + static_cast<u32>(to);
+    }
+
+    void CountStatistic(const ECacheStatistic statistic) noexcept
+    {
+        ++m_Statistics[static_cast<u32>(statistic)];
+    }
+
+    void SetMesi(CacheLine* const cacheLine, const MesiState mesi) noexcept
+    {
+        if(cacheLine->Mesi != mesi)
+        {
+            ++m_Statistics[MesiTransition(cacheLine->Mesi, mesi)];
+            cacheLine->Mesi = mesi;
+        }
+    }
+
+    // Hands a line to the next level, counting it.
+    void WriteBack(u64 address, bool external, const u32* data) noexcept;
+
+    // The line holding address is being filled for a read or write which missed.
+    void CountMiss(const u64 address, const bool external) noexcept
+    {
+        CountStatistic(ECacheStatistic::Misses);
+
+        if constexpr(CLASSIFY_MISSES)
+        {
+            const EMissClass missClass = m_MissClassifier.Miss(PackCacheTag(address >> 3, external));
+            ++m_Statistics[static_cast<u32>(ECacheStatistic::CompulsoryMisses) + static_cast<u32>(missClass)];
+        }
+    }
+
+    [[nodiscard]] CacheLine* GetCacheLine(const u64 address, const bool external) noexcept
     {
         const u64 setIndex = (address >> 3) & ((1 << IndexBits) - 1);
         const u64 tag = address >> (IndexBits + 3);
 
         CacheSet<IndexBits, NumSetLines>& targetSet = m_Sets[setIndex];
+        const uSys way = targetSet.FindLine(tag, external);
 
-        for(uSys i = 0; i < NumSetLines; ++i)
+        return way == NumSetLines ? nullptr : &targetSet.SetLines[way];
+    }
+
+    [[nodiscard]] CacheLine* GetFreeCacheLine(u64 address, bool external) noexcept;
+
+    // Reads the line holding address into cacheLine, shared if another cache supplied it.
+    void FillLineShared(CacheLine* cacheLine, u64 address, bool external) noexcept;
+    // Finds or fills the line holding address, for reading.
+    [[nodiscard]] CacheLine* AcquireLineShared(u64 address, bool external) noexcept;
+    // Finds or fills the line holding address, and takes ownership of it for writing.
+    [[nodiscard]] CacheLine* AcquireLineModified(u64 address, bool external) noexcept;
+
+    // The way of cacheLine within the set holding address.
+    [[nodiscard]] uSys WayOf(const u64 address, const CacheLine* const cacheLine) const noexcept
+    {
+        return static_cast<uSys>(cacheLine - m_Sets[(address >> 3) & ((1 << IndexBits) - 1)].SetLines);
+    }
+
+    // cacheLine, in the set holding address, is being filled.
+    void InsertLine(const u64 address, const CacheLine* const cacheLine) noexcept
+    {
+        m_Replacement[(address >> 3) & ((1 << IndexBits) - 1)].Insert(WayOf(address, cacheLine));
+    }
+
+    // A read or write hit cacheLine, in the set holding address.
+    void CountHit(const u64 address, const bool external, CacheLine* const cacheLine) noexcept
+    {
+        CountStatistic(ECacheStatistic::Hits);
+        m_Replacement[(address >> 3) & ((1 << IndexBits) - 1)].Touch(WayOf(address, cacheLine));
+
+        if constexpr(CLASSIFY_MISSES)
         {
-            if(targetSet.SetLines[i].Tag == tag && targetSet.SetLines[i].External == external)
-            {
-                return &targetSet.SetLines[i];
-            }
+            m_MissClassifier.Hit(PackCacheTag(address >> 3, external));
         }
 
-        return nullptr;
+        if(cacheLine->Prefetched)
+        {
+            CountStatistic(ECacheStatistic::UsefulPrefetches);
+            cacheLine->Prefetched = 0;
+        }
     }
 
-    [[nodiscard]] CacheLine<IndexBits>* GetFreeCacheLine(u64 address, bool external) noexcept;
+    // cacheLine is about to be invalidated or replaced.
+    void CountDrop(CacheLine* const cacheLine) noexcept
+    {
+        if(cacheLine->Prefetched)
+        {
+            CountStatistic(ECacheStatistic::UselessPrefetches);
+            cacheLine->Prefetched = 0;
+        }
+    }
+
+    // cacheLine, holding address, is about to be invalidated by a snoop, or for inclusion if backInvalidate.
+    void CountInvalidation(const u64 address, const bool external, CacheLine* const cacheLine, const bool backInvalidate) noexcept
+    {
+        CountStatistic(ECacheStatistic::Invalidations);
+        CountDrop(cacheLine);
+
+        if constexpr(CLASSIFY_MISSES)
+        {
+            const u64 key = PackCacheTag(address >> 3, external);
+
+            if(backInvalidate)
+            {
+                m_MissClassifier.BackInvalidate(key);
+            }
+            else
+            {
+                m_MissClassifier.SnoopInvalidate(key);
+            }
+        }
+    }
 private:
     Receiver* m_Parent;
     u32 m_LineIndex;
@@ -335,18 +624,184 @@ private:
 
 
     CacheSet<IndexBits, NumSetLines> m_Sets[1 << IndexBits];
-    u32 m_RollingSelector;
+    ReplacementPolicy<NumSetLines> m_Replacement[1 << IndexBits];
+    CacheMissClassifier<(1 << IndexBits) * NumSetLines> m_MissClassifier;
+
+    u64 m_Statistics[static_cast<u32>(ECacheStatistic::Count)];
 };
 
 class Processor;
 
+// The counters the cache controller keeps itself, those of each cache are ECacheStatistic.
+enum class ECacheControllerStatistic : u8
+{
+    // Lines filled from memory, and lines written back to it.
+    MemoryLineReads = 0,
+    MemoryLineWrites,
+    // L1 evictions which snooped the L0s to keep them inclusive.
+    BackInvalidations,
+    // Snoops of single L0s, and those the snoop filter showed weren't needed.
+    SnoopsSent,
+    SnoopsFiltered,
+    Count
+};
+
+/**
+ * \brief Tracks which L0s hold each line, so a miss only snoops those.
+ *
+ *   The filter is indexed like the L0s, and each of its sets has room
+ * for every line the L0s could hold in that set at once, so it never has
+ * to evict an entry, and thus never has to invalidate a line to make
+ * room. The controller tells it about every fill, eviction, and
+ * invalidation, which keeps it exact. An entry only ever loses a holder
+ * when that L0 has let the line go, so if an update were ever missed the
+ * filter would err towards snooping too much, never too little.
+ */
+template<uSys IndexBits, uSys NumSetEntries>
+class SnoopFilter final
+{
+    DEFAULT_DESTRUCT(SnoopFilter);
+    DELETE_CM(SnoopFilter);
+private:
+    struct FilterSet final
+    {
+        // Packed as the cache sets pack them, an entry without holders is free.
+        u64 Tags[NumSetEntries];
+        u8 Holders[NumSetEntries];
+    };
+public:
+    SnoopFilter() noexcept
+        : m_Sets{ }
+    { }
+
+    void Reset() noexcept
+    {
+        (void) ::std::memset(m_Sets, 0, sizeof(m_Sets));
+    }
+
+    // A bit for each L0 which may hold the line.
+    [[nodiscard]] u32 Holders(const u64 address, const bool external) const noexcept
+    {
+        const FilterSet& filterSet = m_Sets[SetIndex(address)];
+        const uSys entry = FindPackedTag(filterSet.Tags, Key(address, external));
+
+        return entry == NumSetEntries ? 0 : filterSet.Holders[entry];
+    }
+
+    void AddHolder(const u64 address, const bool external, const u32 cacheIndex) noexcept
+    {
+        FilterSet& filterSet = m_Sets[SetIndex(address)];
+        const uSys entry = AcquireEntry(filterSet, Key(address, external));
+
+        filterSet.Holders[entry] |= static_cast<u8>(1 << cacheIndex);
+    }
+
+    // The L0 took the line for writing, every other copy was invalidated.
+    void SetOnlyHolder(const u64 address, const bool external, const u32 cacheIndex) noexcept
+    {
+        FilterSet& filterSet = m_Sets[SetIndex(address)];
+        const uSys entry = AcquireEntry(filterSet, Key(address, external));
+
+        filterSet.Holders[entry] = static_cast<u8>(1 << cacheIndex);
+    }
+
+    void RemoveHolder(const u64 address, const bool external, const u32 cacheIndex) noexcept
+    {
+        FilterSet& filterSet = m_Sets[SetIndex(address)];
+        const uSys entry = FindPackedTag(filterSet.Tags, Key(address, external));
+
+        if(entry != NumSetEntries)
+        {
+            filterSet.Holders[entry] &= static_cast<u8>(~(1 << cacheIndex));
+        }
+    }
+
+    void RemoveAllHolders(const u64 address, const bool external) noexcept
+    {
+        FilterSet& filterSet = m_Sets[SetIndex(address)];
+        const uSys entry = FindPackedTag(filterSet.Tags, Key(address, external));
+
+        if(entry != NumSetEntries)
+        {
+            filterSet.Holders[entry] = 0;
+        }
+    }
+private:
+    [[nodiscard]] static u64 SetIndex(const u64 address) noexcept
+    {
+        return (address >> 3) & ((1 << IndexBits) - 1);
+    }
+
+    [[nodiscard]] static u64 Key(const u64 address, const bool external) noexcept
+    {
+        return PackCacheTag(address >> (IndexBits + 3), external);
+    }
+
+    // Finds the entry for key, or claims a free one. A free entry may still hold a stale tag, which is why a
+    // match is reused before looking for a free entry, so a tag is never in a set twice.
+    [[nodiscard]] static uSys AcquireEntry(FilterSet& filterSet, const u64 key) noexcept
+    {
+        const uSys entry = FindPackedTag(filterSet.Tags, key);
+
+        if(entry != NumSetEntries)
+        {
+            return entry;
+        }
+
+        for(uSys i = 0; i < NumSetEntries; ++i)
+        {
+            if(filterSet.Holders[i] == 0)
+            {
+                filterSet.Tags[i] = key;
+                return i;
+            }
+        }
+
+        // The sets are sized so this can't happen.
+        assert(false);
+        return 0;
+    }
+private:
+    FilterSet m_Sets[1 << IndexBits];
+};
+
+/**
+ * \brief Keeps the SM L0s coherent with each other and backs them with a shared L1.
+ *
+ *   On a miss the L0s which the snoop filter says hold the line are
+ * snooped, and one of them supplies it. Misses no L0 can supply, and
+ * everything the L0s write back, go to the L1, which alone talks to
+ * memory. The L1 isn't part of
+ * the MESI protocol between the L0s, it's the memory behind them, so its
+ * lines are only ever exclusive or modified.
+ *
+ *   With an inclusive L1 every line in an L0 is also in the L1, and
+ * evicting a line from the L1 first invalidates it in the L0s, taking
+ * the data from any which had modified it. A non-inclusive L1 allocates
+ * on fills just the same but leaves the L0s alone when it evicts.
+ * Flushing an L0 writes its modified lines back through the L1 to memory.
+ */
 class CacheController final
 {
+public:
+    static inline constexpr u32 L0_CACHE_COUNT = 4;
+    // The requestor line of the L1 as seen by the snoop bus.
+    static inline constexpr u32 L1_LINE_INDEX = L0_CACHE_COUNT;
+    static inline constexpr u32 CACHE_STATISTIC_COUNT = static_cast<u32>(ECacheStatistic::Count);
+    static inline constexpr u32 CONTROLLER_STATISTIC_COUNT = static_cast<u32>(ECacheControllerStatistic::Count);
+private:
+    using L0Cache_t = Cache<8, 4>;
+    using L1Cache_t = Cache<10, 8>;
+    // Indexed like the L0s, with room for every L0 to fill a set with different lines.
+    using SnoopFilter_t = SnoopFilter<8, 4 * L0_CACHE_COUNT>;
 public:
     CacheController(Processor* const processor) noexcept
         : m_Processor(processor)
         , m_L0Caches{ { this, 0 }, { this, 1 }, { this, 2 }, { this, 3 } }
-        // , L1Cache(this, 4)
+        , m_L1Cache(this, L1_LINE_INDEX)
+        , m_SnoopFilter()
+        , m_L1Inclusive(SOFT_GPU_L1_INCLUSIVE)
+        , m_Statistics{ }
     { }
 
     void Reset()
@@ -355,6 +810,9 @@ public:
         m_L0Caches[1].Reset();
         m_L0Caches[2].Reset();
         m_L0Caches[3].Reset();
+        m_L1Cache.Reset();
+        m_SnoopFilter.Reset();
+        ResetStatistics();
     }
 
     [[nodiscard]] u32 Read(const u32 coreIndex, const u64 address, const bool external) noexcept
@@ -365,76 +823,284 @@ public:
     void Write(const u32 coreIndex, const u64 address, const u32 value, const bool external, const bool writeThrough) noexcept
     {
         m_L0Caches[coreIndex].Write(address, value, external, writeThrough);
+        WriteThroughL1(address, external, writeThrough);
     }
 
+    void ReadLine(const u32 coreIndex, const u64 address, const u32 wordCount, const bool external, u32* const values) noexcept
+    {
+        m_L0Caches[coreIndex].ReadLine(address, wordCount, external, values);
+    }
+
+    void WriteLine(const u32 coreIndex, const u64 address, const u32 wordCount, const u32* const values, const bool external, const bool writeThrough) noexcept
+    {
+        m_L0Caches[coreIndex].WriteLine(address, wordCount, values, external, writeThrough);
+        WriteThroughL1(address, external, writeThrough);
+    }
+
+    // The L0s are the coherence point, the requesting L0 takes the line exclusively before applying the operation.
+    void Atomic(const u32 coreIndex, const u64 address, const EAtomicOperation operation, const bool wide, const bool signedCompare, const u32* const operands, u32* const previous, const bool external, const bool writeThrough) noexcept
+    {
+        m_L0Caches[coreIndex].Atomic(address, operation, wide, signedCompare, operands, previous, external, writeThrough);
+        WriteThroughL1(address, external, writeThrough);
+    }
+
+    [[nodiscard]] bool IsCached(const u32 coreIndex, const u64 address, const bool external) noexcept
+    {
+        return m_L0Caches[coreIndex].Contains(address, external);
+    }
+
+    // The SM's prefetcher has already waited out the latency, this is the fill arriving.
     void Prefetch(const u32 coreIndex, const u64 address, const bool external) noexcept
     {
-        // For pre-fetching we'll be acting asynchronously typically, but we're forced to act synchronously in software, so we'll just redirect to read.
-        (void) m_L0Caches[coreIndex].Read(address, external);
+        m_L0Caches[coreIndex].Prefetch(address, external);
     }
 
     void Flush(const u32 coreIndex) noexcept
     {
         m_L0Caches[coreIndex].Flush();
+        // The L0 only flushed as far as the L1.
+        m_L1Cache.Flush();
     }
 
     bool ReadCacheLine(const u32 requestorLine, const u64 address, const bool external, u32* const cacheLine) noexcept
     {
-        bool didWrite = m_L0Caches[0].SnoopBusRead(requestorLine, address, external, cacheLine);
-        didWrite = m_L0Caches[1].SnoopBusRead(requestorLine, address, external, didWrite ? nullptr : cacheLine);
-        didWrite = m_L0Caches[2].SnoopBusRead(requestorLine, address, external, didWrite ? nullptr : cacheLine);
-        didWrite = m_L0Caches[3].SnoopBusRead(requestorLine, address, external, didWrite ? nullptr : cacheLine);
-
-        if(!didWrite)
+        if(requestorLine == L1_LINE_INDEX)
         {
+            CountStatistic(ECacheControllerStatistic::MemoryLineReads);
             // The memory granularity is 32 bits, thus we'll adjust to an 8 bit granularity for x86.
             ReadCacheLine(address, cacheLine, external);
             return false;
         }
 
+        const u32 holders = SnoopTargets(requestorLine, address, external);
+
+        // Any cache holding the line supplies it, the rest only see the snoop.
+        bool didWrite = false;
+
+        for(u32 i = 0; i < L0_CACHE_COUNT; ++i)
+        {
+            if(holders & (1 << i))
+            {
+                didWrite = m_L0Caches[i].SnoopBusRead(requestorLine, address, external, didWrite ? nullptr : cacheLine) || didWrite;
+            }
+        }
+
+        m_SnoopFilter.AddHolder(address, external, requestorLine);
+
+        if(!didWrite)
+        {
+            m_L1Cache.ReadLine(address, 8, external, cacheLine);
+            return false;
+        }
+
         return true;
     }
 
     bool ReadXCacheLine(const u32 requestorLine, const u64 address, const bool external, u32* const cacheLine) noexcept
     {
-        bool didWrite = m_L0Caches[0].SnoopBusReadX(requestorLine, address, external, cacheLine);
-        didWrite = m_L0Caches[1].SnoopBusReadX(requestorLine, address, external, didWrite ? nullptr : cacheLine);
-        didWrite = m_L0Caches[2].SnoopBusReadX(requestorLine, address, external, didWrite ? nullptr : cacheLine);
-        didWrite = m_L0Caches[3].SnoopBusReadX(requestorLine, address, external, didWrite ? nullptr : cacheLine);
-
-        if(!didWrite)
+        if(requestorLine == L1_LINE_INDEX)
         {
+            CountStatistic(ECacheControllerStatistic::MemoryLineReads);
             // The memory granularity is 32 bits, thus we'll adjust to an 8 bit granularity for x86.
             ReadCacheLine(address, cacheLine, external);
             return false;
         }
 
+        const u32 holders = SnoopTargets(requestorLine, address, external);
+
+        // Any cache holding the line supplies it, the rest only see the snoop.
+        bool didWrite = false;
+
+        for(u32 i = 0; i < L0_CACHE_COUNT; ++i)
+        {
+            if(holders & (1 << i))
+            {
+                didWrite = m_L0Caches[i].SnoopBusReadX(requestorLine, address, external, didWrite ? nullptr : cacheLine) || didWrite;
+            }
+        }
+
+        m_SnoopFilter.SetOnlyHolder(address, external, requestorLine);
+
+        if(!didWrite)
+        {
+            m_L1Cache.ReadLine(address, 8, external, cacheLine);
+            return false;
+        }
+
         return true;
     }
 
     void UpgradeCacheLine(const u32 requestorLine, const u64 address, const bool external) noexcept
     {
-        m_L0Caches[0].SnoopBusUpgrade(requestorLine, address, external);
-        m_L0Caches[1].SnoopBusUpgrade(requestorLine, address, external);
-        m_L0Caches[2].SnoopBusUpgrade(requestorLine, address, external);
-        m_L0Caches[3].SnoopBusUpgrade(requestorLine, address, external);
+        // The L1 only ever fills from memory, so it never holds a shared line to upgrade.
+        assert(requestorLine != L1_LINE_INDEX);
+
+        const u32 holders = SnoopTargets(requestorLine, address, external);
+
+        for(u32 i = 0; i < L0_CACHE_COUNT; ++i)
+        {
+            if(holders & (1 << i))
+            {
+                m_L0Caches[i].SnoopBusUpgrade(requestorLine, address, external);
+            }
+        }
+
+        m_SnoopFilter.SetOnlyHolder(address, external, requestorLine);
     }
 
     void WriteBackCacheLine(const u32 requestorLine, const u64 address, const bool external, const u32* cacheLine) noexcept
     {
-        // if(requestorLine == 4)
+        if(requestorLine == L1_LINE_INDEX)
         {
+            CountStatistic(ECacheControllerStatistic::MemoryLineWrites);
             // The memory granularity is 32 bits, thus we'll adjust to an 8 bit granularity for x86.
             WriteCacheLine(address, cacheLine, external);
+            return;
+        }
+
+        m_L1Cache.WriteLine(address, 8, cacheLine, external, false);
+    }
+
+    // A valid line is being replaced. Returns true if the evicting cache must write back the data it now holds.
+    [[nodiscard]] bool EvictCacheLine(const u32 requestorLine, const u64 address, const bool external, u32* const cacheLine) noexcept
+    {
+        if(requestorLine != L1_LINE_INDEX)
+        {
+            m_SnoopFilter.RemoveHolder(address, external, requestorLine);
+            return false;
+        }
+
+        if(!m_L1Inclusive)
+        {
+            return false;
+        }
+
+        CountStatistic(ECacheControllerStatistic::BackInvalidations);
+
+        const u32 holders = SnoopTargets(requestorLine, address, external);
+
+        // At most one L0 can have modified the line, and its data is newer than the L1's.
+        bool modified = false;
+
+        for(u32 i = 0; i < L0_CACHE_COUNT; ++i)
+        {
+            if(holders & (1 << i))
+            {
+                modified = m_L0Caches[i].SnoopBackInvalidate(address, external, cacheLine) || modified;
+            }
+        }
+
+        m_SnoopFilter.RemoveAllHolders(address, external);
+
+        return modified;
+    }
+
+    // The counters of an L0 by its core index, or of the L1 by L1_LINE_INDEX.
+    [[nodiscard]] u64 CacheStatistic(const u32 cacheIndex, const ECacheStatistic statistic) const noexcept
+    {
+        return cacheIndex == L1_LINE_INDEX ? m_L1Cache.Statistic(statistic) : m_L0Caches[cacheIndex].Statistic(statistic);
+    }
+
+    [[nodiscard]] u64 CacheMesiTransitions(const u32 cacheIndex, const MesiState from, const MesiState to) const noexcept
+    {
+        return cacheIndex == L1_LINE_INDEX ? m_L1Cache.MesiTransitions(from, to) : m_L0Caches[cacheIndex].MesiTransitions(from, to);
+    }
+
+    [[nodiscard]] u64 Statistic(const ECacheControllerStatistic statistic) const noexcept
+    {
+        return m_Statistics[static_cast<u32>(statistic)];
+    }
+
+    [[nodiscard]] u64 L0Hits(const u32 coreIndex) const noexcept { return m_L0Caches[coreIndex].Hits(); }
+    [[nodiscard]] u64 L0Misses(const u32 coreIndex) const noexcept { return m_L0Caches[coreIndex].Misses(); }
+    [[nodiscard]] u64 L0PrefetchFills(const u32 coreIndex) const noexcept { return m_L0Caches[coreIndex].PrefetchFills(); }
+    [[nodiscard]] u64 L0UsefulPrefetches(const u32 coreIndex) const noexcept { return m_L0Caches[coreIndex].UsefulPrefetches(); }
+    [[nodiscard]] u64 L0UselessPrefetches(const u32 coreIndex) const noexcept { return m_L0Caches[coreIndex].UselessPrefetches(); }
+    [[nodiscard]] u64 L1Hits() const noexcept { return m_L1Cache.Hits(); }
+    [[nodiscard]] u64 L1Misses() const noexcept { return m_L1Cache.Misses(); }
+    [[nodiscard]] u64 MemoryLineReads() const noexcept { return Statistic(ECacheControllerStatistic::MemoryLineReads); }
+    [[nodiscard]] u64 MemoryLineWrites() const noexcept { return Statistic(ECacheControllerStatistic::MemoryLineWrites); }
+    [[nodiscard]] u64 BackInvalidations() const noexcept { return Statistic(ECacheControllerStatistic::BackInvalidations); }
+    [[nodiscard]] u64 SnoopsSent() const noexcept { return Statistic(ECacheControllerStatistic::SnoopsSent); }
+    [[nodiscard]] u64 SnoopsFiltered() const noexcept { return Statistic(ECacheControllerStatistic::SnoopsFiltered); }
+    // Snoops which found the line valid, summed over the L0s.
+    [[nodiscard]] u64 SnoopHits() const noexcept
+    {
+        u64 snoopHits = 0;
+
+        for(const L0Cache_t& cache : m_L0Caches)
+        {
+            snoopHits += cache.Statistic(ECacheStatistic::SnoopHits);
         }
+
+        return snoopHits;
+    }
+
+    // A bit for each L0 the snoop filter thinks holds the line.
+    [[nodiscard]] u32 SnoopFilterHolders(const u64 address, const bool external) const noexcept
+    {
+        return m_SnoopFilter.Holders(address, external);
+    }
+
+    void ResetStatistics() noexcept
+    {
+        m_L0Caches[0].ResetStatistics();
+        m_L0Caches[1].ResetStatistics();
+        m_L0Caches[2].ResetStatistics();
+        m_L0Caches[3].ResetStatistics();
+        m_L1Cache.ResetStatistics();
+        (void) ::std::memset(m_Statistics, 0, sizeof(m_Statistics));
+    }
+
+    // Only the counters of the core's own L0, the rest are shared by every core.
+    void ResetL0Statistics(const u32 coreIndex) noexcept
+    {
+        m_L0Caches[coreIndex].ResetStatistics();
+    }
+
+    // Set this before Reset, switching with lines already cached would break inclusion.
+    void TestSetL1Inclusive(const bool inclusive) noexcept
+    {
+        m_L1Inclusive = inclusive;
     }
 private:
+    // A write through store has to reach memory, not just the L1.
+    void WriteThroughL1(const u64 address, const bool external, const bool writeThrough) noexcept
+    {
+        if(writeThrough)
+        {
+            m_L1Cache.FlushLine(address, external);
+        }
+    }
+
+    // The L0s to snoop for the requestor, counting the snoops the filter saved.
+    [[nodiscard]] u32 SnoopTargets(const u32 requestorLine, const u64 address, const bool external) noexcept
+    {
+        const u32 holders = m_SnoopFilter.Holders(address, external) & ~(1u << requestorLine);
+        const u32 snoops = static_cast<u32>(::std::popcount(holders));
+        const u32 others = requestorLine == L1_LINE_INDEX ? L0_CACHE_COUNT : L0_CACHE_COUNT - 1;
+
+        m_Statistics[static_cast<u32>(ECacheControllerStatistic::SnoopsSent)] += snoops;
+        m_Statistics[static_cast<u32>(ECacheControllerStatistic::SnoopsFiltered)] += others - snoops;
+
+        return holders;
+    }
+
+    void CountStatistic(const ECacheControllerStatistic statistic) noexcept
+    {
+        ++m_Statistics[static_cast<u32>(statistic)];
+    }
+
     void ReadCacheLine(u64 address, u32 data[8], bool external) noexcept;
     void WriteCacheLine(u64 address, const u32 data[8], bool external) noexcept;
 private:
     Processor* m_Processor;
-    Cache<8, 4> m_L0Caches[4];
-    // Cache<10, 8> L1Cache;
+    L0Cache_t m_L0Caches[L0_CACHE_COUNT];
+    L1Cache_t m_L1Cache;
+    SnoopFilter_t m_SnoopFilter;
+    bool m_L1Inclusive;
+
+    u64 m_Statistics[CONTROLLER_STATISTIC_COUNT];
 };
 
 #include "Cache.inl"
@@ -8,95 +8,229 @@
 #include "Cache.hpp"
 #endif
 
+#include <cassert>
 #include <cstring>
 
-template<uSys IndexBits, uSys SetLineCount>
-u32 Cache<IndexBits, SetLineCount>::Read(u64 address, const bool external) noexcept
+template<uSys IndexBits, uSys SetLineCount, template<uSys> typename ReplacementPolicy>
+u32 Cache<IndexBits, SetLineCount, ReplacementPolicy>::Read(const u64 address, const bool external) noexcept
+{
+    return AcquireLineShared(address, external)->Data[address & 0x7];
+}
+
+template<uSys IndexBits, uSys SetLineCount, template<uSys> typename ReplacementPolicy>
+void Cache<IndexBits, SetLineCount, ReplacementPolicy>::Write(const u64 address, const u32 value, const bool external, const bool writeThrough) noexcept
+{
+    CacheLine* const cacheLine = AcquireLineModified(address, external);
+
+    cacheLine->Data[address & 0x7] = value;
+    if(writeThrough)
+    {
+        WriteBack((address >> 3) << 3, external, cacheLine->Data);
+    }
+}
+
+template<uSys IndexBits, uSys SetLineCount, template<uSys> typename ReplacementPolicy>
+void Cache<IndexBits, SetLineCount, ReplacementPolicy>::ReadLine(const u64 address, const u32 wordCount, const bool external, u32* const values) noexcept
+{
+    const u64 lineOffset = address & 0x7;
+    assert(lineOffset + wordCount <= 8);
+
+    const CacheLine* const cacheLine = AcquireLineShared(address, external);
+
+    (void) ::std::memcpy(values, &cacheLine->Data[lineOffset], wordCount * sizeof(u32));
+}
+
+template<uSys IndexBits, uSys SetLineCount, template<uSys> typename ReplacementPolicy>
+void Cache<IndexBits, SetLineCount, ReplacementPolicy>::WriteLine(const u64 address, const u32 wordCount, const u32* const values, const bool external, const bool writeThrough) noexcept
+{
+    const u64 lineOffset = address & 0x7;
+    assert(lineOffset + wordCount <= 8);
+
+    CacheLine* const cacheLine = AcquireLineModified(address, external);
+
+    (void) ::std::memcpy(&cacheLine->Data[lineOffset], values, wordCount * sizeof(u32));
+    if(writeThrough)
+    {
+        WriteBack((address >> 3) << 3, external, cacheLine->Data);
+    }
+}
+
+template<uSys IndexBits, uSys SetLineCount, template<uSys> typename ReplacementPolicy>
+void Cache<IndexBits, SetLineCount, ReplacementPolicy>::Atomic(const u64 address, const EAtomicOperation operation, const bool wide, const bool signedCompare, const u32* const operands, u32* const previous, const bool external, const bool writeThrough) noexcept
 {
     const u64 lineOffset = address & 0x7;
+    assert(!wide || (lineOffset & 0x1) == 0);
+
+    CacheLine* const cacheLine = AcquireLineModified(address, external);
+
+    ApplyAtomicOperation(operation, wide, signedCompare, &cacheLine->Data[lineOffset], operands, previous);
+    if(writeThrough)
+    {
+        WriteBack((address >> 3) << 3, external, cacheLine->Data);
+    }
+}
+
+template<uSys IndexBits, uSys SetLineCount, template<uSys> typename ReplacementPolicy>
+bool Cache<IndexBits, SetLineCount, ReplacementPolicy>::Contains(u64 address, const bool external) noexcept
+{
+    address >>= 3;
+    address <<= 3;
+    const CacheLine* const cacheLine = GetCacheLine(address, external);
+
+    return cacheLine && cacheLine->Mesi != MesiState::Invalid;
+}
+
+template<uSys IndexBits, uSys SetLineCount, template<uSys> typename ReplacementPolicy>
+void Cache<IndexBits, SetLineCount, ReplacementPolicy>::Prefetch(u64 address, const bool external) noexcept
+{
+    address >>= 3;
+    address <<= 3;
+    CacheLine* cacheLine = GetCacheLine(address, external);
+
+    if(cacheLine && cacheLine->Mesi != MesiState::Invalid)
+    {
+        return;
+    }
+
+    if(!cacheLine)
+    {
+        cacheLine = GetFreeCacheLine(address, external);
+    }
+
+    InsertLine(address, cacheLine);
+    FillLineShared(cacheLine, address, external);
+    cacheLine->Prefetched = 1;
+    CountStatistic(ECacheStatistic::PrefetchFills);
+
+    if constexpr(CLASSIFY_MISSES)
+    {
+        m_MissClassifier.Fill(PackCacheTag(address >> 3, external));
+    }
+}
+
+template<uSys IndexBits, uSys SetLineCount, template<uSys> typename ReplacementPolicy>
+void Cache<IndexBits, SetLineCount, ReplacementPolicy>::Flush() noexcept
+{
+    CountStatistic(ECacheStatistic::Flushes);
+
+    for(uSys i = 0; i < 1 << IndexBits; ++i)
+    {
+        CacheSet<IndexBits, SetLineCount>& cacheSet = m_Sets[i];
+
+        for(u32 j = 0; j < SetLineCount; ++j)
+        {
+            CacheLine& cacheLine = cacheSet.SetLines[j];
+
+            if(cacheLine.Mesi == MesiState::Modified)
+            {
+                const u64 address = (cacheSet.GetTag(j) << (IndexBits + 3)) | (i << 3);
+
+                CountStatistic(ECacheStatistic::FlushWritebacks);
+                WriteBack(address, cacheSet.IsExternal(j), cacheLine.Data);
+                SetMesi(&cacheLine, MesiState::Exclusive);
+            }
+        }
+    }
+}
+
+template<uSys IndexBits, uSys SetLineCount, template<uSys> typename ReplacementPolicy>
+void Cache<IndexBits, SetLineCount, ReplacementPolicy>::FlushLine(u64 address, const bool external) noexcept
+{
     address >>= 3;
     address <<= 3;
-    CacheLine<IndexBits>* cacheLine = GetCacheLine(address, external);
+    CacheLine* const cacheLine = GetCacheLine(address, external);
+
+    if(cacheLine && cacheLine->Mesi == MesiState::Modified)
+    {
+        WriteBack(address, external, cacheLine->Data);
+        SetMesi(cacheLine, MesiState::Exclusive);
+    }
+}
+
+template<uSys IndexBits, uSys SetLineCount, template<uSys> typename ReplacementPolicy>
+void Cache<IndexBits, SetLineCount, ReplacementPolicy>::WriteBack(const u64 address, const bool external, const u32* const data) noexcept
+{
+    CountStatistic(ECacheStatistic::Writebacks);
+    m_Parent->WriteBackCacheLine(m_LineIndex, address, external, data);
+}
+
+template<uSys IndexBits, uSys SetLineCount, template<uSys> typename ReplacementPolicy>
+void Cache<IndexBits, SetLineCount, ReplacementPolicy>::FillLineShared(CacheLine* const cacheLine, const u64 address, const bool external) noexcept
+{
+    if(m_Parent->ReadCacheLine(m_LineIndex, address, external, cacheLine->Data))
+    {
+        SetMesi(cacheLine, MesiState::Shared);
+    }
+    else
+    {
+        SetMesi(cacheLine, MesiState::Exclusive);
+    }
+}
+
+template<uSys IndexBits, uSys SetLineCount, template<uSys> typename ReplacementPolicy>
+CacheLine* Cache<IndexBits, SetLineCount, ReplacementPolicy>::AcquireLineShared(u64 address, const bool external) noexcept
+{
+    address >>= 3;
+    address <<= 3;
+    CacheLine* cacheLine = GetCacheLine(address, external);
     
     if(!cacheLine || cacheLine->Mesi == MesiState::Invalid)
     {
+        CountMiss(address, external);
+
         if(!cacheLine)
         {
             cacheLine = GetFreeCacheLine(address, external);
         }
 
-        if(m_Parent->ReadCacheLine(m_LineIndex, address, external, cacheLine->Data))
-        {
-            cacheLine->Mesi = MesiState::Shared;
-        }
-        else
-        {
-            cacheLine->Mesi = MesiState::Exclusive;
-        }
+        InsertLine(address, cacheLine);
+        FillLineShared(cacheLine, address, external);
+    }
+    else
+    {
+        CountHit(address, external, cacheLine);
     }
 
-    return cacheLine->Data[lineOffset];
+    return cacheLine;
 }
 
-template<uSys IndexBits, uSys SetLineCount>
-void Cache<IndexBits, SetLineCount>::Write(u64 address, const u32 value, const bool external, const bool writeThrough) noexcept
+template<uSys IndexBits, uSys SetLineCount, template<uSys> typename ReplacementPolicy>
+CacheLine* Cache<IndexBits, SetLineCount, ReplacementPolicy>::AcquireLineModified(u64 address, const bool external) noexcept
 {
-    const u64 lineOffset = address & 0x7;
     address >>= 3;
     address <<= 3;
-    CacheLine<IndexBits>* cacheLine = GetCacheLine(address, external);
+    CacheLine* cacheLine = GetCacheLine(address, external);
 
     if(!cacheLine || cacheLine->Mesi == MesiState::Invalid)
     {
+        CountMiss(address, external);
+
         if(!cacheLine)
         {
             cacheLine = GetFreeCacheLine(address, external);
         }
 
+        InsertLine(address, cacheLine);
         (void) m_Parent->ReadXCacheLine(m_LineIndex, address, external, cacheLine->Data);
-        cacheLine->Mesi = MesiState::Modified;
+        SetMesi(cacheLine, MesiState::Modified);
     }
     else if(cacheLine->Mesi == MesiState::Exclusive || cacheLine->Mesi == MesiState::Modified)
     {
-        cacheLine->Mesi = MesiState::Modified;
+        CountHit(address, external, cacheLine);
+        SetMesi(cacheLine, MesiState::Modified);
     }
     else if(cacheLine->Mesi == MesiState::Shared)
     {
-        cacheLine->Mesi = MesiState::Modified;
+        CountHit(address, external, cacheLine);
+        SetMesi(cacheLine, MesiState::Modified);
         m_Parent->UpgradeCacheLine(m_LineIndex, address, external);
     }
 
-    cacheLine->Data[lineOffset] = value;
-    if(writeThrough)
-    {
-        m_Parent->WriteBackCacheLine(m_LineIndex, address, external, cacheLine->Data);
-    }
-}
-
-template<uSys IndexBits, uSys SetLineCount>
-void Cache<IndexBits, SetLineCount>::Flush() noexcept
-{
-    for(uSys i = 0; i < 1 << IndexBits; ++i)
-    {
-        CacheSet<IndexBits, SetLineCount>& cacheSet = m_Sets[i];
-
-        for(u32 j = 0; j < SetLineCount; ++j)
-        {
-            CacheLine<IndexBits>& cacheLine = cacheSet.SetLines[j];
-
-            if(cacheLine.Mesi == MesiState::Modified)
-            {
-                const u64 address = (cacheLine.Tag << (IndexBits + 3)) | (i << 3);
-
-                m_Parent->WriteBackCacheLine(m_LineIndex, address, cacheLine.External, cacheLine.Data);
-                cacheLine.Mesi = MesiState::Exclusive;
-            }
-        }
-    }
+    return cacheLine;
 }
 
-template<uSys IndexBits, uSys SetLineCount>
-CacheLine<IndexBits>* Cache<IndexBits, SetLineCount>::GetFreeCacheLine(const u64 address, const bool external) noexcept
+template<uSys IndexBits, uSys SetLineCount, template<uSys> typename ReplacementPolicy>
+CacheLine* Cache<IndexBits, SetLineCount, ReplacementPolicy>::GetFreeCacheLine(const u64 address, const bool external) noexcept
 {
     const u64 setIndex = (address >> 3) & ((1 << IndexBits) - 1);
     const u64 tag = address >> (IndexBits + 3);
@@ -107,51 +241,55 @@ CacheLine<IndexBits>* Cache<IndexBits, SetLineCount>::GetFreeCacheLine(const u64
     {
         if(targetSet.SetLines[i].Mesi == MesiState::Invalid)
         {
-            targetSet.SetLines[i].Tag = tag;
-            targetSet.SetLines[i].External = external;
+            targetSet.SetTag(i, tag, external);
             return &targetSet.SetLines[i];
         }
     }
 
-    for(uSys i = 0; i < SetLineCount; ++i)
-    {
-        if(targetSet.SetLines[i].Mesi == MesiState::Exclusive || targetSet.SetLines[i].Mesi == MesiState::Shared)
-        {
-            targetSet.SetLines[i].Tag = tag;
-            targetSet.SetLines[i].External = external;
-            return &targetSet.SetLines[i];
-        }
-    }
+    const uSys victim = m_Replacement[setIndex].Victim();
+    CacheLine* const cacheLine = &targetSet.SetLines[victim];
+
+    // Write the victim back to where it came from, not the address replacing it.
+    const u64 victimAddress = (targetSet.GetTag(victim) << (IndexBits + 3)) | (setIndex << 3);
 
-    // This will be implemented as an n-bit rolling integer.
-    const u64 rollingSelector = (m_RollingSelector++) % SetLineCount;
+    CountDrop(cacheLine);
 
-    CacheLine<IndexBits>* const cacheLine = &targetSet.SetLines[rollingSelector];
+    // A clean line is just dropped, unless an inner cache had modified it.
+    const bool innerModified = m_Parent->EvictCacheLine(m_LineIndex, victimAddress, targetSet.IsExternal(victim), cacheLine->Data);
 
-    m_Parent->WriteBackCacheLine(m_LineIndex, address, external, cacheLine->Data);
-    cacheLine->Tag = tag;
+    if(cacheLine->Mesi == MesiState::Modified || innerModified)
+    {
+        WriteBack(victimAddress, targetSet.IsExternal(victim), cacheLine->Data);
+    }
+
+    SetMesi(cacheLine, MesiState::Invalid);
+    targetSet.SetTag(victim, tag, external);
 
     return cacheLine;
 }
 
-template<uSys IndexBits, uSys SetLineCount>
-bool Cache<IndexBits, SetLineCount>::SnoopBusRead(const u32 requestorLine, const u64 address, const bool external, u32* const dataBus) noexcept
+template<uSys IndexBits, uSys SetLineCount, template<uSys> typename ReplacementPolicy>
+bool Cache<IndexBits, SetLineCount, ReplacementPolicy>::SnoopBusRead(const u32 requestorLine, const u64 address, const bool external, u32* const dataBus) noexcept
 {
     if(requestorLine == m_LineIndex)
     {
         return false;
     }
 
-    CacheLine<IndexBits>* cacheLine = GetCacheLine(address, external);
+    CountStatistic(ECacheStatistic::SnoopsReceived);
+
+    CacheLine* cacheLine = GetCacheLine(address, external);
 
     if(!cacheLine || cacheLine->Mesi == MesiState::Invalid)
     {
         return false;
     }
 
+    CountStatistic(ECacheStatistic::SnoopHits);
+
     if(cacheLine->Mesi == MesiState::Exclusive)
     {
-        cacheLine->Mesi = MesiState::Shared;
+        SetMesi(cacheLine, MesiState::Shared);
         if(dataBus)
         {
             (void) ::std::memcpy(dataBus, cacheLine->Data, sizeof(cacheLine->Data));
@@ -166,35 +304,40 @@ bool Cache<IndexBits, SetLineCount>::SnoopBusRead(const u32 requestorLine, const
     }
     else if(cacheLine->Mesi == MesiState::Modified)
     {
-        cacheLine->Mesi = MesiState::Shared;
+        SetMesi(cacheLine, MesiState::Shared);
         if(dataBus)
         {
             (void) ::std::memcpy(dataBus, cacheLine->Data, sizeof(cacheLine->Data));
         }
-        m_Parent->WriteBackCacheLine(m_LineIndex, address, external, cacheLine->Data);
+        WriteBack(address, external, cacheLine->Data);
     }
 
     return true;
 }
 
-template<uSys IndexBits, uSys SetLineCount>
-bool Cache<IndexBits, SetLineCount>::SnoopBusReadX(const u32 requestorLine, const u64 address, const bool external, u32* const dataBus) noexcept
+template<uSys IndexBits, uSys SetLineCount, template<uSys> typename ReplacementPolicy>
+bool Cache<IndexBits, SetLineCount, ReplacementPolicy>::SnoopBusReadX(const u32 requestorLine, const u64 address, const bool external, u32* const dataBus) noexcept
 {
     if(requestorLine == m_LineIndex)
     {
         return false;
     }
 
-    CacheLine<IndexBits>* cacheLine = GetCacheLine(address, external);
+    CountStatistic(ECacheStatistic::SnoopsReceived);
+
+    CacheLine* cacheLine = GetCacheLine(address, external);
 
     if(!cacheLine || cacheLine->Mesi == MesiState::Invalid)
     {
         return false;
     }
 
+    CountStatistic(ECacheStatistic::SnoopHits);
+    CountInvalidation(address, external, cacheLine, false);
+
     if(cacheLine->Mesi == MesiState::Exclusive)
     {
-        cacheLine->Mesi = MesiState::Invalid;
+        SetMesi(cacheLine, MesiState::Invalid);
         if(dataBus)
         {
             (void) ::std::memcpy(dataBus, cacheLine->Data, sizeof(cacheLine->Data));
@@ -202,7 +345,7 @@ bool Cache<IndexBits, SetLineCount>::SnoopBusReadX(const u32 requestorLine, cons
     }
     else if(cacheLine->Mesi == MesiState::Shared)
     {
-        cacheLine->Mesi = MesiState::Invalid;
+        SetMesi(cacheLine, MesiState::Invalid);
         if(dataBus)
         {
             (void) ::std::memcpy(dataBus, cacheLine->Data, sizeof(cacheLine->Data));
@@ -210,29 +353,60 @@ bool Cache<IndexBits, SetLineCount>::SnoopBusReadX(const u32 requestorLine, cons
     }
     else if(cacheLine->Mesi == MesiState::Modified)
     {
-        cacheLine->Mesi = MesiState::Invalid;
+        SetMesi(cacheLine, MesiState::Invalid);
         if(dataBus)
         {
             (void) ::std::memcpy(dataBus, cacheLine->Data, sizeof(cacheLine->Data));
         }
-        m_Parent->WriteBackCacheLine(m_LineIndex, address, external, cacheLine->Data);
+        WriteBack(address, external, cacheLine->Data);
     }
 
     return true;
 }
 
-template<uSys IndexBits, uSys SetLineCount>
-void Cache<IndexBits, SetLineCount>::SnoopBusUpgrade(const u32 requestorLine, const u64 address, const bool external) noexcept
+template<uSys IndexBits, uSys SetLineCount, template<uSys> typename ReplacementPolicy>
+void Cache<IndexBits, SetLineCount, ReplacementPolicy>::SnoopBusUpgrade(const u32 requestorLine, const u64 address, const bool external) noexcept
 {
     if(requestorLine == m_LineIndex)
     {
         return;
     }
 
-    CacheLine<IndexBits>* cacheLine = GetCacheLine(address, external);
+    CountStatistic(ECacheStatistic::SnoopsReceived);
+
+    CacheLine* cacheLine = GetCacheLine(address, external);
+
+    if(cacheLine && cacheLine->Mesi == MesiState::Shared)
+    {
+        CountStatistic(ECacheStatistic::SnoopHits);
+        CountInvalidation(address, external, cacheLine, false);
+        SetMesi(cacheLine, MesiState::Invalid);
+    }
+}
+
+template<uSys IndexBits, uSys SetLineCount, template<uSys> typename ReplacementPolicy>
+bool Cache<IndexBits, SetLineCount, ReplacementPolicy>::SnoopBackInvalidate(const u64 address, const bool external, u32* const data) noexcept
+{
+    CountStatistic(ECacheStatistic::SnoopsReceived);
+
+    CacheLine* cacheLine = GetCacheLine(address, external);
+
+    if(!cacheLine || cacheLine->Mesi == MesiState::Invalid)
+    {
+        return false;
+    }
+
+    CountStatistic(ECacheStatistic::SnoopHits);
+
+    const bool modified = cacheLine->Mesi == MesiState::Modified;
 
-    if(cacheLine->Mesi == MesiState::Shared)
+    if(modified)
     {
-        cacheLine->Mesi = MesiState::Invalid;
+        (void) ::std::memcpy(data, cacheLine->Data, sizeof(cacheLine->Data));
     }
+
+    CountInvalidation(address, external, cacheLine, true);
+    SetMesi(cacheLine, MesiState::Invalid);
+
+    return modified;
 }
@@ -0,0 +1,280 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#pragma once
+
+#include <cstring>
+#include <bit>
+
+#include <Objects.hpp>
+#include <NumTypes.hpp>
+
+// Whether the caches sort their misses by cause, which costs a shadow lookup on every access.
+#ifndef SOFT_GPU_CACHE_MISS_CLASSIFICATION
+    #define SOFT_GPU_CACHE_MISS_CLASSIFICATION 1
+#endif
+
+enum class EMissClass : u8
+{
+    // The first access to the line.
+    Compulsory = 0,
+    // A fully associative cache of the same size wouldn't have held the line either.
+    Capacity,
+    // A fully associative cache of the same size would still have held the line.
+    Conflict,
+    // Another cache took the line away with a snoop.
+    Coherence,
+    Count
+};
+
+/**
+ * \brief Sorts the misses of a cache of Capacity lines by their cause.
+ *
+ *   This isn't part of the hardware, it's the bookkeeping behind the
+ * miss counters. A shadow fully associative LRU cache of the same size
+ * sees every access the real cache does. A miss on a line the cache has
+ * never seen is compulsory, one which misses in the shadow too is a
+ * capacity miss, and one the shadow would have hit is a conflict miss.
+ * Snoops which invalidate a line mark it in the shadow, so the next miss
+ * on it is a coherence miss. An outer cache evicting the line for
+ * inclusion is counted as a capacity miss, as it's that cache's lack of
+ * room.
+ *
+ *   The lines which have been seen are a bit per line of a 16 MiB
+ * window of addresses, so lines a multiple of that apart share a bit.
+ * The first access to the second of them counts as a capacity or
+ * conflict miss.
+ */
+template<uSys Capacity>
+class CacheMissClassifier final
+{
+    DEFAULT_DESTRUCT(CacheMissClassifier);
+    DELETE_CM(CacheMissClassifier);
+public:
+    static inline constexpr u32 SEEN_INDEX_BITS = 20;
+    static inline constexpr u32 BUCKET_COUNT = static_cast<u32>(::std::bit_ceil(Capacity * 2));
+    static inline constexpr u32 NONE = ~0u;
+private:
+    enum class ELoss : u8
+    {
+        None = 0,
+        Snoop,
+        BackInvalidate
+    };
+
+    struct ShadowLine final
+    {
+        u64 Key;
+        // Towards the most and least recently used lines.
+        u32 Newer;
+        u32 Older;
+        // The next line in the same hash bucket.
+        u32 BucketNext;
+        ELoss Loss;
+    };
+public:
+    CacheMissClassifier() noexcept
+        : m_Seen{ }
+        , m_Lines{ }
+        , m_Newest(NONE)
+        , m_Oldest(NONE)
+        , m_LineCount(0)
+    {
+        // An empty bucket is NONE, not 0.
+        (void) ::std::memset(m_Buckets, 0xFF, sizeof(m_Buckets));
+    }
+
+    void Reset() noexcept
+    {
+        (void) ::std::memset(m_Seen, 0, sizeof(m_Seen));
+        (void) ::std::memset(m_Buckets, 0xFF, sizeof(m_Buckets));
+        m_Newest = NONE;
+        m_Oldest = NONE;
+        m_LineCount = 0;
+    }
+
+    // A read or write hit the line.
+    void Hit(const u64 key) noexcept
+    {
+        Touch(key);
+    }
+
+    // The line was filled without a read or write, by a prefetch.
+    void Fill(const u64 key) noexcept
+    {
+        (void) MarkSeen(key);
+        Touch(key);
+    }
+
+    // A read or write missed the line, which is then filled.
+    [[nodiscard]] EMissClass Miss(const u64 key) noexcept
+    {
+        EMissClass missClass = EMissClass::Compulsory;
+
+        if(MarkSeen(key))
+        {
+            const u32 line = Find(key);
+
+            if(line == NONE || m_Lines[line].Loss == ELoss::BackInvalidate)
+            {
+                missClass = EMissClass::Capacity;
+            }
+            else if(m_Lines[line].Loss == ELoss::Snoop)
+            {
+                missClass = EMissClass::Coherence;
+            }
+            else
+            {
+                missClass = EMissClass::Conflict;
+            }
+        }
+
+        Touch(key);
+
+        return missClass;
+    }
+
+    // A snoop invalidated the line.
+    void SnoopInvalidate(const u64 key) noexcept
+    {
+        MarkLoss(key, ELoss::Snoop);
+    }
+
+    // An inclusive outer cache evicted the line.
+    void BackInvalidate(const u64 key) noexcept
+    {
+        MarkLoss(key, ELoss::BackInvalidate);
+    }
+private:
+    [[nodiscard]] static u32 Bucket(const u64 key) noexcept
+    {
+        return static_cast<u32>((key * 0x9E3779B97F4A7C15ull) >> 40) & (BUCKET_COUNT - 1);
+    }
+
+    // Returns whether the line had already been seen.
+    [[nodiscard]] bool MarkSeen(const u64 key) noexcept
+    {
+        const u64 index = key & ((1ull << SEEN_INDEX_BITS) - 1);
+        u64& word = m_Seen[index / 64];
+        const u64 bit = 1ull << (index % 64);
+
+        const bool seen = (word & bit) != 0;
+        word |= bit;
+
+        return seen;
+    }
+
+    [[nodiscard]] u32 Find(const u64 key) const noexcept
+    {
+        for(u32 line = m_Buckets[Bucket(key)]; line != NONE; line = m_Lines[line].BucketNext)
+        {
+            if(m_Lines[line].Key == key)
+            {
+                return line;
+            }
+        }
+
+        return NONE;
+    }
+
+    void MarkLoss(const u64 key, const ELoss loss) noexcept
+    {
+        const u32 line = Find(key);
+
+        if(line != NONE)
+        {
+            m_Lines[line].Loss = loss;
+        }
+    }
+
+    // Makes the line the most recently used, replacing the least recently used line if it isn't held.
+    void Touch(const u64 key) noexcept
+    {
+        u32 line = Find(key);
+
+        if(line != NONE)
+        {
+            Unlink(line);
+        }
+        else
+        {
+            if(m_LineCount < Capacity)
+            {
+                line = m_LineCount++;
+            }
+            else
+            {
+                line = m_Oldest;
+                Unlink(line);
+                RemoveFromBucket(line);
+            }
+
+            const u32 bucket = Bucket(key);
+
+            m_Lines[line].Key = key;
+            m_Lines[line].BucketNext = m_Buckets[bucket];
+            m_Buckets[bucket] = line;
+        }
+
+        m_Lines[line].Loss = ELoss::None;
+        m_Lines[line].Newer = NONE;
+        m_Lines[line].Older = m_Newest;
+
+        if(m_Newest != NONE)
+        {
+            m_Lines[m_Newest].Newer = line;
+        }
+
+        m_Newest = line;
+
+        if(m_Oldest == NONE)
+        {
+            m_Oldest = line;
+        }
+    }
+
+    void Unlink(const u32 line) noexcept
+    {
+        ShadowLine& shadowLine = m_Lines[line];
+
+        if(shadowLine.Newer != NONE)
+        {
+            m_Lines[shadowLine.Newer].Older = shadowLine.Older;
+        }
+        else
+        {
+            m_Newest = shadowLine.Older;
+        }
+
+        if(shadowLine.Older != NONE)
+        {
+            m_Lines[shadowLine.Older].Newer = shadowLine.Newer;
+        }
+        else
+        {
+            m_Oldest = shadowLine.Newer;
+        }
+    }
+
+    void RemoveFromBucket(const u32 line) noexcept
+    {
+        u32* link = &m_Buckets[Bucket(m_Lines[line].Key)];
+
+        while(*link != line)
+        {
+            link = &m_Lines[*link].BucketNext;
+        }
+
+        *link = m_Lines[line].BucketNext;
+    }
+private:
+    u64 m_Seen[(1ull << SEEN_INDEX_BITS) / 64];
+    u32 m_Buckets[BUCKET_COUNT];
+    ShadowLine m_Lines[Capacity];
+    u32 m_Newest;
+    u32 m_Oldest;
+    u32 m_LineCount;
+};
@@ -0,0 +1,244 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#pragma once
+
+#include <bit>
+
+#include <Objects.hpp>
+#include <NumTypes.hpp>
+
+/*
+ *   The replacement policies a cache can choose its victims with. Each
+ * holds the replacement state of a single set of Ways lines. A cache
+ * calls Insert when it fills a way, Touch when a read or write hits
+ * one, and Victim for the way to replace once every way is valid.
+ * Snoops and flushes don't count as uses. Victim may update the state,
+ * SRRIP ages the set until a line is due for replacement.
+ */
+
+/**
+ * \brief Tree pseudo-LRU, a bit per node of a binary tree over the ways.
+ *
+ *   Each bit points to the half of its subtree which was used less
+ * recently. A use flips the bits on its path to point away from it, and
+ * the victim is found by following the bits from the root. This costs
+ * Ways - 1 bits per set rather than true LRU's log2(Ways) per way, and
+ * only ever differs from it in which of the older lines it picks.
+ */
+template<uSys Ways>
+struct TreePlruReplacement final
+{
+    DEFAULT_CONSTRUCT_PU(TreePlruReplacement);
+    DEFAULT_DESTRUCT(TreePlruReplacement);
+    DEFAULT_CM_PU(TreePlruReplacement);
+public:
+    static_assert(::std::has_single_bit(Ways) && Ways <= 64, "Tree PLRU needs a power of 2 ways, at most 64.");
+
+    static inline constexpr uSys LEVELS = static_cast<uSys>(::std::countr_zero(Ways));
+
+    // Node n has children 2n and 2n + 1, the root is node 1, and a set bit points to the upper half.
+    u64 Nodes;
+
+    void Reset() noexcept
+    {
+        Nodes = 0;
+    }
+
+    void Insert(const uSys way) noexcept
+    {
+        Touch(way);
+    }
+
+    void Touch(const uSys way) noexcept
+    {
+        uSys node = 1;
+
+        for(uSys level = LEVELS; level > 0; --level)
+        {
+            const uSys upper = (way >> (level - 1)) & 1;
+
+            if(upper)
+            {
+                Nodes &= ~(1ull << node);
+            }
+            else
+            {
+                Nodes |= 1ull << node;
+            }
+
+            node = node * 2 + upper;
+        }
+    }
+
+    [[nodiscard]] uSys Victim() noexcept
+    {
+        uSys node = 1;
+
+        for(uSys level = 0; level < LEVELS; ++level)
+        {
+            node = node * 2 + ((Nodes >> node) & 1);
+        }
+
+        return node - Ways;
+    }
+};
+
+/**
+ * \brief True LRU, the age rank of each way.
+ *
+ *   The ranks are always a permutation of 0 through Ways - 1, 0 being
+ * the most recently used. A use moves its way to 0 and ages every way
+ * which was younger than it, the victim is the way ranked Ways - 1.
+ */
+template<uSys Ways>
+struct LruReplacement final
+{
+    DEFAULT_CONSTRUCT_PU(LruReplacement);
+    DEFAULT_DESTRUCT(LruReplacement);
+    DEFAULT_CM_PU(LruReplacement);
+public:
+    u8 Ranks[Ways];
+
+    // Before any use the lower ways are the older, so an empty set is filled in order.
+    void Reset() noexcept
+    {
+        for(uSys i = 0; i < Ways; ++i)
+        {
+            Ranks[i] = static_cast<u8>(Ways - 1 - i);
+        }
+    }
+
+    void Insert(const uSys way) noexcept
+    {
+        Touch(way);
+    }
+
+    void Touch(const uSys way) noexcept
+    {
+        const u8 rank = Ranks[way];
+
+        for(uSys i = 0; i < Ways; ++i)
+        {
+            if(Ranks[i] < rank)
+            {
+                ++Ranks[i];
+            }
+        }
+
+        Ranks[way] = 0;
+    }
+
+    [[nodiscard]] uSys Victim() noexcept
+    {
+        for(uSys i = 0; i < Ways; ++i)
+        {
+            if(Ranks[i] == Ways - 1)
+            {
+                return i;
+            }
+        }
+
+        return 0;
+    }
+};
+
+/**
+ * \brief Replaces a pseudo-random way, from a 16 bit LFSR per set.
+ *
+ *   Uses don't change anything. Every set starts from the same seed, so
+ * a run replaces the same lines each time.
+ */
+template<uSys Ways>
+struct RandomReplacement final
+{
+    DEFAULT_CONSTRUCT_PU(RandomReplacement);
+    DEFAULT_DESTRUCT(RandomReplacement);
+    DEFAULT_CM_PU(RandomReplacement);
+public:
+    static inline constexpr u16 SEED = 0xACE1;
+    // The taps of x^16 + x^14 + x^13 + x^11 + 1, which has the full period of 65535.
+    static inline constexpr u16 TAPS = 0xB400;
+
+    u16 Lfsr;
+
+    void Reset() noexcept
+    {
+        Lfsr = SEED;
+    }
+
+    void Insert(const uSys) noexcept
+    { }
+
+    void Touch(const uSys) noexcept
+    { }
+
+    [[nodiscard]] uSys Victim() noexcept
+    {
+        Lfsr = static_cast<u16>((Lfsr >> 1) ^ ((Lfsr & 1) ? TAPS : 0));
+        return Lfsr % Ways;
+    }
+};
+
+/**
+ * \brief Static re-reference interval prediction, with 2 bits per way.
+ *
+ *   Each way holds how far off its next use is predicted to be, from 0
+ * for imminent to 3 for distant. Lines are inserted at 2, so one which
+ * is never hit again is replaced ahead of those which were, and a hit
+ * predicts an imminent reuse. The victim is the first way at 3, ageing
+ * the whole set until there is one. A scan through more lines than the
+ * set holds then only displaces the lines of the scan.
+ */
+template<uSys Ways>
+struct SrripReplacement final
+{
+    DEFAULT_CONSTRUCT_PU(SrripReplacement);
+    DEFAULT_DESTRUCT(SrripReplacement);
+    DEFAULT_CM_PU(SrripReplacement);
+public:
+    static inline constexpr u8 DISTANT = 3;
+    static inline constexpr u8 INSERTED = 2;
+
+    u8 Intervals[Ways];
+
+    void Reset() noexcept
+    {
+        for(uSys i = 0; i < Ways; ++i)
+        {
+            Intervals[i] = DISTANT;
+        }
+    }
+
+    void Insert(const uSys way) noexcept
+    {
+        Intervals[way] = INSERTED;
+    }
+
+    void Touch(const uSys way) noexcept
+    {
+        Intervals[way] = 0;
+    }
+
+    [[nodiscard]] uSys Victim() noexcept
+    {
+        while(true)
+        {
+            for(uSys i = 0; i < Ways; ++i)
+            {
+                if(Intervals[i] == DISTANT)
+                {
+                    return i;
+                }
+            }
+
+            for(uSys i = 0; i < Ways; ++i)
+            {
+                ++Intervals[i];
+            }
+        }
+    }
+};
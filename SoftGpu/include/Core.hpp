@@ -9,6 +9,7 @@
 #include <Objects.hpp>
 #include <NumTypes.hpp>
 #include "FPU.hpp"
+#include "CoreTiming.hpp"
 #include "CoreRegisterManager.hpp"
 #include "RegisterFile.hpp"
 
@@ -25,6 +26,7 @@ class ICore
 public:
     virtual void InvokeRegisterFileHigh(RegisterFile::CommandPacket packet) noexcept = 0;
     virtual void InvokeRegisterFileLow(RegisterFile::CommandPacket packet) noexcept = 0;
+    virtual void ReleaseRegisterContestation(u32 registerIndex) noexcept = 0;
 
     virtual void ReportRegisterValues(u64 a, u64 b, u64 c) noexcept = 0;
     virtual void PrepareRegisterWrite(bool is64Bit, u32 storageRegister, u64 value) noexcept = 0;
@@ -32,22 +34,33 @@ public:
     virtual void ReportReady() const noexcept = 0;
 };
 
-class FpCore final : public ICore
+enum class ECoreCapability : u32
 {
-    DEFAULT_DESTRUCT(FpCore);
-    DELETE_CM(FpCore);
+    Fp = 0, // Floating point only.
+    IntFp // Floating point and integer, the integer ALU is not yet implemented.
+};
+
+// The FP and Int/FP cores share everything but how they report back to the dispatch units, so the capability is
+// resolved at compile time and the SM clocks each array of cores without going through ICore.
+template<ECoreCapability Capability>
+class Core final : public ICore
+{
+    DEFAULT_DESTRUCT(Core);
+    DELETE_CM(Core);
+public:
+    static inline constexpr u32 PIPELINE_DEPTH = 3;
 public:
-    FpCore(StreamingMultiprocessor* const sm, const u32 unitIndex) noexcept
+    Core(StreamingMultiprocessor* const sm, const u32 unitIndex, const FpuTimingTable* const timingTable) noexcept
         : m_SM(sm)
         , m_UnitIndex(unitIndex)
-        , m_Fpu(this)
+        , m_TimingTable(timingTable)
+        , m_Fpu(this, timingTable)
         , m_CRM(this)
-        , m_PipelineSlot0{ }
-        , m_PipelineSlot1{ }
-        , m_PipelineSlot2{ }
-        , m_Stage0Ready(false)
-        , m_Stage1Ready(false)
-        , m_Stage2Ready(false)
+        , m_Timing{ }
+        , m_PipelineSlots{ }
+        , m_PipelineBase(0)
+        , m_StageReadyMask(0)
+        , m_IssuePort(0)
         , m_Pad{ }
     { }
 
@@ -55,187 +68,155 @@ public:
     {
         m_Fpu.Reset();
         m_CRM.Reset();
-        m_PipelineSlot0 = { };
-        m_PipelineSlot1 = { };
-        m_PipelineSlot2 = { };
-        m_Stage0Ready = false;
-        m_Stage1Ready = false;
-        m_Stage2Ready = false;
+        m_Timing.Reset();
+        m_PipelineSlots[0] = { };
+        m_PipelineSlots[1] = { };
+        m_PipelineSlots[2] = { };
+        m_PipelineBase = 0;
+        m_StageReadyMask = 0;
+        m_IssuePort = 0;
     }
 
     void Clock(const u32 clockIndex) noexcept
     {
         m_CRM.Clock(clockIndex);
 
-        if(clockIndex == 2 && m_Stage2Ready)
+        if(clockIndex == 2)
         {
-            m_Fpu.ExecuteInstruction(m_PipelineSlot2);
+            if(m_StageReadyMask & 0x4)
+            {
+                m_Fpu.ExecuteInstruction(PipelineSlot(2));
+            }
+
+            // A write held back by a bank conflict holds the writeback ring, so every later result slips a cycle.
+            CoreTiming::PendingWrite write;
+            if(!m_CRM.IsWriteStalled() && m_Timing.RetireWriteback(&write))
+            {
+                m_CRM.InitiateRegisterWrite(write.Is64Bit, write.StorageRegister, write.Value);
+            }
         }
         else if(clockIndex == 5)
         {
-            (void) ::std::memcpy(&m_PipelineSlot2, &m_PipelineSlot1, sizeof(LoadedFpuInstruction));
-            (void) ::std::memcpy(&m_PipelineSlot1, &m_PipelineSlot0, sizeof(LoadedFpuInstruction));
-
-            m_Stage2Ready = m_Stage1Ready;
-            m_Stage1Ready = m_Stage0Ready;
-            m_Stage0Ready = false;
+            // The CRM has finished latching this cycle's register locks, so we can report whether we can accept another instruction.
+            ReportReady();
+
+            m_Timing.ClockIssue();
+
+            // Rotate the pipeline rather than copying it, stage 2 is retired and its slot becomes the new stage 0.
+            m_PipelineBase = m_PipelineBase == 0 ? PIPELINE_DEPTH - 1 : m_PipelineBase - 1;
+
+            if(m_CRM.IsReadStalled())
+            {
+                // The instruction is still waiting on its operands, it stays in stage 0 and a bubble moves on behind
+                // the older instructions.
+                PipelineSlot(0) = PipelineSlot(1);
+                m_StageReadyMask = ((m_StageReadyMask << 1) & 0x4) | 0x1;
+            }
+            else
+            {
+                m_StageReadyMask = (m_StageReadyMask << 1) & 0x6;
+            }
         }
     }
     
     void InvokeRegisterFileHigh(RegisterFile::CommandPacket packet) noexcept override;
     void InvokeRegisterFileLow(RegisterFile::CommandPacket packet) noexcept override;
+    void ReleaseRegisterContestation(u32 registerIndex) noexcept override;
 
     void InitiateInstruction(const FpuInstruction fpuInstruction) noexcept
     {
-        m_CRM.InitiateRegisterRead(fpuInstruction.Precision == EPrecision::Double, RequiredRegisterCount(fpuInstruction.Operation), fpuInstruction.OperandA, fpuInstruction.OperandB, fpuInstruction.OperandC);
+        m_Timing.BeginIssue(m_TimingTable->Lookup(fpuInstruction.Operation, fpuInstruction.Precision, fpuInstruction.OperandC).InitiationInterval);
 
-        m_PipelineSlot0.DispatchPort = fpuInstruction.DispatchPort;
-        m_PipelineSlot0.Operation = fpuInstruction.Operation;
-        m_PipelineSlot0.Precision = fpuInstruction.Precision;
-        m_PipelineSlot0.StorageRegister = fpuInstruction.StorageRegister;
-        m_PipelineSlot0.OperandA = fpuInstruction.OperandA;
-        m_PipelineSlot0.OperandB = fpuInstruction.OperandB;
-        m_PipelineSlot0.OperandC = fpuInstruction.OperandC;
+        m_CRM.InitiateRegisterRead(fpuInstruction.Precision == EPrecision::Double, RequiredRegisterCount(fpuInstruction.Operation), fpuInstruction.OperandA, fpuInstruction.OperandB, fpuInstruction.OperandC);
 
-        m_Stage0Ready = true;
+        LoadedFpuInstruction& slot0 = PipelineSlot(0);
+        slot0.DispatchPort = fpuInstruction.DispatchPort;
+        m_IssuePort = fpuInstruction.DispatchPort;
+        slot0.Operation = fpuInstruction.Operation;
+        slot0.Precision = fpuInstruction.Precision;
+        slot0.StorageRegister = fpuInstruction.StorageRegister;
+        slot0.FlushToZero = fpuInstruction.FlushToZero;
+        slot0.DenormalsAreZero = fpuInstruction.DenormalsAreZero;
+        slot0.OperandA = fpuInstruction.OperandA;
+        slot0.OperandB = fpuInstruction.OperandB;
+        slot0.OperandC = fpuInstruction.OperandC;
+
+        m_StageReadyMask |= 0x1;
     }
 
     void ReportRegisterValues(const u64 a, const u64 b, const u64 c) noexcept override
     {
-        switch(RequiredRegisterCount(m_PipelineSlot2.Operation))
+        LoadedFpuInstruction& slot0 = PipelineSlot(0);
+
+        switch(RequiredRegisterCount(slot0.Operation))
         {
             case 2:
-                m_PipelineSlot0.OperandC = c;
+                slot0.OperandC = c;
             case 1:
-                m_PipelineSlot0.OperandB = b;
+                slot0.OperandB = b;
             case 0:
-                m_PipelineSlot0.OperandA = a;
+                slot0.OperandA = a;
             default: break;
         }
     }
 
     void PrepareRegisterWrite(const bool is64Bit, const u32 storageRegister, const u64 value) noexcept override
     {
-        m_CRM.InitiateRegisterWrite(is64Bit, storageRegister, value);
+        m_Timing.ScheduleWriteback(is64Bit, storageRegister, value, m_Fpu.ExecutionStage());
     }
 
     void ReportReady() const noexcept override;
-private:
-    StreamingMultiprocessor* m_SM;
-    u32 m_UnitIndex;
-    Fpu m_Fpu;
-    CoreRegisterManager m_CRM;
-
-    LoadedFpuInstruction m_PipelineSlot0;
-    LoadedFpuInstruction m_PipelineSlot1;
-    LoadedFpuInstruction m_PipelineSlot2;
 
-    u8 m_Stage0Ready : 1;
-    u8 m_Stage1Ready : 1;
-    u8 m_Stage2Ready : 1;
-    u8 m_Pad : 5;
-};
+    [[nodiscard]] const CoreTiming& Timing() const noexcept { return m_Timing; }
+    [[nodiscard]] const CoreRegisterManager& RegisterManager() const noexcept { return m_CRM; }
 
-class IntFpCore final : public ICore
-{
-    DEFAULT_DESTRUCT(IntFpCore);
-    DELETE_CM(IntFpCore);
-public:
-    IntFpCore(StreamingMultiprocessor* const sm, const u32 unitIndex) noexcept
-        : m_SM(sm)
-        , m_UnitIndex(unitIndex)
-        , m_Fpu(this)
-        , m_CRM(this)
-        , m_PipelineSlot0{ }
-        , m_PipelineSlot1{ }
-        , m_PipelineSlot2{ }
-        , m_Stage0Ready(false)
-        , m_Stage1Ready(false)
-        , m_Stage2Ready(false)
-        , m_Pad{ }
-    { }
-
-    void Reset()
+    void ResetStatistics() noexcept
     {
-        m_Fpu.Reset();
-        m_CRM.Reset();
-        m_PipelineSlot0 = { };
-        m_PipelineSlot1 = { };
-        m_PipelineSlot2 = { };
-        m_Stage0Ready = false;
-        m_Stage1Ready = false;
-        m_Stage2Ready = false;
+        m_CRM.ResetStatistics();
     }
 
-    void Clock(const u32 clockIndex) noexcept
+    void ObserveRegisterWrite(const u32 registerIndex, const u32 value) noexcept
     {
-        m_CRM.Clock(clockIndex);
-
-        if(clockIndex == 2 && m_Stage2Ready)
-        {
-            m_Fpu.ExecuteInstruction(m_PipelineSlot2);
-        }
-        else if(clockIndex == 5)
-        {
-            (void) ::std::memcpy(&m_PipelineSlot2, &m_PipelineSlot1, sizeof(LoadedFpuInstruction));
-            (void) ::std::memcpy(&m_PipelineSlot1, &m_PipelineSlot0, sizeof(LoadedFpuInstruction));
-
-            m_Stage2Ready = m_Stage1Ready;
-            m_Stage1Ready = m_Stage0Ready;
-            m_Stage0Ready = false;
-        }
+        m_CRM.ObserveRegisterWrite(registerIndex, value);
     }
-    
-    void InvokeRegisterFileHigh(RegisterFile::CommandPacket packet) noexcept override;
-    void InvokeRegisterFileLow(RegisterFile::CommandPacket packet) noexcept override;
-    
-    void InitiateInstructionFP(const FpuInstruction fpuInstruction) noexcept
-    {
-        m_CRM.InitiateRegisterRead(fpuInstruction.Precision == EPrecision::Double, RequiredRegisterCount(fpuInstruction.Operation), fpuInstruction.OperandA, fpuInstruction.OperandB, fpuInstruction.OperandC);
-
-        m_PipelineSlot0.DispatchPort = fpuInstruction.DispatchPort;
-        m_PipelineSlot0.Operation = fpuInstruction.Operation;
-        m_PipelineSlot0.Precision = fpuInstruction.Precision;
-        m_PipelineSlot0.StorageRegister = fpuInstruction.StorageRegister;
-        m_PipelineSlot0.OperandA = fpuInstruction.OperandA;
-        m_PipelineSlot0.OperandB = fpuInstruction.OperandB;
-        m_PipelineSlot0.OperandC = fpuInstruction.OperandC;
 
-        m_Stage0Ready = true;
+    void InvalidateOperands() noexcept
+    {
+        m_CRM.InvalidateOperands();
     }
-
-    void ReportRegisterValues(const u64 a, const u64 b, const u64 c) noexcept override
+private:
+    // The FP cores have register file ports 0 - 7 and the Int/FP cores have 8 - 15.
+    [[nodiscard]] u32 RegisterPort() const noexcept
     {
-        switch(RequiredRegisterCount(m_PipelineSlot2.Operation))
-        {
-            case 2:
-                m_PipelineSlot0.OperandC = c;
-            case 1:
-                m_PipelineSlot0.OperandB = b;
-            case 0:
-                m_PipelineSlot0.OperandA = a;
-            default: break;
-        }
+        return Capability == ECoreCapability::Fp ? m_UnitIndex : 8 + m_UnitIndex;
     }
 
-    void PrepareRegisterWrite(const bool is64Bit, const u32 storageRegister, const u64 value) noexcept override
+    [[nodiscard]] LoadedFpuInstruction& PipelineSlot(const u32 stage) noexcept
     {
-        m_CRM.InitiateRegisterWrite(is64Bit, storageRegister, value);
+        const u32 index = m_PipelineBase + stage;
+        return m_PipelineSlots[index >= PIPELINE_DEPTH ? index - PIPELINE_DEPTH : index];
     }
-
-    void ReportReady() const noexcept override;
 private:
     StreamingMultiprocessor* m_SM;
     u32 m_UnitIndex;
+    const FpuTimingTable* m_TimingTable;
     Fpu m_Fpu;
     CoreRegisterManager m_CRM;
+    CoreTiming m_Timing;
 
-    LoadedFpuInstruction m_PipelineSlot0;
-    LoadedFpuInstruction m_PipelineSlot1;
-    LoadedFpuInstruction m_PipelineSlot2;
+    LoadedFpuInstruction m_PipelineSlots[PIPELINE_DEPTH];
 
-    u8 m_Stage0Ready : 1;
-    u8 m_Stage1Ready : 1;
-    u8 m_Stage2Ready : 1;
-    u8 m_Pad : 5;
+    // The physical slot holding stage 0.
+    u8 m_PipelineBase : 2;
+    // Bit N is set when stage N holds an instruction.
+    u8 m_StageReadyMask : 3;
+    // The dispatch unit which issued the last instruction, it owns any stall that instruction causes.
+    u8 m_IssuePort : 1;
+    u8 m_Pad : 2;
 };
+
+using FpCore = Core<ECoreCapability::Fp>;
+using IntFpCore = Core<ECoreCapability::IntFp>;
+
+extern template class Core<ECoreCapability::Fp>;
+extern template class Core<ECoreCapability::IntFp>;
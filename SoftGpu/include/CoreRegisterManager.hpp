@@ -8,9 +8,16 @@
 
 #include <Objects.hpp>
 #include <NumTypes.hpp>
+#include "OperandCollector.hpp"
+#include "RegisterFile.hpp"
 
 class ICore;
 
+// Reads a core's operands and writes its results through the core's register file port. The port carries one
+// operand per sub-clock, a 64 bit operand takes both halves. Operands held by the operand collector don't need the
+// port at all. A read or write held back by a bank conflict waits for the next cycle, the core stalls until it's
+// done.
+
 class CoreRegisterManager final
 {
     DEFAULT_DESTRUCT(CoreRegisterManager);
@@ -28,6 +35,12 @@ public:
         , m_WriteLock64Bit{ }
         , m_RegisterReadEnabledCount{ }
         , m_RegisterReadLockEnabledCount{ }
+        , m_ReadOperand{ }
+        , m_ReadInFlight{ }
+        , m_ReadCollected{ }
+        , m_ReadStalled{ }
+        , m_WriteIssued{ }
+        , m_WriteStalled{ }
         , m_Pad0{ }
         , m_RegisterReadA{ }
         , m_RegisterReadB{ }
@@ -38,6 +51,15 @@ public:
         , m_RegisterWrite{ }
         , m_RegisterWriteValue{ }
         , m_RegisterWriteLock{ }
+        , m_ReadValues{ }
+        , m_ReadLow{ }
+        , m_ReadHigh{ }
+        , m_WriteLow{ }
+        , m_WriteHigh{ }
+        , m_BankConflictStallCycles(0)
+        , m_CollectedRegisterReads(0)
+        , m_PortRegisterReads(0)
+        , m_OperandCollector{ }
     { }
 
     void Reset()
@@ -52,6 +74,12 @@ public:
         m_WriteLock64Bit = { };
         m_RegisterReadEnabledCount = { };
         m_RegisterReadLockEnabledCount = { };
+        m_ReadOperand = { };
+        m_ReadInFlight = { };
+        m_ReadCollected = { };
+        m_ReadStalled = { };
+        m_WriteIssued = { };
+        m_WriteStalled = { };
         m_Pad0 = { };
         m_RegisterReadA = { };
         m_RegisterReadB = { };
@@ -62,6 +90,17 @@ public:
         m_RegisterWrite = { };
         m_RegisterWriteValue = { };
         m_RegisterWriteLock = { };
+        m_ReadValues[0] = { };
+        m_ReadValues[1] = { };
+        m_ReadValues[2] = { };
+        m_ReadLow = { };
+        m_ReadHigh = { };
+        m_WriteLow = { };
+        m_WriteHigh = { };
+        m_BankConflictStallCycles = 0;
+        m_CollectedRegisterReads = 0;
+        m_PortRegisterReads = 0;
+        m_OperandCollector.Reset();
     }
 
     void Clock() noexcept
@@ -74,8 +113,64 @@ public:
 
     void InitiateRegisterRead(bool is64Bit, u8 registerCount, u32 registerA, u32 registerB, u32 registerC) noexcept;
     void InitiateRegisterWrite(bool is64Bit, u32 storageRegister, u64 value) noexcept;
+
+    // Whether the register read or write for this cycle is waiting on a bank conflict.
+    [[nodiscard]] bool IsReadStalled() const noexcept { return m_ReadStalled; }
+    [[nodiscard]] bool IsWriteStalled() const noexcept { return m_WriteStalled; }
+
+    [[nodiscard]] u64 BankConflictStallCycles() const noexcept { return m_BankConflictStallCycles; }
+    // Register reads the operand collector saved the port, a 64 bit operand is 2.
+    [[nodiscard]] u64 CollectedRegisterReads() const noexcept { return m_CollectedRegisterReads; }
+    // Register reads sent through the port.
+    [[nodiscard]] u64 PortRegisterReads() const noexcept { return m_PortRegisterReads; }
+
+    void ResetStatistics() noexcept
+    {
+        m_BankConflictStallCycles = 0;
+        m_CollectedRegisterReads = 0;
+        m_PortRegisterReads = 0;
+        m_OperandCollector.ResetStatistics();
+    }
+
+    // Another unit wrote to the register file, drop any operand it made stale.
+    void ObserveRegisterWrite(const u32 registerIndex, const u32 value) noexcept
+    {
+        m_OperandCollector.ObserveWrite(registerIndex, value);
+    }
+
+    // Used when the register file changed without going through the ports.
+    void InvalidateOperands() noexcept
+    {
+        m_OperandCollector.InvalidateAll();
+    }
+
+    [[nodiscard]] const OperandCollector& Operands() const noexcept { return m_OperandCollector; }
+private:
+    // The result of a command on one half of the port.
+    struct PortAccess final
+    {
+        u32 Value;
+        bool Successful;
+        bool Unsuccessful;
+    };
 private:
-    void RegisterRead() noexcept;
+    // Looks up a 32 or 64 bit operand in the operand collector.
+    [[nodiscard]] bool CollectOperand(u32 registerIndex, u64* value) noexcept;
+
+    // Sends a command for a single register down the port half its low bit selects.
+    void InvokeRegister(RegisterFile::ECommand command, u32 registerIndex, PortAccess& access) noexcept;
+
+    // Starts reading a 32 or 64 bit operand through the port.
+    void IssueOperandRead(u32 registerIndex) noexcept;
+    // Whether the operand read has come back from the register file.
+    [[nodiscard]] bool IsOperandReadDone(u32 registerIndex) const noexcept;
+    // Takes the operand read off the port, keeping it in the operand collector.
+    [[nodiscard]] u64 CompleteOperandRead(u32 registerIndex) noexcept;
+
+    [[nodiscard]] bool IsWriteDone() const noexcept;
+
+    // Collects the operand on the port and moves on to the next one, which is only sent if issue is set.
+    void RegisterRead(bool issue) noexcept;
     void ReadLockRelease() noexcept;
     void RegisterWrite() noexcept;
     void WriteLockRelease() noexcept;
@@ -103,8 +198,20 @@ private:
     u8 m_RegisterReadEnabledCount : 2;
     // How many base registers are having their read lock released, can either be 1, 2, 3 using 1 indexing.
     u8 m_RegisterReadLockEnabledCount : 2;
+    // The operand being read, the ones before it have been collected.
+    u8 m_ReadOperand : 2;
+    // Whether the read of m_ReadOperand is on the port.
+    u8 m_ReadInFlight : 1;
+    // Whether every operand has been collected and reported to the core.
+    u8 m_ReadCollected : 1;
+    // Whether the read is being held back by a bank conflict.
+    u8 m_ReadStalled : 1;
+    // Whether the write is on the port.
+    u8 m_WriteIssued : 1;
+    // Whether the write is being held back by a bank conflict.
+    u8 m_WriteStalled : 1;
     // Padding for x86.
-    u8 m_Pad0 : 4;
+    u8 m_Pad0 : 5;
 
     // The A register to read.
     u16 m_RegisterReadA;
@@ -127,4 +234,21 @@ private:
 
     // The register to release the write lock on.
     u32 m_RegisterWriteLock;
+
+    // The operands collected so far.
+    u64 m_ReadValues[3];
+
+    // The port halves hold on to these until their commands execute, even registers go through the low half.
+    PortAccess m_ReadLow;
+    PortAccess m_ReadHigh;
+    PortAccess m_WriteLow;
+    PortAccess m_WriteHigh;
+
+    // The number of cycles a read or write waited on a bank conflict.
+    u64 m_BankConflictStallCycles;
+    u64 m_CollectedRegisterReads;
+    u64 m_PortRegisterReads;
+
+    // Recently read and written registers, these don't need a register file read.
+    OperandCollector m_OperandCollector;
 };
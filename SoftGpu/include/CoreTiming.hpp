@@ -0,0 +1,129 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#pragma once
+
+#include <Objects.hpp>
+#include <NumTypes.hpp>
+#include <ConPrinter.hpp>
+
+#include <cassert>
+#include <cstring>
+
+// Tracks the structural hazards of a core's execution unit.
+//
+// Instructions always execute a fixed number of cycles after they are issued, so holding back issue for
+// InitiationInterval - 1 cycles is enough to model a non-pipelined unit. Results are held in a slot ring
+// indexed by the cycle they retire on, a core only has a single write port, so if two results would retire
+// on the same cycle the later one slips to the next free cycle.
+class CoreTiming final
+{
+    DEFAULT_DESTRUCT(CoreTiming);
+    DELETE_CM(CoreTiming);
+public:
+    static inline constexpr u32 WRITEBACK_SLOT_COUNT = 64;
+
+    struct PendingWrite final
+    {
+        u64 Value;
+        u32 StorageRegister : 12;
+        u32 Is64Bit : 1;
+        u32 Valid : 1;
+        u32 Reserved : 18; // Reserved bits for alignment in x86, these can be removed in hardware.
+    };
+public:
+    CoreTiming() noexcept
+        : m_WritebackSlots{ }
+        , m_WritebackHead(0)
+        , m_IssueBlockedCycles(0)
+        , m_StructuralStallCycles(0)
+        , m_WritebackConflicts(0)
+        , m_RetiredWritebacks(0)
+    { }
+
+    void Reset()
+    {
+        (void) ::std::memset(m_WritebackSlots, 0, sizeof(m_WritebackSlots));
+        m_WritebackHead = 0;
+        m_IssueBlockedCycles = 0;
+        m_StructuralStallCycles = 0;
+        m_WritebackConflicts = 0;
+        m_RetiredWritebacks = 0;
+    }
+
+    // Called when an instruction is accepted by the core.
+    void BeginIssue(const u32 initiationInterval) noexcept
+    {
+        m_IssueBlockedCycles = initiationInterval > 1 ? initiationInterval - 1 : 0;
+    }
+
+    [[nodiscard]] bool IsIssueBlocked() const noexcept { return m_IssueBlockedCycles != 0; }
+
+    // Called once per cycle after the core has reported whether it can accept an instruction.
+    void ClockIssue() noexcept
+    {
+        if(m_IssueBlockedCycles != 0)
+        {
+            --m_IssueBlockedCycles;
+            ++m_StructuralStallCycles;
+        }
+    }
+
+    // A latency of 1 retires on the same cycle the instruction executes.
+    void ScheduleWriteback(const bool is64Bit, const u32 storageRegister, const u64 value, const u32 latency) noexcept
+    {
+        const u32 delay = latency > 1 ? latency - 1 : 0;
+
+        for(u32 i = delay; i < WRITEBACK_SLOT_COUNT; ++i)
+        {
+            PendingWrite& slot = m_WritebackSlots[(m_WritebackHead + i) % WRITEBACK_SLOT_COUNT];
+
+            if(slot.Valid)
+            {
+                ++m_WritebackConflicts;
+                continue;
+            }
+
+            slot.Value = value;
+            slot.StorageRegister = storageRegister;
+            slot.Is64Bit = is64Bit;
+            slot.Valid = true;
+            slot.Reserved = 0;
+            return;
+        }
+
+        ConPrinter::PrintLn("Core writeback ring overflowed, latency {} is too long.", latency);
+        assert(false);
+    }
+
+    // Pops the writeback for this cycle, returns false if nothing retires.
+    [[nodiscard]] bool RetireWriteback(PendingWrite* const write) noexcept
+    {
+        PendingWrite& slot = m_WritebackSlots[m_WritebackHead];
+        m_WritebackHead = (m_WritebackHead + 1) % WRITEBACK_SLOT_COUNT;
+
+        if(!slot.Valid)
+        {
+            return false;
+        }
+
+        *write = slot;
+        slot.Valid = false;
+        ++m_RetiredWritebacks;
+        return true;
+    }
+
+    [[nodiscard]] u64 StructuralStallCycles() const noexcept { return m_StructuralStallCycles; }
+    [[nodiscard]] u64 WritebackConflicts() const noexcept { return m_WritebackConflicts; }
+    [[nodiscard]] u64 RetiredWritebacks() const noexcept { return m_RetiredWritebacks; }
+private:
+    PendingWrite m_WritebackSlots[WRITEBACK_SLOT_COUNT];
+    u32 m_WritebackHead;
+    u32 m_IssueBlockedCycles;
+    u64 m_StructuralStallCycles;
+    u64 m_WritebackConflicts;
+    u64 m_RetiredWritebacks;
+};
@@ -24,6 +24,7 @@ inline constexpr u32 DebugCodeCheckForPause = 7;
 inline constexpr u32 DebugCodeReportRegisterFile = 8;
 inline constexpr u32 DebugCodeReportBaseRegister = 9;
 inline constexpr u32 DebugCodeReportRegisterContestion = 10;
+inline constexpr u32 DebugCodeReportRegisterSnapshot = 11;
 
 class DebugManager final
 {
@@ -20,7 +20,7 @@ enum class EInstruction : u8
 {
     Nop = 0,
     Hlt,
-    LoadStore, // { 0 : 1, Read/Write : 1, IndexExponent : 3, RegisterCount : 3 }, BaseRegister : 8, [ IndexRegister : 8 ], TargetRegister : 8, Offset : 16
+    LoadStore, // { Shared : 1, Read/Write : 1, IndexExponent : 3, RegisterCount : 3 }, BaseRegister : 8, [ IndexRegister : 8 ], TargetRegister : 8, Offset : 16
     LoadImmediate, // Register : 8, Value : 32
     LoadZero, // RegisterCount : 8, StartRegister : 8
     SwapRegister, // RegisterA : 8, RegisterB : 8
@@ -88,13 +88,38 @@ enum class EInstruction : u8
     RemVec2D, // RegisterA : 8, RegisterB : 8, StorageRegister : 8
     RemVec3D, // RegisterA : 8, RegisterB : 8, StorageRegister : 8
     RemVec4D, // RegisterA : 8, RegisterB : 8, StorageRegister : 8
+    // bfloat16 ops read and write two packed elements per register, Vec3B and Vec4B span 2 registers.
+    AddB,     // RegisterA : 8, RegisterB : 8, StorageRegister : 8
+    AddVec2B, // RegisterA : 8, RegisterB : 8, StorageRegister : 8
+    AddVec3B, // RegisterA : 8, RegisterB : 8, StorageRegister : 8
+    AddVec4B, // RegisterA : 8, RegisterB : 8, StorageRegister : 8
+    SubB,     // RegisterA : 8, RegisterB : 8, StorageRegister : 8
+    SubVec2B, // RegisterA : 8, RegisterB : 8, StorageRegister : 8
+    SubVec3B, // RegisterA : 8, RegisterB : 8, StorageRegister : 8
+    SubVec4B, // RegisterA : 8, RegisterB : 8, StorageRegister : 8
+    MulB,     // RegisterA : 8, RegisterB : 8, StorageRegister : 8
+    MulVec2B, // RegisterA : 8, RegisterB : 8, StorageRegister : 8
+    MulVec3B, // RegisterA : 8, RegisterB : 8, StorageRegister : 8
+    MulVec4B, // RegisterA : 8, RegisterB : 8, StorageRegister : 8
+    DivB,     // RegisterA : 8, RegisterB : 8, StorageRegister : 8
+    DivVec2B, // RegisterA : 8, RegisterB : 8, StorageRegister : 8
+    DivVec3B, // RegisterA : 8, RegisterB : 8, StorageRegister : 8
+    DivVec4B, // RegisterA : 8, RegisterB : 8, StorageRegister : 8
+    RemB,     // RegisterA : 8, RegisterB : 8, StorageRegister : 8
+    RemVec2B, // RegisterA : 8, RegisterB : 8, StorageRegister : 8
+    RemVec3B, // RegisterA : 8, RegisterB : 8, StorageRegister : 8
+    RemVec4B, // RegisterA : 8, RegisterB : 8, StorageRegister : 8
+    SetFpMode, // { FlushToZero : 1, DenormalsAreZero : 1, 0 : 6 }
+    // Addressed like LoadStore. The operand in TargetRegister (and TargetRegister + 1 if Wide) is replaced with the previous value,
+    // CompareExchange compares against it and stores the value in the register(s) after it. Wide atomics are aligned to 2 words.
+    Atomic, // { SignedCompare : 1, Wide : 1, IndexExponent : 3, EAtomicOperation : 3 }, BaseRegister : 8, [ IndexRegister : 8 ], TargetRegister : 8, Offset : 16
 };
 
 namespace InstructionDecodeData {
 
 struct LoadStoreData final
 {
-    u32 Pad : 1;
+    u32 Shared : 1;
     u32 ReadWrite : 1;
     u32 IndexExponent : 3;
     u32 RegisterCount : 3;
@@ -104,6 +129,18 @@ struct LoadStoreData final
     i16 Offset;
 };
 
+struct AtomicData final
+{
+    u32 SignedCompare : 1;
+    u32 Wide : 1;
+    u32 IndexExponent : 3;
+    u32 Operation : 3;
+    u32 BaseRegister : 8;
+    u32 IndexRegister : 8;
+    u32 TargetRegister : 8;
+    i16 Offset;
+};
+
 struct LoadImmediateData final
 {
     u8 Register;
@@ -116,6 +153,21 @@ struct LoadZeroData final
     u8 StartRegister;
 };
 
+// Statistic indices:
+//   0 - 4: FP, Int/FP, Ld/St and texture saturation, and structural stalls.
+//   5: Register bank conflicts across all banks.
+//   6: Cycles the Ld/St units waited on bank conflicts.
+//   7: Cycles the cores waited on bank conflicts.
+//   8: Register reads the cores' operand collectors saved their register file ports, a 64 bit operand is 2.
+//   9: Register reads the cores sent through their register file ports.
+//   10: Register file compactions.
+//   11: Registers moved by compaction.
+//   12: Register allocations which only succeeded after compacting.
+//   13: Shared memory bank conflicts.
+//   16 - 31: Register bank conflicts for bank N - 16 (REGISTER_BANK_STATISTIC_BASE).
+//   32 - 63: EOccupancyStatistic N - 32, summed over the SM's warp schedulers (OCCUPANCY_STATISTIC_BASE).
+//   64 and up: ECacheStatistic N - 64 of the SM's L0 (CACHE_STATISTIC_BASE).
+// Indices without a statistic, and those past the end of an enum, read 0.
 struct WriteStatisticsData final
 {
     u8 StatisticIndex;
@@ -133,13 +185,20 @@ struct FpuBinOpData final
     EBinOp BinOp;
 };
 
+struct SetFpModeData final
+{
+    u8 Mode;
+};
+
 union InstructionData
 {
     LoadStoreData LoadStore;
+    AtomicData Atomic;
     LoadImmediateData LoadImmediate;
     LoadZeroData LoadZero;
     WriteStatisticsData WriteStatistics;
     FpuBinOpData FpuBinOp;
+    SetFpModeData SetFpMode;
 };
 
 }
@@ -148,6 +207,12 @@ class DispatchUnit final
 {
     DEFAULT_DESTRUCT(DispatchUnit);
     DELETE_CM(DispatchUnit);
+public:
+    static inline constexpr u32 REGISTER_BANK_STATISTIC_BASE = 16;
+    // WriteStatistics indices from here on read the SM's EOccupancyStatistic counters.
+    static inline constexpr u32 OCCUPANCY_STATISTIC_BASE = 32;
+    // And from here on the ECacheStatistic counters of the SM's L0.
+    static inline constexpr u32 CACHE_STATISTIC_BASE = 64;
 public:
     DispatchUnit(StreamingMultiprocessor* const sm, const u32 index) noexcept
         : m_SM(sm)
@@ -155,6 +220,7 @@ public:
         , m_BaseRegisters{ 0, 0, 0, 0, 0, 0, 0, 0 }
         , m_ClockIndex(0)
         , m_InstructionPointer(0)
+        , m_InstructionStartPointer(0)
         , m_FpAvailabilityMap(0xFF)
         , m_IntFpAvailabilityMap(0xFF)
         , m_SfuAvailabilityMap(0xF)
@@ -165,6 +231,12 @@ public:
         , m_ReplicationMask(0x0)
         , m_ReplicationCompletedMask(0x0)
         , m_VectorOpIndex(0)
+        , m_FlushToZero(0)
+        , m_DenormalsAreZero(0)
+        , m_YieldRequested(0)
+        , m_DependencyStalled(0)
+        , m_UnitStalled(0)
+        , m_Issued(0)
         , m_Pad1{ }
         , m_CurrentInstruction(EInstruction::Nop)
         , m_DecodedInstructionData{ }
@@ -173,6 +245,7 @@ public:
         , m_SfuSaturationTracker(0)
         , m_LdStSaturationTracker(0)
         , m_TextureSaturationTracker(0)
+        , m_StructuralStallTracker(0)
         , m_TotalIterationsTracker(0)
     { }
 
@@ -189,6 +262,7 @@ public:
 
         m_ClockIndex = 0;
         m_InstructionPointer = 0;
+        m_InstructionStartPointer = 0;
         m_FpAvailabilityMap = 0xFF;
         m_IntFpAvailabilityMap = 0xFF;
         m_SfuAvailabilityMap = 0xF;
@@ -199,6 +273,12 @@ public:
         m_ReplicationMask = 0x0;
         m_ReplicationCompletedMask = 0x0;
         m_VectorOpIndex = 0;
+        m_FlushToZero = 0;
+        m_DenormalsAreZero = 0;
+        m_YieldRequested = 0;
+        m_DependencyStalled = 0;
+        m_UnitStalled = 0;
+        m_Issued = 0;
         m_Pad1 = { };
         m_CurrentInstruction = EInstruction::Nop;
         m_DecodedInstructionData = { };
@@ -207,6 +287,7 @@ public:
         m_SfuSaturationTracker = 0;
         m_LdStSaturationTracker = 0;
         m_TextureSaturationTracker = 0;
+        m_StructuralStallTracker = 0;
         m_TotalIterationsTracker = 0;
     }
     
@@ -322,20 +403,110 @@ public:
         }
     }
 
+    // The unit is still occupied by a multi-cycle operation, it stays busy until it reports ready.
+    void ReportUnitStructuralStall() noexcept
+    {
+        ++m_StructuralStallTracker;
+    }
+
     void LoadIP(const u32 replicationMask, const u16 baseRegisters[4], const u64 instructionPointer) noexcept
     {
         m_ReplicationMask = replicationMask;
         m_ReplicationCompletedMask = 0x0;
         ::std::memcpy(m_BaseRegisters, baseRegisters, sizeof(u16[4]));
         m_InstructionPointer = instructionPointer;
+        m_FlushToZero = 0;
+        m_DenormalsAreZero = 0;
     }
 
-    void LoadWarp(const u32 enabledMask, const u32 completedMask, const u16 baseRegisters[8], const u64 instructionPointer) noexcept
+    void LoadWarp(const u32 enabledMask, const u32 completedMask, const u16 baseRegisters[8], const u64 instructionPointer, const FpMode fpMode) noexcept
     {
         m_ReplicationMask = enabledMask;
         m_ReplicationCompletedMask = completedMask;
         ::std::memcpy(m_BaseRegisters, baseRegisters, sizeof(m_BaseRegisters));
         m_InstructionPointer = instructionPointer;
+        // Warps are only switched at an instruction boundary, so the new warp starts by decoding.
+        m_NeedToDecode = true;
+        m_VectorOpIndex = 0;
+        m_FlushToZero = fpMode.FlushToZero;
+        m_DenormalsAreZero = fpMode.DenormalsAreZero;
+        m_YieldRequested = false;
+        m_CurrentInstruction = EInstruction::Nop;
+    }
+
+    // Leaves the dispatch unit idle until the next warp is loaded.
+    void UnloadWarp() noexcept
+    {
+        m_InstructionPointer = 0;
+        m_ReplicationMask = 0;
+        m_ReplicationCompletedMask = 0;
+        m_NeedToDecode = true;
+        m_YieldRequested = false;
+        m_CurrentInstruction = EInstruction::Nop;
+    }
+
+    // Stops at the next instruction boundary so the warp scheduler can switch warps.
+    void RequestYield() noexcept
+    {
+        m_YieldRequested = true;
+    }
+
+    [[nodiscard]] bool IsAtInstructionBoundary() const noexcept { return m_NeedToDecode; }
+
+    // Nothing of the current instruction is in flight for the thread being dispatched, so the warp can be switched
+    // out and pick up from the start of the instruction. Threads which already completed it aren't repeated.
+    [[nodiscard]] bool CanSwitchWarp() const noexcept { return m_NeedToDecode || m_VectorOpIndex == 0; }
+
+    // Where the warp has to pick up from if it's switched out now.
+    [[nodiscard]] u64 ResumeInstructionPointer() const noexcept { return m_NeedToDecode ? m_InstructionPointer : m_InstructionStartPointer; }
+
+    // An operand or destination register was still locked by an instruction in flight this cycle.
+    [[nodiscard]] bool IsDependencyStalled() const noexcept { return m_DependencyStalled; }
+
+    // No execution unit the instruction needed was free this cycle.
+    [[nodiscard]] bool IsUnitStalled() const noexcept { return m_UnitStalled; }
+
+    // At least one instruction, or one element of a vector, was dispatched this cycle.
+    [[nodiscard]] bool HasIssued() const noexcept { return m_Issued; }
+
+    // Every thread of the current warp has executed Hlt.
+    [[nodiscard]] bool IsWarpHalted() const noexcept
+    {
+        return m_InstructionPointer != 0 && m_CurrentInstruction == EInstruction::Hlt && m_ReplicationMask == 0;
+    }
+
+    [[nodiscard]] u64 InstructionPointer() const noexcept { return m_InstructionPointer; }
+    [[nodiscard]] u32 ReplicationMask() const noexcept { return m_ReplicationMask; }
+    [[nodiscard]] u32 ReplicationCompletedMask() const noexcept { return m_ReplicationCompletedMask; }
+    [[nodiscard]] u64 StructuralStalls() const noexcept { return m_StructuralStallTracker; }
+
+    // The register file was compacted and the current warp's registers moved, thread base registers of 0xFFFF are disabled threads.
+    void RelocateBaseRegisters(const u16 oldBase, const u16 newBase) noexcept
+    {
+        for(u16& baseRegister : m_BaseRegisters)
+        {
+            if(baseRegister != 0xFFFF)
+            {
+                baseRegister = static_cast<u16>(baseRegister - oldBase + newBase);
+            }
+        }
+    }
+
+    [[nodiscard]] u16 BaseRegister(const u32 replicationIndex) const noexcept { return m_BaseRegisters[replicationIndex]; }
+
+    void SetFpMode(const FpMode fpMode) noexcept
+    {
+        m_FlushToZero = fpMode.FlushToZero;
+        m_DenormalsAreZero = fpMode.DenormalsAreZero;
+    }
+
+    // The denormal mode of the current warp, this is saved by the warp scheduler when the warp is switched out.
+    [[nodiscard]] FpMode GetFpMode() const noexcept
+    {
+        FpMode fpMode { };
+        fpMode.FlushToZero = m_FlushToZero;
+        fpMode.DenormalsAreZero = m_DenormalsAreZero;
+        return fpMode;
     }
 
     void ReportBaseRegisters(const u32 smIndex) noexcept
@@ -360,18 +531,28 @@ private:
     void ReleaseRegisterContestation(u32 registerIndex, u32 replicationIndex) noexcept;
     void LockRegisterRead(u32 registerIndex, u32 replicationIndex) noexcept;
     void LockRegisterWrite(u32 registerIndex, u32 replicationIndex) noexcept;
+    // Instructions that complete in the dispatch unit write their results straight to the register file.
+    void WriteRegister(u32 registerIndex, u32 replicationIndex, u32 value) noexcept;
+    void WriteRegister64(u32 registerIndex, u32 replicationIndex, u64 value) noexcept;
 
     void DecodeLdSt(u64& localInstructionPointer, u32& wordIndex, u8 instructionBytes[4]) noexcept;
     void DecodeLoadImmediate(u64& localInstructionPointer, u32& wordIndex, u8 instructionBytes[4]) noexcept;
     void DecodeLoadZero(u64& localInstructionPointer, u32& wordIndex, u8 instructionBytes[4]) noexcept;
     void DecodeWriteStatistics(u64& localInstructionPointer, u32& wordIndex, u8 instructionBytes[4]) noexcept;
     void DecodeFpuBinOp(u64& localInstructionPointer, u32& wordIndex, u8 instructionBytes[4]) noexcept;
+    void DecodeSetFpMode(u64& localInstructionPointer, u32& wordIndex, u8 instructionBytes[4]) noexcept;
+    void DecodeAtomic(u64& localInstructionPointer, u32& wordIndex, u8 instructionBytes[4]) noexcept;
+
+    // Picks the lowest numbered Ld/St unit which is ready, stalling if there isn't one.
+    [[nodiscard]] bool SelectLdStUnit(u32& ldStUnit) noexcept;
 
     void DispatchLdSt(u32 replicationIndex) noexcept;
     void DispatchLoadImmediate(u32 replicationIndex) noexcept;
     void DispatchLoadZero(u32 replicationIndex) noexcept;
     void DispatchWriteStatistics(u32 replicationIndex) noexcept;
     void DispatchFpuBinOp(u32 replicationIndex) noexcept;
+    void DispatchSetFpMode(u32 replicationIndex) noexcept;
+    void DispatchAtomic(u32 replicationIndex) noexcept;
 private:
     template<typename T>
     T ReadT(u64& localInstructionPointer, u32& wordIndex, u8 instructionBytes[4]) const noexcept
@@ -396,6 +577,8 @@ private:
     u16 m_BaseRegisters[8];
     u32 m_ClockIndex;
     u64 m_InstructionPointer;
+    // Where the current instruction was decoded from.
+    u64 m_InstructionStartPointer;
     u32 m_FpAvailabilityMap : 8;
     u32 m_IntFpAvailabilityMap : 8;
     u32 m_SfuAvailabilityMap : 4;
@@ -407,7 +590,18 @@ private:
     u32 m_ReplicationCompletedMask : 8;
     // The current element of a vector we're operating on.
     u32 m_VectorOpIndex : 2;
-    u32 m_Pad1 : 14;
+    // The denormal mode applied to every FPU instruction dispatched.
+    u32 m_FlushToZero : 1;
+    u32 m_DenormalsAreZero : 1;
+    // The warp scheduler wants to switch warps, we stall at the next instruction boundary.
+    u32 m_YieldRequested : 1;
+    // Set when a register check fails, cleared at the start of each cycle.
+    u32 m_DependencyStalled : 1;
+    // Set when no execution unit is available, cleared at the start of each cycle.
+    u32 m_UnitStalled : 1;
+    // Set when anything is dispatched, cleared at the start of each cycle.
+    u32 m_Issued : 1;
+    u32 m_Pad1 : 8;
     // The currently decoded instruction.
     EInstruction m_CurrentInstruction;
     InstructionDecodeData::InstructionData m_DecodedInstructionData;
@@ -417,6 +611,7 @@ private:
     u64 m_SfuSaturationTracker;
     u64 m_LdStSaturationTracker;
     u64 m_TextureSaturationTracker;
+    u64 m_StructuralStallTracker;
     u64 m_TotalIterationsTracker;
 };
 
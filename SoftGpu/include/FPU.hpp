@@ -39,7 +39,8 @@ enum class EPrecision : u32
 {
     Single = 0,
     Half,
-    Double
+    Double,
+    BFloat16 // Two elements are packed per register, the low 16 bits hold the first element.
 };
 
 struct CompareFlags final
@@ -56,12 +57,29 @@ struct CompareFlags final
     };
 };
 
+// The denormal handling of a warp, this is set with EInstruction::SetFpMode and saved with the warp.
+struct FpMode final
+{
+    union
+    {
+        struct
+        {
+            u8 FlushToZero : 1;
+            u8 DenormalsAreZero : 1;
+            u8 Pad : 6;
+        };
+        u8 Value;
+    };
+};
+
 struct FpuInstruction final
 {
     u32 DispatchPort : 1; // Which Dispatch Port invoked this.
     EFpuOp Operation : 3; // What operation is being performed on the operands
     EPrecision Precision : 2; // What precision is being used
-    u32 Reserved0 : 26; // Reserved bits for alignment in x86, these can be removed in hardware.
+    u32 FlushToZero : 1; // Denormal results are replaced with a signed zero.
+    u32 DenormalsAreZero : 1; // Denormal operands are treated as a signed zero.
+    u32 Reserved0 : 24; // Reserved bits for alignment in x86, these can be removed in hardware.
     u64 OperandA : 12; // The first operand register.
     u64 OperandB : 12; // The second operand register.
     u64 OperandC : 12; // The third operand register.
@@ -75,12 +93,179 @@ struct LoadedFpuInstruction final
     EFpuOp Operation : 3; // What operation is being performed on the operands
     EPrecision Precision : 2; // What precision is being used
     u32 StorageRegister : 12;  // The storage register.
-    u32 Reserved : 14; // Reserved bits for alignment in x86, these can be removed in hardware.
+    u32 FlushToZero : 1; // Denormal results are replaced with a signed zero.
+    u32 DenormalsAreZero : 1; // Denormal operands are treated as a signed zero.
+    u32 Reserved : 12; // Reserved bits for alignment in x86, these can be removed in hardware.
     u64 OperandA; // The first operand.
     u64 OperandB; // The second operand.
     u64 OperandC; // The third operand.
 };
 
+// bfloat16 is the upper half of a binary32, so widening is exact.
+[[nodiscard]] inline constexpr u32 BFloat16ToFloat32(const u16 value) noexcept
+{
+    return static_cast<u32>(value) << 16;
+}
+
+// Narrows a binary32 to bfloat16 using round to nearest, ties to even.
+// NaNs have their quiet bit forced, otherwise dropping the low payload bits could turn them into an infinity.
+[[nodiscard]] inline constexpr u16 Float32ToBFloat16(const u32 value) noexcept
+{
+    if((value & 0x7FFFFFFF) > 0x7F800000)
+    {
+        return static_cast<u16>((value >> 16) | 0x0040);
+    }
+
+    const u32 roundingBias = 0x7FFF + ((value >> 16) & 0x1);
+    return static_cast<u16>((value + roundingBias) >> 16);
+}
+
+[[nodiscard]] inline constexpr u32 PackBFloat16x2(const u16 low, const u16 high) noexcept
+{
+    return (static_cast<u32>(high) << 16) | low;
+}
+
+[[nodiscard]] inline constexpr u16 UnpackBFloat16(const u32 packed, const u32 lane) noexcept
+{
+    return static_cast<u16>(packed >> (lane * 16));
+}
+
+// Groups the operations that share an execution unit, and therefore a latency.
+enum class EFpuTimingClass : u32
+{
+    Add = 0, // Add and Subtract
+    Multiply,
+    Divide,
+    Remainder,
+    Fma,
+    Round,
+    Compare,
+    NegateAbs,
+    Count
+};
+
+struct FpuOpTiming final
+{
+    // How many cycles from execution until the result is written back.
+    u8 Latency;
+    // How many cycles until the unit can begin another operation, non-pipelined operations set this to their latency.
+    u8 InitiationInterval;
+};
+
+[[nodiscard]] inline constexpr EFpuTimingClass GetFpuTimingClass(const EFpuOp op, const EBinOp binOp) noexcept
+{
+    switch(op)
+    {
+        case EFpuOp::BasicBinOp:
+            switch(binOp)
+            {
+                case EBinOp::Add:
+                case EBinOp::Subtract: return EFpuTimingClass::Add;
+                case EBinOp::Multiply: return EFpuTimingClass::Multiply;
+                case EBinOp::Divide: return EFpuTimingClass::Divide;
+                case EBinOp::Remainder: return EFpuTimingClass::Remainder;
+                default: return EFpuTimingClass::Add;
+            }
+        case EFpuOp::Fma: return EFpuTimingClass::Fma;
+        case EFpuOp::Round: return EFpuTimingClass::Round;
+        case EFpuOp::Compare: return EFpuTimingClass::Compare;
+        case EFpuOp::NegateAbs: return EFpuTimingClass::NegateAbs;
+        default: return EFpuTimingClass::NegateAbs;
+    }
+}
+
+// The latency and initiation interval of every operation at every precision.
+// This is configuration rather than hardware state, it exists so that different unit designs can be swept without recompiling.
+class FpuTimingTable final
+{
+    DEFAULT_DESTRUCT(FpuTimingTable);
+    DEFAULT_CM_PUC(FpuTimingTable);
+public:
+    static inline constexpr u32 PRECISION_COUNT = 4;
+    static inline constexpr u32 MAX_LATENCY = 32;
+public:
+    // The default table models the latencies the FPU was designed around, divides and remainders are not pipelined.
+    constexpr FpuTimingTable() noexcept
+        : m_Timings{ }
+    {
+        // Latencies are listed as Single, Half, Double, BFloat16.
+        SetAll(EFpuTimingClass::Add,       4,  4,  8,  4);
+        SetAll(EFpuTimingClass::Multiply,  5,  5, 10,  5);
+        SetAll(EFpuTimingClass::Divide,    6,  6, 12,  6);
+        SetAll(EFpuTimingClass::Remainder, 6,  6, 12,  6);
+        SetAll(EFpuTimingClass::Fma,      10, 10, 20, 10);
+        SetAll(EFpuTimingClass::Round,     4,  3,  5,  4);
+        SetAll(EFpuTimingClass::Compare,   4,  4,  8,  4);
+        SetAll(EFpuTimingClass::NegateAbs, 1,  1,  1,  1);
+
+        for(u32 precision = 0; precision < PRECISION_COUNT; ++precision)
+        {
+            m_Timings[static_cast<u32>(EFpuTimingClass::Divide)][precision].InitiationInterval = m_Timings[static_cast<u32>(EFpuTimingClass::Divide)][precision].Latency;
+            m_Timings[static_cast<u32>(EFpuTimingClass::Remainder)][precision].InitiationInterval = m_Timings[static_cast<u32>(EFpuTimingClass::Remainder)][precision].Latency;
+        }
+    }
+
+    // Every operation completes in a single cycle and is fully pipelined.
+    [[nodiscard]] static constexpr FpuTimingTable SingleCycle() noexcept
+    {
+        FpuTimingTable table;
+
+        for(u32 timingClass = 0; timingClass < static_cast<u32>(EFpuTimingClass::Count); ++timingClass)
+        {
+            for(u32 precision = 0; precision < PRECISION_COUNT; ++precision)
+            {
+                table.m_Timings[timingClass][precision] = { 1, 1 };
+            }
+        }
+
+        return table;
+    }
+
+    [[nodiscard]] constexpr FpuOpTiming Get(const EFpuTimingClass timingClass, const EPrecision precision) const noexcept
+    {
+        return m_Timings[static_cast<u32>(timingClass)][static_cast<u32>(precision)];
+    }
+
+    // Operand C only selects the operation for BasicBinOp, otherwise it is ignored.
+    [[nodiscard]] constexpr FpuOpTiming Lookup(const EFpuOp op, const EPrecision precision, const u64 operandC) const noexcept
+    {
+        return Get(GetFpuTimingClass(op, static_cast<EBinOp>(operandC)), precision);
+    }
+
+    // Both values are clamped to [1, MAX_LATENCY].
+    constexpr void Set(const EFpuTimingClass timingClass, const EPrecision precision, const u32 latency, const u32 initiationInterval) noexcept
+    {
+        FpuOpTiming& timing = m_Timings[static_cast<u32>(timingClass)][static_cast<u32>(precision)];
+        timing.Latency = static_cast<u8>(Clamp(latency));
+        timing.InitiationInterval = static_cast<u8>(Clamp(initiationInterval));
+    }
+private:
+    constexpr void SetAll(const EFpuTimingClass timingClass, const u32 single, const u32 half, const u32 doubleLatency, const u32 bFloat16) noexcept
+    {
+        Set(timingClass, EPrecision::Single, single, 1);
+        Set(timingClass, EPrecision::Half, half, 1);
+        Set(timingClass, EPrecision::Double, doubleLatency, 1);
+        Set(timingClass, EPrecision::BFloat16, bFloat16, 1);
+    }
+
+    [[nodiscard]] static constexpr u32 Clamp(const u32 cycles) noexcept
+    {
+        if(cycles < 1)
+        {
+            return 1;
+        }
+
+        if(cycles > MAX_LATENCY)
+        {
+            return MAX_LATENCY;
+        }
+
+        return cycles;
+    }
+private:
+    FpuOpTiming m_Timings[static_cast<u32>(EFpuTimingClass::Count)][PRECISION_COUNT];
+};
+
 class ICore;
 
 class Fpu final
@@ -88,8 +273,9 @@ class Fpu final
     DEFAULT_DESTRUCT(Fpu);
     DELETE_CM(Fpu);
 public:
-    Fpu(ICore* const core) noexcept
+    Fpu(ICore* const core, const FpuTimingTable* const timingTable) noexcept
         : m_Core(core)
+        , m_TimingTable(timingTable)
         , m_ExecutionStage(0)
         , m_DispatchPort{ }
         , m_ReplicationIndex{ }
@@ -109,11 +295,15 @@ public:
     void Clock() noexcept;
 
     void ExecuteInstruction(LoadedFpuInstruction instructionInfo) noexcept;
+
+    // The latency of the last executed instruction, this is valid as soon as ExecuteInstruction starts writing results.
+    [[nodiscard]] u32 ExecutionStage() const noexcept { return m_ExecutionStage; }
 private:
     [[nodiscard]] f32 BasicBinOpF32(f32 valueA, f32 valueB, EBinOp op) noexcept;
     [[nodiscard]] f64 BasicBinOpF64(f64 valueA, f64 valueB, EBinOp op) noexcept;
     [[nodiscard]] f32 FmaF32(f32 valueA, f32 valueB, f32 valueC) noexcept;
     [[nodiscard]] f64 FmaF64(f64 valueA, f64 valueB, f64 valueC) noexcept;
+    [[nodiscard]] u16 FmaBF16(f32 valueA, f32 valueB, f32 valueC) noexcept;
     [[nodiscard]] f32 RoundF32(ERoundingMode roundingMode, f32 value) noexcept;
     [[nodiscard]] u16 RoundF16(ERoundingMode roundingMode, f32 value) noexcept;
     [[nodiscard]] f64 RoundF64(ERoundingMode roundingMode, f64 value) noexcept;
@@ -122,8 +312,10 @@ private:
     [[nodiscard]] u32 NegateAbsF32(u32 value, bool isAbs) noexcept;
     [[nodiscard]] u32 NegateAbsF16(u32 value, bool isAbs) noexcept;
     [[nodiscard]] u64 NegateAbsF64(u64 value, bool isAbs) noexcept;
+    [[nodiscard]] u32 NegateAbsBF16x2(u32 value, bool isAbs) noexcept;
 private:
     ICore* m_Core;
+    const FpuTimingTable* m_TimingTable;
     u32 m_ExecutionStage;
     u32 m_DispatchPort;
     u32 m_ReplicationIndex;
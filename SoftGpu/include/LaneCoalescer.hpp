@@ -0,0 +1,109 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#pragma once
+
+#include <Objects.hpp>
+#include <NumTypes.hpp>
+
+#include <cstring>
+
+/**
+ * \brief Merges the memory accesses of a replicated instruction's lanes.
+ *
+ *   A dispatch unit issues each lane of a replicated Ld/St instruction
+ * to its own Ld/St unit, and starts a group for the instruction with its
+ * first lane. The lines a lane loads or stores are recorded against the
+ * group along with their translation. A later lane of the same
+ * instruction which touches a recorded line takes it from here, without
+ * another translation or line access, so lanes accessing adjacent
+ * addresses cost one transaction per line between them.
+ *
+ *   A loaded line keeps its data as it was read, with the SM's buffered
+ * stores forwarded over it. Any store the SM makes to the line drops it,
+ * so a lane never sees data older than a store it's ordered after. A
+ * merged store still writes its words to the store buffer, where they
+ * combine with the first lane's.
+ *
+ *   Uncached and write-through lines aren't recorded, every lane
+ * accesses those itself. Each dispatch unit has one group at a time, a
+ * lane which accesses memory after its dispatch unit has moved on to
+ * the next instruction does so on its own.
+ */
+class LaneCoalescer final
+{
+    DEFAULT_DESTRUCT(LaneCoalescer);
+    DELETE_CM(LaneCoalescer);
+public:
+    static inline constexpr u32 LINE_WORD_COUNT = 8;
+    // 4 lanes of up to 8 registers each touch at most 2 lines apiece.
+    static inline constexpr u32 LINE_COUNT = 8;
+    static inline constexpr u32 DISPATCH_PORT_COUNT = 2;
+    // Accesses which aren't part of a group, they never merge.
+    static inline constexpr u32 NO_GROUP = ~0u;
+
+    struct Line final
+    {
+        // The virtual address of the first word in the line.
+        u64 VirtualAddress;
+        // The physical address of the first word in the line.
+        u64 PhysicalAddress;
+        // Only loaded lines have their data.
+        u32 Data[LINE_WORD_COUNT];
+        // Whether the address translated, an untranslated load reads all ones and a store is dropped.
+        bool Translated;
+        bool Writable;
+        bool External;
+        bool Loaded;
+        bool Valid;
+    };
+public:
+    LaneCoalescer() noexcept
+        : m_Groups{}
+        , m_MergedLines(0)
+    { }
+
+    void Reset() noexcept
+    {
+        (void) ::std::memset(m_Groups, 0, sizeof(m_Groups));
+        ResetStatistics();
+    }
+
+    // Starts the group for the instruction a dispatch unit is issuing, dropping its previous one.
+    void BeginGroup(u32 dispatchPort, u32 group) noexcept;
+
+    [[nodiscard]] u32 CurrentGroup(const u32 dispatchPort) const noexcept
+    {
+        return m_Groups[dispatchPort].Active ? m_Groups[dispatchPort].Sequence : NO_GROUP;
+    }
+
+    // The line holding address if another lane of the group loaded or stored it, otherwise nullptr.
+    [[nodiscard]] const Line* Find(u32 dispatchPort, u32 group, u64 address, bool loaded) noexcept;
+    // A line for the group to record address in, nullptr if the dispatch unit has moved on or every line is taken.
+    [[nodiscard]] Line* Record(u32 dispatchPort, u32 group, u64 address) noexcept;
+
+    // The SM stored to the line holding physicalAddress, loaded copies of it are stale.
+    void InvalidatePhysical(u64 physicalAddress, bool external) noexcept;
+
+    // Lines a lane took from another lane of its instruction rather than accessing memory.
+    [[nodiscard]] u64 MergedLines() const noexcept { return m_MergedLines; }
+
+    void ResetStatistics() noexcept
+    {
+        m_MergedLines = 0;
+    }
+private:
+    struct Group final
+    {
+        Line Lines[LINE_COUNT];
+        // The Ld/St sequence of the instruction's first lane.
+        u32 Sequence;
+        bool Active;
+    };
+private:
+    Group m_Groups[DISPATCH_PORT_COUNT];
+    u64 m_MergedLines;
+};
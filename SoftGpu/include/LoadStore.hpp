@@ -10,6 +10,9 @@
 #include <NumTypes.hpp>
 #include <cstring>
 
+#include "RegisterFile.hpp"
+#include "Atomic.hpp"
+
 class StreamingMultiprocessor;
 
 // Computes the address in the form of [BaseRegister + IndexRegister * 2**IndexExponent + Offset]
@@ -19,39 +22,161 @@ struct LoadStoreInstruction final
     u32 ReadWrite : 1; // Loading = 0, Storing = 1
     u32 IndexExponent : 3; // Index multiplier can be either 1, 2, 4, 8, 16, 32, 64, or 0. 111 disables indexing, every other value is equal to 2**xxx
     u32 RegisterCount : 3; // Indicates how many registers in a sequence are being Loaded/Stored. This uses 1 based index. This is enough to store a full vec4d.
-    u32 Pad0 : 8; // Pad for x86 alignment.
+                           // Packed bfloat16 pairs move as whole registers, so a vec4 of bfloat16 only needs 2.
+    u32 Warp : 4; // The warp which issued this, loads report back to its scheduler when they complete.
+    u32 Atomic : 1; // Atomics are issued as stores, RegisterCount covers the previous value they return.
+    u32 AtomicOperation : 3; // An EAtomicOperation.
     u32 BaseRegister : 12; // The base register to address to. This points to a sequence of 2 registers.
     u32 IndexRegister : 12; // The index register to address to. This will be ignored if IndexExponent is 111
     u32 TargetRegister : 12; // The target register to Load or Store.
-    u32 Pad1 : 6; // Pad for x86 alignment.
+    u32 Wide : 1; // Atomics operate on 64 bits instead of 32.
+    u32 SignedCompare : 1; // Atomic Min and Max compare as signed integers.
+    u32 Shared : 1; // The address is a word in the SM's shared memory rather than a virtual address.
+    u32 Pad1 : 3; // Pad for x86 alignment.
     i16 Offset; // A signed offset from the base register and index.
 };
 
+/**
+ * \brief Executes loads and stores, with several loads in flight at once.
+ *
+ *   The front end steps through reading the address registers and
+ * accessing memory for one instruction at a time, one register file
+ * command per clock. A command is checked for completion on the
+ * following clock, and the unit waits in place while its port is held
+ * back by a bank conflict.
+ *
+ *   A load takes its data from memory when it's accessed and is handed
+ * to the miss status table, which holds it until its cache lines would
+ * have arrived. A load whose lines are already being fetched by an
+ * earlier entry waits for that entry rather than paying the latency
+ * again. The front end is then free for the next instruction, the unit
+ * only reports busy to the dispatch units while the table is full.
+ *
+ *   Loads whose lines have arrived are written back oldest first, so a
+ * hit issued after a miss returns before it. Registers alternate
+ * between the port halves, so the write of one register and the unlock
+ * of the one before it go out together, one register per clock. The
+ * writeback has the port ahead of the front end. Loads report back to
+ * the issuing warp's scheduler once their registers have been written,
+ * so the scheduler can tell a warp blocked on memory from one blocked on
+ * arithmetic.
+ *
+ *   Stores are read from the register file by the front end the same
+ * way, one register per clock, then handed to the SM's store buffer
+ * together, and don't wait.
+ *
+ *   Instructions are numbered as they're dispatched. A load doesn't
+ * access memory while an older store on another unit which could
+ * overlap it hasn't reached the store buffer, and a store waits the
+ * same way for older loads and stores. A thread's accesses to the same
+ * words are always seen in program order.
+ *
+ *   Atomics read their operands like a store, then apply the operation
+ * in the L0 with the line held exclusively, waiting on older accesses
+ * to the same words like a store does. The previous value goes through
+ * the miss status table and is written back like a load.
+ *
+ *   Shared memory accesses skip translation, the L0, and the store
+ * buffer. A load has its data as soon as it wins its banks, a store once
+ * its registers have been read and its banks won, and either waits a
+ * clock and tries again when it loses. They're ordered against older
+ * accesses to the same shared words like any other.
+ *
+ *   The registers of an instruction are consecutive words, so memory is
+ * accessed in one transaction per cache line they touch, with a single
+ * address translation per page, rather than a lookup per register. The
+ * lanes of a replicated instruction are merged the same way, a line one
+ * lane has already accessed costs the others nothing.
+ */
 class LoadStore final
 {
     DEFAULT_DESTRUCT(LoadStore);
     DELETE_CM(LoadStore);
 public:
+    // How many times the unit is clocked per SM cycle.
     static inline constexpr u32 MAX_EXECUTION_STAGE = 24;
+    // The cycles a load waits when one of its lines isn't in the L0.
+    static inline constexpr u32 MISS_LATENCY_CYCLES = 64;
+    // Loads which can be waiting on memory or writing back at once.
+    static inline constexpr u32 MISS_STATUS_ENTRY_COUNT = 4;
+    static inline constexpr u32 INVALID_ENTRY = MISS_STATUS_ENTRY_COUNT;
+    // A load moves at most 8 registers.
+    static inline constexpr u32 MAX_REGISTER_COUNT = 8;
+
+    enum class EStage : u8
+    {
+        Idle = 0,
+        ReadBaseRegister,
+        ReleaseBaseRegister,
+        ReadIndexRegister,
+        ReleaseIndexRegister,
+        AccessMemory,
+        StoreRegister,
+        WriteMemory,
+        ReadAtomicOperand,
+        ExecuteAtomic,
+        Complete
+    };
+
+    struct MissStatusEntry final
+    {
+        LoadStoreInstruction Instruction;
+        // The word address of the first register.
+        u64 Address;
+        // Captured when the load accessed memory, so later stores can't change what it returns.
+        u32 Data[MAX_REGISTER_COUNT];
+        // Clocks left before the lines arrive.
+        u32 WaitClocks;
+        // Issue order, lower is older.
+        u32 Sequence;
+        bool Valid;
+    };
 public:
     LoadStore(StreamingMultiprocessor* const sm, const u32 unitIndex) noexcept
         : m_SM(sm)
         , m_UnitIndex(unitIndex)
-        , m_ExecutionStage(0)
+        , m_Stage(EStage::Idle)
         , m_Instruction{}
+        , m_Sequence(0)
+        , m_LaneGroup(0)
+        , m_InstructionPointer(0)
         , m_SuccessfulHigh(false)
         , m_UnsuccessfulHigh(false)
         , m_SuccessfulLow(false)
         , m_UnsuccessfulLow(false)
         , m_Address(0)
         , m_IndexRegister(0)
+        , m_StoreData{}
         , m_CurrentRegister(0)
+        , m_Entries{}
+        , m_EntryLimit(MISS_STATUS_ENTRY_COUNT)
+        , m_IssueSequence(0)
+        , m_ReturnEntry(INVALID_ENTRY)
+        , m_ReturnRegister(0)
+        , m_BankConflictStallCycles(0)
+        , m_Loads(0)
+        , m_Stores(0)
+        , m_Atomics(0)
+        , m_AtomicMisses(0)
+        , m_SharedLoads(0)
+        , m_SharedStores(0)
+        , m_SharedBankConflictStallCycles(0)
+        , m_LoadMisses(0)
+        , m_MergedLoads(0)
+        , m_OutOfOrderReturns(0)
+        , m_MemoryTransactions(0)
+        , m_PageCrossings(0)
+        , m_OrderingStallCycles(0)
+        , m_PeakOutstandingLoads(0)
     { }
 
     void Reset()
     {
-        m_ExecutionStage = 0;
+        m_Stage = EStage::Idle;
         (void) ::std::memset(&m_Instruction, 0, sizeof(m_Instruction));
+        m_Sequence = 0;
+        m_LaneGroup = 0;
+        m_InstructionPointer = 0;
         m_SuccessfulHigh = false;
         m_UnsuccessfulHigh = false;
         m_SuccessfulLow = false;
@@ -59,186 +184,182 @@ public:
         m_Address = 0;
         m_IndexRegister = 0;
         m_CurrentRegister = 0;
+        (void) ::std::memset(m_Entries, 0, sizeof(m_Entries));
+        m_IssueSequence = 0;
+        m_ReturnEntry = INVALID_ENTRY;
+        m_ReturnRegister = 0;
+        ResetStatistics();
     }
 
     void Clock() noexcept
     {
-        switch(m_ExecutionStage)
+        // The lines keep coming in while the port is held up.
+        CountDownEntries();
+
+        if(WaitForRegisterPort())
         {
-            case 0: return;
-            case  1: Pipeline23(); break;
-            case  2: Pipeline22(); break;
-            case  3: Pipeline21(); break;
-            case  4: Pipeline20(); break;
-            case  5: Pipeline19(); break;
-            case  6: Pipeline18(); break;
-            case  7: Pipeline17(); break;
-            case  8: Pipeline16(); break;
-            case  9: Pipeline15(); break;
-            case 10: Pipeline14(); break;
-            case 11: Pipeline13(); break;
-            case 12: Pipeline12(); break;
-            case 13: Pipeline11(); break;
-            case 14: Pipeline10(); break;
-            case 15: Pipeline9();  break;
-            case 16: Pipeline8();  break;
-            case 17: Pipeline7();  break;
-            case 18: Pipeline6();  break;
-            case 19: Pipeline5();  break;
-            case 20: Pipeline4();  break;
-            // case 21: Pipeline3();  break;
-            // case 22: Pipeline2();  break;
-            case 21: PipelineReleaseReadLockBaseRegister();  break;
-            case 22: PipelineReadBaseRegister();  break;
-            default: break;
+            return;
         }
 
-        --m_ExecutionStage;
+        if(ReturnLoad() && UsesRegisterPort(m_Stage))
+        {
+            return;
+        }
+
+        switch(m_Stage)
+        {
+            case EStage::ReadBaseRegister: ReadBaseRegister(); break;
+            case EStage::ReleaseBaseRegister: ReleaseBaseRegister(); break;
+            case EStage::ReadIndexRegister: ReadIndexRegister(); break;
+            case EStage::ReleaseIndexRegister: ReleaseIndexRegister(); break;
+            case EStage::AccessMemory: AccessMemory(); break;
+            case EStage::StoreRegister: StoreRegister(); break;
+            case EStage::WriteMemory: WriteMemory(); break;
+            case EStage::ReadAtomicOperand: ReadAtomicOperand(); break;
+            case EStage::ExecuteAtomic: ExecuteAtomic(); break;
+            case EStage::Complete: Complete(); break;
+            default: break;
+        }
     }
 
-    void PrepareExecution(LoadStoreInstruction instructionInfo) noexcept
+    // The sequence orders this instruction's memory access against those on the other units, the lane group merges it with the
+    // instruction's other lanes, and the instruction pointer trains the prefetcher.
+    void PrepareExecution(LoadStoreInstruction instructionInfo, const u32 sequence, const u32 laneGroup, const u64 instructionPointer) noexcept
     {
         (void) ::std::memcpy(&m_Instruction, &instructionInfo, sizeof(instructionInfo));
-        m_ExecutionStage = MAX_EXECUTION_STAGE;
+        m_Sequence = sequence;
+        m_LaneGroup = laneGroup;
+        m_InstructionPointer = instructionPointer;
+        m_Address = 0;
+        m_CurrentRegister = 0;
+        m_Stage = EStage::ReadBaseRegister;
     }
 
-    // void Execute(LoadStoreInstruction instructionInfo) noexcept;
-private:
-    // Read high and low base register.
-    void PipelineReadBaseRegister() noexcept;
-
-    // Release the read locks on the base register.
-    void PipelineReleaseReadLockBaseRegister() noexcept;
-
-    // // Read base register low.
-    // void Pipeline0() noexcept;
-
-    // // Release read lock on base register low.
-    // void Pipeline1() noexcept;
-
-    // // Read base register high.
-    // void Pipeline2() noexcept;
-
-    // // Release read lock on base register high.
-    // void Pipeline3() noexcept;
-
-    // Read index register.
-    void Pipeline4() noexcept;
-
-    // Release read lock on index register.
-    void Pipeline5() noexcept;
-
-    // Prefetch memory.
-    void Pipeline6() noexcept;
-
-    // Handle register 0.
-    void Pipeline7() noexcept
+    // 1 makes the unit wait for each load to write back before taking the next instruction.
+    void SetOutstandingLoadLimit(const u32 limit) noexcept
     {
-        PipelineRWHandler(0);
+        m_EntryLimit = limit < 1 ? 1 : (limit > MISS_STATUS_ENTRY_COUNT ? MISS_STATUS_ENTRY_COUNT : limit);
     }
 
-    // Release lock on register 0.
-    void Pipeline8() noexcept
+    [[nodiscard]] EStage Stage() const noexcept { return m_Stage; }
+
+    // Whether this unit holds an instruction issued before sequence which hasn't accessed memory yet, and may overlap [address, address + wordCount) in the same address space.
+    [[nodiscard]] bool BlocksAccess(u32 sequence, bool storesOnly, bool shared, u64 address, u32 wordCount) const noexcept;
+    [[nodiscard]] u32 OutstandingLoads() const noexcept;
+    [[nodiscard]] const MissStatusEntry& Entry(const u32 entryIndex) const noexcept { return m_Entries[entryIndex]; }
+    // The clocks left on an entry already fetching the line address is in, 0 if there isn't one.
+    [[nodiscard]] u32 PendingLineWait(u64 address) const noexcept;
+
+    [[nodiscard]] u64 BankConflictStallCycles() const noexcept { return m_BankConflictStallCycles; }
+    [[nodiscard]] u64 Loads() const noexcept { return m_Loads; }
+    [[nodiscard]] u64 Stores() const noexcept { return m_Stores; }
+    [[nodiscard]] u64 Atomics() const noexcept { return m_Atomics; }
+    // Atomics whose line wasn't in the L0, usually because another SM took it.
+    [[nodiscard]] u64 AtomicMisses() const noexcept { return m_AtomicMisses; }
+    [[nodiscard]] u64 SharedLoads() const noexcept { return m_SharedLoads; }
+    [[nodiscard]] u64 SharedStores() const noexcept { return m_SharedStores; }
+    // Clocks spent waiting for a shared memory bank another access had.
+    [[nodiscard]] u64 SharedBankConflictStallCycles() const noexcept { return m_SharedBankConflictStallCycles; }
+    // Loads which had to wait out the miss latency.
+    [[nodiscard]] u64 LoadMisses() const noexcept { return m_LoadMisses; }
+    // Loads which waited on a line an earlier entry was already fetching.
+    [[nodiscard]] u64 MergedLoads() const noexcept { return m_MergedLoads; }
+    // Loads written back while an older load was still waiting.
+    [[nodiscard]] u64 OutOfOrderReturns() const noexcept { return m_OutOfOrderReturns; }
+    // Cache line transactions, one per line a load or store touches.
+    [[nodiscard]] u64 MemoryTransactions() const noexcept { return m_MemoryTransactions; }
+    // Loads and stores whose registers span two pages, and so needed two translations.
+    [[nodiscard]] u64 PageCrossings() const noexcept { return m_PageCrossings; }
+    // Clocks spent waiting for an older access on another unit to the same words.
+    [[nodiscard]] u64 OrderingStallCycles() const noexcept { return m_OrderingStallCycles; }
+    [[nodiscard]] u32 PeakOutstandingLoads() const noexcept { return m_PeakOutstandingLoads; }
+
+    void ResetStatistics() noexcept
     {
-        PipelineReleaseHandler(0);
-    }
-    
-    // Handle register 1.
-    void Pipeline9() noexcept
-    {
-        PipelineRWHandler(1);
+        m_BankConflictStallCycles = 0;
+        m_Loads = 0;
+        m_Stores = 0;
+        m_Atomics = 0;
+        m_AtomicMisses = 0;
+        m_SharedLoads = 0;
+        m_SharedStores = 0;
+        m_SharedBankConflictStallCycles = 0;
+        m_LoadMisses = 0;
+        m_MergedLoads = 0;
+        m_OutOfOrderReturns = 0;
+        m_MemoryTransactions = 0;
+        m_PageCrossings = 0;
+        m_OrderingStallCycles = 0;
+        m_PeakOutstandingLoads = 0;
     }
+private:
+    // Returns true if our last register command lost a bank conflict and is still held in the port.
+    [[nodiscard]] bool WaitForRegisterPort() noexcept;
 
-    // Release lock on register 1.
-    void Pipeline10() noexcept
-    {
-        PipelineReleaseHandler(1);
-    }
+    // Issues a command for a single register on whichever port half holds it.
+    void InvokeRegister(RegisterFile::ECommand command, u32 registerIndex, u32* value) noexcept;
 
-    // Handle register 2.
-    void Pipeline11() noexcept
+    [[nodiscard]] static bool UsesRegisterPort(const EStage stage) noexcept
     {
-        PipelineRWHandler(2);
+        return stage != EStage::Idle && stage != EStage::AccessMemory && stage != EStage::WriteMemory && stage != EStage::ExecuteAtomic && stage != EStage::Complete;
     }
 
-    // Release lock on register 2.
-    void Pipeline12() noexcept
-    {
-        PipelineReleaseHandler(2);
-    }
+    // Read the high and low halves of the base address.
+    void ReadBaseRegister() noexcept;
 
-    // Handle register 3.
-    void Pipeline13() noexcept
-    {
-        PipelineRWHandler(3);
-    }
+    // Release the read locks on the base registers.
+    void ReleaseBaseRegister() noexcept;
 
-    // Release lock on register 3.
-    void Pipeline14() noexcept
-    {
-        PipelineReleaseHandler(3);
-    }
+    void ReadIndexRegister() noexcept;
 
-    // Handle register 4.
-    void Pipeline15() noexcept
-    {
-        PipelineRWHandler(4);
-    }
+    // Add the index into the address, and release its read lock.
+    void ReleaseIndexRegister() noexcept;
 
-    // Release lock on register 4.
-    void Pipeline16() noexcept
-    {
-        PipelineReleaseHandler(4);
-    }
+    // Stores go on to StoreRegister, loads are captured into the miss status table.
+    void AccessMemory() noexcept;
 
-    // Handle register 5.
-    void Pipeline17() noexcept
-    {
-        PipelineRWHandler(5);
-    }
+    // Captures a load from shared memory, unless it loses a bank this clock.
+    void LoadShared(u64 address) noexcept;
 
-    // Release lock on register 5.
-    void Pipeline18() noexcept
-    {
-        PipelineReleaseHandler(5);
-    }
+    // Releases the register read last clock, while reading the next.
+    void StoreRegister() noexcept;
 
-    // Handle register 6.
-    void Pipeline19() noexcept
-    {
-        PipelineRWHandler(6);
-    }
+    // Hands the store's registers to the store buffer, once older accesses to the same words have gone.
+    void WriteMemory() noexcept;
 
-    // Release lock on register 6.
-    void Pipeline20() noexcept
-    {
-        PipelineReleaseHandler(6);
-    }
+    // Reads the operands one register per clock. The previous value replaces the first operand, so those registers stay locked for the writeback.
+    void ReadAtomicOperand() noexcept;
 
-    // Handle register 6.
-    void Pipeline21() noexcept
-    {
-        PipelineRWHandler(7);
-    }
+    // Applies the operation once older accesses to the same words have gone, and hands the previous value to the miss status table.
+    void ExecuteAtomic() noexcept;
 
-    // Release lock on register 6.
-    void Pipeline22() noexcept
-    {
-        PipelineReleaseHandler(7);
-    }
+    // Report that this unit is ready, if there is room for another load.
+    void Complete() noexcept;
+
+    void CountDownEntries() noexcept;
 
-    // Report that this unit is ready.
-    void Pipeline23() noexcept;
+    // Writes back the oldest load whose lines have arrived. Returns true if it used the register port.
+    [[nodiscard]] bool ReturnLoad() noexcept;
 
-    void PipelineRWHandler(u32 index) noexcept;
-    void PipelineReleaseHandler(u32 index) noexcept;
+    // The clocks a miss on the line holding address waits, less if a prefetch is already fetching it.
+    [[nodiscard]] u32 LineMissWait(u64 address) noexcept;
+    // Fills a free entry for the current instruction, whose data arrives in waitClocks.
+    [[nodiscard]] MissStatusEntry& IssueEntry(u32 waitClocks) noexcept;
+    [[nodiscard]] u32 FreeEntry() const noexcept;
+    // The oldest valid entry with its lines arrived and nothing left to wait for.
+    [[nodiscard]] u32 OldestReadyEntry() const noexcept;
+    [[nodiscard]] bool HasOlderEntry(u32 sequence) const noexcept;
 private:
     StreamingMultiprocessor* m_SM;
     u32 m_UnitIndex;
 
-    u32 m_ExecutionStage;
+    EStage m_Stage;
 
     LoadStoreInstruction m_Instruction;
+    u32 m_Sequence;
+    // The lane coalescing group of the instruction's dispatch unit it was issued in.
+    u32 m_LaneGroup;
+    u64 m_InstructionPointer;
 
     bool m_SuccessfulHigh;
     bool m_UnsuccessfulHigh;
@@ -255,11 +376,32 @@ private:
         u64 m_Address;
     };
 
-    union
-    {
-        u32 m_IndexRegister;
-        u32 m_TargetValue;
-    };
+    u32 m_IndexRegister;
+    // The registers of a store, written out together once they've all been read.
+    u32 m_StoreData[MAX_REGISTER_COUNT];
 
     u16 m_CurrentRegister;
+
+    MissStatusEntry m_Entries[MISS_STATUS_ENTRY_COUNT];
+    u32 m_EntryLimit;
+    u32 m_IssueSequence;
+    // The entry being written back, and how many of its registers have been written.
+    u32 m_ReturnEntry;
+    u32 m_ReturnRegister;
+
+    u64 m_BankConflictStallCycles;
+    u64 m_Loads;
+    u64 m_Stores;
+    u64 m_Atomics;
+    u64 m_AtomicMisses;
+    u64 m_SharedLoads;
+    u64 m_SharedStores;
+    u64 m_SharedBankConflictStallCycles;
+    u64 m_LoadMisses;
+    u64 m_MergedLoads;
+    u64 m_OutOfOrderReturns;
+    u64 m_MemoryTransactions;
+    u64 m_PageCrossings;
+    u64 m_OrderingStallCycles;
+    u32 m_PeakOutstandingLoads;
 };
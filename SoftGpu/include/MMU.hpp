@@ -44,6 +44,8 @@ struct PageEntry final
 static_assert(sizeof(PageEntry) == 8, "Page Entry is not 8 bytes long.");
 
 static inline constexpr u64 GpuPageSize = 65536;
+// Addresses have a 4 byte granularity.
+static inline constexpr u64 GpuPageWordCount = GpuPageSize / sizeof(u32);
 
 class Mmu final
 {
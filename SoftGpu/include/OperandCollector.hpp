@@ -0,0 +1,167 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#pragma once
+
+#include <Objects.hpp>
+#include <NumTypes.hpp>
+
+// A small fully associative cache of register values in front of a core's register file port.
+//
+// Operands that were recently read, and results the core wrote back, are kept so that the next instruction
+// reusing them doesn't need a register file read. Any write to the register file by another unit is
+// broadcast to the collector, which drops the entry if the value no longer matches. Entries are replaced
+// least recently used first, in hardware this would be a pseudo-LRU.
+class OperandCollector final
+{
+    DEFAULT_DESTRUCT(OperandCollector);
+    DELETE_CM(OperandCollector);
+public:
+    static inline constexpr u32 ENTRY_COUNT = 8;
+
+    struct Entry final
+    {
+        u32 Value;
+        u32 Register : 12;
+        u32 Valid : 1;
+        u32 Reserved : 19; // Reserved bits for alignment in x86, these can be removed in hardware.
+        u32 LastUse;
+    };
+public:
+    OperandCollector() noexcept
+        : m_Entries{ }
+        , m_UseCounter(0)
+        , m_Hits(0)
+        , m_Misses(0)
+        , m_Forwards(0)
+        , m_Invalidations(0)
+    { }
+
+    void Reset() noexcept
+    {
+        InvalidateAll();
+        m_UseCounter = 0;
+        ResetStatistics();
+    }
+
+    void ResetStatistics() noexcept
+    {
+        m_Hits = 0;
+        m_Misses = 0;
+        m_Forwards = 0;
+        m_Invalidations = 0;
+    }
+
+    // Returns true and the value if the register is held, this counts as a use of the entry.
+    [[nodiscard]] bool Lookup(const u32 registerIndex, u32* const value) noexcept
+    {
+        Entry* const entry = Find(registerIndex);
+
+        if(!entry)
+        {
+            ++m_Misses;
+            return false;
+        }
+
+        ++m_Hits;
+        entry->LastUse = ++m_UseCounter;
+        *value = entry->Value;
+        return true;
+    }
+
+    // Records a value read from the register file.
+    void Fill(const u32 registerIndex, const u32 value) noexcept
+    {
+        Insert(registerIndex, value);
+    }
+
+    // Records a result written by this core, the next instruction can use it without waiting on the register file.
+    void Forward(const u32 registerIndex, const u32 value) noexcept
+    {
+        ++m_Forwards;
+        Insert(registerIndex, value);
+    }
+
+    // Called for every register file write. Our own writes carry the value we already hold, so they are kept.
+    void ObserveWrite(const u32 registerIndex, const u32 value) noexcept
+    {
+        Entry* const entry = Find(registerIndex);
+
+        if(entry && entry->Value != value)
+        {
+            entry->Valid = false;
+            ++m_Invalidations;
+        }
+    }
+
+    void InvalidateAll() noexcept
+    {
+        for(Entry& entry : m_Entries)
+        {
+            if(entry.Valid)
+            {
+                entry.Valid = false;
+                ++m_Invalidations;
+            }
+        }
+    }
+
+    [[nodiscard]] u64 Hits() const noexcept { return m_Hits; }
+    [[nodiscard]] u64 Misses() const noexcept { return m_Misses; }
+    [[nodiscard]] u64 Forwards() const noexcept { return m_Forwards; }
+    [[nodiscard]] u64 Invalidations() const noexcept { return m_Invalidations; }
+private:
+    [[nodiscard]] Entry* Find(const u32 registerIndex) noexcept
+    {
+        for(Entry& entry : m_Entries)
+        {
+            if(entry.Valid && entry.Register == registerIndex)
+            {
+                return &entry;
+            }
+        }
+
+        return nullptr;
+    }
+
+    void Insert(const u32 registerIndex, const u32 value) noexcept
+    {
+        Entry* target = Find(registerIndex);
+
+        if(!target)
+        {
+            target = &m_Entries[0];
+
+            for(Entry& entry : m_Entries)
+            {
+                if(!entry.Valid)
+                {
+                    target = &entry;
+                    break;
+                }
+
+                if(entry.LastUse < target->LastUse)
+                {
+                    target = &entry;
+                }
+            }
+        }
+
+        target->Value = value;
+        target->Register = registerIndex;
+        target->Valid = true;
+        target->Reserved = 0;
+        target->LastUse = ++m_UseCounter;
+    }
+private:
+    Entry m_Entries[ENTRY_COUNT];
+    u32 m_UseCounter;
+
+    u64 m_Hits;
+    u64 m_Misses;
+    u64 m_Forwards;
+    u64 m_Invalidations;
+};
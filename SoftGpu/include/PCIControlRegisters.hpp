@@ -94,6 +94,18 @@ public:
     static inline constexpr u16 REGISTER_VRAM_SIZE_HIGH         = 0x0018;
     static inline constexpr u16 REGISTER_INTERRUPT_TYPE         = 0x001C;
     static inline constexpr u16 REGISTER_DMA_CHANNEL_COUNT      = 0x0020;
+    // Bits 0-7 select the EOccupancyStatistic, bits 8-15 the SM.
+    static inline constexpr u16 REGISTER_SM_STATISTIC_SELECT    = 0x0024;
+    // Reading the low word latches the high word, so a 64 bit counter is read consistently.
+    static inline constexpr u16 REGISTER_SM_STATISTIC_LOW       = 0x0028;
+    static inline constexpr u16 REGISTER_SM_STATISTIC_HIGH      = 0x002C;
+    // Bits 0-7 select the ECacheStatistic, bits 8-15 the L0 by its SM or 4 for the L1.
+    // Selecting cache 0xFF reads the controller's own ECacheControllerStatistic counters instead.
+    static inline constexpr u16 REGISTER_CACHE_STATISTIC_SELECT = 0x0030;
+    // Latched just like the SM statistic.
+    static inline constexpr u16 REGISTER_CACHE_STATISTIC_LOW    = 0x0034;
+    static inline constexpr u16 REGISTER_CACHE_STATISTIC_HIGH   = 0x0038;
+    static inline constexpr u32 VALUE_CACHE_STATISTIC_CONTROLLER = 0xFF;
 
     static inline constexpr u32 MSG_INTERRUPT_NONE              = 0x00000000;
     static inline constexpr u32 MSG_INTERRUPT_VSYNC_DISPLAY_0   = 0x00000010; // 0x10 - 0x17
@@ -168,6 +180,12 @@ public:
         , m_DmaLock { VALUE_DMA_LOCK_UNLOCKED, VALUE_DMA_LOCK_UNLOCKED, VALUE_DMA_LOCK_UNLOCKED, VALUE_DMA_LOCK_UNLOCKED }
         , m_DmaBuses {  }
         , m_DmaRequestNumbers { }
+        , m_SmStatisticSelect(0)
+        , m_SmStatisticHigh(0)
+        , m_SmStatistic(0)
+        , m_CacheStatisticSelect(0)
+        , m_CacheStatisticHigh(0)
+        , m_CacheStatistic(0)
         , m_DebugReadCallback(nullptr)
         , m_DebugWriteCallback(nullptr)
     {
@@ -201,6 +219,22 @@ public:
         m_CurrentInterruptMessage = messageType;
     }
 
+    [[nodiscard]] u32 SmStatisticSelect() const noexcept { return m_SmStatisticSelect; }
+
+    // The processor drives the selected SM statistic every clock.
+    void SetSmStatistic(const u64 statistic) noexcept
+    {
+        m_SmStatistic = statistic;
+    }
+
+    [[nodiscard]] u32 CacheStatisticSelect() const noexcept { return m_CacheStatisticSelect; }
+
+    // The processor drives the selected cache statistic every clock.
+    void SetCacheStatistic(const u64 statistic) noexcept
+    {
+        m_CacheStatistic = statistic;
+    }
+
     void RegisterDebugCallbacks(const PciControlDebugReadCallback_f debugReadCallback, const PciControlDebugWriteCallback_f debugWriteCallback) noexcept
     {
         m_DebugReadCallback = debugReadCallback;
@@ -229,6 +263,11 @@ private:
 
             m_DebugLogLock = 0;
 
+            m_SmStatisticSelect = 0;
+            m_SmStatisticHigh = 0;
+            m_CacheStatisticSelect = 0;
+            m_CacheStatisticHigh = 0;
+
             m_ReadState = 0;
 
             for(u32 i = 0; i < DMA_CHANNEL_COUNT; ++i)
@@ -299,6 +338,18 @@ private:
             case REGISTER_VGA_HEIGHT: m_Bus.ReadResponse = m_VgaHeight; break;
             case REGISTER_INTERRUPT_TYPE: m_Bus.ReadResponse = m_CurrentInterruptMessage; break;
             case REGISTER_DMA_CHANNEL_COUNT: m_Bus.ReadResponse = DMA_CHANNEL_COUNT; break;
+            case REGISTER_SM_STATISTIC_SELECT: m_Bus.ReadResponse = m_SmStatisticSelect; break;
+            case REGISTER_SM_STATISTIC_LOW:
+                m_Bus.ReadResponse = static_cast<u32>(m_SmStatistic);
+                m_SmStatisticHigh = static_cast<u32>(m_SmStatistic >> 32);
+                break;
+            case REGISTER_SM_STATISTIC_HIGH: m_Bus.ReadResponse = m_SmStatisticHigh; break;
+            case REGISTER_CACHE_STATISTIC_SELECT: m_Bus.ReadResponse = m_CacheStatisticSelect; break;
+            case REGISTER_CACHE_STATISTIC_LOW:
+                m_Bus.ReadResponse = static_cast<u32>(m_CacheStatistic);
+                m_CacheStatisticHigh = static_cast<u32>(m_CacheStatistic >> 32);
+                break;
+            case REGISTER_CACHE_STATISTIC_HIGH: m_Bus.ReadResponse = m_CacheStatisticHigh; break;
             case REGISTER_DEBUG_PRINT: m_Bus.ReadResponse = 0; break;
             case REGISTER_DEBUG_LOG_LOCK: m_Bus.ReadResponse = m_DebugLogLock; break;
             case REGISTER_DEBUG_LOG_MULTI: m_Bus.ReadResponse = 0; break;
@@ -442,6 +493,8 @@ private:
             case REGISTER_VGA_WIDTH: m_VgaWidth = static_cast<u16>(m_Bus.WriteValue); break;
             case REGISTER_VGA_HEIGHT: m_VgaHeight = static_cast<u16>(m_Bus.WriteValue); break;
             case REGISTER_INTERRUPT_TYPE: m_CurrentInterruptMessage = 0; break; // The CPU can only clear the interrupt.
+            case REGISTER_SM_STATISTIC_SELECT: m_SmStatisticSelect = m_Bus.WriteValue & 0xFFFF; break;
+            case REGISTER_CACHE_STATISTIC_SELECT: m_CacheStatisticSelect = m_Bus.WriteValue & 0xFFFF; break;
             case REGISTER_DEBUG_LOG_LOCK:
                 if(m_DebugLogLock == VALUE_DEBUG_LOG_LOCK_UNLOCKED)
                 {
@@ -519,6 +572,14 @@ private:
     DMAChannelBus m_DmaBuses[DMA_CHANNEL_COUNT];
     u32 m_DmaRequestNumbers[DMA_CHANNEL_COUNT];
 
+    u32 m_SmStatisticSelect;
+    u32 m_SmStatisticHigh;
+    u64 m_SmStatistic;
+
+    u32 m_CacheStatisticSelect;
+    u32 m_CacheStatisticHigh;
+    u64 m_CacheStatistic;
+
     PciControlDebugReadCallback_f m_DebugReadCallback;
     PciControlDebugWriteCallback_f m_DebugWriteCallback;
 };
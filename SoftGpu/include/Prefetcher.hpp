@@ -0,0 +1,149 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#pragma once
+
+#include <Objects.hpp>
+#include <NumTypes.hpp>
+
+#include <cstring>
+
+class StreamingMultiprocessor;
+
+// Whether the SM trains a stride prefetcher on its loads, it can still be switched off per SM.
+#ifndef SOFT_GPU_STRIDE_PREFETCH
+    #define SOFT_GPU_STRIDE_PREFETCH 1
+#endif
+
+/**
+ * \brief Fetches lines into an SM's L0 in the background.
+ *
+ *   A prefetch takes one of a small table of miss status holding
+ * registers and counts down the miss latency, only filling the L0 when
+ * it runs out, so nothing waits on it. A request for a line which is
+ * already cached or already being fetched is redundant, and one which
+ * finds every register busy is dropped rather than waited for.
+ *
+ *   A load which misses on a line a prefetch is fetching merges into it,
+ * and only waits out what's left of its latency. The load has its data
+ * immediately, so the fill is skipped when the register retires. Such a
+ * prefetch was late, one whose line is hit in the L0 before it's evicted
+ * was useful, and the L0 counts that, along with those evicted unused.
+ *
+ *   The stride prefetcher watches the loads of each Ld/St unit by the
+ * instruction pointer that issued them. With no branches the same
+ * instruction repeats across threads and warps, each with its own base,
+ * and once an instruction has moved by the same stride a few times in a
+ * row, each of its loads prefetches the line a few strides ahead.
+ */
+class Prefetcher final
+{
+    DEFAULT_DESTRUCT(Prefetcher);
+    DELETE_CM(Prefetcher);
+public:
+    static inline constexpr u32 MISS_STATUS_ENTRY_COUNT = 8;
+    static inline constexpr u32 STRIDE_ENTRY_COUNT = 16;
+    // Repeats of the same stride before an instruction prefetches.
+    static inline constexpr u32 STRIDE_CONFIDENCE_THRESHOLD = 2;
+    static inline constexpr u32 MAX_STRIDE_CONFIDENCE = 3;
+    // How many strides ahead of the load to prefetch, far enough to cover most of the miss latency.
+    static inline constexpr u32 PREFETCH_DISTANCE = 4;
+
+    struct MissStatusEntry final
+    {
+        // The physical address of the first word in the line.
+        u64 LineAddress;
+        // Clocks left before the line arrives.
+        u32 WaitClocks;
+        bool External;
+        // A load merged into this fill and already has the line.
+        bool Demanded;
+        bool Valid;
+    };
+
+    struct StrideEntry final
+    {
+        u64 InstructionPointer;
+        u64 LastAddress;
+        i64 Stride;
+        u8 UnitIndex;
+        u8 Confidence;
+        bool Valid;
+    };
+public:
+    Prefetcher(StreamingMultiprocessor* const sm, const u32 fillClocks) noexcept
+        : m_SM(sm)
+        , m_FillClocks(fillClocks)
+        , m_Entries{}
+        , m_StrideEntries{}
+        , m_StrideEnabled(SOFT_GPU_STRIDE_PREFETCH)
+        , m_Issued(0)
+        , m_Redundant(0)
+        , m_Dropped(0)
+        , m_Late(0)
+        , m_StridePrefetches(0)
+    { }
+
+    void Reset() noexcept
+    {
+        (void) ::std::memset(m_Entries, 0, sizeof(m_Entries));
+        (void) ::std::memset(m_StrideEntries, 0, sizeof(m_StrideEntries));
+        ResetStatistics();
+    }
+
+    // Counts down the fills, once per Ld/St clock, filling the L0 as they arrive.
+    void Clock() noexcept;
+
+    // Starts fetching the line holding physicalAddress, unless it's already here or coming, or there's no register free.
+    void Request(u64 physicalAddress, bool external) noexcept;
+
+    // A load missed on the line holding physicalAddress. Returns the clocks left on a prefetch of it, or 0 if there isn't one.
+    [[nodiscard]] u32 MergeDemand(u64 physicalAddress, bool external) noexcept;
+
+    // Trains the stride prefetcher on a load, which may then prefetch ahead of it.
+    void Train(u32 unitIndex, u64 instructionPointer, u64 address) noexcept;
+
+    void SetStrideEnabled(const bool enabled) noexcept
+    {
+        m_StrideEnabled = enabled;
+    }
+
+    [[nodiscard]] u32 InFlight() const noexcept;
+
+    // Prefetches which took a register.
+    [[nodiscard]] u64 Issued() const noexcept { return m_Issued; }
+    // Requests for lines already cached or being fetched.
+    [[nodiscard]] u64 Redundant() const noexcept { return m_Redundant; }
+    // Requests which found every register busy.
+    [[nodiscard]] u64 Dropped() const noexcept { return m_Dropped; }
+    // Prefetches a load missed on before they arrived.
+    [[nodiscard]] u64 Late() const noexcept { return m_Late; }
+    // Requests made by the stride prefetcher, whatever became of them.
+    [[nodiscard]] u64 StridePrefetches() const noexcept { return m_StridePrefetches; }
+
+    void ResetStatistics() noexcept
+    {
+        m_Issued = 0;
+        m_Redundant = 0;
+        m_Dropped = 0;
+        m_Late = 0;
+        m_StridePrefetches = 0;
+    }
+private:
+    [[nodiscard]] MissStatusEntry* FindEntry(u64 lineAddress, bool external) noexcept;
+private:
+    StreamingMultiprocessor* m_SM;
+    u32 m_FillClocks;
+    MissStatusEntry m_Entries[MISS_STATUS_ENTRY_COUNT];
+    StrideEntry m_StrideEntries[STRIDE_ENTRY_COUNT];
+    bool m_StrideEnabled;
+
+    u64 m_Issued;
+    u64 m_Redundant;
+    u64 m_Dropped;
+    u64 m_Late;
+    u64 m_StridePrefetches;
+};
@@ -135,6 +135,10 @@ public:
             }
         }
 
+        // Driven ahead of the rising edge so a read sees the selection written on the previous clock.
+        m_PciRegisters.SetSmStatistic(SelectedSmStatistic());
+        m_PciRegisters.SetCacheStatistic(SelectedCacheStatistic());
+
         m_PciController.Clock(true);
         m_PciRegisters.SetClock(true);
         // m_DmaController.SetClock(true);
@@ -166,6 +170,50 @@ public:
         m_SMs[sm].TestLoadRegister(dispatchPort, replicationIndex, registerIndex, registerValue);
     }
 
+    [[nodiscard]] bool TestLaunchWarp(const u32 sm, const u32 dispatchPort, const u64 instructionPointer, const u8 threadEnabledMask, const u8 requiredRegisterCount, const u64 registerFilePointer, const FpMode fpMode) noexcept
+    {
+        return m_SMs[sm].LaunchWarp(dispatchPort, instructionPointer, threadEnabledMask, requiredRegisterCount, registerFilePointer, fpMode);
+    }
+
+    [[nodiscard]] u64 OccupancyStatistic(const u32 sm, const EOccupancyStatistic statistic) const noexcept
+    {
+        return m_SMs[sm].OccupancyStatistic(statistic);
+    }
+
+    void ResetOccupancyStatistics(const u32 sm) noexcept
+    {
+        m_SMs[sm].ResetOccupancyStatistics();
+    }
+
+    // The counters of an L0 by its core index, or of the L1 by CacheController::L1_LINE_INDEX.
+    [[nodiscard]] u64 CacheStatistic(const u32 cacheIndex, const ECacheStatistic statistic) const noexcept
+    {
+        return m_CacheController.CacheStatistic(cacheIndex, statistic);
+    }
+
+    void ResetCacheStatistics(const u32 coreIndex) noexcept
+    {
+        m_CacheController.ResetL0Statistics(coreIndex);
+    }
+
+    [[nodiscard]] StreamingMultiprocessor& TestStreamingMultiprocessor(const u32 sm) noexcept
+    {
+        return m_SMs[sm];
+    }
+
+    [[nodiscard]] CacheController& TestCacheController() noexcept
+    {
+        return m_CacheController;
+    }
+
+    void SetFpuTimingTable(const FpuTimingTable& timingTable) noexcept
+    {
+        m_SMs[0].SetFpuTimingTable(timingTable);
+        m_SMs[1].SetFpuTimingTable(timingTable);
+        m_SMs[2].SetFpuTimingTable(timingTable);
+        m_SMs[3].SetFpuTimingTable(timingTable);
+    }
+
     void TestSetRamBaseAddress(const u64 ramBaseAddress, const u64 size) noexcept
     {
         m_RamBaseAddress = ramBaseAddress;
@@ -192,6 +240,24 @@ public:
         (void) ::std::memcpy(reinterpret_cast<void*>(addressX86), &value, sizeof(u32));
     }
 
+    // Reads wordCount consecutive words in a single transfer, a cache line fill moves all 8 at once.
+    void MemReadPhyBurst(const u64 address, const u32 wordCount, u32* const values, const bool external = false) noexcept
+    {
+        (void) external;
+
+        const uintptr_t addressX86 = address << 2;
+        (void) ::std::memcpy(values, reinterpret_cast<const void*>(addressX86), wordCount * sizeof(u32));
+    }
+
+    // Writes wordCount consecutive words in a single transfer.
+    void MemWritePhyBurst(const u64 address, const u32 wordCount, const u32* const values, const bool external = false) noexcept
+    {
+        (void) external;
+
+        const uintptr_t addressX86 = address << 2;
+        (void) ::std::memcpy(reinterpret_cast<void*>(addressX86), values, wordCount * sizeof(u32));
+    }
+
     void PciBusRead(const u64 cpuPhysicalAddress, const u16 size, u32 transferBlock[1024]) noexcept
     {
         m_PciController.PciBusMasterRead(cpuPhysicalAddress, size, transferBlock);
@@ -354,13 +420,68 @@ public:
         m_CacheController.Write(coreIndex, address, value, external, writeThrough);
     }
 
+    // Reads wordCount words from a single cache line.
+    void ReadLine(const u32 coreIndex, const u64 address, const u32 wordCount, u32* const values, const bool cacheDisable = false, const bool external = false) noexcept
+    {
+        if(cacheDisable)
+        {
+            MemReadPhyBurst(address, wordCount, values, external);
+            return;
+        }
+
+        m_CacheController.ReadLine(coreIndex, address, wordCount, external, values);
+    }
+
+    // Writes wordCount words to a single cache line.
+    void WriteLine(const u32 coreIndex, const u64 address, const u32 wordCount, const u32* const values, const bool writeThrough = false, const bool cacheDisable = false, const bool external = false) noexcept
+    {
+        if(cacheDisable)
+        {
+            MemWritePhyBurst(address, wordCount, values, external);
+            return;
+        }
+
+        m_CacheController.WriteLine(coreIndex, address, wordCount, values, external, writeThrough);
+    }
+
+    // Applies an atomic operation to the 1 or 2 words at address, returning what they held in previous.
+    void Atomic(const u32 coreIndex, const u64 address, const EAtomicOperation operation, const bool wide, const bool signedCompare, const u32* const operands, u32* const previous, const bool writeThrough = false, const bool cacheDisable = false, const bool external = false) noexcept
+    {
+        // Nothing else can touch memory between the read and the write.
+        if(cacheDisable)
+        {
+            const u32 wordCount = wide ? 2 : 1;
+            u32 words[2];
+
+            MemReadPhyBurst(address, wordCount, words, external);
+            ApplyAtomicOperation(operation, wide, signedCompare, words, operands, previous);
+            MemWritePhyBurst(address, wordCount, words, external);
+            return;
+        }
+
+        m_CacheController.Atomic(coreIndex, address, operation, wide, signedCompare, operands, previous, external, writeThrough);
+    }
+
     void Prefetch(const u32 coreIndex, const u64 address, const bool external = false) noexcept
     {
         m_CacheController.Prefetch(coreIndex, address, external);
     }
 
+    // Uncached accesses always go to memory, so they always miss.
+    [[nodiscard]] bool IsCached(const u32 coreIndex, const u64 address, const bool cacheDisable = false, const bool external = false) noexcept
+    {
+        if(cacheDisable)
+        {
+            return false;
+        }
+
+        return m_CacheController.IsCached(coreIndex, address, external);
+    }
+
+    // Flushing is also a fence, the SM's buffered stores go out first.
     void FlushCache(const u32 coreIndex) noexcept
     {
+        m_SMs[coreIndex].DrainStoreBuffer();
         m_CacheController.Flush(coreIndex);
     }
 
@@ -467,6 +588,41 @@ private:
     {
         return BIT_TO_BOOL(p_Reset_n) && LOGIC_TO_BOOL(m_TriggerReset_n);
     }
+
+    // The SM statistic the PCI registers have selected, out of range selections read as 0.
+    [[nodiscard]] u64 SelectedSmStatistic() const noexcept
+    {
+        const u32 select = m_PciRegisters.SmStatisticSelect();
+        const u32 statistic = select & 0xFF;
+        const u32 sm = (select >> 8) & 0xFF;
+
+        if(sm >= ::std::size(m_SMs) || statistic >= WarpScheduler::OCCUPANCY_STATISTIC_COUNT)
+        {
+            return 0;
+        }
+
+        return m_SMs[sm].OccupancyStatistic(static_cast<EOccupancyStatistic>(statistic));
+    }
+
+    // The cache statistic the PCI registers have selected, out of range selections read as 0.
+    [[nodiscard]] u64 SelectedCacheStatistic() const noexcept
+    {
+        const u32 select = m_PciRegisters.CacheStatisticSelect();
+        const u32 statistic = select & 0xFF;
+        const u32 cache = (select >> 8) & 0xFF;
+
+        if(cache == PciControlRegisters::VALUE_CACHE_STATISTIC_CONTROLLER)
+        {
+            return statistic < CacheController::CONTROLLER_STATISTIC_COUNT ? m_CacheController.Statistic(static_cast<ECacheControllerStatistic>(statistic)) : 0;
+        }
+
+        if(cache > CacheController::L1_LINE_INDEX || statistic >= CacheController::CACHE_STATISTIC_COUNT)
+        {
+            return 0;
+        }
+
+        return m_CacheController.CacheStatistic(cache, static_cast<ECacheStatistic>(statistic));
+    }
 private:
     PROCESSES_DECL()
     {
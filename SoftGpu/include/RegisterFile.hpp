@@ -7,10 +7,12 @@
 #pragma once
 
 #include <cassert>
+#include <cstring>
 #include <Objects.hpp>
 #include <NumTypes.hpp>
 #include <ConPrinter.hpp>
 #include "DebugManager.hpp"
+#include "RegisterFileSnapshot.hpp"
 
 /**
  * \brief Manages the set of register for a given SM.s
@@ -28,6 +30,16 @@
  * up to 16 simultaneous operations, to simplify things there are only
  * 2 effective ports in use at once, each only able to access half of
  * the banks.
+ *
+ *   Each of the 16 cores has a port of its own after the Ld/St ports,
+ * which its register manager reads operands and writes results through.
+ *
+ *   When bank conflict modelling is enabled, each bank grants a single
+ * access per SM cycle, however many times the register file is clocked
+ * within it. A command targeting a bank which has already been granted
+ * this cycle is held in its port and retried when the cycle ends,
+ * IsPortStalled lets the owner of the port wait for it rather than
+ * issuing a new command.
  */
 class RegisterFile final
 {
@@ -61,705 +73,478 @@ public:
     static inline constexpr uSys REGISTER_FILE_BANK_COUNT = 16;
     static inline constexpr uSys REGISTER_FILE_BANK_REGISTER_COUNT = 256;
     static inline constexpr uSys REGISTER_FILE_REGISTER_COUNT = REGISTER_FILE_BANK_COUNT * REGISTER_FILE_BANK_REGISTER_COUNT;
+    static inline constexpr u32 LD_ST_PORT_COUNT = 4;
+    static inline constexpr u32 CORE_PORT_COUNT = 16;
+    static inline constexpr u32 PORT_COUNT = LD_ST_PORT_COUNT + CORE_PORT_COUNT;
+    static inline constexpr u32 PORT_HALF_COUNT = PORT_COUNT * 2;
+    static inline constexpr u32 WRITE_LOG_SIZE = PORT_HALF_COUNT;
+
+    // Registers are interleaved across the banks, the low 4 bits of a register index select the bank. This places
+    // the odd registers in the high banks and the even registers in the low banks, matching the port halves.
+    [[nodiscard]] static constexpr u32 BankOfRegister(const u32 registerIndex) noexcept { return registerIndex & (REGISTER_FILE_BANK_COUNT - 1); }
+    [[nodiscard]] static constexpr u32 RowOfRegister(const u32 registerIndex) noexcept { return registerIndex >> 4; }
 public:
     void Reset() noexcept
     {
-        (void) ::std::memset(m_RegisterBank0, 0, sizeof(m_RegisterBank0));
-        (void) ::std::memset(m_RegisterBank1, 0, sizeof(m_RegisterBank0));
-        (void) ::std::memset(m_RegisterBank2, 0, sizeof(m_RegisterBank0));
-        (void) ::std::memset(m_RegisterBank3, 0, sizeof(m_RegisterBank0));
-        (void) ::std::memset(m_RegisterBank4, 0, sizeof(m_RegisterBank0));
-        (void) ::std::memset(m_RegisterBank5, 0, sizeof(m_RegisterBank0));
-        (void) ::std::memset(m_RegisterBank6, 0, sizeof(m_RegisterBank0));
-        (void) ::std::memset(m_RegisterBank7, 0, sizeof(m_RegisterBank0));
-        (void) ::std::memset(m_RegisterBank8, 0, sizeof(m_RegisterBank0));
-        (void) ::std::memset(m_RegisterBank9, 0, sizeof(m_RegisterBank0));
-        (void) ::std::memset(m_RegisterBankA, 0, sizeof(m_RegisterBank0));
-        (void) ::std::memset(m_RegisterBankB, 0, sizeof(m_RegisterBank0));
-        (void) ::std::memset(m_RegisterBankC, 0, sizeof(m_RegisterBank0));
-        (void) ::std::memset(m_RegisterBankD, 0, sizeof(m_RegisterBank0));
-        (void) ::std::memset(m_RegisterBankE, 0, sizeof(m_RegisterBank0));
-        (void) ::std::memset(m_RegisterBankF, 0, sizeof(m_RegisterBank0));
-
-        (void) ::std::memset(m_RegisterContestationMapBank0, 0, sizeof(m_RegisterContestationMapBank0));
-        (void) ::std::memset(m_RegisterContestationMapBank1, 0, sizeof(m_RegisterContestationMapBank0));
-        (void) ::std::memset(m_RegisterContestationMapBank2, 0, sizeof(m_RegisterContestationMapBank0));
-        (void) ::std::memset(m_RegisterContestationMapBank3, 0, sizeof(m_RegisterContestationMapBank0));
-        (void) ::std::memset(m_RegisterContestationMapBank4, 0, sizeof(m_RegisterContestationMapBank0));
-        (void) ::std::memset(m_RegisterContestationMapBank5, 0, sizeof(m_RegisterContestationMapBank0));
-        (void) ::std::memset(m_RegisterContestationMapBank6, 0, sizeof(m_RegisterContestationMapBank0));
-        (void) ::std::memset(m_RegisterContestationMapBank7, 0, sizeof(m_RegisterContestationMapBank0));
-        (void) ::std::memset(m_RegisterContestationMapBank8, 0, sizeof(m_RegisterContestationMapBank0));
-        (void) ::std::memset(m_RegisterContestationMapBank9, 0, sizeof(m_RegisterContestationMapBank0));
-        (void) ::std::memset(m_RegisterContestationMapBankA, 0, sizeof(m_RegisterContestationMapBank0));
-        (void) ::std::memset(m_RegisterContestationMapBankB, 0, sizeof(m_RegisterContestationMapBank0));
-        (void) ::std::memset(m_RegisterContestationMapBankC, 0, sizeof(m_RegisterContestationMapBank0));
-        (void) ::std::memset(m_RegisterContestationMapBankD, 0, sizeof(m_RegisterContestationMapBank0));
-        (void) ::std::memset(m_RegisterContestationMapBankE, 0, sizeof(m_RegisterContestationMapBank0));
-        (void) ::std::memset(m_RegisterContestationMapBankF, 0, sizeof(m_RegisterContestationMapBank0));
-    }
-
-    // We'll use a pulsed model for handling multiple ports.
+        (void) ::std::memset(m_Registers, 0, sizeof(m_Registers));
+        (void) ::std::memset(m_RegisterContestationMap, 0, sizeof(m_RegisterContestationMap));
+        (void) ::std::memset(m_Ports, 0, sizeof(m_Ports));
+        (void) ::std::memset(m_BankConflicts, 0, sizeof(m_BankConflicts));
+        m_StalledPortMask = 0;
+        m_GrantedBanks = 0;
+        // Every register changed, the consumer has to drop everything it holds.
+        m_WriteLogCount = 0;
+        m_WriteLogOverflowed = true;
+        m_Snapshot.Invalidate();
+    }
+
+    // We'll use a pulsed model for handling multiple ports. A command is consumed when it executes, it only stays in
+    // its port while it's held back by a bank conflict.
     void Clock() noexcept
     {
-        ExecutePacket(m_Port0High, m_Port0Low);
-        ExecutePacket(m_Port1High, m_Port1Low);
-        ExecutePacket(m_Port2High, m_Port2Low);
-        ExecutePacket(m_Port3High, m_Port3Low);
+        if(!m_ModelBankConflicts)
+        {
+            for(u32 i = 0; i < PORT_HALF_COUNT; i += 2)
+            {
+                ConsumeCommand(i + 1);
+                ConsumeCommand(i);
+            }
+            return;
+        }
+
+        // The banks granted earlier in the cycle stay taken, so a held command can't go until the cycle ends.
+        for(u32 i = 0; i < PORT_HALF_COUNT; i += 2)
+        {
+            if(!(m_StalledPortMask & (1ull << (i + 1))))
+            {
+                ArbitrateCommand(i + 1);
+            }
+
+            if(!(m_StalledPortMask & (1ull << i)))
+            {
+                ArbitrateCommand(i);
+            }
+        }
+    }
+
+    // Frees every bank for the next SM cycle. The commands held back by a conflict get the first grants, so a port
+    // can't be starved.
+    void EndCycle() noexcept
+    {
+        m_GrantedBanks = 0;
+
+        if(!m_ModelBankConflicts)
+        {
+            return;
+        }
+
+        const u64 retryMask = m_StalledPortMask;
+        m_StalledPortMask = 0;
+
+        for(u32 i = 0; i < PORT_HALF_COUNT; i += 2)
+        {
+            if(retryMask & (1ull << (i + 1)))
+            {
+                ArbitrateCommand(i + 1);
+            }
+
+            if(retryMask & (1ull << i))
+            {
+                ArbitrateCommand(i);
+            }
+        }
     }
 
     void InvokePort0High(const CommandPacket packet) noexcept
     {
-        (void) ::std::memcpy(&m_Port0High, &packet, sizeof(packet));
+        (void) ::std::memcpy(&m_Ports[PortHalfIndex(0, 1)], &packet, sizeof(packet));
     }
 
     void InvokePort1High(const CommandPacket packet) noexcept
     {
-        (void) ::std::memcpy(&m_Port1High, &packet, sizeof(packet));
+        (void) ::std::memcpy(&m_Ports[PortHalfIndex(1, 1)], &packet, sizeof(packet));
     }
 
     void InvokePort2High(const CommandPacket packet) noexcept
     {
-        (void) ::std::memcpy(&m_Port2High, &packet, sizeof(packet));
+        (void) ::std::memcpy(&m_Ports[PortHalfIndex(2, 1)], &packet, sizeof(packet));
     }
 
     void InvokePort3High(const CommandPacket packet) noexcept
     {
-        (void) ::std::memcpy(&m_Port3High, &packet, sizeof(packet));
+        (void) ::std::memcpy(&m_Ports[PortHalfIndex(3, 1)], &packet, sizeof(packet));
     }
 
     void InvokePort0Low(const CommandPacket packet) noexcept
     {
-        (void) ::std::memcpy(&m_Port0Low, &packet, sizeof(packet));
+        (void) ::std::memcpy(&m_Ports[PortHalfIndex(0, 0)], &packet, sizeof(packet));
     }
 
     void InvokePort1Low(const CommandPacket packet) noexcept
     {
-        (void) ::std::memcpy(&m_Port1Low, &packet, sizeof(packet));
+        (void) ::std::memcpy(&m_Ports[PortHalfIndex(1, 0)], &packet, sizeof(packet));
     }
 
     void InvokePort2Low(const CommandPacket packet) noexcept
     {
-        (void) ::std::memcpy(&m_Port2Low, &packet, sizeof(packet));
+        (void) ::std::memcpy(&m_Ports[PortHalfIndex(2, 0)], &packet, sizeof(packet));
     }
 
     void InvokePort3Low(const CommandPacket packet) noexcept
     {
-        (void) ::std::memcpy(&m_Port3Low, &packet, sizeof(packet));
+        (void) ::std::memcpy(&m_Ports[PortHalfIndex(3, 0)], &packet, sizeof(packet));
     }
 
-    void ReportRegisters(const u32 smIndex) const noexcept
+    // The FP cores are cores 0 - 7 and the Int/FP cores are 8 - 15.
+    void InvokeCorePortHigh(const u32 core, const CommandPacket packet) noexcept
     {
-        if(GlobalDebug.IsAttached())
-        {
-            {
-                GlobalDebug.WriteRawInfo(&DebugCodeReportRegisterFile, sizeof(DebugCodeReportRegisterFile));
-                constexpr u32 length = sizeof(smIndex) + sizeof(u32) * REGISTER_FILE_REGISTER_COUNT;
-                GlobalDebug.WriteRawInfo(&length, sizeof(length));
-                GlobalDebug.WriteRawInfo(&smIndex, sizeof(smIndex));
-                for(u32 i = 0; i < REGISTER_FILE_REGISTER_COUNT; ++i)
-                {
-                    GlobalDebug.WriteRawInfo(&m_RegisterBank0[i], sizeof(u32));
-                    GlobalDebug.WriteRawInfo(&m_RegisterBank1[i], sizeof(u32));
-                    GlobalDebug.WriteRawInfo(&m_RegisterBank2[i], sizeof(u32));
-                    GlobalDebug.WriteRawInfo(&m_RegisterBank3[i], sizeof(u32));
-                    GlobalDebug.WriteRawInfo(&m_RegisterBank4[i], sizeof(u32));
-                    GlobalDebug.WriteRawInfo(&m_RegisterBank5[i], sizeof(u32));
-                    GlobalDebug.WriteRawInfo(&m_RegisterBank6[i], sizeof(u32));
-                    GlobalDebug.WriteRawInfo(&m_RegisterBank7[i], sizeof(u32));
-                    GlobalDebug.WriteRawInfo(&m_RegisterBank8[i], sizeof(u32));
-                    GlobalDebug.WriteRawInfo(&m_RegisterBank9[i], sizeof(u32));
-                    GlobalDebug.WriteRawInfo(&m_RegisterBankA[i], sizeof(u32));
-                    GlobalDebug.WriteRawInfo(&m_RegisterBankB[i], sizeof(u32));
-                    GlobalDebug.WriteRawInfo(&m_RegisterBankC[i], sizeof(u32));
-                    GlobalDebug.WriteRawInfo(&m_RegisterBankD[i], sizeof(u32));
-                    GlobalDebug.WriteRawInfo(&m_RegisterBankE[i], sizeof(u32));
-                    GlobalDebug.WriteRawInfo(&m_RegisterBankF[i], sizeof(u32));
-                }
-            }
+        (void) ::std::memcpy(&m_Ports[PortHalfIndex(LD_ST_PORT_COUNT + (core & (CORE_PORT_COUNT - 1)), 1)], &packet, sizeof(packet));
+    }
 
-            {
-                GlobalDebug.WriteRawInfo(&DebugCodeReportRegisterContestion, sizeof(DebugCodeReportRegisterContestion));
-                constexpr u32 length = sizeof(smIndex) + sizeof(u8) * REGISTER_FILE_REGISTER_COUNT;
-                GlobalDebug.WriteRawInfo(&length, sizeof(length));
-                GlobalDebug.WriteRawInfo(&smIndex, sizeof(smIndex));
-                for(u32 i = 0; i < REGISTER_FILE_REGISTER_COUNT; ++i)
-                {
-                    GlobalDebug.WriteRawInfo(&m_RegisterContestationMapBank0[i], sizeof(u8));
-                    GlobalDebug.WriteRawInfo(&m_RegisterContestationMapBank1[i], sizeof(u8));
-                    GlobalDebug.WriteRawInfo(&m_RegisterContestationMapBank2[i], sizeof(u8));
-                    GlobalDebug.WriteRawInfo(&m_RegisterContestationMapBank3[i], sizeof(u8));
-                    GlobalDebug.WriteRawInfo(&m_RegisterContestationMapBank4[i], sizeof(u8));
-                    GlobalDebug.WriteRawInfo(&m_RegisterContestationMapBank5[i], sizeof(u8));
-                    GlobalDebug.WriteRawInfo(&m_RegisterContestationMapBank6[i], sizeof(u8));
-                    GlobalDebug.WriteRawInfo(&m_RegisterContestationMapBank7[i], sizeof(u8));
-                    GlobalDebug.WriteRawInfo(&m_RegisterContestationMapBank8[i], sizeof(u8));
-                    GlobalDebug.WriteRawInfo(&m_RegisterContestationMapBank9[i], sizeof(u8));
-                    GlobalDebug.WriteRawInfo(&m_RegisterContestationMapBankA[i], sizeof(u8));
-                    GlobalDebug.WriteRawInfo(&m_RegisterContestationMapBankB[i], sizeof(u8));
-                    GlobalDebug.WriteRawInfo(&m_RegisterContestationMapBankC[i], sizeof(u8));
-                    GlobalDebug.WriteRawInfo(&m_RegisterContestationMapBankD[i], sizeof(u8));
-                    GlobalDebug.WriteRawInfo(&m_RegisterContestationMapBankE[i], sizeof(u8));
-                    GlobalDebug.WriteRawInfo(&m_RegisterContestationMapBankF[i], sizeof(u8));
-                }
-            }
+    void InvokeCorePortLow(const u32 core, const CommandPacket packet) noexcept
+    {
+        (void) ::std::memcpy(&m_Ports[PortHalfIndex(LD_ST_PORT_COUNT + (core & (CORE_PORT_COUNT - 1)), 0)], &packet, sizeof(packet));
+    }
+
+    // Bulk access for functional mode, checkpointing, and spill/fill. These bypass the ports and the contestation map,
+    // so they must only be used while no port has an operation in flight on the range.
+    void ReadRegisters(const u32 baseRegister, const u32 registerCount, u32* const values) const noexcept
+    {
+        if(!CheckRange(baseRegister, registerCount))
+        {
+            return;
         }
+
+        (void) ::std::memcpy(values, &m_Registers[baseRegister], sizeof(u32) * registerCount);
     }
-private:
-    void ExecutePacket(const CommandPacket packetHigh, const CommandPacket packetLow) noexcept
+
+    void WriteRegisters(const u32 baseRegister, const u32 registerCount, const u32* const values) noexcept
     {
-        switch(packetHigh.Command)
+        if(!CheckRange(baseRegister, registerCount))
         {
-            case ECommand::ReadRegister:
-                switch(packetHigh.TargetRegister & 0x7)
-                {
-                    case 0: *packetHigh.Value = m_RegisterBank1[packetHigh.TargetRegister >> 3]; break;
-                    case 1: *packetHigh.Value = m_RegisterBank3[packetHigh.TargetRegister >> 3]; break;
-                    case 2: *packetHigh.Value = m_RegisterBank5[packetHigh.TargetRegister >> 3]; break;
-                    case 3: *packetHigh.Value = m_RegisterBank7[packetHigh.TargetRegister >> 3]; break;
-                    case 4: *packetHigh.Value = m_RegisterBank9[packetHigh.TargetRegister >> 3]; break;
-                    case 5: *packetHigh.Value = m_RegisterBankB[packetHigh.TargetRegister >> 3]; break;
-                    case 6: *packetHigh.Value = m_RegisterBankD[packetHigh.TargetRegister >> 3]; break;
-                    case 7: *packetHigh.Value = m_RegisterBankF[packetHigh.TargetRegister >> 3]; break;
-                    default: break;
-                }
-                *packetHigh.Successful = true;
-                *packetHigh.Unsuccessful = false;
-                break;
-            case ECommand::WriteRegister:
-                switch(packetHigh.TargetRegister & 0x7)
-                {
-                    case 0: m_RegisterBank1[packetHigh.TargetRegister >> 3] = *packetHigh.Value; break;
-                    case 1: m_RegisterBank3[packetHigh.TargetRegister >> 3] = *packetHigh.Value; break;
-                    case 2: m_RegisterBank5[packetHigh.TargetRegister >> 3] = *packetHigh.Value; break;
-                    case 3: m_RegisterBank7[packetHigh.TargetRegister >> 3] = *packetHigh.Value; break;
-                    case 4: m_RegisterBank9[packetHigh.TargetRegister >> 3] = *packetHigh.Value; break;
-                    case 5: m_RegisterBankB[packetHigh.TargetRegister >> 3] = *packetHigh.Value; break;
-                    case 6: m_RegisterBankD[packetHigh.TargetRegister >> 3] = *packetHigh.Value; break;
-                    case 7: m_RegisterBankF[packetHigh.TargetRegister >> 3] = *packetHigh.Value; break;
-                    default: break;
-                }
-                *packetHigh.Successful = true;
-                *packetHigh.Unsuccessful = false;
-                break;
-            case ECommand::CheckRead:
-            {
-                u32 contestation;
+            return;
+        }
 
-                switch(packetHigh.TargetRegister & 0x7)
-                {
-                    case 0: contestation = m_RegisterContestationMapBank1[packetHigh.TargetRegister >> 3]; break;
-                    case 1: contestation = m_RegisterContestationMapBank3[packetHigh.TargetRegister >> 3]; break;
-                    case 2: contestation = m_RegisterContestationMapBank5[packetHigh.TargetRegister >> 3]; break;
-                    case 3: contestation = m_RegisterContestationMapBank7[packetHigh.TargetRegister >> 3]; break;
-                    case 4: contestation = m_RegisterContestationMapBank9[packetHigh.TargetRegister >> 3]; break;
-                    case 5: contestation = m_RegisterContestationMapBankB[packetHigh.TargetRegister >> 3]; break;
-                    case 6: contestation = m_RegisterContestationMapBankD[packetHigh.TargetRegister >> 3]; break;
-                    case 7: contestation = m_RegisterContestationMapBankF[packetHigh.TargetRegister >> 3]; break;
-                    default: contestation = 0xFF; break;
-                }
+        (void) ::std::memcpy(&m_Registers[baseRegister], values, sizeof(u32) * registerCount);
 
-                if(contestation != 1 && contestation != 0xFF)
-                {
-                    *packetHigh.Successful = true;
-                    *packetHigh.Unsuccessful = false;
-                }
-                else
-                {
-                    *packetHigh.Successful = false;
-                    *packetHigh.Unsuccessful = true;
-                }
-                break;
-            }
-            case ECommand::CheckWrite:
-            {
-                u8 contestation;
+        for(u32 i = 0; i < registerCount && !m_WriteLogOverflowed; ++i)
+        {
+            LogWrite(baseRegister + i, values[i]);
+        }
+    }
 
-                switch(packetHigh.TargetRegister & 0x7)
-                {
-                    case 0: contestation = m_RegisterContestationMapBank1[packetHigh.TargetRegister >> 3]; break;
-                    case 1: contestation = m_RegisterContestationMapBank3[packetHigh.TargetRegister >> 3]; break;
-                    case 2: contestation = m_RegisterContestationMapBank5[packetHigh.TargetRegister >> 3]; break;
-                    case 3: contestation = m_RegisterContestationMapBank7[packetHigh.TargetRegister >> 3]; break;
-                    case 4: contestation = m_RegisterContestationMapBank9[packetHigh.TargetRegister >> 3]; break;
-                    case 5: contestation = m_RegisterContestationMapBankB[packetHigh.TargetRegister >> 3]; break;
-                    case 6: contestation = m_RegisterContestationMapBankD[packetHigh.TargetRegister >> 3]; break;
-                    case 7: contestation = m_RegisterContestationMapBankF[packetHigh.TargetRegister >> 3]; break;
-                    default: contestation = 0xFF; break;
-                }
+    void ReadContestation(const u32 baseRegister, const u32 registerCount, u8* const contestation) const noexcept
+    {
+        if(!CheckRange(baseRegister, registerCount))
+        {
+            return;
+        }
 
-                if(contestation == 0)
-                {
-                    *packetHigh.Successful = true;
-                    *packetHigh.Unsuccessful = false;
-                }
-                else
-                {
-                    *packetHigh.Successful = false;
-                    *packetHigh.Unsuccessful = true;
-                }
-                break;
-            }
-            case ECommand::LockRead:
-            {
-                u8 contestation;
+        (void) ::std::memcpy(contestation, &m_RegisterContestationMap[baseRegister], registerCount);
+    }
 
-                switch(packetHigh.TargetRegister & 0x7)
-                {
-                    case 0: contestation = m_RegisterContestationMapBank1[packetHigh.TargetRegister >> 3]; break;
-                    case 1: contestation = m_RegisterContestationMapBank3[packetHigh.TargetRegister >> 3]; break;
-                    case 2: contestation = m_RegisterContestationMapBank5[packetHigh.TargetRegister >> 3]; break;
-                    case 3: contestation = m_RegisterContestationMapBank7[packetHigh.TargetRegister >> 3]; break;
-                    case 4: contestation = m_RegisterContestationMapBank9[packetHigh.TargetRegister >> 3]; break;
-                    case 5: contestation = m_RegisterContestationMapBankB[packetHigh.TargetRegister >> 3]; break;
-                    case 6: contestation = m_RegisterContestationMapBankD[packetHigh.TargetRegister >> 3]; break;
-                    case 7: contestation = m_RegisterContestationMapBankF[packetHigh.TargetRegister >> 3]; break;
-                    default: contestation = 0xFF; break;
-                }
+    // The dispatch units check and lock registers directly as they issue, the units release them when they're done.
+    // The contestation map is separate from the banks, so these don't take a bank, and the port commands for the
+    // same operations go through these as well so both see the same locks.
+    [[nodiscard]] bool CanReadRegister(const u32 registerIndex) const noexcept
+    {
+        const u8 contestation = m_RegisterContestationMap[registerIndex & (REGISTER_FILE_REGISTER_COUNT - 1)];
+        return contestation != 1 && contestation != 0xFF;
+    }
 
-                if(contestation == 0)
-                {
-                    contestation = 2;
-                }
-                else
-                {
-                    if(contestation == 0xFF)
-                    {
-                        ConPrinter::PrintLn("Register Read Lock {} has overflowed.", packetHigh.TargetRegister);
+    [[nodiscard]] bool CanWriteRegister(const u32 registerIndex) const noexcept
+    {
+        return m_RegisterContestationMap[registerIndex & (REGISTER_FILE_REGISTER_COUNT - 1)] == 0;
+    }
 
-                        *packetHigh.Successful = false;
-                        *packetHigh.Unsuccessful = true;
+    void LockRegisterRead(const u32 registerIndex) noexcept
+    {
+        u8& contestation = m_RegisterContestationMap[registerIndex & (REGISTER_FILE_REGISTER_COUNT - 1)];
 
-                        assert(contestation != 0xFF);
-                    }
+        if(contestation == 1 || contestation == 0xFF)
+        {
+            ConPrinter::PrintLn("Register {} can't be locked for reading, its contestation is {}.", registerIndex, contestation);
+            assert(false);
+            return;
+        }
 
-                    ++contestation;
-                }
+        contestation = contestation == 0 ? 2 : contestation + 1;
+    }
 
-                switch(packetHigh.TargetRegister & 0x7)
-                {
-                    case 0: m_RegisterContestationMapBank1[packetHigh.TargetRegister >> 3] = contestation; break;
-                    case 1: m_RegisterContestationMapBank3[packetHigh.TargetRegister >> 3] = contestation; break;
-                    case 2: m_RegisterContestationMapBank5[packetHigh.TargetRegister >> 3] = contestation; break;
-                    case 3: m_RegisterContestationMapBank7[packetHigh.TargetRegister >> 3] = contestation; break;
-                    case 4: m_RegisterContestationMapBank9[packetHigh.TargetRegister >> 3] = contestation; break;
-                    case 5: m_RegisterContestationMapBankB[packetHigh.TargetRegister >> 3] = contestation; break;
-                    case 6: m_RegisterContestationMapBankD[packetHigh.TargetRegister >> 3] = contestation; break;
-                    case 7: m_RegisterContestationMapBankF[packetHigh.TargetRegister >> 3] = contestation; break;
-                    default: break;
-                }
+    void LockRegisterWrite(const u32 registerIndex) noexcept
+    {
+        u8& contestation = m_RegisterContestationMap[registerIndex & (REGISTER_FILE_REGISTER_COUNT - 1)];
 
-                *packetHigh.Successful = true;
-                *packetHigh.Unsuccessful = false;
-                break;
-            }
-            case ECommand::LockWrite:
-            {
-                u8 contestation;
+        if(contestation != 0)
+        {
+            ConPrinter::PrintLn("Register {} can't be locked for writing, its contestation is {}.", registerIndex, contestation);
+            assert(false);
+            return;
+        }
 
-                switch(packetHigh.TargetRegister & 0x7)
-                {
-                    case 0: contestation = m_RegisterContestationMapBank1[packetHigh.TargetRegister >> 3]; break;
-                    case 1: contestation = m_RegisterContestationMapBank3[packetHigh.TargetRegister >> 3]; break;
-                    case 2: contestation = m_RegisterContestationMapBank5[packetHigh.TargetRegister >> 3]; break;
-                    case 3: contestation = m_RegisterContestationMapBank7[packetHigh.TargetRegister >> 3]; break;
-                    case 4: contestation = m_RegisterContestationMapBank9[packetHigh.TargetRegister >> 3]; break;
-                    case 5: contestation = m_RegisterContestationMapBankB[packetHigh.TargetRegister >> 3]; break;
-                    case 6: contestation = m_RegisterContestationMapBankD[packetHigh.TargetRegister >> 3]; break;
-                    case 7: contestation = m_RegisterContestationMapBankF[packetHigh.TargetRegister >> 3]; break;
-                    default: contestation = 0xFF; break;
-                }
+        contestation = 1;
+    }
 
-                if(contestation != 0)
-                {
-                    *packetHigh.Successful = false;
-                    *packetHigh.Unsuccessful = true;
-                }
-                else
-                {
-                    contestation = 1;
-
-                    switch(packetHigh.TargetRegister & 0x7)
-                    {
-                        case 0: m_RegisterContestationMapBank1[packetHigh.TargetRegister >> 3] = contestation; break;
-                        case 1: m_RegisterContestationMapBank3[packetHigh.TargetRegister >> 3] = contestation; break;
-                        case 2: m_RegisterContestationMapBank5[packetHigh.TargetRegister >> 3] = contestation; break;
-                        case 3: m_RegisterContestationMapBank7[packetHigh.TargetRegister >> 3] = contestation; break;
-                        case 4: m_RegisterContestationMapBank9[packetHigh.TargetRegister >> 3] = contestation; break;
-                        case 5: m_RegisterContestationMapBankB[packetHigh.TargetRegister >> 3] = contestation; break;
-                        case 6: m_RegisterContestationMapBankD[packetHigh.TargetRegister >> 3] = contestation; break;
-                        case 7: m_RegisterContestationMapBankF[packetHigh.TargetRegister >> 3] = contestation; break;
-                        default: break;
-                    }
-
-                    *packetHigh.Successful = true;
-                    *packetHigh.Unsuccessful = false;
-                }
-                break;
-            }
-            case ECommand::Unlock:
-            {
-                u8 contestation;
+    // Instructions handed straight to a unit, rather than through a dispatch unit, never took their locks, so
+    // releasing an uncontested register does nothing.
+    void ReleaseRegisterContestation(const u32 registerIndex) noexcept
+    {
+        u8& contestation = m_RegisterContestationMap[registerIndex & (REGISTER_FILE_REGISTER_COUNT - 1)];
 
-                switch(packetHigh.TargetRegister & 0x7)
-                {
-                    case 0: contestation = m_RegisterContestationMapBank1[packetHigh.TargetRegister >> 3]; break;
-                    case 1: contestation = m_RegisterContestationMapBank3[packetHigh.TargetRegister >> 3]; break;
-                    case 2: contestation = m_RegisterContestationMapBank5[packetHigh.TargetRegister >> 3]; break;
-                    case 3: contestation = m_RegisterContestationMapBank7[packetHigh.TargetRegister >> 3]; break;
-                    case 4: contestation = m_RegisterContestationMapBank9[packetHigh.TargetRegister >> 3]; break;
-                    case 5: contestation = m_RegisterContestationMapBankB[packetHigh.TargetRegister >> 3]; break;
-                    case 6: contestation = m_RegisterContestationMapBankD[packetHigh.TargetRegister >> 3]; break;
-                    case 7: contestation = m_RegisterContestationMapBankF[packetHigh.TargetRegister >> 3]; break;
-                    default: contestation = 0xFF; break;
-                }
+        if(contestation == 0 || contestation == 1 || contestation == 2)
+        {
+            contestation = 0;
+        }
+        else
+        {
+            --contestation;
+        }
+    }
 
-                --contestation;
+    [[nodiscard]] u32 GetRegister(const u32 registerIndex) const noexcept
+    {
+        return m_Registers[registerIndex & (REGISTER_FILE_REGISTER_COUNT - 1)];
+    }
 
-                if(contestation == 0xFF)
-                {
-                    ConPrinter::PrintLn("Register Unlock {} has underflowed.", packetHigh.TargetRegister);
+    void SetRegister(const u32 registerIndex, const u32 value) noexcept
+    {
+        m_Registers[registerIndex & (REGISTER_FILE_REGISTER_COUNT - 1)] = value;
+        LogWrite(registerIndex & (REGISTER_FILE_REGISTER_COUNT - 1), value);
+    }
 
-                    *packetHigh.Successful = false;
-                    *packetHigh.Unsuccessful = true;
+    // Every write since the log was last cleared, used to keep the cores' operand collectors coherent. If more
+    // registers were written than the log can hold it overflows and the consumer has to assume everything changed.
+    [[nodiscard]] bool HasLoggedWrites() const noexcept { return m_WriteLogCount != 0 || m_WriteLogOverflowed; }
+    [[nodiscard]] bool WriteLogOverflowed() const noexcept { return m_WriteLogOverflowed; }
+    [[nodiscard]] u32 WriteLogCount() const noexcept { return m_WriteLogCount; }
+    [[nodiscard]] u32 LoggedWriteRegister(const u32 index) const noexcept { return m_WriteLogRegisters[index]; }
+    [[nodiscard]] u32 LoggedWriteValue(const u32 index) const noexcept { return m_WriteLogValues[index]; }
 
-                    assert(contestation != 0xFF);
-                }
+    void ClearWriteLog() noexcept
+    {
+        m_WriteLogCount = 0;
+        m_WriteLogOverflowed = false;
+    }
 
-                // If that was the last read lock the value will now be 1, which is actually the write lock. Set it to no lock.
-                if(contestation == 1)
-                {
-                    contestation = 0;
-                }
+    // Whether either half of a port is holding its command back because of a bank conflict.
+    [[nodiscard]] bool IsPortStalled(const u32 port) const noexcept
+    {
+        return (m_StalledPortMask >> (port << 1)) & 0x3;
+    }
 
-                switch(packetHigh.TargetRegister & 0x7)
-                {
-                    case 0: m_RegisterContestationMapBank1[packetHigh.TargetRegister >> 3] = contestation; break;
-                    case 1: m_RegisterContestationMapBank3[packetHigh.TargetRegister >> 3] = contestation; break;
-                    case 2: m_RegisterContestationMapBank5[packetHigh.TargetRegister >> 3] = contestation; break;
-                    case 3: m_RegisterContestationMapBank7[packetHigh.TargetRegister >> 3] = contestation; break;
-                    case 4: m_RegisterContestationMapBank9[packetHigh.TargetRegister >> 3] = contestation; break;
-                    case 5: m_RegisterContestationMapBankB[packetHigh.TargetRegister >> 3] = contestation; break;
-                    case 6: m_RegisterContestationMapBankD[packetHigh.TargetRegister >> 3] = contestation; break;
-                    case 7: m_RegisterContestationMapBankF[packetHigh.TargetRegister >> 3] = contestation; break;
-                    default: break;
-                }
+    void SetBankConflictModelling(const bool enable) noexcept
+    {
+        m_ModelBankConflicts = enable;
 
-                *packetHigh.Successful = true;
-                *packetHigh.Unsuccessful = false;
-                break;
-            }
-            case ECommand::Reset:
-                // This is used for synchronization in hardware.
-                break;
-            case ECommand::None: break;
-            default:
-                ConPrinter::PrintLn("Default case invoked while handling register file command. This should not be possible. {}", static_cast<u8>(packetHigh.Command));
-                assert(false);
-                break;
+        if(!enable)
+        {
+            m_StalledPortMask = 0;
+            m_GrantedBanks = 0;
         }
+    }
+
+    [[nodiscard]] bool BankConflictModelling() const noexcept { return m_ModelBankConflicts; }
 
-        switch(packetLow.Command)
+    [[nodiscard]] u64 BankConflicts(const u32 bank) const noexcept
+    {
+        return m_BankConflicts[bank & (REGISTER_FILE_BANK_COUNT - 1)];
+    }
+
+    [[nodiscard]] u64 TotalBankConflicts() const noexcept
+    {
+        u64 total = 0;
+
+        for(const u64 conflicts : m_BankConflicts)
         {
-            case ECommand::ReadRegister:
-                switch(packetLow.TargetRegister & 0x7)
-                {
-                    case 0: *packetLow.Value = m_RegisterBank0[packetLow.TargetRegister >> 3]; break;
-                    case 1: *packetLow.Value = m_RegisterBank2[packetLow.TargetRegister >> 3]; break;
-                    case 2: *packetLow.Value = m_RegisterBank4[packetLow.TargetRegister >> 3]; break;
-                    case 3: *packetLow.Value = m_RegisterBank6[packetLow.TargetRegister >> 3]; break;
-                    case 4: *packetLow.Value = m_RegisterBank8[packetLow.TargetRegister >> 3]; break;
-                    case 5: *packetLow.Value = m_RegisterBankA[packetLow.TargetRegister >> 3]; break;
-                    case 6: *packetLow.Value = m_RegisterBankC[packetLow.TargetRegister >> 3]; break;
-                    case 7: *packetLow.Value = m_RegisterBankE[packetLow.TargetRegister >> 3]; break;
-                    default: break;
-                }
-                *packetLow.Successful = true;
-                *packetLow.Unsuccessful = false;
-                break;
-            case ECommand::WriteRegister:
-                switch(packetLow.TargetRegister & 0x7)
-                {
-                    case 0: m_RegisterBank0[packetLow.TargetRegister >> 3] = *packetLow.Value; break;
-                    case 1: m_RegisterBank2[packetLow.TargetRegister >> 3] = *packetLow.Value; break;
-                    case 2: m_RegisterBank4[packetLow.TargetRegister >> 3] = *packetLow.Value; break;
-                    case 3: m_RegisterBank6[packetLow.TargetRegister >> 3] = *packetLow.Value; break;
-                    case 4: m_RegisterBank8[packetLow.TargetRegister >> 3] = *packetLow.Value; break;
-                    case 5: m_RegisterBankA[packetLow.TargetRegister >> 3] = *packetLow.Value; break;
-                    case 6: m_RegisterBankC[packetLow.TargetRegister >> 3] = *packetLow.Value; break;
-                    case 7: m_RegisterBankE[packetLow.TargetRegister >> 3] = *packetLow.Value; break;
-                    default: break;
-                }
-                *packetLow.Successful = true;
-                *packetLow.Unsuccessful = false;
-                break;
-            case ECommand::CheckRead:
-            {
-                u8 contestation;
+            total += conflicts;
+        }
 
-                switch(packetLow.TargetRegister & 0x7)
-                {
-                    case 0: contestation = m_RegisterContestationMapBank0[packetLow.TargetRegister >> 3]; break;
-                    case 1: contestation = m_RegisterContestationMapBank2[packetLow.TargetRegister >> 3]; break;
-                    case 2: contestation = m_RegisterContestationMapBank4[packetLow.TargetRegister >> 3]; break;
-                    case 3: contestation = m_RegisterContestationMapBank6[packetLow.TargetRegister >> 3]; break;
-                    case 4: contestation = m_RegisterContestationMapBank8[packetLow.TargetRegister >> 3]; break;
-                    case 5: contestation = m_RegisterContestationMapBankA[packetLow.TargetRegister >> 3]; break;
-                    case 6: contestation = m_RegisterContestationMapBankC[packetLow.TargetRegister >> 3]; break;
-                    case 7: contestation = m_RegisterContestationMapBankE[packetLow.TargetRegister >> 3]; break;
-                    default: contestation = 0xFF; break;
-                }
+        return total;
+    }
 
-                if(contestation != 1 && contestation != 0xFF)
-                {
-                    *packetLow.Successful = true;
-                    *packetLow.Unsuccessful = false;
-                }
-                else
-                {
-                    *packetLow.Successful = false;
-                    *packetLow.Unsuccessful = true;
-                }
-                break;
-            }
-            case ECommand::CheckWrite:
-            {
-                u8 contestation;
+    void ResetStatistics() noexcept
+    {
+        (void) ::std::memset(m_BankConflicts, 0, sizeof(m_BankConflicts));
+    }
 
-                switch(packetLow.TargetRegister & 0x7)
-                {
-                    case 0: contestation = m_RegisterContestationMapBank0[packetLow.TargetRegister >> 3]; break;
-                    case 1: contestation = m_RegisterContestationMapBank2[packetLow.TargetRegister >> 3]; break;
-                    case 2: contestation = m_RegisterContestationMapBank4[packetLow.TargetRegister >> 3]; break;
-                    case 3: contestation = m_RegisterContestationMapBank6[packetLow.TargetRegister >> 3]; break;
-                    case 4: contestation = m_RegisterContestationMapBank8[packetLow.TargetRegister >> 3]; break;
-                    case 5: contestation = m_RegisterContestationMapBankA[packetLow.TargetRegister >> 3]; break;
-                    case 6: contestation = m_RegisterContestationMapBankC[packetLow.TargetRegister >> 3]; break;
-                    case 7: contestation = m_RegisterContestationMapBankE[packetLow.TargetRegister >> 3]; break;
-                    default: contestation = 0xFF; break;
-                }
+    // Sends the registers which changed since the last report to the debugger as a single message.
+    void ReportRegisters(const u32 smIndex) noexcept
+    {
+        if(GlobalDebug.IsAttached())
+        {
+            const u32 messageSize = m_Snapshot.Encode(smIndex, m_Registers, m_RegisterContestationMap);
 
-                if(contestation == 0)
-                {
-                    *packetLow.Successful = true;
-                    *packetLow.Unsuccessful = false;
-                }
-                else
-                {
-                    *packetLow.Successful = false;
-                    *packetLow.Unsuccessful = true;
-                }
-                break;
-            }
-            case ECommand::LockRead:
+            if(messageSize != 0)
             {
-                u8 contestation;
+                GlobalDebug.WriteRawInfo(m_Snapshot.Data(), messageSize);
+            }
+        }
+    }
 
-                switch(packetLow.TargetRegister & 0x7)
-                {
-                    case 0: contestation = m_RegisterContestationMapBank0[packetLow.TargetRegister >> 3]; break;
-                    case 1: contestation = m_RegisterContestationMapBank2[packetLow.TargetRegister >> 3]; break;
-                    case 2: contestation = m_RegisterContestationMapBank4[packetLow.TargetRegister >> 3]; break;
-                    case 3: contestation = m_RegisterContestationMapBank6[packetLow.TargetRegister >> 3]; break;
-                    case 4: contestation = m_RegisterContestationMapBank8[packetLow.TargetRegister >> 3]; break;
-                    case 5: contestation = m_RegisterContestationMapBankA[packetLow.TargetRegister >> 3]; break;
-                    case 6: contestation = m_RegisterContestationMapBankC[packetLow.TargetRegister >> 3]; break;
-                    case 7: contestation = m_RegisterContestationMapBankE[packetLow.TargetRegister >> 3]; break;
-                    default: contestation = 0xFF; break;
-                }
+    [[nodiscard]] RegisterFileSnapshot& Snapshot() noexcept { return m_Snapshot; }
+private:
+    [[nodiscard]] static bool CheckRange(const u32 baseRegister, const u32 registerCount) noexcept
+    {
+        if(baseRegister > REGISTER_FILE_REGISTER_COUNT || registerCount > REGISTER_FILE_REGISTER_COUNT - baseRegister)
+        {
+            ConPrinter::PrintLn("Register range {} + {} is outside of the register file.", baseRegister, registerCount);
+            assert(false);
+            return false;
+        }
 
-                if(contestation == 0)
-                {
-                    contestation = 2;
-                }
-                else
-                {
-                    if(contestation == 0xFF)
-                    {
-                        ConPrinter::PrintLn("Register Read Lock {} has overflowed.", packetLow.TargetRegister);
+        return true;
+    }
 
-                        *packetLow.Successful = false;
-                        *packetLow.Unsuccessful = true;
+    void LogWrite(const u32 registerIndex, const u32 value) noexcept
+    {
+        if(m_WriteLogCount == WRITE_LOG_SIZE)
+        {
+            m_WriteLogOverflowed = true;
+            return;
+        }
 
-                        assert(contestation != 0xFF);
-                    }
+        m_WriteLogRegisters[m_WriteLogCount] = static_cast<u16>(registerIndex);
+        m_WriteLogValues[m_WriteLogCount] = value;
+        ++m_WriteLogCount;
+    }
 
-                    ++contestation;
-                }
+    [[nodiscard]] static constexpr u32 PortHalfIndex(const u32 port, const u32 highBit) noexcept { return (port << 1) | highBit; }
 
-                switch(packetLow.TargetRegister & 0x7)
-                {
-                    case 0: m_RegisterContestationMapBank0[packetLow.TargetRegister >> 3] = contestation; break;
-                    case 1: m_RegisterContestationMapBank2[packetLow.TargetRegister >> 3] = contestation; break;
-                    case 2: m_RegisterContestationMapBank4[packetLow.TargetRegister >> 3] = contestation; break;
-                    case 3: m_RegisterContestationMapBank6[packetLow.TargetRegister >> 3] = contestation; break;
-                    case 4: m_RegisterContestationMapBank8[packetLow.TargetRegister >> 3] = contestation; break;
-                    case 5: m_RegisterContestationMapBankA[packetLow.TargetRegister >> 3] = contestation; break;
-                    case 6: m_RegisterContestationMapBankC[packetLow.TargetRegister >> 3] = contestation; break;
-                    case 7: m_RegisterContestationMapBankE[packetLow.TargetRegister >> 3] = contestation; break;
-                    default: break;
-                }
+    void ArbitrateCommand(const u32 portHalf) noexcept
+    {
+        const CommandPacket& packet = m_Ports[portHalf];
 
-                *packetLow.Successful = true;
-                *packetLow.Unsuccessful = false;
-                break;
-            }
-            case ECommand::LockWrite:
-            {
-                u8 contestation;
+        if(packet.Command == ECommand::None)
+        {
+            return;
+        }
 
-                switch(packetLow.TargetRegister & 0x7)
-                {
-                    case 0: contestation = m_RegisterContestationMapBank0[packetLow.TargetRegister >> 3]; break;
-                    case 1: contestation = m_RegisterContestationMapBank2[packetLow.TargetRegister >> 3]; break;
-                    case 2: contestation = m_RegisterContestationMapBank4[packetLow.TargetRegister >> 3]; break;
-                    case 3: contestation = m_RegisterContestationMapBank6[packetLow.TargetRegister >> 3]; break;
-                    case 4: contestation = m_RegisterContestationMapBank8[packetLow.TargetRegister >> 3]; break;
-                    case 5: contestation = m_RegisterContestationMapBankA[packetLow.TargetRegister >> 3]; break;
-                    case 6: contestation = m_RegisterContestationMapBankC[packetLow.TargetRegister >> 3]; break;
-                    case 7: contestation = m_RegisterContestationMapBankE[packetLow.TargetRegister >> 3]; break;
-                    default: contestation = 0xFF; break;
-                }
+        // Only reads and writes access a bank, the contestation map is separate and a reset doesn't touch either.
+        if(packet.Command != ECommand::ReadRegister && packet.Command != ECommand::WriteRegister)
+        {
+            ConsumeCommand(portHalf);
+            return;
+        }
 
-                if(contestation != 0)
-                {
-                    *packetLow.Successful = false;
-                    *packetLow.Unsuccessful = true;
-                }
-                else
-                {
-                    contestation = 1;
-
-                    switch(packetLow.TargetRegister & 0x7)
-                    {
-                        case 0: m_RegisterContestationMapBank0[packetLow.TargetRegister >> 3] = contestation; break;
-                        case 1: m_RegisterContestationMapBank2[packetLow.TargetRegister >> 3] = contestation; break;
-                        case 2: m_RegisterContestationMapBank4[packetLow.TargetRegister >> 3] = contestation; break;
-                        case 3: m_RegisterContestationMapBank6[packetLow.TargetRegister >> 3] = contestation; break;
-                        case 4: m_RegisterContestationMapBank8[packetLow.TargetRegister >> 3] = contestation; break;
-                        case 5: m_RegisterContestationMapBankA[packetLow.TargetRegister >> 3] = contestation; break;
-                        case 6: m_RegisterContestationMapBankC[packetLow.TargetRegister >> 3] = contestation; break;
-                        case 7: m_RegisterContestationMapBankE[packetLow.TargetRegister >> 3] = contestation; break;
-                        default: break;
-                    }
-
-                    *packetLow.Successful = true;
-                    *packetLow.Unsuccessful = false;
-                }
-                break;
-            }
-            case ECommand::Unlock:
-            {
-                u8 contestation;
+        const u32 highBit = portHalf & 0x1;
+        const u32 bank = BankOfRegister((static_cast<u32>(packet.TargetRegister) << 1) | highBit);
 
-                switch(packetLow.TargetRegister & 0x7)
-                {
-                    case 0: contestation = m_RegisterContestationMapBank0[packetLow.TargetRegister >> 3]; break;
-                    case 1: contestation = m_RegisterContestationMapBank2[packetLow.TargetRegister >> 3]; break;
-                    case 2: contestation = m_RegisterContestationMapBank4[packetLow.TargetRegister >> 3]; break;
-                    case 3: contestation = m_RegisterContestationMapBank6[packetLow.TargetRegister >> 3]; break;
-                    case 4: contestation = m_RegisterContestationMapBank8[packetLow.TargetRegister >> 3]; break;
-                    case 5: contestation = m_RegisterContestationMapBankA[packetLow.TargetRegister >> 3]; break;
-                    case 6: contestation = m_RegisterContestationMapBankC[packetLow.TargetRegister >> 3]; break;
-                    case 7: contestation = m_RegisterContestationMapBankE[packetLow.TargetRegister >> 3]; break;
-                    default: contestation = 0xFF; break;
-                }
+        if(m_GrantedBanks & (1u << bank))
+        {
+            m_StalledPortMask |= 1ull << portHalf;
+            ++m_BankConflicts[bank];
+            return;
+        }
 
-                --contestation;
+        m_GrantedBanks |= static_cast<u16>(1u << bank);
+        ConsumeCommand(portHalf);
+    }
 
-                if(contestation == 0xFF)
-                {
-                    ConPrinter::PrintLn("Register Unlock {} has underflowed.", packetLow.TargetRegister);
+    // Empties the port once its command has executed, otherwise it would execute again on every clock until the
+    // owner replaced it.
+    void ConsumeCommand(const u32 portHalf) noexcept
+    {
+        ExecuteCommand(m_Ports[portHalf], portHalf & 0x1);
+        m_Ports[portHalf].Command = ECommand::None;
+    }
 
-                    *packetLow.Successful = false;
-                    *packetLow.Unsuccessful = true;
+    static void SetCommandResult(const CommandPacket& packet, const bool successful) noexcept
+    {
+        *packet.Successful = successful;
+        *packet.Unsuccessful = !successful;
+    }
 
-                    assert(contestation != 0xFF);
-                }
+    // The port target register omits the high/low bit, so the full register index is rebuilt from the port half.
+    void ExecuteCommand(const CommandPacket packet, const u32 highBit) noexcept
+    {
+        const u32 registerIndex = (static_cast<u32>(packet.TargetRegister) << 1) | highBit;
 
-                // If that was the last read lock the value will now be 1, which is actually the write lock. Set it to no lock.
-                if(contestation == 1)
+        switch(packet.Command)
+        {
+            case ECommand::ReadRegister:
+                *packet.Value = m_Registers[registerIndex];
+                *packet.Successful = true;
+                *packet.Unsuccessful = false;
+                break;
+            case ECommand::WriteRegister:
+                m_Registers[registerIndex] = *packet.Value;
+                LogWrite(registerIndex, *packet.Value);
+                *packet.Successful = true;
+                *packet.Unsuccessful = false;
+                break;
+            case ECommand::CheckRead:
+                SetCommandResult(packet, CanReadRegister(registerIndex));
+                break;
+            case ECommand::CheckWrite:
+                SetCommandResult(packet, CanWriteRegister(registerIndex));
+                break;
+            case ECommand::LockRead:
+            {
+                const bool canRead = CanReadRegister(registerIndex);
+
+                if(canRead)
                 {
-                    contestation = 0;
+                    LockRegisterRead(registerIndex);
                 }
 
-                switch(packetLow.TargetRegister & 0x7)
+                SetCommandResult(packet, canRead);
+                break;
+            }
+            case ECommand::LockWrite:
+            {
+                const bool canWrite = CanWriteRegister(registerIndex);
+
+                if(canWrite)
                 {
-                    case 0: m_RegisterContestationMapBank0[packetLow.TargetRegister >> 3] = contestation; break;
-                    case 1: m_RegisterContestationMapBank2[packetLow.TargetRegister >> 3] = contestation; break;
-                    case 2: m_RegisterContestationMapBank4[packetLow.TargetRegister >> 3] = contestation; break;
-                    case 3: m_RegisterContestationMapBank6[packetLow.TargetRegister >> 3] = contestation; break;
-                    case 4: m_RegisterContestationMapBank8[packetLow.TargetRegister >> 3] = contestation; break;
-                    case 5: m_RegisterContestationMapBankA[packetLow.TargetRegister >> 3] = contestation; break;
-                    case 6: m_RegisterContestationMapBankC[packetLow.TargetRegister >> 3] = contestation; break;
-                    case 7: m_RegisterContestationMapBankE[packetLow.TargetRegister >> 3] = contestation; break;
-                    default: break;
+                    LockRegisterWrite(registerIndex);
                 }
 
-                *packetLow.Successful = true;
-                *packetLow.Unsuccessful = false;
+                SetCommandResult(packet, canWrite);
                 break;
             }
+            case ECommand::Unlock:
+                ReleaseRegisterContestation(registerIndex);
+                SetCommandResult(packet, true);
+                break;
             case ECommand::Reset:
                 // This is used for synchronization in hardware.
                 break;
             case ECommand::None: break;
             default:
-                ConPrinter::PrintLn("Default case invoked while handling register file command. This should not be possible. {}", static_cast<u8>(packetLow.Command));
+                ConPrinter::PrintLn("Default case invoked while handling register file command. This should not be possible. {}", static_cast<u8>(packet.Command));
                 assert(false);
                 break;
         }
     }
 private:
-    u32 m_RegisterBank0[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u32 m_RegisterBank1[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u32 m_RegisterBank2[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u32 m_RegisterBank3[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u32 m_RegisterBank4[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u32 m_RegisterBank5[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u32 m_RegisterBank6[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u32 m_RegisterBank7[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u32 m_RegisterBank8[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u32 m_RegisterBank9[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u32 m_RegisterBankA[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u32 m_RegisterBankB[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u32 m_RegisterBankC[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u32 m_RegisterBankD[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u32 m_RegisterBankE[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u32 m_RegisterBankF[REGISTER_FILE_BANK_REGISTER_COUNT];
-
-    u8 m_RegisterContestationMapBank0[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u8 m_RegisterContestationMapBank1[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u8 m_RegisterContestationMapBank2[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u8 m_RegisterContestationMapBank3[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u8 m_RegisterContestationMapBank4[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u8 m_RegisterContestationMapBank5[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u8 m_RegisterContestationMapBank6[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u8 m_RegisterContestationMapBank7[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u8 m_RegisterContestationMapBank8[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u8 m_RegisterContestationMapBank9[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u8 m_RegisterContestationMapBankA[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u8 m_RegisterContestationMapBankB[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u8 m_RegisterContestationMapBankC[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u8 m_RegisterContestationMapBankD[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u8 m_RegisterContestationMapBankE[REGISTER_FILE_BANK_REGISTER_COUNT];
-    u8 m_RegisterContestationMapBankF[REGISTER_FILE_BANK_REGISTER_COUNT];
-
-    // u32 m_Registers[REGISTER_FILE_REGISTER_COUNT];
+    // The 16 banks interleaved by register, register N lives in bank N & 0xF at row N >> 4. In hardware each bank is
+    // its own array, storing them interleaved lets a range of registers be accessed contiguously.
+    u32 m_Registers[REGISTER_FILE_REGISTER_COUNT];
 
     // This contains information about how each register is being used.
     // If the value is zero the register is unused.
     // If the value is one it is locked for writes.
     // Otherwise, the register is locked for reads. Any number of simultaneous reads are allowed.
-    // u8 m_RegisterContestationMap[REGISTER_FILE_REGISTER_COUNT];
+    u8 m_RegisterContestationMap[REGISTER_FILE_REGISTER_COUNT];
 
     // Storage is just because hardware style ports don't work with the transient nature of functions.
-    CommandPacket m_Port0High;
-    CommandPacket m_Port1High;
-    CommandPacket m_Port2High;
-    CommandPacket m_Port3High;
-    CommandPacket m_Port0Low;
-    CommandPacket m_Port1Low;
-    CommandPacket m_Port2Low;
-    CommandPacket m_Port3Low;
+    // Indexed by port * 2 + high bit.
+    CommandPacket m_Ports[PORT_HALF_COUNT];
+
+    u64 m_BankConflicts[REGISTER_FILE_BANK_COUNT] { };
+    // Bit N is set when port half N is holding a command back because of a bank conflict.
+    u64 m_StalledPortMask = 0;
+    // Bit N is set when bank N has been granted to a command this SM cycle.
+    u16 m_GrantedBanks = 0;
+    bool m_ModelBankConflicts = true;
+
+    u16 m_WriteLogRegisters[WRITE_LOG_SIZE] { };
+    u32 m_WriteLogValues[WRITE_LOG_SIZE] { };
+    u8 m_WriteLogCount = 0;
+    bool m_WriteLogOverflowed = false;
+
+    // The state last reported to the debugger, this is not part of the hardware.
+    RegisterFileSnapshot m_Snapshot;
 };
+
+static_assert(RegisterFile::REGISTER_FILE_REGISTER_COUNT == RegisterFileSnapshot::REGISTER_COUNT, "The debugger snapshot must cover the whole register file.");
@@ -0,0 +1,105 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#pragma once
+
+#include <Objects.hpp>
+#include <NumTypes.hpp>
+
+/**
+ * \brief Packs register file snapshots for the debugger.
+ *
+ *   A snapshot is built into a single contiguous buffer, including the
+ * debug code and length, so that it can be sent with a single write.
+ * Only the first snapshot (or the first after Invalidate) contains the
+ * whole register file, later ones only contain the runs of registers
+ * whose value or contestation changed since the previous snapshot. If
+ * every register changed a full snapshot is sent instead.
+ *
+ * Wire format (little endian), following the u32 debug code and u32 length:
+ *
+ *   u32 Version
+ *   u32 SmIndex
+ *   u32 Flags           Bit 0: Full, the runs cover the whole register file.
+ *   u32 RunCount
+ *   RunCount x
+ *     u16 BaseRegister
+ *     u16 RegisterCount
+ *     u32 Values[RegisterCount]
+ *     u8  Contestation[RegisterCount]
+ *
+ *   Runs are not padded, and are sorted by base register.
+ */
+class RegisterFileSnapshot final
+{
+    DEFAULT_DESTRUCT(RegisterFileSnapshot);
+    DELETE_CM(RegisterFileSnapshot);
+public:
+    static inline constexpr u32 VERSION = 1;
+    static inline constexpr u32 FLAG_FULL = 1 << 0;
+
+    static inline constexpr u32 REGISTER_COUNT = 4096;
+
+    struct Header final
+    {
+        u32 Version;
+        u32 SmIndex;
+        u32 Flags;
+        u32 RunCount;
+    };
+
+    struct RunHeader final
+    {
+        u16 BaseRegister;
+        u16 RegisterCount;
+    };
+
+    static inline constexpr u32 RUN_REGISTER_SIZE = sizeof(u32) + sizeof(u8);
+    static inline constexpr u32 MAX_PAYLOAD_SIZE = sizeof(Header) + sizeof(RunHeader) + REGISTER_COUNT * RUN_REGISTER_SIZE;
+    // The debug code and length.
+    static inline constexpr u32 MESSAGE_HEADER_SIZE = sizeof(u32) * 2;
+public:
+    RegisterFileSnapshot() noexcept
+        : m_ReportedRegisters{ }
+        , m_ReportedContestation{ }
+        , m_Buffer{ }
+        , m_FullPending(true)
+    { }
+
+    // Forces the next snapshot to contain the whole register file.
+    void Invalidate() noexcept
+    {
+        m_FullPending = true;
+    }
+
+    /**
+     * Packs the registers that changed since the last snapshot into the internal buffer.
+     *
+     * @return The number of bytes of the message, including the debug code and length,
+     *   or 0 if nothing changed and there is nothing to send.
+     */
+    [[nodiscard]] u32 Encode(u32 smIndex, const u32* registers, const u8* contestation) noexcept;
+
+    [[nodiscard]] const u8* Data() const noexcept { return m_Buffer; }
+
+    /**
+     * Applies a snapshot payload (everything after the debug code and length) to a copy
+     * of the register file. This mirrors what the debugger does.
+     *
+     * @return False if the payload is malformed or of an unsupported version.
+     */
+    [[nodiscard]] static bool Decode(const u8* payload, u32 payloadSize, u32* smIndex, u32* registers, u8* contestation) noexcept;
+private:
+    [[nodiscard]] u32 EncodeFull(u32 smIndex, const u32* registers, const u8* contestation) noexcept;
+    [[nodiscard]] u32 WriteRun(u32 offset, u32 baseRegister, u32 registerCount, const u32* registers, const u8* contestation) noexcept;
+    [[nodiscard]] u32 Finish(u32 payloadEnd, u32 smIndex, u32 flags, u32 runCount) noexcept;
+private:
+    // What the debugger currently believes the register file contains.
+    u32 m_ReportedRegisters[REGISTER_COUNT];
+    u8 m_ReportedContestation[REGISTER_COUNT];
+    u8 m_Buffer[MESSAGE_HEADER_SIZE + MAX_PAYLOAD_SIZE];
+    bool m_FullPending;
+};
@@ -0,0 +1,114 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#pragma once
+
+#include <Objects.hpp>
+#include <NumTypes.hpp>
+
+#include <cstring>
+
+// The size of each SM's shared memory in KiB.
+#ifndef SOFT_GPU_SHARED_MEMORY_KIB
+    #define SOFT_GPU_SHARED_MEMORY_KIB 64
+#endif
+
+/**
+ * \brief A banked scratchpad local to an SM, shared by all of its warps.
+ *
+ *   Shared memory is addressed in words from 0, with no translation and
+ * no caching, so it never goes near the MMU, the store buffer, or the
+ * L0. Words are interleaved across the banks, so the registers of a
+ * single access are always in different banks.
+ *
+ *   Each bank serves one word per clock. An access which needs a bank
+ * another access already has this clock is refused and retried on the
+ * next one, unless both are reads of the same word, which is broadcast
+ * to both. Words past the end read as 0xFFFFFFFF and ignore writes,
+ * like an invalid page.
+ */
+class SharedMemory final
+{
+    DEFAULT_DESTRUCT(SharedMemory);
+    DELETE_CM(SharedMemory);
+public:
+    static inline constexpr u32 WORD_COUNT = SOFT_GPU_SHARED_MEMORY_KIB * 1024 / sizeof(u32);
+    static inline constexpr u32 BANK_COUNT = 32;
+
+    static_assert(WORD_COUNT % BANK_COUNT == 0, "Shared memory must be a whole number of rows across the banks.");
+public:
+    SharedMemory() noexcept
+        : m_Words{}
+        , m_BusyBanks(0)
+        , m_WriteBanks(0)
+        , m_BankAddresses{}
+        , m_Reads(0)
+        , m_Writes(0)
+        , m_BankConflicts(0)
+        , m_Broadcasts(0)
+    { }
+
+    void Reset() noexcept
+    {
+        (void) ::std::memset(m_Words, 0, sizeof(m_Words));
+        m_BusyBanks = 0;
+        m_WriteBanks = 0;
+        ResetStatistics();
+    }
+
+    // Frees every bank for the next clock.
+    void Clock() noexcept
+    {
+        m_BusyBanks = 0;
+        m_WriteBanks = 0;
+    }
+
+    // Reads wordCount consecutive words. Returns false, reading nothing, if a bank is taken this clock.
+    [[nodiscard]] bool Read(u64 address, u32 wordCount, u32* values) noexcept;
+    // Writes wordCount consecutive words. Returns false, writing nothing, if a bank is taken this clock.
+    [[nodiscard]] bool Write(u64 address, u32 wordCount, const u32* values) noexcept;
+
+    // Direct access for the host, this bypasses the banks.
+    [[nodiscard]] u32 GetWord(const u32 address) const noexcept
+    {
+        return m_Words[address];
+    }
+
+    void SetWord(const u32 address, const u32 value) noexcept
+    {
+        m_Words[address] = value;
+    }
+
+    [[nodiscard]] u64 Reads() const noexcept { return m_Reads; }
+    [[nodiscard]] u64 Writes() const noexcept { return m_Writes; }
+    // Accesses refused because a bank was serving a different word, each retry counts again.
+    [[nodiscard]] u64 BankConflicts() const noexcept { return m_BankConflicts; }
+    // Reads which shared a word with another read in the same clock.
+    [[nodiscard]] u64 Broadcasts() const noexcept { return m_Broadcasts; }
+
+    void ResetStatistics() noexcept
+    {
+        m_Reads = 0;
+        m_Writes = 0;
+        m_BankConflicts = 0;
+        m_Broadcasts = 0;
+    }
+private:
+    // Takes the banks for the access if none of them are serving a different word, or any word for a write.
+    [[nodiscard]] bool AcquireBanks(u64 address, u32 wordCount, bool write) noexcept;
+private:
+    u32 m_Words[WORD_COUNT];
+    // Bit i is set once bank i has been taken this clock.
+    u32 m_BusyBanks;
+    u32 m_WriteBanks;
+    // The word each busy bank is serving.
+    u64 m_BankAddresses[BANK_COUNT];
+
+    u64 m_Reads;
+    u64 m_Writes;
+    u64 m_BankConflicts;
+    u64 m_Broadcasts;
+};
@@ -0,0 +1,136 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#pragma once
+
+#include <Objects.hpp>
+#include <NumTypes.hpp>
+
+#include <cstring>
+
+class StreamingMultiprocessor;
+
+/**
+ * \brief Combines an SM's stores into whole cache line writes.
+ *
+ *   Stores are held by physical cache line along with a mask of the
+ * words written. A store to a line that is already buffered merges into
+ * its entry, later words replacing earlier ones. A line is written to
+ * the L0 as soon as every word has been stored, otherwise it waits until
+ * the buffer needs the entry back, oldest first, or until a fence.
+ *
+ *   Loads from the SM see the buffered words over whatever is in the
+ * cache, so a thread always reads its own stores. Other SMs only see
+ * them once they've been drained, which FlushCache does before flushing
+ * the L0.
+ *
+ *   Uncached and write-through accesses to a buffered line drain it
+ * first, so they stay in program order with the buffered stores.
+ */
+class StoreBuffer final
+{
+    DEFAULT_DESTRUCT(StoreBuffer);
+    DELETE_CM(StoreBuffer);
+public:
+    static inline constexpr u32 ENTRY_COUNT = 8;
+    static inline constexpr u32 LINE_WORD_COUNT = 8;
+    static inline constexpr u8 FULL_LINE_MASK = 0xFF;
+    static inline constexpr u32 INVALID_ENTRY = ENTRY_COUNT;
+
+    struct Entry final
+    {
+        // The physical address of the first word in the line.
+        u64 LineAddress;
+        u32 Data[LINE_WORD_COUNT];
+        u32 Sequence;
+        // Bit i is set if Data[i] has been stored.
+        u8 WordMask;
+        bool External;
+        bool Valid;
+    };
+public:
+    StoreBuffer(StreamingMultiprocessor* const sm) noexcept
+        : m_SM(sm)
+        , m_Entries{}
+        , m_ValidMask(0)
+        , m_Sequence(0)
+        , m_Stores(0)
+        , m_MergedStores(0)
+        , m_FullLineDrains(0)
+        , m_PartialLineDrains(0)
+        , m_CapacityDrains(0)
+        , m_Fences(0)
+        , m_ForwardedLoads(0)
+    { }
+
+    void Reset() noexcept
+    {
+        (void) ::std::memset(m_Entries, 0, sizeof(m_Entries));
+        m_ValidMask = 0;
+        m_Sequence = 0;
+        ResetStatistics();
+    }
+
+    // Buffers wordCount words starting at physicalAddress, which must all be in the same line.
+    void Write(u64 physicalAddress, u32 wordCount, const u32* values, bool external) noexcept;
+
+    // Replaces any of the wordCount words starting at physicalAddress which are buffered. They must all be in the same line.
+    void Forward(u64 physicalAddress, u32 wordCount, u32* values, bool external) noexcept;
+
+    // Writes out the line holding physicalAddress, if it's buffered.
+    void DrainLine(u64 physicalAddress, bool external) noexcept;
+
+    // Writes out every buffered line, oldest first.
+    void Fence() noexcept;
+
+    [[nodiscard]] bool IsEmpty() const noexcept { return m_ValidMask == 0; }
+    [[nodiscard]] const Entry& TestEntry(const u32 entryIndex) const noexcept { return m_Entries[entryIndex]; }
+
+    // Line writes into the buffer.
+    [[nodiscard]] u64 Stores() const noexcept { return m_Stores; }
+    // Line writes which merged into an entry already holding the line.
+    [[nodiscard]] u64 MergedStores() const noexcept { return m_MergedStores; }
+    // Entries written out as a single full line.
+    [[nodiscard]] u64 FullLineDrains() const noexcept { return m_FullLineDrains; }
+    // Entries written out with only some of their words stored.
+    [[nodiscard]] u64 PartialLineDrains() const noexcept { return m_PartialLineDrains; }
+    // Entries drained early because the buffer was full.
+    [[nodiscard]] u64 CapacityDrains() const noexcept { return m_CapacityDrains; }
+    [[nodiscard]] u64 Fences() const noexcept { return m_Fences; }
+    // Reads which took at least one word from the buffer.
+    [[nodiscard]] u64 ForwardedLoads() const noexcept { return m_ForwardedLoads; }
+
+    void ResetStatistics() noexcept
+    {
+        m_Stores = 0;
+        m_MergedStores = 0;
+        m_FullLineDrains = 0;
+        m_PartialLineDrains = 0;
+        m_CapacityDrains = 0;
+        m_Fences = 0;
+        m_ForwardedLoads = 0;
+    }
+private:
+    [[nodiscard]] u32 FindEntry(u64 lineAddress, bool external) const noexcept;
+    [[nodiscard]] u32 OldestEntry() const noexcept;
+
+    // Writes each run of stored words in the entry to the L0, then frees it.
+    void DrainEntry(u32 entryIndex) noexcept;
+private:
+    StreamingMultiprocessor* m_SM;
+    Entry m_Entries[ENTRY_COUNT];
+    // Bit i is set if m_Entries[i] is valid.
+    u32 m_ValidMask;
+    u32 m_Sequence;
+
+    u64 m_Stores;
+    u64 m_MergedStores;
+    u64 m_FullLineDrains;
+    u64 m_PartialLineDrains;
+    u64 m_CapacityDrains;
+    u64 m_Fences;
+    u64 m_ForwardedLoads;
+};
@@ -9,10 +9,28 @@
 #include "RegisterFile.hpp"
 #include "LoadStore.hpp"
 #include "DispatchUnit.hpp"
+#include "WarpScheduler.hpp"
 #include "Core.hpp"
 #include "DebugManager.hpp"
-#include "RegisterAllocator.hpp"
+#include "BitmapRegisterAllocator.hpp"
 #include "MMU.hpp"
+#include "StoreBuffer.hpp"
+#include "LaneCoalescer.hpp"
+#include "SharedMemory.hpp"
+#include "Prefetcher.hpp"
+#include "Cache.hpp"
+
+// The SM launches warps with the bitmap allocator. The buddy allocator can hand out overlapping blocks, so it is only
+// kept for the allocator benchmark to compare against and can't be selected here.
+#ifndef SOFT_GPU_USE_BITMAP_REGISTER_ALLOCATOR
+    #define SOFT_GPU_USE_BITMAP_REGISTER_ALLOCATOR 1
+#endif
+
+#if !SOFT_GPU_USE_BITMAP_REGISTER_ALLOCATOR
+    #error "The buddy register allocator can hand out overlapping register blocks, the SM requires the bitmap allocator."
+#endif
+
+using SmRegisterAllocator = BitmapRegisterAllocator;
 
 class Processor;
 
@@ -20,22 +38,53 @@ class StreamingMultiprocessor final
 {
     DEFAULT_DESTRUCT(StreamingMultiprocessor);
     DELETE_CM(StreamingMultiprocessor);
+public:
+    // Free registers outside the largest free block at which a free triggers compaction.
+    static inline constexpr u32 DEFAULT_REGISTER_COMPACTION_THRESHOLD = 1024;
+    // Compaction moves a row of one register per bank per cycle, once to read it and once to write it.
+    static inline constexpr u32 REGISTER_COMPACTION_ROW_REGISTERS = RegisterFile::REGISTER_FILE_BANK_COUNT;
 public:
     StreamingMultiprocessor(Processor* const processor, const u32 smIndex) noexcept
         : m_Processor(processor)
         , m_RegisterFile { }
         , m_Mmu(this)
+        , m_StoreBuffer(this)
+        , m_LaneCoalescer { }
+        , m_SharedMemory { }
+        , m_Prefetcher(this, LoadStore::MISS_LATENCY_CYCLES * LoadStore::MAX_EXECUTION_STAGE)
+        , m_FpuTimingTable { }
         , m_LdSt { { this, 0 }, { this, 1 }, { this, 2 }, { this, 3 } }
-        , m_FpCores { { this, 0 }, { this, 1 }, { this, 2 }, { this, 3 }, { this, 4 }, { this, 5 }, { this, 6 }, { this, 7 } }
-        , m_IntFpCores { { this, 0 }, { this, 1 }, { this, 2 }, { this, 3 }, { this, 4 }, { this, 5 }, { this, 6 }, { this, 7 } }
+        , m_FpCores {
+            { this, 0, &m_FpuTimingTable }, { this, 1, &m_FpuTimingTable }, { this, 2, &m_FpuTimingTable }, { this, 3, &m_FpuTimingTable },
+            { this, 4, &m_FpuTimingTable }, { this, 5, &m_FpuTimingTable }, { this, 6, &m_FpuTimingTable }, { this, 7, &m_FpuTimingTable }
+        }
+        , m_IntFpCores {
+            { this, 0, &m_FpuTimingTable }, { this, 1, &m_FpuTimingTable }, { this, 2, &m_FpuTimingTable }, { this, 3, &m_FpuTimingTable },
+            { this, 4, &m_FpuTimingTable }, { this, 5, &m_FpuTimingTable }, { this, 6, &m_FpuTimingTable }, { this, 7, &m_FpuTimingTable }
+        }
         , m_DispatchUnits { { this, 0 }, { this, 1 } }
+        , m_WarpSchedulers { { this, &m_DispatchUnits[0], 0 }, { this, &m_DispatchUnits[1], 1 } }
         , m_SMIndex(smIndex)
+        , m_LdStSequence(0)
+        , m_RegisterCompactionThreshold(DEFAULT_REGISTER_COMPACTION_THRESHOLD)
+        , m_RegisterCompactions(0)
+        , m_RegisterCompactionMovedRegisters(0)
+        , m_RegisterCompactionCycles(0)
+        , m_RegisterCompactionRecoveredRegisters(0)
+        , m_RegisterCompactionRecoveredAllocations(0)
+        , m_RegisterCompactionsDeferred(0)
     { }
 
     void Reset()
     {
         m_RegisterFile.Reset();
+        m_RegisterAllocator.Reset();
         m_Mmu.Reset();
+        m_StoreBuffer.Reset();
+        m_LaneCoalescer.Reset();
+        m_SharedMemory.Reset();
+        m_Prefetcher.Reset();
+        m_LdStSequence = 0;
         m_LdSt[0].Reset();
         m_LdSt[1].Reset();
         m_LdSt[2].Reset();
@@ -52,6 +101,8 @@ public:
 
         m_DispatchUnits[0].Reset();
         m_DispatchUnits[1].Reset();
+        m_WarpSchedulers[0].Reset();
+        m_WarpSchedulers[1].Reset();
     }
 
     void Clock() noexcept
@@ -69,7 +120,9 @@ public:
             m_LdSt[1].Clock();
             m_LdSt[2].Clock();
             m_LdSt[3].Clock();
-            m_RegisterFile.Clock();
+            ClockRegisterFile();
+            m_SharedMemory.Clock();
+            m_Prefetcher.Clock();
         }
 
         for(u32 subClockIndex = 0; subClockIndex <= 5; ++subClockIndex)
@@ -77,22 +130,22 @@ public:
             for(u32 coreIndex = 0; coreIndex < 4; ++coreIndex)
             {
                 m_FpCores[coreIndex].Clock(subClockIndex);
-                m_RegisterFile.Clock();
+                ClockRegisterFile();
             }
             for(u32 coreIndex = 0; coreIndex < 4; ++coreIndex)
             {
                 m_IntFpCores[coreIndex].Clock(subClockIndex);
-                m_RegisterFile.Clock();
+                ClockRegisterFile();
             }
             for(u32 coreIndex = 4; coreIndex < 8; ++coreIndex)
             {
                 m_FpCores[coreIndex].Clock(subClockIndex);
-                m_RegisterFile.Clock();
+                ClockRegisterFile();
             }
             for(u32 coreIndex = 4; coreIndex < 8; ++coreIndex)
             {
                 m_IntFpCores[coreIndex].Clock(subClockIndex);
-                m_RegisterFile.Clock();
+                ClockRegisterFile();
             }
         }
 
@@ -104,6 +157,11 @@ public:
             m_DispatchUnits[0].Clock();
             m_DispatchUnits[1].Clock();
         }
+
+        m_WarpSchedulers[0].Clock();
+        m_WarpSchedulers[1].Clock();
+
+        EndRegisterFileCycle();
     }
 
     void TestLoadProgram(const u32 dispatchPort, const u8 replicationMask, const u64 program)
@@ -112,6 +170,11 @@ public:
         m_DispatchUnits[dispatchPort].LoadIP(replicationMask, baseRegisters, program);
     }
 
+    void TestSetFpMode(const u32 dispatchPort, const FpMode fpMode) noexcept
+    {
+        m_DispatchUnits[dispatchPort].SetFpMode(fpMode);
+    }
+
     void TestLoadRegister(const u32 dispatchPort, const u32 replicationIndex, const u8 registerIndex, const u32 registerValue)
     {
         u32 value = registerValue;
@@ -134,7 +197,8 @@ public:
             InvokeRegisterFileLow(0, packet);
         }
 
-        m_RegisterFile.Clock();
+        ClockRegisterFile();
+        EndRegisterFileCycle();
 
         packet.Command = RegisterFile::ECommand::Reset;
 
@@ -147,19 +211,190 @@ public:
             InvokeRegisterFileLow(0, packet);
         }
 
-        m_RegisterFile.Clock();
+        ClockRegisterFile();
 
         // m_RegisterFile.SetRegister((dispatchPort * 4 + replicationIndex) * 256 + registerIndex, registerValue);
     }
 
-    void LoadWarp(const u32 dispatchPort, const u8 enabledMask, const u8 completedMask, const u16 baseRegisters[8], const u64 instructionPointer) noexcept
+    // Writes a register through port 0 the way a Ld/St unit would, including notifying the cores. The write takes a
+    // cycle of its own, so it can't conflict with the one before it.
+    void TestWriteRegister(const u32 registerIndex, const u32 registerValue) noexcept
+    {
+        u32 value = registerValue;
+        bool successful = false;
+        bool unsuccessful = false;
+
+        RegisterFile::CommandPacket packet;
+        packet.Command = RegisterFile::ECommand::WriteRegister;
+        packet.TargetRegister = registerIndex >> 1;
+        packet.Pad = 0;
+        packet.Value = &value;
+        packet.Successful = &successful;
+        packet.Unsuccessful = &unsuccessful;
+
+        RegisterFile::CommandPacket idle { };
+        idle.Command = RegisterFile::ECommand::None;
+
+        if(registerIndex & 0x1)
+        {
+            InvokeRegisterFileHigh(0, packet);
+            InvokeRegisterFileLow(0, idle);
+        }
+        else
+        {
+            InvokeRegisterFileLow(0, packet);
+            InvokeRegisterFileHigh(0, idle);
+        }
+
+        ClockRegisterFile();
+        EndRegisterFileCycle();
+
+        InvokeRegisterFileHigh(0, idle);
+        InvokeRegisterFileLow(0, idle);
+    }
+
+    void LoadWarp(const u32 dispatchPort, const u8 enabledMask, const u8 completedMask, const u16 baseRegisters[8], const u64 instructionPointer, const FpMode fpMode) noexcept
+    {
+        m_DispatchUnits[dispatchPort].LoadWarp(enabledMask, completedMask, baseRegisters, instructionPointer, fpMode);
+    }
+
+    // Queues a warp on the dispatch port's scheduler, see WarpScheduler::LaunchWarp.
+    [[nodiscard]] bool LaunchWarp(const u32 dispatchPort, const u64 instructionPointer, const u8 threadEnabledMask, const u8 requiredRegisterCount, const u64 registerFilePointer, const FpMode fpMode) noexcept
     {
-        m_DispatchUnits[dispatchPort].LoadWarp(enabledMask, completedMask, baseRegisters, instructionPointer);
+        return m_WarpSchedulers[dispatchPort].LaunchWarp(instructionPointer, threadEnabledMask, requiredRegisterCount, registerFilePointer, fpMode);
+    }
+
+    // Direct register access for spilling and filling warps, this bypasses the ports.
+    [[nodiscard]] u32 GetRegister(const u32 registerIndex) const noexcept
+    {
+        return m_RegisterFile.GetRegister(registerIndex);
+    }
+
+    void SetRegister(const u32 registerIndex, const u32 value) noexcept
+    {
+        m_RegisterFile.SetRegister(registerIndex, value);
+    }
+
+    // True if any register in the block has a read or write in flight.
+    [[nodiscard]] bool IsRegisterBlockContested(u32 baseRegister, u32 registerCount) const noexcept;
+
+    [[nodiscard]] bool CanReadRegister(const u32 registerIndex) const noexcept
+    {
+        return m_RegisterFile.CanReadRegister(registerIndex);
+    }
+
+    [[nodiscard]] bool CanWriteRegister(const u32 registerIndex) const noexcept
+    {
+        return m_RegisterFile.CanWriteRegister(registerIndex);
+    }
+
+    void LockRegisterRead(const u32 registerIndex) noexcept
+    {
+        m_RegisterFile.LockRegisterRead(registerIndex);
+    }
+
+    void LockRegisterWrite(const u32 registerIndex) noexcept
+    {
+        m_RegisterFile.LockRegisterWrite(registerIndex);
+    }
+
+    void ReleaseRegisterContestation(const u32 registerIndex) noexcept
+    {
+        m_RegisterFile.ReleaseRegisterContestation(registerIndex);
     }
 
     [[nodiscard]] u32 Read(u64 address) noexcept;
     void Write(u64 address, u32 value) noexcept;
+    // Reads wordCount consecutive words with one transaction per cache line touched, and one translation per page. Returns the number of transactions.
+    // Lines another lane of the group already read are taken from the lane coalescer, and don't count.
+    [[nodiscard]] u32 ReadCoalesced(u64 address, u32 wordCount, u32* values, u32 dispatchPort = 0, u32 group = LaneCoalescer::NO_GROUP) noexcept;
+    // Writes wordCount consecutive words with one transaction per cache line touched, and one translation per page. Returns the number of transactions.
+    // Lines another lane of the group already wrote reuse its translation, and don't count.
+    u32 WriteCoalesced(u64 address, u32 wordCount, const u32* values, u32 dispatchPort = 0, u32 group = LaneCoalescer::NO_GROUP) noexcept;
+
+    // Shared memory accesses bypass translation and the caches, they return false if a bank was taken this clock.
+    [[nodiscard]] bool ReadShared(const u64 address, const u32 wordCount, u32* const values) noexcept
+    {
+        return m_SharedMemory.Read(address, wordCount, values);
+    }
+
+    [[nodiscard]] bool WriteShared(const u64 address, const u32 wordCount, const u32* const values) noexcept
+    {
+        return m_SharedMemory.Write(address, wordCount, values);
+    }
+
+    // Whether an Ld/St unit other than unitIndex holds an older access that must go before this one.
+    [[nodiscard]] bool IsAccessBlocked(const u32 unitIndex, const u32 sequence, const bool storesOnly, const bool shared, const u64 address, const u32 wordCount) const noexcept
+    {
+        for(u32 i = 0; i < 4; ++i)
+        {
+            if(i != unitIndex && m_LdSt[i].BlocksAccess(sequence, storesOnly, shared, address, wordCount))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Whether every Ld/St unit is idle with no loads left to write back.
+    [[nodiscard]] bool IsLdStDrained() const noexcept
+    {
+        for(const LoadStore& ldSt : m_LdSt)
+        {
+            if(ldSt.Stage() != LoadStore::EStage::Idle || ldSt.OutstandingLoads() != 0)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Writes out the stores held in the store buffer, for a fence.
+    void DrainStoreBuffer() noexcept
+    {
+        m_StoreBuffer.Fence();
+    }
+
+    // Applies an atomic operation to the 1 or 2 words at address, which a 64 bit operation needs aligned to 2 words. previous always gets 2 words.
+    void Atomic(u64 address, EAtomicOperation operation, bool wide, bool signedCompare, const u32* operands, u32* previous) noexcept;
+
+    // Called by the store buffer as it drains, wordCount words in a single line.
+    void WriteLinePhysical(u64 physicalAddress, u32 wordCount, const u32* values, bool external) noexcept;
+    // Starts fetching the line holding address into the L0 in the background.
     void Prefetch(u64 address) noexcept;
+    // Called by the prefetcher as a fill arrives.
+    void FillLinePhysical(u64 physicalAddress, bool external) noexcept;
+    // Whether a read of address would hit in this SM's L0 cache.
+    [[nodiscard]] bool IsCached(u64 address) noexcept;
+    [[nodiscard]] bool IsCachedPhysical(u64 physicalAddress, bool external) noexcept;
+    // A load missed on address, returns the clocks left on a prefetch already fetching its line, or 0 if there isn't one.
+    [[nodiscard]] u32 PrefetchWait(u64 address) noexcept;
+
+    void TrainPrefetcher(const u32 unitIndex, const u64 instructionPointer, const u64 address) noexcept
+    {
+        m_Prefetcher.Train(unitIndex, instructionPointer, address);
+    }
+
+    void SetStridePrefetchEnabled(const bool enabled) noexcept
+    {
+        m_Prefetcher.SetStrideEnabled(enabled);
+    }
+
+    // The L0 is shared, so a line one Ld/St unit is still waiting on is on its way for all of them.
+    [[nodiscard]] u32 PendingLineWait(const u64 address) const noexcept
+    {
+        u32 waitClocks = 0;
+
+        for(const LoadStore& ldSt : m_LdSt)
+        {
+            const u32 unitWait = ldSt.PendingLineWait(address);
+            waitClocks = unitWait > waitClocks ? unitWait : waitClocks;
+        }
+
+        return waitClocks;
+    }
 
     void InvokeRegisterFileHigh(const u32 port, const RegisterFile::CommandPacket packet) noexcept
     {
@@ -191,6 +426,152 @@ public:
         }
     }
 
+    [[nodiscard]] bool IsRegisterPortStalled(const u32 port) const noexcept
+    {
+        return m_RegisterFile.IsPortStalled(port);
+    }
+
+    void InvokeCoreRegisterFileHigh(const u32 core, const RegisterFile::CommandPacket packet) noexcept
+    {
+        m_RegisterFile.InvokeCorePortHigh(core, packet);
+    }
+
+    void InvokeCoreRegisterFileLow(const u32 core, const RegisterFile::CommandPacket packet) noexcept
+    {
+        m_RegisterFile.InvokeCorePortLow(core, packet);
+    }
+
+    void SetWarpSchedulingPolicy(const EWarpSchedulingPolicy policy) noexcept
+    {
+        m_WarpSchedulers[0].SetPolicy(policy);
+        m_WarpSchedulers[1].SetPolicy(policy);
+    }
+
+    // How many loads each Ld/St unit keeps in flight, see LoadStore::SetOutstandingLoadLimit.
+    void SetLdStOutstandingLoadLimit(const u32 limit) noexcept
+    {
+        m_LdSt[0].SetOutstandingLoadLimit(limit);
+        m_LdSt[1].SetOutstandingLoadLimit(limit);
+        m_LdSt[2].SetOutstandingLoadLimit(limit);
+        m_LdSt[3].SetOutstandingLoadLimit(limit);
+    }
+
+    void SetRegisterBankConflictModelling(const bool enable) noexcept
+    {
+        m_RegisterFile.SetBankConflictModelling(enable);
+    }
+
+    [[nodiscard]] u64 RegisterBankConflicts(const u32 bank) const noexcept
+    {
+        return m_RegisterFile.BankConflicts(bank);
+    }
+
+    [[nodiscard]] u64 TotalRegisterBankConflicts() const noexcept
+    {
+        return m_RegisterFile.TotalBankConflicts();
+    }
+
+    [[nodiscard]] u64 LdStBankConflictStallCycles() const noexcept
+    {
+        return m_LdSt[0].BankConflictStallCycles() + m_LdSt[1].BankConflictStallCycles() + m_LdSt[2].BankConflictStallCycles() + m_LdSt[3].BankConflictStallCycles();
+    }
+
+    [[nodiscard]] u64 SharedMemoryBankConflicts() const noexcept
+    {
+        return m_SharedMemory.BankConflicts();
+    }
+
+    [[nodiscard]] const Prefetcher& Prefetches() const noexcept
+    {
+        return m_Prefetcher;
+    }
+
+    [[nodiscard]] u64 CoreBankConflictStallCycles() const noexcept
+    {
+        u64 total = 0;
+
+        for(u32 coreIndex = 0; coreIndex < 8; ++coreIndex)
+        {
+            total += m_FpCores[coreIndex].RegisterManager().BankConflictStallCycles();
+            total += m_IntFpCores[coreIndex].RegisterManager().BankConflictStallCycles();
+        }
+
+        return total;
+    }
+
+    [[nodiscard]] u64 CollectedRegisterReads() const noexcept
+    {
+        u64 total = 0;
+
+        for(u32 coreIndex = 0; coreIndex < 8; ++coreIndex)
+        {
+            total += m_FpCores[coreIndex].RegisterManager().CollectedRegisterReads();
+            total += m_IntFpCores[coreIndex].RegisterManager().CollectedRegisterReads();
+        }
+
+        return total;
+    }
+
+    [[nodiscard]] u64 CorePortRegisterReads() const noexcept
+    {
+        u64 total = 0;
+
+        for(u32 coreIndex = 0; coreIndex < 8; ++coreIndex)
+        {
+            total += m_FpCores[coreIndex].RegisterManager().PortRegisterReads();
+            total += m_IntFpCores[coreIndex].RegisterManager().PortRegisterReads();
+        }
+
+        return total;
+    }
+
+    void ResetRegisterStatistics() noexcept
+    {
+        m_RegisterFile.ResetStatistics();
+        m_SharedMemory.ResetStatistics();
+        m_Prefetcher.ResetStatistics();
+        m_LaneCoalescer.ResetStatistics();
+        m_LdSt[0].ResetStatistics();
+        m_LdSt[1].ResetStatistics();
+        m_LdSt[2].ResetStatistics();
+        m_LdSt[3].ResetStatistics();
+
+        for(u32 coreIndex = 0; coreIndex < 8; ++coreIndex)
+        {
+            m_FpCores[coreIndex].ResetStatistics();
+            m_IntFpCores[coreIndex].ResetStatistics();
+        }
+
+        m_RegisterCompactions = 0;
+        m_RegisterCompactionMovedRegisters = 0;
+        m_RegisterCompactionCycles = 0;
+        m_RegisterCompactionRecoveredRegisters = 0;
+        m_RegisterCompactionRecoveredAllocations = 0;
+        m_RegisterCompactionsDeferred = 0;
+    }
+
+    // The occupancy counters summed over both dispatch ports, see EOccupancyStatistic.
+    [[nodiscard]] u64 OccupancyStatistic(const EOccupancyStatistic statistic) const noexcept
+    {
+        // Both schedulers are clocked every cycle, so either one's cycle count is the SM's.
+        if(statistic == EOccupancyStatistic::Cycles)
+        {
+            return m_WarpSchedulers[0].Occupancy(statistic);
+        }
+
+        return m_WarpSchedulers[0].Occupancy(statistic) + m_WarpSchedulers[1].Occupancy(statistic);
+    }
+
+    void ResetOccupancyStatistics() noexcept
+    {
+        m_WarpSchedulers[0].ResetOccupancy();
+        m_WarpSchedulers[1].ResetOccupancy();
+    }
+
+    // The counters of this SM's L0.
+    [[nodiscard]] u64 CacheStatistic(ECacheStatistic statistic) const noexcept;
+    void ResetCacheStatistics() noexcept;
+
     void ReportFpCoreReady(const u32 unitIndex) noexcept
     {
         m_DispatchUnits[0].ReportUnitReady(unitIndex + FP_AVAIL_OFFSET);
@@ -203,18 +584,47 @@ public:
         m_DispatchUnits[1].ReportUnitReady(unitIndex + INT_FP_AVAIL_OFFSET);
     }
 
+    // Only the dispatch unit which issued the blocking instruction counts the stall.
+    void ReportCoreStructuralStall(const u32 dispatchPort) noexcept
+    {
+        m_DispatchUnits[dispatchPort].ReportUnitStructuralStall();
+    }
+
     void ReportLdStReady(const u32 unitIndex) noexcept
     {
         m_DispatchUnits[0].ReportUnitReady(unitIndex + LDST_AVAIL_OFFSET);
         m_DispatchUnits[1].ReportUnitReady(unitIndex + LDST_AVAIL_OFFSET);
     }
     
-    void DispatchLdSt(const u32 ldStIndex, const LoadStoreInstruction instructionInfo) noexcept
+    // The first lane of an instruction starts its dispatch unit's lane coalescing group, the rest join it.
+    void DispatchLdSt(const u32 ldStIndex, LoadStoreInstruction instructionInfo, const u64 instructionPointer, const bool firstLane) noexcept
     {
         m_DispatchUnits[0].ReportUnitBusy(ldStIndex + LDST_AVAIL_OFFSET);
         m_DispatchUnits[1].ReportUnitBusy(ldStIndex + LDST_AVAIL_OFFSET);
 
-        m_LdSt[ldStIndex].PrepareExecution(instructionInfo);
+        // Loads are tagged with the warp that issued them, its scheduler knows it's waiting on memory until they return.
+        // Atomics return the previous value the same way.
+        WarpScheduler& scheduler = m_WarpSchedulers[instructionInfo.DispatchUnit];
+        instructionInfo.Warp = scheduler.CurrentWarp();
+
+        if(instructionInfo.ReadWrite == 0 || instructionInfo.Atomic)
+        {
+            scheduler.ReportLoadIssued(instructionInfo.Warp);
+        }
+
+        const u32 sequence = m_LdStSequence++;
+
+        if(firstLane)
+        {
+            m_LaneCoalescer.BeginGroup(instructionInfo.DispatchUnit, sequence);
+        }
+
+        m_LdSt[ldStIndex].PrepareExecution(instructionInfo, sequence, m_LaneCoalescer.CurrentGroup(instructionInfo.DispatchUnit), instructionPointer);
+    }
+
+    void ReportLoadComplete(const u32 dispatchPort, const u32 warpIndex) noexcept
+    {
+        m_WarpSchedulers[dispatchPort].ReportLoadComplete(warpIndex);
     }
 
     void DispatchFpu(const u32 fpIndex, const FpuInstruction instructionInfo) noexcept
@@ -229,8 +639,36 @@ public:
         {
             m_DispatchUnits[0].ReportUnitBusy(fpIndex - 8 + INT_FP_AVAIL_OFFSET);
             m_DispatchUnits[1].ReportUnitBusy(fpIndex - 8 + INT_FP_AVAIL_OFFSET);
-            m_IntFpCores[fpIndex - 8].InitiateInstructionFP(instructionInfo);
+            m_IntFpCores[fpIndex - 8].InitiateInstruction(instructionInfo);
+        }
+    }
+
+    // The cores hold a pointer to the table, so this takes effect from the next instruction issued.
+    void SetFpuTimingTable(const FpuTimingTable& timingTable) noexcept
+    {
+        m_FpuTimingTable = timingTable;
+    }
+
+    [[nodiscard]] const FpuTimingTable& GetFpuTimingTable() const noexcept { return m_FpuTimingTable; }
+
+    [[nodiscard]] const CoreTiming& TestFpCoreTiming(const u32 fpIndex) const noexcept
+    {
+        if(fpIndex < 8)
+        {
+            return m_FpCores[fpIndex].Timing();
         }
+
+        return m_IntFpCores[fpIndex - 8].Timing();
+    }
+
+    [[nodiscard]] const CoreRegisterManager& TestCoreRegisterManager(const u32 fpIndex) const noexcept
+    {
+        if(fpIndex < 8)
+        {
+            return m_FpCores[fpIndex].RegisterManager();
+        }
+
+        return m_IntFpCores[fpIndex - 8].RegisterManager();
     }
 
     void LoadPageDirectoryPointer(const u64 pageDirectoryPhysicalAddress) noexcept
@@ -247,23 +685,139 @@ public:
 
     void FlushCache() noexcept;
 
-    u16 AllocateRegisters(const u16 registerCount) noexcept
+    // Every allocated block must belong to a resident warp in one of the warp schedulers, compaction only moves those.
+    u16 AllocateRegisters(u16 registerCount) noexcept;
+    void FreeRegisters(u16 registerBase, u16 registerCount) noexcept;
+
+    /**
+     * Moves the resident warps' register blocks to coalesce the free space,
+     * updating the warps' base registers and the dispatch units.
+     *
+     * @return True if any registers were moved. Nothing is moved if it wouldn't
+     *   grow the largest free block, or if any register that has to move is
+     *   contested by an instruction in flight.
+     */
+    bool CompactRegisters() noexcept;
+
+    // 0 disables compaction on free, it is still attempted when an allocation fails.
+    void SetRegisterCompactionThreshold(const u32 threshold) noexcept
+    {
+        m_RegisterCompactionThreshold = threshold;
+    }
+
+    // Free registers which are not part of the largest free block.
+    [[nodiscard]] u32 RegisterFragmentation() const noexcept;
+
+    [[nodiscard]] u64 RegisterCompactions() const noexcept { return m_RegisterCompactions; }
+    [[nodiscard]] u64 RegisterCompactionMovedRegisters() const noexcept { return m_RegisterCompactionMovedRegisters; }
+    [[nodiscard]] u64 RegisterCompactionCycles() const noexcept { return m_RegisterCompactionCycles; }
+    [[nodiscard]] u64 RegisterCompactionRecoveredRegisters() const noexcept { return m_RegisterCompactionRecoveredRegisters; }
+    [[nodiscard]] u64 RegisterCompactionRecoveredAllocations() const noexcept { return m_RegisterCompactionRecoveredAllocations; }
+    [[nodiscard]] u64 RegisterCompactionsDeferred() const noexcept { return m_RegisterCompactionsDeferred; }
+
+    [[nodiscard]] WarpScheduler& TestWarpScheduler(const u32 dispatchPort) noexcept
+    {
+        return m_WarpSchedulers[dispatchPort];
+    }
+
+    [[nodiscard]] const DispatchUnit& TestDispatchUnit(const u32 dispatchPort) const noexcept
+    {
+        return m_DispatchUnits[dispatchPort];
+    }
+
+    [[nodiscard]] const LoadStore& TestLoadStore(const u32 unitIndex) const noexcept
+    {
+        return m_LdSt[unitIndex];
+    }
+
+    [[nodiscard]] const StoreBuffer& TestStoreBuffer() const noexcept
     {
-        return m_RegisterAllocator.AllocateRegisterBlock(registerCount);
+        return m_StoreBuffer;
     }
 
-    void FreeRegisters(const u16 registerBase, const u16 registerCount) noexcept
+    [[nodiscard]] const LaneCoalescer& TestLaneCoalescer() const noexcept
     {
-        m_RegisterAllocator.FreeRegisterBlock(registerBase, registerCount);
+        return m_LaneCoalescer;
     }
+
+    [[nodiscard]] SharedMemory& TestSharedMemory() noexcept
+    {
+        return m_SharedMemory;
+    }
+
+    void TestReadRegisters(const u32 baseRegister, const u32 registerCount, u32* const values) const noexcept
+    {
+        m_RegisterFile.ReadRegisters(baseRegister, registerCount, values);
+    }
+
+    void TestWriteRegisters(const u32 baseRegister, const u32 registerCount, const u32* const values) noexcept
+    {
+        m_RegisterFile.WriteRegisters(baseRegister, registerCount, values);
+        ClockRegisterFile();
+    }
+
+    // Lets the core benchmark clock cores of its own against this SM's register file ports.
+    void TestClockRegisterFile() noexcept
+    {
+        ClockRegisterFile();
+    }
+
+    void TestEndRegisterFileCycle() noexcept
+    {
+        EndRegisterFileCycle();
+    }
+private:
+    void ClockRegisterFile() noexcept
+    {
+        m_RegisterFile.Clock();
+
+        if(m_RegisterFile.HasLoggedWrites())
+        {
+            BroadcastRegisterWrites();
+        }
+    }
+
+    // Grants the commands held back by bank conflicts for the next cycle, which can write registers too.
+    void EndRegisterFileCycle() noexcept
+    {
+        m_RegisterFile.EndCycle();
+
+        if(m_RegisterFile.HasLoggedWrites())
+        {
+            BroadcastRegisterWrites();
+        }
+    }
+
+    // Keeps the cores' operand collectors coherent with writes from the Ld/St units and other cores.
+    void BroadcastRegisterWrites() noexcept;
+
+    // The 256 register chunks occupied by resident warps, in the allocator's chunk layout.
+    [[nodiscard]] u16 OccupiedRegisterChunks() const noexcept;
 private:
     Processor* m_Processor;
     RegisterFile m_RegisterFile;
-    RegisterAllocator m_RegisterAllocator;
+    SmRegisterAllocator m_RegisterAllocator;
     Mmu m_Mmu;
+    StoreBuffer m_StoreBuffer;
+    LaneCoalescer m_LaneCoalescer;
+    SharedMemory m_SharedMemory;
+    Prefetcher m_Prefetcher;
+    FpuTimingTable m_FpuTimingTable;
     LoadStore m_LdSt[4];
     FpCore m_FpCores[8];
     IntFpCore m_IntFpCores[8];
     DispatchUnit m_DispatchUnits[2];
+    WarpScheduler m_WarpSchedulers[2];
     u32 m_SMIndex;
+    // Dispatch order of Ld/St instructions, for keeping their accesses in order.
+    u32 m_LdStSequence;
+
+    u32 m_RegisterCompactionThreshold;
+    u64 m_RegisterCompactions;
+    u64 m_RegisterCompactionMovedRegisters;
+    u64 m_RegisterCompactionCycles;
+    // How much the largest free block grew, summed over all compactions.
+    u64 m_RegisterCompactionRecoveredRegisters;
+    u64 m_RegisterCompactionRecoveredAllocations;
+    u64 m_RegisterCompactionsDeferred;
 };
@@ -9,51 +9,302 @@
 #include <Objects.hpp>
 #include <NumTypes.hpp>
 
+#include <cstring>
+
+#include "FPU.hpp"
+
 #define WARP_COUNT (16)
 #define WARP_COUNT_BITS (4)
 
 class StreamingMultiprocessor;
+class DispatchUnit;
 
 struct WarpInfo final
 {
     // The pointer to the current instruction. This is only updated after a warp is swapped out. This needs to only be 48/52 bits.
     u64 InstructionPointer : 48;
+    // The word address the registers are spilled to, and filled from the first time the warp is scheduled.
     u64 RegisterFilePointer : 48;
     u64 RegisterFileResident : 1;
     u64 RegisterFileBase : 12;
     // The total number of registers required for all threads. This uses 1 based indexing.
     u64 TotalRequiredRegisterCount : 11;
-    u64 Pad : 8;
+    // The FpMode of the warp, this is saved when the warp is switched out.
+    u64 DenormalMode : 2;
+    // The warp has been launched and hasn't halted yet.
+    u64 Active : 1;
+    // Loads issued by the warp which haven't written their registers yet, at most one per miss status entry of each Ld/St unit.
+    u64 OutstandingLoads : 5;
     // The number of registers per thread required in the view for this thread warp. This uses 1 based indexing.
     u8 RequiredRegisterCount;
+    // The threads the warp was launched with, this determines where each thread's registers are.
     u8 ThreadEnabledMask;
+    // The threads which haven't halted yet.
+    u8 ThreadActiveMask;
     u8 ThreadCompletedMask;
+    // When the warp was launched relative to the others on its scheduler, lower is older.
+    u32 LaunchSequence;
+};
+
+enum class EWarpSchedulingPolicy : u8
+{
+    // Round robin over the warps which aren't waiting on memory, each runs for a time slice.
+    LooseRoundRobin = 0,
+    // The current warp runs until it stalls on memory, then the oldest ready warp takes over.
+    GreedyThenOldest,
+    // Round robin within a small active set, warps waiting on memory are swapped out of the set for pending warps.
+    TwoLevel
+};
+
+/**
+ * \brief The occupancy counters kept by each warp scheduler.
+ *
+ *   Every cycle a dispatch port has warps active is counted as exactly one
+ * of issuing or one of the stall reasons, the rest of its cycles are idle
+ * or lost to switching warps. The SM sums these over its two ports, other
+ * than Cycles, which is the SM's own cycle count.
+ */
+enum class EOccupancyStatistic : u8
+{
+    Cycles = 0,
+    // Warps launched and not yet halted, summed every cycle.
+    ActiveWarpCycles,
+    // Warps with their registers in the register file, summed every cycle.
+    ResidentWarpCycles,
+    // Threads of the loaded warp which haven't halted, summed every cycle.
+    ActiveLaneCycles,
+    // The dispatch unit issued at least one instruction.
+    IssueCycles,
+    // No warp was loaded because registers were being allocated, spilled, or filled.
+    RegisterAllocationStallCycles,
+    // The next instruction's registers were locked by an instruction in flight.
+    ScoreboardStallCycles,
+    // As above, but the warp was waiting on one of its own loads.
+    MemoryStallCycles,
+    // No execution unit of the right type was free.
+    DispatchStallCycles,
+    Count
 };
 
+/**
+ * \brief Time slices up to 16 warps onto a single dispatch unit.
+ *
+ *   Warps which don't fit in the register file have their registers
+ * spilled to their RegisterFilePointer through the SM's cache, and
+ * filled again when they're next scheduled. A warp's registers are
+ * always filled from memory the first time it's scheduled, so the
+ * launcher supplies the initial register values there.
+ *
+ *   Warps are only switched at an instruction boundary. When a warp's
+ * time slice is up the dispatch unit is asked to yield, the warp's
+ * state is saved, and the next active warp is loaded. A warp which is
+ * blocked on a register one of its own loads hasn't written yet is
+ * switched out straight away, without waiting for its slice, and isn't
+ * picked again while another warp is ready. Which ready warp runs next
+ * is chosen by the EWarpSchedulingPolicy. If the next warp
+ * isn't resident a block is allocated for it, spilling the resident
+ * warp which ran most recently until one fits. Spills and fills move
+ * one cache line of registers per clock, the dispatch unit idles
+ * while they're in progress.
+ */
 class WarpScheduler final
 {
     DEFAULT_DESTRUCT(WarpScheduler);
     DELETE_CM(WarpScheduler);
 public:
-    WarpScheduler(StreamingMultiprocessor* const sm, const u32 index) noexcept
+    // How many cycles a warp runs before it yields to the next active warp.
+    static inline constexpr u32 TIME_SLICE_CYCLES = 64;
+    // One cache line of registers is spilled or filled per clock.
+    static inline constexpr u32 SPILL_REGISTERS_PER_CLOCK = 8;
+    static inline constexpr u32 INVALID_WARP = WARP_COUNT;
+    // The warps eligible to run under the two level policy.
+    static inline constexpr u32 ACTIVE_SET_SIZE = 4;
+    static inline constexpr u32 OCCUPANCY_STATISTIC_COUNT = static_cast<u32>(EOccupancyStatistic::Count);
+
+    enum class EState : u8
+    {
+        Idle = 0,
+        Running,
+        Yielding,
+        Spilling,
+        Filling
+    };
+public:
+    WarpScheduler(StreamingMultiprocessor* const sm, DispatchUnit* const dispatchUnit, const u32 index) noexcept
         : m_SM(sm)
+        , m_DispatchUnit(dispatchUnit)
         , m_Index(index)
         , m_Warps{ }
+        , m_ActiveWarps(0)
+        , m_WaitingWarps(0)
+        , m_ActiveSet(0)
+        , m_Policy(EWarpSchedulingPolicy::LooseRoundRobin)
         , m_CurrentWarp(0)
-        , m_ActiveWarpCount(0)
+        , m_TransferWarp(0)
+        , m_State(EState::Idle)
+        , m_SliceCycles(0)
+        , m_TransferredRegisters(0)
+        , m_LaunchSequence(0)
+        , m_WarpSwitches(0)
+        , m_CompletedWarps(0)
+        , m_Spills(0)
+        , m_Fills(0)
+        , m_SpilledRegisters(0)
+        , m_FilledRegisters(0)
+        , m_TransferCycles(0)
+        , m_AllocationStallCycles(0)
+        , m_MemoryStallSwitches(0)
+        , m_MemoryStallCycles(0)
+        , m_ActiveCycles(0)
+        , m_Occupancy{ }
     { }
 
+    void Reset() noexcept
+    {
+        (void) ::std::memset(m_Warps, 0, sizeof(m_Warps));
+        m_ActiveWarps = 0;
+        m_WaitingWarps = 0;
+        m_ActiveSet = 0;
+        m_CurrentWarp = 0;
+        m_TransferWarp = 0;
+        m_State = EState::Idle;
+        m_SliceCycles = 0;
+        m_TransferredRegisters = 0;
+        m_LaunchSequence = 0;
+        ResetStatistics();
+    }
+
+    void ResetStatistics() noexcept
+    {
+        m_WarpSwitches = 0;
+        m_CompletedWarps = 0;
+        m_Spills = 0;
+        m_Fills = 0;
+        m_SpilledRegisters = 0;
+        m_FilledRegisters = 0;
+        m_TransferCycles = 0;
+        m_AllocationStallCycles = 0;
+        m_MemoryStallSwitches = 0;
+        m_MemoryStallCycles = 0;
+        m_ActiveCycles = 0;
+        ResetOccupancy();
+    }
+
+    void ResetOccupancy() noexcept
+    {
+        (void) ::std::memset(m_Occupancy, 0, sizeof(m_Occupancy));
+    }
+
     void Clock() noexcept;
 
-    void NextWarp(u64 instructionPointer, u8 threadEnabledMask, u8 threadCompletedMask) noexcept;
+    /**
+     * Adds a warp to the first free slot.
+     *
+     * @param requiredRegisterCount The registers per thread, this uses 1 based indexing.
+     * @param registerFilePointer The word address of the warp's registers in memory, each
+     *   enabled thread's registers follow the previous thread's.
+     * @return False if all slots are in use.
+     */
+    [[nodiscard]] bool LaunchWarp(u64 instructionPointer, u8 threadEnabledMask, u8 requiredRegisterCount, u64 registerFilePointer, FpMode fpMode) noexcept;
+
+    // The policy is kept across resets, it's a property of the SM rather than of the running kernel.
+    void SetPolicy(const EWarpSchedulingPolicy policy) noexcept { m_Policy = policy; }
+    [[nodiscard]] EWarpSchedulingPolicy Policy() const noexcept { return m_Policy; }
+
+    void ReportLoadIssued(u32 warpIndex) noexcept;
+    void ReportLoadComplete(u32 warpIndex) noexcept;
+
+    [[nodiscard]] WarpInfo& Warp(const u32 warpIndex) noexcept { return m_Warps[warpIndex]; }
+    [[nodiscard]] const WarpInfo& Warp(const u32 warpIndex) const noexcept { return m_Warps[warpIndex]; }
+
+    // The warp currently loaded into the dispatch unit.
+    [[nodiscard]] u32 CurrentWarp() const noexcept { return m_CurrentWarp; }
+    [[nodiscard]] u16 ActiveWarps() const noexcept { return m_ActiveWarps; }
+    // Warps with loads outstanding.
+    [[nodiscard]] u16 WaitingWarps() const noexcept { return m_WaitingWarps; }
+    [[nodiscard]] EState State() const noexcept { return m_State; }
+    // The warp being spilled or filled, only meaningful in those states.
+    [[nodiscard]] u32 TransferWarp() const noexcept { return m_TransferWarp; }
 
+    [[nodiscard]] u64 WarpSwitches() const noexcept { return m_WarpSwitches; }
+    [[nodiscard]] u64 CompletedWarps() const noexcept { return m_CompletedWarps; }
+    [[nodiscard]] u64 Spills() const noexcept { return m_Spills; }
+    [[nodiscard]] u64 Fills() const noexcept { return m_Fills; }
+    [[nodiscard]] u64 SpilledRegisters() const noexcept { return m_SpilledRegisters; }
+    [[nodiscard]] u64 FilledRegisters() const noexcept { return m_FilledRegisters; }
+    // Cycles the dispatch unit idled while registers were spilled or filled.
+    [[nodiscard]] u64 TransferCycles() const noexcept { return m_TransferCycles; }
+    // Cycles spent waiting on the other scheduler to free registers.
+    [[nodiscard]] u64 AllocationStallCycles() const noexcept { return m_AllocationStallCycles; }
+    // Switches made because the current warp was blocked on one of its loads.
+    [[nodiscard]] u64 MemoryStallSwitches() const noexcept { return m_MemoryStallSwitches; }
+    // Cycles the current warp was blocked on one of its loads.
+    [[nodiscard]] u64 MemoryStallCycles() const noexcept { return m_MemoryStallCycles; }
+    // Cycles with at least one warp active.
+    [[nodiscard]] u64 ActiveCycles() const noexcept { return m_ActiveCycles; }
 
+    [[nodiscard]] u64 Occupancy(const EOccupancyStatistic statistic) const noexcept
+    {
+        return m_Occupancy[static_cast<u32>(statistic)];
+    }
+private:
+    // Classifies the cycle the dispatch unit just finished, this has to run before the scheduler changes state.
+    void CountOccupancy() noexcept;
+
+    void ScheduleNextWarp() noexcept;
+    void ResumeWarp(u32 warpIndex) noexcept;
+    void SaveCurrentWarp() noexcept;
+    void RetireCurrentWarp() noexcept;
+    void LoadWarp(u32 warpIndex) noexcept;
+
+    // In flight instructions may still write the registers of a warp which was just switched out.
+    [[nodiscard]] bool IsRegisterBlockBusy(const WarpInfo& warp) const noexcept;
+
+    // Returns true once the transfer of m_TransferWarp is complete.
+    [[nodiscard]] bool SpillRegisters() noexcept;
+    [[nodiscard]] bool FillRegisters() noexcept;
+
+    // Switches away from a warp blocked on memory if another warp is ready. Returns true if it switched.
+    [[nodiscard]] bool SwitchOnMemoryStall() noexcept;
+
+    // The next warp to run under the current policy, preferring warps which aren't waiting on memory. Returns INVALID_WARP if none are active.
+    [[nodiscard]] u32 SelectNextWarp() const noexcept;
+    // The next warp in mask after the current one.
+    [[nodiscard]] u32 NextRoundRobin(u16 mask) const noexcept;
+    // The oldest warp in mask.
+    [[nodiscard]] u32 Oldest(u16 mask) const noexcept;
+    // The resident warp which ran most recently, other than the warp we're trying to make room for.
+    [[nodiscard]] u32 SelectSpillVictim(u32 incomingWarp) const noexcept;
 private:
     StreamingMultiprocessor* m_SM;
+    DispatchUnit* m_DispatchUnit;
     u32 m_Index;
 
     WarpInfo m_Warps[WARP_COUNT];
 
+    u16 m_ActiveWarps;
+    u16 m_WaitingWarps;
+    // The warps the two level policy is currently round robining between.
+    u16 m_ActiveSet;
+    EWarpSchedulingPolicy m_Policy;
     u8 m_CurrentWarp : WARP_COUNT_BITS;
-    u8 m_ActiveWarpCount : WARP_COUNT_BITS;
+    u8 m_TransferWarp : WARP_COUNT_BITS;
+    EState m_State;
+    u32 m_SliceCycles;
+    // How far through the current spill or fill we are.
+    u32 m_TransferredRegisters;
+    u32 m_LaunchSequence;
+
+    u64 m_WarpSwitches;
+    u64 m_CompletedWarps;
+    u64 m_Spills;
+    u64 m_Fills;
+    u64 m_SpilledRegisters;
+    u64 m_FilledRegisters;
+    u64 m_TransferCycles;
+    u64 m_AllocationStallCycles;
+    u64 m_MemoryStallSwitches;
+    u64 m_MemoryStallCycles;
+    u64 m_ActiveCycles;
+    u64 m_Occupancy[OCCUPANCY_STATISTIC_COUNT];
 };
@@ -0,0 +1,54 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#include "Atomic.hpp"
+
+[[nodiscard]] static u64 ReadValue(const u32* const words, const bool wide) noexcept
+{
+    return wide ? static_cast<u64>(words[0]) | (static_cast<u64>(words[1]) << 32) : words[0];
+}
+
+// 32 bit values are sign extended so the same comparison works for both widths.
+[[nodiscard]] static i64 ToSigned(const u64 value, const bool wide) noexcept
+{
+    return wide ? static_cast<i64>(value) : static_cast<i64>(static_cast<i32>(static_cast<u32>(value)));
+}
+
+void ApplyAtomicOperation(const EAtomicOperation operation, const bool wide, const bool signedCompare, u32* const memory, const u32* const operands, u32* const previous) noexcept
+{
+    const u64 current = ReadValue(memory, wide);
+    const u64 operand = ReadValue(operands, wide);
+
+    const bool operandLess = signedCompare ? ToSigned(operand, wide) < ToSigned(current, wide) : operand < current;
+    const bool operandGreater = signedCompare ? ToSigned(operand, wide) > ToSigned(current, wide) : operand > current;
+
+    u64 result;
+
+    switch(operation)
+    {
+        case EAtomicOperation::Add: result = current + operand; break;
+        case EAtomicOperation::Min: result = operandLess ? operand : current; break;
+        case EAtomicOperation::Max: result = operandGreater ? operand : current; break;
+        case EAtomicOperation::And: result = current & operand; break;
+        case EAtomicOperation::Or: result = current | operand; break;
+        case EAtomicOperation::Xor: result = current ^ operand; break;
+        case EAtomicOperation::Exchange: result = operand; break;
+        case EAtomicOperation::CompareExchange:
+            // The value to store follows the value to compare against.
+            result = current == operand ? ReadValue(operands + (wide ? 2 : 1), wide) : current;
+            break;
+        default: result = current; break;
+    }
+
+    previous[0] = memory[0];
+    memory[0] = static_cast<u32>(result);
+
+    if(wide)
+    {
+        previous[1] = memory[1];
+        memory[1] = static_cast<u32>(result >> 32);
+    }
+}
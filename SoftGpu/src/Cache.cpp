@@ -9,16 +9,10 @@
 
 void CacheController::ReadCacheLine(const u64 address, u32 data[8], const bool external) noexcept
 {
-    for(uSys i = 0; i < 8; ++i)
-    {
-        data[i] = m_Processor->MemReadPhy(address + i, external);
-    }
+    m_Processor->MemReadPhyBurst(address, 8, data, external);
 }
 
 void CacheController::WriteCacheLine(const u64 address, const u32 data[8], const bool external) noexcept
 {
-    for(uSys i = 0; i < 8; ++i)
-    {
-        m_Processor->MemWritePhy(address + i, data[i], external);
-    }
+    m_Processor->MemWritePhyBurst(address, 8, data, external);
 }
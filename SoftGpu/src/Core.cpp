@@ -7,32 +7,43 @@
 #include "Core.hpp"
 #include "StreamingMultiprocessor.hpp"
 
-void FpCore::InvokeRegisterFileHigh(const RegisterFile::CommandPacket packet) noexcept
+template<ECoreCapability Capability>
+void Core<Capability>::InvokeRegisterFileHigh(const RegisterFile::CommandPacket packet) noexcept
 {
-    m_SM->InvokeRegisterFileHigh(m_UnitIndex & 0x2, packet);
+    m_SM->InvokeCoreRegisterFileHigh(RegisterPort(), packet);
 }
 
-void FpCore::InvokeRegisterFileLow(const RegisterFile::CommandPacket packet) noexcept
+template<ECoreCapability Capability>
+void Core<Capability>::InvokeRegisterFileLow(const RegisterFile::CommandPacket packet) noexcept
 {
-    m_SM->InvokeRegisterFileLow(m_UnitIndex & 0x2, packet);
+    m_SM->InvokeCoreRegisterFileLow(RegisterPort(), packet);
 }
 
-void FpCore::ReportReady() const noexcept
+template<ECoreCapability Capability>
+void Core<Capability>::ReleaseRegisterContestation(const u32 registerIndex) noexcept
 {
-    m_SM->ReportFpCoreReady(m_UnitIndex);
+    m_SM->ReleaseRegisterContestation(registerIndex);
 }
 
-void IntFpCore::InvokeRegisterFileHigh(const RegisterFile::CommandPacket packet) noexcept
+template<ECoreCapability Capability>
+void Core<Capability>::ReportReady() const noexcept
 {
-    m_SM->InvokeRegisterFileHigh(m_UnitIndex & 0x2, packet);
-}
+    // A non-pipelined operation is still occupying the unit, or a register read is waiting out a bank conflict.
+    if(m_Timing.IsIssueBlocked() || m_CRM.IsReadStalled())
+    {
+        m_SM->ReportCoreStructuralStall(m_IssuePort);
+        return;
+    }
 
-void IntFpCore::InvokeRegisterFileLow(const RegisterFile::CommandPacket packet) noexcept
-{
-    m_SM->InvokeRegisterFileLow(m_UnitIndex & 0x2, packet);
+    if constexpr(Capability == ECoreCapability::Fp)
+    {
+        m_SM->ReportFpCoreReady(m_UnitIndex);
+    }
+    else
+    {
+        m_SM->ReportIntFpCoreReady(m_UnitIndex);
+    }
 }
 
-void IntFpCore::ReportReady() const noexcept
-{
-    m_SM->ReportIntFpCoreReady(m_UnitIndex);
-}
+template class Core<ECoreCapability::Fp>;
+template class Core<ECoreCapability::IntFp>;
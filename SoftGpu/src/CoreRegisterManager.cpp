@@ -14,37 +14,63 @@ void CoreRegisterManager::Clock(const u32 clockIndex) noexcept
     switch(clockIndex)
     {
         case 0:
-            RegisterRead();
+            RegisterRead(true);
             break;
         case 1:
+            RegisterRead(true);
             ReadLockRelease();
             break;
         case 2:
             // Op Execute
+            RegisterRead(true);
             break;
         case 3:
+            // The last operand read comes back before the write takes the port.
+            RegisterRead(false);
             RegisterWrite();
             break;
         case 4:
             WriteLockRelease();
             break;
         case 5:
-            m_WriteLock64Bit = m_Write64Bit;
-            m_RegisterWriteLock = m_RegisterWrite;
-            m_RegisterWriteLockReleaseReady = m_RegisterWriteReady;
-
-            m_RegisterWriteReady = false;
-
-            m_ReadLock64Bit = m_Read64Bit;
-            m_RegisterReadLockEnabledCount = m_RegisterReadEnabledCount;
-            m_RegisterReadLockA = m_RegisterReadA;
-            m_RegisterReadLockB = m_RegisterReadB;
-            m_RegisterReadLockC = m_RegisterReadC;
-            m_RegisterReadLockReleaseReady = m_RegisterReadReady;
-
-            m_RegisterReadReady = false;
-            
-            m_Core->ReportReady();
+            // A stalled read or write stays where it is to be finished next cycle, there is nothing to release yet.
+            m_WriteStalled = m_RegisterWriteReady && !IsWriteDone();
+            m_ReadStalled = m_RegisterReadReady && !m_ReadCollected;
+
+            if(m_ReadStalled || m_WriteStalled)
+            {
+                ++m_BankConflictStallCycles;
+            }
+
+            if(m_WriteStalled)
+            {
+                m_RegisterWriteLockReleaseReady = false;
+            }
+            else
+            {
+                m_WriteLock64Bit = m_Write64Bit;
+                m_RegisterWriteLock = m_RegisterWrite;
+                m_RegisterWriteLockReleaseReady = m_RegisterWriteReady;
+
+                m_RegisterWriteReady = false;
+                m_WriteIssued = false;
+            }
+
+            if(m_ReadStalled)
+            {
+                m_RegisterReadLockReleaseReady = false;
+            }
+            else
+            {
+                m_ReadLock64Bit = m_Read64Bit;
+                m_RegisterReadLockEnabledCount = m_RegisterReadEnabledCount;
+                m_RegisterReadLockA = m_RegisterReadA;
+                m_RegisterReadLockB = m_RegisterReadB;
+                m_RegisterReadLockC = m_RegisterReadC;
+                m_RegisterReadLockReleaseReady = m_RegisterReadReady;
+
+                m_RegisterReadReady = false;
+            }
             break;
         default:
             break;
@@ -58,6 +84,9 @@ void CoreRegisterManager::InitiateRegisterRead(const bool is64Bit, const u8 regi
     m_RegisterReadA = registerA;
     m_RegisterReadB = registerB;
     m_RegisterReadC = registerC;
+    m_ReadOperand = 0;
+    m_ReadInFlight = false;
+    m_ReadCollected = false;
 
     m_RegisterReadReady = true;
 }
@@ -67,95 +96,155 @@ void CoreRegisterManager::InitiateRegisterWrite(const bool is64Bit, const u32 st
     m_Write64Bit = is64Bit;
     m_RegisterWrite = storageRegister;
     m_RegisterWriteValue = value;
+    m_WriteIssued = false;
 
     m_RegisterWriteReady = true;
 }
 
-void CoreRegisterManager::RegisterRead() noexcept
+bool CoreRegisterManager::CollectOperand(const u32 registerIndex, u64* const value) noexcept
 {
-    if(!m_RegisterReadReady)
+    u32 low;
+    if(!m_OperandCollector.Lookup(registerIndex, &low))
+    {
+        return false;
+    }
+
+    if(!m_Read64Bit)
+    {
+        *value = low;
+        return true;
+    }
+
+    u32 high;
+    if(!m_OperandCollector.Lookup(registerIndex + 1, &high))
+    {
+        return false;
+    }
+
+    *value = (static_cast<u64>(high) << 32) | low;
+    return true;
+}
+
+void CoreRegisterManager::InvokeRegister(const RegisterFile::ECommand command, const u32 registerIndex, PortAccess& access) noexcept
+{
+    access.Successful = false;
+    access.Unsuccessful = false;
+
+    RegisterFile::CommandPacket packet {};
+    packet.Command = command;
+    // The port half selects the low bit of the register.
+    packet.TargetRegister = static_cast<u16>(registerIndex >> 1);
+    packet.Value = &access.Value;
+    packet.Successful = &access.Successful;
+    packet.Unsuccessful = &access.Unsuccessful;
+
+    if(registerIndex & 0x1)
+    {
+        m_Core->InvokeRegisterFileHigh(packet);
+    }
+    else
+    {
+        m_Core->InvokeRegisterFileLow(packet);
+    }
+}
+
+void CoreRegisterManager::IssueOperandRead(const u32 registerIndex) noexcept
+{
+    InvokeRegister(RegisterFile::ECommand::ReadRegister, registerIndex, (registerIndex & 0x1) ? m_ReadHigh : m_ReadLow);
+    ++m_PortRegisterReads;
+
+    if(m_Read64Bit)
+    {
+        InvokeRegister(RegisterFile::ECommand::ReadRegister, registerIndex + 1, (registerIndex & 0x1) ? m_ReadLow : m_ReadHigh);
+        ++m_PortRegisterReads;
+    }
+}
+
+bool CoreRegisterManager::IsOperandReadDone(const u32 registerIndex) const noexcept
+{
+    if(m_Read64Bit)
+    {
+        return m_ReadLow.Successful && m_ReadHigh.Successful;
+    }
+
+    return (registerIndex & 0x1) ? m_ReadHigh.Successful : m_ReadLow.Successful;
+}
+
+u64 CoreRegisterManager::CompleteOperandRead(const u32 registerIndex) noexcept
+{
+    const u32 low = (registerIndex & 0x1) ? m_ReadHigh.Value : m_ReadLow.Value;
+    m_OperandCollector.Fill(registerIndex, low);
+
+    if(!m_Read64Bit)
+    {
+        return low;
+    }
+
+    const u32 high = (registerIndex & 0x1) ? m_ReadLow.Value : m_ReadHigh.Value;
+    m_OperandCollector.Fill(registerIndex + 1, high);
+
+    return (static_cast<u64>(high) << 32) | low;
+}
+
+bool CoreRegisterManager::IsWriteDone() const noexcept
+{
+    if(!m_WriteIssued)
+    {
+        return false;
+    }
+
+    if(m_Write64Bit)
+    {
+        return m_WriteLow.Successful && m_WriteHigh.Successful;
+    }
+
+    return (m_RegisterWrite & 0x1) ? m_WriteHigh.Successful : m_WriteLow.Successful;
+}
+
+void CoreRegisterManager::RegisterRead(const bool issue) noexcept
+{
+    if(!m_RegisterReadReady || m_ReadCollected)
     {
         return;
     }
-            // TODO: FIX
-    //
-    // if(m_Read64Bit)
-    // {
-    //     RegisterFile::CommandPacket packetHigh;
-    //     packetHigh.Command = RegisterFile::ECommand::ReadRegister;
-    //     packetHigh.Successful = &m_SuccessfulHigh;
-    //     packetHigh.Unsuccessful = &m_UnsuccessfulHigh;
-    //
-    //     RegisterFile::CommandPacket packetLow;
-    //     packetLow.Command = RegisterFile::ECommand::ReadRegister;
-    //     packetLow.Successful = &m_SuccessfulLow;
-    //     packetLow.Unsuccessful = &m_UnsuccessfulLow;
-    //
-    //     // Does the base register start at high?
-    //     if(m_RegisterReadA & 0x1)
-    //     {
-    //         packetHigh.TargetRegister = (m_RegisterReadA + 1u) >> 1u;
-    //         packetLow.TargetRegister = (m_RegisterReadA + 1u) >> 1u;
-    //
-    //         packetHigh.Value = &m_BaseAddressLow;
-    //         packetLow.Value = &m_BaseAddressHigh;
-    //     }
-    //     // The base register starts at low
-    //     else
-    //     {
-    //         packetHigh.TargetRegister = m_RegisterReadA >> 1u;
-    //         packetLow.TargetRegister = m_RegisterReadA >> 1u;
-    //
-    //         packetHigh.Value = &m_BaseAddressHigh;
-    //         packetLow.Value = &m_BaseAddressLow;
-    //     }
-    //
-    //     m_Core->InvokeRegisterFileHigh(packetHigh);
-    //     m_Core->InvokeRegisterFileLow(packetLow);
-    //
-    //     const u32 aLow = m_Core->GetRegister(m_RegisterReadA);
-    //     const u32 aHigh = m_Core->GetRegister(m_RegisterReadA + 1);
-    //
-    //     const u64 a = (static_cast<u64>(aHigh) << 32) | aLow;
-    //     u64 b = 0;
-    //     u64 c = 0;
-    //
-    //     if(m_RegisterReadEnabledCount >= 1u)
-    //     {
-    //         const u32 bLow = m_Core->GetRegister(m_RegisterReadB);
-    //         const u32 bHigh = m_Core->GetRegister(m_RegisterReadB + 1);
-    //
-    //         b = (static_cast<u64>(bHigh) << 32) | bLow;
-    //
-    //         if(m_RegisterReadEnabledCount >= 2u)
-    //         {
-    //             const u32 cLow = m_Core->GetRegister(m_RegisterReadC);
-    //             const u32 cHigh = m_Core->GetRegister(m_RegisterReadC + 1);
-    //
-    //             c = (static_cast<u64>(cHigh) << 32) | cLow;
-    //         }
-    //     }
-    //
-    //     m_Core->ReportRegisterValues(a, b, c);
-    // }
-    // else
-    // {
-    //     const u64 a = m_Core->GetRegister(m_RegisterReadA);
-    //     u64 b = 0;
-    //     u64 c = 0;
-    //
-    //     if(m_RegisterReadEnabledCount >= 1u)
-    //     {
-    //         b = m_Core->GetRegister(m_RegisterReadB);
-    //
-    //         if(m_RegisterReadEnabledCount >= 2u)
-    //         {
-    //             c = m_Core->GetRegister(m_RegisterReadC);
-    //         }
-    //     }
-    //
-    //     m_Core->ReportRegisterValues(a, b, c);
-    // }
+
+    const u32 registers[3] = { m_RegisterReadA, m_RegisterReadB, m_RegisterReadC };
+
+    if(m_ReadInFlight)
+    {
+        // Still held back by a bank conflict.
+        if(!IsOperandReadDone(registers[m_ReadOperand]))
+        {
+            return;
+        }
+
+        m_ReadValues[m_ReadOperand] = CompleteOperandRead(registers[m_ReadOperand]);
+        m_ReadInFlight = false;
+        ++m_ReadOperand;
+    }
+
+    // Operands held by the operand collector don't need the port, the first one which isn't is read through it and
+    // kept for the next instruction to use.
+    for(; m_ReadOperand <= m_RegisterReadEnabledCount && m_ReadOperand < 3; ++m_ReadOperand)
+    {
+        // A write from the last cycle can still be holding the port.
+        if(!issue || (m_WriteIssued && !IsWriteDone()))
+        {
+            return;
+        }
+
+        if(!CollectOperand(registers[m_ReadOperand], &m_ReadValues[m_ReadOperand]))
+        {
+            IssueOperandRead(registers[m_ReadOperand]);
+            m_ReadInFlight = true;
+            return;
+        }
+
+        m_CollectedRegisterReads += m_Read64Bit ? 2 : 1;
+    }
+
+    m_ReadCollected = true;
+    m_Core->ReportRegisterValues(m_ReadValues[0], m_ReadValues[1], m_ReadValues[2]);
 }
 
 void CoreRegisterManager::ReadLockRelease() noexcept
@@ -164,61 +253,46 @@ void CoreRegisterManager::ReadLockRelease() noexcept
     {
         return;
     }
-            // TODO: FIX
-    //
-    // if(m_ReadLock64Bit)
-    // {
-    //     m_Core->ReleaseRegisterContestation(m_RegisterReadA);
-    //     m_Core->ReleaseRegisterContestation(m_RegisterReadA + 1);
-    //
-    //     if(m_RegisterReadLockEnabledCount >= 1u)
-    //     {
-    //         m_Core->ReleaseRegisterContestation(m_RegisterReadB);
-    //         m_Core->ReleaseRegisterContestation(m_RegisterReadB + 1);
-    //
-    //         if(m_RegisterReadLockEnabledCount >= 2u)
-    //         {
-    //             m_Core->ReleaseRegisterContestation(m_RegisterReadC);
-    //             m_Core->ReleaseRegisterContestation(m_RegisterReadC + 1);
-    //         }
-    //     }
-    // }
-    // else
-    // {
-    //     m_Core->ReleaseRegisterContestation(m_RegisterReadA);
-    //
-    //     if(m_RegisterReadLockEnabledCount >= 1u)
-    //     {
-    //         m_Core->ReleaseRegisterContestation(m_RegisterReadB);
-    //
-    //         if(m_RegisterReadLockEnabledCount >= 2u)
-    //         {
-    //             m_Core->ReleaseRegisterContestation(m_RegisterReadC);
-    //         }
-    //     }
-    // }
+
+    // The locks are released whether or not the operands came from the operand collector, the dispatch unit took them either way.
+    const u32 registers[3] = { m_RegisterReadLockA, m_RegisterReadLockB, m_RegisterReadLockC };
+
+    for(u32 i = 0; i <= m_RegisterReadLockEnabledCount && i < 3; ++i)
+    {
+        m_Core->ReleaseRegisterContestation(registers[i]);
+
+        if(m_ReadLock64Bit)
+        {
+            m_Core->ReleaseRegisterContestation(registers[i] + 1);
+        }
+    }
 }
 
 void CoreRegisterManager::RegisterWrite() noexcept
 {
-    if(!m_RegisterWriteReady)
+    // A write already on the port is waiting on a bank conflict, and a read held on the port keeps it busy.
+    if(!m_RegisterWriteReady || m_WriteIssued || m_ReadInFlight)
     {
         return;
     }
-            // TODO: FIX
-    //
-    // if(m_Write64Bit)
-    // {
-    //     u32 words[2];
-    //     (void) ::std::memcpy(words, &m_RegisterWriteValue, sizeof(m_RegisterWriteValue));
-    //
-    //     m_Core->SetRegister(m_RegisterWrite, words[0]);
-    //     m_Core->SetRegister(m_RegisterWrite + 1, words[1]);
-    // }
-    // else
-    // {
-    //     m_Core->SetRegister(m_RegisterWrite, static_cast<u32>(m_RegisterWriteValue));
-    // }
+
+    u32 words[2];
+    (void) ::std::memcpy(words, &m_RegisterWriteValue, sizeof(m_RegisterWriteValue));
+
+    m_WriteIssued = true;
+
+    PortAccess& first = (m_RegisterWrite & 0x1) ? m_WriteHigh : m_WriteLow;
+    first.Value = words[0];
+    InvokeRegister(RegisterFile::ECommand::WriteRegister, m_RegisterWrite, first);
+    m_OperandCollector.Forward(m_RegisterWrite, words[0]);
+
+    if(m_Write64Bit)
+    {
+        PortAccess& second = (m_RegisterWrite & 0x1) ? m_WriteLow : m_WriteHigh;
+        second.Value = words[1];
+        InvokeRegister(RegisterFile::ECommand::WriteRegister, m_RegisterWrite + 1, second);
+        m_OperandCollector.Forward(m_RegisterWrite + 1, words[1]);
+    }
 }
 
 void CoreRegisterManager::WriteLockRelease() noexcept
@@ -227,12 +301,11 @@ void CoreRegisterManager::WriteLockRelease() noexcept
     {
         return;
     }
-            // TODO: FIX
-    //
-    // m_Core->ReleaseRegisterContestation(m_RegisterWrite);
-    //
-    // if(m_WriteLock64Bit)
-    // {
-    //     m_Core->ReleaseRegisterContestation(m_RegisterWrite + 1);
-    // }
+
+    m_Core->ReleaseRegisterContestation(m_RegisterWriteLock);
+
+    if(m_WriteLock64Bit)
+    {
+        m_Core->ReleaseRegisterContestation(m_RegisterWriteLock + 1);
+    }
 }
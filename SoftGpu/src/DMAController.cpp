@@ -41,10 +41,7 @@ void DMAChannel::ExecuteRead() noexcept
     }
     else
     {
-        for(u64 i = 0; i < wordsToTransfer; ++i)
-        {
-            m_TransferBlock[i] = m_Processor->MemReadPhy(p_GPUVirtualAddress + i);
-        }
+        m_Processor->MemReadPhyBurst(p_GPUVirtualAddress, static_cast<u32>(wordsToTransfer), m_TransferBlock);
     }
 }
 
@@ -67,10 +64,7 @@ void DMAChannel::ExecuteWrite() noexcept
 
     if(p_ReadWrite)
     {
-        for(u64 i = 0; i < static_cast<u64>(m_WordsInTransferBlock); ++i)
-        {
-            m_Processor->MemWritePhy(p_GPUVirtualAddress + i, m_TransferBlock[i]);
-        }
+        m_Processor->MemWritePhyBurst(p_GPUVirtualAddress, m_WordsInTransferBlock, m_TransferBlock);
     }
     else
     {
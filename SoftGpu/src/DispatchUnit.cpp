@@ -13,6 +13,9 @@
 void DispatchUnit::ResetCycle() noexcept
 {
     m_IsStalled = false;
+    m_DependencyStalled = false;
+    m_UnitStalled = false;
+    m_Issued = false;
     m_ClockIndex = 0;
     ++m_TotalIterationsTracker;
     m_FpSaturationTracker += 8 - ::std::popcount(m_FpAvailabilityMap);
@@ -36,8 +39,15 @@ void DispatchUnit::Clock() noexcept
         return;
     }
 
+    if(m_NeedToDecode && m_YieldRequested)
+    {
+        m_IsStalled = true;
+        return;
+    }
+
     if(m_NeedToDecode)
     {
+        m_InstructionStartPointer = m_InstructionPointer;
         u64 localInstructionPointer = m_InstructionPointer;
 
         u32 wordIndex = localInstructionPointer & 0x3;
@@ -117,8 +127,30 @@ void DispatchUnit::Clock() noexcept
             case EInstruction::RemVec2D:
             case EInstruction::RemVec3D:
             case EInstruction::RemVec4D:
+            case EInstruction::AddB:
+            case EInstruction::AddVec2B:
+            case EInstruction::AddVec3B:
+            case EInstruction::AddVec4B:
+            case EInstruction::SubB:
+            case EInstruction::SubVec2B:
+            case EInstruction::SubVec3B:
+            case EInstruction::SubVec4B:
+            case EInstruction::MulB:
+            case EInstruction::MulVec2B:
+            case EInstruction::MulVec3B:
+            case EInstruction::MulVec4B:
+            case EInstruction::DivB:
+            case EInstruction::DivVec2B:
+            case EInstruction::DivVec3B:
+            case EInstruction::DivVec4B:
+            case EInstruction::RemB:
+            case EInstruction::RemVec2B:
+            case EInstruction::RemVec3B:
+            case EInstruction::RemVec4B:
                 DecodeFpuBinOp(localInstructionPointer, wordIndex, instructionBytes);
                 break;
+            case EInstruction::SetFpMode: DecodeSetFpMode(localInstructionPointer, wordIndex, instructionBytes); break;
+            case EInstruction::Atomic: DecodeAtomic(localInstructionPointer, wordIndex, instructionBytes); break;
             default: break;
         }
 
@@ -165,29 +197,13 @@ void DispatchUnit::Clock() noexcept
 
     switch(m_CurrentInstruction)
     {
-        case EInstruction::Nop: break;
+        case EInstruction::Nop:
+            m_ReplicationCompletedMask |= 1 << replicationIndex;
+            break;
         case EInstruction::Hlt:
         {
-            switch(replicationIndex)
-            {
-                case 0:
-                    m_ReplicationMask &= 0b1110;
-                    m_ReplicationCompletedMask &= 0b1110;
-                    break;
-                case 1:
-                    m_ReplicationMask &= 0b1101;
-                    m_ReplicationCompletedMask &= 0b1101;
-                    break;
-                case 2:
-                    m_ReplicationMask &= 0b1011;
-                    m_ReplicationCompletedMask &= 0b1011;
-                    break;
-                case 3:
-                    m_ReplicationMask &= 0b0111;
-                    m_ReplicationCompletedMask &= 0b0111;
-                    break;
-                default: break;
-            }
+            m_ReplicationMask &= ~(1u << replicationIndex);
+            m_ReplicationCompletedMask &= ~(1u << replicationIndex);
 
             if(m_ReplicationMask == 0x0u)
             {
@@ -208,7 +224,16 @@ void DispatchUnit::Clock() noexcept
             //         return;
             //     }
             // }
+
+            // The flush is also a fence, earlier loads and stores have to be out of the Ld/St units first.
+            if(!m_SM->IsLdStDrained())
+            {
+                m_IsStalled = true;
+                break;
+            }
+
             m_SM->FlushCache();
+            m_ReplicationCompletedMask |= 1 << replicationIndex;
             break;
         case EInstruction::ResetStatistics:
         {
@@ -216,7 +241,12 @@ void DispatchUnit::Clock() noexcept
             m_IntFpSaturationTracker = 0;
             m_LdStSaturationTracker = 0;
             m_TextureSaturationTracker = 0;
+            m_StructuralStallTracker = 0;
             m_TotalIterationsTracker = 0;
+            m_SM->ResetRegisterStatistics();
+            m_SM->ResetOccupancyStatistics();
+            m_SM->ResetCacheStatistics();
+            m_ReplicationCompletedMask |= 1 << replicationIndex;
             break;
         }
         case EInstruction::WriteStatistics: DispatchWriteStatistics(replicationIndex); break;
@@ -280,13 +310,37 @@ void DispatchUnit::Clock() noexcept
         case EInstruction::RemVec2D:
         case EInstruction::RemVec3D:
         case EInstruction::RemVec4D:
+        case EInstruction::AddB:
+        case EInstruction::AddVec2B:
+        case EInstruction::AddVec3B:
+        case EInstruction::AddVec4B:
+        case EInstruction::SubB:
+        case EInstruction::SubVec2B:
+        case EInstruction::SubVec3B:
+        case EInstruction::SubVec4B:
+        case EInstruction::MulB:
+        case EInstruction::MulVec2B:
+        case EInstruction::MulVec3B:
+        case EInstruction::MulVec4B:
+        case EInstruction::DivB:
+        case EInstruction::DivVec2B:
+        case EInstruction::DivVec3B:
+        case EInstruction::DivVec4B:
+        case EInstruction::RemB:
+        case EInstruction::RemVec2B:
+        case EInstruction::RemVec3B:
+        case EInstruction::RemVec4B:
             DispatchFpuBinOp(replicationIndex);
             break;
+        case EInstruction::SetFpMode: DispatchSetFpMode(replicationIndex); break;
+        case EInstruction::Atomic: DispatchAtomic(replicationIndex); break;
         default: break;
     }
 
     if(!m_IsStalled)
     {
+        m_Issued = true;
+
         // Only continue to the next instruction when all replications are complete
         // if(static_cast<u32>(m_ReplicationCompletedMask) >> (replicationIndex + 1) == 0x0u)
         if(static_cast<u32>(m_ReplicationCompletedMask) == static_cast<u32>(m_ReplicationMask))
@@ -312,50 +366,62 @@ void DispatchUnit::NextInstruction(u64& localInstructionPointer, u32& wordIndex,
 
 bool DispatchUnit::CanReadRegister(const u32 registerIndex, const u32 replicationIndex) noexcept
 {
-    (void) registerIndex;
-    (void) replicationIndex;
-    // TODO: FIX
-    // return m_SM->CanReadRegister(m_BaseRegisters[replicationIndex] + registerIndex);
-    return false;
+    const bool canRead = m_SM->CanReadRegister(m_BaseRegisters[replicationIndex] + registerIndex);
+
+    if(!canRead)
+    {
+        m_DependencyStalled = true;
+    }
+
+    return canRead;
 }
 
 bool DispatchUnit::CanWriteRegister(const u32 registerIndex, const u32 replicationIndex) noexcept
 {
-    (void) registerIndex;
-    (void) replicationIndex;
-    // TODO: FIX
-    // return m_SM->CanWriteRegister(m_BaseRegisters[replicationIndex] + registerIndex);
-    return false;
+    const bool canWrite = m_SM->CanWriteRegister(m_BaseRegisters[replicationIndex] + registerIndex);
+
+    if(!canWrite)
+    {
+        m_DependencyStalled = true;
+    }
+
+    return canWrite;
 }
 
 void DispatchUnit::ReleaseRegisterContestation(const u32 registerIndex, const u32 replicationIndex) noexcept
 {
-    (void) registerIndex;
-    (void) replicationIndex;
-    // TODO: FIX
-    // m_SM->ReleaseRegisterContestation(m_BaseRegisters[replicationIndex] + registerIndex);
+    m_SM->ReleaseRegisterContestation(m_BaseRegisters[replicationIndex] + registerIndex);
 }
 
 void DispatchUnit::LockRegisterRead(const u32 registerIndex, const u32 replicationIndex) noexcept
 {
-    (void) registerIndex;
-    (void) replicationIndex;
-    // TODO: FIX
-    // m_SM->LockRegisterRead(m_BaseRegisters[replicationIndex] + registerIndex);
+    m_SM->LockRegisterRead(m_BaseRegisters[replicationIndex] + registerIndex);
 }
 
 void DispatchUnit::LockRegisterWrite(const u32 registerIndex, const u32 replicationIndex) noexcept
 {
-    (void) registerIndex;
-    (void) replicationIndex;
-    // TODO: FIX
-    // m_SM->LockRegisterWrite(m_BaseRegisters[replicationIndex] + registerIndex);
+    m_SM->LockRegisterWrite(m_BaseRegisters[replicationIndex] + registerIndex);
+}
+
+void DispatchUnit::WriteRegister(const u32 registerIndex, const u32 replicationIndex, const u32 value) noexcept
+{
+    m_SM->SetRegister(m_BaseRegisters[replicationIndex] + registerIndex, value);
+}
+
+void DispatchUnit::WriteRegister64(const u32 registerIndex, const u32 replicationIndex, const u64 value) noexcept
+{
+    u32 words[2];
+    (void) ::std::memcpy(words, &value, sizeof(value));
+
+    WriteRegister(registerIndex, replicationIndex, words[0]);
+    WriteRegister(registerIndex + 1, replicationIndex, words[1]);
 }
 
 void DispatchUnit::DecodeLdSt(u64& localInstructionPointer, u32& wordIndex, u8 instructionBytes[4]) noexcept
 {
     NextInstruction(localInstructionPointer, wordIndex, instructionBytes);
 
+    const u32 shared = (instructionBytes[wordIndex] >> 7) & 0x1;
     const u32 readWrite = (instructionBytes[wordIndex] >> 6) & 0x1;
     const u32 indexExponent = (instructionBytes[wordIndex] >> 3) & 0x7;
     const u32 registerCount = instructionBytes[wordIndex] & 0x7;
@@ -387,7 +453,7 @@ void DispatchUnit::DecodeLdSt(u64& localInstructionPointer, u32& wordIndex, u8 i
 
     const i16 offset = static_cast<i16>((static_cast<u16>(offsetHigh) << 8) | offsetLow);
 
-    m_DecodedInstructionData.LoadStore.Pad = 0;
+    m_DecodedInstructionData.LoadStore.Shared = shared;
     m_DecodedInstructionData.LoadStore.ReadWrite = readWrite;
     m_DecodedInstructionData.LoadStore.IndexExponent = indexExponent;
     m_DecodedInstructionData.LoadStore.RegisterCount = registerCount;
@@ -397,6 +463,50 @@ void DispatchUnit::DecodeLdSt(u64& localInstructionPointer, u32& wordIndex, u8 i
     m_DecodedInstructionData.LoadStore.Offset = offset;
 }
 
+void DispatchUnit::DecodeAtomic(u64& localInstructionPointer, u32& wordIndex, u8 instructionBytes[4]) noexcept
+{
+    NextInstruction(localInstructionPointer, wordIndex, instructionBytes);
+
+    const u32 signedCompare = (instructionBytes[wordIndex] >> 7) & 0x1;
+    const u32 wide = (instructionBytes[wordIndex] >> 6) & 0x1;
+    const u32 indexExponent = (instructionBytes[wordIndex] >> 3) & 0x7;
+    const u32 operation = instructionBytes[wordIndex] & 0x7;
+
+    NextInstruction(localInstructionPointer, wordIndex, instructionBytes);
+
+    const u8 baseRegister = instructionBytes[wordIndex];
+
+    u8 indexRegister = 0;
+
+    if(indexExponent != 7)
+    {
+        NextInstruction(localInstructionPointer, wordIndex, instructionBytes);
+
+        indexRegister = instructionBytes[wordIndex];
+    }
+
+    NextInstruction(localInstructionPointer, wordIndex, instructionBytes);
+
+    const u8 targetRegister = instructionBytes[wordIndex];
+
+    NextInstruction(localInstructionPointer, wordIndex, instructionBytes);
+
+    const u8 offsetLow = instructionBytes[wordIndex];
+
+    NextInstruction(localInstructionPointer, wordIndex, instructionBytes);
+
+    const u8 offsetHigh = instructionBytes[wordIndex];
+
+    m_DecodedInstructionData.Atomic.SignedCompare = signedCompare;
+    m_DecodedInstructionData.Atomic.Wide = wide;
+    m_DecodedInstructionData.Atomic.IndexExponent = indexExponent;
+    m_DecodedInstructionData.Atomic.Operation = operation;
+    m_DecodedInstructionData.Atomic.BaseRegister = baseRegister;
+    m_DecodedInstructionData.Atomic.IndexRegister = indexRegister;
+    m_DecodedInstructionData.Atomic.TargetRegister = targetRegister;
+    m_DecodedInstructionData.Atomic.Offset = static_cast<i16>((static_cast<u16>(offsetHigh) << 8) | offsetLow);
+}
+
 void DispatchUnit::DecodeLoadImmediate(u64& localInstructionPointer, u32& wordIndex, u8 instructionBytes[4]) noexcept
 {
     NextInstruction(localInstructionPointer, wordIndex, instructionBytes);
@@ -462,7 +572,13 @@ void DispatchUnit::DecodeFpuBinOp(u64& localInstructionPointer, u32& wordIndex,
 
     const EPrecision precision = GetElementPrecision(m_CurrentInstruction);
     const EBinOp binOp = GetElementOperation(m_CurrentInstruction);
-    const u32 baseRegisterCount = GetElementCount(m_CurrentInstruction);
+    u32 baseRegisterCount = GetElementCount(m_CurrentInstruction);
+
+    // bfloat16 elements are packed two to a register, and each FPU op processes a full register.
+    if(precision == EPrecision::BFloat16)
+    {
+        baseRegisterCount = (baseRegisterCount + 1) / 2;
+    }
 
     m_DecodedInstructionData.FpuBinOp.RegisterA = registerA;
     m_DecodedInstructionData.FpuBinOp.RegisterB = registerB;
@@ -474,15 +590,15 @@ void DispatchUnit::DecodeFpuBinOp(u64& localInstructionPointer, u32& wordIndex,
     m_VectorOpIndex = 0;
 }
 
-void DispatchUnit::DispatchLdSt(const u32 replicationIndex) noexcept
+void DispatchUnit::DecodeSetFpMode(u64& localInstructionPointer, u32& wordIndex, u8 instructionBytes[4]) noexcept
 {
-    if(m_LdStAvailabilityMap == 0u)
-    {
-        m_IsStalled = true;
-        return;
-    }
+    NextInstruction(localInstructionPointer, wordIndex, instructionBytes);
 
-    u32 ldStUnit;
+    m_DecodedInstructionData.SetFpMode.Mode = instructionBytes[wordIndex];
+}
+
+bool DispatchUnit::SelectLdStUnit(u32& ldStUnit) noexcept
+{
     if((m_LdStAvailabilityMap & 0x1u) != 0)
     {
         ldStUnit = 0;
@@ -502,6 +618,18 @@ void DispatchUnit::DispatchLdSt(const u32 replicationIndex) noexcept
     else
     {
         m_IsStalled = true;
+        m_UnitStalled = true;
+        return false;
+    }
+
+    return true;
+}
+
+void DispatchUnit::DispatchLdSt(const u32 replicationIndex) noexcept
+{
+    u32 ldStUnit;
+    if(!SelectLdStUnit(ldStUnit))
+    {
         return;
     }
     
@@ -551,7 +679,7 @@ void DispatchUnit::DispatchLdSt(const u32 replicationIndex) noexcept
         }
     }
 
-    LoadStoreInstruction instruction;
+    LoadStoreInstruction instruction {};
     instruction.DispatchUnit = m_Index;
     instruction.ReadWrite = m_DecodedInstructionData.LoadStore.ReadWrite;
     instruction.IndexExponent = m_DecodedInstructionData.LoadStore.IndexExponent;
@@ -560,8 +688,90 @@ void DispatchUnit::DispatchLdSt(const u32 replicationIndex) noexcept
     instruction.IndexRegister = m_BaseRegisters[replicationIndex] + m_DecodedInstructionData.LoadStore.IndexRegister;
     instruction.TargetRegister = m_BaseRegisters[replicationIndex] + m_DecodedInstructionData.LoadStore.TargetRegister;
     instruction.Offset = m_DecodedInstructionData.LoadStore.Offset;
+    instruction.Shared = m_DecodedInstructionData.LoadStore.Shared;
+
+    // No lane of this instruction has been issued yet.
+    m_SM->DispatchLdSt(ldStUnit, instruction, m_InstructionStartPointer, m_ReplicationCompletedMask == 0);
+
+    m_ReplicationCompletedMask |= 1 << replicationIndex;
+}
+
+void DispatchUnit::DispatchAtomic(const u32 replicationIndex) noexcept
+{
+    u32 ldStUnit;
+    if(!SelectLdStUnit(ldStUnit))
+    {
+        return;
+    }
+
+    const InstructionDecodeData::AtomicData& atomic = m_DecodedInstructionData.Atomic;
+
+    // The previous value is written over the first operand, any operand registers after that are only read.
+    const u32 resultCount = atomic.Wide ? 2u : 1u;
+    const u32 operandCount = AtomicOperandCount(static_cast<EAtomicOperation>(atomic.Operation), atomic.Wide);
+
+    if(!CanReadRegister(atomic.BaseRegister, replicationIndex) || !CanReadRegister(atomic.BaseRegister + 1u, replicationIndex))
+    {
+        m_IsStalled = true;
+        return;
+    }
+
+    if(atomic.IndexExponent != 7u && !CanReadRegister(atomic.IndexRegister, replicationIndex))
+    {
+        m_IsStalled = true;
+        return;
+    }
+
+    for(u32 i = 0; i < operandCount; ++i)
+    {
+        if(i < resultCount && !CanWriteRegister(atomic.TargetRegister + i, replicationIndex))
+        {
+            m_IsStalled = true;
+            return;
+        }
+        else if(i >= resultCount && !CanReadRegister(atomic.TargetRegister + i, replicationIndex))
+        {
+            m_IsStalled = true;
+            return;
+        }
+    }
+
+    LockRegisterRead(atomic.BaseRegister, replicationIndex);
+    LockRegisterRead(atomic.BaseRegister + 1u, replicationIndex);
+
+    if(atomic.IndexExponent != 7u)
+    {
+        LockRegisterRead(atomic.IndexRegister, replicationIndex);
+    }
 
-    m_SM->DispatchLdSt(ldStUnit, instruction);
+    for(u32 i = 0; i < operandCount; ++i)
+    {
+        if(i < resultCount)
+        {
+            LockRegisterWrite(atomic.TargetRegister + i, replicationIndex);
+        }
+        else
+        {
+            LockRegisterRead(atomic.TargetRegister + i, replicationIndex);
+        }
+    }
+
+    LoadStoreInstruction instruction {};
+    instruction.DispatchUnit = m_Index;
+    instruction.ReadWrite = 1;
+    instruction.IndexExponent = atomic.IndexExponent;
+    instruction.RegisterCount = resultCount - 1;
+    instruction.Atomic = 1;
+    instruction.AtomicOperation = atomic.Operation;
+    instruction.BaseRegister = m_BaseRegisters[replicationIndex] + atomic.BaseRegister;
+    instruction.IndexRegister = m_BaseRegisters[replicationIndex] + atomic.IndexRegister;
+    instruction.TargetRegister = m_BaseRegisters[replicationIndex] + atomic.TargetRegister;
+    instruction.Wide = atomic.Wide;
+    instruction.SignedCompare = atomic.SignedCompare;
+    instruction.Offset = atomic.Offset;
+
+    // No lane of this instruction has been issued yet.
+    m_SM->DispatchLdSt(ldStUnit, instruction, m_InstructionStartPointer, m_ReplicationCompletedMask == 0);
 
     m_ReplicationCompletedMask |= 1 << replicationIndex;
 }
@@ -574,8 +784,7 @@ void DispatchUnit::DispatchLoadImmediate(const u32 replicationIndex) noexcept
         return;
     }
 
-            // TODO: FIX
-    // m_SM->SetRegister(m_BaseRegisters[replicationIndex] + m_DecodedInstructionData.LoadImmediate.Register, m_DecodedInstructionData.LoadImmediate.Value);
+    WriteRegister(m_DecodedInstructionData.LoadImmediate.Register, replicationIndex, m_DecodedInstructionData.LoadImmediate.Value);
     m_ReplicationCompletedMask |= 1 << replicationIndex;
 }
 
@@ -592,8 +801,7 @@ void DispatchUnit::DispatchLoadZero(const u32 replicationIndex) noexcept
 
     for(u32 i = 0; i < m_DecodedInstructionData.LoadZero.RegisterCount + 1u; ++i)
     {
-            // TODO: FIX
-        // m_SM->SetRegister(m_BaseRegisters[replicationIndex] + static_cast<u32>(m_DecodedInstructionData.LoadZero.StartRegister) + i, 0);
+        WriteRegister(m_DecodedInstructionData.LoadZero.StartRegister + i, replicationIndex, 0);
     }
 
     m_ReplicationCompletedMask |= 1 << replicationIndex;
@@ -625,12 +833,7 @@ void DispatchUnit::DispatchWriteStatistics(const u32 replicationIndex) noexcept
         return;
     }
 
-    u32 clockWords[2];
-    (void) ::std::memcpy(clockWords, &m_TotalIterationsTracker, sizeof(m_TotalIterationsTracker));
-
-            // TODO: FIX
-    // m_SM->SetRegister(m_BaseRegisters[replicationIndex] + m_DecodedInstructionData.WriteStatistics.ClockStartRegister, clockWords[0]);
-    // m_SM->SetRegister(m_BaseRegisters[replicationIndex] + m_DecodedInstructionData.WriteStatistics.ClockStartRegister + 1, clockWords[1]);
+    WriteRegister64(m_DecodedInstructionData.WriteStatistics.ClockStartRegister, replicationIndex, m_TotalIterationsTracker);
 
     u64 targetStatistic = 0;
     if(m_DecodedInstructionData.WriteStatistics.StatisticIndex == 0)
@@ -649,13 +852,63 @@ void DispatchUnit::DispatchWriteStatistics(const u32 replicationIndex) noexcept
     {
         targetStatistic = m_TextureSaturationTracker;
     }
+    else if(m_DecodedInstructionData.WriteStatistics.StatisticIndex == 4)
+    {
+        targetStatistic = m_StructuralStallTracker;
+    }
+    else if(m_DecodedInstructionData.WriteStatistics.StatisticIndex == 5)
+    {
+        targetStatistic = m_SM->TotalRegisterBankConflicts();
+    }
+    else if(m_DecodedInstructionData.WriteStatistics.StatisticIndex == 6)
+    {
+        targetStatistic = m_SM->LdStBankConflictStallCycles();
+    }
+    else if(m_DecodedInstructionData.WriteStatistics.StatisticIndex == 7)
+    {
+        targetStatistic = m_SM->CoreBankConflictStallCycles();
+    }
+    else if(m_DecodedInstructionData.WriteStatistics.StatisticIndex == 8)
+    {
+        targetStatistic = m_SM->CollectedRegisterReads();
+    }
+    else if(m_DecodedInstructionData.WriteStatistics.StatisticIndex == 9)
+    {
+        targetStatistic = m_SM->CorePortRegisterReads();
+    }
+    else if(m_DecodedInstructionData.WriteStatistics.StatisticIndex == 10)
+    {
+        targetStatistic = m_SM->RegisterCompactions();
+    }
+    else if(m_DecodedInstructionData.WriteStatistics.StatisticIndex == 11)
+    {
+        targetStatistic = m_SM->RegisterCompactionMovedRegisters();
+    }
+    else if(m_DecodedInstructionData.WriteStatistics.StatisticIndex == 12)
+    {
+        targetStatistic = m_SM->RegisterCompactionRecoveredAllocations();
+    }
+    else if(m_DecodedInstructionData.WriteStatistics.StatisticIndex == 13)
+    {
+        targetStatistic = m_SM->SharedMemoryBankConflicts();
+    }
+    else if(m_DecodedInstructionData.WriteStatistics.StatisticIndex >= REGISTER_BANK_STATISTIC_BASE &&
+            m_DecodedInstructionData.WriteStatistics.StatisticIndex < REGISTER_BANK_STATISTIC_BASE + RegisterFile::REGISTER_FILE_BANK_COUNT)
+    {
+        targetStatistic = m_SM->RegisterBankConflicts(m_DecodedInstructionData.WriteStatistics.StatisticIndex - REGISTER_BANK_STATISTIC_BASE);
+    }
+    else if(m_DecodedInstructionData.WriteStatistics.StatisticIndex >= OCCUPANCY_STATISTIC_BASE &&
+            m_DecodedInstructionData.WriteStatistics.StatisticIndex < OCCUPANCY_STATISTIC_BASE + WarpScheduler::OCCUPANCY_STATISTIC_COUNT)
+    {
+        targetStatistic = m_SM->OccupancyStatistic(static_cast<EOccupancyStatistic>(m_DecodedInstructionData.WriteStatistics.StatisticIndex - OCCUPANCY_STATISTIC_BASE));
+    }
+    else if(m_DecodedInstructionData.WriteStatistics.StatisticIndex >= CACHE_STATISTIC_BASE &&
+            m_DecodedInstructionData.WriteStatistics.StatisticIndex < CACHE_STATISTIC_BASE + CacheController::CACHE_STATISTIC_COUNT)
+    {
+        targetStatistic = m_SM->CacheStatistic(static_cast<ECacheStatistic>(m_DecodedInstructionData.WriteStatistics.StatisticIndex - CACHE_STATISTIC_BASE));
+    }
 
-    u32 statisticWords[2];
-    (void) ::std::memcpy(statisticWords, &targetStatistic, sizeof(targetStatistic));
-
-            // TODO: FIX
-    // m_SM->SetRegister(m_BaseRegisters[replicationIndex] + m_DecodedInstructionData.WriteStatistics.StartRegister, statisticWords[0]);
-    // m_SM->SetRegister(m_BaseRegisters[replicationIndex] + m_DecodedInstructionData.WriteStatistics.StartRegister + 1, statisticWords[1]);
+    WriteRegister64(m_DecodedInstructionData.WriteStatistics.StartRegister, replicationIndex, targetStatistic);
 
     m_ReplicationCompletedMask |= 1 << replicationIndex;
 }
@@ -670,6 +923,7 @@ void DispatchUnit::DispatchFpuBinOp(const u32 replicationIndex) noexcept
         if(m_FpAvailabilityMap == 0u && m_IntFpAvailabilityMap == 0u)
         {
             m_IsStalled = true;
+            m_UnitStalled = true;
             return;
         }
 
@@ -782,6 +1036,7 @@ void DispatchUnit::DispatchFpuBinOp(const u32 replicationIndex) noexcept
             if(fpUnit == 16)
             {
                 m_IsStalled = true;
+                m_UnitStalled = true;
                 return;
             }
         }
@@ -791,6 +1046,8 @@ void DispatchUnit::DispatchFpuBinOp(const u32 replicationIndex) noexcept
         fpuInstruction.DispatchPort = m_Index;
         fpuInstruction.Operation = EFpuOp::BasicBinOp;
         fpuInstruction.Precision = m_DecodedInstructionData.FpuBinOp.Precision;
+        fpuInstruction.FlushToZero = m_FlushToZero;
+        fpuInstruction.DenormalsAreZero = m_DenormalsAreZero;
         fpuInstruction.Reserved0 = 0;
         fpuInstruction.OperandA = m_BaseRegisters[replicationIndex] + m_DecodedInstructionData.FpuBinOp.RegisterA + registerOffset;
         fpuInstruction.OperandB = m_BaseRegisters[replicationIndex] + m_DecodedInstructionData.FpuBinOp.RegisterB + registerOffset;
@@ -799,6 +1056,7 @@ void DispatchUnit::DispatchFpuBinOp(const u32 replicationIndex) noexcept
         fpuInstruction.Reserved1 = 0;
 
         m_SM->DispatchFpu(fpUnit, fpuInstruction);
+        m_Issued = true;
 
         // Have we completed all operations for this vector.
         if(static_cast<u32>(m_VectorOpIndex) + 1 == m_DecodedInstructionData.FpuBinOp.RegisterCount)
@@ -814,6 +1072,16 @@ void DispatchUnit::DispatchFpuBinOp(const u32 replicationIndex) noexcept
     }
 }
 
+void DispatchUnit::DispatchSetFpMode(const u32 replicationIndex) noexcept
+{
+    // The mode belongs to the warp, so every replication writes the same value.
+    FpMode fpMode;
+    fpMode.Value = m_DecodedInstructionData.SetFpMode.Mode;
+    SetFpMode(fpMode);
+
+    m_ReplicationCompletedMask |= 1 << replicationIndex;
+}
+
 static u32 GetElementCount(const EInstruction instruction) noexcept
 {
     switch(instruction)
@@ -821,66 +1089,86 @@ static u32 GetElementCount(const EInstruction instruction) noexcept
         case EInstruction::AddF:
         case EInstruction::AddH:
         case EInstruction::AddD:
+        case EInstruction::AddB:
         case EInstruction::SubF:
         case EInstruction::SubH:
         case EInstruction::SubD:
+        case EInstruction::SubB:
         case EInstruction::MulF:
         case EInstruction::MulH:
         case EInstruction::MulD:
+        case EInstruction::MulB:
         case EInstruction::DivF:
         case EInstruction::DivH:
         case EInstruction::DivD:
+        case EInstruction::DivB:
         case EInstruction::RemF:
         case EInstruction::RemH:
         case EInstruction::RemD:
+        case EInstruction::RemB:
             return 1;
         case EInstruction::AddVec2F:
         case EInstruction::AddVec2H:
         case EInstruction::AddVec2D:
+        case EInstruction::AddVec2B:
         case EInstruction::SubVec2F:
         case EInstruction::SubVec2H:
         case EInstruction::SubVec2D:
+        case EInstruction::SubVec2B:
         case EInstruction::MulVec2F:
         case EInstruction::MulVec2H:
         case EInstruction::MulVec2D:
+        case EInstruction::MulVec2B:
         case EInstruction::DivVec2F:
         case EInstruction::DivVec2H:
         case EInstruction::DivVec2D:
+        case EInstruction::DivVec2B:
         case EInstruction::RemVec2F:
         case EInstruction::RemVec2H:
         case EInstruction::RemVec2D:
+        case EInstruction::RemVec2B:
             return 2;
         case EInstruction::AddVec3F:
         case EInstruction::AddVec3H:
         case EInstruction::AddVec3D:
+        case EInstruction::AddVec3B:
         case EInstruction::SubVec3F:
         case EInstruction::SubVec3H:
         case EInstruction::SubVec3D:
+        case EInstruction::SubVec3B:
         case EInstruction::MulVec3F:
         case EInstruction::MulVec3H:
         case EInstruction::MulVec3D:
+        case EInstruction::MulVec3B:
         case EInstruction::DivVec3F:
         case EInstruction::DivVec3H:
         case EInstruction::DivVec3D:
+        case EInstruction::DivVec3B:
         case EInstruction::RemVec3F:
         case EInstruction::RemVec3H:
         case EInstruction::RemVec3D:
+        case EInstruction::RemVec3B:
             return 3;
         case EInstruction::AddVec4F:
         case EInstruction::AddVec4H:
         case EInstruction::AddVec4D:
+        case EInstruction::AddVec4B:
         case EInstruction::SubVec4F:
         case EInstruction::SubVec4H:
         case EInstruction::SubVec4D:
+        case EInstruction::SubVec4B:
         case EInstruction::MulVec4F:
         case EInstruction::MulVec4H:
         case EInstruction::MulVec4D:
+        case EInstruction::MulVec4B:
         case EInstruction::DivVec4F:
         case EInstruction::DivVec4H:
         case EInstruction::DivVec4D:
+        case EInstruction::DivVec4B:
         case EInstruction::RemVec4F:
         case EInstruction::RemVec4H:
         case EInstruction::RemVec4D:
+        case EInstruction::RemVec4B:
             return 4;
         default: return 0;
     }
@@ -953,6 +1241,27 @@ static EPrecision GetElementPrecision(const EInstruction instruction) noexcept
         case EInstruction::RemVec3D:
         case EInstruction::RemVec4D:
             return EPrecision::Double;
+        case EInstruction::AddB:
+        case EInstruction::AddVec2B:
+        case EInstruction::AddVec3B:
+        case EInstruction::AddVec4B:
+        case EInstruction::SubB:
+        case EInstruction::SubVec2B:
+        case EInstruction::SubVec3B:
+        case EInstruction::SubVec4B:
+        case EInstruction::MulB:
+        case EInstruction::MulVec2B:
+        case EInstruction::MulVec3B:
+        case EInstruction::MulVec4B:
+        case EInstruction::DivB:
+        case EInstruction::DivVec2B:
+        case EInstruction::DivVec3B:
+        case EInstruction::DivVec4B:
+        case EInstruction::RemB:
+        case EInstruction::RemVec2B:
+        case EInstruction::RemVec3B:
+        case EInstruction::RemVec4B:
+            return EPrecision::BFloat16;
         default: return EPrecision::Single;
     }
 }
@@ -970,9 +1279,13 @@ static EBinOp GetElementOperation(const EInstruction instruction) noexcept
         case EInstruction::AddVec3H:
         case EInstruction::AddVec4H:
         case EInstruction::AddD:
+        case EInstruction::AddB:
         case EInstruction::AddVec2D:
+        case EInstruction::AddVec2B:
         case EInstruction::AddVec3D:
+        case EInstruction::AddVec3B:
         case EInstruction::AddVec4D:
+        case EInstruction::AddVec4B:
             return EBinOp::Add;
         case EInstruction::SubF:
         case EInstruction::SubVec2F:
@@ -983,9 +1296,13 @@ static EBinOp GetElementOperation(const EInstruction instruction) noexcept
         case EInstruction::SubVec3H:
         case EInstruction::SubVec4H:
         case EInstruction::SubD:
+        case EInstruction::SubB:
         case EInstruction::SubVec2D:
+        case EInstruction::SubVec2B:
         case EInstruction::SubVec3D:
+        case EInstruction::SubVec3B:
         case EInstruction::SubVec4D:
+        case EInstruction::SubVec4B:
             return EBinOp::Subtract;
         case EInstruction::MulF:
         case EInstruction::MulVec2F:
@@ -996,9 +1313,13 @@ static EBinOp GetElementOperation(const EInstruction instruction) noexcept
         case EInstruction::MulVec3H:
         case EInstruction::MulVec4H:
         case EInstruction::MulD:
+        case EInstruction::MulB:
         case EInstruction::MulVec2D:
+        case EInstruction::MulVec2B:
         case EInstruction::MulVec3D:
+        case EInstruction::MulVec3B:
         case EInstruction::MulVec4D:
+        case EInstruction::MulVec4B:
             return EBinOp::Multiply;
         case EInstruction::DivF:
         case EInstruction::DivVec2F:
@@ -1009,9 +1330,13 @@ static EBinOp GetElementOperation(const EInstruction instruction) noexcept
         case EInstruction::DivVec3H:
         case EInstruction::DivVec4H:
         case EInstruction::DivD:
+        case EInstruction::DivB:
         case EInstruction::DivVec2D:
+        case EInstruction::DivVec2B:
         case EInstruction::DivVec3D:
+        case EInstruction::DivVec3B:
         case EInstruction::DivVec4D:
+        case EInstruction::DivVec4B:
             return EBinOp::Divide;
         case EInstruction::RemF:
         case EInstruction::RemVec2F:
@@ -1022,9 +1347,13 @@ static EBinOp GetElementOperation(const EInstruction instruction) noexcept
         case EInstruction::RemVec3H:
         case EInstruction::RemVec4H:
         case EInstruction::RemD:
+        case EInstruction::RemB:
         case EInstruction::RemVec2D:
+        case EInstruction::RemVec2B:
         case EInstruction::RemVec3D:
+        case EInstruction::RemVec3B:
         case EInstruction::RemVec4D:
+        case EInstruction::RemVec4B:
             return EBinOp::Remainder;
         default: return EBinOp::Add;
     }
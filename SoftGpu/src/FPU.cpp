@@ -16,6 +16,7 @@
 #include <cstring>
 #include <limits>
 #include <cmath>
+#include <bit>
 
 #if !HAS_X86_INTRINSICS
 #define _MM_FROUND_TO_NEAREST_INT 0x00
@@ -252,6 +253,108 @@ u16 _cvtss_sh(const f32 f, int) noexcept
 
 #endif
 
+// Replaces a denormal with a zero of the same sign, the value is in the encoding of the given precision.
+[[nodiscard]] static u64 FlushDenormal(const EPrecision precision, const u64 value) noexcept
+{
+    switch(precision)
+    {
+        case EPrecision::Single:
+            return (value & 0x7F800000) == 0 ? (value & 0x80000000) : value;
+        case EPrecision::Half:
+            return (value & 0x7C00) == 0 ? (value & 0x8000) : value;
+        case EPrecision::Double:
+            return (value & 0x7FF0000000000000) == 0 ? (value & 0x8000000000000000) : value;
+        case EPrecision::BFloat16:
+        {
+            u64 flushed = value;
+
+            for(u32 lane = 0; lane < 2; ++lane)
+            {
+                const u64 exponentMask = 0x7F80ull << (lane * 16);
+                const u64 mantissaMask = 0x007Full << (lane * 16);
+
+                if((value & exponentMask) == 0)
+                {
+                    flushed &= ~mantissaMask;
+                }
+            }
+
+            return flushed;
+        }
+        default:
+            return value;
+    }
+}
+
+// DAZ only applies to the floating point operands, the rounding mode, the negate/abs mask, and the binary op selector are left alone.
+static void FlushDenormalOperands(LoadedFpuInstruction* const instructionInfo) noexcept
+{
+    switch(instructionInfo->Operation)
+    {
+        case EFpuOp::Fma:
+            instructionInfo->OperandC = FlushDenormal(instructionInfo->Precision, instructionInfo->OperandC);
+            [[fallthrough]];
+        case EFpuOp::BasicBinOp:
+        case EFpuOp::Compare:
+            instructionInfo->OperandB = FlushDenormal(instructionInfo->Precision, instructionInfo->OperandB);
+            [[fallthrough]];
+        case EFpuOp::Round:
+            instructionInfo->OperandA = FlushDenormal(instructionInfo->Precision, instructionInfo->OperandA);
+            break;
+        default:
+            break;
+    }
+}
+
+// FTZ is applied to the result after it has been rounded to the destination format. Compare flags are not floats.
+[[nodiscard]] static u64 FlushResult(const LoadedFpuInstruction& instructionInfo, const u64 result) noexcept
+{
+    if(!instructionInfo.FlushToZero || instructionInfo.Operation == EFpuOp::Compare)
+    {
+        return result;
+    }
+
+    return FlushDenormal(instructionInfo.Precision, result);
+}
+
+#if HAS_X86_INTRINSICS
+
+// Puts the host into the same denormal mode as the instruction for the duration of its execution.
+//
+// This avoids the microcode assists x86 takes on denormals. The architectural FTZ rule is the SSE one, tininess
+// is detected after rounding, so single and double results come straight from the host. Half and bfloat16 are
+// rounded in software and are flushed by FlushResult. Hosts without SSE fall back to FlushResult for everything,
+// which differs only for results that round up to the smallest normal. MXCSR is only touched when a mode is
+// enabled, so the common case costs a single branch.
+class HostDenormalModeScope final
+{
+    DELETE_CM(HostDenormalModeScope);
+public:
+    HostDenormalModeScope(const bool flushToZero, const bool denormalsAreZero) noexcept
+        : m_SavedCsr(0)
+        , m_Active(flushToZero || denormalsAreZero)
+    {
+        if(m_Active)
+        {
+            m_SavedCsr = _mm_getcsr();
+            _mm_setcsr(m_SavedCsr | (flushToZero ? _MM_FLUSH_ZERO_ON : 0) | (denormalsAreZero ? _MM_DENORMALS_ZERO_ON : 0));
+        }
+    }
+
+    ~HostDenormalModeScope() noexcept
+    {
+        if(m_Active)
+        {
+            _mm_setcsr(m_SavedCsr);
+        }
+    }
+private:
+    u32 m_SavedCsr;
+    bool m_Active;
+};
+
+#endif
+
 void Fpu::Clock() noexcept
 {
     if(m_ExecutionStage == 0)
@@ -266,11 +369,21 @@ void Fpu::Clock() noexcept
     --m_ExecutionStage;
 }
 
-void Fpu::ExecuteInstruction(const LoadedFpuInstruction instructionInfo) noexcept
+void Fpu::ExecuteInstruction(LoadedFpuInstruction instructionInfo) noexcept
 {
     m_DispatchPort = instructionInfo.DispatchPort;
     m_StorageRegister = instructionInfo.StorageRegister;
-    
+    m_ExecutionStage = m_TimingTable->Lookup(instructionInfo.Operation, instructionInfo.Precision, instructionInfo.OperandC).Latency;
+
+    if(instructionInfo.DenormalsAreZero)
+    {
+        FlushDenormalOperands(&instructionInfo);
+    }
+
+#if HAS_X86_INTRINSICS
+    const HostDenormalModeScope hostDenormalMode(instructionInfo.FlushToZero, instructionInfo.DenormalsAreZero);
+#endif
+
     if(instructionInfo.Precision == EPrecision::Single)
     {
         m_StorageRegisterCount = 1;
@@ -333,7 +446,7 @@ void Fpu::ExecuteInstruction(const LoadedFpuInstruction instructionInfo) noexcep
         u32 resultU;
         (void) ::std::memcpy(&resultU, &result, sizeof(result));
 
-        m_Core->PrepareRegisterWrite(false, instructionInfo.StorageRegister, resultU);
+        m_Core->PrepareRegisterWrite(false, instructionInfo.StorageRegister, FlushResult(instructionInfo, resultU));
     }
     else if(instructionInfo.Precision == EPrecision::Half)
     {
@@ -388,7 +501,7 @@ void Fpu::ExecuteInstruction(const LoadedFpuInstruction instructionInfo) noexcep
             case EFpuOp::Round:
             {
                 const u16 resultU = RoundF16(static_cast<ERoundingMode>(instructionInfo.OperandB), valueA);
-                m_Core->PrepareRegisterWrite(false, instructionInfo.StorageRegister, resultU);
+                m_Core->PrepareRegisterWrite(false, instructionInfo.StorageRegister, FlushResult(instructionInfo, resultU));
                 return;
             }
             default:
@@ -397,7 +510,7 @@ void Fpu::ExecuteInstruction(const LoadedFpuInstruction instructionInfo) noexcep
         }
 
         const u32 resultU = _cvtss_sh(result, _MM_FROUND_CUR_DIRECTION);
-        m_Core->PrepareRegisterWrite(false, instructionInfo.StorageRegister, resultU);
+        m_Core->PrepareRegisterWrite(false, instructionInfo.StorageRegister, FlushResult(instructionInfo, resultU));
     }
     else if(instructionInfo.Precision == EPrecision::Double)
     {
@@ -461,7 +574,67 @@ void Fpu::ExecuteInstruction(const LoadedFpuInstruction instructionInfo) noexcep
         u64 resultU;
         ::std::memcpy(&resultU, &result, sizeof(result));
 
-        m_Core->PrepareRegisterWrite(true, instructionInfo.StorageRegister, resultU);
+        m_Core->PrepareRegisterWrite(true, instructionInfo.StorageRegister, FlushResult(instructionInfo, resultU));
+    }
+    else if(instructionInfo.Precision == EPrecision::BFloat16)
+    {
+        // Both packed elements are computed in the same pass, each one goes through single precision and is rounded back.
+        m_StorageRegisterCount = 1;
+
+        if(instructionInfo.Operation == EFpuOp::NegateAbs)
+        {
+            const u32 result = NegateAbsBF16x2(static_cast<u32>(instructionInfo.OperandA), instructionInfo.OperandB);
+            m_Core->PrepareRegisterWrite(false, instructionInfo.StorageRegister, result);
+            return;
+        }
+
+        u32 packedResult = 0;
+
+        for(u32 lane = 0; lane < 2; ++lane)
+        {
+            const f32 valueA = ::std::bit_cast<f32>(BFloat16ToFloat32(UnpackBFloat16(static_cast<u32>(instructionInfo.OperandA), lane)));
+
+            u16 result;
+
+            switch(instructionInfo.Operation)
+            {
+                case EFpuOp::BasicBinOp:
+                {
+                    const f32 valueB = ::std::bit_cast<f32>(BFloat16ToFloat32(UnpackBFloat16(static_cast<u32>(instructionInfo.OperandB), lane)));
+                    const f32 resultF = BasicBinOpF32(valueA, valueB, static_cast<EBinOp>(instructionInfo.OperandC));
+                    result = Float32ToBFloat16(::std::bit_cast<u32>(resultF));
+                    break;
+                }
+                case EFpuOp::Fma:
+                {
+                    const f32 valueB = ::std::bit_cast<f32>(BFloat16ToFloat32(UnpackBFloat16(static_cast<u32>(instructionInfo.OperandB), lane)));
+                    const f32 valueC = ::std::bit_cast<f32>(BFloat16ToFloat32(UnpackBFloat16(static_cast<u32>(instructionInfo.OperandC), lane)));
+                    result = FmaBF16(valueA, valueB, valueC);
+                    break;
+                }
+                case EFpuOp::Compare:
+                {
+                    // The compare flags for each element are placed in its own half of the register.
+                    const f32 valueB = ::std::bit_cast<f32>(BFloat16ToFloat32(UnpackBFloat16(static_cast<u32>(instructionInfo.OperandB), lane)));
+                    result = static_cast<u16>(CompareF32(valueA, valueB));
+                    break;
+                }
+                case EFpuOp::Round:
+                {
+                    // Any integer a bfloat16 rounds to is representable as a bfloat16, so this does not round twice.
+                    const f32 resultF = RoundF32(static_cast<ERoundingMode>(instructionInfo.OperandB), valueA);
+                    result = Float32ToBFloat16(::std::bit_cast<u32>(resultF));
+                    break;
+                }
+                default:
+                    result = Float32ToBFloat16(::std::bit_cast<u32>(::std::numeric_limits<f32>::quiet_NaN()));
+                    break;
+            }
+
+            packedResult |= static_cast<u32>(result) << (lane * 16);
+        }
+
+        m_Core->PrepareRegisterWrite(false, instructionInfo.StorageRegister, FlushResult(instructionInfo, packedResult));
     }
 }
 
@@ -470,22 +643,16 @@ f32 Fpu::BasicBinOpF32(const f32 valueA, const f32 valueB, const EBinOp op) noex
     switch(op)
     {
         case EBinOp::Add:
-            m_ExecutionStage = 4;
             return valueA + valueB;
         case EBinOp::Subtract:
-            m_ExecutionStage = 4;
             return valueA - valueB;
         case EBinOp::Multiply:
-            m_ExecutionStage = 5;
             return valueA * valueB;
         case EBinOp::Divide:
-            m_ExecutionStage = 6;
             return valueA / valueB;
         case EBinOp::Remainder:
-            m_ExecutionStage = 6;
             return ::std::fmod(valueA, valueB);
         default:
-            m_ExecutionStage = 1;
             return ::std::numeric_limits<f32>::quiet_NaN();
     }
 }
@@ -495,30 +662,22 @@ f64 Fpu::BasicBinOpF64(const f64 valueA, const f64 valueB, const EBinOp op) noex
     switch(op)
     {
         case EBinOp::Add:
-            m_ExecutionStage = 8;
             return valueA + valueB;
         case EBinOp::Subtract:
-            m_ExecutionStage = 8;
             return valueA - valueB;
         case EBinOp::Multiply:
-            m_ExecutionStage = 10;
             return valueA * valueB;
         case EBinOp::Divide:
-            m_ExecutionStage = 12;
             return valueA / valueB;
         case EBinOp::Remainder:
-            m_ExecutionStage = 12;
             return ::std::fmod(valueA, valueB);
         default:
-            m_ExecutionStage = 1;
             return ::std::numeric_limits<f64>::quiet_NaN();
     }
 }
 
 f32 Fpu::FmaF32(const f32 valueA, const f32 valueB, const f32 valueC) noexcept
 {
-    m_ExecutionStage = 10;
-
 #if HAS_X86_INTRINSICS
     const __m128 valueAV = _mm_set_ss(valueA);
     const __m128 valueBV = _mm_set_ss(valueB);
@@ -534,8 +693,6 @@ f32 Fpu::FmaF32(const f32 valueA, const f32 valueB, const f32 valueC) noexcept
 
 f64 Fpu::FmaF64(const f64 valueA, const f64 valueB, const f64 valueC) noexcept
 {
-    m_ExecutionStage = 20;
-
 #if HAS_X86_INTRINSICS
     const __m128d valueAV = _mm_set_sd(valueA);
     const __m128d valueBV = _mm_set_sd(valueB);
@@ -549,10 +706,46 @@ f64 Fpu::FmaF64(const f64 valueA, const f64 valueB, const f64 valueC) noexcept
 #endif
 }
 
-f32 Fpu::RoundF32(const ERoundingMode ERoundingMode, const f32 value) noexcept
+// Rounding the fused result to single precision and then to bfloat16 can round twice, a sum just past a bfloat16 tie
+// can land on the tie in single precision and then round to even. Instead the sum is rounded to odd at each wider
+// precision, which keeps an inexact result off the tie, so the final round to nearest is the only rounding. The
+// product of two bfloat16s is exact in double precision, and the rounding error of the sum is recovered exactly.
+u16 Fpu::FmaBF16(const f32 valueA, const f32 valueB, const f32 valueC) noexcept
 {
-    m_ExecutionStage = 4;
+    const f64 product = static_cast<f64>(valueA) * static_cast<f64>(valueB);
+    f64 sum = product + static_cast<f64>(valueC);
+
+    if(!::std::isfinite(sum))
+    {
+        return Float32ToBFloat16(::std::bit_cast<u32>(static_cast<f32>(sum)));
+    }
+
+    // The part of the exact sum which was rounded off.
+    const f64 productPart = sum - static_cast<f64>(valueC);
+    const f64 error = (product - productPart) + (static_cast<f64>(valueC) - (sum - productPart));
 
+    if(error != 0.0 && (::std::bit_cast<u64>(sum) & 0x1) == 0)
+    {
+        sum = ::std::nextafter(sum, error > 0.0 ? ::std::numeric_limits<f64>::infinity() : -::std::numeric_limits<f64>::infinity());
+    }
+
+    f32 result = static_cast<f32>(sum);
+
+    if(::std::isinf(result))
+    {
+        // The largest finite single has an odd significand, so it still rounds to infinity as a bfloat16.
+        result = ::std::copysign(::std::numeric_limits<f32>::max(), result);
+    }
+    else if(static_cast<f64>(result) != sum && (::std::bit_cast<u32>(result) & 0x1) == 0)
+    {
+        result = ::std::nextafter(result, sum < static_cast<f64>(result) ? -::std::numeric_limits<f32>::infinity() : ::std::numeric_limits<f32>::infinity());
+    }
+
+    return Float32ToBFloat16(::std::bit_cast<u32>(result));
+}
+
+f32 Fpu::RoundF32(const ERoundingMode ERoundingMode, const f32 value) noexcept
+{
     switch(ERoundingMode)
     {
         case ERoundingMode::Truncate: return ::std::trunc(value);
@@ -565,8 +758,6 @@ f32 Fpu::RoundF32(const ERoundingMode ERoundingMode, const f32 value) noexcept
 
 u16 Fpu::RoundF16(const ERoundingMode ERoundingMode, const f32 value) noexcept
 {
-    m_ExecutionStage = 3;
-
     switch(ERoundingMode)
     {
         case ERoundingMode::Truncate:
@@ -605,8 +796,6 @@ u16 Fpu::RoundF16(const ERoundingMode ERoundingMode, const f32 value) noexcept
 
 f64 Fpu::RoundF64(const ERoundingMode ERoundingMode, const f64 value) noexcept
 {
-    m_ExecutionStage = 5;
-
     switch(ERoundingMode)
     {
         case ERoundingMode::Truncate: return ::std::trunc(value);
@@ -619,7 +808,6 @@ f64 Fpu::RoundF64(const ERoundingMode ERoundingMode, const f64 value) noexcept
 
 u32 Fpu::CompareF32(const f32 valueA, const f32 valueB) noexcept
 {
-    m_ExecutionStage = 4;
     CompareFlags result;
     result.Pad = 0;
 
@@ -646,7 +834,6 @@ u32 Fpu::CompareF32(const f32 valueA, const f32 valueB) noexcept
 
 u32 Fpu::CompareF64(const f64 valueA, const f64 valueB) noexcept
 {
-    m_ExecutionStage = 8;
     CompareFlags result;
     result.Pad = 0;
 
@@ -673,18 +860,20 @@ u32 Fpu::CompareF64(const f64 valueA, const f64 valueB) noexcept
 
 u32 Fpu::NegateAbsF32(u32 value, bool isAbs) noexcept
 {
-    m_ExecutionStage = 1;
     return isAbs ? value & 0x7FFFFFFF : value ^ 0x80000000;
 }
 
 u32 Fpu::NegateAbsF16(u32 value, bool isAbs) noexcept
 {
-    m_ExecutionStage = 1;
     return isAbs ? value & 0x7FFF : value ^ 0x8000;
 }
 
 u64 Fpu::NegateAbsF64(u64 value, bool isAbs) noexcept
 {
-    m_ExecutionStage = 1;
     return isAbs ? value & 0x7FFFFFFFFFFFFFFF : value ^ 0x8000000000000000;
 }
+
+u32 Fpu::NegateAbsBF16x2(u32 value, bool isAbs) noexcept
+{
+    return isAbs ? value & 0x7FFF7FFF : value ^ 0x80008000;
+}
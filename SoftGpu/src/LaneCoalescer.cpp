@@ -0,0 +1,82 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#include "LaneCoalescer.hpp"
+
+void LaneCoalescer::BeginGroup(const u32 dispatchPort, const u32 group) noexcept
+{
+    Group& target = m_Groups[dispatchPort];
+
+    for(Line& line : target.Lines)
+    {
+        line.Valid = false;
+    }
+
+    target.Sequence = group;
+    target.Active = true;
+}
+
+const LaneCoalescer::Line* LaneCoalescer::Find(const u32 dispatchPort, const u32 group, const u64 address, const bool loaded) noexcept
+{
+    const Group& target = m_Groups[dispatchPort];
+
+    if(group == NO_GROUP || !target.Active || target.Sequence != group)
+    {
+        return nullptr;
+    }
+
+    const u64 lineAddress = address & ~static_cast<u64>(LINE_WORD_COUNT - 1);
+
+    for(const Line& line : target.Lines)
+    {
+        if(line.Valid && line.Loaded == loaded && line.VirtualAddress == lineAddress)
+        {
+            ++m_MergedLines;
+            return &line;
+        }
+    }
+
+    return nullptr;
+}
+
+LaneCoalescer::Line* LaneCoalescer::Record(const u32 dispatchPort, const u32 group, const u64 address) noexcept
+{
+    Group& target = m_Groups[dispatchPort];
+
+    if(group == NO_GROUP || !target.Active || target.Sequence != group)
+    {
+        return nullptr;
+    }
+
+    for(Line& line : target.Lines)
+    {
+        if(!line.Valid)
+        {
+            line.VirtualAddress = address & ~static_cast<u64>(LINE_WORD_COUNT - 1);
+            line.Valid = true;
+            return &line;
+        }
+    }
+
+    return nullptr;
+}
+
+void LaneCoalescer::InvalidatePhysical(const u64 physicalAddress, const bool external) noexcept
+{
+    const u64 lineAddress = physicalAddress & ~static_cast<u64>(LINE_WORD_COUNT - 1);
+
+    for(Group& group : m_Groups)
+    {
+        for(Line& line : group.Lines)
+        {
+            // A store group's own lines are never loaded, so they stay for its later lanes.
+            if(line.Valid && line.Loaded && line.External == external && line.PhysicalAddress == lineAddress)
+            {
+                line.Valid = false;
+            }
+        }
+    }
+}
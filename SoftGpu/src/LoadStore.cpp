@@ -7,485 +7,517 @@
 #include "LoadStore.hpp"
 #include "StreamingMultiprocessor.hpp"
 
-void LoadStore::PipelineReadBaseRegister() noexcept
+#include <cassert>
+
+bool LoadStore::WaitForRegisterPort() noexcept
 {
-    RegisterFile::CommandPacket packetHigh;
-    packetHigh.Command = RegisterFile::ECommand::ReadRegister;
-    packetHigh.Successful = &m_SuccessfulHigh;
-    packetHigh.Unsuccessful = &m_UnsuccessfulHigh;
+    if(!m_SM->IsRegisterPortStalled(m_UnitIndex))
+    {
+        return false;
+    }
 
-    RegisterFile::CommandPacket packetLow;
-    packetLow.Command = RegisterFile::ECommand::ReadRegister;
-    packetLow.Successful = &m_SuccessfulLow;
-    packetLow.Unsuccessful = &m_UnsuccessfulLow;
+    ++m_BankConflictStallCycles;
+    return true;
+}
 
-    // Does the base register start at high?
-    if(m_Instruction.BaseRegister & 0x1)
-    {
-        packetHigh.TargetRegister = (m_Instruction.BaseRegister + 1u) >> 1u;
-        packetLow.TargetRegister = (m_Instruction.BaseRegister + 1u) >> 1u;
+void LoadStore::InvokeRegister(const RegisterFile::ECommand command, const u32 registerIndex, u32* const value) noexcept
+{
+    RegisterFile::CommandPacket packet {};
+    packet.Command = command;
+    // The port half selects the low bit of the register.
+    packet.TargetRegister = static_cast<u16>(registerIndex >> 1);
+    packet.Value = value;
 
-        packetHigh.Value = &m_BaseAddressLow;
-        packetLow.Value = &m_BaseAddressHigh;
+    if(registerIndex & 0x1)
+    {
+        m_SuccessfulHigh = false;
+        m_UnsuccessfulHigh = false;
+        packet.Successful = &m_SuccessfulHigh;
+        packet.Unsuccessful = &m_UnsuccessfulHigh;
+        m_SM->InvokeRegisterFileHigh(m_UnitIndex, packet);
     }
-    // The base register starts at low
     else
     {
-        packetHigh.TargetRegister = m_Instruction.BaseRegister >> 1u;
-        packetLow.TargetRegister = m_Instruction.BaseRegister >> 1u;
-
-        packetHigh.Value = &m_BaseAddressHigh;
-        packetLow.Value = &m_BaseAddressLow;
+        m_SuccessfulLow = false;
+        m_UnsuccessfulLow = false;
+        packet.Successful = &m_SuccessfulLow;
+        packet.Unsuccessful = &m_UnsuccessfulLow;
+        m_SM->InvokeRegisterFileLow(m_UnitIndex, packet);
     }
+}
+
+void LoadStore::ReadBaseRegister() noexcept
+{
+    // The base address is a pair of registers, one of them is always in the high half and the other in the low half.
+    InvokeRegister(RegisterFile::ECommand::ReadRegister, m_Instruction.BaseRegister, &m_BaseAddressLow);
+    InvokeRegister(RegisterFile::ECommand::ReadRegister, m_Instruction.BaseRegister + 1u, &m_BaseAddressHigh);
+
+    m_Stage = EStage::ReleaseBaseRegister;
+}
+
+void LoadStore::ReleaseBaseRegister() noexcept
+{
+    InvokeRegister(RegisterFile::ECommand::Unlock, m_Instruction.BaseRegister, nullptr);
+    InvokeRegister(RegisterFile::ECommand::Unlock, m_Instruction.BaseRegister + 1u, nullptr);
 
-    m_SM->InvokeRegisterFileHigh(m_UnitIndex, packetHigh);
-    m_SM->InvokeRegisterFileLow(m_UnitIndex, packetLow);
+    // If the exponent is 111 then ignore the indexing register.
+    m_Stage = m_Instruction.IndexExponent == 7u ? EStage::AccessMemory : EStage::ReadIndexRegister;
 }
 
-void LoadStore::PipelineReleaseReadLockBaseRegister() noexcept
+void LoadStore::ReadIndexRegister() noexcept
 {
-    if((!m_SuccessfulHigh && !m_UnsuccessfulHigh) || (!m_SuccessfulLow && !m_UnsuccessfulLow))
+    InvokeRegister(RegisterFile::ECommand::ReadRegister, m_Instruction.IndexRegister, &m_IndexRegister);
+
+    m_Stage = EStage::ReleaseIndexRegister;
+}
+
+void LoadStore::ReleaseIndexRegister() noexcept
+{
+    m_Address += static_cast<u64>(m_IndexRegister) << static_cast<u32>(m_Instruction.IndexExponent);
+
+    InvokeRegister(RegisterFile::ECommand::Unlock, m_Instruction.IndexRegister, nullptr);
+
+    m_Stage = EStage::AccessMemory;
+}
+
+void LoadStore::AccessMemory() noexcept
+{
+    const u64 address = m_Address + static_cast<u64>(static_cast<i64>(m_Instruction.Offset));
+
+    // A load can't pass an older store to the same words, stores wait in WriteMemory instead.
+    if(!m_Instruction.ReadWrite && m_SM->IsAccessBlocked(m_UnitIndex, m_Sequence, true, m_Instruction.Shared, address, m_Instruction.RegisterCount + 1u))
     {
-        // Unit hasn't run yet, this can't actually happen in software.
-        --m_ExecutionStage;
+        ++m_OrderingStallCycles;
+        return;
     }
 
-    // If we failed to read, just go back a stage.
-    if(!m_UnsuccessfulHigh || !m_UnsuccessfulLow)
+    if(m_Instruction.Shared && !m_Instruction.ReadWrite)
     {
-        --m_ExecutionStage;
+        LoadShared(address);
+        return;
     }
 
-    RegisterFile::CommandPacket packetHigh;
-    packetHigh.Command = RegisterFile::ECommand::Unlock;
-    packetHigh.Value = nullptr;
-    packetHigh.Successful = &m_SuccessfulHigh;
-    packetHigh.Unsuccessful = &m_UnsuccessfulHigh;
+    m_Address = address;
 
-    RegisterFile::CommandPacket packetLow;
-    packetLow.Command = RegisterFile::ECommand::Unlock;
-    packetLow.Value = nullptr;
-    packetLow.Successful = &m_SuccessfulHigh;
-    packetLow.Unsuccessful = &m_UnsuccessfulHigh;
+    m_CurrentRegister = 0;
 
-    // Does the base register start at high?
-    if(m_Instruction.BaseRegister & 0x1)
+    if(m_Instruction.Atomic)
     {
-        packetHigh.TargetRegister = (m_Instruction.BaseRegister + 1u) >> 1u;
-        packetLow.TargetRegister = (m_Instruction.BaseRegister + 1u) >> 1u;
+        // 64 bit atomics are aligned to a pair of words, so they never straddle a line.
+        m_Address &= ~static_cast<u64>(m_Instruction.Wide);
+
+        ++m_Atomics;
+        m_Stage = EStage::ReadAtomicOperand;
+        return;
     }
-    // The base register starts at low
-    else
+
+    if(m_Instruction.Shared)
     {
-        packetHigh.TargetRegister = m_Instruction.BaseRegister >> 1u;
-        packetLow.TargetRegister = m_Instruction.BaseRegister >> 1u;
+        ++m_SharedStores;
+        m_Stage = EStage::StoreRegister;
+        return;
     }
 
-    m_SM->InvokeRegisterFileHigh(m_UnitIndex, packetHigh);
-    m_SM->InvokeRegisterFileLow(m_UnitIndex, packetLow);
-    
-}
+    // Being able to read up to 8 registers we can be in at most be in two cache lines.
+    const u64 maxAddress = m_Address + m_Instruction.RegisterCount;
 
-// void LoadStore::Pipeline0() noexcept
-// {
-//     RegisterFile::CommandPacket packet;
-//     packet.Command = RegisterFile::ECommand::ReadRegister;
-//     packet.TargetRegister = m_Instruction.BaseRegister;
-//     packet.Value = &m_BaseAddressLow;
-//     packet.Successful = &m_SuccessfulHigh;
-//     packet.Unsuccessful = &m_UnsuccessfulHigh;
-//
-//     m_SM->InvokeRegisterFile(m_UnitIndex, packet);
-// }
-//
-// void LoadStore::Pipeline1() noexcept
-// {
-//     if(!m_SuccessfulHigh && !m_UnsuccessfulHigh)
-//     {
-//         // Unit hasn't run yet, this can't actually happen in software.
-//         --m_ExecutionStage;
-//     }
-//
-//     // If we failed to read, just go back a stage.
-//     if(!m_UnsuccessfulHigh)
-//     {
-//         --m_ExecutionStage;
-//     }
-//
-//     RegisterFile::CommandPacket packet;
-//     packet.Command = RegisterFile::ECommand::Unlock;
-//     packet.TargetRegister = m_Instruction.BaseRegister;
-//     packet.Value = nullptr;
-//     packet.Successful = &m_SuccessfulHigh;
-//     packet.Unsuccessful = &m_UnsuccessfulHigh;
-//
-//     m_SM->InvokeRegisterFile(m_UnitIndex, packet);
-// }
-//
-// void LoadStore::Pipeline2() noexcept
-// {
-//     if(!m_SuccessfulHigh && !m_UnsuccessfulHigh)
-//     {
-//         // Unit hasn't run yet, this can't actually happen in software.
-//         --m_ExecutionStage;
-//     }
-//
-//     // If we failed to read, just go back a stage.
-//     if(!m_UnsuccessfulHigh)
-//     {
-//         --m_ExecutionStage;
-//     }
-//
-//     RegisterFile::CommandPacket packet;
-//     packet.Command = RegisterFile::ECommand::ReadRegister;
-//     packet.TargetRegister = m_Instruction.BaseRegister + 1u;
-//     packet.Value = &m_BaseAddressHigh;
-//     packet.Successful = &m_SuccessfulHigh;
-//     packet.Unsuccessful = &m_UnsuccessfulHigh;
-//
-//     m_SM->InvokeRegisterFile(m_UnitIndex, packet);
-// }
-//
-// void LoadStore::Pipeline3() noexcept
-// {
-//     if(!m_SuccessfulHigh && !m_UnsuccessfulHigh)
-//     {
-//         // Unit hasn't run yet, this can't actually happen in software.
-//         --m_ExecutionStage;
-//     }
-//
-//     // If we failed to read, just go back a stage.
-//     if(!m_UnsuccessfulHigh)
-//     {
-//         --m_ExecutionStage;
-//     }
-//
-//     RegisterFile::CommandPacket packet;
-//     packet.Command = RegisterFile::ECommand::Unlock;
-//     packet.TargetRegister = m_Instruction.BaseRegister + 1u;
-//     packet.Value = nullptr;
-//     packet.Successful = &m_SuccessfulHigh;
-//     packet.Unsuccessful = &m_UnsuccessfulHigh;
-//
-//     m_SM->InvokeRegisterFile(m_UnitIndex, packet);
-// }
-
-void LoadStore::Pipeline4() noexcept
-{
-    if(!m_SuccessfulHigh && !m_UnsuccessfulHigh)
+    if(m_Address / GpuPageWordCount != maxAddress / GpuPageWordCount)
     {
-        // Unit hasn't run yet, this can't actually happen in software.
-        --m_ExecutionStage;
+        ++m_PageCrossings;
     }
 
-    // If we failed to read, just go back a stage.
-    if(!m_UnsuccessfulHigh)
+    if(m_Instruction.ReadWrite)
     {
-        --m_ExecutionStage;
+        ++m_Stores;
+        m_Stage = EStage::StoreRegister;
+        return;
     }
 
-    RegisterFile::CommandPacket resetPacket {};
-    resetPacket.Command = RegisterFile::ECommand::Reset;
-    resetPacket.TargetRegister = 0;
-    resetPacket.Value = nullptr;
-    resetPacket.Successful = nullptr;
-    resetPacket.Unsuccessful = nullptr;
+    ++m_Loads;
 
-    // If the exponent is 111 then ignore the indexing register.
-    if(m_Instruction.IndexExponent == 7u)
+    // The lower 3 bits are just the index into the cache line.
+    const bool crossesLine = (m_Address >> 3) != (maxAddress >> 3);
+
+    // Earlier entries on any unit have already pulled their lines into the L0, so check whether they're still on their way first.
+    u32 waitClocks = m_SM->PendingLineWait(m_Address);
+
+    if(crossesLine)
     {
-        m_SM->InvokeRegisterFileHigh(m_UnitIndex, resetPacket);
-        m_SM->InvokeRegisterFileLow(m_UnitIndex, resetPacket);
-        return;
+        const u32 secondLineWait = m_SM->PendingLineWait(maxAddress);
+        waitClocks = secondLineWait > waitClocks ? secondLineWait : waitClocks;
     }
 
-    RegisterFile::CommandPacket packet {};
-    packet.Command = RegisterFile::ECommand::ReadRegister;
-    packet.TargetRegister = m_Instruction.IndexRegister;
-    packet.Value = &m_IndexRegister;
-    packet.Successful = &m_SuccessfulHigh;
-    packet.Unsuccessful = &m_UnsuccessfulHigh;
+    const bool hit = m_SM->IsCached(m_Address) && (!crossesLine || m_SM->IsCached(maxAddress));
 
-    if(m_Instruction.IndexRegister & 0x1)
+    // Both lines are requested together, so a miss only costs the latency once.
+    if(!hit)
     {
-        m_SM->InvokeRegisterFileHigh(m_UnitIndex, packet);
-        m_SM->InvokeRegisterFileLow(m_UnitIndex, resetPacket);
+        ++m_LoadMisses;
+
+        u32 missWait = LineMissWait(m_Address);
+
+        if(crossesLine)
+        {
+            const u32 secondLineMissWait = LineMissWait(maxAddress);
+            missWait = secondLineMissWait > missWait ? secondLineMissWait : missWait;
+        }
+
+        waitClocks = missWait > waitClocks ? missWait : waitClocks;
     }
-    else
+    else if(waitClocks)
     {
-        m_SM->InvokeRegisterFileLow(m_UnitIndex, packet);
-        m_SM->InvokeRegisterFileHigh(m_UnitIndex, resetPacket);
+        ++m_MergedLoads;
     }
+
+    MissStatusEntry& entry = IssueEntry(waitClocks);
+
+    // RegisterCount uses 1 based indexing.
+    m_MemoryTransactions += m_SM->ReadCoalesced(m_Address, m_Instruction.RegisterCount + 1u, entry.Data, m_Instruction.DispatchUnit, m_LaneGroup);
+
+    // Trained after the access, so a prefetch it starts can't be mistaken for this load's own miss.
+    m_SM->TrainPrefetcher(m_UnitIndex, m_InstructionPointer, m_Address);
+
+    m_Stage = EStage::Complete;
 }
 
-void LoadStore::Pipeline5() noexcept
+void LoadStore::LoadShared(const u64 address) noexcept
 {
-    if(!m_SuccessfulHigh && !m_UnsuccessfulHigh)
+    u32 values[MAX_REGISTER_COUNT];
+
+    // RegisterCount uses 1 based indexing.
+    if(!m_SM->ReadShared(address, m_Instruction.RegisterCount + 1u, values))
     {
-        // Unit hasn't run yet, this can't actually happen in software.
-        --m_ExecutionStage;
+        ++m_SharedBankConflictStallCycles;
+        return;
     }
 
-    // If we failed to read, just go back a stage.
-    if(!m_UnsuccessfulHigh)
+    m_Address = address;
+    m_CurrentRegister = 0;
+
+    ++m_SharedLoads;
+
+    // The data is already here, it only waits its turn to write back.
+    MissStatusEntry& entry = IssueEntry(0);
+    (void) ::std::memcpy(entry.Data, values, (m_Instruction.RegisterCount + 1u) * sizeof(u32));
+
+    m_Stage = EStage::Complete;
+}
+
+void LoadStore::StoreRegister() noexcept
+{
+    // The register read last clock is on the other port half from the one read this clock.
+    if(m_CurrentRegister > 0)
     {
-        --m_ExecutionStage;
+        InvokeRegister(RegisterFile::ECommand::Unlock, m_Instruction.TargetRegister + m_CurrentRegister - 1u, nullptr);
     }
 
-    RegisterFile::CommandPacket resetPacket {};
-    resetPacket.Command = RegisterFile::ECommand::Reset;
-    resetPacket.TargetRegister = 0;
-    resetPacket.Value = nullptr;
-    resetPacket.Successful = nullptr;
-    resetPacket.Unsuccessful = nullptr;
+    // RegisterCount uses 1 based indexing.
+    if(m_CurrentRegister <= m_Instruction.RegisterCount)
+    {
+        InvokeRegister(RegisterFile::ECommand::ReadRegister, m_Instruction.TargetRegister + m_CurrentRegister, &m_StoreData[m_CurrentRegister]);
+        ++m_CurrentRegister;
+        return;
+    }
 
-    // If the exponent is 111 then ignore the indexing register.
-    if(m_Instruction.IndexExponent == 7u)
+    m_Stage = EStage::WriteMemory;
+}
+
+void LoadStore::WriteMemory() noexcept
+{
+    if(m_SM->IsAccessBlocked(m_UnitIndex, m_Sequence, false, m_Instruction.Shared, m_Address, m_Instruction.RegisterCount + 1u))
     {
-        m_SM->InvokeRegisterFileHigh(m_UnitIndex, resetPacket);
-        m_SM->InvokeRegisterFileLow(m_UnitIndex, resetPacket);
+        ++m_OrderingStallCycles;
         return;
     }
 
-    m_Address += static_cast<u64>(m_IndexRegister) * (1u << static_cast<u32>(m_Instruction.IndexExponent));
+    if(m_Instruction.Shared)
+    {
+        if(!m_SM->WriteShared(m_Address, m_Instruction.RegisterCount + 1u, m_StoreData))
+        {
+            ++m_SharedBankConflictStallCycles;
+            return;
+        }
 
-    RegisterFile::CommandPacket packet {};
-    packet.Command = RegisterFile::ECommand::Unlock;
-    packet.TargetRegister = m_Instruction.IndexRegister;
-    packet.Value = nullptr;
-    packet.Successful = &m_SuccessfulHigh;
-    packet.Unsuccessful = &m_UnsuccessfulHigh;
+        m_Stage = EStage::Complete;
+        return;
+    }
+
+    m_MemoryTransactions += m_SM->WriteCoalesced(m_Address, m_Instruction.RegisterCount + 1u, m_StoreData, m_Instruction.DispatchUnit, m_LaneGroup);
+    m_Stage = EStage::Complete;
+}
 
-    if(m_Instruction.IndexRegister & 0x1)
+void LoadStore::ReadAtomicOperand() noexcept
+{
+    // RegisterCount uses 1 based indexing, only the compare exchange's value to store is past the previous value.
+    if(m_CurrentRegister > m_Instruction.RegisterCount + 1u)
     {
-        m_SM->InvokeRegisterFileHigh(m_UnitIndex, packet);
-        m_SM->InvokeRegisterFileLow(m_UnitIndex, resetPacket);
+        InvokeRegister(RegisterFile::ECommand::Unlock, m_Instruction.TargetRegister + m_CurrentRegister - 1u, nullptr);
     }
-    else
+
+    if(m_CurrentRegister < AtomicOperandCount(static_cast<EAtomicOperation>(m_Instruction.AtomicOperation), m_Instruction.Wide))
     {
-        m_SM->InvokeRegisterFileLow(m_UnitIndex, packet);
-        m_SM->InvokeRegisterFileHigh(m_UnitIndex, resetPacket);
+        InvokeRegister(RegisterFile::ECommand::ReadRegister, m_Instruction.TargetRegister + m_CurrentRegister, &m_StoreData[m_CurrentRegister]);
+        ++m_CurrentRegister;
+        return;
     }
+
+    m_Stage = EStage::ExecuteAtomic;
 }
 
-void LoadStore::Pipeline6() noexcept
+void LoadStore::ExecuteAtomic() noexcept
 {
-    if(!m_SuccessfulHigh && !m_UnsuccessfulHigh)
+    // An atomic both reads and writes, so it waits on older loads as well as stores.
+    if(m_SM->IsAccessBlocked(m_UnitIndex, m_Sequence, false, false, m_Address, m_Instruction.RegisterCount + 1u))
     {
-        // Unit hasn't run yet, this can't actually happen in software.
-        --m_ExecutionStage;
+        ++m_OrderingStallCycles;
+        return;
     }
 
-    // If we failed to read, just go back a stage.
-    if(!m_UnsuccessfulHigh)
+    u32 waitClocks = m_SM->PendingLineWait(m_Address);
+
+    if(!m_SM->IsCached(m_Address))
     {
-        --m_ExecutionStage;
+        ++m_AtomicMisses;
+
+        const u32 missWait = LineMissWait(m_Address);
+        waitClocks = missWait > waitClocks ? missWait : waitClocks;
     }
 
-    RegisterFile::CommandPacket resetPacket {};
-    resetPacket.Command = RegisterFile::ECommand::Reset;
-    resetPacket.TargetRegister = 0;
-    resetPacket.Value = nullptr;
-    resetPacket.Successful = nullptr;
-    resetPacket.Unsuccessful = nullptr;
+    MissStatusEntry& entry = IssueEntry(waitClocks);
 
-    m_SM->InvokeRegisterFileHigh(m_UnitIndex, resetPacket);
-    m_SM->InvokeRegisterFileLow(m_UnitIndex, resetPacket);
+    m_SM->Atomic(m_Address, static_cast<EAtomicOperation>(m_Instruction.AtomicOperation), m_Instruction.Wide, m_Instruction.SignedCompare, m_StoreData, entry.Data);
+    ++m_MemoryTransactions;
 
-    // Being able to read up to 8 registers we can be in at most be in two cache lines.
-    // If the last register is in another cache line we'll prefetch it. This has no effect in software, but would have a substantial effect in hardware.
+    m_Stage = EStage::Complete;
+}
 
-    const u64 maxAddress = m_Address + m_Instruction.RegisterCount;
+void LoadStore::Complete() noexcept
+{
+    m_Stage = EStage::Idle;
 
-    // The lower 3 bits are just the index into the cache line.
-    const u64 addressSetIndex = m_Address >> 3;
-    const u64 maxAddressSetIndex = maxAddress >> 3;
-    if(addressSetIndex != maxAddressSetIndex)
+    // Otherwise we report ready once a load has written back.
+    if(FreeEntry() != INVALID_ENTRY)
     {
-        m_SM->Prefetch(maxAddress);
+        m_SM->ReportLdStReady(m_UnitIndex);
     }
 }
 
-void LoadStore::Pipeline23() noexcept
+void LoadStore::CountDownEntries() noexcept
 {
-    m_SM->ReportLdStReady(m_UnitIndex);
+    for(MissStatusEntry& entry : m_Entries)
+    {
+        if(entry.Valid && entry.WaitClocks > 0)
+        {
+            --entry.WaitClocks;
+        }
+    }
 }
 
-void LoadStore::PipelineRWHandler(const u32 index) noexcept
+bool LoadStore::ReturnLoad() noexcept
 {
-    if(!m_SuccessfulHigh && !m_UnsuccessfulHigh)
+    if(m_ReturnEntry == INVALID_ENTRY)
     {
-        // Unit hasn't run yet, this can't actually happen in software.
-        --m_ExecutionStage;
+        m_ReturnEntry = OldestReadyEntry();
+        m_ReturnRegister = 0;
+
+        if(m_ReturnEntry == INVALID_ENTRY)
+        {
+            return false;
+        }
+
+        if(HasOlderEntry(m_Entries[m_ReturnEntry].Sequence))
+        {
+            ++m_OutOfOrderReturns;
+        }
     }
 
-    // If we failed to read, just go back a stage.
-    if(!m_UnsuccessfulHigh)
+    MissStatusEntry& entry = m_Entries[m_ReturnEntry];
+
+    // The register written last clock is on the other port half from the one written this clock.
+    if(m_ReturnRegister > 0)
     {
-        --m_ExecutionStage;
+        InvokeRegister(RegisterFile::ECommand::Unlock, entry.Instruction.TargetRegister + m_ReturnRegister - 1u, nullptr);
     }
 
-    RegisterFile::CommandPacket resetPacket {};
-    resetPacket.Command = RegisterFile::ECommand::Reset;
-    resetPacket.TargetRegister = 0;
-    resetPacket.Value = nullptr;
-    resetPacket.Successful = nullptr;
-    resetPacket.Unsuccessful = nullptr;
+    // RegisterCount uses 1 based indexing.
+    if(m_ReturnRegister <= entry.Instruction.RegisterCount)
+    {
+        InvokeRegister(RegisterFile::ECommand::WriteRegister, entry.Instruction.TargetRegister + m_ReturnRegister, &entry.Data[m_ReturnRegister]);
+        ++m_ReturnRegister;
+        return true;
+    }
+
+    entry.Valid = false;
+    m_ReturnEntry = INVALID_ENTRY;
+
+    m_SM->ReportLoadComplete(entry.Instruction.DispatchUnit, entry.Instruction.Warp);
 
-    if(m_Instruction.RegisterCount < index)
+    // The front end held off reporting ready while the table was full.
+    if(m_Stage == EStage::Idle)
     {
-        m_SM->InvokeRegisterFileHigh(m_UnitIndex, resetPacket);
-        m_SM->InvokeRegisterFileLow(m_UnitIndex, resetPacket);
-        return;
+        m_SM->ReportLdStReady(m_UnitIndex);
     }
 
-    RegisterFile::CommandPacket packet {};
-    packet.TargetRegister = m_CurrentRegister;
-    packet.Value = &m_TargetValue;
-    packet.Successful = &m_SuccessfulHigh;
-    packet.Unsuccessful = &m_UnsuccessfulHigh;
+    return true;
+}
 
-    if(m_Instruction.ReadWrite)
+bool LoadStore::BlocksAccess(const u32 sequence, const bool storesOnly, const bool shared, const u64 address, const u32 wordCount) const noexcept
+{
+    // Loads have accessed memory once they're past AccessMemory, stores once they're past WriteMemory, and atomics once they're past ExecuteAtomic.
+    if(m_Stage == EStage::Idle || m_Stage == EStage::Complete)
     {
-        packet.Command = RegisterFile::ECommand::WriteRegister;
+        return false;
     }
-    else
+
+    // The sequence wraps, so compare the distance.
+    if(static_cast<i32>(m_Sequence - sequence) >= 0)
     {
-        // This needs to be changed to handle pipelining.
-        m_TargetValue = m_SM->Read(m_Address);
-        packet.Command = RegisterFile::ECommand::ReadRegister;
+        return false;
     }
 
-    if(m_Instruction.IndexRegister & 0x1)
+    if(storesOnly && !m_Instruction.ReadWrite)
     {
-        m_SM->InvokeRegisterFileHigh(m_UnitIndex, packet);
-        m_SM->InvokeRegisterFileLow(m_UnitIndex, resetPacket);
+        return false;
     }
-    else
+
+    // Shared memory and global memory never overlap.
+    if(m_Instruction.Shared != shared)
     {
-        m_SM->InvokeRegisterFileLow(m_UnitIndex, packet);
-        m_SM->InvokeRegisterFileHigh(m_UnitIndex, resetPacket);
+        return false;
+    }
+
+    // Until then the address isn't known, so anything could overlap.
+    if(m_Stage < EStage::AccessMemory)
+    {
+        return true;
+    }
+
+    const u64 pendingAddress = m_Stage == EStage::AccessMemory ? m_Address + static_cast<u64>(static_cast<i64>(m_Instruction.Offset)) : m_Address;
+
+    // RegisterCount uses 1 based indexing.
+    return pendingAddress < address + wordCount && address < pendingAddress + m_Instruction.RegisterCount + 1u;
+}
+
+u32 LoadStore::OutstandingLoads() const noexcept
+{
+    u32 count = 0;
+
+    for(const MissStatusEntry& entry : m_Entries)
+    {
+        count += entry.Valid ? 1u : 0u;
     }
+
+    return count;
 }
 
-void LoadStore::PipelineReleaseHandler(const u32 index) noexcept
+u32 LoadStore::LineMissWait(const u64 address) noexcept
 {
-    if(!m_SuccessfulHigh && !m_UnsuccessfulHigh)
+    if(m_SM->IsCached(address))
     {
-        // Unit hasn't run yet, this can't actually happen in software.
-        --m_ExecutionStage;
+        return 0;
     }
 
-    // If we failed to read, just go back a stage.
-    if(!m_UnsuccessfulHigh)
+    const u32 prefetchWait = m_SM->PrefetchWait(address);
+
+    return prefetchWait ? prefetchWait : MISS_LATENCY_CYCLES * MAX_EXECUTION_STAGE;
+}
+
+LoadStore::MissStatusEntry& LoadStore::IssueEntry(const u32 waitClocks) noexcept
+{
+    const u32 entryIndex = FreeEntry();
+
+    // We only report ready while there's a free entry.
+    assert(entryIndex != INVALID_ENTRY);
+
+    MissStatusEntry& entry = m_Entries[entryIndex];
+    (void) ::std::memcpy(&entry.Instruction, &m_Instruction, sizeof(m_Instruction));
+    entry.Address = m_Address;
+    entry.WaitClocks = waitClocks;
+    entry.Sequence = m_IssueSequence++;
+    entry.Valid = true;
+
+    const u32 outstandingLoads = OutstandingLoads();
+
+    if(outstandingLoads > m_PeakOutstandingLoads)
     {
-        --m_ExecutionStage;
+        m_PeakOutstandingLoads = outstandingLoads;
     }
 
-    RegisterFile::CommandPacket resetPacket {};
-    resetPacket.Command = RegisterFile::ECommand::Reset;
-    resetPacket.TargetRegister = 0;
-    resetPacket.Value = nullptr;
-    resetPacket.Successful = nullptr;
-    resetPacket.Unsuccessful = nullptr;
+    return entry;
+}
 
-    if(m_Instruction.RegisterCount < index)
+u32 LoadStore::FreeEntry() const noexcept
+{
+    if(OutstandingLoads() >= m_EntryLimit)
     {
-        m_SM->InvokeRegisterFileHigh(m_UnitIndex, resetPacket);
-        m_SM->InvokeRegisterFileLow(m_UnitIndex, resetPacket);
-        return;
+        return INVALID_ENTRY;
     }
 
-    RegisterFile::CommandPacket packet {};
-    packet.Command = RegisterFile::ECommand::Unlock;
-    packet.TargetRegister = m_CurrentRegister;
-    packet.Value = &m_TargetValue;
-    packet.Successful = &m_SuccessfulHigh;
-    packet.Unsuccessful = &m_UnsuccessfulHigh;
+    for(u32 i = 0; i < MISS_STATUS_ENTRY_COUNT; ++i)
+    {
+        if(!m_Entries[i].Valid)
+        {
+            return i;
+        }
+    }
 
-    // This needs to be changed to handle pipelining.
-    m_SM->Write(m_Address, m_TargetValue);
+    return INVALID_ENTRY;
+}
 
-    ++m_Address;
-    ++m_CurrentRegister;
+u32 LoadStore::OldestReadyEntry() const noexcept
+{
+    u32 oldest = INVALID_ENTRY;
 
-    if(m_Instruction.IndexRegister & 0x1)
+    for(u32 i = 0; i < MISS_STATUS_ENTRY_COUNT; ++i)
     {
-        m_SM->InvokeRegisterFileHigh(m_UnitIndex, packet);
-        m_SM->InvokeRegisterFileLow(m_UnitIndex, resetPacket);
+        const MissStatusEntry& entry = m_Entries[i];
+
+        if(!entry.Valid || entry.WaitClocks > 0)
+        {
+            continue;
+        }
+
+        if(oldest == INVALID_ENTRY || entry.Sequence < m_Entries[oldest].Sequence)
+        {
+            oldest = i;
+        }
     }
-    else
+
+    return oldest;
+}
+
+u32 LoadStore::PendingLineWait(const u64 address) const noexcept
+{
+    u32 waitClocks = 0;
+
+    for(const MissStatusEntry& entry : m_Entries)
     {
-        m_SM->InvokeRegisterFileLow(m_UnitIndex, packet);
-        m_SM->InvokeRegisterFileHigh(m_UnitIndex, resetPacket);
+        // Shared memory loads aren't fetching any lines.
+        if(!entry.Valid || entry.Instruction.Shared || entry.WaitClocks <= waitClocks)
+        {
+            continue;
+        }
+
+        const u64 line = address >> 3;
+
+        if(line == entry.Address >> 3 || line == (entry.Address + entry.Instruction.RegisterCount) >> 3)
+        {
+            waitClocks = entry.WaitClocks;
+        }
     }
+
+    return waitClocks;
 }
 
-// void LoadStore::Execute(const LoadStoreInstruction instructionInfo) noexcept
-// {
-//     // Compute the 64 bit base address
-//     const u32 baseAddressLow = m_SM->GetRegister(instructionInfo.BaseRegister);
-//     const u32 baseAddressHigh = m_SM->GetRegister(instructionInfo.BaseRegister + 1u);
-//
-//     m_SM->ReleaseRegisterContestation(instructionInfo.BaseRegister);
-//     m_SM->ReleaseRegisterContestation(instructionInfo.BaseRegister + 1u);
-//
-//     u64 address = (static_cast<u64>(baseAddressHigh) << 32) | baseAddressLow;
-//
-//     // If the exponent is not 111 then account for the indexing register.
-//     if(instructionInfo.IndexExponent != 7u)
-//     {
-//         const u32 indexValue = m_SM->GetRegister(instructionInfo.IndexRegister);
-//         m_SM->ReleaseRegisterContestation(instructionInfo.IndexRegister);
-//         address += static_cast<u64>(indexValue) * (1u << static_cast<u32>(instructionInfo.IndexExponent));
-//     }
-//
-//     // Add the offset
-//     address += instructionInfo.Offset;
-//
-//     // Here we would get a lock on the cache from the other load store units.
-//     //   We'll use something similar to the staggered buffer so that once all the address info is calculated
-//     // we will perform the loads and stores from Ld/St unit 0 -> 3. We can also add a flag that indicates
-//     // all units are performing Loads, in which case locking isn't necessary, though we'd need multiple comm
-//     // lines to access the cache.
-//
-//     {
-//         // With 8 registers we can at most be in two cache lines.
-//         // If the last register is in another cache line we'll prefetch it. This has no effect in software, but would have a substantial effect in hardware.
-//
-//         const u64 maxAddress = address + instructionInfo.RegisterCount;
-//
-//         // The lower 3 bits are just the index into the cache line.
-//         const u64 addressSetIndex = address >> 3;
-//         const u64 maxAddressSetIndex = maxAddress >> 3;
-//         if(addressSetIndex != maxAddressSetIndex)
-//         {
-//             m_SM->Prefetch(maxAddress);
-//         }
-//     }
-//
-//     m_DispatchPort = instructionInfo.DispatchUnit;
-//     m_RegisterCount = instructionInfo.RegisterCount;
-//     m_StartRegister = instructionInfo.TargetRegister;
-//     m_ExecutionStage = 5;
-//
-//     // If 1 then write.
-//     if(instructionInfo.ReadWrite)
-//     {
-//         // Iterate through each register that is being written.
-//         for(u32 i = 0; i < instructionInfo.RegisterCount + 1u; ++i)
-//         {
-//             const u32 value = m_SM->GetRegister(instructionInfo.TargetRegister + i);
-//             m_SM->Write(address + i, value);
-//         }
-//     }
-//     else // Else Read
-//     {
-//         // Iterate through each register that is being read.
-//         for(u32 i = 0; i < instructionInfo.RegisterCount + 1u; ++i)
-//         {
-//             const u32 value = m_SM->Read(address + i);
-//             m_SM->SetRegister(instructionInfo.TargetRegister + i, value);
-//         }
-//     }
-// }
+bool LoadStore::HasOlderEntry(const u32 sequence) const noexcept
+{
+    for(const MissStatusEntry& entry : m_Entries)
+    {
+        if(entry.Valid && entry.Sequence < sequence)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
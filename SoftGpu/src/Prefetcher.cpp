@@ -0,0 +1,157 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#include "Prefetcher.hpp"
+#include "StreamingMultiprocessor.hpp"
+
+static constexpr u64 LINE_WORD_COUNT = 8;
+
+void Prefetcher::Clock() noexcept
+{
+    for(MissStatusEntry& entry : m_Entries)
+    {
+        if(!entry.Valid)
+        {
+            continue;
+        }
+
+        if(--entry.WaitClocks > 0)
+        {
+            continue;
+        }
+
+        // A merged load already brought the line in.
+        if(!entry.Demanded)
+        {
+            m_SM->FillLinePhysical(entry.LineAddress, entry.External);
+        }
+
+        entry.Valid = false;
+    }
+}
+
+void Prefetcher::Request(const u64 physicalAddress, const bool external) noexcept
+{
+    const u64 lineAddress = physicalAddress & ~(LINE_WORD_COUNT - 1);
+
+    if(FindEntry(lineAddress, external) || m_SM->IsCachedPhysical(lineAddress, external))
+    {
+        ++m_Redundant;
+        return;
+    }
+
+    for(MissStatusEntry& entry : m_Entries)
+    {
+        if(entry.Valid)
+        {
+            continue;
+        }
+
+        entry.LineAddress = lineAddress;
+        entry.WaitClocks = m_FillClocks;
+        entry.External = external;
+        entry.Demanded = false;
+        entry.Valid = true;
+
+        ++m_Issued;
+        return;
+    }
+
+    ++m_Dropped;
+}
+
+u32 Prefetcher::MergeDemand(const u64 physicalAddress, const bool external) noexcept
+{
+    MissStatusEntry* const entry = FindEntry(physicalAddress & ~(LINE_WORD_COUNT - 1), external);
+
+    if(!entry)
+    {
+        return 0;
+    }
+
+    if(!entry->Demanded)
+    {
+        ++m_Late;
+        entry->Demanded = true;
+    }
+
+    return entry->WaitClocks;
+}
+
+void Prefetcher::Train(const u32 unitIndex, const u64 instructionPointer, const u64 address) noexcept
+{
+    if(!m_StrideEnabled)
+    {
+        return;
+    }
+
+    StrideEntry& entry = m_StrideEntries[(instructionPointer ^ (instructionPointer >> 4) ^ unitIndex) % STRIDE_ENTRY_COUNT];
+
+    if(!entry.Valid || entry.InstructionPointer != instructionPointer || entry.UnitIndex != unitIndex)
+    {
+        entry.InstructionPointer = instructionPointer;
+        entry.LastAddress = address;
+        entry.Stride = 0;
+        entry.UnitIndex = static_cast<u8>(unitIndex);
+        entry.Confidence = 0;
+        entry.Valid = true;
+        return;
+    }
+
+    const i64 stride = static_cast<i64>(address - entry.LastAddress);
+
+    // Threads which share an address tell us nothing.
+    if(stride == 0)
+    {
+        return;
+    }
+
+    if(stride == entry.Stride)
+    {
+        if(entry.Confidence < MAX_STRIDE_CONFIDENCE)
+        {
+            ++entry.Confidence;
+        }
+    }
+    else
+    {
+        entry.Stride = stride;
+        entry.Confidence = 0;
+    }
+
+    entry.LastAddress = address;
+
+    if(entry.Confidence >= STRIDE_CONFIDENCE_THRESHOLD)
+    {
+        ++m_StridePrefetches;
+        m_SM->Prefetch(address + static_cast<u64>(stride * PREFETCH_DISTANCE));
+    }
+}
+
+u32 Prefetcher::InFlight() const noexcept
+{
+    u32 inFlight = 0;
+
+    for(const MissStatusEntry& entry : m_Entries)
+    {
+        inFlight += entry.Valid ? 1 : 0;
+    }
+
+    return inFlight;
+}
+
+Prefetcher::MissStatusEntry* Prefetcher::FindEntry(const u64 lineAddress, const bool external) noexcept
+{
+    for(MissStatusEntry& entry : m_Entries)
+    {
+        if(entry.Valid && entry.LineAddress == lineAddress && entry.External == external)
+        {
+            return &entry;
+        }
+    }
+
+    return nullptr;
+}
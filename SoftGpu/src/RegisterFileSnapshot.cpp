@@ -0,0 +1,146 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#include "RegisterFileSnapshot.hpp"
+#include "DebugManager.hpp"
+
+#include <cstring>
+
+u32 RegisterFileSnapshot::Encode(const u32 smIndex, const u32* const registers, const u8* const contestation) noexcept
+{
+    if(m_FullPending)
+    {
+        return EncodeFull(smIndex, registers, contestation);
+    }
+
+    u32 offset = MESSAGE_HEADER_SIZE + sizeof(Header);
+    u32 runCount = 0;
+
+    for(u32 i = 0; i < REGISTER_COUNT;)
+    {
+        if(registers[i] == m_ReportedRegisters[i] && contestation[i] == m_ReportedContestation[i])
+        {
+            ++i;
+            continue;
+        }
+
+        u32 end = i + 1;
+
+        while(end < REGISTER_COUNT && (registers[end] != m_ReportedRegisters[end] || contestation[end] != m_ReportedContestation[end]))
+        {
+            ++end;
+        }
+
+        // A run header is never larger than the unchanged registers separating two runs, so a delta only reaches the
+        // size of a full snapshot when every register changed. Send it as a full snapshot in that case.
+        if(offset + sizeof(RunHeader) + (end - i) * RUN_REGISTER_SIZE >= sizeof(m_Buffer))
+        {
+            return EncodeFull(smIndex, registers, contestation);
+        }
+
+        offset = WriteRun(offset, i, end - i, registers, contestation);
+        ++runCount;
+        i = end;
+    }
+
+    if(runCount == 0)
+    {
+        return 0;
+    }
+
+    return Finish(offset, smIndex, 0, runCount);
+}
+
+bool RegisterFileSnapshot::Decode(const u8* const payload, const u32 payloadSize, u32* const smIndex, u32* const registers, u8* const contestation) noexcept
+{
+    if(payloadSize < sizeof(Header))
+    {
+        return false;
+    }
+
+    Header header;
+    (void) ::std::memcpy(&header, payload, sizeof(header));
+
+    if(header.Version != VERSION)
+    {
+        return false;
+    }
+
+    u32 offset = sizeof(Header);
+
+    for(u32 run = 0; run < header.RunCount; ++run)
+    {
+        if(payloadSize - offset < sizeof(RunHeader))
+        {
+            return false;
+        }
+
+        RunHeader runHeader;
+        (void) ::std::memcpy(&runHeader, payload + offset, sizeof(runHeader));
+        offset += sizeof(RunHeader);
+
+        const u32 registerCount = runHeader.RegisterCount;
+
+        if(runHeader.BaseRegister + registerCount > REGISTER_COUNT || payloadSize - offset < registerCount * RUN_REGISTER_SIZE)
+        {
+            return false;
+        }
+
+        (void) ::std::memcpy(&registers[runHeader.BaseRegister], payload + offset, sizeof(u32) * registerCount);
+        offset += sizeof(u32) * registerCount;
+        (void) ::std::memcpy(&contestation[runHeader.BaseRegister], payload + offset, registerCount);
+        offset += registerCount;
+    }
+
+    *smIndex = header.SmIndex;
+
+    return offset == payloadSize;
+}
+
+u32 RegisterFileSnapshot::EncodeFull(const u32 smIndex, const u32* const registers, const u8* const contestation) noexcept
+{
+    m_FullPending = false;
+
+    const u32 offset = WriteRun(MESSAGE_HEADER_SIZE + sizeof(Header), 0, REGISTER_COUNT, registers, contestation);
+    return Finish(offset, smIndex, FLAG_FULL, 1);
+}
+
+// Copies a run into the buffer and records it as reported.
+u32 RegisterFileSnapshot::WriteRun(u32 offset, const u32 baseRegister, const u32 registerCount, const u32* const registers, const u8* const contestation) noexcept
+{
+    RunHeader runHeader;
+    runHeader.BaseRegister = static_cast<u16>(baseRegister);
+    runHeader.RegisterCount = static_cast<u16>(registerCount);
+
+    (void) ::std::memcpy(m_Buffer + offset, &runHeader, sizeof(runHeader));
+    offset += sizeof(runHeader);
+    (void) ::std::memcpy(m_Buffer + offset, &registers[baseRegister], sizeof(u32) * registerCount);
+    offset += sizeof(u32) * registerCount;
+    (void) ::std::memcpy(m_Buffer + offset, &contestation[baseRegister], registerCount);
+    offset += registerCount;
+
+    (void) ::std::memcpy(&m_ReportedRegisters[baseRegister], &registers[baseRegister], sizeof(u32) * registerCount);
+    (void) ::std::memcpy(&m_ReportedContestation[baseRegister], &contestation[baseRegister], registerCount);
+
+    return offset;
+}
+
+u32 RegisterFileSnapshot::Finish(const u32 payloadEnd, const u32 smIndex, const u32 flags, const u32 runCount) noexcept
+{
+    const u32 payloadSize = payloadEnd - MESSAGE_HEADER_SIZE;
+
+    Header header;
+    header.Version = VERSION;
+    header.SmIndex = smIndex;
+    header.Flags = flags;
+    header.RunCount = runCount;
+
+    (void) ::std::memcpy(m_Buffer, &DebugCodeReportRegisterSnapshot, sizeof(DebugCodeReportRegisterSnapshot));
+    (void) ::std::memcpy(m_Buffer + sizeof(u32), &payloadSize, sizeof(payloadSize));
+    (void) ::std::memcpy(m_Buffer + MESSAGE_HEADER_SIZE, &header, sizeof(header));
+
+    return payloadEnd;
+}
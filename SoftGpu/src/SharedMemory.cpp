@@ -0,0 +1,106 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#include "SharedMemory.hpp"
+
+// How many of the words starting at address exist, the rest are past the end.
+[[nodiscard]] static u32 InRangeWordCount(const u64 address, const u32 wordCount) noexcept
+{
+    if(address >= SharedMemory::WORD_COUNT)
+    {
+        return 0;
+    }
+
+    const u64 remainingWords = SharedMemory::WORD_COUNT - address;
+    return remainingWords < wordCount ? static_cast<u32>(remainingWords) : wordCount;
+}
+
+bool SharedMemory::Read(const u64 address, const u32 wordCount, u32* const values) noexcept
+{
+    if(!AcquireBanks(address, wordCount, false))
+    {
+        return false;
+    }
+
+    ++m_Reads;
+
+    const u32 inRangeWords = InRangeWordCount(address, wordCount);
+
+    for(u32 i = 0; i < wordCount; ++i)
+    {
+        values[i] = i < inRangeWords ? m_Words[address + i] : 0xFFFFFFFF;
+    }
+
+    return true;
+}
+
+bool SharedMemory::Write(const u64 address, const u32 wordCount, const u32* const values) noexcept
+{
+    if(!AcquireBanks(address, wordCount, true))
+    {
+        return false;
+    }
+
+    ++m_Writes;
+
+    const u32 inRangeWords = InRangeWordCount(address, wordCount);
+
+    if(inRangeWords != 0)
+    {
+        (void) ::std::memcpy(&m_Words[address], values, inRangeWords * sizeof(u32));
+    }
+
+    return true;
+}
+
+bool SharedMemory::AcquireBanks(const u64 address, const u32 wordCount, const bool write) noexcept
+{
+    // Out of range words don't need a bank.
+    const u32 inRangeWords = InRangeWordCount(address, wordCount);
+
+    u32 banks = 0;
+    bool broadcast = false;
+
+    for(u32 i = 0; i < inRangeWords; ++i)
+    {
+        const u32 bank = static_cast<u32>((address + i) % BANK_COUNT);
+        const u32 bankBit = 1u << bank;
+
+        banks |= bankBit;
+
+        if(!(m_BusyBanks & bankBit))
+        {
+            continue;
+        }
+
+        if(write || (m_WriteBanks & bankBit) || m_BankAddresses[bank] != address + i)
+        {
+            ++m_BankConflicts;
+            return false;
+        }
+
+        broadcast = true;
+    }
+
+    if(broadcast)
+    {
+        ++m_Broadcasts;
+    }
+
+    for(u32 i = 0; i < inRangeWords; ++i)
+    {
+        m_BankAddresses[(address + i) % BANK_COUNT] = address + i;
+    }
+
+    m_BusyBanks |= banks;
+
+    if(write)
+    {
+        m_WriteBanks |= banks;
+    }
+
+    return true;
+}
@@ -0,0 +1,182 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#include "StoreBuffer.hpp"
+#include "StreamingMultiprocessor.hpp"
+
+#include <bit>
+#include <cassert>
+
+void StoreBuffer::Write(const u64 physicalAddress, const u32 wordCount, const u32* const values, const bool external) noexcept
+{
+    const u64 lineOffset = physicalAddress & (LINE_WORD_COUNT - 1);
+    const u64 lineAddress = physicalAddress - lineOffset;
+
+    assert(lineOffset + wordCount <= LINE_WORD_COUNT);
+
+    ++m_Stores;
+
+    u32 entryIndex = FindEntry(lineAddress, external);
+
+    if(entryIndex != INVALID_ENTRY)
+    {
+        ++m_MergedStores;
+    }
+    else
+    {
+        if(m_ValidMask == (1u << ENTRY_COUNT) - 1)
+        {
+            ++m_CapacityDrains;
+            DrainEntry(OldestEntry());
+        }
+
+        entryIndex = static_cast<u32>(::std::countr_one(m_ValidMask));
+
+        Entry& entry = m_Entries[entryIndex];
+        entry.LineAddress = lineAddress;
+        entry.Sequence = m_Sequence++;
+        entry.WordMask = 0;
+        entry.External = external;
+        entry.Valid = true;
+
+        m_ValidMask |= 1u << entryIndex;
+    }
+
+    Entry& entry = m_Entries[entryIndex];
+
+    (void) ::std::memcpy(&entry.Data[lineOffset], values, wordCount * sizeof(u32));
+    entry.WordMask |= static_cast<u8>(((1u << wordCount) - 1) << lineOffset);
+
+    // There's nothing left to combine with, so don't hold on to it.
+    if(entry.WordMask == FULL_LINE_MASK)
+    {
+        DrainEntry(entryIndex);
+    }
+}
+
+void StoreBuffer::Forward(const u64 physicalAddress, const u32 wordCount, u32* const values, const bool external) noexcept
+{
+    if(m_ValidMask == 0)
+    {
+        return;
+    }
+
+    const u64 lineOffset = physicalAddress & (LINE_WORD_COUNT - 1);
+
+    assert(lineOffset + wordCount <= LINE_WORD_COUNT);
+
+    const u32 entryIndex = FindEntry(physicalAddress - lineOffset, external);
+
+    if(entryIndex == INVALID_ENTRY)
+    {
+        return;
+    }
+
+    const Entry& entry = m_Entries[entryIndex];
+    const u32 requestMask = ((1u << wordCount) - 1) << lineOffset;
+
+    if((entry.WordMask & requestMask) == 0)
+    {
+        return;
+    }
+
+    ++m_ForwardedLoads;
+
+    for(u32 i = 0; i < wordCount; ++i)
+    {
+        if(entry.WordMask & (1u << (lineOffset + i)))
+        {
+            values[i] = entry.Data[lineOffset + i];
+        }
+    }
+}
+
+void StoreBuffer::DrainLine(const u64 physicalAddress, const bool external) noexcept
+{
+    if(m_ValidMask == 0)
+    {
+        return;
+    }
+
+    const u32 entryIndex = FindEntry(physicalAddress & ~static_cast<u64>(LINE_WORD_COUNT - 1), external);
+
+    if(entryIndex != INVALID_ENTRY)
+    {
+        DrainEntry(entryIndex);
+    }
+}
+
+void StoreBuffer::Fence() noexcept
+{
+    ++m_Fences;
+
+    while(m_ValidMask != 0)
+    {
+        DrainEntry(OldestEntry());
+    }
+}
+
+u32 StoreBuffer::FindEntry(const u64 lineAddress, const bool external) const noexcept
+{
+    for(u32 validMask = m_ValidMask; validMask != 0; validMask &= validMask - 1)
+    {
+        const u32 entryIndex = static_cast<u32>(::std::countr_zero(validMask));
+        const Entry& entry = m_Entries[entryIndex];
+
+        if(entry.LineAddress == lineAddress && entry.External == external)
+        {
+            return entryIndex;
+        }
+    }
+
+    return INVALID_ENTRY;
+}
+
+u32 StoreBuffer::OldestEntry() const noexcept
+{
+    u32 oldest = INVALID_ENTRY;
+
+    for(u32 validMask = m_ValidMask; validMask != 0; validMask &= validMask - 1)
+    {
+        const u32 entryIndex = static_cast<u32>(::std::countr_zero(validMask));
+
+        if(oldest == INVALID_ENTRY || m_Entries[entryIndex].Sequence < m_Entries[oldest].Sequence)
+        {
+            oldest = entryIndex;
+        }
+    }
+
+    return oldest;
+}
+
+void StoreBuffer::DrainEntry(const u32 entryIndex) noexcept
+{
+    Entry& entry = m_Entries[entryIndex];
+
+    if(entry.WordMask == FULL_LINE_MASK)
+    {
+        ++m_FullLineDrains;
+    }
+    else
+    {
+        ++m_PartialLineDrains;
+    }
+
+    u32 wordMask = entry.WordMask;
+
+    while(wordMask != 0)
+    {
+        const u32 runStart = static_cast<u32>(::std::countr_zero(wordMask));
+        const u32 runLength = static_cast<u32>(::std::countr_one(wordMask >> runStart));
+
+        m_SM->WriteLinePhysical(entry.LineAddress + runStart, runLength, &entry.Data[runStart], entry.External);
+
+        wordMask &= ~(((1u << runLength) - 1) << runStart);
+    }
+
+    entry.Valid = false;
+    m_ValidMask &= ~(1u << entryIndex);
+}
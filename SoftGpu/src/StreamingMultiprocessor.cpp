@@ -7,6 +7,8 @@
 #include "StreamingMultiprocessor.hpp"
 #include "Processor.hpp"
 
+#include <cstring>
+
 u32 StreamingMultiprocessor::Read(const u64 address) noexcept
 {
     bool success;
@@ -20,7 +22,9 @@ u32 StreamingMultiprocessor::Read(const u64 address) noexcept
         return 0xFFFFFFFF;
     }
 
-    return m_Processor->Read(m_SMIndex, physicalAddress, cacheDisable, external);
+    u32 value = m_Processor->Read(m_SMIndex, physicalAddress, cacheDisable, external);
+    m_StoreBuffer.Forward(physicalAddress, 1, &value, external);
+    return value;
 }
 
 void StreamingMultiprocessor::Write(const u64 address, const u32 value) noexcept
@@ -53,7 +57,224 @@ void StreamingMultiprocessor::Write(const u64 address, const u32 value) noexcept
 
     m_Mmu.MarkDirty(address);
 
-    m_Processor->Write(m_SMIndex, physicalAddress, value, writeThrough, cacheDisable, external);
+    if(writeThrough || cacheDisable)
+    {
+        m_StoreBuffer.DrainLine(physicalAddress, external);
+        m_Processor->Write(m_SMIndex, physicalAddress, value, writeThrough, cacheDisable, external);
+        m_LaneCoalescer.InvalidatePhysical(physicalAddress, external);
+        return;
+    }
+
+    m_StoreBuffer.Write(physicalAddress, 1, &value, external);
+    m_LaneCoalescer.InvalidatePhysical(physicalAddress, external);
+}
+
+// Lines never straddle a page, so a transaction never needs more than the one translation.
+static constexpr u64 LINE_WORD_COUNT = 8;
+
+[[nodiscard]] static u32 LineWordCount(const u64 address, const u32 remainingWords) noexcept
+{
+    const u32 lineWords = static_cast<u32>(LINE_WORD_COUNT - (address & (LINE_WORD_COUNT - 1)));
+    return lineWords < remainingWords ? lineWords : remainingWords;
+}
+
+u32 StreamingMultiprocessor::ReadCoalesced(const u64 address, const u32 wordCount, u32* const values, const u32 dispatchPort, const u32 group) noexcept
+{
+    u32 transactions = 0;
+    u64 page = ~0ull;
+
+    bool success = false;
+    bool cacheDisable = false;
+    bool external = false;
+    // The page is physically contiguous, so later lines are offset from its base.
+    u64 physicalPage = 0;
+
+    for(u32 i = 0; i < wordCount;)
+    {
+        const u64 lineAddress = address + i;
+        const u32 lineWords = LineWordCount(lineAddress, wordCount - i);
+        const u32 lineOffset = static_cast<u32>(lineAddress & (LINE_WORD_COUNT - 1));
+
+        // Another lane of this instruction already read the line.
+        if(const LaneCoalescer::Line* const merged = m_LaneCoalescer.Find(dispatchPort, group, lineAddress, true))
+        {
+            (void) ::std::memcpy(values + i, merged->Data + lineOffset, lineWords * sizeof(u32));
+            i += lineWords;
+            continue;
+        }
+
+        ++transactions;
+
+        if(lineAddress / GpuPageWordCount != page)
+        {
+            page = lineAddress / GpuPageWordCount;
+            physicalPage = m_Mmu.TranslateAddress(lineAddress, &success, nullptr, nullptr, nullptr, &cacheDisable, &external) - lineAddress % GpuPageWordCount;
+        }
+
+        // Uncached lines are only read as far as asked for, so they're never kept for the other lanes.
+        LaneCoalescer::Line* const recorded = cacheDisable ? nullptr : m_LaneCoalescer.Record(dispatchPort, group, lineAddress);
+
+        // Was the virtual address valid?
+        if(!success)
+        {
+            for(u32 j = 0; j < lineWords; ++j)
+            {
+                values[i + j] = 0xFFFFFFFF;
+            }
+
+            if(recorded)
+            {
+                (void) ::std::memset(recorded->Data, 0xFF, sizeof(recorded->Data));
+                recorded->PhysicalAddress = 0;
+            }
+        }
+        else if(recorded)
+        {
+            // The whole line is read, so the other lanes can take any of its words.
+            const u64 physicalLine = physicalPage + (lineAddress - lineOffset) % GpuPageWordCount;
+            m_Processor->ReadLine(m_SMIndex, physicalLine, static_cast<u32>(LINE_WORD_COUNT), recorded->Data, cacheDisable, external);
+            m_StoreBuffer.Forward(physicalLine, static_cast<u32>(LINE_WORD_COUNT), recorded->Data, external);
+            (void) ::std::memcpy(values + i, recorded->Data + lineOffset, lineWords * sizeof(u32));
+            recorded->PhysicalAddress = physicalLine;
+        }
+        else
+        {
+            const u64 physicalAddress = physicalPage + lineAddress % GpuPageWordCount;
+            m_Processor->ReadLine(m_SMIndex, physicalAddress, lineWords, values + i, cacheDisable, external);
+            m_StoreBuffer.Forward(physicalAddress, lineWords, values + i, external);
+        }
+
+        if(recorded)
+        {
+            recorded->Translated = success;
+            recorded->Writable = false;
+            recorded->External = external;
+            recorded->Loaded = true;
+        }
+
+        i += lineWords;
+    }
+
+    return transactions;
+}
+
+u32 StreamingMultiprocessor::WriteCoalesced(const u64 address, const u32 wordCount, const u32* const values, const u32 dispatchPort, const u32 group) noexcept
+{
+    u32 transactions = 0;
+    u64 page = ~0ull;
+
+    bool writable = false;
+    bool writeThrough = false;
+    bool cacheDisable = false;
+    bool external = false;
+    // The page is physically contiguous, so later lines are offset from its base.
+    u64 physicalPage = 0;
+
+    for(u32 i = 0; i < wordCount;)
+    {
+        const u64 lineAddress = address + i;
+        const u32 lineWords = LineWordCount(lineAddress, wordCount - i);
+        const u32 lineOffset = static_cast<u32>(lineAddress & (LINE_WORD_COUNT - 1));
+
+        // Another lane of this instruction already translated the line, our words combine with its in the store buffer.
+        if(const LaneCoalescer::Line* const merged = m_LaneCoalescer.Find(dispatchPort, group, lineAddress, false))
+        {
+            if(merged->Writable)
+            {
+                m_StoreBuffer.Write(merged->PhysicalAddress + lineOffset, lineWords, values + i, merged->External);
+                m_LaneCoalescer.InvalidatePhysical(merged->PhysicalAddress, merged->External);
+            }
+
+            i += lineWords;
+            continue;
+        }
+
+        ++transactions;
+
+        if(lineAddress / GpuPageWordCount != page)
+        {
+            page = lineAddress / GpuPageWordCount;
+
+            bool success;
+            bool readWrite;
+            bool execute;
+            physicalPage = m_Mmu.TranslateAddress(lineAddress, &success, &readWrite, &execute, &writeThrough, &cacheDisable, &external) - lineAddress % GpuPageWordCount;
+
+            // Cannot write to invalid, read-only, or executable pages.
+            writable = success && readWrite && !execute;
+
+            if(writable)
+            {
+                m_Mmu.MarkDirty(lineAddress);
+            }
+        }
+
+        const u64 physicalAddress = physicalPage + lineAddress % GpuPageWordCount;
+
+        // Write through and uncached stores go straight out, behind any buffered stores to the line.
+        if(writable && (writeThrough || cacheDisable))
+        {
+            m_StoreBuffer.DrainLine(physicalAddress, external);
+            m_Processor->WriteLine(m_SMIndex, physicalAddress, lineWords, values + i, writeThrough, cacheDisable, external);
+        }
+        else if(writable)
+        {
+            m_StoreBuffer.Write(physicalAddress, lineWords, values + i, external);
+        }
+
+        if(writable)
+        {
+            m_LaneCoalescer.InvalidatePhysical(physicalAddress, external);
+        }
+
+        // Write through and uncached lines go out for every lane.
+        if(!writeThrough && !cacheDisable)
+        {
+            if(LaneCoalescer::Line* const recorded = m_LaneCoalescer.Record(dispatchPort, group, lineAddress))
+            {
+                recorded->PhysicalAddress = physicalAddress - lineOffset;
+                recorded->Translated = writable;
+                recorded->Writable = writable;
+                recorded->External = external;
+                recorded->Loaded = false;
+            }
+        }
+
+        i += lineWords;
+    }
+
+    return transactions;
+}
+
+void StreamingMultiprocessor::Atomic(const u64 address, const EAtomicOperation operation, const bool wide, const bool signedCompare, const u32* const operands, u32* const previous) noexcept
+{
+    bool success;
+    bool readWrite;
+    bool execute;
+    bool writeThrough;
+    bool cacheDisable;
+    bool external;
+    const u64 physicalAddress = m_Mmu.TranslateAddress(address, &success, &readWrite, &execute, &writeThrough, &cacheDisable, &external);
+
+    // Cannot modify invalid, read-only, or executable pages.
+    if(!success || !readWrite || execute)
+    {
+        previous[0] = 0xFFFFFFFF;
+        previous[1] = 0xFFFFFFFF;
+        return;
+    }
+
+    m_Mmu.MarkDirty(address);
+
+    // Our own buffered stores to the line go first, then the operation works on the line itself.
+    m_StoreBuffer.DrainLine(physicalAddress, external);
+    m_Processor->Atomic(m_SMIndex, physicalAddress, operation, wide, signedCompare, operands, previous, writeThrough, cacheDisable, external);
+    m_LaneCoalescer.InvalidatePhysical(physicalAddress, external);
+}
+
+void StreamingMultiprocessor::WriteLinePhysical(const u64 physicalAddress, const u32 wordCount, const u32* const values, const bool external) noexcept
+{
+    m_Processor->WriteLine(m_SMIndex, physicalAddress, wordCount, values, false, false, external);
 }
 
 void StreamingMultiprocessor::Prefetch(u64 address) noexcept
@@ -75,16 +296,310 @@ void StreamingMultiprocessor::Prefetch(u64 address) noexcept
         return;
     }
 
+    m_Prefetcher.Request(physicalAddress, external);
+}
+
+void StreamingMultiprocessor::FillLinePhysical(const u64 physicalAddress, const bool external) noexcept
+{
     m_Processor->Prefetch(m_SMIndex, physicalAddress, external);
 }
 
+bool StreamingMultiprocessor::IsCached(const u64 address) noexcept
+{
+    bool success;
+    bool cacheDisable;
+    bool external;
+    const u64 physicalAddress = m_Mmu.TranslateAddress(address, &success, nullptr, nullptr, nullptr, &cacheDisable, &external);
+
+    // An invalid address faults rather than going to memory, there's nothing to wait on.
+    if(!success)
+    {
+        return true;
+    }
+
+    return m_Processor->IsCached(m_SMIndex, physicalAddress, cacheDisable, external);
+}
+
+bool StreamingMultiprocessor::IsCachedPhysical(const u64 physicalAddress, const bool external) noexcept
+{
+    return m_Processor->IsCached(m_SMIndex, physicalAddress, false, external);
+}
+
+u32 StreamingMultiprocessor::PrefetchWait(const u64 address) noexcept
+{
+    bool success;
+    bool cacheDisable;
+    bool external;
+    const u64 physicalAddress = m_Mmu.TranslateAddress(address, &success, nullptr, nullptr, nullptr, &cacheDisable, &external);
+
+    // Uncached pages are never prefetched.
+    if(!success || cacheDisable)
+    {
+        return 0;
+    }
+
+    return m_Prefetcher.MergeDemand(physicalAddress, external);
+}
+
 void StreamingMultiprocessor::FlushCache() noexcept
 {
     m_Processor->FlushCache(m_SMIndex);
 }
 
+u64 StreamingMultiprocessor::CacheStatistic(const ECacheStatistic statistic) const noexcept
+{
+    return m_Processor->CacheStatistic(m_SMIndex, statistic);
+}
+
+void StreamingMultiprocessor::ResetCacheStatistics() noexcept
+{
+    m_Processor->ResetCacheStatistics(m_SMIndex);
+}
+
 void StreamingMultiprocessor::WriteMmuPageInfo(const u64 physicalAddress, const u64 pageTableEntry) noexcept
 {
     m_Processor->Write(m_SMIndex, physicalAddress, static_cast<u32>(pageTableEntry), true, true, false);
     m_Processor->Write(m_SMIndex, physicalAddress + 1, static_cast<u32>(pageTableEntry >> 32), true, true, false);
 }
+
+void StreamingMultiprocessor::BroadcastRegisterWrites() noexcept
+{
+    if(m_RegisterFile.WriteLogOverflowed())
+    {
+        for(u32 coreIndex = 0; coreIndex < 8; ++coreIndex)
+        {
+            m_FpCores[coreIndex].InvalidateOperands();
+            m_IntFpCores[coreIndex].InvalidateOperands();
+        }
+    }
+    else
+    {
+        for(u32 i = 0; i < m_RegisterFile.WriteLogCount(); ++i)
+        {
+            const u32 registerIndex = m_RegisterFile.LoggedWriteRegister(i);
+            const u32 value = m_RegisterFile.LoggedWriteValue(i);
+
+            for(u32 coreIndex = 0; coreIndex < 8; ++coreIndex)
+            {
+                m_FpCores[coreIndex].ObserveRegisterWrite(registerIndex, value);
+                m_IntFpCores[coreIndex].ObserveRegisterWrite(registerIndex, value);
+            }
+        }
+    }
+
+    m_RegisterFile.ClearWriteLog();
+}
+
+bool StreamingMultiprocessor::IsRegisterBlockContested(const u32 baseRegister, const u32 registerCount) const noexcept
+{
+    u8 contestation[RegisterFile::REGISTER_FILE_REGISTER_COUNT];
+    m_RegisterFile.ReadContestation(baseRegister, registerCount, contestation);
+
+    for(u32 i = 0; i < registerCount; ++i)
+    {
+        if(contestation[i] != 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+u16 StreamingMultiprocessor::AllocateRegisters(const u16 registerCount) noexcept
+{
+    u16 registerBase = m_RegisterAllocator.AllocateRegisterBlock(registerCount);
+
+    // There may be enough free registers, just not in one place.
+    if(registerBase == 0xFFFF && CompactRegisters())
+    {
+        registerBase = m_RegisterAllocator.AllocateRegisterBlock(registerCount);
+
+        if(registerBase != 0xFFFF)
+        {
+            ++m_RegisterCompactionRecoveredAllocations;
+        }
+    }
+
+    return registerBase;
+}
+
+void StreamingMultiprocessor::FreeRegisters(const u16 registerBase, const u16 registerCount) noexcept
+{
+    m_RegisterAllocator.FreeRegisterBlock(registerBase, registerCount);
+
+    if(m_RegisterCompactionThreshold != 0 && RegisterFragmentation() >= m_RegisterCompactionThreshold)
+    {
+        (void) CompactRegisters();
+    }
+}
+
+u32 StreamingMultiprocessor::RegisterFragmentation() const noexcept
+{
+    const u16 freeChunks = static_cast<u16>(~OccupiedRegisterChunks());
+    const u32 freeChunkCount = static_cast<u32>(::std::popcount(freeChunks));
+
+    return (freeChunkCount - BitmapRegisterAllocator::LargestFreeRun(freeChunks)) * BitmapRegisterAllocator::CHUNK_REGISTER_COUNT;
+}
+
+u16 StreamingMultiprocessor::OccupiedRegisterChunks() const noexcept
+{
+    u16 occupied = 0;
+
+    for(const WarpScheduler& scheduler : m_WarpSchedulers)
+    {
+        for(u32 warpIndex = 0; warpIndex < WARP_COUNT; ++warpIndex)
+        {
+            const WarpInfo& warp = scheduler.Warp(warpIndex);
+
+            if(warp.RegisterFileResident)
+            {
+                const u32 chunkCount = BitmapRegisterAllocator::BlockChunkCount(static_cast<u16>(warp.TotalRequiredRegisterCount));
+                occupied |= static_cast<u16>(((1u << chunkCount) - 1) << (warp.RegisterFileBase / BitmapRegisterAllocator::CHUNK_REGISTER_COUNT));
+            }
+        }
+    }
+
+    return occupied;
+}
+
+bool StreamingMultiprocessor::CompactRegisters() noexcept
+{
+    struct RegisterBlockMove final
+    {
+        WarpInfo* Warp;
+        u32 DispatchPort;
+        u32 ChunkCount;
+        u16 OldBase;
+        u16 NewBase;
+    };
+
+    RegisterBlockMove blocks[2 * WARP_COUNT];
+    u32 blockCount = 0;
+
+    for(u32 dispatchPort = 0; dispatchPort < 2; ++dispatchPort)
+    {
+        for(u32 warpIndex = 0; warpIndex < WARP_COUNT; ++warpIndex)
+        {
+            WarpInfo& warp = m_WarpSchedulers[dispatchPort].Warp(warpIndex);
+
+            if(!warp.RegisterFileResident)
+            {
+                continue;
+            }
+
+            RegisterBlockMove block;
+            block.Warp = &warp;
+            block.DispatchPort = dispatchPort;
+            block.ChunkCount = BitmapRegisterAllocator::BlockChunkCount(static_cast<u16>(warp.TotalRequiredRegisterCount));
+            block.OldBase = static_cast<u16>(warp.RegisterFileBase);
+            block.NewBase = block.OldBase;
+
+            // Largest first, this packs each column from the bottom and leaves the free space in one run per column.
+            u32 insertIndex = blockCount++;
+
+            for(; insertIndex > 0 && blocks[insertIndex - 1].ChunkCount < block.ChunkCount; --insertIndex)
+            {
+                blocks[insertIndex] = blocks[insertIndex - 1];
+            }
+
+            blocks[insertIndex] = block;
+        }
+    }
+
+    const u32 largestFreeBefore = BitmapRegisterAllocator::LargestFreeRun(static_cast<u16>(~OccupiedRegisterChunks()));
+
+    // Plan on a scratch allocator first, if the packing doesn't fit or doesn't help the live allocator is untouched.
+    SmRegisterAllocator planner;
+    u16 plannedFreeChunks = BitmapRegisterAllocator::ALL_CHUNKS_FREE;
+
+    for(u32 i = 0; i < blockCount; ++i)
+    {
+        blocks[i].NewBase = planner.AllocateRegisterBlock(static_cast<u16>(blocks[i].Warp->TotalRequiredRegisterCount));
+
+        if(blocks[i].NewBase == 0xFFFF)
+        {
+            return false;
+        }
+
+        plannedFreeChunks &= static_cast<u16>(~(((1u << blocks[i].ChunkCount) - 1) << (blocks[i].NewBase / BitmapRegisterAllocator::CHUNK_REGISTER_COUNT)));
+    }
+
+    const u32 largestFreeAfter = BitmapRegisterAllocator::LargestFreeRun(plannedFreeChunks);
+
+    if(largestFreeAfter <= largestFreeBefore)
+    {
+        return false;
+    }
+
+    // Registers with a read or write in flight can't move, the instruction already has the old register index.
+    for(u32 i = 0; i < blockCount; ++i)
+    {
+        if(blocks[i].NewBase == blocks[i].OldBase)
+        {
+            continue;
+        }
+
+        const u32 registerCount = blocks[i].Warp->TotalRequiredRegisterCount + 1;
+        u8 contestation[BitmapRegisterAllocator::CHUNK_REGISTER_COUNT * BitmapRegisterAllocator::COLUMN_CHUNK_COUNT];
+        m_RegisterFile.ReadContestation(blocks[i].OldBase, registerCount, contestation);
+
+        for(u32 j = 0; j < registerCount; ++j)
+        {
+            if(contestation[j] != 0)
+            {
+                ++m_RegisterCompactionsDeferred;
+                return false;
+            }
+        }
+    }
+
+    // Blocks can move onto each other, so gather everything into its new place before writing any of it back.
+    u32 values[RegisterFile::REGISTER_FILE_REGISTER_COUNT];
+
+    for(u32 i = 0; i < blockCount; ++i)
+    {
+        if(blocks[i].NewBase != blocks[i].OldBase)
+        {
+            m_RegisterFile.ReadRegisters(blocks[i].OldBase, blocks[i].Warp->TotalRequiredRegisterCount + 1, &values[blocks[i].NewBase]);
+        }
+    }
+
+    // Replaying the plan on the reset allocator places every block exactly where the planner did.
+    m_RegisterAllocator.Reset();
+
+    for(u32 i = 0; i < blockCount; ++i)
+    {
+        const u32 registerCount = blocks[i].Warp->TotalRequiredRegisterCount + 1;
+
+        [[maybe_unused]] const u16 registerBase = m_RegisterAllocator.AllocateRegisterBlock(static_cast<u16>(registerCount - 1));
+        assert(registerBase == blocks[i].NewBase);
+
+        if(blocks[i].NewBase == blocks[i].OldBase)
+        {
+            continue;
+        }
+
+        m_RegisterFile.WriteRegisters(blocks[i].NewBase, registerCount, &values[blocks[i].NewBase]);
+
+        blocks[i].Warp->RegisterFileBase = blocks[i].NewBase;
+
+        if(blocks[i].Warp == &m_WarpSchedulers[blocks[i].DispatchPort].Warp(m_WarpSchedulers[blocks[i].DispatchPort].CurrentWarp()))
+        {
+            m_DispatchUnits[blocks[i].DispatchPort].RelocateBaseRegisters(blocks[i].OldBase, blocks[i].NewBase);
+        }
+
+        m_RegisterCompactionMovedRegisters += registerCount;
+        m_RegisterCompactionCycles += 2 * ((registerCount + REGISTER_COMPACTION_ROW_REGISTERS - 1) / REGISTER_COMPACTION_ROW_REGISTERS);
+    }
+
+    ++m_RegisterCompactions;
+    m_RegisterCompactionRecoveredRegisters += (largestFreeAfter - largestFreeBefore) * BitmapRegisterAllocator::CHUNK_REGISTER_COUNT;
+
+    if(m_RegisterFile.HasLoggedWrites())
+    {
+        BroadcastRegisterWrites();
+    }
+
+    return true;
+}
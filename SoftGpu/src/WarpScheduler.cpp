@@ -7,70 +7,511 @@
 #include "WarpScheduler.hpp"
 #include "StreamingMultiprocessor.hpp"
 
+#include <algorithm>
+#include <bit>
+
 void WarpScheduler::Clock() noexcept
 {
+    if(m_ActiveWarps)
+    {
+        ++m_ActiveCycles;
+    }
+
+    CountOccupancy();
+
+    switch(m_State)
+    {
+        case EState::Idle:
+            ScheduleNextWarp();
+            break;
+        case EState::Running:
+            if(m_DispatchUnit->IsWarpHalted())
+            {
+                RetireCurrentWarp();
+                break;
+            }
+
+            if(SwitchOnMemoryStall())
+            {
+                break;
+            }
+
+            // Greedy then oldest keeps the current warp until it stalls. Otherwise only yield if there is another warp to run.
+            if(m_Policy != EWarpSchedulingPolicy::GreedyThenOldest && ++m_SliceCycles >= TIME_SLICE_CYCLES && (m_ActiveWarps & ~(1u << m_CurrentWarp)) != 0)
+            {
+                m_DispatchUnit->RequestYield();
+                m_State = EState::Yielding;
+            }
+            break;
+        case EState::Yielding:
+            if(m_DispatchUnit->IsWarpHalted())
+            {
+                RetireCurrentWarp();
+                break;
+            }
+
+            if(SwitchOnMemoryStall())
+            {
+                break;
+            }
+
+            if(m_DispatchUnit->IsAtInstructionBoundary())
+            {
+                SaveCurrentWarp();
+                ++m_WarpSwitches;
+                ScheduleNextWarp();
+            }
+            break;
+        case EState::Spilling:
+            ++m_TransferCycles;
+
+            if(SpillRegisters())
+            {
+                // There may be enough room for the next warp now, or we may need to spill another.
+                ScheduleNextWarp();
+            }
+            break;
+        case EState::Filling:
+            ++m_TransferCycles;
+
+            if(FillRegisters())
+            {
+                LoadWarp(m_TransferWarp);
+            }
+            break;
+        default: break;
+    }
 }
 
-void WarpScheduler::NextWarp(const u64 instructionPointer, const u8 threadEnabledMask, const u8 threadCompletedMask) noexcept
+void WarpScheduler::CountOccupancy() noexcept
 {
+    ++m_Occupancy[static_cast<u32>(EOccupancyStatistic::Cycles)];
+
+    if(!m_ActiveWarps)
+    {
+        return;
+    }
+
+    u32 residentWarps = 0;
+
+    for(const WarpInfo& warp : m_Warps)
     {
-        m_Warps[m_CurrentWarp].InstructionPointer = instructionPointer;
-        m_Warps[m_CurrentWarp].ThreadEnabledMask = threadEnabledMask;
-        m_Warps[m_CurrentWarp].ThreadCompletedMask = threadCompletedMask;
-        
-        const u64 storageAddress = m_Warps[m_CurrentWarp].RegisterFilePointer;
-        u32* const storagePointer = reinterpret_cast<u32*>(storageAddress);
+        residentWarps += static_cast<u32>(warp.RegisterFileResident);
+    }
+
+    m_Occupancy[static_cast<u32>(EOccupancyStatistic::ActiveWarpCycles)] += static_cast<u32>(::std::popcount(m_ActiveWarps));
+    m_Occupancy[static_cast<u32>(EOccupancyStatistic::ResidentWarpCycles)] += residentWarps;
+
+    EOccupancyStatistic cycleState;
 
-        for(u32 i = 0; i <= m_Warps[m_CurrentWarp].TotalRequiredRegisterCount; ++i)
+    if(m_State != EState::Running && m_State != EState::Yielding)
+    {
+        cycleState = EOccupancyStatistic::RegisterAllocationStallCycles;
+    }
+    else
+    {
+        m_Occupancy[static_cast<u32>(EOccupancyStatistic::ActiveLaneCycles)] += static_cast<u32>(::std::popcount(m_DispatchUnit->ReplicationMask()));
+
+        if(m_DispatchUnit->HasIssued())
+        {
+            cycleState = EOccupancyStatistic::IssueCycles;
+        }
+        else if(m_DispatchUnit->IsDependencyStalled())
+        {
+            // The same approximation the memory stall switch uses, a warp with loads outstanding is assumed to be blocked on them.
+            cycleState = (m_WaitingWarps & (1u << m_CurrentWarp)) ? EOccupancyStatistic::MemoryStallCycles : EOccupancyStatistic::ScoreboardStallCycles;
+        }
+        else if(m_DispatchUnit->IsUnitStalled())
+        {
+            cycleState = EOccupancyStatistic::DispatchStallCycles;
+        }
+        else
         {
-            (void) storagePointer;
-            // TODO: FIX
-            // storagePointer[i] = m_SM->GetRegister(m_Warps[m_CurrentWarp].RegisterFileBase + i);
+            // Draining for a yield or a halt, this isn't attributed to anything.
+            return;
         }
+    }
+
+    ++m_Occupancy[static_cast<u32>(cycleState)];
+}
+
+bool WarpScheduler::LaunchWarp(const u64 instructionPointer, const u8 threadEnabledMask, const u8 requiredRegisterCount, const u64 registerFilePointer, const FpMode fpMode) noexcept
+{
+    const u16 freeWarps = static_cast<u16>(~m_ActiveWarps);
+
+    if(!freeWarps || !threadEnabledMask)
+    {
+        return false;
+    }
+
+    // At most 8 threads of 256 registers, this always fits in a block.
+    const u32 totalRegisterCount = static_cast<u32>(::std::popcount(threadEnabledMask)) * (requiredRegisterCount + 1u);
+
+    const u32 warpIndex = static_cast<u32>(::std::countr_zero(freeWarps));
+
+    WarpInfo& warp = m_Warps[warpIndex];
+    warp.InstructionPointer = instructionPointer;
+    warp.RegisterFilePointer = registerFilePointer;
+    warp.RegisterFileResident = false;
+    warp.RegisterFileBase = 0;
+    warp.TotalRequiredRegisterCount = totalRegisterCount - 1;
+    warp.DenormalMode = fpMode.Value;
+    warp.Active = true;
+    warp.OutstandingLoads = 0;
+    warp.RequiredRegisterCount = requiredRegisterCount;
+    warp.ThreadEnabledMask = threadEnabledMask;
+    warp.ThreadActiveMask = threadEnabledMask;
+    warp.ThreadCompletedMask = 0;
+    warp.LaunchSequence = m_LaunchSequence++;
+
+    m_ActiveWarps |= static_cast<u16>(1u << warpIndex);
+
+    return true;
+}
+
+void WarpScheduler::ReportLoadIssued(const u32 warpIndex) noexcept
+{
+    WarpInfo& warp = m_Warps[warpIndex];
+    ++warp.OutstandingLoads;
+    m_WaitingWarps |= static_cast<u16>(1u << warpIndex);
+}
+
+void WarpScheduler::ReportLoadComplete(const u32 warpIndex) noexcept
+{
+    WarpInfo& warp = m_Warps[warpIndex];
+
+    if(warp.OutstandingLoads > 0)
+    {
+        --warp.OutstandingLoads;
+    }
 
-        m_SM->FreeRegisters(m_Warps[m_CurrentWarp].RegisterFileBase, m_Warps[m_CurrentWarp].TotalRequiredRegisterCount);
+    if(warp.OutstandingLoads == 0)
+    {
+        m_WaitingWarps &= static_cast<u16>(~(1u << warpIndex));
     }
+}
 
-    // (m_CurrentWarp + 1) % WARP_COUNT
-    const u8 nextIndex = (m_CurrentWarp + 1) & (WARP_COUNT - 1);
+bool WarpScheduler::SwitchOnMemoryStall() noexcept
+{
+    const u16 currentBit = static_cast<u16>(1u << m_CurrentWarp);
 
-    if(!m_Warps[nextIndex].RegisterFileResident)
+    if(!m_DispatchUnit->IsDependencyStalled() || !(m_WaitingWarps & currentBit))
     {
-        const u64 storageAddress = m_Warps[nextIndex].RegisterFilePointer;
-        const u32* const storagePointer = reinterpret_cast<u32*>(storageAddress);
+        return false;
+    }
 
-        m_Warps[nextIndex].RegisterFileBase = m_SM->AllocateRegisters(m_Warps[nextIndex].TotalRequiredRegisterCount);
+    ++m_MemoryStallCycles;
 
-        for(u32 i = 0; i <= m_Warps[m_CurrentWarp].TotalRequiredRegisterCount; ++i)
-        {
-            (void) storagePointer;
-            // TODO: FIX
-            // m_SM->SetRegister(m_Warps[nextIndex].RegisterFileBase + i, storagePointer[i]);
-        }
+    // Another thread of the warp may already be part way through a vector op, that has to finish first.
+    if(!m_DispatchUnit->CanSwitchWarp())
+    {
+        return false;
+    }
+
+    const u32 nextWarp = SelectNextWarp();
+
+    // Only switch to a warp which can make progress.
+    if(nextWarp == INVALID_WARP || nextWarp == m_CurrentWarp || (m_WaitingWarps & (1u << nextWarp)))
+    {
+        return false;
+    }
+
+    if(m_Policy == EWarpSchedulingPolicy::TwoLevel)
+    {
+        m_ActiveSet &= static_cast<u16>(~currentBit);
+    }
+
+    SaveCurrentWarp();
+    ++m_WarpSwitches;
+    ++m_MemoryStallSwitches;
+
+    m_State = EState::Idle;
+    ResumeWarp(nextWarp);
+
+    return true;
+}
+
+void WarpScheduler::ScheduleNextWarp() noexcept
+{
+    m_State = EState::Idle;
+
+    const u32 nextWarp = SelectNextWarp();
+
+    if(nextWarp == INVALID_WARP)
+    {
+        return;
+    }
+
+    ResumeWarp(nextWarp);
+}
+
+void WarpScheduler::ResumeWarp(const u32 warpIndex) noexcept
+{
+    WarpInfo& warp = m_Warps[warpIndex];
+
+    if(warp.RegisterFileResident)
+    {
+        LoadWarp(warpIndex);
+        return;
+    }
+
+    const u16 registerBase = m_SM->AllocateRegisters(static_cast<u16>(warp.TotalRequiredRegisterCount));
+
+    if(registerBase != 0xFFFF)
+    {
+        // The warp is resident from here on so that a compaction during the fill moves it along with everything else.
+        warp.RegisterFileBase = registerBase;
+        warp.RegisterFileResident = true;
+        m_TransferWarp = static_cast<u8>(warpIndex);
+        m_TransferredRegisters = 0;
+        m_State = EState::Filling;
+        return;
+    }
+
+    const u32 victim = SelectSpillVictim(warpIndex);
+
+    if(victim == INVALID_WARP)
+    {
+        // Everything else in the register file belongs to the other scheduler, wait for it to free something.
+        ++m_AllocationStallCycles;
+        return;
+    }
+
+    m_TransferWarp = static_cast<u8>(victim);
+    m_TransferredRegisters = 0;
+    m_State = EState::Spilling;
+}
+
+void WarpScheduler::SaveCurrentWarp() noexcept
+{
+    WarpInfo& warp = m_Warps[m_CurrentWarp];
+
+    // A warp switched out on a memory stall restarts the instruction it was blocked on.
+    warp.InstructionPointer = m_DispatchUnit->ResumeInstructionPointer();
+    warp.ThreadActiveMask = static_cast<u8>(m_DispatchUnit->ReplicationMask());
+    warp.ThreadCompletedMask = static_cast<u8>(m_DispatchUnit->ReplicationCompletedMask());
+    warp.DenormalMode = m_DispatchUnit->GetFpMode().Value;
+
+    m_DispatchUnit->UnloadWarp();
+}
+
+void WarpScheduler::RetireCurrentWarp() noexcept
+{
+    WarpInfo& warp = m_Warps[m_CurrentWarp];
+
+    // Wait for the last instructions to write back before handing the registers to another warp.
+    if(IsRegisterBlockBusy(warp))
+    {
+        return;
     }
 
-    m_CurrentWarp = nextIndex;
+    m_DispatchUnit->UnloadWarp();
+
+    warp.RegisterFileResident = false;
+    m_SM->FreeRegisters(static_cast<u16>(warp.RegisterFileBase), static_cast<u16>(warp.TotalRequiredRegisterCount));
+
+    warp.Active = false;
+    m_ActiveWarps &= static_cast<u16>(~(1u << m_CurrentWarp));
+    m_ActiveSet &= static_cast<u16>(~(1u << m_CurrentWarp));
+    m_WaitingWarps &= static_cast<u16>(~(1u << m_CurrentWarp));
+    ++m_CompletedWarps;
+
+    ScheduleNextWarp();
+}
+
+void WarpScheduler::LoadWarp(const u32 warpIndex) noexcept
+{
+    const WarpInfo& warp = m_Warps[warpIndex];
 
     u16 baseRegisters[8];
 
     (void) ::std::memset(baseRegisters, 0xFF, sizeof(baseRegisters));
 
     // Iterate through all enabled threads and assign base registers.
-    u8 threadMask = m_Warps[nextIndex].ThreadEnabledMask;
+    u8 threadMask = warp.ThreadEnabledMask;
     u32 registerIndex = 0; // Only needs to be 3 bits
-    u16 currentBaseRegister = m_Warps[nextIndex].RegisterFileBase;
+    u16 currentBaseRegister = static_cast<u16>(warp.RegisterFileBase);
     // This would be better done by checking all bits of the mask simultaneously.
     while(threadMask)
     {
         if((threadMask & 0x1) != 0)
         {
             baseRegisters[registerIndex] = currentBaseRegister;
-            currentBaseRegister += m_Warps[nextIndex].RequiredRegisterCount;
+            // RequiredRegisterCount uses 1 based indexing.
+            currentBaseRegister += warp.RequiredRegisterCount + 1;
         }
 
         threadMask >>= 1;
         ++registerIndex;
     }
 
-    m_SM->LoadWarp(m_Index, m_Warps[nextIndex].ThreadEnabledMask, m_Warps[nextIndex].ThreadCompletedMask, baseRegisters, m_Warps[nextIndex].InstructionPointer);
+    FpMode fpMode { };
+    fpMode.Value = static_cast<u8>(warp.DenormalMode);
+
+    m_DispatchUnit->LoadWarp(warp.ThreadActiveMask, warp.ThreadCompletedMask, baseRegisters, warp.InstructionPointer, fpMode);
+
+    // Promoting a warp into a full two level active set pushes out the members waiting on memory.
+    if(!(m_ActiveSet & (1u << warpIndex)))
+    {
+        if(static_cast<u32>(::std::popcount(m_ActiveSet)) >= ACTIVE_SET_SIZE)
+        {
+            m_ActiveSet &= static_cast<u16>(~m_WaitingWarps);
+        }
+
+        m_ActiveSet |= static_cast<u16>(1u << warpIndex);
+    }
+
+    m_CurrentWarp = static_cast<u8>(warpIndex);
+    m_SliceCycles = 0;
+    m_State = EState::Running;
+}
+
+bool WarpScheduler::IsRegisterBlockBusy(const WarpInfo& warp) const noexcept
+{
+    return m_SM->IsRegisterBlockContested(static_cast<u32>(warp.RegisterFileBase), static_cast<u32>(warp.TotalRequiredRegisterCount) + 1);
+}
+
+bool WarpScheduler::SpillRegisters() noexcept
+{
+    WarpInfo& warp = m_Warps[m_TransferWarp];
+    const u32 registerCount = static_cast<u32>(warp.TotalRequiredRegisterCount) + 1;
+
+    if(m_TransferredRegisters == 0 && IsRegisterBlockBusy(warp))
+    {
+        return false;
+    }
+
+    const u32 end = ::std::min(m_TransferredRegisters + SPILL_REGISTERS_PER_CLOCK, registerCount);
+
+    for(; m_TransferredRegisters < end; ++m_TransferredRegisters)
+    {
+        m_SM->Write(warp.RegisterFilePointer + m_TransferredRegisters, m_SM->GetRegister(static_cast<u32>(warp.RegisterFileBase) + m_TransferredRegisters));
+    }
+
+    if(m_TransferredRegisters < registerCount)
+    {
+        return false;
+    }
+
+    // Mark the warp as spilled before freeing, the free may compact the register file and must not move this block.
+    warp.RegisterFileResident = false;
+    m_SM->FreeRegisters(static_cast<u16>(warp.RegisterFileBase), static_cast<u16>(warp.TotalRequiredRegisterCount));
+
+    ++m_Spills;
+    m_SpilledRegisters += registerCount;
+
+    return true;
+}
+
+bool WarpScheduler::FillRegisters() noexcept
+{
+    const WarpInfo& warp = m_Warps[m_TransferWarp];
+    const u32 registerCount = static_cast<u32>(warp.TotalRequiredRegisterCount) + 1;
+
+    const u32 end = ::std::min(m_TransferredRegisters + SPILL_REGISTERS_PER_CLOCK, registerCount);
+
+    // The base is re-read every clock, a compaction may have moved the block since the fill started.
+    for(; m_TransferredRegisters < end; ++m_TransferredRegisters)
+    {
+        m_SM->SetRegister(static_cast<u32>(warp.RegisterFileBase) + m_TransferredRegisters, m_SM->Read(warp.RegisterFilePointer + m_TransferredRegisters));
+    }
+
+    if(m_TransferredRegisters < registerCount)
+    {
+        return false;
+    }
+
+    ++m_Fills;
+    m_FilledRegisters += registerCount;
+
+    return true;
+}
+
+u32 WarpScheduler::SelectNextWarp() const noexcept
+{
+    if(!m_ActiveWarps)
+    {
+        return INVALID_WARP;
+    }
+
+    // If every warp is waiting on memory fall back to all of them, one of them will be first to be able to continue.
+    const u16 readyWarps = static_cast<u16>(m_ActiveWarps & ~m_WaitingWarps);
+    const u16 candidates = readyWarps ? readyWarps : m_ActiveWarps;
+
+    switch(m_Policy)
+    {
+        case EWarpSchedulingPolicy::GreedyThenOldest:
+            return Oldest(candidates);
+        case EWarpSchedulingPolicy::TwoLevel:
+        {
+            const u16 pendingCandidates = static_cast<u16>(candidates & ~m_ActiveSet);
+
+            // Top the active set up with the oldest pending warp, then round robin within it.
+            if(pendingCandidates && static_cast<u32>(::std::popcount(m_ActiveSet)) < ACTIVE_SET_SIZE)
+            {
+                return Oldest(pendingCandidates);
+            }
+
+            const u16 activeSetCandidates = static_cast<u16>(candidates & m_ActiveSet);
+
+            if(activeSetCandidates)
+            {
+                return NextRoundRobin(activeSetCandidates);
+            }
+
+            return Oldest(candidates);
+        }
+        case EWarpSchedulingPolicy::LooseRoundRobin:
+        default:
+            return NextRoundRobin(candidates);
+    }
+}
+
+u32 WarpScheduler::NextRoundRobin(const u16 mask) const noexcept
+{
+    // Rotate the mask so the warp after the current one is bit 0, the current warp comes last.
+    const u32 start = (m_CurrentWarp + 1u) & (WARP_COUNT - 1);
+    const u16 rotated = ::std::rotr(mask, static_cast<int>(start));
+
+    return (start + static_cast<u32>(::std::countr_zero(rotated))) & (WARP_COUNT - 1);
+}
+
+u32 WarpScheduler::Oldest(u16 mask) const noexcept
+{
+    u32 oldest = INVALID_WARP;
+
+    while(mask)
+    {
+        const u32 warpIndex = static_cast<u32>(::std::countr_zero(mask));
+        mask &= static_cast<u16>(mask - 1);
+
+        if(oldest == INVALID_WARP || m_Warps[warpIndex].LaunchSequence < m_Warps[oldest].LaunchSequence)
+        {
+            oldest = warpIndex;
+        }
+    }
+
+    return oldest;
+}
+
+u32 WarpScheduler::SelectSpillVictim(const u32 incomingWarp) const noexcept
+{
+    // A warp waiting on memory can't be spilled until its loads land, so those are only taken when nothing else is resident.
+    const u16 waitingMasks[2] = { static_cast<u16>(~m_WaitingWarps), m_WaitingWarps };
+
+    for(const u16 waitingMask : waitingMasks)
+    {
+        // Under round robin the warps before the incoming one ran most recently, and will be the last to run again.
+        for(u32 i = 1; i < WARP_COUNT; ++i)
+        {
+            const u32 warpIndex = (incomingWarp - i) & (WARP_COUNT - 1);
+
+            if(m_Warps[warpIndex].RegisterFileResident && (waitingMask & (1u << warpIndex)))
+            {
+                return warpIndex;
+            }
+        }
+    }
+
+    return INVALID_WARP;
 }
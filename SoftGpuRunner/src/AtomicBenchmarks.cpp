@@ -0,0 +1,152 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#include <ConPrinter.hpp>
+
+#include <Processor.hpp>
+#include <StreamingMultiprocessor.hpp>
+#include <WarpScheduler.hpp>
+#include <LoadStore.hpp>
+#include <Atomic.hpp>
+
+#include "KernelAssembly.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <new>
+
+static void BenchmarkAtomicAdds(u32 smCount, bool contended) noexcept;
+
+namespace tau::benchmark::atomic {
+
+void RunBenchmarks() noexcept
+{
+    for(const bool contended : { false, true })
+    {
+        for(u32 smCount = 1; smCount <= 4; ++smCount)
+        {
+            BenchmarkAtomicAdds(smCount, contended);
+        }
+    }
+}
+
+}
+
+static constexpr u32 ATOMIC_COUNT = 64;
+// Adds rotate through this many target registers, so that many can be in flight per thread.
+static constexpr u32 TARGET_REGISTER_COUNT = 8;
+static constexpr u32 THREADS_PER_WARP = 4;
+static constexpr u32 THREAD_REGISTER_COUNT = 16;
+static constexpr u32 CLOCK_LIMIT = 1 << 24;
+
+struct AtomicKernelMemory final
+{
+    alignas(64) u8 Program[1024];
+    // Uncontended SMs each get their own line.
+    alignas(64) u32 Counters[4][8];
+    alignas(64) u32 Registers[4][2][THREADS_PER_WARP][THREAD_REGISTER_COUNT];
+};
+
+// Nothing depends on the previous values, so the only limits are the Ld/St units and who holds the line.
+static void WriteKernel(AtomicKernelMemory& memory) noexcept
+{
+    u8* const program = memory.Program;
+    u32 offset = 0;
+
+    for(u32 i = 0; i < ATOMIC_COUNT; ++i)
+    {
+        const u8 target = static_cast<u8>(4 + i % TARGET_REGISTER_COUNT);
+
+        offset = WriteLoadImmediate(program, offset, target, 1);
+        offset = WriteAtomic(program, offset, EAtomicOperation::Add, false, false, target, 0);
+    }
+
+    program[offset] = static_cast<u8>(EInstruction::Hlt);
+}
+
+static void BenchmarkAtomicAdds(const u32 smCount, const bool contended) noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    AtomicKernelMemory* const memory = new(::std::nothrow) AtomicKernelMemory;
+    (void) ::std::memset(memory, 0, sizeof(*memory));
+    WriteKernel(*memory);
+
+    for(u32 sm = 0; sm < smCount; ++sm)
+    {
+        for(u32 port = 0; port < 2; ++port)
+        {
+            for(u32 thread = 0; thread < THREADS_PER_WARP; ++thread)
+            {
+                WriteBasePointer(memory->Registers[sm][port][thread], memory->Counters[contended ? 0 : sm]);
+            }
+
+            (void) processor->TestLaunchWarp(sm, port, reinterpret_cast<u64>(memory->Program), 0xF, THREAD_REGISTER_COUNT - 1, WordAddress(memory->Registers[sm][port]), FpMode { });
+        }
+    }
+
+    const auto start = ::std::chrono::high_resolution_clock::now();
+
+    u64 cycles = 0;
+    bool active = true;
+
+    for(; cycles < CLOCK_LIMIT && active; ++cycles)
+    {
+        processor->Clock();
+
+        active = false;
+
+        for(u32 sm = 0; sm < smCount; ++sm)
+        {
+            StreamingMultiprocessor& streamingMultiprocessor = processor->TestStreamingMultiprocessor(sm);
+            active = active || streamingMultiprocessor.TestWarpScheduler(0).ActiveWarps() != 0 || streamingMultiprocessor.TestWarpScheduler(1).ActiveWarps() != 0;
+        }
+    }
+
+    const auto end = ::std::chrono::high_resolution_clock::now();
+    const u64 nanoseconds = static_cast<u64>(::std::chrono::duration_cast<::std::chrono::nanoseconds>(end - start).count());
+
+    for(u32 sm = 0; sm < smCount; ++sm)
+    {
+        processor->FlushCache(sm);
+    }
+
+    const u64 totalAtomics = static_cast<u64>(smCount) * 2 * THREADS_PER_WARP * ATOMIC_COUNT;
+
+    u64 counterTotal = 0;
+
+    for(u32 sm = 0; sm < (contended ? 1 : smCount); ++sm)
+    {
+        counterTotal += memory->Counters[sm][0];
+    }
+
+    if(active || counterTotal != totalAtomics)
+    {
+        ConPrinter::PrintLn("Atomic adds on {} SMs counted {} of {}.", smCount, counterTotal, totalAtomics);
+    }
+
+    u64 atomicMisses = 0;
+    u64 orderingStallCycles = 0;
+
+    for(u32 sm = 0; sm < smCount; ++sm)
+    {
+        for(u32 unit = 0; unit < 4; ++unit)
+        {
+            const LoadStore& ldSt = processor->TestStreamingMultiprocessor(sm).TestLoadStore(unit);
+            atomicMisses += ldSt.AtomicMisses();
+            orderingStallCycles += ldSt.OrderingStallCycles();
+        }
+    }
+
+    // Hundredths of an atomic per cycle across all SMs.
+    const u64 atomicsPerCycle = totalAtomics * 100 / cycles;
+
+    ConPrinter::PrintLn("Atomic adds {} on {} SMs: {} cycles, {}.{} atomics per cycle, {} line misses of {}, {} ordering stall clocks, {} ns per cycle.", contended ? "contended" : "uncontended", smCount, cycles, atomicsPerCycle / 100, atomicsPerCycle % 100, atomicMisses, totalAtomics, orderingStallCycles, nanoseconds / cycles);
+
+    delete memory;
+    delete processor;
+}
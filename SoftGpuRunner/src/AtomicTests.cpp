@@ -0,0 +1,608 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#include <ConPrinter.hpp>
+
+#include <Processor.hpp>
+#include <StreamingMultiprocessor.hpp>
+#include <WarpScheduler.hpp>
+#include <LoadStore.hpp>
+#include <Atomic.hpp>
+
+#include "KernelAssembly.hpp"
+
+#include <cstring>
+#include <new>
+
+static void TestAtomicOperations() noexcept;
+static void TestKernelAtomics() noexcept;
+static void TestAddContention(bool wide) noexcept;
+static void TestExchangeContention() noexcept;
+static void TestCompareExchangeContention() noexcept;
+
+namespace tau::test::atomic {
+
+void RunTests() noexcept
+{
+    TestAtomicOperations();
+    TestKernelAtomics();
+    TestAddContention(false);
+    TestAddContention(true);
+    TestExchangeContention();
+    TestCompareExchangeContention();
+}
+
+}
+
+static constexpr u32 CLOCK_LIMIT = 1 << 22;
+static constexpr u32 LINE_WORDS = 8;
+static constexpr u32 SM_COUNT = 4;
+// One warp on each dispatch port of every SM, each with 4 threads.
+static constexpr u32 CONTENDING_WARP_COUNT = SM_COUNT * 2;
+static constexpr u32 THREADS_PER_WARP = 4;
+static constexpr u32 THREAD_COUNT = CONTENDING_WARP_COUNT * THREADS_PER_WARP;
+static constexpr u32 THREAD_REGISTER_COUNT = 16;
+static constexpr u32 CONTENDED_OPERATION_COUNT = 16;
+static constexpr u32 COMPARE_EXCHANGE_ROUND_COUNT = 4;
+// The contention kernels address the atomic target through r0:r1, and their thread's values through r2:r3.
+static constexpr u8 VALUES_REGISTER = 2;
+
+struct OperationCase final
+{
+    EAtomicOperation Operation;
+    bool Wide;
+    bool SignedCompare;
+    u64 Initial;
+    // The operand, and the value to store for a compare exchange.
+    u64 Operand;
+    u64 Desired;
+    u64 Expected;
+};
+
+// Every operation at both widths, straight through the SM, the result checked in memory after a flush.
+static void TestAtomicOperations() noexcept
+{
+    static constexpr OperationCase CASES[] = {
+        { EAtomicOperation::Add, false, false, 5, 7, 0, 12 },
+        { EAtomicOperation::Add, false, false, 0xFFFFFFFF, 2, 0, 1 },
+        { EAtomicOperation::Add, true, false, 0xFFFFFFFF, 1, 0, 0x100000000 },
+        { EAtomicOperation::Min, false, false, 5, 0xFFFFFFFF, 0, 5 },
+        { EAtomicOperation::Min, false, true, 5, 0xFFFFFFFF, 0, 0xFFFFFFFF },
+        { EAtomicOperation::Min, true, true, 1, 0xFFFFFFFFFFFFFFFE, 0, 0xFFFFFFFFFFFFFFFE },
+        { EAtomicOperation::Max, false, false, 5, 0xFFFFFFFF, 0, 0xFFFFFFFF },
+        { EAtomicOperation::Max, false, true, 5, 0xFFFFFFFF, 0, 5 },
+        { EAtomicOperation::Max, true, false, 0x100000000, 0xFFFFFFFF, 0, 0x100000000 },
+        { EAtomicOperation::And, false, false, 0xF0F0, 0xFF00, 0, 0xF000 },
+        { EAtomicOperation::Or, true, false, 0xF000000000000000, 0x0F, 0, 0xF00000000000000F },
+        { EAtomicOperation::Xor, false, false, 0xFFFF, 0x0FF0, 0, 0xF00F },
+        { EAtomicOperation::Exchange, true, false, 0x1111111122222222, 0x3333333344444444, 0, 0x3333333344444444 },
+        { EAtomicOperation::CompareExchange, false, false, 9, 9, 0xC0DE, 0xC0DE },
+        { EAtomicOperation::CompareExchange, false, false, 9, 8, 0xC0DE, 9 },
+        { EAtomicOperation::CompareExchange, true, false, 0xAAAAAAAA00000009, 0xAAAAAAAA00000009, 0x0123456789ABCDEF, 0x0123456789ABCDEF },
+        { EAtomicOperation::CompareExchange, true, false, 0xAAAAAAAA00000009, 0xBBBBBBBB00000009, 0x0123456789ABCDEF, 0xAAAAAAAA00000009 },
+    };
+
+    static constexpr u32 CASE_COUNT = static_cast<u32>(::std::size(CASES));
+
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    // Each case gets its own pair of words, followed by a pair which must not change.
+    alignas(64) u32 data[CASE_COUNT * 4];
+    (void) ::std::memset(data, 0xEE, sizeof(data));
+
+    for(u32 i = 0; i < CASE_COUNT; ++i)
+    {
+        data[i * 4] = static_cast<u32>(CASES[i].Initial);
+        data[i * 4 + 1] = static_cast<u32>(CASES[i].Initial >> 32);
+    }
+
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+
+    u32 failures = 0;
+
+    for(u32 i = 0; i < CASE_COUNT; ++i)
+    {
+        const OperationCase& testCase = CASES[i];
+
+        const u32 wordCount = testCase.Wide ? 2 : 1;
+        u32 operands[4];
+        operands[0] = static_cast<u32>(testCase.Operand);
+        operands[1] = static_cast<u32>(testCase.Operand >> 32);
+        operands[wordCount] = static_cast<u32>(testCase.Desired);
+        operands[wordCount + 1] = static_cast<u32>(testCase.Desired >> 32);
+
+        u32 previous[2] = { 0, 0 };
+        sm.Atomic(WordAddress(&data[i * 4]), testCase.Operation, testCase.Wide, testCase.SignedCompare, operands, previous);
+
+        const u64 initial = testCase.Wide ? testCase.Initial : static_cast<u32>(testCase.Initial);
+        const u64 returned = testCase.Wide ? static_cast<u64>(previous[0]) | (static_cast<u64>(previous[1]) << 32) : previous[0];
+
+        if(returned != initial)
+        {
+            ConPrinter::PrintLn("Atomic case {} returned 0x{XP0}, expected 0x{XP0}.", i, returned, initial);
+            ++failures;
+        }
+    }
+
+    processor->FlushCache(0);
+
+    for(u32 i = 0; i < CASE_COUNT; ++i)
+    {
+        const OperationCase& testCase = CASES[i];
+
+        // A 32 bit operation leaves the high word alone.
+        const u64 expected = testCase.Wide ? testCase.Expected : (testCase.Initial & 0xFFFFFFFF00000000) | static_cast<u32>(testCase.Expected);
+        const u64 stored = static_cast<u64>(data[i * 4]) | (static_cast<u64>(data[i * 4 + 1]) << 32);
+
+        if(stored != expected || data[i * 4 + 2] != 0xEEEEEEEE || data[i * 4 + 3] != 0xEEEEEEEE)
+        {
+            ConPrinter::PrintLn("Atomic case {} left 0x{XP0} in memory, expected 0x{XP0}.", i, stored, expected);
+            ++failures;
+        }
+    }
+
+    // Uncached atomics go straight to memory.
+    u32 uncachedPrevious[2];
+    const u32 uncachedOperand = 0x10;
+    data[2] = 0x20;
+    processor->Atomic(0, WordAddress(&data[2]), EAtomicOperation::Add, false, false, &uncachedOperand, uncachedPrevious, false, true);
+
+    if(data[2] != 0x30 || uncachedPrevious[0] != 0x20)
+    {
+        ConPrinter::PrintLn("Uncached atomic add left 0x{XP0} and returned 0x{XP0}, expected 0x30 and 0x20.", data[2], uncachedPrevious[0]);
+        ++failures;
+    }
+
+    if(failures == 0)
+    {
+        ConPrinter::PrintLn("Successfully applied {} atomic operations.", CASE_COUNT + 1);
+    }
+
+    delete processor;
+}
+
+struct KernelTestMemory final
+{
+    alignas(64) u8 Program[128];
+    alignas(64) u32 Data[2 * LINE_WORDS];
+    alignas(64) u32 Registers[THREAD_REGISTER_COUNT];
+};
+
+// Atomics decoded from a kernel, with an index register, writing the previous value back over their operands.
+static void TestKernelAtomics() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    KernelTestMemory* const memory = new(::std::nothrow) KernelTestMemory;
+    (void) ::std::memset(memory, 0, sizeof(*memory));
+
+    memory->Data[8] = 100;
+    memory->Data[10] = 0x89ABCDEF;
+    memory->Data[11] = 0x01234567;
+    memory->Data[12] = 0xFFFFFFF0;
+    memory->Data[14] = 0x14141414;
+    memory->Data[15] = 0x15151515;
+
+    WriteBasePointer(memory->Registers, memory->Data);
+    memory->Registers[2] = 3;
+    memory->Registers[4] = 10;
+    // Compare against the current value, and store a new one.
+    memory->Registers[6] = 0x89ABCDEF;
+    memory->Registers[7] = 0x01234567;
+    memory->Registers[8] = 0xFEEDFACE;
+    memory->Registers[9] = 0xDEADBEEF;
+    memory->Registers[10] = 3;
+    memory->Registers[12] = 0xAAAAAAAA;
+    memory->Registers[13] = 0xBBBBBBBB;
+
+    u8* const program = memory->Program;
+    u32 offset = 0;
+
+    // Add r4 to [r0:r1 + r2 * 2 + 2], word 8.
+    program[offset++] = static_cast<u8>(EInstruction::Atomic);
+    program[offset++] = static_cast<u8>((1 << 3) | static_cast<u8>(EAtomicOperation::Add));
+    program[offset++] = 0;
+    program[offset++] = 2;
+    program[offset++] = 4;
+    program[offset++] = 2;
+    program[offset++] = 0;
+
+    offset = WriteAtomic(program, offset, EAtomicOperation::CompareExchange, true, false, 6, 10);
+    offset = WriteAtomic(program, offset, EAtomicOperation::Max, false, true, 10, 12);
+    // Word 15 is rounded down to the pair starting at word 14.
+    offset = WriteAtomic(program, offset, EAtomicOperation::Exchange, true, false, 12, 15);
+
+    // A load after the add sees its result.
+    offset = WriteLoadStore(program, offset, false, 0, 14, 8);
+
+    program[offset] = static_cast<u8>(EInstruction::Hlt);
+
+    (void) processor->TestLaunchWarp(0, 0, reinterpret_cast<u64>(program), 0x1, THREAD_REGISTER_COUNT - 1, WordAddress(memory->Registers), FpMode { });
+
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+    const WarpScheduler& scheduler = sm.TestWarpScheduler(0);
+
+    u32 clock = 0;
+
+    for(; clock < CLOCK_LIMIT && scheduler.ActiveWarps() != 0; ++clock)
+    {
+        processor->Clock();
+    }
+
+    processor->FlushCache(0);
+
+    const u32 registerBase = static_cast<u32>(scheduler.Warp(0).RegisterFileBase);
+    u32 registers[THREAD_REGISTER_COUNT];
+
+    for(u32 i = 0; i < THREAD_REGISTER_COUNT; ++i)
+    {
+        registers[i] = sm.GetRegister(registerBase + i);
+    }
+
+    const bool registersCorrect =
+        registers[4] == 100 &&
+        registers[6] == 0x89ABCDEF && registers[7] == 0x01234567 &&
+        registers[10] == 0xFFFFFFF0 &&
+        registers[12] == 0x14141414 && registers[13] == 0x15151515 &&
+        registers[14] == 110;
+
+    const bool memoryCorrect =
+        memory->Data[8] == 110 &&
+        memory->Data[10] == 0xFEEDFACE && memory->Data[11] == 0xDEADBEEF &&
+        memory->Data[12] == 3 &&
+        memory->Data[14] == 0xAAAAAAAA && memory->Data[15] == 0xBBBBBBBB;
+
+    if(clock >= CLOCK_LIMIT)
+    {
+        ConPrinter::PrintLn("Atomic kernel didn't complete in {} clocks.", clock);
+    }
+    else if(!registersCorrect)
+    {
+        ConPrinter::PrintLn("Atomic kernel returned 0x{XP0} 0x{XP0}:0x{XP0} 0x{XP0} 0x{XP0}:0x{XP0}, and loaded 0x{XP0}.", registers[4], registers[7], registers[6], registers[10], registers[13], registers[12], registers[14]);
+    }
+    else if(!memoryCorrect)
+    {
+        ConPrinter::PrintLn("Atomic kernel left 0x{XP0} 0x{XP0}:0x{XP0} 0x{XP0} 0x{XP0}:0x{XP0} in memory.", memory->Data[8], memory->Data[11], memory->Data[10], memory->Data[12], memory->Data[15], memory->Data[14]);
+    }
+    else if(sm.TestLoadStore(0).Atomics() + sm.TestLoadStore(1).Atomics() + sm.TestLoadStore(2).Atomics() + sm.TestLoadStore(3).Atomics() != 4)
+    {
+        ConPrinter::PrintLn("Ld/St units counted the wrong number of atomics.");
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully decoded and executed atomics from a kernel.");
+    }
+
+    delete memory;
+    delete processor;
+}
+
+struct ContentionMemory final
+{
+    alignas(64) u8 Program[1024];
+    // Each round of compare exchange gets its own line.
+    alignas(64) u32 Target[COMPARE_EXCHANGE_ROUND_COUNT * LINE_WORDS];
+    // What each thread loads in, and the previous values each thread stores out.
+    alignas(64) u32 Values[THREAD_COUNT][CONTENDED_OPERATION_COUNT * 2];
+    alignas(64) u32 Registers[THREAD_COUNT][THREAD_REGISTER_COUNT];
+};
+
+[[nodiscard]] static ContentionMemory* CreateContentionMemory() noexcept
+{
+    ContentionMemory* const memory = new(::std::nothrow) ContentionMemory;
+    (void) ::std::memset(memory, 0, sizeof(*memory));
+
+    for(u32 i = 0; i < THREAD_COUNT; ++i)
+    {
+        WriteBasePointer(&memory->Registers[i][0], memory->Target);
+        WriteBasePointer(&memory->Registers[i][VALUES_REGISTER], memory->Values[i]);
+    }
+
+    return memory;
+}
+
+// Runs the program on every thread of every SM at once, then flushes every SM so memory holds the results.
+[[nodiscard]] static bool RunContended(Processor& processor, ContentionMemory& memory) noexcept
+{
+    for(u32 sm = 0; sm < SM_COUNT; ++sm)
+    {
+        for(u32 port = 0; port < 2; ++port)
+        {
+            const u32 warp = sm * 2 + port;
+            (void) processor.TestLaunchWarp(sm, port, reinterpret_cast<u64>(memory.Program), 0xF, THREAD_REGISTER_COUNT - 1, WordAddress(memory.Registers[warp * THREADS_PER_WARP]), FpMode { });
+        }
+    }
+
+    bool active = true;
+
+    for(u32 clock = 0; clock < CLOCK_LIMIT && active; ++clock)
+    {
+        processor.Clock();
+
+        active = false;
+
+        for(u32 sm = 0; sm < SM_COUNT; ++sm)
+        {
+            StreamingMultiprocessor& streamingMultiprocessor = processor.TestStreamingMultiprocessor(sm);
+            active = active || streamingMultiprocessor.TestWarpScheduler(0).ActiveWarps() != 0 || streamingMultiprocessor.TestWarpScheduler(1).ActiveWarps() != 0;
+        }
+    }
+
+    for(u32 sm = 0; sm < SM_COUNT; ++sm)
+    {
+        processor.FlushCache(sm);
+    }
+
+    return !active;
+}
+
+// Every thread on every SM adds 1 to the same counter. Atomic adds hand out each count exactly once.
+static void TestAddContention(const bool wide) noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    ContentionMemory* const memory = CreateContentionMemory();
+
+    // The 64 bit counter carries into its high word part way through.
+    const u64 start = wide ? 0xFFFFFF00 : 0;
+    memory->Target[0] = static_cast<u32>(start);
+    memory->Target[1] = static_cast<u32>(start >> 32);
+
+    u8* const program = memory->Program;
+    u32 offset = 0;
+
+    for(u32 i = 0; i < CONTENDED_OPERATION_COUNT; ++i)
+    {
+        // Rotate through register pairs, so several adds are in flight at once.
+        const u8 target = static_cast<u8>(4 + (i % 4) * 2);
+
+        offset = WriteLoadImmediate(program, offset, target, 1);
+
+        if(wide)
+        {
+            offset = WriteLoadImmediate(program, offset, target + 1, 0);
+        }
+
+        offset = WriteAtomic(program, offset, EAtomicOperation::Add, wide, false, target, 0);
+        offset = WriteLoadStore(program, offset, true, wide ? 1 : 0, target, static_cast<i16>(i * 2), VALUES_REGISTER);
+    }
+
+    program[offset] = static_cast<u8>(EInstruction::Hlt);
+
+    const bool completed = RunContended(*processor, *memory);
+
+    static constexpr u32 TOTAL_ADDS = THREAD_COUNT * CONTENDED_OPERATION_COUNT;
+
+    bool seen[TOTAL_ADDS] = { };
+    u32 duplicates = 0;
+    u32 outOfRange = 0;
+
+    for(u32 thread = 0; thread < THREAD_COUNT; ++thread)
+    {
+        for(u32 i = 0; i < CONTENDED_OPERATION_COUNT; ++i)
+        {
+            const u32* const value = &memory->Values[thread][i * 2];
+            const u64 returned = wide ? static_cast<u64>(value[0]) | (static_cast<u64>(value[1]) << 32) : value[0];
+            const u64 count = returned - start;
+
+            if(count >= TOTAL_ADDS)
+            {
+                ++outOfRange;
+            }
+            else if(seen[count])
+            {
+                ++duplicates;
+            }
+            else
+            {
+                seen[count] = true;
+            }
+        }
+    }
+
+    const u64 counter = static_cast<u64>(memory->Target[0]) | (wide ? static_cast<u64>(memory->Target[1]) << 32 : 0);
+
+    u64 atomicMisses = 0;
+
+    for(u32 sm = 0; sm < SM_COUNT; ++sm)
+    {
+        for(u32 unit = 0; unit < 4; ++unit)
+        {
+            atomicMisses += processor->TestStreamingMultiprocessor(sm).TestLoadStore(unit).AtomicMisses();
+        }
+    }
+
+    if(!completed)
+    {
+        ConPrinter::PrintLn("Contended {} bit adds didn't complete in {} clocks.", wide ? 64 : 32, CLOCK_LIMIT);
+    }
+    else if(counter != start + TOTAL_ADDS)
+    {
+        ConPrinter::PrintLn("Contended {} bit adds left the counter at 0x{XP0}, expected 0x{XP0}.", wide ? 64 : 32, counter, start + TOTAL_ADDS);
+    }
+    else if(duplicates != 0 || outOfRange != 0)
+    {
+        ConPrinter::PrintLn("Contended {} bit adds returned {} duplicate and {} out of range counts.", wide ? 64 : 32, duplicates, outOfRange);
+    }
+    else if(atomicMisses == 0)
+    {
+        ConPrinter::PrintLn("Contended {} bit adds never had to take the line from another SM.", wide ? 64 : 32);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully handed out {} unique counts with {} bit adds from {} threads on {} SMs.", TOTAL_ADDS, wide ? 64 : 32, THREAD_COUNT, SM_COUNT);
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// Every thread swaps its own values into the same word. Each value written comes back out exactly once, or is left behind.
+static void TestExchangeContention() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    ContentionMemory* const memory = CreateContentionMemory();
+
+    static constexpr u32 INITIAL_VALUE = 0xFFFF;
+    memory->Target[0] = INITIAL_VALUE;
+
+    for(u32 thread = 0; thread < THREAD_COUNT; ++thread)
+    {
+        for(u32 i = 0; i < CONTENDED_OPERATION_COUNT; ++i)
+        {
+            memory->Values[thread][i] = (thread << 8) | i;
+        }
+    }
+
+    u8* const program = memory->Program;
+    u32 offset = 0;
+
+    for(u32 i = 0; i < CONTENDED_OPERATION_COUNT; ++i)
+    {
+        const u8 target = static_cast<u8>(4 + i % 8);
+
+        offset = WriteLoadStore(program, offset, false, 0, target, static_cast<i16>(i), VALUES_REGISTER);
+        offset = WriteAtomic(program, offset, EAtomicOperation::Exchange, false, false, target, 0);
+        offset = WriteLoadStore(program, offset, true, 0, target, static_cast<i16>(i), VALUES_REGISTER);
+    }
+
+    program[offset] = static_cast<u8>(EInstruction::Hlt);
+
+    const bool completed = RunContended(*processor, *memory);
+
+    // Each of the written values and the initial value, indexed by thread then operation.
+    static constexpr u32 VALUE_COUNT = THREAD_COUNT * CONTENDED_OPERATION_COUNT;
+
+    u32 seenCount[VALUE_COUNT + 1] = { };
+
+    const auto countValue = [&seenCount](const u32 value)
+    {
+        if(value == INITIAL_VALUE)
+        {
+            ++seenCount[VALUE_COUNT];
+        }
+        else if((value >> 8) < THREAD_COUNT && (value & 0xFF) < CONTENDED_OPERATION_COUNT)
+        {
+            ++seenCount[(value >> 8) * CONTENDED_OPERATION_COUNT + (value & 0xFF)];
+        }
+    };
+
+    for(u32 thread = 0; thread < THREAD_COUNT; ++thread)
+    {
+        for(u32 i = 0; i < CONTENDED_OPERATION_COUNT; ++i)
+        {
+            countValue(memory->Values[thread][i]);
+        }
+    }
+
+    countValue(memory->Target[0]);
+
+    u32 wrongCounts = 0;
+
+    for(const u32 count : seenCount)
+    {
+        wrongCounts += count != 1 ? 1 : 0;
+    }
+
+    if(!completed)
+    {
+        ConPrinter::PrintLn("Contended exchanges didn't complete in {} clocks.", CLOCK_LIMIT);
+    }
+    else if(wrongCounts != 0)
+    {
+        ConPrinter::PrintLn("Contended exchanges lost or duplicated {} values.", wrongCounts);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully exchanged {} values from {} threads on {} SMs without losing any.", VALUE_COUNT, THREAD_COUNT, SM_COUNT);
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// Every thread tries to claim the same empty slots. Exactly one wins each, and the rest see the winner.
+static void TestCompareExchangeContention() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    ContentionMemory* const memory = CreateContentionMemory();
+
+    for(u32 thread = 0; thread < THREAD_COUNT; ++thread)
+    {
+        for(u32 round = 0; round < COMPARE_EXCHANGE_ROUND_COUNT; ++round)
+        {
+            memory->Values[thread][round * 2 + 1] = 0xC1A10000u | (thread << 8) | round;
+        }
+    }
+
+    u8* const program = memory->Program;
+    u32 offset = 0;
+
+    for(u32 round = 0; round < COMPARE_EXCHANGE_ROUND_COUNT; ++round)
+    {
+        const u8 target = static_cast<u8>(4 + (round % 4) * 2);
+
+        // Compare against an empty slot, store this thread's claim.
+        offset = WriteLoadImmediate(program, offset, target, 0);
+        offset = WriteLoadStore(program, offset, false, 0, target + 1, static_cast<i16>(round * 2 + 1), VALUES_REGISTER);
+        offset = WriteAtomic(program, offset, EAtomicOperation::CompareExchange, false, false, target, static_cast<i16>(round * LINE_WORDS));
+        offset = WriteLoadStore(program, offset, true, 0, target, static_cast<i16>(round * 2), VALUES_REGISTER);
+    }
+
+    program[offset] = static_cast<u8>(EInstruction::Hlt);
+
+    const bool completed = RunContended(*processor, *memory);
+
+    u32 failedRounds = 0;
+
+    for(u32 round = 0; round < COMPARE_EXCHANGE_ROUND_COUNT; ++round)
+    {
+        const u32 winnerValue = memory->Target[round * LINE_WORDS];
+        u32 winners = 0;
+        u32 wrongLosers = 0;
+        bool winnerMatches = false;
+
+        for(u32 thread = 0; thread < THREAD_COUNT; ++thread)
+        {
+            const u32 returned = memory->Values[thread][round * 2];
+
+            if(returned == 0)
+            {
+                ++winners;
+                winnerMatches = memory->Values[thread][round * 2 + 1] == winnerValue;
+            }
+            else if(returned != winnerValue)
+            {
+                ++wrongLosers;
+            }
+        }
+
+        if(winners != 1 || !winnerMatches || wrongLosers != 0)
+        {
+            ConPrinter::PrintLn("Compare exchange round {} had {} winners, and {} threads saw something other than the winner's 0x{XP0}.", round, winners, wrongLosers, winnerValue);
+            ++failedRounds;
+        }
+    }
+
+    if(!completed)
+    {
+        ConPrinter::PrintLn("Contended compare exchanges didn't complete in {} clocks.", CLOCK_LIMIT);
+    }
+    else if(failedRounds == 0)
+    {
+        ConPrinter::PrintLn("Successfully let exactly one of {} threads claim each of {} slots with compare exchange.", THREAD_COUNT, COMPARE_EXCHANGE_ROUND_COUNT);
+    }
+
+    delete memory;
+    delete processor;
+}
@@ -0,0 +1,433 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#include <ConPrinter.hpp>
+
+#include <Cache.hpp>
+#include <Processor.hpp>
+#include <StreamingMultiprocessor.hpp>
+#include <WarpScheduler.hpp>
+
+#include "KernelAssembly.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <random>
+
+template<uSys IndexBits, uSys NumSetLines>
+static void BenchmarkLookup() noexcept;
+static void BenchmarkSharedTable(bool inclusive) noexcept;
+static void BenchmarkReplacementTraces() noexcept;
+static void BenchmarkLineTransfers() noexcept;
+
+namespace tau::benchmark::cache {
+
+void RunBenchmarks() noexcept
+{
+    BenchmarkLookup<8, 4>();
+    BenchmarkLookup<10, 8>();
+    BenchmarkLookup<8, 16>();
+    BenchmarkLookup<12, 16>();
+    BenchmarkSharedTable(true);
+    BenchmarkSharedTable(false);
+    BenchmarkReplacementTraces();
+    BenchmarkLineTransfers();
+}
+
+}
+
+static constexpr u32 LOOKUP_COUNT = 1 << 22;
+static constexpr u32 ADDRESS_COUNT = 1 << 16;
+
+static void PrintThroughput(const char* const name, const uSys indexBits, const uSys setLineCount, const u64 checksum, const u64 nanoseconds) noexcept
+{
+    ConPrinter::PrintLn("Cache<{}, {}> {} lookup: {} million lookups per second, checksum {}.", indexBits, setLineCount, name, LOOKUP_COUNT * 1000ull / (nanoseconds ? nanoseconds : 1), checksum);
+}
+
+// Looks up a stream of random line addresses, roughly half of which are resident, with the packed
+// lookup and the line by line walk it replaced.
+template<uSys IndexBits, uSys NumSetLines>
+static void BenchmarkLookup() noexcept
+{
+    using Set = CacheSet<IndexBits, NumSetLines>;
+
+    constexpr uSys SET_COUNT = 1 << IndexBits;
+
+    Set* const sets = new(::std::nothrow) Set[SET_COUNT];
+    u64* const addresses = new(::std::nothrow) u64[ADDRESS_COUNT];
+
+    ::std::mt19937_64 rng(0x5EED0044);
+
+    for(uSys i = 0; i < SET_COUNT; ++i)
+    {
+        sets[i].Reset();
+
+        for(uSys way = 0; way < NumSetLines; ++way)
+        {
+            sets[i].SetTag(way, rng() & 0xFFFF, false);
+        }
+    }
+
+    for(u32 i = 0; i < ADDRESS_COUNT; ++i)
+    {
+        const u64 setIndex = rng() % SET_COUNT;
+        const u64 tag = (rng() & 1) ? sets[setIndex].GetTag(rng() % NumSetLines) : (rng() & 0xFFFF) | 0x10000;
+
+        addresses[i] = (tag << (IndexBits + 3)) | (setIndex << 3);
+    }
+
+    const auto lookup = [sets, addresses](const bool packed) -> u64
+    {
+        u64 checksum = 0;
+
+        for(u32 i = 0; i < LOOKUP_COUNT; ++i)
+        {
+            const u64 address = addresses[i & (ADDRESS_COUNT - 1)];
+            const u64 setIndex = (address >> 3) & (SET_COUNT - 1);
+            const u64 tag = address >> (IndexBits + 3);
+
+            checksum += packed ? sets[setIndex].FindLine(tag, false) : sets[setIndex].FindLineScalar(tag, false);
+        }
+
+        return checksum;
+    };
+
+    for(const bool packed : { false, true })
+    {
+        const auto start = ::std::chrono::high_resolution_clock::now();
+        const u64 checksum = lookup(packed);
+        const auto end = ::std::chrono::high_resolution_clock::now();
+        const u64 nanoseconds = static_cast<u64>(::std::chrono::duration_cast<::std::chrono::nanoseconds>(end - start).count());
+
+        PrintThroughput(packed ? "packed" : "scalar", IndexBits, NumSetLines, checksum, nanoseconds);
+    }
+
+    delete[] addresses;
+    delete[] sets;
+}
+
+// The table lines all share an L0 set, there are twice as many as the L0 has ways, but the L1 holds them all.
+static constexpr u32 TABLE_LINE_COUNT = 8;
+static constexpr u32 TABLE_LINE_STRIDE = 2048;
+static constexpr u32 TABLE_PASS_COUNT = 4;
+static constexpr u32 CLOCK_LIMIT = 1 << 22;
+
+struct SharedTableMemory final
+{
+    alignas(64) u8 Program[512];
+    alignas(64) u32 Table[TABLE_LINE_COUNT * TABLE_LINE_STRIDE];
+    alignas(64) u32 Registers[4][16];
+};
+
+static void WriteSharedTableKernel(SharedTableMemory& memory) noexcept
+{
+    u8* const program = memory.Program;
+    u32 offset = 0;
+
+    for(u32 pass = 0; pass < TABLE_PASS_COUNT; ++pass)
+    {
+        for(u32 i = 0; i < TABLE_LINE_COUNT; ++i)
+        {
+            offset = WriteLoadStore(program, offset, false, 0, static_cast<u8>(4 + i), static_cast<i16>(i * TABLE_LINE_STRIDE));
+        }
+    }
+
+    program[offset] = static_cast<u8>(EInstruction::Hlt);
+}
+
+// Every SM walks the same table, which thrashes each L0. Without the L1 every L0 miss another L0 couldn't supply
+// would have gone to memory, with it only the first touch of each line does.
+static void BenchmarkSharedTable(const bool inclusive) noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->TestCacheController().TestSetL1Inclusive(inclusive);
+    processor->Reset();
+
+    SharedTableMemory* const memory = new(::std::nothrow) SharedTableMemory;
+    (void) ::std::memset(memory, 0, sizeof(*memory));
+    WriteSharedTableKernel(*memory);
+
+    for(u32 sm = 0; sm < 4; ++sm)
+    {
+        WriteBasePointer(memory->Registers[sm], memory->Table);
+
+        (void) processor->TestLaunchWarp(sm, 0, reinterpret_cast<u64>(memory->Program), 0x1, 15, WordAddress(memory->Registers[sm]), FpMode { });
+    }
+
+    const auto active = [processor]() -> bool
+    {
+        for(u32 sm = 0; sm < 4; ++sm)
+        {
+            if(processor->TestStreamingMultiprocessor(sm).TestWarpScheduler(0).ActiveWarps() != 0)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    };
+
+    u32 clocks = 0;
+
+    for(; clocks < CLOCK_LIMIT && active(); ++clocks)
+    {
+        processor->Clock();
+    }
+
+    const CacheController& controller = processor->TestCacheController();
+
+    u64 l0Hits = 0;
+    u64 l0Misses = 0;
+
+    for(u32 sm = 0; sm < 4; ++sm)
+    {
+        l0Hits += controller.L0Hits(sm);
+        l0Misses += controller.L0Misses(sm);
+    }
+
+    const u64 l1Accesses = controller.L1Hits() + controller.L1Misses();
+
+    ConPrinter::PrintLn("Shared table ({} L1): {} clocks, L0 {} hits {} misses, L1 {} hits {} misses, {} memory line reads against {} without the L1.", inclusive ? "inclusive" : "non-inclusive", clocks, l0Hits, l0Misses, controller.L1Hits(), controller.L1Misses(), controller.MemoryLineReads(), l1Accesses);
+
+    delete memory;
+    delete processor;
+}
+
+// The L0's geometry.
+static constexpr uSys TRACE_INDEX_BITS = 8;
+static constexpr uSys TRACE_WAYS = 4;
+static constexpr u32 TRACE_SET_COUNT = 1 << TRACE_INDEX_BITS;
+static constexpr u32 TRACE_CAPACITY_LINES = TRACE_SET_COUNT * TRACE_WAYS;
+static constexpr u32 TRACE_LENGTH = 1 << 20;
+
+// The round robin the cache replaced with before it took a policy, kept per set here.
+template<uSys Ways>
+struct RollingReplacement final
+{
+    u32 Next;
+
+    void Reset() noexcept { Next = 0; }
+    void Insert(const uSys) noexcept { }
+    void Touch(const uSys) noexcept { }
+    [[nodiscard]] uSys Victim() noexcept { return Next++ % Ways; }
+};
+
+// The tags and replacement state of an L0, without the data or coherence, replaying line addresses.
+template<template<uSys> typename ReplacementPolicy>
+struct ReplacementModel final
+{
+    CacheSet<TRACE_INDEX_BITS, TRACE_WAYS> Sets[TRACE_SET_COUNT];
+    ReplacementPolicy<TRACE_WAYS> Replacement[TRACE_SET_COUNT];
+
+    void Reset() noexcept
+    {
+        for(u32 i = 0; i < TRACE_SET_COUNT; ++i)
+        {
+            Sets[i].Reset();
+            Replacement[i].Reset();
+        }
+    }
+
+    // Returns whether the line holding address was resident, filling it if it wasn't.
+    [[nodiscard]] bool Access(const u64 address) noexcept
+    {
+        const u64 setIndex = (address >> 3) & (TRACE_SET_COUNT - 1);
+        const u64 tag = address >> (TRACE_INDEX_BITS + 3);
+
+        CacheSet<TRACE_INDEX_BITS, TRACE_WAYS>& set = Sets[setIndex];
+        uSys way = set.FindLine(tag, false);
+
+        if(way != TRACE_WAYS && set.SetLines[way].Mesi != MesiState::Invalid)
+        {
+            Replacement[setIndex].Touch(way);
+            return true;
+        }
+
+        for(way = 0; way < TRACE_WAYS && set.SetLines[way].Mesi != MesiState::Invalid; ++way)
+        { }
+
+        if(way == TRACE_WAYS)
+        {
+            way = Replacement[setIndex].Victim();
+        }
+
+        set.SetTag(way, tag, false);
+        set.SetLines[way].Mesi = MesiState::Exclusive;
+        Replacement[setIndex].Insert(way);
+        return false;
+    }
+};
+
+enum class ETrace : u32
+{
+    // The shared table kernel, every warp walking 8 lines of a single set.
+    SharedTable = 0,
+    // Lookups into a table of half the L0, each followed by a load streaming through memory.
+    TableAndStream,
+    // Warps loading consecutive lines in a loop over twice the L0.
+    StridedLoop,
+    // Uniformly random lines from one and a half times the L0.
+    Random,
+    Count
+};
+
+[[nodiscard]] static const char* TraceName(const ETrace trace) noexcept
+{
+    switch(trace)
+    {
+        case ETrace::SharedTable: return "shared table";
+        case ETrace::TableAndStream: return "table and stream";
+        case ETrace::StridedLoop: return "strided loop";
+        case ETrace::Random: return "random";
+        default: return "unknown";
+    }
+}
+
+static void GenerateTrace(const ETrace trace, u64* const addresses) noexcept
+{
+    ::std::mt19937_64 rng(0x5EED0048);
+
+    for(u32 i = 0; i < TRACE_LENGTH; ++i)
+    {
+        u64 line = 0;
+
+        switch(trace)
+        {
+            case ETrace::SharedTable:
+                line = (i % TABLE_LINE_COUNT) * (TABLE_LINE_STRIDE / 8);
+                break;
+            case ETrace::TableAndStream:
+                line = (i & 1) ? TRACE_CAPACITY_LINES + i / 2 : rng() % (TRACE_CAPACITY_LINES / 2);
+                break;
+            case ETrace::StridedLoop:
+                line = i % (TRACE_CAPACITY_LINES * 2);
+                break;
+            case ETrace::Random:
+                line = rng() % (TRACE_CAPACITY_LINES * 3 / 2);
+                break;
+            default:
+                break;
+        }
+
+        // Word addresses, with some offset within the line.
+        addresses[i] = line * 8 + (i & 7);
+    }
+}
+
+template<template<uSys> typename ReplacementPolicy>
+static void ReplayTrace(const char* const policyName, const ETrace trace, const u64* const addresses) noexcept
+{
+    ReplacementModel<ReplacementPolicy>* const model = new(::std::nothrow) ReplacementModel<ReplacementPolicy>;
+    model->Reset();
+
+    const auto start = ::std::chrono::high_resolution_clock::now();
+
+    u64 hits = 0;
+
+    for(u32 i = 0; i < TRACE_LENGTH; ++i)
+    {
+        hits += model->Access(addresses[i]) ? 1 : 0;
+    }
+
+    const auto end = ::std::chrono::high_resolution_clock::now();
+    const u64 nanoseconds = static_cast<u64>(::std::chrono::duration_cast<::std::chrono::nanoseconds>(end - start).count());
+
+    const u64 hitRate = hits * 1000 / TRACE_LENGTH;
+
+    ConPrinter::PrintLn("Replacement {} on the {} trace: {}.{}% hits, {} of {} accesses, {} million accesses per second.", policyName, TraceName(trace), hitRate / 10, hitRate % 10, hits, TRACE_LENGTH, TRACE_LENGTH * 1000ull / (nanoseconds ? nanoseconds : 1));
+
+    delete model;
+}
+
+// Replays line address traces shaped like our kernels through an L0 sized model with each replacement
+// policy, and the rolling selector they replaced.
+static void BenchmarkReplacementTraces() noexcept
+{
+    u64* const addresses = new(::std::nothrow) u64[TRACE_LENGTH];
+
+    for(u32 trace = 0; trace < static_cast<u32>(ETrace::Count); ++trace)
+    {
+        GenerateTrace(static_cast<ETrace>(trace), addresses);
+
+        ReplayTrace<RollingReplacement>("rolling", static_cast<ETrace>(trace), addresses);
+        ReplayTrace<TreePlruReplacement>("tree PLRU", static_cast<ETrace>(trace), addresses);
+        ReplayTrace<LruReplacement>("LRU", static_cast<ETrace>(trace), addresses);
+        ReplayTrace<RandomReplacement>("random", static_cast<ETrace>(trace), addresses);
+        ReplayTrace<SrripReplacement>("SRRIP", static_cast<ETrace>(trace), addresses);
+    }
+
+    delete[] addresses;
+}
+
+static constexpr u32 TRANSFER_LINE_COUNT = 1 << 16;
+static constexpr u32 TRANSFER_PASS_COUNT = 16;
+
+// Reads then writes back every line of a buffer larger than the host's L2, a word at a time as the
+// cache controller used to and in a single burst as it does now.
+static void BenchmarkLineTransfers() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    u32* const memory = new(::std::nothrow) u32[TRANSFER_LINE_COUNT * 8];
+    (void) ::std::memset(memory, 0, TRANSFER_LINE_COUNT * 8 * sizeof(u32));
+
+    const u64 baseAddress = WordAddress(memory);
+
+    u64 wordNanoseconds = 0;
+    u64 burstNanoseconds = 0;
+    u64 checksum = 0;
+
+    for(u32 pass = 0; pass < TRANSFER_PASS_COUNT; ++pass)
+    {
+        const bool burst = (pass & 1) != 0;
+        const auto start = ::std::chrono::high_resolution_clock::now();
+
+        for(u32 line = 0; line < TRANSFER_LINE_COUNT; ++line)
+        {
+            const u64 address = baseAddress + line * 8;
+            u32 data[8];
+
+            if(burst)
+            {
+                processor->MemReadPhyBurst(address, 8, data);
+            }
+            else
+            {
+                for(u32 i = 0; i < 8; ++i)
+                {
+                    data[i] = processor->MemReadPhy(address + i);
+                }
+            }
+
+            ++data[line & 7];
+            checksum += data[0];
+
+            if(burst)
+            {
+                processor->MemWritePhyBurst(address, 8, data);
+            }
+            else
+            {
+                for(u32 i = 0; i < 8; ++i)
+                {
+                    processor->MemWritePhy(address + i, data[i]);
+                }
+            }
+        }
+
+        const auto end = ::std::chrono::high_resolution_clock::now();
+        const u64 nanoseconds = static_cast<u64>(::std::chrono::duration_cast<::std::chrono::nanoseconds>(end - start).count());
+
+        (burst ? burstNanoseconds : wordNanoseconds) += nanoseconds;
+    }
+
+    constexpr u64 LINES_PER_KIND = static_cast<u64>(TRANSFER_LINE_COUNT) * (TRANSFER_PASS_COUNT / 2);
+
+    ConPrinter::PrintLn("Line transfers: {} million lines per second by word, {} million by burst, checksum {}.", LINES_PER_KIND * 1000 / (wordNanoseconds ? wordNanoseconds : 1), LINES_PER_KIND * 1000 / (burstNanoseconds ? burstNanoseconds : 1), checksum);
+
+    delete[] memory;
+    delete processor;
+}
@@ -0,0 +1,472 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#include <ConPrinter.hpp>
+
+#include <Cache.hpp>
+#include <Processor.hpp>
+#include <StreamingMultiprocessor.hpp>
+#include <WarpScheduler.hpp>
+#include <DispatchUnit.hpp>
+#include <PCIControlRegisters.hpp>
+
+#include "KernelAssembly.hpp"
+
+#include <cstring>
+#include <new>
+
+static void TestClassifierWithoutReset() noexcept;
+static void TestCompulsoryAndConflictMisses() noexcept;
+static void TestCapacityMisses() noexcept;
+static void TestCoherenceCounters() noexcept;
+static void TestResetCacheStatistics() noexcept;
+static void TestWriteCacheStatistics() noexcept;
+static void TestPciCacheStatistics() noexcept;
+
+namespace tau::test::cache_statistics {
+
+void RunTests() noexcept
+{
+    TestClassifierWithoutReset();
+    TestCompulsoryAndConflictMisses();
+    TestCapacityMisses();
+    TestCoherenceCounters();
+    TestResetCacheStatistics();
+    TestWriteCacheStatistics();
+    TestPciCacheStatistics();
+}
+
+}
+
+static constexpr u32 CLOCK_LIMIT = 1 << 20;
+// Lines this many words apart share an L0 set.
+static constexpr u32 L0_SET_STRIDE = 2048;
+// One more line than the L0 holds, 5 for each of its 4 way sets.
+static constexpr u32 OVERFLOW_LINE_COUNT = 1280;
+
+struct CacheStatisticsTestMemory final
+{
+    alignas(64) u32 Data[OVERFLOW_LINE_COUNT * 8];
+};
+
+[[nodiscard]] static Processor* NewProcessor() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+    return processor;
+}
+
+[[nodiscard]] static u64 Statistic(const Processor& processor, const u32 cacheIndex, const ECacheStatistic statistic) noexcept
+{
+    return processor.CacheStatistic(cacheIndex, statistic);
+}
+
+// Whether every miss of the cache was counted as exactly one of the classes.
+[[nodiscard]] static bool MissesAddUp(const Processor& processor, const u32 cacheIndex) noexcept
+{
+    return Statistic(processor, cacheIndex, ECacheStatistic::Misses) ==
+        Statistic(processor, cacheIndex, ECacheStatistic::CompulsoryMisses) +
+        Statistic(processor, cacheIndex, ECacheStatistic::CapacityMisses) +
+        Statistic(processor, cacheIndex, ECacheStatistic::ConflictMisses) +
+        Statistic(processor, cacheIndex, ECacheStatistic::CoherenceMisses);
+}
+
+// A freshly constructed classifier is usable before its first reset, as the caches are.
+static void TestClassifierWithoutReset() noexcept
+{
+    CacheMissClassifier<4>* const classifier = new(::std::nothrow) CacheMissClassifier<4>;
+
+    // 5 lines through 4 entries, the first of them has been pushed out by the time it's missed again.
+    const EMissClass first = classifier->Miss(0x10);
+    classifier->Hit(0x10);
+
+    for(u64 key = 0x20; key <= 0x50; key += 0x10)
+    {
+        (void) classifier->Miss(key);
+    }
+
+    const EMissClass again = classifier->Miss(0x10);
+    const EMissClass recent = classifier->Miss(0x50);
+
+    if(first != EMissClass::Compulsory || again != EMissClass::Capacity || recent != EMissClass::Conflict)
+    {
+        ConPrinter::PrintLn("Unreset classifier sorted misses as {}, {}, {}, expected compulsory, capacity, conflict.", static_cast<u32>(first), static_cast<u32>(again), static_cast<u32>(recent));
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully classified misses before the first reset.");
+    }
+
+    delete classifier;
+}
+
+// 5 lines in one 4 way set are all compulsory misses, and the first, which the fifth replaced, is then a conflict
+// miss as a fully associative L0 would still hold all 5.
+static void TestCompulsoryAndConflictMisses() noexcept
+{
+    Processor* const processor = NewProcessor();
+    CacheStatisticsTestMemory* const memory = new(::std::nothrow) CacheStatisticsTestMemory;
+
+    for(u32 i = 0; i < 5; ++i)
+    {
+        (void) processor->Read(0, WordAddress(&memory->Data[i * L0_SET_STRIDE]));
+    }
+
+    (void) processor->Read(0, WordAddress(&memory->Data[0]));
+
+    const CacheController& controller = processor->TestCacheController();
+
+    const u64 compulsory = Statistic(*processor, 0, ECacheStatistic::CompulsoryMisses);
+    const u64 conflict = Statistic(*processor, 0, ECacheStatistic::ConflictMisses);
+    const u64 capacity = Statistic(*processor, 0, ECacheStatistic::CapacityMisses);
+    // The refill replaced a second line.
+    const u64 evictions = controller.CacheMesiTransitions(0, MesiState::Exclusive, MesiState::Invalid);
+    const u64 fills = controller.CacheMesiTransitions(0, MesiState::Invalid, MesiState::Exclusive);
+
+    if(compulsory != 5 || conflict != 1 || capacity != 0 || !MissesAddUp(*processor, 0))
+    {
+        ConPrinter::PrintLn("Conflict misses counted {} compulsory, {} conflict, {} capacity misses of {}, expected 5, 1, 0 of 6.", compulsory, conflict, capacity, controller.L0Misses(0));
+    }
+    else if(evictions != 2 || fills != 6 || controller.L0Hits(0) != 0)
+    {
+        ConPrinter::PrintLn("Conflict misses counted {} evictions, {} fills, {} hits, expected 2, 6, 0.", evictions, fills, controller.L0Hits(0));
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully counted compulsory and conflict misses.");
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// Walking one line more than the L0 holds pushes the first lines out of a fully associative L0 as well, so
+// coming back to the first is a capacity miss. The L1 holds them all and refills it.
+static void TestCapacityMisses() noexcept
+{
+    Processor* const processor = NewProcessor();
+    CacheStatisticsTestMemory* const memory = new(::std::nothrow) CacheStatisticsTestMemory;
+
+    for(u32 i = 0; i < OVERFLOW_LINE_COUNT; ++i)
+    {
+        (void) processor->Read(0, WordAddress(&memory->Data[i * 8]));
+    }
+
+    (void) processor->Read(0, WordAddress(&memory->Data[0]));
+    (void) processor->Read(0, WordAddress(&memory->Data[(OVERFLOW_LINE_COUNT - 1) * 8]));
+
+    const CacheController& controller = processor->TestCacheController();
+
+    const u64 compulsory = Statistic(*processor, 0, ECacheStatistic::CompulsoryMisses);
+    const u64 capacity = Statistic(*processor, 0, ECacheStatistic::CapacityMisses);
+    const u64 conflict = Statistic(*processor, 0, ECacheStatistic::ConflictMisses);
+    // A line from each set was replaced by the walk, and one more by the refill.
+    const u64 evictions = controller.CacheMesiTransitions(0, MesiState::Exclusive, MesiState::Invalid);
+    const u64 l1Compulsory = Statistic(*processor, CacheController::L1_LINE_INDEX, ECacheStatistic::CompulsoryMisses);
+
+    if(compulsory != OVERFLOW_LINE_COUNT || capacity != 1 || conflict != 0 || !MissesAddUp(*processor, 0))
+    {
+        ConPrinter::PrintLn("Capacity misses counted {} compulsory, {} capacity, {} conflict misses, expected {}, 1, 0.", compulsory, capacity, conflict, OVERFLOW_LINE_COUNT);
+    }
+    else if(controller.L0Hits(0) != 1 || evictions != 257)
+    {
+        ConPrinter::PrintLn("Capacity misses counted {} hits and {} evictions, expected 1 and 257.", controller.L0Hits(0), evictions);
+    }
+    else if(l1Compulsory != OVERFLOW_LINE_COUNT || controller.L1Misses() != OVERFLOW_LINE_COUNT || controller.L1Hits() != 1 || !MissesAddUp(*processor, CacheController::L1_LINE_INDEX))
+    {
+        ConPrinter::PrintLn("Capacity misses counted {} compulsory L1 misses of {}, and {} L1 hits, expected {} and 1.", l1Compulsory, controller.L1Misses(), controller.L1Hits(), OVERFLOW_LINE_COUNT);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully counted capacity misses.");
+    }
+
+    delete memory;
+    delete processor;
+}
+
+struct ExpectedCount final
+{
+    const char* Name;
+    u64 Count;
+    u64 Expected;
+};
+
+// Prints the first count which isn't as expected, returns whether they all were.
+[[nodiscard]] static bool CheckCounts(const char* const testName, const ExpectedCount* const counts, const u32 countCount) noexcept
+{
+    for(u32 i = 0; i < countCount; ++i)
+    {
+        if(counts[i].Count != counts[i].Expected)
+        {
+            ConPrinter::PrintLn("{} counted {} {}, expected {}.", testName, counts[i].Count, counts[i].Name, counts[i].Expected);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ *   SM 0 reads a line, SM 1 writes it, and SM 0 reads it again, then both
+ * flush. The write invalidates SM 0's exclusive copy, so its second read
+ * is a coherence miss, which SM 1 answers from its modified copy, writing
+ * it back to the L1. Only the L1 flush writes anything to memory.
+ */
+static void RunCoherencePattern(Processor& processor, CacheStatisticsTestMemory& memory) noexcept
+{
+    const u64 address = WordAddress(&memory.Data[0]);
+
+    (void) processor.Read(0, address);
+    processor.Write(1, address, 0x12345678);
+    (void) processor.Read(0, address);
+
+    processor.FlushCache(0);
+    processor.FlushCache(1);
+}
+
+static void TestCoherenceCounters() noexcept
+{
+    Processor* const processor = NewProcessor();
+    CacheStatisticsTestMemory* const memory = new(::std::nothrow) CacheStatisticsTestMemory;
+
+    RunCoherencePattern(*processor, *memory);
+
+    const CacheController& controller = processor->TestCacheController();
+    constexpr u32 L1 = CacheController::L1_LINE_INDEX;
+
+    const ExpectedCount counts[] = {
+        { "SM 0 misses", Statistic(*processor, 0, ECacheStatistic::Misses), 2 },
+        { "SM 0 compulsory misses", Statistic(*processor, 0, ECacheStatistic::CompulsoryMisses), 1 },
+        { "SM 0 coherence misses", Statistic(*processor, 0, ECacheStatistic::CoherenceMisses), 1 },
+        { "SM 0 snoops received", Statistic(*processor, 0, ECacheStatistic::SnoopsReceived), 1 },
+        { "SM 0 snoop hits", Statistic(*processor, 0, ECacheStatistic::SnoopHits), 1 },
+        { "SM 0 invalidations", Statistic(*processor, 0, ECacheStatistic::Invalidations), 1 },
+        { "SM 0 writebacks", Statistic(*processor, 0, ECacheStatistic::Writebacks), 0 },
+        { "SM 0 flushes", Statistic(*processor, 0, ECacheStatistic::Flushes), 1 },
+        { "SM 0 flush writebacks", Statistic(*processor, 0, ECacheStatistic::FlushWritebacks), 0 },
+        { "SM 0 I to E", controller.CacheMesiTransitions(0, MesiState::Invalid, MesiState::Exclusive), 1 },
+        { "SM 0 E to I", controller.CacheMesiTransitions(0, MesiState::Exclusive, MesiState::Invalid), 1 },
+        { "SM 0 I to S", controller.CacheMesiTransitions(0, MesiState::Invalid, MesiState::Shared), 1 },
+        { "SM 1 misses", Statistic(*processor, 1, ECacheStatistic::Misses), 1 },
+        { "SM 1 compulsory misses", Statistic(*processor, 1, ECacheStatistic::CompulsoryMisses), 1 },
+        { "SM 1 snoops received", Statistic(*processor, 1, ECacheStatistic::SnoopsReceived), 1 },
+        { "SM 1 snoop hits", Statistic(*processor, 1, ECacheStatistic::SnoopHits), 1 },
+        { "SM 1 invalidations", Statistic(*processor, 1, ECacheStatistic::Invalidations), 0 },
+        { "SM 1 writebacks", Statistic(*processor, 1, ECacheStatistic::Writebacks), 1 },
+        { "SM 1 I to M", controller.CacheMesiTransitions(1, MesiState::Invalid, MesiState::Modified), 1 },
+        { "SM 1 M to S", controller.CacheMesiTransitions(1, MesiState::Modified, MesiState::Shared), 1 },
+        { "SM 2 snoops received", Statistic(*processor, 2, ECacheStatistic::SnoopsReceived), 0 },
+        { "L1 misses", Statistic(*processor, L1, ECacheStatistic::Misses), 1 },
+        { "L1 hits", Statistic(*processor, L1, ECacheStatistic::Hits), 1 },
+        { "L1 flushes", Statistic(*processor, L1, ECacheStatistic::Flushes), 2 },
+        { "L1 flush writebacks", Statistic(*processor, L1, ECacheStatistic::FlushWritebacks), 1 },
+        { "L1 E to M", controller.CacheMesiTransitions(L1, MesiState::Exclusive, MesiState::Modified), 1 },
+        { "L1 M to E", controller.CacheMesiTransitions(L1, MesiState::Modified, MesiState::Exclusive), 1 },
+        { "snoops sent", controller.SnoopsSent(), 2 },
+        { "snoops filtered", controller.SnoopsFiltered(), 7 },
+        { "snoop hits", controller.SnoopHits(), 2 },
+        { "memory line reads", controller.MemoryLineReads(), 1 },
+        { "memory line writes", controller.MemoryLineWrites(), 1 },
+    };
+
+    if(CheckCounts("Coherence counters", counts, static_cast<u32>(::std::size(counts))) && memory->Data[0] == 0x12345678)
+    {
+        ConPrinter::PrintLn("Successfully counted coherence misses, snoops, transitions, writebacks, and flushes.");
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// Resetting an SM's cache statistics only clears its own L0's, resetting the controller clears them all. The
+// caches keep their lines, so a read afterwards hits.
+static void TestResetCacheStatistics() noexcept
+{
+    Processor* const processor = NewProcessor();
+    CacheStatisticsTestMemory* const memory = new(::std::nothrow) CacheStatisticsTestMemory;
+
+    RunCoherencePattern(*processor, *memory);
+
+    CacheController& controller = processor->TestCacheController();
+
+    processor->ResetCacheStatistics(0);
+
+    const bool ownCleared = Statistic(*processor, 0, ECacheStatistic::Misses) == 0 && controller.CacheMesiTransitions(0, MesiState::Invalid, MesiState::Shared) == 0;
+    const bool othersKept = Statistic(*processor, 1, ECacheStatistic::Misses) == 1 && controller.SnoopsSent() == 2 && controller.L1Hits() == 1;
+
+    controller.ResetStatistics();
+
+    const bool allCleared = Statistic(*processor, 1, ECacheStatistic::Writebacks) == 0 && controller.L1Misses() == 0 && controller.SnoopsSent() == 0 && controller.MemoryLineWrites() == 0;
+
+    (void) processor->Read(0, WordAddress(&memory->Data[0]));
+
+    const bool hit = controller.L0Hits(0) == 1 && controller.L0Misses(0) == 0;
+
+    if(!ownCleared || !othersKept || !allCleared || !hit)
+    {
+        ConPrinter::PrintLn("Resetting cache statistics cleared SM 0 {}, kept the others {}, cleared all {}, then hit {}.", ownCleared, othersKept, allCleared, hit);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully reset cache statistics per L0 and for the whole controller.");
+    }
+
+    delete memory;
+    delete processor;
+}
+
+static constexpr u32 THREAD_REGISTER_COUNT = 16;
+
+struct StatisticsKernelMemory final
+{
+    alignas(64) u8 Program[64];
+    alignas(64) u32 Data[16];
+    alignas(64) u32 Registers[THREAD_REGISTER_COUNT];
+};
+
+[[nodiscard]] static u32 WriteCacheStatistic(u8* const program, u32 offset, const ECacheStatistic statistic, const u8 target, const u8 clockTarget) noexcept
+{
+    program[offset++] = static_cast<u8>(EInstruction::WriteStatistics);
+    program[offset++] = static_cast<u8>(DispatchUnit::CACHE_STATISTIC_BASE + static_cast<u32>(statistic));
+    program[offset++] = target;
+    program[offset++] = clockTarget;
+    return offset;
+}
+
+/*
+ *   The kernel fits in one line, which with the warp's registers is
+ * already in the L0 by the time it resets the statistics. So all it
+ * then misses on are its 2 loads. The add waits for both, so they have
+ * been to the cache before the statistics are written.
+ */
+static void TestWriteCacheStatistics() noexcept
+{
+    Processor* const processor = NewProcessor();
+
+    StatisticsKernelMemory* const memory = new(::std::nothrow) StatisticsKernelMemory;
+    (void) ::std::memset(memory, 0, sizeof(*memory));
+
+    u32 offset = 0;
+    memory->Program[offset++] = static_cast<u8>(EInstruction::ResetStatistics);
+    offset = WriteLoadStore(memory->Program, offset, false, 0, 4, 0);
+    offset = WriteLoadStore(memory->Program, offset, false, 0, 5, 8);
+    offset = WriteAddF(memory->Program, offset, 4, 5, 6);
+    offset = WriteCacheStatistic(memory->Program, offset, ECacheStatistic::Misses, 8, 12);
+    offset = WriteCacheStatistic(memory->Program, offset, ECacheStatistic::CompulsoryMisses, 10, 12);
+    memory->Program[offset] = static_cast<u8>(EInstruction::Hlt);
+
+    WriteBasePointer(memory->Registers, memory->Data);
+
+    (void) processor->TestLaunchWarp(0, 0, reinterpret_cast<u64>(memory->Program), 0x1, THREAD_REGISTER_COUNT - 1, WordAddress(memory->Registers), FpMode { });
+
+    // The registers are read back directly, a store would be counted itself.
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+    const WarpScheduler& scheduler = sm.TestWarpScheduler(0);
+
+    u32 written[4] { };
+    u32 clock = 0;
+
+    for(; clock < CLOCK_LIMIT && scheduler.ActiveWarps() != 0; ++clock)
+    {
+        processor->Clock();
+
+        if(scheduler.State() == WarpScheduler::EState::Running)
+        {
+            const u32 base = static_cast<u32>(scheduler.Warp(0).RegisterFileBase);
+            written[0] = sm.GetRegister(base + 8);
+            written[1] = sm.GetRegister(base + 9);
+            written[2] = sm.GetRegister(base + 10);
+            written[3] = sm.GetRegister(base + 11);
+        }
+    }
+
+    const u64 misses = written[0] | (static_cast<u64>(written[1]) << 32);
+    const u64 compulsory = written[2] | (static_cast<u64>(written[3]) << 32);
+
+    if(clock >= CLOCK_LIMIT)
+    {
+        ConPrinter::PrintLn("Cache statistics kernel didn't complete in {} clocks.", clock);
+    }
+    else if(misses != 2 || compulsory != 2)
+    {
+        ConPrinter::PrintLn("Kernel read {} misses, {} compulsory, expected 2 and 2.", misses, compulsory);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully wrote L0 statistics from a kernel.");
+    }
+
+    delete memory;
+    delete processor;
+}
+
+static void PciWrite(Processor& processor, const u32 address, const u32 value) noexcept
+{
+    PciControlRegistersBus& bus = processor.PciControlRegistersBus();
+    bus.WriteAddress = address;
+    bus.WriteSize = 4;
+    bus.WriteValue = value;
+    bus.WriteBusLocked = 1;
+
+    processor.Clock();
+
+    bus.WriteBusLocked = 0;
+}
+
+[[nodiscard]] static u32 PciRead(Processor& processor, const u32 address) noexcept
+{
+    PciControlRegistersBus& bus = processor.PciControlRegistersBus();
+    bus.ReadAddress = address;
+    bus.ReadSize = 4;
+    bus.ReadBusLocked = 1;
+
+    processor.Clock();
+
+    bus.ReadBusLocked = 0;
+
+    return bus.ReadResponse;
+}
+
+[[nodiscard]] static u64 PciReadCacheStatistic(Processor& processor, const u32 cache, const u32 statistic) noexcept
+{
+    PciWrite(processor, PciControlRegisters::REGISTER_CACHE_STATISTIC_SELECT, (cache << 8) | statistic);
+
+    const u32 low = PciRead(processor, PciControlRegisters::REGISTER_CACHE_STATISTIC_LOW);
+    const u32 high = PciRead(processor, PciControlRegisters::REGISTER_CACHE_STATISTIC_HIGH);
+
+    return low | (static_cast<u64>(high) << 32);
+}
+
+static void TestPciCacheStatistics() noexcept
+{
+    Processor* const processor = NewProcessor();
+    CacheStatisticsTestMemory* const memory = new(::std::nothrow) CacheStatisticsTestMemory;
+
+    RunCoherencePattern(*processor, *memory);
+
+    constexpr u32 CONTROLLER = PciControlRegisters::VALUE_CACHE_STATISTIC_CONTROLLER;
+
+    const ExpectedCount counts[] = {
+        { "SM 0 coherence misses", PciReadCacheStatistic(*processor, 0, static_cast<u32>(ECacheStatistic::CoherenceMisses)), 1 },
+        { "SM 1 writebacks", PciReadCacheStatistic(*processor, 1, static_cast<u32>(ECacheStatistic::Writebacks)), 1 },
+        { "L1 flush writebacks", PciReadCacheStatistic(*processor, CacheController::L1_LINE_INDEX, static_cast<u32>(ECacheStatistic::FlushWritebacks)), 1 },
+        { "SM 1 M to S", PciReadCacheStatistic(*processor, 1, static_cast<u32>(ECacheStatistic::MesiTransitions) + static_cast<u32>(MesiState::Modified) * 4 + static_cast<u32>(MesiState::Shared)), 1 },
+        { "snoops sent", PciReadCacheStatistic(*processor, CONTROLLER, static_cast<u32>(ECacheControllerStatistic::SnoopsSent)), 2 },
+        { "snoops filtered", PciReadCacheStatistic(*processor, CONTROLLER, static_cast<u32>(ECacheControllerStatistic::SnoopsFiltered)), 7 },
+        { "an invalid cache", PciReadCacheStatistic(*processor, CacheController::L1_LINE_INDEX + 1, static_cast<u32>(ECacheStatistic::Misses)), 0 },
+        { "an invalid statistic", PciReadCacheStatistic(*processor, 0, CacheController::CACHE_STATISTIC_COUNT), 0 },
+        { "an invalid controller statistic", PciReadCacheStatistic(*processor, CONTROLLER, CacheController::CONTROLLER_STATISTIC_COUNT), 0 },
+    };
+
+    if(CheckCounts("PCI cache statistics", counts, static_cast<u32>(::std::size(counts))))
+    {
+        ConPrinter::PrintLn("Successfully read cache statistics through the PCI control registers.");
+    }
+
+    delete memory;
+    delete processor;
+}
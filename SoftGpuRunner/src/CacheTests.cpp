@@ -0,0 +1,830 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#include <ConPrinter.hpp>
+
+#include <Cache.hpp>
+#include <Processor.hpp>
+
+#include "KernelAssembly.hpp"
+
+#include <cstring>
+#include <new>
+#include <random>
+
+template<uSys IndexBits, uSys NumSetLines>
+static void TestFindLineDifferential() noexcept;
+static void TestFindLineFirstMatch() noexcept;
+static void TestL1Refill(bool inclusive) noexcept;
+static void TestL1WriteBack(bool inclusive) noexcept;
+static void TestL1Eviction(bool inclusive) noexcept;
+static void TestL1RandomCoherence(bool inclusive) noexcept;
+static void TestSnoopFilterPrivateData() noexcept;
+static void TestSnoopFilterStress(bool inclusive) noexcept;
+static void TestTreePlruOrder() noexcept;
+template<uSys Ways>
+static void TestLruDifferential() noexcept;
+static void TestRandomReplacement() noexcept;
+static void TestSrripOrder() noexcept;
+static void TestReplacementKeepsHotLine() noexcept;
+
+namespace tau::test::cache {
+
+void RunTests() noexcept
+{
+    TestFindLineDifferential<8, 4>();
+    TestFindLineDifferential<10, 8>();
+    TestFindLineDifferential<8, 16>();
+    // Way counts which don't fill a vector exercise the scalar tail.
+    TestFindLineDifferential<8, 3>();
+    TestFindLineDifferential<8, 1>();
+    TestFindLineFirstMatch();
+
+    for(const bool inclusive : { true, false })
+    {
+        TestL1Refill(inclusive);
+        TestL1WriteBack(inclusive);
+        TestL1Eviction(inclusive);
+        TestL1RandomCoherence(inclusive);
+    }
+
+    TestSnoopFilterPrivateData();
+    TestSnoopFilterStress(true);
+    TestSnoopFilterStress(false);
+
+    TestTreePlruOrder();
+    TestLruDifferential<4>();
+    TestLruDifferential<8>();
+    TestRandomReplacement();
+    TestSrripOrder();
+    TestReplacementKeepsHotLine();
+}
+
+}
+
+// Fills sets with tags from a small pool, so probes see hits, misses, and repeated tags, and
+// checks the packed lookup against the line by line walk.
+template<uSys IndexBits, uSys NumSetLines>
+static void TestFindLineDifferential() noexcept
+{
+    CacheSet<IndexBits, NumSetLines>* const cacheSet = new(::std::nothrow) CacheSet<IndexBits, NumSetLines>;
+    cacheSet->Reset();
+
+    ::std::mt19937_64 rng(0x5EED0044 + IndexBits * 64 + NumSetLines);
+    const u64 tagMask = (1ull << (61 - IndexBits)) - 1;
+
+    u64 pool[NumSetLines * 2];
+
+    for(u64& tag : pool)
+    {
+        tag = rng() & tagMask;
+    }
+
+    u32 failures = 0;
+    u32 hits = 0;
+    constexpr u32 PROBE_COUNT = 1 << 18;
+
+    for(u32 i = 0; i < PROBE_COUNT; ++i)
+    {
+        if((i & 0x3F) == 0)
+        {
+            for(uSys way = 0; way < NumSetLines; ++way)
+            {
+                cacheSet->SetTag(way, pool[rng() % ::std::size(pool)], rng() & 1);
+            }
+        }
+
+        const u64 random = rng();
+        // Mostly probe the pool, sometimes the largest tag or one which differs from a pooled tag in a single bit.
+        u64 tag = pool[random % ::std::size(pool)];
+
+        if(((random >> 8) & 0xF) == 0)
+        {
+            tag ^= 1ull << ((random >> 12) % (61 - IndexBits));
+        }
+        else if(((random >> 8) & 0xF) == 1)
+        {
+            tag = tagMask;
+        }
+
+        const bool external = (random >> 20) & 1;
+
+        const uSys way = cacheSet->FindLine(tag, external);
+        const uSys expected = cacheSet->FindLineScalar(tag, external);
+
+        if(way != expected)
+        {
+            ConPrinter::PrintLn("Cache<{}, {}> lookup of tag 0x{XP0} (external {}) found way {}, reference {}.", IndexBits, NumSetLines, tag, external, way, expected);
+            ++failures;
+        }
+        else if(way != NumSetLines)
+        {
+            ++hits;
+        }
+
+        if(failures >= 16)
+        {
+            break;
+        }
+    }
+
+    if(failures == 0)
+    {
+        ConPrinter::PrintLn("Successfully matched the packed tag lookup of Cache<{}, {}> over {} randomized probes, {} of which hit.", IndexBits, NumSetLines, PROBE_COUNT, hits);
+    }
+
+    delete cacheSet;
+}
+
+// A lookup matches on the tag and external bit alone, returns the lowest way when several match, and
+// doesn't look at the MESI state, callers use that to refill an invalidated line in place.
+static void TestFindLineFirstMatch() noexcept
+{
+    CacheSet<8, 8>* const cacheSet = new(::std::nothrow) CacheSet<8, 8>;
+    cacheSet->Reset();
+
+    bool passed = true;
+
+    // A reset set holds tag 0 from internal memory in every way.
+    passed = passed && cacheSet->FindLine(0, false) == 0;
+    passed = passed && cacheSet->FindLine(0, true) == 8;
+
+    cacheSet->SetTag(0, 0x1234, false);
+    cacheSet->SetTag(3, 0x5678, true);
+    cacheSet->SetTag(5, 0x5678, true);
+    cacheSet->SetTag(6, 0x5678, false);
+    cacheSet->SetLines[3].Mesi = MesiState::Invalid;
+    cacheSet->SetLines[5].Mesi = MesiState::Modified;
+
+    passed = passed && cacheSet->FindLine(0x5678, true) == 3;
+    passed = passed && cacheSet->FindLine(0x5678, false) == 6;
+    passed = passed && cacheSet->FindLine(0x1234, true) == 8;
+    passed = passed && cacheSet->FindLine(0, false) == 1;
+    passed = passed && cacheSet->GetTag(5) == 0x5678 && cacheSet->IsExternal(5) && !cacheSet->IsExternal(6);
+
+    if(passed)
+    {
+        ConPrinter::PrintLn("Successfully found the first matching way regardless of MESI state.");
+    }
+    else
+    {
+        ConPrinter::PrintLn("Packed tag lookup did not find the first matching way.");
+    }
+
+    delete cacheSet;
+}
+
+// Lines this many words apart share an L0 set.
+static constexpr u32 L0_SET_STRIDE = 2048;
+// Lines this many words apart share an L1 set.
+static constexpr u32 L1_SET_STRIDE = 8192;
+// Enough lines to fill an L1 set twice over.
+static constexpr u32 CONFLICT_LINE_COUNT = 16;
+
+struct CacheTestMemory final
+{
+    alignas(64) u32 Data[L1_SET_STRIDE * CONFLICT_LINE_COUNT];
+};
+
+[[nodiscard]] static Processor* NewProcessor(const bool inclusive) noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->TestCacheController().TestSetL1Inclusive(inclusive);
+    processor->Reset();
+    return processor;
+}
+
+[[nodiscard]] static const char* InclusionName(const bool inclusive) noexcept
+{
+    return inclusive ? "inclusive" : "non-inclusive";
+}
+
+// A line the L0 evicted is refilled from the L1 without going back to memory.
+static void TestL1Refill(const bool inclusive) noexcept
+{
+    Processor* const processor = NewProcessor(inclusive);
+    CacheTestMemory* const memory = new(::std::nothrow) CacheTestMemory;
+
+    for(u32 i = 0; i < 5; ++i)
+    {
+        memory->Data[i * L0_SET_STRIDE] = 0x1000 + i;
+    }
+
+    const CacheController& controller = processor->TestCacheController();
+
+    u32 failures = 0;
+
+    // 5 lines in a 4 way L0 set, the first is evicted by the last.
+    for(u32 i = 0; i < 5; ++i)
+    {
+        if(processor->Read(0, WordAddress(&memory->Data[i * L0_SET_STRIDE])) != 0x1000 + i)
+        {
+            ++failures;
+        }
+    }
+
+    const bool evicted = !processor->IsCached(0, WordAddress(&memory->Data[0]));
+
+    if(processor->Read(0, WordAddress(&memory->Data[0])) != 0x1000)
+    {
+        ++failures;
+    }
+
+    if(failures != 0 || !evicted)
+    {
+        ConPrinter::PrintLn("L1 refill ({}) read {} wrong values, first line evicted {}.", InclusionName(inclusive), failures, evicted);
+    }
+    else if(controller.L0Misses(0) != 6 || controller.L0Hits(0) != 0 || controller.L1Misses() != 5 || controller.L1Hits() != 1 || controller.MemoryLineReads() != 5)
+    {
+        ConPrinter::PrintLn("L1 refill ({}) counted {} L0 hits, {} L0 misses, {} L1 hits, {} L1 misses, {} memory reads, expected 0, 6, 1, 5, 5.", InclusionName(inclusive), controller.L0Hits(0), controller.L0Misses(0), controller.L1Hits(), controller.L1Misses(), controller.MemoryLineReads());
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully refilled an evicted L0 line from the {} L1.", InclusionName(inclusive));
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// A modified line another L0 snoops is written back as far as the L1, and only a flush takes it to memory.
+static void TestL1WriteBack(const bool inclusive) noexcept
+{
+    Processor* const processor = NewProcessor(inclusive);
+    CacheTestMemory* const memory = new(::std::nothrow) CacheTestMemory;
+    memory->Data[3] = 0x11111111;
+
+    const CacheController& controller = processor->TestCacheController();
+    const u64 address = WordAddress(&memory->Data[3]);
+
+    processor->Write(0, address, 0x22222222);
+    const u32 snooped = processor->Read(1, address);
+    const u32 beforeFlush = memory->Data[3];
+    const u64 writesBeforeFlush = controller.MemoryLineWrites();
+
+    processor->FlushCache(0);
+
+    const u32 afterFlush = memory->Data[3];
+
+    if(snooped != 0x22222222)
+    {
+        ConPrinter::PrintLn("L1 write back ({}) snooped 0x{XP0} from the modified L0.", InclusionName(inclusive), snooped);
+    }
+    else if(beforeFlush != 0x11111111 || writesBeforeFlush != 0)
+    {
+        ConPrinter::PrintLn("L1 write back ({}) reached memory before the flush, 0x{XP0} after {} line writes.", InclusionName(inclusive), beforeFlush, writesBeforeFlush);
+    }
+    else if(afterFlush != 0x22222222 || controller.MemoryLineWrites() != 1)
+    {
+        ConPrinter::PrintLn("L1 write back ({}) flushed 0x{XP0} with {} line writes.", InclusionName(inclusive), afterFlush, controller.MemoryLineWrites());
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully wrote a snooped line back through the {} L1.", InclusionName(inclusive));
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// Filling an L1 set evicts a line SM 0 has modified. An inclusive L1 takes it from the L0 and writes it to
+// memory, a non-inclusive L1 leaves it modified in the L0.
+static void TestL1Eviction(const bool inclusive) noexcept
+{
+    Processor* const processor = NewProcessor(inclusive);
+    CacheTestMemory* const memory = new(::std::nothrow) CacheTestMemory;
+    memory->Data[0] = 0x11111111;
+
+    const CacheController& controller = processor->TestCacheController();
+    const u64 address = WordAddress(&memory->Data[0]);
+
+    processor->Write(0, address, 0x22222222);
+
+    // The 8 ways of the set are the modified line and 7 of these, the 8th evicts the oldest.
+    for(u32 i = 1; i <= 8; ++i)
+    {
+        (void) processor->Read(1, WordAddress(&memory->Data[i * L1_SET_STRIDE]));
+    }
+
+    const bool cached = processor->IsCached(0, address);
+    const u32 beforeFlush = memory->Data[0];
+
+    processor->FlushCache(0);
+
+    const u32 afterFlush = memory->Data[0];
+
+    const bool expectedCached = !inclusive;
+    const u32 expectedBeforeFlush = inclusive ? 0x22222222 : 0x11111111;
+    const u64 expectedBackInvalidations = inclusive ? 1 : 0;
+
+    if(cached != expectedCached || beforeFlush != expectedBeforeFlush || afterFlush != 0x22222222 || controller.BackInvalidations() != expectedBackInvalidations)
+    {
+        ConPrinter::PrintLn("L1 eviction ({}) left the line cached {} with 0x{XP0} in memory, 0x{XP0} after the flush, {} back invalidations.", InclusionName(inclusive), cached, beforeFlush, afterFlush, controller.BackInvalidations());
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully evicted a line modified in an L0 from the {} L1.", InclusionName(inclusive));
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// All 4 L0s read and write words in lines which all fight over the same L0 and L1 sets, every read is checked
+// against a flat reference, and after flushing memory must match it too.
+static void TestL1RandomCoherence(const bool inclusive) noexcept
+{
+    Processor* const processor = NewProcessor(inclusive);
+    CacheTestMemory* const memory = new(::std::nothrow) CacheTestMemory;
+    (void) ::std::memset(memory, 0, sizeof(*memory));
+
+    // Word i of the reference is word i % 8 of conflict line i / 8.
+    u32 reference[CONFLICT_LINE_COUNT * 8] = { };
+
+    ::std::mt19937 rng(0x5EED0045 + inclusive);
+
+    u32 failures = 0;
+    constexpr u32 OPERATION_COUNT = 1 << 16;
+
+    for(u32 i = 0; i < OPERATION_COUNT && failures < 16; ++i)
+    {
+        const u32 random = rng();
+        const u32 core = random & 0x3;
+        const u32 word = (random >> 2) % ::std::size(reference);
+        const u64 address = WordAddress(&memory->Data[(word / 8) * L1_SET_STRIDE + word % 8]);
+        const u32 operation = (random >> 12) & 0xF;
+
+        if(operation == 0)
+        {
+            processor->FlushCache(core);
+        }
+        else if(operation < 6)
+        {
+            reference[word] = rng();
+            processor->Write(core, address, reference[word]);
+        }
+        else
+        {
+            const u32 value = processor->Read(core, address);
+
+            if(value != reference[word])
+            {
+                ConPrinter::PrintLn("L1 coherence ({}) operation {} read 0x{XP0} from word {} on L0 {}, expected 0x{XP0}.", InclusionName(inclusive), i, value, word, core, reference[word]);
+                ++failures;
+            }
+        }
+    }
+
+    for(u32 core = 0; core < CacheController::L0_CACHE_COUNT; ++core)
+    {
+        processor->FlushCache(core);
+    }
+
+    for(u32 word = 0; word < ::std::size(reference) && failures < 16; ++word)
+    {
+        const u32 value = memory->Data[(word / 8) * L1_SET_STRIDE + word % 8];
+
+        if(value != reference[word])
+        {
+            ConPrinter::PrintLn("L1 coherence ({}) flushed 0x{XP0} to word {}, expected 0x{XP0}.", InclusionName(inclusive), value, word, reference[word]);
+            ++failures;
+        }
+    }
+
+    if(failures == 0)
+    {
+        ConPrinter::PrintLn("Successfully kept 4 L0s and the {} L1 coherent over {} randomized accesses.", InclusionName(inclusive), OPERATION_COUNT);
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// Each L0 only touches its own lines, so the filter never lets a snoop through.
+static void TestSnoopFilterPrivateData() noexcept
+{
+    Processor* const processor = NewProcessor(true);
+    CacheTestMemory* const memory = new(::std::nothrow) CacheTestMemory;
+    (void) ::std::memset(memory, 0, sizeof(*memory));
+
+    const CacheController& controller = processor->TestCacheController();
+
+    u32 failures = 0;
+
+    // 5 lines per L0 in the same set, so each L0 also evicts.
+    for(u32 pass = 0; pass < 2; ++pass)
+    {
+        for(u32 core = 0; core < CacheController::L0_CACHE_COUNT; ++core)
+        {
+            for(u32 i = 0; i < 5; ++i)
+            {
+                const u64 address = WordAddress(&memory->Data[(core * 5 + i) * L0_SET_STRIDE]);
+
+                processor->Write(core, address, core * 16 + i);
+
+                if(processor->Read(core, address) != core * 16 + i)
+                {
+                    ++failures;
+                }
+            }
+        }
+    }
+
+    // Every write on the first pass misses, and the fifth line evicts the first. On the second pass tree PLRU
+    // replaces lines 2, 3, 4 and 0 in turn, so only line 1 hits.
+    const u64 fills = CacheController::L0_CACHE_COUNT * (5 + 4);
+
+    if(failures != 0)
+    {
+        ConPrinter::PrintLn("Snoop filter read back {} wrong private values.", failures);
+    }
+    else if(controller.SnoopsSent() != 0 || controller.SnoopsFiltered() != fills * 3)
+    {
+        ConPrinter::PrintLn("Snoop filter sent {} and filtered {} snoops for private data, expected 0 and {}.", controller.SnoopsSent(), controller.SnoopsFiltered(), fills * 3);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully filtered every snoop for private data.");
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// The 4 L0s read, write, and apply atomics to words of lines which fight over the same L0 and L1 sets, with
+// the occasional flush. Every read is checked against a flat reference, and after every operation the
+// snoop filter must say exactly which L0s hold the line touched.
+static void TestSnoopFilterStress(const bool inclusive) noexcept
+{
+    Processor* const processor = NewProcessor(inclusive);
+    CacheTestMemory* const memory = new(::std::nothrow) CacheTestMemory;
+    (void) ::std::memset(memory, 0, sizeof(*memory));
+
+    const CacheController& controller = processor->TestCacheController();
+
+    // Word i of the reference is word i % 8 of conflict line i / 8.
+    u32 reference[CONFLICT_LINE_COUNT * 8] = { };
+
+    const auto wordAddress = [memory](const u32 word) -> u64
+    {
+        return WordAddress(&memory->Data[(word / 8) * L1_SET_STRIDE + word % 8]);
+    };
+
+    // Compares the filter against the L0s for every line, which also catches lines an operation touched indirectly.
+    const auto filterMatches = [processor, &controller, &wordAddress]() -> bool
+    {
+        for(u32 line = 0; line < CONFLICT_LINE_COUNT; ++line)
+        {
+            const u64 address = wordAddress(line * 8);
+            u32 holders = 0;
+
+            for(u32 core = 0; core < CacheController::L0_CACHE_COUNT; ++core)
+            {
+                holders |= processor->IsCached(core, address) ? 1 << core : 0;
+            }
+
+            if(controller.SnoopFilterHolders(address, false) != holders)
+            {
+                ConPrinter::PrintLn("Snoop filter holders 0x{XP0} for line {}, the L0s hold 0x{XP0}.", controller.SnoopFilterHolders(address, false), line, holders);
+                return false;
+            }
+        }
+
+        return true;
+    };
+
+    ::std::mt19937 rng(0x5EED0046 + inclusive);
+
+    u32 failures = 0;
+    constexpr u32 OPERATION_COUNT = 1 << 16;
+
+    for(u32 i = 0; i < OPERATION_COUNT && failures < 16; ++i)
+    {
+        const u32 random = rng();
+        const u32 core = random & 0x3;
+        const u32 word = (random >> 2) % ::std::size(reference);
+        const u64 address = wordAddress(word);
+        const u32 operation = (random >> 12) & 0x1F;
+
+        if(operation == 0)
+        {
+            processor->FlushCache(core);
+        }
+        else if(operation < 8)
+        {
+            reference[word] = rng();
+            processor->Write(core, address, reference[word]);
+        }
+        else if(operation < 12)
+        {
+            // The rest of the line from this word on.
+            const u32 wordCount = 8 - word % 8;
+            u32 values[8];
+
+            for(u32 j = 0; j < wordCount; ++j)
+            {
+                values[j] = rng();
+                reference[word + j] = values[j];
+            }
+
+            processor->WriteLine(core, address, wordCount, values);
+        }
+        else if(operation < 16)
+        {
+            const u32 operand = rng() & 0xFFFF;
+            u32 previous = 0;
+
+            processor->Atomic(core, address, EAtomicOperation::Add, false, false, &operand, &previous);
+
+            if(previous != reference[word])
+            {
+                ConPrinter::PrintLn("Snoop filter stress ({}) operation {} atomic saw 0x{XP0} in word {} on L0 {}, expected 0x{XP0}.", InclusionName(inclusive), i, previous, word, core, reference[word]);
+                ++failures;
+            }
+
+            reference[word] += operand;
+        }
+        else
+        {
+            const u32 value = processor->Read(core, address);
+
+            if(value != reference[word])
+            {
+                ConPrinter::PrintLn("Snoop filter stress ({}) operation {} read 0x{XP0} from word {} on L0 {}, expected 0x{XP0}.", InclusionName(inclusive), i, value, word, core, reference[word]);
+                ++failures;
+            }
+        }
+
+        if(!filterMatches())
+        {
+            ConPrinter::PrintLn("Snoop filter stress ({}) lost track of the L0s after operation {}.", InclusionName(inclusive), i);
+            ++failures;
+            break;
+        }
+    }
+
+    for(u32 core = 0; core < CacheController::L0_CACHE_COUNT; ++core)
+    {
+        processor->FlushCache(core);
+    }
+
+    for(u32 word = 0; word < ::std::size(reference) && failures < 16; ++word)
+    {
+        const u32 value = memory->Data[(word / 8) * L1_SET_STRIDE + word % 8];
+
+        if(value != reference[word])
+        {
+            ConPrinter::PrintLn("Snoop filter stress ({}) flushed 0x{XP0} to word {}, expected 0x{XP0}.", InclusionName(inclusive), value, word, reference[word]);
+            ++failures;
+        }
+    }
+
+    if(failures == 0)
+    {
+        ConPrinter::PrintLn("Successfully kept the snoop filter exact over {} randomized accesses ({} L1), {} snoops sent and {} filtered.", OPERATION_COUNT, InclusionName(inclusive), controller.SnoopsSent(), controller.SnoopsFiltered());
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// Every use points the tree away from the way used, so the victim is the way each level has gone longest without.
+static void TestTreePlruOrder() noexcept
+{
+    TreePlruReplacement<4> plru;
+    plru.Reset();
+
+    bool passed = true;
+
+    for(uSys way = 0; way < 4; ++way)
+    {
+        plru.Insert(way);
+    }
+
+    passed = passed && plru.Victim() == 0;
+    // Looking for a victim doesn't change anything.
+    passed = passed && plru.Victim() == 0;
+    plru.Touch(0);
+    passed = passed && plru.Victim() == 2;
+    plru.Touch(2);
+    passed = passed && plru.Victim() == 1;
+    plru.Touch(1);
+    passed = passed && plru.Victim() == 3;
+
+    // Where it differs from true LRU, after 0 1 2 3 2 0 the upper half is older, and within it 3 was used before 2,
+    // though 1 is the least recently used.
+    plru.Reset();
+
+    for(uSys way = 0; way < 4; ++way)
+    {
+        plru.Insert(way);
+    }
+
+    plru.Touch(2);
+    plru.Touch(0);
+    passed = passed && plru.Victim() == 3;
+
+    TreePlruReplacement<8> wide;
+    wide.Reset();
+
+    for(uSys way = 0; way < 8; ++way)
+    {
+        wide.Insert(way);
+    }
+
+    passed = passed && wide.Victim() == 0;
+    wide.Touch(0);
+    passed = passed && wide.Victim() == 4;
+    wide.Touch(4);
+    passed = passed && wide.Victim() == 2;
+
+    if(passed)
+    {
+        ConPrinter::PrintLn("Successfully evicted in tree PLRU order.");
+    }
+    else
+    {
+        ConPrinter::PrintLn("Tree PLRU evicted out of order.");
+    }
+}
+
+// Checks the ranks against the last use time of each way over a random stream of uses.
+template<uSys Ways>
+static void TestLruDifferential() noexcept
+{
+    LruReplacement<Ways> lru;
+    lru.Reset();
+
+    // An empty set is filled from way 0.
+    bool passed = lru.Victim() == 0;
+
+    u64 lastUse[Ways];
+
+    for(uSys way = 0; way < Ways; ++way)
+    {
+        lru.Insert(way);
+        lastUse[way] = way;
+    }
+
+    ::std::mt19937_64 rng(0x5EED0048 + Ways);
+
+    for(u64 time = Ways; time < (1 << 16) && passed; ++time)
+    {
+        uSys oldest = 0;
+
+        for(uSys way = 1; way < Ways; ++way)
+        {
+            oldest = lastUse[way] < lastUse[oldest] ? way : oldest;
+        }
+
+        passed = lru.Victim() == oldest;
+
+        // Mostly reuse, sometimes replace the victim.
+        const uSys way = (rng() & 3) == 0 ? oldest : static_cast<uSys>(rng() % Ways);
+
+        if(way == oldest)
+        {
+            lru.Insert(way);
+        }
+        else
+        {
+            lru.Touch(way);
+        }
+
+        lastUse[way] = time;
+    }
+
+    if(passed)
+    {
+        ConPrinter::PrintLn("Successfully evicted the least recently used of {} ways.", Ways);
+    }
+    else
+    {
+        ConPrinter::PrintLn("{} way LRU didn't evict the least recently used way.", Ways);
+    }
+}
+
+// Uses don't steer it, every way is picked about as often, and a reset replays the same victims.
+static void TestRandomReplacement() noexcept
+{
+    constexpr u32 DRAW_COUNT = 4096;
+
+    RandomReplacement<4> random;
+    random.Reset();
+
+    u32 counts[4] = { };
+    uSys firstVictims[16];
+
+    for(u32 i = 0; i < DRAW_COUNT; ++i)
+    {
+        random.Touch(i % 4);
+        const uSys victim = random.Victim();
+        random.Insert(victim);
+
+        if(i < ::std::size(firstVictims))
+        {
+            firstVictims[i] = victim;
+        }
+
+        ++counts[victim];
+    }
+
+    bool passed = true;
+
+    for(const u32 count : counts)
+    {
+        passed = passed && count > DRAW_COUNT / 4 - DRAW_COUNT / 16 && count < DRAW_COUNT / 4 + DRAW_COUNT / 16;
+    }
+
+    random.Reset();
+
+    for(const uSys victim : firstVictims)
+    {
+        passed = passed && random.Victim() == victim;
+    }
+
+    if(passed)
+    {
+        ConPrinter::PrintLn("Successfully spread {} random victims over 4 ways, {} {} {} {}.", DRAW_COUNT, counts[0], counts[1], counts[2], counts[3]);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Random replacement picked ways {} {} {} {} times, or didn't repeat after a reset.", counts[0], counts[1], counts[2], counts[3]);
+    }
+}
+
+// A hit line is predicted to be reused soon, and outlives the lines inserted around it.
+static void TestSrripOrder() noexcept
+{
+    SrripReplacement<4> srrip;
+    srrip.Reset();
+
+    bool passed = true;
+
+    for(uSys way = 0; way < 4; ++way)
+    {
+        srrip.Insert(way);
+    }
+
+    srrip.Touch(1);
+
+    // Nothing is distant, so the set ages once and way 0 is the first to get there.
+    passed = passed && srrip.Victim() == 0;
+    passed = passed && srrip.Intervals[1] == 1;
+    srrip.Insert(0);
+    passed = passed && srrip.Victim() == 2;
+    srrip.Insert(2);
+    passed = passed && srrip.Victim() == 3;
+    srrip.Insert(3);
+    // Ageing again, the hit line is still a step behind the rest.
+    passed = passed && srrip.Victim() == 0;
+    passed = passed && srrip.Intervals[1] == 2;
+
+    if(passed)
+    {
+        ConPrinter::PrintLn("Successfully evicted in SRRIP order.");
+    }
+    else
+    {
+        ConPrinter::PrintLn("SRRIP evicted out of order.");
+    }
+}
+
+// A line read between every fill of its set is never evicted, the rolling selector this replaced took it in turn.
+static void TestReplacementKeepsHotLine() noexcept
+{
+    constexpr u32 STREAM_LINE_COUNT = 16;
+
+    Processor* const processor = NewProcessor(true);
+    CacheTestMemory* const memory = new(::std::nothrow) CacheTestMemory;
+    (void) ::std::memset(memory, 0, sizeof(*memory));
+
+    const CacheController& controller = processor->TestCacheController();
+    const u64 hotAddress = WordAddress(&memory->Data[0]);
+
+    (void) processor->Read(0, hotAddress);
+
+    u32 evictions = 0;
+
+    for(u32 i = 1; i <= STREAM_LINE_COUNT; ++i)
+    {
+        (void) processor->Read(0, WordAddress(&memory->Data[i * L0_SET_STRIDE]));
+        evictions += processor->IsCached(0, hotAddress) ? 0 : 1;
+        (void) processor->Read(0, hotAddress);
+    }
+
+    if(evictions != 0 || controller.L0Hits(0) != STREAM_LINE_COUNT || controller.L0Misses(0) != STREAM_LINE_COUNT + 1)
+    {
+        ConPrinter::PrintLn("The hot line was evicted {} times, with {} hits and {} misses, expected 0, {} and {}.", evictions, controller.L0Hits(0), controller.L0Misses(0), STREAM_LINE_COUNT, STREAM_LINE_COUNT + 1);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully kept a hot line through a stream of {} conflicting lines.", STREAM_LINE_COUNT);
+    }
+
+    delete memory;
+    delete processor;
+}
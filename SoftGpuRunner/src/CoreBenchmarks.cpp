@@ -0,0 +1,333 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#include <ConPrinter.hpp>
+
+#include <Core.hpp>
+#include <StreamingMultiprocessor.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <new>
+
+static void BenchmarkCoreClock(const char* name, bool issue, EFpuOp op, EPrecision precision, EBinOp binOp) noexcept;
+
+namespace tau::benchmark::core {
+
+void RunBenchmarks() noexcept
+{
+    BenchmarkCoreClock("idle", false, EFpuOp::BasicBinOp, EPrecision::Single, EBinOp::Add);
+    BenchmarkCoreClock("single add", true, EFpuOp::BasicBinOp, EPrecision::Single, EBinOp::Add);
+    BenchmarkCoreClock("double fma", true, EFpuOp::Fma, EPrecision::Double, EBinOp::Add);
+    BenchmarkCoreClock("half divide", true, EFpuOp::BasicBinOp, EPrecision::Half, EBinOp::Divide);
+}
+
+}
+
+// A copy of the cores as they were before FpCore and IntFpCore became one template, kept as the baseline for it.
+// Each stage has its own slot and the pipeline advances by copying them, the ready flags are separate bits, and the
+// ready report is a virtual call, the CRM made it through its ICore pointer. The register file port and stall
+// handling is brought up to date so both versions do the same work each cycle.
+class LegacyCore : public ICore
+{
+    DEFAULT_DESTRUCT_VI(LegacyCore);
+    DELETE_CM(LegacyCore);
+public:
+    LegacyCore(StreamingMultiprocessor* const sm, const u32 unitIndex, const u32 registerPort, const FpuTimingTable* const timingTable) noexcept
+        : m_SM(sm)
+        , m_UnitIndex(unitIndex)
+        , m_RegisterPort(registerPort)
+        , m_TimingTable(timingTable)
+        , m_Fpu(this, timingTable)
+        , m_CRM(this)
+        , m_Timing{ }
+        , m_PipelineSlot0{ }
+        , m_PipelineSlot1{ }
+        , m_PipelineSlot2{ }
+        , m_Stage0Ready(false)
+        , m_Stage1Ready(false)
+        , m_Stage2Ready(false)
+        , m_IssuePort(0)
+        , m_Pad{ }
+    { }
+
+    void Clock(const u32 clockIndex) noexcept
+    {
+        m_CRM.Clock(clockIndex);
+
+        if(clockIndex == 2)
+        {
+            if(m_Stage2Ready)
+            {
+                m_Fpu.ExecuteInstruction(m_PipelineSlot2);
+            }
+
+            CoreTiming::PendingWrite write;
+            if(!m_CRM.IsWriteStalled() && m_Timing.RetireWriteback(&write))
+            {
+                m_CRM.InitiateRegisterWrite(write.Is64Bit, write.StorageRegister, write.Value);
+            }
+        }
+        else if(clockIndex == 5)
+        {
+            ReportReady();
+
+            m_Timing.ClockIssue();
+
+            (void) ::std::memcpy(&m_PipelineSlot2, &m_PipelineSlot1, sizeof(LoadedFpuInstruction));
+
+            m_Stage2Ready = m_Stage1Ready;
+
+            if(m_CRM.IsReadStalled())
+            {
+                m_Stage1Ready = false;
+            }
+            else
+            {
+                (void) ::std::memcpy(&m_PipelineSlot1, &m_PipelineSlot0, sizeof(LoadedFpuInstruction));
+                m_Stage1Ready = m_Stage0Ready;
+                m_Stage0Ready = false;
+            }
+        }
+    }
+
+    void InvokeRegisterFileHigh(const RegisterFile::CommandPacket packet) noexcept override
+    {
+        m_SM->InvokeCoreRegisterFileHigh(m_RegisterPort, packet);
+    }
+
+    void InvokeRegisterFileLow(const RegisterFile::CommandPacket packet) noexcept override
+    {
+        m_SM->InvokeCoreRegisterFileLow(m_RegisterPort, packet);
+    }
+
+    void ReleaseRegisterContestation(const u32 registerIndex) noexcept override
+    {
+        m_SM->ReleaseRegisterContestation(registerIndex);
+    }
+
+    void InitiateInstruction(const FpuInstruction fpuInstruction) noexcept
+    {
+        m_Timing.BeginIssue(m_TimingTable->Lookup(fpuInstruction.Operation, fpuInstruction.Precision, fpuInstruction.OperandC).InitiationInterval);
+
+        m_CRM.InitiateRegisterRead(fpuInstruction.Precision == EPrecision::Double, RequiredRegisterCount(fpuInstruction.Operation), fpuInstruction.OperandA, fpuInstruction.OperandB, fpuInstruction.OperandC);
+
+        m_PipelineSlot0.DispatchPort = fpuInstruction.DispatchPort;
+        m_IssuePort = fpuInstruction.DispatchPort;
+        m_PipelineSlot0.Operation = fpuInstruction.Operation;
+        m_PipelineSlot0.Precision = fpuInstruction.Precision;
+        m_PipelineSlot0.StorageRegister = fpuInstruction.StorageRegister;
+        m_PipelineSlot0.FlushToZero = fpuInstruction.FlushToZero;
+        m_PipelineSlot0.DenormalsAreZero = fpuInstruction.DenormalsAreZero;
+        m_PipelineSlot0.OperandA = fpuInstruction.OperandA;
+        m_PipelineSlot0.OperandB = fpuInstruction.OperandB;
+        m_PipelineSlot0.OperandC = fpuInstruction.OperandC;
+
+        m_Stage0Ready = true;
+    }
+
+    void ReportRegisterValues(const u64 a, const u64 b, const u64 c) noexcept override
+    {
+        switch(RequiredRegisterCount(m_PipelineSlot0.Operation))
+        {
+            case 2:
+                m_PipelineSlot0.OperandC = c;
+            case 1:
+                m_PipelineSlot0.OperandB = b;
+            case 0:
+                m_PipelineSlot0.OperandA = a;
+            default: break;
+        }
+    }
+
+    void PrepareRegisterWrite(const bool is64Bit, const u32 storageRegister, const u64 value) noexcept override
+    {
+        m_Timing.ScheduleWriteback(is64Bit, storageRegister, value, m_Fpu.ExecutionStage());
+    }
+
+    [[nodiscard]] const CoreTiming& Timing() const noexcept { return m_Timing; }
+    [[nodiscard]] const CoreRegisterManager& RegisterManager() const noexcept { return m_CRM; }
+protected:
+    // Whether the core has to report a structural stall rather than being ready.
+    [[nodiscard]] bool IsStalled() const noexcept
+    {
+        return m_Timing.IsIssueBlocked() || m_CRM.IsReadStalled();
+    }
+protected:
+    StreamingMultiprocessor* m_SM;
+    u32 m_UnitIndex;
+    u32 m_RegisterPort;
+    const FpuTimingTable* m_TimingTable;
+    Fpu m_Fpu;
+    CoreRegisterManager m_CRM;
+    CoreTiming m_Timing;
+
+    LoadedFpuInstruction m_PipelineSlot0;
+    LoadedFpuInstruction m_PipelineSlot1;
+    LoadedFpuInstruction m_PipelineSlot2;
+
+    u8 m_Stage0Ready : 1;
+    u8 m_Stage1Ready : 1;
+    u8 m_Stage2Ready : 1;
+    u8 m_IssuePort : 1;
+    u8 m_Pad : 4;
+};
+
+class LegacyFpCore final : public LegacyCore
+{
+    DEFAULT_DESTRUCT(LegacyFpCore);
+    DELETE_CM(LegacyFpCore);
+public:
+    LegacyFpCore(StreamingMultiprocessor* const sm, const u32 unitIndex, const FpuTimingTable* const timingTable) noexcept
+        : LegacyCore(sm, unitIndex, unitIndex, timingTable)
+    { }
+
+    void ReportReady() const noexcept override
+    {
+        if(IsStalled())
+        {
+            m_SM->ReportCoreStructuralStall(m_IssuePort);
+            return;
+        }
+
+        m_SM->ReportFpCoreReady(m_UnitIndex);
+    }
+};
+
+class LegacyIntFpCore final : public LegacyCore
+{
+    DEFAULT_DESTRUCT(LegacyIntFpCore);
+    DELETE_CM(LegacyIntFpCore);
+public:
+    LegacyIntFpCore(StreamingMultiprocessor* const sm, const u32 unitIndex, const FpuTimingTable* const timingTable) noexcept
+        : LegacyCore(sm, unitIndex, 8 + unitIndex, timingTable)
+    { }
+
+    void ReportReady() const noexcept override
+    {
+        if(IsStalled())
+        {
+            m_SM->ReportCoreStructuralStall(m_IssuePort);
+            return;
+        }
+
+        m_SM->ReportIntFpCoreReady(m_UnitIndex);
+    }
+};
+
+static FpuInstruction MakeBenchmarkInstruction(const EFpuOp op, const EPrecision precision, const EBinOp binOp) noexcept
+{
+    FpuInstruction instruction;
+    instruction.DispatchPort = 0;
+    instruction.Operation = op;
+    instruction.Precision = precision;
+    instruction.FlushToZero = 0;
+    instruction.DenormalsAreZero = 0;
+    instruction.Reserved0 = 0;
+    instruction.OperandA = 0;
+    instruction.OperandB = 2;
+    instruction.OperandC = static_cast<u32>(binOp);
+    instruction.StorageRegister = 4;
+    instruction.Reserved1 = 0;
+    return instruction;
+}
+
+// Clocks a bank of 8 FP and 8 Int/FP cores the way the SM does, issuing to each whenever it could report ready. The
+// register file is clocked once per sub-clock rather than after every core, it serves every port in one clock and
+// would otherwise dominate the measurement, as would the load/store and dispatch units which are left out. Bank
+// conflicts aren't modelled, all 16 cores use the same registers and would spend most cycles stalled. Returns the
+// nanoseconds taken.
+template<typename TFpCore, typename TIntFpCore>
+static u64 TimeCoreClock(StreamingMultiprocessor* const sm, const u32 cycleCount, const bool issue, const FpuInstruction instruction, u64* const issued) noexcept
+{
+    const FpuTimingTable& timingTable = sm->GetFpuTimingTable();
+
+    TFpCore* const fpCores = static_cast<TFpCore*>(::operator new(sizeof(TFpCore) * 8, ::std::nothrow));
+    TIntFpCore* const intFpCores = static_cast<TIntFpCore*>(::operator new(sizeof(TIntFpCore) * 8, ::std::nothrow));
+
+    for(u32 i = 0; i < 8; ++i)
+    {
+        new(&fpCores[i]) TFpCore(sm, i, &timingTable);
+        new(&intFpCores[i]) TIntFpCore(sm, i, &timingTable);
+    }
+
+    *issued = 0;
+
+    const auto start = ::std::chrono::high_resolution_clock::now();
+
+    for(u32 cycle = 0; cycle < cycleCount; ++cycle)
+    {
+        if(issue)
+        {
+            for(u32 i = 0; i < 8; ++i)
+            {
+                if(!fpCores[i].Timing().IsIssueBlocked() && !fpCores[i].RegisterManager().IsReadStalled())
+                {
+                    fpCores[i].InitiateInstruction(instruction);
+                    ++*issued;
+                }
+
+                if(!intFpCores[i].Timing().IsIssueBlocked() && !intFpCores[i].RegisterManager().IsReadStalled())
+                {
+                    intFpCores[i].InitiateInstruction(instruction);
+                    ++*issued;
+                }
+            }
+        }
+
+        for(u32 subClockIndex = 0; subClockIndex <= 5; ++subClockIndex)
+        {
+            for(u32 i = 0; i < 8; ++i)
+            {
+                fpCores[i].Clock(subClockIndex);
+                intFpCores[i].Clock(subClockIndex);
+            }
+
+            sm->TestClockRegisterFile();
+        }
+
+        sm->TestEndRegisterFileCycle();
+    }
+
+    const auto end = ::std::chrono::high_resolution_clock::now();
+
+    for(u32 i = 0; i < 8; ++i)
+    {
+        fpCores[i].~TFpCore();
+        intFpCores[i].~TIntFpCore();
+    }
+
+    ::operator delete(fpCores);
+    ::operator delete(intFpCores);
+
+    return static_cast<u64>(::std::chrono::duration_cast<::std::chrono::nanoseconds>(end - start).count());
+}
+
+// Times the Core<> template against the legacy classes on the same workload. The idle run never issues.
+static void BenchmarkCoreClock(const char* const name, const bool issue, const EFpuOp op, const EPrecision precision, const EBinOp binOp) noexcept
+{
+    static constexpr u32 CYCLE_COUNT = 1 << 20;
+
+    StreamingMultiprocessor* const sm = new(::std::nothrow) StreamingMultiprocessor(nullptr, 0);
+    sm->SetRegisterBankConflictModelling(false);
+
+    const FpuInstruction instruction = MakeBenchmarkInstruction(op, precision, binOp);
+
+    u64 legacyIssued;
+    u64 coreIssued;
+
+    const u64 legacyNanoseconds = TimeCoreClock<LegacyFpCore, LegacyIntFpCore>(sm, CYCLE_COUNT, issue, instruction, &legacyIssued);
+    const u64 coreNanoseconds = TimeCoreClock<FpCore, IntFpCore>(sm, CYCLE_COUNT, issue, instruction, &coreIssued);
+
+    ConPrinter::PrintLn("Core clock {}: {} cycles, {} instructions, legacy {} ps per cycle, template {} ps per cycle for 16 cores.", name, CYCLE_COUNT, coreIssued, legacyNanoseconds * 1000 / CYCLE_COUNT, coreNanoseconds * 1000 / CYCLE_COUNT);
+
+    if(legacyIssued != coreIssued)
+    {
+        ConPrinter::PrintLn("Core clock {}: the legacy cores issued {} instructions.", name, legacyIssued);
+    }
+
+    delete sm;
+}
@@ -0,0 +1,661 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#include <ConPrinter.hpp>
+
+#include <FPU.hpp>
+#include <Core.hpp>
+#include <StreamingMultiprocessor.hpp>
+
+#include <Common.hpp>
+
+#if HAS_X86_INTRINSICS
+#include <immintrin.h>
+#endif
+
+#include <bit>
+#include <cmath>
+#include <random>
+
+// A core that just captures the results the FPU writes back.
+class FpuTestCore final : public ICore
+{
+    DEFAULT_DESTRUCT(FpuTestCore);
+    DELETE_CM(FpuTestCore);
+public:
+    FpuTestCore() noexcept
+        : m_WriteCount(0)
+        , m_LastIs64Bit(false)
+        , m_LastStorageRegister(0)
+        , m_LastValue(0)
+    { }
+
+    void InvokeRegisterFileHigh(RegisterFile::CommandPacket) noexcept override { }
+    void InvokeRegisterFileLow(RegisterFile::CommandPacket) noexcept override { }
+    void ReleaseRegisterContestation(u32) noexcept override { }
+    void ReportRegisterValues(u64, u64, u64) noexcept override { }
+
+    void PrepareRegisterWrite(const bool is64Bit, const u32 storageRegister, const u64 value) noexcept override
+    {
+        ++m_WriteCount;
+        m_LastIs64Bit = is64Bit;
+        m_LastStorageRegister = storageRegister;
+        m_LastValue = value;
+    }
+
+    void ReportReady() const noexcept override { }
+
+    [[nodiscard]] u32 WriteCount() const noexcept { return m_WriteCount; }
+    [[nodiscard]] bool LastIs64Bit() const noexcept { return m_LastIs64Bit; }
+    [[nodiscard]] u32 LastStorageRegister() const noexcept { return m_LastStorageRegister; }
+    [[nodiscard]] u64 LastValue() const noexcept { return m_LastValue; }
+private:
+    u32 m_WriteCount;
+    bool m_LastIs64Bit;
+    u32 m_LastStorageRegister;
+    u64 m_LastValue;
+};
+
+static void TestBFloat16ConversionEdgeCases() noexcept;
+static void TestBFloat16ConversionReference() noexcept;
+static void TestBFloat16PackedBinOp() noexcept;
+static void TestBFloat16PackedFma() noexcept;
+static void TestBFloat16PackedNaN() noexcept;
+static void TestBFloat16PackedNegateAbs() noexcept;
+static void TestDenormalModes() noexcept;
+static void TestDenormalCompare() noexcept;
+static void TestDenormalHostModeRestored() noexcept;
+static void TestTimingConfiguration(const char* name, const FpuTimingTable& timingTable) noexcept;
+static void TestTimingWritebackConflict() noexcept;
+
+namespace tau::test::fpu {
+
+void RunTests() noexcept
+{
+    TestBFloat16ConversionEdgeCases();
+    TestBFloat16ConversionReference();
+    TestBFloat16PackedBinOp();
+    TestBFloat16PackedFma();
+    TestBFloat16PackedNaN();
+    TestBFloat16PackedNegateAbs();
+
+    TestDenormalModes();
+    TestDenormalCompare();
+    TestDenormalHostModeRestored();
+
+    TestTimingConfiguration("default", FpuTimingTable());
+    TestTimingConfiguration("single cycle", FpuTimingTable::SingleCycle());
+
+    {
+        // A design with a slow pipelined adder and a fast, but non-pipelined, double divider.
+        FpuTimingTable sweepTable;
+        sweepTable.Set(EFpuTimingClass::Add, EPrecision::Single, 7, 1);
+        sweepTable.Set(EFpuTimingClass::Divide, EPrecision::Double, 3, 3);
+        sweepTable.Set(EFpuTimingClass::Multiply, EPrecision::Half, 2, 2);
+        TestTimingConfiguration("sweep", sweepTable);
+    }
+
+    TestTimingWritebackConflict();
+}
+
+}
+
+static bool IsBFloat16NaN(const u16 value) noexcept
+{
+    return (value & 0x7F80) == 0x7F80 && (value & 0x007F) != 0;
+}
+
+// Picks the nearest bfloat16 by comparing distances in double precision, breaking ties toward the even encoding.
+static u16 ReferenceFloat32ToBFloat16(const u32 value) noexcept
+{
+    const u16 truncated = static_cast<u16>(value >> 16);
+
+    if((value & 0xFFFF) == 0)
+    {
+        return truncated;
+    }
+
+    const u16 roundedUp = static_cast<u16>(truncated + 1);
+
+    const f64 exact = ::std::fabs(static_cast<f64>(::std::bit_cast<f32>(value)));
+    const f64 lower = ::std::fabs(static_cast<f64>(::std::bit_cast<f32>(BFloat16ToFloat32(truncated))));
+    // The step above the largest finite value is the infinity encoding, its distance is measured to the next power of two.
+    const f64 upper = (roundedUp & 0x7FFF) == 0x7F80 ? ::std::ldexp(1.0, 128) : ::std::fabs(static_cast<f64>(::std::bit_cast<f32>(BFloat16ToFloat32(roundedUp))));
+
+    const f64 lowerDistance = exact - lower;
+    const f64 upperDistance = upper - exact;
+
+    if(lowerDistance < upperDistance)
+    {
+        return truncated;
+    }
+    else if(upperDistance < lowerDistance)
+    {
+        return roundedUp;
+    }
+
+    return (truncated & 0x1) == 0 ? truncated : roundedUp;
+}
+
+static void TestBFloat16ConversionEdgeCases() noexcept
+{
+    struct Case final
+    {
+        u32 Input;
+        u16 Expected;
+    };
+
+    static constexpr Case cases[] = {
+        { 0x3F800000, 0x3F80 }, // 1.0
+        { 0xBF800000, 0xBF80 }, // -1.0
+        { 0x00000000, 0x0000 }, // +0
+        { 0x80000000, 0x8000 }, // -0
+        { 0x3F808000, 0x3F80 }, // Tie, rounds down to even.
+        { 0x3F818000, 0x3F82 }, // Tie, rounds up to even.
+        { 0x3F808001, 0x3F81 }, // Just above the tie.
+        { 0x3F807FFF, 0x3F80 }, // Just below the tie.
+        { 0xBF818000, 0xBF82 }, // Negative tie.
+        { 0x00008000, 0x0000 }, // Denormal tie rounds to zero.
+        { 0x00018000, 0x0002 }, // Denormal tie rounds up to even.
+        { 0x007FFFFF, 0x0080 }, // Largest denormal rounds up to the smallest normal.
+        { 0x7F7FFFFF, 0x7F80 }, // Largest finite overflows to infinity.
+        { 0xFF7FFFFF, 0xFF80 }, // Largest negative finite overflows to negative infinity.
+        { 0x7F800000, 0x7F80 }, // +Inf
+        { 0xFF800000, 0xFF80 }, // -Inf
+        { 0x7FC00000, 0x7FC0 }, // Quiet NaN
+        { 0xFFC00000, 0xFFC0 }, // Negative quiet NaN
+        { 0x7F800001, 0x7FC0 }, // Signalling NaN with only low payload bits must not become infinity.
+        { 0x7F810000, 0x7FC1 }, // Signalling NaN keeps its upper payload.
+        { 0x7FFFFFFF, 0x7FFF }, // NaN with a full payload must not carry into the sign.
+    };
+
+    u32 failures = 0;
+
+    for(const Case& testCase : cases)
+    {
+        const u16 result = Float32ToBFloat16(testCase.Input);
+
+        if(result != testCase.Expected)
+        {
+            ConPrinter::PrintLn("bfloat16 conversion of 0x{XP0} produced 0x{XP0}, expected 0x{XP0}.", testCase.Input, result, testCase.Expected);
+            ++failures;
+        }
+
+        if(BFloat16ToFloat32(testCase.Expected) >> 16 != testCase.Expected)
+        {
+            ConPrinter::PrintLn("bfloat16 widening of 0x{XP0} was not exact.", testCase.Expected);
+            ++failures;
+        }
+    }
+
+    if(failures == 0)
+    {
+        ConPrinter::PrintLn("Successfully converted bfloat16 edge cases.");
+    }
+}
+
+static void TestBFloat16ConversionReference() noexcept
+{
+    ::std::mt19937 rng(0x5EED0026);
+    ::std::uniform_int_distribution<u32> distribution;
+
+    u32 failures = 0;
+
+    for(u32 i = 0; i < 1000000; ++i)
+    {
+        const u32 input = distribution(rng);
+        const u16 result = Float32ToBFloat16(input);
+
+        if((input & 0x7FFFFFFF) > 0x7F800000)
+        {
+            if(!IsBFloat16NaN(result) || (result & 0x8000) != ((input >> 16) & 0x8000))
+            {
+                ConPrinter::PrintLn("bfloat16 conversion of NaN 0x{XP0} produced non-NaN 0x{XP0}.", input, result);
+                ++failures;
+            }
+        }
+        else
+        {
+            const u16 expected = ReferenceFloat32ToBFloat16(input);
+
+            if(result != expected)
+            {
+                ConPrinter::PrintLn("bfloat16 conversion of 0x{XP0} produced 0x{XP0}, reference 0x{XP0}.", input, result, expected);
+                ++failures;
+            }
+        }
+
+        if(failures >= 16)
+        {
+            break;
+        }
+    }
+
+    if(failures == 0)
+    {
+        ConPrinter::PrintLn("Successfully matched bfloat16 conversion against the reference rounding.");
+    }
+}
+
+static u64 ExecuteBFloat16(FpuTestCore& core, const EFpuOp op, const u32 operandA, const u32 operandB, const u32 operandC) noexcept
+{
+    static constexpr FpuTimingTable timingTable;
+    Fpu fpu(&core, &timingTable);
+
+    LoadedFpuInstruction instruction { };
+    instruction.DispatchPort = 0;
+    instruction.Operation = op;
+    instruction.Precision = EPrecision::BFloat16;
+    instruction.StorageRegister = 17;
+    instruction.OperandA = operandA;
+    instruction.OperandB = operandB;
+    instruction.OperandC = operandC;
+
+    fpu.ExecuteInstruction(instruction);
+
+    return core.LastValue();
+}
+
+static void TestBFloat16PackedBinOp() noexcept
+{
+    FpuTestCore core;
+
+    // [1.0, 2.0] + [0.5, 3.0] = [1.5, 5.0]
+    const u64 sum = ExecuteBFloat16(core, EFpuOp::BasicBinOp, PackBFloat16x2(0x3F80, 0x4000), PackBFloat16x2(0x3F00, 0x4040), static_cast<u32>(EBinOp::Add));
+
+    if(sum != PackBFloat16x2(0x3FC0, 0x40A0))
+    {
+        ConPrinter::PrintLn("Packed bfloat16 add produced 0x{XP0}.", sum);
+    }
+    else if(core.WriteCount() != 1 || core.LastIs64Bit() || core.LastStorageRegister() != 17)
+    {
+        ConPrinter::PrintLn("Packed bfloat16 add did not write a single 32 bit register.");
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully added packed bfloat16.");
+    }
+
+    // 1.0078125 * 1.0078125 = 1.01568603515625 which rounds to 1.015625, lane 1 is -2.0 * 3.0.
+    const u64 product = ExecuteBFloat16(core, EFpuOp::BasicBinOp, PackBFloat16x2(0x3F81, 0xC000), PackBFloat16x2(0x3F81, 0x4040), static_cast<u32>(EBinOp::Multiply));
+
+    if(product != PackBFloat16x2(0x3F82, 0xC0C0))
+    {
+        ConPrinter::PrintLn("Packed bfloat16 multiply produced 0x{XP0}.", product);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully multiplied packed bfloat16 with rounding.");
+    }
+
+    // Compare flags land in each element's half of the register.
+    const u64 compare = ExecuteBFloat16(core, EFpuOp::Compare, PackBFloat16x2(0x4000, 0x3F80), PackBFloat16x2(0x3F80, 0x3F80), 0);
+
+    if(UnpackBFloat16(static_cast<u32>(compare), 0) != 0x2 || UnpackBFloat16(static_cast<u32>(compare), 1) != 0x1)
+    {
+        ConPrinter::PrintLn("Packed bfloat16 compare produced 0x{XP0}.", compare);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully compared packed bfloat16.");
+    }
+}
+
+static void TestBFloat16PackedFma() noexcept
+{
+    FpuTestCore core;
+
+    // 1.0625 * 1.0625 + 2^-30 is just past the tie between 1.125 and 1.1328125. Single precision can't hold the 2^-30,
+    // so rounding through it lands on the tie and then rounds to even, 1.125. A single rounding gives 1.1328125. Lane 1
+    // is the same negated.
+    const u64 result = ExecuteBFloat16(core, EFpuOp::Fma, PackBFloat16x2(0x3F88, 0xBF88), PackBFloat16x2(0x3F88, 0x3F88), PackBFloat16x2(0x3080, 0xB080));
+
+    // 1.0 * 1.5 + 0.25 is exact, lane 1 overflows to infinity.
+    const u64 exact = ExecuteBFloat16(core, EFpuOp::Fma, PackBFloat16x2(0x3F80, 0x7F7F), PackBFloat16x2(0x3FC0, 0x4000), PackBFloat16x2(0x3E80, 0x0000));
+
+    if(result != PackBFloat16x2(0x3F91, 0xBF91))
+    {
+        ConPrinter::PrintLn("Packed bfloat16 fma rounded twice, producing 0x{XP0}.", result);
+    }
+    else if(exact != PackBFloat16x2(0x3FE0, 0x7F80))
+    {
+        ConPrinter::PrintLn("Packed bfloat16 fma produced 0x{XP0}.", exact);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully fused packed bfloat16 with a single rounding.");
+    }
+}
+
+static void TestBFloat16PackedNaN() noexcept
+{
+    FpuTestCore core;
+
+    // NaN + 1.0 and Inf - Inf must both produce NaN.
+    const u64 result = ExecuteBFloat16(core, EFpuOp::BasicBinOp, PackBFloat16x2(0x7FC1, 0x7F80), PackBFloat16x2(0x3F80, 0xFF80), static_cast<u32>(EBinOp::Add));
+
+    if(!IsBFloat16NaN(UnpackBFloat16(static_cast<u32>(result), 0)) || !IsBFloat16NaN(UnpackBFloat16(static_cast<u32>(result), 1)))
+    {
+        ConPrinter::PrintLn("Packed bfloat16 NaN handling produced 0x{XP0}.", result);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully propagated packed bfloat16 NaNs.");
+    }
+}
+
+static void TestBFloat16PackedNegateAbs() noexcept
+{
+    FpuTestCore core;
+
+    const u64 negated = ExecuteBFloat16(core, EFpuOp::NegateAbs, PackBFloat16x2(0x3F80, 0xC000), 0, 0);
+    const u64 absolute = ExecuteBFloat16(core, EFpuOp::NegateAbs, PackBFloat16x2(0xBF80, 0xFFC0), 1, 0);
+
+    if(negated != PackBFloat16x2(0xBF80, 0x4000) || absolute != PackBFloat16x2(0x3F80, 0x7FC0))
+    {
+        ConPrinter::PrintLn("Packed bfloat16 negate/abs produced 0x{XP0} and 0x{XP0}.", negated, absolute);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully negated packed bfloat16.");
+    }
+}
+
+static u64 ExecuteWithFpMode(FpuTestCore& core, const EPrecision precision, const EFpuOp op, const u64 operandA, const u64 operandB, const u64 operandC, const bool flushToZero, const bool denormalsAreZero) noexcept
+{
+    static constexpr FpuTimingTable timingTable;
+    Fpu fpu(&core, &timingTable);
+
+    LoadedFpuInstruction instruction { };
+    instruction.DispatchPort = 0;
+    instruction.Operation = op;
+    instruction.Precision = precision;
+    instruction.StorageRegister = 3;
+    instruction.FlushToZero = flushToZero;
+    instruction.DenormalsAreZero = denormalsAreZero;
+    instruction.OperandA = operandA;
+    instruction.OperandB = operandB;
+    instruction.OperandC = operandC;
+
+    fpu.ExecuteInstruction(instruction);
+
+    return core.LastValue();
+}
+
+struct DenormalTestCase final
+{
+    const char* Name;
+    EPrecision Precision;
+    EBinOp BinOp;
+    u64 OperandA;
+    u64 OperandB;
+    bool FlushToZero;
+    bool DenormalsAreZero;
+    u64 Expected;
+};
+
+static void TestDenormalModes() noexcept
+{
+    static constexpr DenormalTestCase testCases[] = {
+        // Denormal operands, the smallest denormal plus zero.
+        { "single denormal input", EPrecision::Single, EBinOp::Add, 0x00000001, 0x00000000, false, false, 0x00000001 },
+        { "single DAZ input", EPrecision::Single, EBinOp::Add, 0x00000001, 0x00000000, false, true, 0x00000000 },
+        { "single DAZ negative input", EPrecision::Single, EBinOp::Add, 0x80000001, 0x80000000, false, true, 0x80000000 },
+        { "single FTZ keeps denormal input", EPrecision::Single, EBinOp::Multiply, 0x00400000, 0x40000000, true, false, 0x00800000 },
+        // Denormal results, the smallest normal times 0.5.
+        { "single denormal output", EPrecision::Single, EBinOp::Multiply, 0x00800000, 0x3F000000, false, false, 0x00400000 },
+        { "single DAZ keeps denormal output", EPrecision::Single, EBinOp::Multiply, 0x00800000, 0x3F000000, false, true, 0x00400000 },
+        { "single FTZ output", EPrecision::Single, EBinOp::Multiply, 0x00800000, 0x3F000000, true, false, 0x00000000 },
+        { "single FTZ negative output", EPrecision::Single, EBinOp::Multiply, 0x80800000, 0x3F000000, true, false, 0x80000000 },
+        { "half denormal input", EPrecision::Half, EBinOp::Add, 0x0001, 0x0000, false, false, 0x0001 },
+        { "half DAZ input", EPrecision::Half, EBinOp::Add, 0x0001, 0x0000, false, true, 0x0000 },
+        { "half DAZ negative input", EPrecision::Half, EBinOp::Add, 0x8001, 0x8000, false, true, 0x8000 },
+        { "half FTZ keeps denormal input", EPrecision::Half, EBinOp::Multiply, 0x0200, 0x4000, true, false, 0x0400 },
+        { "half denormal output", EPrecision::Half, EBinOp::Multiply, 0x0400, 0x3800, false, false, 0x0200 },
+        { "half FTZ output", EPrecision::Half, EBinOp::Multiply, 0x0400, 0x3800, true, false, 0x0000 },
+        { "half FTZ negative output", EPrecision::Half, EBinOp::Multiply, 0x8400, 0x3800, true, false, 0x8000 },
+        { "double denormal input", EPrecision::Double, EBinOp::Add, 0x0000000000000001, 0x0000000000000000, false, false, 0x0000000000000001 },
+        { "double DAZ input", EPrecision::Double, EBinOp::Add, 0x0000000000000001, 0x0000000000000000, false, true, 0x0000000000000000 },
+        { "double DAZ negative input", EPrecision::Double, EBinOp::Add, 0x8000000000000001, 0x8000000000000000, false, true, 0x8000000000000000 },
+        { "double FTZ keeps denormal input", EPrecision::Double, EBinOp::Multiply, 0x0008000000000000, 0x4000000000000000, true, false, 0x0010000000000000 },
+        { "double denormal output", EPrecision::Double, EBinOp::Multiply, 0x0010000000000000, 0x3FE0000000000000, false, false, 0x0008000000000000 },
+        { "double FTZ output", EPrecision::Double, EBinOp::Multiply, 0x0010000000000000, 0x3FE0000000000000, true, false, 0x0000000000000000 },
+        { "double FTZ negative output", EPrecision::Double, EBinOp::Multiply, 0x8010000000000000, 0x3FE0000000000000, true, false, 0x8000000000000000 },
+        // Each packed element is flushed on its own.
+        { "bfloat16 DAZ input", EPrecision::BFloat16, EBinOp::Add, PackBFloat16x2(0x0001, 0x3F80), 0x00000000, false, true, PackBFloat16x2(0x0000, 0x3F80) },
+        { "bfloat16 FTZ output", EPrecision::BFloat16, EBinOp::Multiply, PackBFloat16x2(0x0080, 0x8080), PackBFloat16x2(0x3F00, 0x3F80), true, false, PackBFloat16x2(0x0000, 0x8080) },
+    };
+
+    FpuTestCore core;
+    u32 failures = 0;
+
+    for(const DenormalTestCase& testCase : testCases)
+    {
+        const u64 result = ExecuteWithFpMode(core, testCase.Precision, EFpuOp::BasicBinOp, testCase.OperandA, testCase.OperandB, static_cast<u32>(testCase.BinOp), testCase.FlushToZero, testCase.DenormalsAreZero);
+
+        if(result != testCase.Expected)
+        {
+            ConPrinter::PrintLn("Denormal mode case \"{}\" produced 0x{XP0}, expected 0x{XP0}.", testCase.Name, result, testCase.Expected);
+            ++failures;
+        }
+    }
+
+    if(failures == 0)
+    {
+        ConPrinter::PrintLn("Successfully flushed denormals in half, single, double and bfloat16.");
+    }
+}
+
+static void TestDenormalCompare() noexcept
+{
+    FpuTestCore core;
+
+    CompareFlags preserved;
+    preserved.Value = static_cast<u32>(ExecuteWithFpMode(core, EPrecision::Single, EFpuOp::Compare, 0x00000001, 0x00000000, 0, false, false));
+
+    CompareFlags flushed;
+    flushed.Value = static_cast<u32>(ExecuteWithFpMode(core, EPrecision::Single, EFpuOp::Compare, 0x00000001, 0x00000000, 0, false, true));
+
+    if(preserved.Equal || !preserved.Greater || !flushed.Equal)
+    {
+        ConPrinter::PrintLn("Denormal compare produced 0x{XP0} without DAZ and 0x{XP0} with DAZ.", preserved.Value, flushed.Value);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully compared denormals with and without DAZ.");
+    }
+}
+
+static void TestDenormalHostModeRestored() noexcept
+{
+#if HAS_X86_INTRINSICS
+    FpuTestCore core;
+
+    const u32 csrBefore = _mm_getcsr();
+    (void) ExecuteWithFpMode(core, EPrecision::Single, EFpuOp::BasicBinOp, 0x00800000, 0x3F000000, static_cast<u32>(EBinOp::Multiply), true, true);
+    const u32 csrAfter = _mm_getcsr();
+
+    // The sticky exception flags may be raised by the operation itself.
+    if((csrBefore & ~0x3Fu) != (csrAfter & ~0x3Fu))
+    {
+        ConPrinter::PrintLn("FPU did not restore the host MXCSR, 0x{XP0} became 0x{XP0}.", csrBefore, csrAfter);
+        return;
+    }
+
+    // A plain float operation after the instruction must still produce a denormal.
+    volatile f32 minNormal = ::std::bit_cast<f32>(0x00800000u);
+    const f32 halved = minNormal * 0.5f;
+
+    if(::std::bit_cast<u32>(halved) != 0x00400000)
+    {
+        ConPrinter::PrintLn("Host FTZ leaked out of the FPU.");
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully restored the host denormal mode.");
+    }
+#endif
+}
+
+static FpuInstruction MakeTimingInstruction(const EFpuOp op, const EPrecision precision, const EBinOp binOp) noexcept
+{
+    FpuInstruction instruction;
+    instruction.DispatchPort = 0;
+    instruction.Operation = op;
+    instruction.Precision = precision;
+    instruction.FlushToZero = 0;
+    instruction.DenormalsAreZero = 0;
+    instruction.Reserved0 = 0;
+    instruction.OperandA = 0;
+    instruction.OperandB = 2;
+    instruction.OperandC = static_cast<u32>(binOp);
+    instruction.StorageRegister = 4;
+    instruction.Reserved1 = 0;
+    return instruction;
+}
+
+// Issues a single instruction to an idle core and checks the cycle it retires on, and how long it holds the unit.
+// Instructions spend 2 cycles reading operands before executing, so a latency of L retires on cycle 2 + L.
+static bool CheckTiming(StreamingMultiprocessor& sm, const u32 fpIndex, const FpuInstruction instruction, const FpuOpTiming expected) noexcept
+{
+    const CoreTiming& timing = sm.TestFpCoreTiming(fpIndex);
+    const u64 retiredBefore = timing.RetiredWritebacks();
+    const u64 stallsBefore = timing.StructuralStallCycles();
+    const u64 issuingStallsBefore = sm.TestDispatchUnit(0).StructuralStalls();
+    const u64 otherStallsBefore = sm.TestDispatchUnit(1).StructuralStalls();
+
+    sm.DispatchFpu(fpIndex, instruction);
+
+    u32 retireCycle = 0;
+    u32 readyCycle = 0;
+
+    for(u32 cycle = 1; cycle <= FpuTimingTable::MAX_LATENCY + 4; ++cycle)
+    {
+        sm.Clock();
+
+        if(retireCycle == 0 && timing.RetiredWritebacks() != retiredBefore)
+        {
+            retireCycle = cycle;
+        }
+
+        if(readyCycle == 0 && !timing.IsIssueBlocked())
+        {
+            readyCycle = cycle;
+        }
+    }
+
+    const u32 expectedRetireCycle = 2 + expected.Latency;
+    // The unit is blocked for the cycles between issues, and reports ready on the last of them.
+    const u32 expectedStalls = expected.InitiationInterval - 1u;
+    const u32 expectedReadyCycle = expected.InitiationInterval > 1 ? expected.InitiationInterval - 1u : 1u;
+
+    if(retireCycle != expectedRetireCycle || timing.StructuralStallCycles() - stallsBefore != expectedStalls || readyCycle != expectedReadyCycle)
+    {
+        ConPrinter::PrintLn("Op {} precision {} retired on cycle {} (expected {}), stalled {} cycles (expected {}).",
+            static_cast<u32>(instruction.Operation), static_cast<u32>(instruction.Precision),
+            retireCycle, expectedRetireCycle, timing.StructuralStallCycles() - stallsBefore, expectedStalls);
+        return false;
+    }
+
+    // Only the dispatch unit which issued the instruction counts the stall.
+    const u64 issuingStalls = sm.TestDispatchUnit(0).StructuralStalls() - issuingStallsBefore;
+    const u64 otherStalls = sm.TestDispatchUnit(1).StructuralStalls() - otherStallsBefore;
+
+    if(issuingStalls != expectedStalls || otherStalls != 0)
+    {
+        ConPrinter::PrintLn("Op {} precision {} counted {} stalls on the issuing dispatch unit (expected {}) and {} on the other (expected 0).",
+            static_cast<u32>(instruction.Operation), static_cast<u32>(instruction.Precision), issuingStalls, expectedStalls, otherStalls);
+        return false;
+    }
+
+    return true;
+}
+
+static void TestTimingConfiguration(const char* const name, const FpuTimingTable& timingTable) noexcept
+{
+    StreamingMultiprocessor* const sm = new(::std::nothrow) StreamingMultiprocessor(nullptr, 0);
+    sm->SetFpuTimingTable(timingTable);
+
+    static constexpr EPrecision precisions[] = { EPrecision::Single, EPrecision::Half, EPrecision::Double, EPrecision::BFloat16 };
+    static constexpr EBinOp binOps[] = { EBinOp::Add, EBinOp::Subtract, EBinOp::Multiply, EBinOp::Divide, EBinOp::Remainder };
+    static constexpr EFpuOp ops[] = { EFpuOp::Fma, EFpuOp::Round, EFpuOp::Compare, EFpuOp::NegateAbs };
+
+    u32 failures = 0;
+    u32 fpIndex = 0;
+
+    for(const EPrecision precision : precisions)
+    {
+        for(const EBinOp binOp : binOps)
+        {
+            const FpuInstruction instruction = MakeTimingInstruction(EFpuOp::BasicBinOp, precision, binOp);
+            const FpuOpTiming expected = timingTable.Get(GetFpuTimingClass(EFpuOp::BasicBinOp, binOp), precision);
+
+            // Rotate through both core types so each is covered.
+            failures += CheckTiming(*sm, fpIndex, instruction, expected) ? 0 : 1;
+            fpIndex = (fpIndex + 5) % 16;
+        }
+
+        for(const EFpuOp op : ops)
+        {
+            const FpuInstruction instruction = MakeTimingInstruction(op, precision, EBinOp::Add);
+            const FpuOpTiming expected = timingTable.Get(GetFpuTimingClass(op, EBinOp::Add), precision);
+
+            failures += CheckTiming(*sm, fpIndex, instruction, expected) ? 0 : 1;
+            fpIndex = (fpIndex + 5) % 16;
+        }
+    }
+
+    if(failures == 0)
+    {
+        ConPrinter::PrintLn("Successfully verified {} FPU timing configuration.", name);
+    }
+
+    delete sm;
+}
+
+static void TestTimingWritebackConflict() noexcept
+{
+    StreamingMultiprocessor* const sm = new(::std::nothrow) StreamingMultiprocessor(nullptr, 0);
+
+    const FpuTimingTable& timingTable = sm->GetFpuTimingTable();
+    const u32 fmaLatency = timingTable.Get(EFpuTimingClass::Fma, EPrecision::Single).Latency;
+    const u32 addLatency = timingTable.Get(EFpuTimingClass::Add, EPrecision::Single).Latency;
+
+    const CoreTiming& timing = sm->TestFpCoreTiming(0);
+
+    // Issue an add late enough that it would retire on the same cycle as the earlier fma.
+    sm->DispatchFpu(0, MakeTimingInstruction(EFpuOp::Fma, EPrecision::Single, EBinOp::Add));
+
+    u32 retireCycles[2] = { 0, 0 };
+    u32 retired = 0;
+
+    for(u32 cycle = 1; cycle <= FpuTimingTable::MAX_LATENCY + 4; ++cycle)
+    {
+        sm->Clock();
+
+        if(cycle == fmaLatency - addLatency)
+        {
+            sm->DispatchFpu(0, MakeTimingInstruction(EFpuOp::BasicBinOp, EPrecision::Single, EBinOp::Add));
+        }
+
+        if(timing.RetiredWritebacks() != retired && retired < 2)
+        {
+            retireCycles[retired] = cycle;
+            retired = static_cast<u32>(timing.RetiredWritebacks());
+        }
+    }
+
+    if(retireCycles[0] != 2 + fmaLatency || retireCycles[1] != 3 + fmaLatency || timing.WritebackConflicts() != 1)
+    {
+        ConPrinter::PrintLn("Writeback conflict retired on cycles {} and {}, expected {} and {}.", retireCycles[0], retireCycles[1], 2 + fmaLatency, 3 + fmaLatency);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully serialized conflicting FPU writebacks.");
+    }
+
+    delete sm;
+}
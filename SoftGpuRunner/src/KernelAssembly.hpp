@@ -0,0 +1,78 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#pragma once
+
+#include <NumTypes.hpp>
+#include <DispatchUnit.hpp>
+#include <Atomic.hpp>
+
+#include <cstring>
+
+// Helpers for the tests and benchmarks to assemble their kernels with. Each appends an instruction at offset and
+// returns the offset after it.
+
+// The SM addresses memory in words.
+[[nodiscard]] inline u64 WordAddress(const void* const pointer) noexcept
+{
+    return reinterpret_cast<u64>(pointer) >> 2;
+}
+
+// Points the register pair starting at registers at pointer.
+inline void WriteBasePointer(u32* const registers, const void* const pointer) noexcept
+{
+    const u64 address = WordAddress(pointer);
+    registers[0] = static_cast<u32>(address);
+    registers[1] = static_cast<u32>(address >> 32);
+}
+
+// Appends Ld/St of registerCount + 1 registers starting at target, from [baseRegister:baseRegister + 1 + addressOffset].
+[[nodiscard]] inline u32 WriteLoadStore(u8* const program, u32 offset, const bool store, const u8 registerCount, const u8 target, const i16 addressOffset, const u8 baseRegister = 0, const bool shared = false) noexcept
+{
+    program[offset++] = static_cast<u8>(EInstruction::LoadStore);
+    // Indexing is disabled with an exponent of 111.
+    program[offset++] = static_cast<u8>((shared ? 0x80 : 0x00) | (store ? 0x40 : 0x00) | 0x38 | registerCount);
+    program[offset++] = baseRegister;
+    program[offset++] = target;
+    program[offset++] = static_cast<u8>(static_cast<u16>(addressOffset));
+    program[offset++] = static_cast<u8>(static_cast<u16>(addressOffset) >> 8);
+    return offset;
+}
+
+[[nodiscard]] inline u32 WriteLoadImmediate(u8* const program, u32 offset, const u8 target, const u32 value) noexcept
+{
+    program[offset++] = static_cast<u8>(EInstruction::LoadImmediate);
+    program[offset++] = target;
+    (void) ::std::memcpy(&program[offset], &value, sizeof(value));
+    return offset + sizeof(value);
+}
+
+// Appends an atomic on [r0:r1 + addressOffset], without an index register.
+[[nodiscard]] inline u32 WriteAtomic(u8* const program, u32 offset, const EAtomicOperation operation, const bool wide, const bool signedCompare, const u8 target, const i16 addressOffset) noexcept
+{
+    program[offset++] = static_cast<u8>(EInstruction::Atomic);
+    program[offset++] = static_cast<u8>((signedCompare ? 0x80 : 0x00) | (wide ? 0x40 : 0x00) | 0x38 | static_cast<u8>(operation));
+    program[offset++] = 0;
+    program[offset++] = target;
+    program[offset++] = static_cast<u8>(static_cast<u16>(addressOffset));
+    program[offset++] = static_cast<u8>(static_cast<u16>(addressOffset) >> 8);
+    return offset;
+}
+
+// Appends a 32 bit FP operation, storage = a op b.
+[[nodiscard]] inline u32 WriteBinaryOp(u8* const program, u32 offset, const EInstruction instruction, const u8 a, const u8 b, const u8 storage) noexcept
+{
+    program[offset++] = static_cast<u8>(instruction);
+    program[offset++] = a;
+    program[offset++] = b;
+    program[offset++] = storage;
+    return offset;
+}
+
+[[nodiscard]] inline u32 WriteAddF(u8* const program, const u32 offset, const u8 a, const u8 b, const u8 storage) noexcept
+{
+    return WriteBinaryOp(program, offset, EInstruction::AddF, a, b, storage);
+}
@@ -0,0 +1,124 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#include <ConPrinter.hpp>
+
+#include <Processor.hpp>
+#include <StreamingMultiprocessor.hpp>
+#include <WarpScheduler.hpp>
+#include <LoadStore.hpp>
+
+#include "KernelAssembly.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <new>
+
+static void BenchmarkStreamingLoads(u32 outstandingLoadLimit, u32 warpCount) noexcept;
+
+namespace tau::benchmark::load_store {
+
+void RunBenchmarks() noexcept
+{
+    for(const u32 warpCount : { 1u, 4u, 8u })
+    {
+        for(u32 limit = 1; limit <= LoadStore::MISS_STATUS_ENTRY_COUNT; limit *= 2)
+        {
+            BenchmarkStreamingLoads(limit, warpCount);
+        }
+    }
+}
+
+}
+
+static constexpr u32 LOAD_COUNT = 64;
+// Loads rotate through this many target registers, so that many can be in flight per warp.
+static constexpr u32 TARGET_REGISTER_COUNT = 8;
+static constexpr u32 CLOCK_LIMIT = 1 << 22;
+
+struct KernelMemory final
+{
+    alignas(64) u8 Program[512];
+    alignas(64) u32 Data[WARP_COUNT][LOAD_COUNT * 8];
+    alignas(64) u32 Registers[WARP_COUNT][16];
+};
+
+// Every load touches a new cache line and nothing depends on it, so the only limit is how many the Ld/St units keep in flight.
+static void WriteKernel(KernelMemory& memory) noexcept
+{
+    u8* const program = memory.Program;
+    u32 offset = 0;
+
+    for(u32 i = 0; i < LOAD_COUNT; ++i)
+    {
+        offset = WriteLoadStore(program, offset, false, 0, static_cast<u8>(4 + i % TARGET_REGISTER_COUNT), static_cast<i16>(i * 8));
+    }
+
+    program[offset] = static_cast<u8>(EInstruction::Hlt);
+}
+
+static void BenchmarkStreamingLoads(const u32 outstandingLoadLimit, const u32 warpCount) noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    KernelMemory* const memory = new(::std::nothrow) KernelMemory;
+    (void) ::std::memset(memory, 0, sizeof(*memory));
+    WriteKernel(*memory);
+
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+    sm.SetLdStOutstandingLoadLimit(outstandingLoadLimit);
+
+    for(u32 i = 0; i < warpCount; ++i)
+    {
+        WriteBasePointer(memory->Registers[i], memory->Data[i]);
+
+        (void) processor->TestLaunchWarp(0, 0, reinterpret_cast<u64>(memory->Program), 0x1, 15, WordAddress(memory->Registers[i]), FpMode { });
+    }
+
+    const WarpScheduler& scheduler = sm.TestWarpScheduler(0);
+
+    const auto start = ::std::chrono::high_resolution_clock::now();
+
+    for(u32 clock = 0; clock < CLOCK_LIMIT && scheduler.ActiveWarps() != 0; ++clock)
+    {
+        processor->Clock();
+    }
+
+    const auto end = ::std::chrono::high_resolution_clock::now();
+    const u64 nanoseconds = static_cast<u64>(::std::chrono::duration_cast<::std::chrono::nanoseconds>(end - start).count());
+
+    if(scheduler.CompletedWarps() != warpCount)
+    {
+        ConPrinter::PrintLn("Ld/St ({} outstanding) completed {} of {} streaming warps.", outstandingLoadLimit, scheduler.CompletedWarps(), warpCount);
+    }
+
+    const u64 cycles = scheduler.ActiveCycles();
+    u64 outOfOrderReturns = 0;
+    u64 transactions = 0;
+    u64 instructions = 0;
+    u32 peakOutstanding = 0;
+
+    for(u32 i = 0; i < 4; ++i)
+    {
+        const LoadStore& ldSt = sm.TestLoadStore(i);
+        outOfOrderReturns += ldSt.OutOfOrderReturns();
+        transactions += ldSt.MemoryTransactions();
+        instructions += ldSt.Loads() + ldSt.Stores();
+        peakOutstanding = ldSt.PeakOutstandingLoads() > peakOutstanding ? ldSt.PeakOutstandingLoads() : peakOutstanding;
+    }
+
+    // Hundredths of a cycle per load across all warps.
+    const u64 cyclesPerLoad = cycles * 100 / (LOAD_COUNT * warpCount);
+
+    // Hundredths of a cache line transaction per load.
+    const u64 transactionsPerLoad = transactions * 100 / instructions;
+
+    ConPrinter::PrintLn("Ld/St {} outstanding ({} warps): {} cycles, {}.{} cycles per load, {}.{} transactions per load, {} peak outstanding, {} out of order returns, {} ns per cycle.", outstandingLoadLimit, warpCount, cycles, cyclesPerLoad / 100, cyclesPerLoad % 100, transactionsPerLoad / 100, transactionsPerLoad % 100, peakOutstanding, outOfOrderReturns, nanoseconds / cycles);
+
+    delete memory;
+    delete processor;
+}
@@ -0,0 +1,742 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#include <ConPrinter.hpp>
+
+#include <Processor.hpp>
+#include <StreamingMultiprocessor.hpp>
+#include <WarpScheduler.hpp>
+#include <LoadStore.hpp>
+#include <MMU.hpp>
+
+#include "KernelAssembly.hpp"
+
+#include <cstring>
+#include <new>
+
+static void TestIndexedLoad() noexcept;
+static void TestOutOfOrderReturn() noexcept;
+static void TestMergedMiss() noexcept;
+static void TestStoreOrdering() noexcept;
+static void TestPipelinedLoads() noexcept;
+static void TestCoalescedTransactions() noexcept;
+static void TestCoalescedLanes() noexcept;
+static void TestPageCrossingLoad() noexcept;
+static void TestTranslatedPageCrossing() noexcept;
+
+namespace tau::test::load_store {
+
+void RunTests() noexcept
+{
+    TestIndexedLoad();
+    TestOutOfOrderReturn();
+    TestMergedMiss();
+    TestStoreOrdering();
+    TestPipelinedLoads();
+    TestCoalescedTransactions();
+    TestCoalescedLanes();
+    TestPageCrossingLoad();
+    TestTranslatedPageCrossing();
+}
+
+}
+
+static constexpr u32 CLOCK_LIMIT = 1 << 20;
+static constexpr u32 LINE_WORDS = 8;
+static constexpr u32 PIPELINED_LOAD_COUNT = 16;
+static constexpr u32 LANE_COUNT = 4;
+static constexpr u32 LANE_REGISTER_COUNT = 32;
+
+struct LoadStoreTestMemory final
+{
+    alignas(64) u8 Program[256];
+    alignas(64) u32 Data[16 * LINE_WORDS];
+    // Each lane has its own 32 registers.
+    alignas(64) u32 Registers[LANE_COUNT * LANE_REGISTER_COUNT];
+};
+
+[[nodiscard]] static LoadStoreTestMemory* CreateMemory() noexcept
+{
+    LoadStoreTestMemory* const memory = new(::std::nothrow) LoadStoreTestMemory;
+    (void) ::std::memset(memory, 0, sizeof(*memory));
+
+    for(u32 i = 0; i < ::std::size(memory->Data); ++i)
+    {
+        memory->Data[i] = 0xDA7A0000u | i;
+    }
+
+    WriteBasePointer(memory->Registers, memory->Data);
+
+    return memory;
+}
+
+static void LaunchWarp(Processor& processor, LoadStoreTestMemory& memory) noexcept
+{
+    (void) processor.TestLaunchWarp(0, 0, reinterpret_cast<u64>(memory.Program), 0x1, 31, WordAddress(memory.Registers), FpMode { });
+}
+
+// The register of warp 0's only thread. The only warp stays where it was loaded, even after it retires.
+[[nodiscard]] static u32 WarpRegister(StreamingMultiprocessor& sm, const u32 registerIndex) noexcept
+{
+    return sm.GetRegister(static_cast<u32>(sm.TestWarpScheduler(0).Warp(0).RegisterFileBase) + registerIndex);
+}
+
+[[nodiscard]] static u64 TotalMergedLoads(StreamingMultiprocessor& sm) noexcept
+{
+    return sm.TestLoadStore(0).MergedLoads() + sm.TestLoadStore(1).MergedLoads() + sm.TestLoadStore(2).MergedLoads() + sm.TestLoadStore(3).MergedLoads();
+}
+
+[[nodiscard]] static u64 TotalOutOfOrderReturns(StreamingMultiprocessor& sm) noexcept
+{
+    return sm.TestLoadStore(0).OutOfOrderReturns() + sm.TestLoadStore(1).OutOfOrderReturns() + sm.TestLoadStore(2).OutOfOrderReturns() + sm.TestLoadStore(3).OutOfOrderReturns();
+}
+
+[[nodiscard]] static u64 TotalMemoryTransactions(StreamingMultiprocessor& sm) noexcept
+{
+    return sm.TestLoadStore(0).MemoryTransactions() + sm.TestLoadStore(1).MemoryTransactions() + sm.TestLoadStore(2).MemoryTransactions() + sm.TestLoadStore(3).MemoryTransactions();
+}
+
+[[nodiscard]] static u64 TotalLoadMisses(StreamingMultiprocessor& sm) noexcept
+{
+    return sm.TestLoadStore(0).LoadMisses() + sm.TestLoadStore(1).LoadMisses() + sm.TestLoadStore(2).LoadMisses() + sm.TestLoadStore(3).LoadMisses();
+}
+
+// A load from [r0:r1 + r2 * 2 + 1] into r4 and r5. Every register the front end read is unlocked once it completes.
+static void TestIndexedLoad() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    LoadStoreTestMemory* const memory = CreateMemory();
+    memory->Registers[2] = 3;
+
+    u32 offset = 0;
+    memory->Program[offset++] = static_cast<u8>(EInstruction::LoadStore);
+    // An index exponent of 1 and 2 registers.
+    memory->Program[offset++] = 0x08 | 0x01;
+    memory->Program[offset++] = 0;
+    memory->Program[offset++] = 2;
+    memory->Program[offset++] = 4;
+    memory->Program[offset++] = 1;
+    memory->Program[offset++] = 0;
+    memory->Program[offset] = static_cast<u8>(EInstruction::Hlt);
+
+    LaunchWarp(*processor, *memory);
+
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+    const WarpScheduler& scheduler = sm.TestWarpScheduler(0);
+
+    u32 clock = 0;
+
+    for(; clock < CLOCK_LIMIT && scheduler.ActiveWarps() != 0; ++clock)
+    {
+        processor->Clock();
+    }
+
+    const u32 base = static_cast<u32>(scheduler.Warp(0).RegisterFileBase);
+    const bool unlocked = sm.CanWriteRegister(base) && sm.CanWriteRegister(base + 1) && sm.CanWriteRegister(base + 2) && sm.CanWriteRegister(base + 4) && sm.CanWriteRegister(base + 5);
+
+    if(clock >= CLOCK_LIMIT)
+    {
+        ConPrinter::PrintLn("The indexed load didn't complete in {} clocks.", clock);
+    }
+    else if(WarpRegister(sm, 4) != memory->Data[7] || WarpRegister(sm, 5) != memory->Data[8])
+    {
+        ConPrinter::PrintLn("The indexed load returned 0x{XP0} and 0x{XP0}, expected 0x{XP0} and 0x{XP0}.", WarpRegister(sm, 4), WarpRegister(sm, 5), memory->Data[7], memory->Data[8]);
+    }
+    else if(!unlocked)
+    {
+        ConPrinter::PrintLn("The indexed load left its registers locked.");
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully loaded from an indexed address.");
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// A run of misses spread over the units, then a hit which lands behind one of them. The hit is written back first.
+static void TestOutOfOrderReturn() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    LoadStoreTestMemory* const memory = CreateMemory();
+
+    u32 offset = 0;
+
+    for(u32 i = 0; i < 4; ++i)
+    {
+        offset = WriteLoadStore(memory->Program, offset, false, 0, static_cast<u8>(4 + i), static_cast<i16>(i * LINE_WORDS));
+    }
+
+    offset = WriteLoadStore(memory->Program, offset, false, 0, 8, LINE_WORDS * 8);
+    memory->Program[offset] = static_cast<u8>(EInstruction::Hlt);
+
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+
+    // Every load reads the same base registers, bank conflicts on them would change which unit each load lands on.
+    sm.SetRegisterBankConflictModelling(false);
+
+    // Only the last load's line is in the L0.
+    (void) sm.Read(WordAddress(&memory->Data[LINE_WORDS * 8]));
+
+    LaunchWarp(*processor, *memory);
+
+    const WarpScheduler& scheduler = sm.TestWarpScheduler(0);
+
+    u32 clock = 0;
+    u32 firstClock = 0;
+    u32 secondClock = 0;
+
+    for(; clock < CLOCK_LIMIT && scheduler.ActiveWarps() != 0; ++clock)
+    {
+        processor->Clock();
+
+        if(!firstClock && WarpRegister(sm, 4) == memory->Data[0])
+        {
+            firstClock = clock;
+        }
+
+        if(!secondClock && WarpRegister(sm, 8) == memory->Data[LINE_WORDS * 8])
+        {
+            secondClock = clock;
+        }
+    }
+
+    if(clock >= CLOCK_LIMIT || !firstClock || !secondClock)
+    {
+        ConPrinter::PrintLn("Out of order loads wrote their registers on clocks {} and {} of {}.", firstClock, secondClock, clock);
+    }
+    else if(secondClock >= firstClock || firstClock < LoadStore::MISS_LATENCY_CYCLES)
+    {
+        ConPrinter::PrintLn("The hit returned on clock {} and the miss on clock {}, expected the hit first.", secondClock, firstClock);
+    }
+    else if(TotalLoadMisses(sm) != 4 || TotalOutOfOrderReturns(sm) != 1)
+    {
+        ConPrinter::PrintLn("The Ld/St units counted {} misses and {} out of order returns, expected 4 and 1.", TotalLoadMisses(sm), TotalOutOfOrderReturns(sm));
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully returned a hit on clock {} ahead of a miss on clock {}.", secondClock, firstClock);
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// A second load from a line which is still on its way, even on another unit, waits for it instead of hitting early or missing again.
+static void TestMergedMiss() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    LoadStoreTestMemory* const memory = CreateMemory();
+
+    u32 offset = 0;
+    offset = WriteLoadStore(memory->Program, offset, false, 0, 4, 0);
+    offset = WriteLoadStore(memory->Program, offset, false, 0, 5, 3);
+    memory->Program[offset] = static_cast<u8>(EInstruction::Hlt);
+
+    LaunchWarp(*processor, *memory);
+
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+    const WarpScheduler& scheduler = sm.TestWarpScheduler(0);
+
+    u32 clock = 0;
+    u32 secondClock = 0;
+
+    for(; clock < CLOCK_LIMIT && scheduler.ActiveWarps() != 0; ++clock)
+    {
+        processor->Clock();
+
+        if(!secondClock && WarpRegister(sm, 5) == memory->Data[3])
+        {
+            secondClock = clock;
+        }
+    }
+
+    if(clock >= CLOCK_LIMIT || !secondClock)
+    {
+        ConPrinter::PrintLn("Merged loads didn't complete in {} clocks.", clock);
+    }
+    else if(TotalLoadMisses(sm) != 1 || TotalMergedLoads(sm) != 1)
+    {
+        ConPrinter::PrintLn("The Ld/St units counted {} misses and {} merged loads, expected 1 and 1.", TotalLoadMisses(sm), TotalMergedLoads(sm));
+    }
+    else if(secondClock < LoadStore::MISS_LATENCY_CYCLES || secondClock > LoadStore::MISS_LATENCY_CYCLES + 8)
+    {
+        ConPrinter::PrintLn("The merged load returned on clock {}, expected just after the {} cycle miss.", secondClock, LoadStore::MISS_LATENCY_CYCLES);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully merged a load into an outstanding miss, returned on clock {}.", secondClock);
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// A store behind a missed load to the same address must not change what the load returns, and a load behind a store sees it.
+static void TestStoreOrdering() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    LoadStoreTestMemory* const memory = CreateMemory();
+
+    memory->Registers[8] = 0x11111111;
+    memory->Registers[9] = 0x22222222;
+    memory->Registers[10] = 0x33333333;
+    memory->Registers[11] = 0x44444444;
+
+    const u32 oldValue = memory->Data[LINE_WORDS];
+
+    u32 offset = 0;
+    // Load then store to the same word.
+    offset = WriteLoadStore(memory->Program, offset, false, 0, 4, LINE_WORDS);
+    offset = WriteLoadStore(memory->Program, offset, true, 0, 8, LINE_WORDS);
+    // Store 4 registers across a line boundary, then load them back.
+    offset = WriteLoadStore(memory->Program, offset, true, 3, 8, LINE_WORDS * 3 - 2);
+    offset = WriteLoadStore(memory->Program, offset, false, 3, 12, LINE_WORDS * 3 - 2);
+    memory->Program[offset] = static_cast<u8>(EInstruction::Hlt);
+
+    LaunchWarp(*processor, *memory);
+
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+    const WarpScheduler& scheduler = sm.TestWarpScheduler(0);
+
+    u32 clock = 0;
+
+    for(; clock < CLOCK_LIMIT && scheduler.ActiveWarps() != 0; ++clock)
+    {
+        processor->Clock();
+    }
+
+    u32 loaded[5];
+    loaded[0] = WarpRegister(sm, 4);
+
+    for(u32 i = 0; i < 4; ++i)
+    {
+        loaded[i + 1] = WarpRegister(sm, 12 + i);
+    }
+
+    processor->FlushCache(0);
+
+    const bool roundTrip = loaded[1] == 0x11111111 && loaded[2] == 0x22222222 && loaded[3] == 0x33333333 && loaded[4] == 0x44444444;
+
+    if(clock >= CLOCK_LIMIT)
+    {
+        ConPrinter::PrintLn("Store ordering kernel didn't complete in {} clocks.", clock);
+    }
+    else if(loaded[0] != oldValue || memory->Data[LINE_WORDS] != 0x11111111)
+    {
+        ConPrinter::PrintLn("Load before a store returned 0x{XP0}, expected 0x{XP0}, memory holds 0x{XP0}.", loaded[0], oldValue, memory->Data[LINE_WORDS]);
+    }
+    else if(!roundTrip)
+    {
+        ConPrinter::PrintLn("Load after a store returned 0x{XP0} 0x{XP0} 0x{XP0} 0x{XP0}.", loaded[1], loaded[2], loaded[3], loaded[4]);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully kept loads and stores to the same address in order.");
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// Independent loads to separate lines, with a single outstanding load per unit and with the full table.
+[[nodiscard]] static u32 RunIndependentLoads(const u32 outstandingLoadLimit, u32* const peakOutstanding, bool* const correct) noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    LoadStoreTestMemory* const memory = CreateMemory();
+
+    u32 offset = 0;
+
+    for(u32 i = 0; i < PIPELINED_LOAD_COUNT; ++i)
+    {
+        offset = WriteLoadStore(memory->Program, offset, false, 0, static_cast<u8>(4 + i), static_cast<i16>(i * LINE_WORDS));
+    }
+
+    memory->Program[offset] = static_cast<u8>(EInstruction::Hlt);
+
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+    sm.SetLdStOutstandingLoadLimit(outstandingLoadLimit);
+
+    LaunchWarp(*processor, *memory);
+
+    const WarpScheduler& scheduler = sm.TestWarpScheduler(0);
+
+    u32 clock = 0;
+
+    for(; clock < CLOCK_LIMIT && scheduler.ActiveWarps() != 0; ++clock)
+    {
+        processor->Clock();
+    }
+
+    *correct = clock < CLOCK_LIMIT;
+
+    for(u32 i = 0; i < PIPELINED_LOAD_COUNT; ++i)
+    {
+        *correct = *correct && WarpRegister(sm, 4 + i) == memory->Data[i * LINE_WORDS];
+    }
+
+    *peakOutstanding = 0;
+
+    for(u32 i = 0; i < 4; ++i)
+    {
+        const u32 peak = sm.TestLoadStore(i).PeakOutstandingLoads();
+        *peakOutstanding = peak > *peakOutstanding ? peak : *peakOutstanding;
+    }
+
+    delete memory;
+    delete processor;
+
+    return clock;
+}
+
+static void TestPipelinedLoads() noexcept
+{
+    u32 serialPeak;
+    bool serialCorrect;
+    const u32 serialClocks = RunIndependentLoads(1, &serialPeak, &serialCorrect);
+
+    u32 pipelinedPeak;
+    bool pipelinedCorrect;
+    const u32 pipelinedClocks = RunIndependentLoads(LoadStore::MISS_STATUS_ENTRY_COUNT, &pipelinedPeak, &pipelinedCorrect);
+
+    if(!serialCorrect || !pipelinedCorrect)
+    {
+        ConPrinter::PrintLn("Independent loads returned the wrong values, serial: {}, pipelined: {}.", serialCorrect, pipelinedCorrect);
+    }
+    else if(serialPeak != 1 || pipelinedPeak < 2)
+    {
+        ConPrinter::PrintLn("At most {} and {} loads were outstanding on a unit, expected 1 and more than 1.", serialPeak, pipelinedPeak);
+    }
+    else if(pipelinedClocks * 2 > serialClocks || pipelinedClocks > LoadStore::MISS_LATENCY_CYCLES * 2)
+    {
+        ConPrinter::PrintLn("{} independent loads took {} clocks pipelined and {} with one outstanding load per unit.", PIPELINED_LOAD_COUNT, pipelinedClocks, serialClocks);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully pipelined {} independent loads in {} clocks, {} with one outstanding load per unit.", PIPELINED_LOAD_COUNT, pipelinedClocks, serialClocks);
+    }
+}
+
+// Each instruction should cost one transaction per cache line it touches, however many registers it moves.
+static void TestCoalescedTransactions() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    LoadStoreTestMemory* const memory = CreateMemory();
+
+    u32 offset = 0;
+    // Aligned, 1 line.
+    offset = WriteLoadStore(memory->Program, offset, false, 7, 4, 0);
+    // Unaligned, 2 lines.
+    offset = WriteLoadStore(memory->Program, offset, false, 7, 12, LINE_WORDS + 5);
+    // Unaligned within a line, 1 line.
+    offset = WriteLoadStore(memory->Program, offset, false, 2, 20, LINE_WORDS * 3 + 2);
+    // Unaligned, 2 lines.
+    offset = WriteLoadStore(memory->Program, offset, true, 7, 12, LINE_WORDS * 5 + 3);
+    memory->Program[offset] = static_cast<u8>(EInstruction::Hlt);
+
+    u32 expected[20];
+
+    for(u32 i = 0; i < 8; ++i)
+    {
+        expected[i] = memory->Data[i];
+        expected[i + 8] = memory->Data[LINE_WORDS + 5 + i];
+    }
+
+    for(u32 i = 0; i < 3; ++i)
+    {
+        expected[i + 16] = memory->Data[LINE_WORDS * 3 + 2 + i];
+    }
+
+    LaunchWarp(*processor, *memory);
+
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+    const WarpScheduler& scheduler = sm.TestWarpScheduler(0);
+
+    u32 clock = 0;
+
+    for(; clock < CLOCK_LIMIT && scheduler.ActiveWarps() != 0; ++clock)
+    {
+        processor->Clock();
+    }
+
+    processor->FlushCache(0);
+
+    u32 wrongRegisters = 0;
+    u32 wrongWords = 0;
+
+    for(u32 i = 0; i < 19; ++i)
+    {
+        wrongRegisters += WarpRegister(sm, 4 + i) != expected[i] ? 1 : 0;
+    }
+
+    for(u32 i = 0; i < 8; ++i)
+    {
+        wrongWords += memory->Data[LINE_WORDS * 5 + 3 + i] != expected[i + 8] ? 1 : 0;
+    }
+
+    if(clock >= CLOCK_LIMIT)
+    {
+        ConPrinter::PrintLn("Coalescing kernel didn't complete in {} clocks.", clock);
+    }
+    else if(wrongRegisters != 0 || wrongWords != 0)
+    {
+        ConPrinter::PrintLn("Coalesced accesses loaded {} registers and stored {} words incorrectly.", wrongRegisters, wrongWords);
+    }
+    else if(TotalMemoryTransactions(sm) != 6)
+    {
+        ConPrinter::PrintLn("4 instructions moving 27 registers took {} transactions, expected 6.", TotalMemoryTransactions(sm));
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully coalesced 4 instructions moving 27 registers into 6 transactions.");
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// 4 lanes each loading and storing a pair of words next to the previous lane's, the lanes share one transaction per line.
+static void TestCoalescedLanes() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    LoadStoreTestMemory* const memory = CreateMemory();
+
+    for(u32 lane = 0; lane < LANE_COUNT; ++lane)
+    {
+        WriteBasePointer(&memory->Registers[lane * LANE_REGISTER_COUNT], &memory->Data[lane * 2]);
+    }
+
+    u32 offset = 0;
+    // Words 0 - 7, 1 line.
+    offset = WriteLoadStore(memory->Program, offset, false, 1, 4, 0);
+    // Words 21 - 28, 2 lines.
+    offset = WriteLoadStore(memory->Program, offset, true, 1, 4, LINE_WORDS * 2 + 5);
+    memory->Program[offset] = static_cast<u8>(EInstruction::Hlt);
+
+    (void) processor->TestLaunchWarp(0, 0, reinterpret_cast<u64>(memory->Program), 0xF, LANE_REGISTER_COUNT - 1, WordAddress(memory->Registers), FpMode { });
+
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+    const WarpScheduler& scheduler = sm.TestWarpScheduler(0);
+
+    u32 clock = 0;
+
+    for(; clock < CLOCK_LIMIT && scheduler.ActiveWarps() != 0; ++clock)
+    {
+        processor->Clock();
+    }
+
+    processor->FlushCache(0);
+
+    u32 wrongRegisters = 0;
+    u32 wrongWords = 0;
+
+    for(u32 lane = 0; lane < LANE_COUNT; ++lane)
+    {
+        for(u32 i = 0; i < 2; ++i)
+        {
+            const u32 expected = 0xDA7A0000u | (lane * 2 + i);
+            wrongRegisters += WarpRegister(sm, lane * LANE_REGISTER_COUNT + 4 + i) != expected ? 1 : 0;
+            wrongWords += memory->Data[LINE_WORDS * 2 + 5 + lane * 2 + i] != expected ? 1 : 0;
+        }
+    }
+
+    if(clock >= CLOCK_LIMIT)
+    {
+        ConPrinter::PrintLn("Lane coalescing kernel didn't complete in {} clocks.", clock);
+    }
+    else if(wrongRegisters != 0 || wrongWords != 0)
+    {
+        ConPrinter::PrintLn("Coalesced lanes loaded {} registers and stored {} words incorrectly.", wrongRegisters, wrongWords);
+    }
+    else if(TotalMemoryTransactions(sm) != 3 || sm.TestLaneCoalescer().MergedLines() != 6)
+    {
+        ConPrinter::PrintLn("8 lane accesses took {} transactions and merged {} lines, expected 3 and 6.", TotalMemoryTransactions(sm), sm.TestLaneCoalescer().MergedLines());
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully coalesced the accesses of 4 lanes into 3 transactions.");
+    }
+
+    delete memory;
+    delete processor;
+}
+
+struct PageTestMemory final
+{
+    alignas(GpuPageSize) PageEntry Directory[GpuPageSize / sizeof(PageEntry)];
+    alignas(GpuPageSize) PageEntry Table[GpuPageSize / sizeof(PageEntry)];
+    alignas(GpuPageSize) u32 Pages[2][GpuPageWordCount];
+};
+
+[[nodiscard]] static PageTestMemory* CreatePageMemory() noexcept
+{
+    PageTestMemory* const memory = new(::std::nothrow) PageTestMemory;
+    (void) ::std::memset(memory, 0, sizeof(*memory));
+
+    for(u32 i = 0; i < 2; ++i)
+    {
+        for(u32 j = 0; j < GpuPageWordCount; ++j)
+        {
+            memory->Pages[i][j] = (i << 16) | j;
+        }
+    }
+
+    return memory;
+}
+
+// A load and a store straddling the boundary between two pages, with the pages untranslated.
+static void TestPageCrossingLoad() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    LoadStoreTestMemory* const memory = CreateMemory();
+    PageTestMemory* const pages = CreatePageMemory();
+
+    WriteBasePointer(memory->Registers, &pages->Pages[0][GpuPageWordCount - 3]);
+
+    u32 offset = 0;
+    offset = WriteLoadStore(memory->Program, offset, false, 7, 4, 0);
+    // Write them back 2 words further on, still across the boundary.
+    offset = WriteLoadStore(memory->Program, offset, true, 7, 4, 2);
+    memory->Program[offset] = static_cast<u8>(EInstruction::Hlt);
+
+    LaunchWarp(*processor, *memory);
+
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+    const WarpScheduler& scheduler = sm.TestWarpScheduler(0);
+
+    u32 clock = 0;
+
+    for(; clock < CLOCK_LIMIT && scheduler.ActiveWarps() != 0; ++clock)
+    {
+        processor->Clock();
+    }
+
+    processor->FlushCache(0);
+
+    u32 wrongRegisters = 0;
+    u32 wrongWords = 0;
+
+    for(u32 i = 0; i < 8; ++i)
+    {
+        const u32 expected = i < 3 ? static_cast<u32>(GpuPageWordCount - 3 + i) : (1u << 16) | (i - 3);
+        wrongRegisters += WarpRegister(sm, 4 + i) != expected ? 1 : 0;
+
+        const u32* const stored = i < 1 ? &pages->Pages[0][GpuPageWordCount - 1] : &pages->Pages[1][i - 1];
+        wrongWords += *stored != expected ? 1 : 0;
+    }
+
+    u64 pageCrossings = 0;
+
+    for(u32 i = 0; i < 4; ++i)
+    {
+        pageCrossings += sm.TestLoadStore(i).PageCrossings();
+    }
+
+    if(clock >= CLOCK_LIMIT)
+    {
+        ConPrinter::PrintLn("Page crossing kernel didn't complete in {} clocks.", clock);
+    }
+    else if(wrongRegisters != 0 || wrongWords != 0)
+    {
+        ConPrinter::PrintLn("Page crossing accesses loaded {} registers and stored {} words incorrectly.", wrongRegisters, wrongWords);
+    }
+    else if(pageCrossings != 2 || TotalMemoryTransactions(sm) != 4)
+    {
+        ConPrinter::PrintLn("Page crossing accesses counted {} crossings and {} transactions, expected 2 and 4.", pageCrossings, TotalMemoryTransactions(sm));
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully loaded and stored across a page boundary.");
+    }
+
+    delete pages;
+    delete memory;
+    delete processor;
+}
+
+// Consecutive virtual pages mapped to physical pages in the opposite order, each half of the access has to be translated separately.
+static void TestTranslatedPageCrossing() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    PageTestMemory* const pages = CreatePageMemory();
+
+    pages->Directory[0].Present = true;
+    pages->Directory[0].PhysicalAddress = reinterpret_cast<u64>(pages->Table) >> 16;
+
+    for(u32 i = 0; i < 2; ++i)
+    {
+        PageEntry& entry = pages->Table[1 + i];
+        entry.Present = true;
+        entry.ReadWrite = true;
+        entry.PhysicalAddress = reinterpret_cast<u64>(pages->Pages[1 - i]) >> 16;
+    }
+
+    processor->LoadPageDirectoryPointer(0, pages->Directory);
+
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+
+    // The last 3 words of virtual page 1, then the first 5 of virtual page 2.
+    const u64 address = GpuPageWordCount * 2 - 3;
+
+    u32 values[8];
+    const u32 readTransactions = sm.ReadCoalesced(address, 8, values);
+
+    const u32 stored[8] = { 10, 11, 12, 13, 14, 15, 16, 17 };
+    const u32 writeTransactions = sm.WriteCoalesced(address, 8, stored);
+
+    processor->FlushCache(0);
+
+    u32 wrongValues = 0;
+    u32 wrongWords = 0;
+
+    for(u32 i = 0; i < 8; ++i)
+    {
+        const u32* const physical = i < 3 ? &pages->Pages[1][GpuPageWordCount - 3 + i] : &pages->Pages[0][i - 3];
+        const u32 expected = i < 3 ? (1u << 16) | static_cast<u32>(GpuPageWordCount - 3 + i) : i - 3;
+
+        wrongValues += values[i] != expected ? 1 : 0;
+        wrongWords += *physical != stored[i] ? 1 : 0;
+    }
+
+    if(wrongValues != 0 || wrongWords != 0)
+    {
+        ConPrinter::PrintLn("Translated page crossing read {} words and wrote {} words incorrectly.", wrongValues, wrongWords);
+    }
+    else if(readTransactions != 2 || writeTransactions != 2)
+    {
+        ConPrinter::PrintLn("Translated page crossing took {} read and {} write transactions, expected 2 and 2.", readTransactions, writeTransactions);
+    }
+    else if(!pages->Table[1].Accessed || !pages->Table[2].Accessed || !pages->Table[1].Dirty || !pages->Table[2].Dirty)
+    {
+        ConPrinter::PrintLn("Translated page crossing didn't mark both pages accessed and dirty.");
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully translated each page of an access crossing a page boundary.");
+    }
+
+    delete pages;
+    delete processor;
+}
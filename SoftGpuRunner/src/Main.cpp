@@ -53,6 +53,82 @@ namespace tau::test::register_allocator {
 extern void RunTests() noexcept;
 }
 
+namespace tau::test::fpu {
+extern void RunTests() noexcept;
+}
+
+namespace tau::test::register_file {
+extern void RunTests() noexcept;
+}
+
+namespace tau::test::operand_collector {
+extern void RunTests() noexcept;
+}
+
+namespace tau::test::warp_scheduler {
+extern void RunTests() noexcept;
+}
+
+namespace tau::test::occupancy {
+extern void RunTests() noexcept;
+}
+
+namespace tau::test::load_store {
+extern void RunTests() noexcept;
+}
+
+namespace tau::test::store_buffer {
+extern void RunTests() noexcept;
+}
+
+namespace tau::test::atomic {
+extern void RunTests() noexcept;
+}
+
+namespace tau::test::shared_memory {
+extern void RunTests() noexcept;
+}
+
+namespace tau::test::cache {
+extern void RunTests() noexcept;
+}
+
+namespace tau::test::prefetch {
+extern void RunTests() noexcept;
+}
+
+namespace tau::test::cache_statistics {
+extern void RunTests() noexcept;
+}
+
+namespace tau::benchmark::core {
+extern void RunBenchmarks() noexcept;
+}
+
+namespace tau::benchmark::register_allocator {
+extern void RunBenchmarks() noexcept;
+}
+
+namespace tau::benchmark::warp_scheduler {
+extern void RunBenchmarks() noexcept;
+}
+
+namespace tau::benchmark::load_store {
+extern void RunBenchmarks() noexcept;
+}
+
+namespace tau::benchmark::atomic {
+extern void RunBenchmarks() noexcept;
+}
+
+namespace tau::benchmark::shared_memory {
+extern void RunBenchmarks() noexcept;
+}
+
+namespace tau::benchmark::cache {
+extern void RunBenchmarks() noexcept;
+}
+
 [[maybe_unused]] static void FillFramebufferBlackMagenta(const Ref<::tau::vd::Window>& window, u8* const framebuffer) noexcept
 {
     for(uSys y = 0; y < window->FramebufferHeight(); ++y)
@@ -203,6 +279,82 @@ int main(int argCount, char* args[])
     ::tau::test::register_allocator::RunTests();
 #endif
 
+#if 0
+    ::tau::test::fpu::RunTests();
+#endif
+
+#if 0
+    ::tau::test::register_file::RunTests();
+#endif
+
+#if 0
+    ::tau::test::operand_collector::RunTests();
+#endif
+
+#if 0
+    ::tau::test::warp_scheduler::RunTests();
+#endif
+
+#if 0
+    ::tau::test::occupancy::RunTests();
+#endif
+
+#if 0
+    ::tau::test::load_store::RunTests();
+#endif
+
+#if 0
+    ::tau::test::store_buffer::RunTests();
+#endif
+
+#if 0
+    ::tau::test::atomic::RunTests();
+#endif
+
+#if 0
+    ::tau::test::shared_memory::RunTests();
+#endif
+
+#if 0
+    ::tau::test::cache::RunTests();
+#endif
+
+#if 0
+    ::tau::test::prefetch::RunTests();
+#endif
+
+#if 0
+    ::tau::test::cache_statistics::RunTests();
+#endif
+
+#if 0
+    ::tau::benchmark::core::RunBenchmarks();
+#endif
+
+#if 0
+    ::tau::benchmark::register_allocator::RunBenchmarks();
+#endif
+
+#if 0
+    ::tau::benchmark::warp_scheduler::RunBenchmarks();
+#endif
+
+#if 0
+    ::tau::benchmark::load_store::RunBenchmarks();
+#endif
+
+#if 0
+    ::tau::benchmark::atomic::RunBenchmarks();
+#endif
+
+#if 0
+    ::tau::benchmark::shared_memory::RunBenchmarks();
+#endif
+
+#if 0
+    ::tau::benchmark::cache::RunBenchmarks();
+#endif
+
     tau::vd::InitSdl();
     Ref<tau::vd::Window> window = tau::vd::Window::CreateWindow();
     Ref<tau::vd::VulkanManager> vulkanManager = tau::vd::VulkanManager::CreateVulkanManager(window);
@@ -0,0 +1,455 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#include <ConPrinter.hpp>
+
+#include <Processor.hpp>
+#include <StreamingMultiprocessor.hpp>
+#include <WarpScheduler.hpp>
+#include <DispatchUnit.hpp>
+#include <PCIControlRegisters.hpp>
+
+#include "KernelAssembly.hpp"
+
+#include <cstring>
+#include <new>
+
+static void TestScoreboardStall() noexcept;
+static void TestMemoryStall() noexcept;
+static void TestDispatchStall() noexcept;
+static void TestRegisterAllocationStall() noexcept;
+static void TestWriteStatistics() noexcept;
+static void TestPciStatistics() noexcept;
+
+namespace tau::test::occupancy {
+
+void RunTests() noexcept
+{
+    TestScoreboardStall();
+    TestMemoryStall();
+    TestDispatchStall();
+    TestRegisterAllocationStall();
+    TestWriteStatistics();
+    TestPciStatistics();
+}
+
+}
+
+static constexpr u32 CLOCK_LIMIT = 1 << 20;
+static constexpr u32 THREAD_REGISTER_COUNT = 16;
+// Enough loads from 8 threads to fill every Ld/St unit's miss status table.
+static constexpr u32 DISPATCH_STALL_LOAD_COUNT = 4;
+
+struct OccupancyTestMemory final
+{
+    alignas(64) u8 Program[512];
+    // Each thread's cache lines are separate so every load misses.
+    alignas(64) u32 Data[8][DISPATCH_STALL_LOAD_COUNT * 8];
+    alignas(64) u32 Registers[8 * THREAD_REGISTER_COUNT];
+};
+
+[[nodiscard]] static u32 WriteStatistics(u8* const program, u32 offset, const EOccupancyStatistic statistic, const u8 target, const u8 clockTarget) noexcept
+{
+    program[offset++] = static_cast<u8>(EInstruction::WriteStatistics);
+    program[offset++] = static_cast<u8>(DispatchUnit::OCCUPANCY_STATISTIC_BASE + static_cast<u32>(statistic));
+    program[offset++] = target;
+    program[offset++] = clockTarget;
+    return offset;
+}
+
+// Launches one warp on port 0 of SM 0 with every thread's base pointer set to its own line of Data.
+static void LaunchWarp(Processor& processor, OccupancyTestMemory& memory, const u8 threadMask) noexcept
+{
+    for(u32 i = 0; i < 8; ++i)
+    {
+        WriteBasePointer(&memory.Registers[i * THREAD_REGISTER_COUNT], memory.Data[i]);
+    }
+
+    (void) processor.TestLaunchWarp(0, 0, reinterpret_cast<u64>(memory.Program), threadMask, THREAD_REGISTER_COUNT - 1, WordAddress(memory.Registers), FpMode { });
+}
+
+[[nodiscard]] static u32 RunUntilComplete(Processor& processor) noexcept
+{
+    StreamingMultiprocessor& sm = processor.TestStreamingMultiprocessor(0);
+    const WarpScheduler& scheduler0 = sm.TestWarpScheduler(0);
+    const WarpScheduler& scheduler1 = sm.TestWarpScheduler(1);
+
+    u32 clock = 0;
+
+    for(; clock < CLOCK_LIMIT && (scheduler0.ActiveWarps() != 0 || scheduler1.ActiveWarps() != 0); ++clock)
+    {
+        processor.Clock();
+    }
+
+    return clock;
+}
+
+[[nodiscard]] static u64 Occupancy(const Processor& processor, const EOccupancyStatistic statistic) noexcept
+{
+    return processor.OccupancyStatistic(0, statistic);
+}
+
+// Every cycle a port has warps active is either issuing or one of the stalls, or lost to a switch or halt.
+[[nodiscard]] static bool IsAccountingConsistent(const Processor& processor) noexcept
+{
+    const u64 attributed = Occupancy(processor, EOccupancyStatistic::IssueCycles) +
+        Occupancy(processor, EOccupancyStatistic::RegisterAllocationStallCycles) +
+        Occupancy(processor, EOccupancyStatistic::ScoreboardStallCycles) +
+        Occupancy(processor, EOccupancyStatistic::MemoryStallCycles) +
+        Occupancy(processor, EOccupancyStatistic::DispatchStallCycles);
+
+    return attributed <= Occupancy(processor, EOccupancyStatistic::Cycles) * 2 &&
+        Occupancy(processor, EOccupancyStatistic::ActiveWarpCycles) >= attributed;
+}
+
+// A chain of adds, each waiting on the result of the last.
+static void TestScoreboardStall() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    OccupancyTestMemory* const memory = new(::std::nothrow) OccupancyTestMemory;
+    (void) ::std::memset(memory, 0, sizeof(*memory));
+
+    u32 offset = 0;
+
+    for(u8 i = 0; i < 8; ++i)
+    {
+        offset = WriteAddF(memory->Program, offset, static_cast<u8>(4 + i), static_cast<u8>(4 + i), static_cast<u8>(5 + i));
+    }
+
+    memory->Program[offset] = static_cast<u8>(EInstruction::Hlt);
+
+    LaunchWarp(*processor, *memory, 0x1);
+    const u32 clock = RunUntilComplete(*processor);
+
+    const u64 scoreboard = Occupancy(*processor, EOccupancyStatistic::ScoreboardStallCycles);
+    const u64 memoryStall = Occupancy(*processor, EOccupancyStatistic::MemoryStallCycles);
+    const u64 dispatch = Occupancy(*processor, EOccupancyStatistic::DispatchStallCycles);
+    const u64 issue = Occupancy(*processor, EOccupancyStatistic::IssueCycles);
+
+    if(clock >= CLOCK_LIMIT)
+    {
+        ConPrinter::PrintLn("Dependent add chain didn't complete in {} clocks.", clock);
+    }
+    else if(scoreboard == 0 || memoryStall != 0 || dispatch != 0)
+    {
+        ConPrinter::PrintLn("Dependent add chain counted {} scoreboard, {} memory, and {} dispatch stall cycles, expected some, 0, and 0.", scoreboard, memoryStall, dispatch);
+    }
+    else if(issue < 8 || !IsAccountingConsistent(*processor))
+    {
+        ConPrinter::PrintLn("Dependent add chain counted {} issue cycles over {} cycles.", issue, Occupancy(*processor, EOccupancyStatistic::Cycles));
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully counted {} scoreboard stall cycles for a dependent add chain.", scoreboard);
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// An add waiting on a load which misses the cache.
+static void TestMemoryStall() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    OccupancyTestMemory* const memory = new(::std::nothrow) OccupancyTestMemory;
+    (void) ::std::memset(memory, 0, sizeof(*memory));
+
+    u32 offset = 0;
+    offset = WriteLoadStore(memory->Program, offset, false, 0, 4, 0);
+    offset = WriteAddF(memory->Program, offset, 4, 4, 5);
+    memory->Program[offset] = static_cast<u8>(EInstruction::Hlt);
+
+    LaunchWarp(*processor, *memory, 0x1);
+    const u32 clock = RunUntilComplete(*processor);
+
+    const u64 scoreboard = Occupancy(*processor, EOccupancyStatistic::ScoreboardStallCycles);
+    const u64 memoryStall = Occupancy(*processor, EOccupancyStatistic::MemoryStallCycles);
+    const u64 dispatch = Occupancy(*processor, EOccupancyStatistic::DispatchStallCycles);
+
+    if(clock >= CLOCK_LIMIT)
+    {
+        ConPrinter::PrintLn("Load and use didn't complete in {} clocks.", clock);
+    }
+    else if(memoryStall < LoadStore::MISS_LATENCY_CYCLES / 2 || memoryStall <= scoreboard || dispatch != 0)
+    {
+        ConPrinter::PrintLn("Load and use counted {} memory, {} scoreboard, and {} dispatch stall cycles, expected at least {}, fewer, and 0.", memoryStall, scoreboard, dispatch, LoadStore::MISS_LATENCY_CYCLES / 2);
+    }
+    else if(!IsAccountingConsistent(*processor))
+    {
+        ConPrinter::PrintLn("Load and use attributed more cycles than the SM ran.");
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully counted {} memory stall cycles for a load and use.", memoryStall);
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// 8 threads each issue 4 loads, the 4 Ld/St units can only hold 16.
+static void TestDispatchStall() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    OccupancyTestMemory* const memory = new(::std::nothrow) OccupancyTestMemory;
+    (void) ::std::memset(memory, 0, sizeof(*memory));
+
+    u32 offset = 0;
+
+    for(u32 i = 0; i < DISPATCH_STALL_LOAD_COUNT; ++i)
+    {
+        offset = WriteLoadStore(memory->Program, offset, false, 0, static_cast<u8>(4 + i), static_cast<i16>(i * 8));
+    }
+
+    memory->Program[offset] = static_cast<u8>(EInstruction::Hlt);
+
+    LaunchWarp(*processor, *memory, 0xFF);
+    const u32 clock = RunUntilComplete(*processor);
+
+    const u64 scoreboard = Occupancy(*processor, EOccupancyStatistic::ScoreboardStallCycles);
+    const u64 memoryStall = Occupancy(*processor, EOccupancyStatistic::MemoryStallCycles);
+    const u64 dispatch = Occupancy(*processor, EOccupancyStatistic::DispatchStallCycles);
+    const u64 lanes = Occupancy(*processor, EOccupancyStatistic::ActiveLaneCycles);
+    const u64 warps = Occupancy(*processor, EOccupancyStatistic::ActiveWarpCycles);
+
+    if(clock >= CLOCK_LIMIT)
+    {
+        ConPrinter::PrintLn("Oversubscribed loads didn't complete in {} clocks.", clock);
+    }
+    else if(dispatch == 0 || scoreboard != 0 || memoryStall != 0)
+    {
+        ConPrinter::PrintLn("Oversubscribed loads counted {} dispatch, {} scoreboard, and {} memory stall cycles, expected some, 0, and 0.", dispatch, scoreboard, memoryStall);
+    }
+    else if(lanes <= warps || lanes > warps * 8 || !IsAccountingConsistent(*processor))
+    {
+        ConPrinter::PrintLn("Oversubscribed loads counted {} lane cycles over {} warp cycles.", lanes, warps);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully counted {} dispatch stall cycles for 32 loads on 4 units.", dispatch);
+    }
+
+    delete memory;
+    delete processor;
+}
+
+struct AllocationTestMemory final
+{
+    alignas(64) u8 Program[160];
+    alignas(64) u32 Registers[3][2048];
+};
+
+// Three warps which each need a whole column of the register file, only two fit.
+static void TestRegisterAllocationStall() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    AllocationTestMemory* const memory = new(::std::nothrow) AllocationTestMemory;
+    (void) ::std::memset(memory, 0, sizeof(*memory));
+    (void) ::std::memset(memory->Program, static_cast<u8>(EInstruction::Nop), sizeof(memory->Program) - 1);
+    memory->Program[sizeof(memory->Program) - 1] = static_cast<u8>(EInstruction::Hlt);
+
+    (void) processor->TestLaunchWarp(0, 0, reinterpret_cast<u64>(memory->Program), 0xFF, 255, WordAddress(memory->Registers[0]), FpMode { });
+    (void) processor->TestLaunchWarp(0, 0, reinterpret_cast<u64>(memory->Program), 0xFF, 255, WordAddress(memory->Registers[1]), FpMode { });
+    (void) processor->TestLaunchWarp(0, 1, reinterpret_cast<u64>(memory->Program), 0xFF, 255, WordAddress(memory->Registers[2]), FpMode { });
+
+    const u32 clock = RunUntilComplete(*processor);
+
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+    const WarpScheduler& scheduler0 = sm.TestWarpScheduler(0);
+    const WarpScheduler& scheduler1 = sm.TestWarpScheduler(1);
+
+    const u64 allocation = Occupancy(*processor, EOccupancyStatistic::RegisterAllocationStallCycles);
+    const u64 transfers = scheduler0.TransferCycles() + scheduler1.TransferCycles() + scheduler0.AllocationStallCycles() + scheduler1.AllocationStallCycles();
+    const u64 resident = Occupancy(*processor, EOccupancyStatistic::ResidentWarpCycles);
+    const u64 active = Occupancy(*processor, EOccupancyStatistic::ActiveWarpCycles);
+
+    if(clock >= CLOCK_LIMIT)
+    {
+        ConPrinter::PrintLn("Oversized warps didn't complete in {} clocks.", clock);
+    }
+    else if(allocation < transfers || transfers == 0)
+    {
+        ConPrinter::PrintLn("Oversized warps counted {} register allocation stall cycles, expected at least {}.", allocation, transfers);
+    }
+    else if(Occupancy(*processor, EOccupancyStatistic::ScoreboardStallCycles) != 0 || Occupancy(*processor, EOccupancyStatistic::MemoryStallCycles) != 0 || Occupancy(*processor, EOccupancyStatistic::DispatchStallCycles) != 0)
+    {
+        ConPrinter::PrintLn("Oversized Nop warps counted stalls other than register allocation.");
+    }
+    else if(resident == 0 || resident >= active || !IsAccountingConsistent(*processor))
+    {
+        ConPrinter::PrintLn("Oversized warps counted {} resident warp cycles against {} active.", resident, active);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully counted {} register allocation stall cycles for oversized warps.", allocation);
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// The kernel reads its own scoreboard stalls back, after a reset part way through.
+static void TestWriteStatistics() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    OccupancyTestMemory* const memory = new(::std::nothrow) OccupancyTestMemory;
+    (void) ::std::memset(memory, 0, sizeof(*memory));
+
+    u32 offset = 0;
+    offset = WriteAddF(memory->Program, offset, 4, 4, 5);
+    offset = WriteAddF(memory->Program, offset, 5, 5, 6);
+    memory->Program[offset++] = static_cast<u8>(EInstruction::ResetStatistics);
+    offset = WriteAddF(memory->Program, offset, 6, 6, 7);
+    offset = WriteAddF(memory->Program, offset, 7, 7, 8);
+    offset = WriteStatistics(memory->Program, offset, EOccupancyStatistic::ScoreboardStallCycles, 10, 12);
+    offset = WriteStatistics(memory->Program, offset, EOccupancyStatistic::Cycles, 14, 12);
+    memory->Program[offset++] = static_cast<u8>(EInstruction::Hlt);
+
+    LaunchWarp(*processor, *memory, 0x1);
+
+    // The registers are read back directly, the kernel writing them through a store would add stalls of its own.
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+    const WarpScheduler& scheduler = sm.TestWarpScheduler(0);
+
+    u32 written[6] { };
+    u32 clock = 0;
+
+    for(; clock < CLOCK_LIMIT && scheduler.ActiveWarps() != 0; ++clock)
+    {
+        processor->Clock();
+
+        if(scheduler.State() == WarpScheduler::EState::Running)
+        {
+            const u32 base = scheduler.Warp(0).RegisterFileBase;
+            written[0] = sm.GetRegister(base + 10);
+            written[1] = sm.GetRegister(base + 11);
+            written[4] = sm.GetRegister(base + 14);
+            written[5] = sm.GetRegister(base + 15);
+        }
+    }
+
+    const u64 scoreboard = written[0] | (static_cast<u64>(written[1]) << 32);
+    const u64 cycles = written[4] | (static_cast<u64>(written[5]) << 32);
+    const u64 total = Occupancy(*processor, EOccupancyStatistic::ScoreboardStallCycles);
+
+    if(clock >= CLOCK_LIMIT)
+    {
+        ConPrinter::PrintLn("Statistics kernel didn't complete in {} clocks.", clock);
+    }
+    else if(scoreboard == 0 || scoreboard > total)
+    {
+        ConPrinter::PrintLn("Kernel read {} scoreboard stall cycles, the SM counted {}.", scoreboard, total);
+    }
+    else if(cycles == 0 || cycles >= Occupancy(*processor, EOccupancyStatistic::Cycles) || cycles >= clock)
+    {
+        ConPrinter::PrintLn("Kernel read {} cycles after resetting the statistics, the SM ran {} in total.", cycles, clock);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully wrote {} scoreboard stall cycles over {} cycles from a kernel.", scoreboard, cycles);
+    }
+
+    delete memory;
+    delete processor;
+}
+
+static void PciWrite(Processor& processor, const u32 address, const u32 value) noexcept
+{
+    PciControlRegistersBus& bus = processor.PciControlRegistersBus();
+    bus.WriteAddress = address;
+    bus.WriteSize = 4;
+    bus.WriteValue = value;
+    bus.WriteBusLocked = 1;
+
+    processor.Clock();
+
+    bus.WriteBusLocked = 0;
+}
+
+[[nodiscard]] static u32 PciRead(Processor& processor, const u32 address) noexcept
+{
+    PciControlRegistersBus& bus = processor.PciControlRegistersBus();
+    bus.ReadAddress = address;
+    bus.ReadSize = 4;
+    bus.ReadBusLocked = 1;
+
+    processor.Clock();
+
+    bus.ReadBusLocked = 0;
+
+    return bus.ReadResponse;
+}
+
+[[nodiscard]] static u64 PciReadSmStatistic(Processor& processor, const u32 sm, const EOccupancyStatistic statistic) noexcept
+{
+    PciWrite(processor, PciControlRegisters::REGISTER_SM_STATISTIC_SELECT, (sm << 8) | static_cast<u32>(statistic));
+
+    const u32 low = PciRead(processor, PciControlRegisters::REGISTER_SM_STATISTIC_LOW);
+    const u32 high = PciRead(processor, PciControlRegisters::REGISTER_SM_STATISTIC_HIGH);
+
+    return low | (static_cast<u64>(high) << 32);
+}
+
+static void TestPciStatistics() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    OccupancyTestMemory* const memory = new(::std::nothrow) OccupancyTestMemory;
+    (void) ::std::memset(memory, 0, sizeof(*memory));
+
+    u32 offset = 0;
+    offset = WriteLoadStore(memory->Program, offset, false, 0, 4, 0);
+    offset = WriteAddF(memory->Program, offset, 4, 4, 5);
+    memory->Program[offset] = static_cast<u8>(EInstruction::Hlt);
+
+    LaunchWarp(*processor, *memory, 0x3);
+    (void) RunUntilComplete(*processor);
+
+    // Nothing is running any more, so everything but the cycle count holds still while it's read.
+    const u64 memoryStall = PciReadSmStatistic(*processor, 0, EOccupancyStatistic::MemoryStallCycles);
+    const u64 lanes = PciReadSmStatistic(*processor, 0, EOccupancyStatistic::ActiveLaneCycles);
+    const u64 otherSm = PciReadSmStatistic(*processor, 1, EOccupancyStatistic::ActiveLaneCycles);
+    const u64 cycles = PciReadSmStatistic(*processor, 0, EOccupancyStatistic::Cycles);
+    const u64 invalid = PciReadSmStatistic(*processor, 0, EOccupancyStatistic::Count);
+
+    if(memoryStall == 0 || memoryStall != Occupancy(*processor, EOccupancyStatistic::MemoryStallCycles))
+    {
+        ConPrinter::PrintLn("PCI read {} memory stall cycles, the SM counted {}.", memoryStall, Occupancy(*processor, EOccupancyStatistic::MemoryStallCycles));
+    }
+    else if(lanes == 0 || lanes != Occupancy(*processor, EOccupancyStatistic::ActiveLaneCycles) || otherSm != 0)
+    {
+        ConPrinter::PrintLn("PCI read {} active lane cycles for SM 0 and {} for SM 1, SM 0 counted {}.", lanes, otherSm, Occupancy(*processor, EOccupancyStatistic::ActiveLaneCycles));
+    }
+    else if(cycles == 0 || cycles >= Occupancy(*processor, EOccupancyStatistic::Cycles) || invalid != 0)
+    {
+        ConPrinter::PrintLn("PCI read {} cycles and {} for an invalid statistic.", cycles, invalid);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully read SM statistics through the PCI control registers.");
+    }
+
+    processor->ResetOccupancyStatistics(0);
+
+    if(Occupancy(*processor, EOccupancyStatistic::MemoryStallCycles) != 0 || Occupancy(*processor, EOccupancyStatistic::Cycles) != 0)
+    {
+        ConPrinter::PrintLn("Occupancy statistics weren't cleared by a reset.");
+    }
+
+    delete memory;
+    delete processor;
+}
@@ -0,0 +1,490 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#include <ConPrinter.hpp>
+
+#include <OperandCollector.hpp>
+#include <CoreRegisterManager.hpp>
+#include <Core.hpp>
+#include <StreamingMultiprocessor.hpp>
+
+#include <bit>
+#include <new>
+
+static void TestForwardAndLookup() noexcept;
+static void TestObservedWrites() noexcept;
+static void TestReplacement() noexcept;
+static void TestRegisterManagerForwarding() noexcept;
+static void TestRegisterManagerInvalidation() noexcept;
+static void TestRegisterManagerLockRelease() noexcept;
+static void TestStreamingMultiprocessorBroadcast() noexcept;
+static void TestRegisterManagerBankConflict() noexcept;
+
+namespace tau::test::operand_collector {
+
+void RunTests() noexcept
+{
+    TestForwardAndLookup();
+    TestObservedWrites();
+    TestReplacement();
+    TestRegisterManagerForwarding();
+    TestRegisterManagerInvalidation();
+    TestRegisterManagerLockRelease();
+    TestStreamingMultiprocessorBroadcast();
+    TestRegisterManagerBankConflict();
+}
+
+}
+
+// A core with a small register file of its own behind its port, which captures the operand values the register
+// manager reports. Its port never has a bank conflict, so every command executes as soon as it's sent.
+class OperandTestCore final : public ICore
+{
+    DEFAULT_DESTRUCT(OperandTestCore);
+    DELETE_CM(OperandTestCore);
+public:
+    OperandTestCore() noexcept
+        : m_ReportCount(0)
+        , m_A(0)
+        , m_B(0)
+        , m_C(0)
+        , m_Registers{ }
+        , m_RegisterReads(0)
+        , m_ReleaseCount(0)
+        , m_LastRelease(0)
+    { }
+
+    void InvokeRegisterFileHigh(const RegisterFile::CommandPacket packet) noexcept override
+    {
+        ExecuteCommand(packet, 1);
+    }
+
+    void InvokeRegisterFileLow(const RegisterFile::CommandPacket packet) noexcept override
+    {
+        ExecuteCommand(packet, 0);
+    }
+
+    void ReleaseRegisterContestation(const u32 registerIndex) noexcept override
+    {
+        ++m_ReleaseCount;
+        m_LastRelease = registerIndex;
+    }
+
+    [[nodiscard]] u32 GetRegister(const u32 registerIndex) const noexcept
+    {
+        return m_Registers[registerIndex % 64];
+    }
+
+    void SetRegister(const u32 registerIndex, const u32 value) noexcept
+    {
+        m_Registers[registerIndex % 64] = value;
+    }
+
+    void ReportRegisterValues(const u64 a, const u64 b, const u64 c) noexcept override
+    {
+        ++m_ReportCount;
+        m_A = a;
+        m_B = b;
+        m_C = c;
+    }
+
+    void PrepareRegisterWrite(bool, u32, u64) noexcept override { }
+    void ReportReady() const noexcept override { }
+
+    void ExecuteCommand(const RegisterFile::CommandPacket packet, const u32 highBit) noexcept
+    {
+        const u32 registerIndex = (static_cast<u32>(packet.TargetRegister) << 1) | highBit;
+
+        if(packet.Command == RegisterFile::ECommand::ReadRegister)
+        {
+            ++m_RegisterReads;
+            *packet.Value = GetRegister(registerIndex);
+        }
+        else if(packet.Command == RegisterFile::ECommand::WriteRegister)
+        {
+            SetRegister(registerIndex, *packet.Value);
+        }
+
+        *packet.Successful = true;
+        *packet.Unsuccessful = false;
+    }
+
+    u32 m_ReportCount;
+    u64 m_A;
+    u64 m_B;
+    u64 m_C;
+    u32 m_Registers[64];
+    u32 m_RegisterReads;
+    u32 m_ReleaseCount;
+    u32 m_LastRelease;
+};
+
+// Runs the register manager through one full cycle of sub-clocks.
+static void ClockCycle(CoreRegisterManager& crm) noexcept
+{
+    for(u32 clockIndex = 0; clockIndex <= 5; ++clockIndex)
+    {
+        crm.Clock(clockIndex);
+    }
+}
+
+// Writes a result through the register manager the way the core retires it.
+static void RetireWrite(CoreRegisterManager& crm, const bool is64Bit, const u32 storageRegister, const u64 value) noexcept
+{
+    crm.InitiateRegisterWrite(is64Bit, storageRegister, value);
+    ClockCycle(crm);
+}
+
+static void TestForwardAndLookup() noexcept
+{
+    OperandCollector collector;
+
+    u32 value = 0;
+    const bool coldHit = collector.Lookup(5, &value);
+
+    collector.Forward(5, 0xCAFEF00D);
+    collector.Fill(6, 0x600D);
+
+    u32 forwarded = 0;
+    u32 filled = 0;
+    const bool forwardHit = collector.Lookup(5, &forwarded);
+    const bool fillHit = collector.Lookup(6, &filled);
+
+    if(coldHit || !forwardHit || !fillHit || forwarded != 0xCAFEF00D || filled != 0x600D)
+    {
+        ConPrinter::PrintLn("Operand collector returned 0x{XP0} and 0x{XP0} for forwarded and filled registers.", forwarded, filled);
+    }
+    else if(collector.Hits() != 2 || collector.Misses() != 1 || collector.Forwards() != 1)
+    {
+        ConPrinter::PrintLn("Operand collector counted {} hits, {} misses, and {} forwards, expected 2, 1, and 1.", collector.Hits(), collector.Misses(), collector.Forwards());
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully forwarded and looked up operands.");
+    }
+}
+
+static void TestObservedWrites() noexcept
+{
+    OperandCollector collector;
+
+    collector.Forward(10, 100);
+    collector.Forward(11, 110);
+    collector.Forward(12, 120);
+
+    // Our own write coming back through the register file must not drop the entry.
+    collector.ObserveWrite(10, 100);
+    // Another unit writing a new value must.
+    collector.ObserveWrite(11, 999);
+    // As must a write we can't account for.
+    collector.ObserveWrite(13, 130);
+
+    u32 value;
+    const bool ownKept = collector.Lookup(10, &value);
+    const bool otherDropped = !collector.Lookup(11, &value);
+    const bool untouchedKept = collector.Lookup(12, &value);
+
+    collector.InvalidateAll();
+    const bool allDropped = !collector.Lookup(10, &value) && !collector.Lookup(12, &value);
+
+    if(!ownKept || !otherDropped || !untouchedKept)
+    {
+        ConPrinter::PrintLn("Operand collector handled an observed write incorrectly.");
+    }
+    else if(!allDropped || collector.Invalidations() != 3)
+    {
+        ConPrinter::PrintLn("Operand collector counted {} invalidations, expected 3.", collector.Invalidations());
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully invalidated operands on writes from other units.");
+    }
+}
+
+static void TestReplacement() noexcept
+{
+    OperandCollector collector;
+
+    for(u32 i = 0; i < OperandCollector::ENTRY_COUNT; ++i)
+    {
+        collector.Fill(i, i);
+    }
+
+    // Register 0 is now the most recently used, so register 1 is the one to go.
+    u32 value;
+    (void) collector.Lookup(0, &value);
+    collector.Fill(100, 100);
+
+    const bool keptRecent = collector.Lookup(0, &value);
+    const bool evictedOldest = !collector.Lookup(1, &value);
+    const bool insertedNew = collector.Lookup(100, &value) && value == 100;
+
+    if(!keptRecent || !evictedOldest || !insertedNew)
+    {
+        ConPrinter::PrintLn("Operand collector did not replace the least recently used entry.");
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully replaced the least recently used operand.");
+    }
+}
+
+static void TestRegisterManagerForwarding() noexcept
+{
+    OperandTestCore core;
+    CoreRegisterManager crm(&core);
+
+    RetireWrite(crm, false, 10, 0x1234);
+    RetireWrite(crm, false, 11, 0x5678);
+
+    // The next instruction reads both results, neither needs the register file.
+    crm.InitiateRegisterRead(false, 1, 10, 11, 0);
+    ClockCycle(crm);
+
+    const bool singleForwarded = core.m_ReportCount == 1 && core.m_A == 0x1234 && core.m_B == 0x5678;
+
+    RetireWrite(crm, true, 20, 0x0123456789ABCDEFull);
+
+    crm.InitiateRegisterRead(true, 0, 20, 0, 0);
+    ClockCycle(crm);
+
+    const bool doubleForwarded = core.m_ReportCount == 2 && core.m_A == 0x0123456789ABCDEFull;
+
+    // Register 30 was never written by this core, so this read has to go to the register file.
+    core.SetRegister(30, 0x3030);
+    crm.InitiateRegisterRead(false, 1, 10, 30, 0);
+    ClockCycle(crm);
+
+    const bool missRead = core.m_ReportCount == 3 && core.m_A == 0x1234 && core.m_B == 0x3030 && core.m_RegisterReads == 1;
+
+    // The value read for register 30 is kept, reading it again doesn't go to the register file.
+    crm.InitiateRegisterRead(false, 0, 30, 0, 0);
+    ClockCycle(crm);
+
+    const bool missFilled = core.m_ReportCount == 4 && core.m_A == 0x3030 && core.m_RegisterReads == 1;
+
+    const OperandCollector& operands = crm.Operands();
+
+    if(!singleForwarded)
+    {
+        ConPrinter::PrintLn("Forwarded 32 bit operands were 0x{XP0} and 0x{XP0}.", core.m_A, core.m_B);
+    }
+    else if(!doubleForwarded)
+    {
+        ConPrinter::PrintLn("Forwarded 64 bit operand was 0x{XP0}.", core.m_A);
+    }
+    else if(!missRead || !missFilled)
+    {
+        ConPrinter::PrintLn("Register 30 was read as 0x{XP0} with {} register file reads, expected 0x3030 with 1.", core.m_A, core.m_RegisterReads);
+    }
+    else if(core.GetRegister(10) != 0x1234 || core.GetRegister(21) != 0x01234567)
+    {
+        ConPrinter::PrintLn("Retired results weren't written to the register file.");
+    }
+    else if(operands.Hits() != 6 || operands.Misses() != 1)
+    {
+        ConPrinter::PrintLn("Register manager counted {} hits and {} misses, expected 6 and 1.", operands.Hits(), operands.Misses());
+    }
+    else if(crm.CollectedRegisterReads() != 6 || crm.PortRegisterReads() != core.m_RegisterReads)
+    {
+        ConPrinter::PrintLn("Register manager counted {} collected and {} port register reads, expected 6 and {}.", crm.CollectedRegisterReads(), crm.PortRegisterReads(), core.m_RegisterReads);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully forwarded results to the next instruction.");
+    }
+}
+
+static void TestRegisterManagerInvalidation() noexcept
+{
+    OperandTestCore core;
+    CoreRegisterManager crm(&core);
+
+    RetireWrite(crm, false, 10, 0x1234);
+
+    // A Ld/St unit overwrites the register before we read it.
+    core.SetRegister(10, 0xBEEF);
+    crm.ObserveRegisterWrite(10, 0xBEEF);
+
+    crm.InitiateRegisterRead(false, 0, 10, 0, 0);
+    ClockCycle(crm);
+
+    if(core.m_ReportCount != 1 || core.m_A != 0xBEEF)
+    {
+        ConPrinter::PrintLn("Register manager read operand 0x{XP0}, expected 0xBEEF.", core.m_A);
+    }
+    else if(crm.Operands().Misses() != 1 || crm.Operands().Invalidations() != 1)
+    {
+        ConPrinter::PrintLn("Register manager counted {} misses and {} invalidations, expected 1 and 1.", crm.Operands().Misses(), crm.Operands().Invalidations());
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully refused to forward a stale operand.");
+    }
+}
+
+static void TestRegisterManagerLockRelease() noexcept
+{
+    OperandTestCore core;
+    CoreRegisterManager crm(&core);
+
+    // Two 64 bit operands and a 64 bit result, each register pair was locked by the dispatch unit.
+    crm.InitiateRegisterRead(true, 1, 4, 8, 0);
+    crm.InitiateRegisterWrite(true, 12, 0);
+
+    // The locks are released the cycle after the read and write.
+    ClockCycle(crm);
+    const u32 releasesDuringAccess = core.m_ReleaseCount;
+    ClockCycle(crm);
+
+    if(releasesDuringAccess != 0)
+    {
+        ConPrinter::PrintLn("Register manager released {} locks before the operands were read.", releasesDuringAccess);
+    }
+    else if(core.m_ReleaseCount != 6 || core.m_LastRelease != 13)
+    {
+        ConPrinter::PrintLn("Register manager released {} locks ending with register {}, expected 6 ending with 13.", core.m_ReleaseCount, core.m_LastRelease);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully released the register locks of a retired instruction.");
+    }
+}
+
+static void TestStreamingMultiprocessorBroadcast() noexcept
+{
+    StreamingMultiprocessor* const sm = new(::std::nothrow) StreamingMultiprocessor(nullptr, 0);
+    sm->Reset();
+
+    FpuInstruction instruction;
+    instruction.DispatchPort = 0;
+    instruction.Operation = EFpuOp::BasicBinOp;
+    instruction.Precision = EPrecision::Single;
+    instruction.FlushToZero = 0;
+    instruction.DenormalsAreZero = 0;
+    instruction.Reserved0 = 0;
+    instruction.OperandA = 0;
+    instruction.OperandB = 2;
+    instruction.OperandC = static_cast<u32>(EBinOp::Add);
+    instruction.StorageRegister = 40;
+    instruction.Reserved1 = 0;
+
+    sm->TestWriteRegister(0, ::std::bit_cast<u32>(1.5f));
+    sm->TestWriteRegister(2, ::std::bit_cast<u32>(2.25f));
+
+    sm->DispatchFpu(0, instruction);
+
+    for(u32 i = 0; i < 8; ++i)
+    {
+        sm->Clock();
+    }
+
+    const OperandCollector& operands = sm->TestCoreRegisterManager(0).Operands();
+    const u64 forwards = operands.Forwards();
+    const u32 result = sm->GetRegister(40);
+
+    // A write to an unrelated register leaves the result alone, a write to the result register drops it.
+    sm->TestWriteRegister(41, 0xDEAD);
+    const u64 unrelatedInvalidations = operands.Invalidations();
+    sm->TestWriteRegister(40, 0xDEAD);
+    const u64 invalidations = operands.Invalidations();
+
+    if(forwards != 1)
+    {
+        ConPrinter::PrintLn("FP core 0 forwarded {} results, expected 1.", forwards);
+    }
+    else if(result != ::std::bit_cast<u32>(3.75f))
+    {
+        ConPrinter::PrintLn("FP core 0 wrote {} to the register file, expected 3.75.", ::std::bit_cast<f32>(result));
+    }
+    else if(unrelatedInvalidations != 0 || invalidations != 1)
+    {
+        ConPrinter::PrintLn("Register writes caused {} and {} invalidations, expected 0 and 1.", unrelatedInvalidations, invalidations);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully broadcast register writes to the operand collectors.");
+    }
+
+    delete sm;
+}
+
+// Two cores adding registers from the same banks in the same cycle, returns the cycles until both results are in.
+static u32 RunConflictingAdds(StreamingMultiprocessor* const sm, const bool modelBankConflicts, u64* const stallCycles) noexcept
+{
+    sm->Reset();
+    sm->SetRegisterBankConflictModelling(modelBankConflicts);
+
+    // Registers 0 and 16 are both in bank 0, 2 and 18 are both in bank 2.
+    sm->TestWriteRegister(0, ::std::bit_cast<u32>(1.5f));
+    sm->TestWriteRegister(2, ::std::bit_cast<u32>(2.25f));
+    sm->TestWriteRegister(16, ::std::bit_cast<u32>(4.0f));
+    sm->TestWriteRegister(18, ::std::bit_cast<u32>(0.5f));
+
+    FpuInstruction instruction;
+    instruction.DispatchPort = 0;
+    instruction.Operation = EFpuOp::BasicBinOp;
+    instruction.Precision = EPrecision::Single;
+    instruction.FlushToZero = 0;
+    instruction.DenormalsAreZero = 0;
+    instruction.Reserved0 = 0;
+    instruction.OperandA = 0;
+    instruction.OperandB = 2;
+    instruction.OperandC = static_cast<u32>(EBinOp::Add);
+    instruction.StorageRegister = 40;
+    instruction.Reserved1 = 0;
+
+    sm->DispatchFpu(0, instruction);
+
+    instruction.OperandA = 16;
+    instruction.OperandB = 18;
+    instruction.StorageRegister = 42;
+
+    sm->DispatchFpu(1, instruction);
+
+    u32 cycles = 0;
+
+    while(cycles < 32 && (sm->GetRegister(40) != ::std::bit_cast<u32>(3.75f) || sm->GetRegister(42) != ::std::bit_cast<u32>(4.5f)))
+    {
+        sm->Clock();
+        ++cycles;
+    }
+
+    *stallCycles = sm->CoreBankConflictStallCycles();
+    return cycles;
+}
+
+static void TestRegisterManagerBankConflict() noexcept
+{
+    StreamingMultiprocessor* const sm = new(::std::nothrow) StreamingMultiprocessor(nullptr, 0);
+
+    u64 conflictStallCycles = 0;
+    const u32 conflictCycles = RunConflictingAdds(sm, true, &conflictStallCycles);
+    const u64 bankConflicts = sm->TotalRegisterBankConflicts();
+    const u64 core0StallCycles = sm->TestCoreRegisterManager(0).BankConflictStallCycles();
+
+    u64 freeStallCycles = 0;
+    const u32 freeCycles = RunConflictingAdds(sm, false, &freeStallCycles);
+
+    if(conflictCycles >= 32 || freeCycles >= 32)
+    {
+        ConPrinter::PrintLn("Cores adding registers from the same banks didn't write their results.");
+    }
+    else if(bankConflicts == 0 || conflictStallCycles == 0 || core0StallCycles != 0)
+    {
+        ConPrinter::PrintLn("Cores counted {} bank conflicts and {} stall cycles, {} on core 0, expected core 1 to stall.", bankConflicts, conflictStallCycles, core0StallCycles);
+    }
+    else if(freeStallCycles != 0 || conflictCycles <= freeCycles)
+    {
+        ConPrinter::PrintLn("Bank conflicts took {} cycles against {} without them, with {} stall cycles while disabled.", conflictCycles, freeCycles, freeStallCycles);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully stalled a core on a register bank conflict, {} cycles against {}.", conflictCycles, freeCycles);
+    }
+
+    delete sm;
+}
@@ -0,0 +1,434 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#include <ConPrinter.hpp>
+
+#include <Processor.hpp>
+
+#include "KernelAssembly.hpp"
+
+#include <cstring>
+#include <new>
+
+static void TestBackgroundFill() noexcept;
+static void TestUsefulAndUseless() noexcept;
+static void TestMissStatusLimit() noexcept;
+static void TestLateMerge() noexcept;
+static void TestStrideTraining() noexcept;
+static void TestStrideKernel() noexcept;
+
+namespace tau::test::prefetch {
+
+void RunTests() noexcept
+{
+    TestBackgroundFill();
+    TestUsefulAndUseless();
+    TestMissStatusLimit();
+    TestLateMerge();
+    TestStrideTraining();
+    TestStrideKernel();
+}
+
+}
+
+static constexpr u32 CLOCK_LIMIT = 1 << 20;
+static constexpr u32 LINE_WORDS = 8;
+// Lines this far apart share an L0 set.
+static constexpr u32 L0_SET_STRIDE = 2048;
+static constexpr u32 KERNEL_WARP_COUNT = 16;
+
+struct PrefetchTestMemory final
+{
+    alignas(64) u8 Program[64];
+    alignas(64) u32 Data[L0_SET_STRIDE * 6];
+    alignas(64) u32 Registers[KERNEL_WARP_COUNT][16];
+};
+
+[[nodiscard]] static PrefetchTestMemory* CreateMemory() noexcept
+{
+    PrefetchTestMemory* const memory = new(::std::nothrow) PrefetchTestMemory;
+    (void) ::std::memset(memory, 0, sizeof(*memory));
+
+    for(u32 i = 0; i < ::std::size(memory->Data); ++i)
+    {
+        memory->Data[i] = 0xDA7A0000u | i;
+    }
+
+    return memory;
+}
+
+// Loads r4 from [r0:r1], and if copyOffset isn't 0 stores it back copyOffset words further on, where it outlives the warp.
+static void WriteLoadKernel(PrefetchTestMemory& memory, const i16 copyOffset) noexcept
+{
+    u32 offset = WriteLoadStore(memory.Program, 0, false, 0, 4, 0);
+
+    if(copyOffset)
+    {
+        offset = WriteLoadStore(memory.Program, offset, true, 0, 4, copyOffset);
+    }
+
+    memory.Program[offset] = static_cast<u8>(EInstruction::Hlt);
+}
+
+static void LaunchLoadWarp(Processor& processor, PrefetchTestMemory& memory, const u32 warp, const u64 address) noexcept
+{
+    memory.Registers[warp][0] = static_cast<u32>(address);
+    memory.Registers[warp][1] = static_cast<u32>(address >> 32);
+
+    (void) processor.TestLaunchWarp(0, 0, reinterpret_cast<u64>(memory.Program), 0x1, 15, WordAddress(memory.Registers[warp]), FpMode { });
+}
+
+static void ClockCycles(Processor& processor, const u32 cycles) noexcept
+{
+    for(u32 i = 0; i < cycles; ++i)
+    {
+        processor.Clock();
+    }
+}
+
+// Runs the launched warps to completion, returning the clocks taken.
+[[nodiscard]] static u32 RunWarps(Processor& processor) noexcept
+{
+    const WarpScheduler& scheduler = processor.TestStreamingMultiprocessor(0).TestWarpScheduler(0);
+
+    u32 clock = 0;
+
+    for(; clock < CLOCK_LIMIT && scheduler.ActiveWarps() != 0; ++clock)
+    {
+        processor.Clock();
+    }
+
+    return clock;
+}
+
+// A prefetch doesn't touch the L0 until the miss latency has passed, and then fills it without counting an access.
+static void TestBackgroundFill() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    PrefetchTestMemory* const memory = CreateMemory();
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+    const CacheController& controller = processor->TestCacheController();
+
+    const u64 address = WordAddress(&memory->Data[0]);
+
+    sm.Prefetch(address + 3);
+
+    const bool cachedEarly = sm.IsCached(address);
+    const u32 inFlight = sm.Prefetches().InFlight();
+
+    ClockCycles(*processor, LoadStore::MISS_LATENCY_CYCLES - 1);
+    const bool cachedBeforeLatency = sm.IsCached(address);
+
+    ClockCycles(*processor, 1);
+    const bool cachedAfterLatency = sm.IsCached(address);
+
+    if(cachedEarly || cachedBeforeLatency || !cachedAfterLatency || inFlight != 1 || sm.Prefetches().InFlight() != 0)
+    {
+        ConPrinter::PrintLn("A prefetch was cached {}, {} and {} at 0, {} and {} cycles, with {} in flight.", cachedEarly, cachedBeforeLatency, cachedAfterLatency, LoadStore::MISS_LATENCY_CYCLES - 1, LoadStore::MISS_LATENCY_CYCLES, inFlight);
+    }
+    else if(sm.Prefetches().Issued() != 1 || controller.L0PrefetchFills(0) != 1 || controller.L0Hits(0) != 0 || controller.L0Misses(0) != 0)
+    {
+        ConPrinter::PrintLn("A prefetch counted {} issued and {} fills, with {} hits and {} misses, expected 1, 1, 0 and 0.", sm.Prefetches().Issued(), controller.L0PrefetchFills(0), controller.L0Hits(0), controller.L0Misses(0));
+    }
+    else if(sm.Read(address + 3) != memory->Data[3])
+    {
+        ConPrinter::PrintLn("A prefetched line read 0x{XP0}, expected 0x{XP0}.", sm.Read(address + 3), memory->Data[3]);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully filled a prefetch in the background after {} cycles.", LoadStore::MISS_LATENCY_CYCLES);
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// A prefetched line which is read was useful, one evicted or invalidated by another SM's write first wasn't.
+static void TestUsefulAndUseless() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    PrefetchTestMemory* const memory = CreateMemory();
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+    const CacheController& controller = processor->TestCacheController();
+
+    const u64 usedAddress = WordAddress(&memory->Data[0]);
+    const u64 evictedAddress = WordAddress(&memory->Data[LINE_WORDS]);
+    const u64 sharedAddress = WordAddress(&memory->Data[LINE_WORDS * 2]);
+
+    sm.Prefetch(usedAddress);
+    sm.Prefetch(evictedAddress);
+    sm.Prefetch(sharedAddress);
+    ClockCycles(*processor, LoadStore::MISS_LATENCY_CYCLES);
+
+    // Only the first hit counts.
+    (void) sm.Read(usedAddress);
+    (void) sm.Read(usedAddress + 1);
+
+    // Fills the rest of the evicted line's set and then one more, which replaces the oldest clean line.
+    for(u32 i = 1; i <= 4; ++i)
+    {
+        (void) processor->Read(0, evictedAddress + i * L0_SET_STRIDE);
+    }
+
+    const bool evicted = !sm.IsCached(evictedAddress);
+
+    processor->Write(1, sharedAddress, 0x5EED);
+
+    const bool invalidated = !sm.IsCached(sharedAddress);
+
+    if(!evicted || !invalidated)
+    {
+        ConPrinter::PrintLn("The prefetched lines were evicted {} and invalidated {}, expected both.", evicted, invalidated);
+    }
+    else if(controller.L0PrefetchFills(0) != 3 || controller.L0UsefulPrefetches(0) != 1 || controller.L0UselessPrefetches(0) != 2)
+    {
+        ConPrinter::PrintLn("The L0 counted {} prefetch fills, {} useful and {} useless, expected 3, 1 and 2.", controller.L0PrefetchFills(0), controller.L0UsefulPrefetches(0), controller.L0UselessPrefetches(0));
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully counted 1 useful and 2 useless prefetches.");
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// Prefetches beyond the free registers are dropped, and lines already cached or coming aren't fetched again.
+static void TestMissStatusLimit() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    PrefetchTestMemory* const memory = CreateMemory();
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+    const Prefetcher& prefetcher = sm.Prefetches();
+
+    const u64 base = WordAddress(&memory->Data[0]);
+    const u64 cachedAddress = base + LINE_WORDS * (Prefetcher::MISS_STATUS_ENTRY_COUNT + 1);
+
+    (void) sm.Read(cachedAddress);
+
+    for(u32 i = 0; i <= Prefetcher::MISS_STATUS_ENTRY_COUNT; ++i)
+    {
+        sm.Prefetch(base + i * LINE_WORDS);
+    }
+
+    // Another word of a line being fetched, and a cached line.
+    sm.Prefetch(base + 5);
+    sm.Prefetch(cachedAddress);
+
+    if(prefetcher.Issued() != Prefetcher::MISS_STATUS_ENTRY_COUNT || prefetcher.Dropped() != 1 || prefetcher.Redundant() != 2 || prefetcher.InFlight() != Prefetcher::MISS_STATUS_ENTRY_COUNT)
+    {
+        ConPrinter::PrintLn("Prefetches counted {} issued, {} dropped and {} redundant with {} in flight, expected {}, 1, 2 and {}.", prefetcher.Issued(), prefetcher.Dropped(), prefetcher.Redundant(), prefetcher.InFlight(), Prefetcher::MISS_STATUS_ENTRY_COUNT, Prefetcher::MISS_STATUS_ENTRY_COUNT);
+        delete memory;
+        delete processor;
+        return;
+    }
+
+    ClockCycles(*processor, LoadStore::MISS_LATENCY_CYCLES);
+
+    u32 cachedLines = 0;
+
+    for(u32 i = 0; i < Prefetcher::MISS_STATUS_ENTRY_COUNT; ++i)
+    {
+        cachedLines += sm.IsCached(base + i * LINE_WORDS) ? 1 : 0;
+    }
+
+    if(cachedLines != Prefetcher::MISS_STATUS_ENTRY_COUNT || sm.IsCached(base + Prefetcher::MISS_STATUS_ENTRY_COUNT * LINE_WORDS))
+    {
+        ConPrinter::PrintLn("{} prefetched lines arrived and the dropped line was cached {}, expected {} and false.", cachedLines, sm.IsCached(base + Prefetcher::MISS_STATUS_ENTRY_COUNT * LINE_WORDS), Prefetcher::MISS_STATUS_ENTRY_COUNT);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully dropped a prefetch past {} in flight.", Prefetcher::MISS_STATUS_ENTRY_COUNT);
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// A load missing on a line which is still being prefetched only waits out the rest of the prefetch.
+static void TestLateMerge() noexcept
+{
+    constexpr u32 HEAD_START_CYCLES = 32;
+
+    u32 clocks[2];
+    u64 late[2];
+    u64 fills[2];
+    u32 values[2];
+
+    for(u32 run = 0; run < 2; ++run)
+    {
+        Processor* const processor = new(::std::nothrow) Processor;
+        processor->Reset();
+
+        PrefetchTestMemory* const memory = CreateMemory();
+        WriteLoadKernel(*memory, 0);
+
+        StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+        const u64 address = WordAddress(&memory->Data[0]);
+
+        if(run == 1)
+        {
+            sm.Prefetch(address);
+            ClockCycles(*processor, HEAD_START_CYCLES);
+        }
+
+        LaunchLoadWarp(*processor, *memory, 0, address);
+
+        clocks[run] = RunWarps(*processor);
+        late[run] = sm.Prefetches().Late();
+        fills[run] = processor->TestCacheController().L0PrefetchFills(0);
+        values[run] = sm.GetRegister(static_cast<u32>(sm.TestWarpScheduler(0).Warp(0).RegisterFileBase) + 4);
+
+        delete memory;
+        delete processor;
+    }
+
+    if(values[0] != values[1] || values[0] != (0xDA7A0000u | 0))
+    {
+        ConPrinter::PrintLn("The loads returned 0x{XP0} and 0x{XP0}, expected 0x{XP0}.", values[0], values[1], 0xDA7A0000u);
+    }
+    else if(late[0] != 0 || late[1] != 1 || fills[1] != 0)
+    {
+        ConPrinter::PrintLn("The merged load counted {} late prefetches and {} fills, expected 1 and 0.", late[1], fills[1]);
+    }
+    // The load's own dispatch is hidden behind the prefetch, but it can't return before the prefetch would have.
+    else if(clocks[1] + HEAD_START_CYCLES > clocks[0] || clocks[1] + HEAD_START_CYCLES < LoadStore::MISS_LATENCY_CYCLES)
+    {
+        ConPrinter::PrintLn("The merged load took {} clocks after a {} cycle head start, and the plain miss {}.", clocks[1], HEAD_START_CYCLES, clocks[0]);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully merged a load into a late prefetch, taking {} clocks rather than {}.", clocks[1], clocks[0]);
+    }
+}
+
+// An instruction prefetches once it's moved by the same stride enough times, each unit trains apart, and a new stride starts over.
+static void TestStrideTraining() noexcept
+{
+    constexpr u64 INSTRUCTION_POINTER = 0x1000;
+    constexpr u64 STRIDE = LINE_WORDS * 3;
+
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    PrefetchTestMemory* const memory = CreateMemory();
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+    const Prefetcher& prefetcher = sm.Prefetches();
+
+    const u64 base = WordAddress(&memory->Data[0]);
+
+    // The first sets the address, the second the stride, and it takes two more repeats to reach the threshold.
+    for(u32 i = 0; i <= Prefetcher::STRIDE_CONFIDENCE_THRESHOLD; ++i)
+    {
+        sm.TrainPrefetcher(0, INSTRUCTION_POINTER, base + i * STRIDE);
+        // The same instruction on another unit, interleaved, trains its own entry.
+        sm.TrainPrefetcher(1, INSTRUCTION_POINTER, base + 1 + i * STRIDE * 2);
+    }
+
+    const u64 beforeThreshold = prefetcher.StridePrefetches();
+
+    const u64 lastAddress = base + (Prefetcher::STRIDE_CONFIDENCE_THRESHOLD + 1) * STRIDE;
+    sm.TrainPrefetcher(0, INSTRUCTION_POINTER, lastAddress);
+
+    const u64 atThreshold = prefetcher.StridePrefetches();
+
+    // A different stride starts training over.
+    sm.TrainPrefetcher(0, INSTRUCTION_POINTER, lastAddress + LINE_WORDS);
+    sm.TrainPrefetcher(0, INSTRUCTION_POINTER, lastAddress + LINE_WORDS * 2);
+
+    const u64 afterRestart = prefetcher.StridePrefetches();
+
+    ClockCycles(*processor, LoadStore::MISS_LATENCY_CYCLES);
+
+    const bool aheadCached = sm.IsCached(lastAddress + STRIDE * Prefetcher::PREFETCH_DISTANCE);
+
+    if(beforeThreshold != 0 || atThreshold != 1 || afterRestart != 1)
+    {
+        ConPrinter::PrintLn("The stride prefetcher made {}, {} and {} prefetches, expected 0, 1 and 1.", beforeThreshold, atThreshold, afterRestart);
+    }
+    else if(!aheadCached || prefetcher.Issued() != 1)
+    {
+        ConPrinter::PrintLn("The stride prefetch issued {} and cached {} the line {} strides ahead.", prefetcher.Issued(), aheadCached, Prefetcher::PREFETCH_DISTANCE);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully trained the stride prefetcher on a stride of {} words.", STRIDE);
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// Warps running the same load from consecutive lines train the prefetcher, which then has the lines of later warps on their way before they load them.
+static void TestStrideKernel() noexcept
+{
+    constexpr u32 COPY_OFFSET = L0_SET_STRIDE * 3;
+
+    u32 clocks[2];
+    u64 covered = 0;
+    u64 stridePrefetches = 0;
+    bool valuesMatch = true;
+
+    for(u32 run = 0; run < 2; ++run)
+    {
+        Processor* const processor = new(::std::nothrow) Processor;
+        processor->Reset();
+
+        PrefetchTestMemory* const memory = CreateMemory();
+        WriteLoadKernel(*memory, COPY_OFFSET);
+
+        StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+        sm.SetStridePrefetchEnabled(run == 1);
+
+        for(u32 warp = 0; warp < KERNEL_WARP_COUNT; ++warp)
+        {
+            LaunchLoadWarp(*processor, *memory, warp, WordAddress(&memory->Data[warp * LINE_WORDS]));
+        }
+
+        clocks[run] = RunWarps(*processor);
+        // The copies may still be in the store buffer and the L0.
+        processor->FlushCache(0);
+
+        const CacheController& controller = processor->TestCacheController();
+
+        for(u32 warp = 0; warp < KERNEL_WARP_COUNT; ++warp)
+        {
+            valuesMatch = valuesMatch && memory->Data[COPY_OFFSET + warp * LINE_WORDS] == memory->Data[warp * LINE_WORDS];
+        }
+
+        if(run == 1)
+        {
+            covered = controller.L0UsefulPrefetches(0) + sm.Prefetches().Late();
+            stridePrefetches = sm.Prefetches().StridePrefetches();
+        }
+
+        delete memory;
+        delete processor;
+    }
+
+    if(!valuesMatch || clocks[0] >= CLOCK_LIMIT || clocks[1] >= CLOCK_LIMIT)
+    {
+        ConPrinter::PrintLn("The strided kernel returned the right values {}, taking {} and {} clocks.", valuesMatch, clocks[0], clocks[1]);
+    }
+    else if(stridePrefetches == 0 || covered == 0)
+    {
+        ConPrinter::PrintLn("The stride prefetcher made {} prefetches covering {} loads.", stridePrefetches, covered);
+    }
+    else if(clocks[1] > clocks[0])
+    {
+        ConPrinter::PrintLn("The strided kernel took {} clocks with prefetching, {} without.", clocks[1], clocks[0]);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully prefetched ahead of {} strided warps, {} prefetches covered {} loads, taking {} clocks rather than {}.", KERNEL_WARP_COUNT, stridePrefetches, covered, clocks[1], clocks[0]);
+    }
+}
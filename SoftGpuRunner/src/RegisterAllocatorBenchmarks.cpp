@@ -0,0 +1,112 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#include <ConPrinter.hpp>
+
+#include <RegisterAllocator.hpp>
+#include <BitmapRegisterAllocator.hpp>
+
+#include <chrono>
+#include <new>
+
+template<typename Allocator>
+static void BenchmarkSingleBlock(const char* allocatorName) noexcept;
+
+template<typename Allocator>
+static void BenchmarkWarpLaunch(const char* allocatorName) noexcept;
+
+namespace tau::benchmark::register_allocator {
+
+void RunBenchmarks() noexcept
+{
+    BenchmarkSingleBlock<RegisterAllocator>("buddy");
+    BenchmarkSingleBlock<BitmapRegisterAllocator>("bitmap");
+    BenchmarkWarpLaunch<RegisterAllocator>("buddy");
+    BenchmarkWarpLaunch<BitmapRegisterAllocator>("bitmap");
+}
+
+}
+
+static constexpr u32 ITERATION_COUNT = 1 << 20;
+
+static void PrintThroughput(const char* const name, const char* const allocatorName, const u64 operations, const u64 nanoseconds) noexcept
+{
+    ConPrinter::PrintLn("Register allocator {} ({}): {} allocations and frees, {} ps per operation.", name, allocatorName, operations, nanoseconds * 1000 / operations);
+}
+
+// The best case, a single warp repeatedly launching into an empty register file.
+template<typename Allocator>
+static void BenchmarkSingleBlock(const char* const allocatorName) noexcept
+{
+    Allocator* const allocator = new(::std::nothrow) Allocator;
+
+    u64 checksum = 0;
+
+    const auto start = ::std::chrono::high_resolution_clock::now();
+
+    for(u32 i = 0; i < ITERATION_COUNT; ++i)
+    {
+        const u16 base = allocator->AllocateRegisterBlock(63);
+        checksum += base;
+        allocator->FreeRegisterBlock(base, 63);
+    }
+
+    const auto end = ::std::chrono::high_resolution_clock::now();
+    const u64 nanoseconds = static_cast<u64>(::std::chrono::duration_cast<::std::chrono::nanoseconds>(end - start).count());
+
+    if(checksum != 0 || !allocator->CheckFree())
+    {
+        ConPrinter::PrintLn("Register allocator {} lost track of a single block.", allocatorName);
+    }
+
+    PrintThroughput("single block", allocatorName, ITERATION_COUNT * 2ull, nanoseconds);
+
+    delete allocator;
+}
+
+// Warps of mixed sizes launching and retiring out of order, with the register file close to full.
+template<typename Allocator>
+static void BenchmarkWarpLaunch(const char* const allocatorName) noexcept
+{
+    Allocator* const allocator = new(::std::nothrow) Allocator;
+
+    u64 operations = 0;
+
+    const auto start = ::std::chrono::high_resolution_clock::now();
+
+    for(u32 i = 0; i < ITERATION_COUNT; ++i)
+    {
+        const u16 block0 = allocator->AllocateRegisterBlock(22);
+        const u16 block1 = allocator->AllocateRegisterBlock(699);
+        const u16 block2 = allocator->AllocateRegisterBlock(259);
+
+        allocator->FreeRegisterBlock(block1, 699);
+
+        const u16 block3 = allocator->AllocateRegisterBlock(999);
+
+        allocator->FreeRegisterBlock(block0, 22);
+
+        const u16 block4 = allocator->AllocateRegisterBlock(29);
+
+        allocator->FreeRegisterBlock(block2, 259);
+        allocator->FreeRegisterBlock(block3, 999);
+        allocator->FreeRegisterBlock(block4, 29);
+
+        operations += 10;
+    }
+
+    const auto end = ::std::chrono::high_resolution_clock::now();
+    const u64 nanoseconds = static_cast<u64>(::std::chrono::duration_cast<::std::chrono::nanoseconds>(end - start).count());
+
+    if(!allocator->CheckFree())
+    {
+        ConPrinter::PrintLn("Register allocator {} failed to coalesce after warp launches.", allocatorName);
+    }
+
+    PrintThroughput("warp launch", allocatorName, operations, nanoseconds);
+
+    delete allocator;
+}
@@ -7,68 +7,95 @@
 #include <ConPrinter.hpp>
 
 #include <RegisterAllocator.hpp>
+#include <BitmapRegisterAllocator.hpp>
+#include <StreamingMultiprocessor.hpp>
 
-template<u16 RegisterCount>
-static void TestAllocSingle() noexcept;
+#include <new>
 
-static void TestStochasticInOrderAlloc() noexcept;
-static void TestStochasticMixedOrderAlloc() noexcept;
+template<typename Allocator>
+static void RunAllocatorTests(const char* allocatorName) noexcept;
+
+template<typename Allocator, u16 RegisterCount>
+static void TestAllocSingle(const char* allocatorName) noexcept;
+
+template<typename Allocator>
+static void TestStochasticInOrderAlloc(const char* allocatorName) noexcept;
+template<typename Allocator>
+static void TestStochasticMixedOrderAlloc(const char* allocatorName) noexcept;
+
+static void TestBitmapPlacement() noexcept;
+static void TestRandomizedDifferential() noexcept;
+static void TestCompactionRecoversAllocation() noexcept;
+static void TestRandomizedCompactionIntegrity() noexcept;
 
 namespace tau::test::register_allocator {
 
 void RunTests() noexcept
 {
-    TestAllocSingle<2048>();
-    TestAllocSingle<2047>();
-    TestAllocSingle<1537>();
-    TestAllocSingle<1536>();
-    TestAllocSingle<1535>();
-    TestAllocSingle<1025>();
-    TestAllocSingle<1024>();
-    TestAllocSingle<1023>();
-    TestAllocSingle<769>();
-    TestAllocSingle<768>();
-    TestAllocSingle<767>();
-    TestAllocSingle<513>();
-    TestAllocSingle<512>();
-    TestAllocSingle<511>();
-    TestAllocSingle<257>();
-    TestAllocSingle<256>();
-    TestAllocSingle<255>();
+    RunAllocatorTests<RegisterAllocator>("buddy");
+    RunAllocatorTests<BitmapRegisterAllocator>("bitmap");
+
+    TestBitmapPlacement();
+    TestRandomizedDifferential();
+    TestCompactionRecoversAllocation();
+    TestRandomizedCompactionIntegrity();
+}
 
-    TestStochasticInOrderAlloc();
-    TestStochasticMixedOrderAlloc();
 }
 
+template<typename Allocator>
+static void RunAllocatorTests(const char* const allocatorName) noexcept
+{
+    TestAllocSingle<Allocator, 2048>(allocatorName);
+    TestAllocSingle<Allocator, 2047>(allocatorName);
+    TestAllocSingle<Allocator, 1537>(allocatorName);
+    TestAllocSingle<Allocator, 1536>(allocatorName);
+    TestAllocSingle<Allocator, 1535>(allocatorName);
+    TestAllocSingle<Allocator, 1025>(allocatorName);
+    TestAllocSingle<Allocator, 1024>(allocatorName);
+    TestAllocSingle<Allocator, 1023>(allocatorName);
+    TestAllocSingle<Allocator, 769>(allocatorName);
+    TestAllocSingle<Allocator, 768>(allocatorName);
+    TestAllocSingle<Allocator, 767>(allocatorName);
+    TestAllocSingle<Allocator, 513>(allocatorName);
+    TestAllocSingle<Allocator, 512>(allocatorName);
+    TestAllocSingle<Allocator, 511>(allocatorName);
+    TestAllocSingle<Allocator, 257>(allocatorName);
+    TestAllocSingle<Allocator, 256>(allocatorName);
+    TestAllocSingle<Allocator, 255>(allocatorName);
+
+    TestStochasticInOrderAlloc<Allocator>(allocatorName);
+    TestStochasticMixedOrderAlloc<Allocator>(allocatorName);
 }
 
-template<u16 RegisterCount>
-static void TestAllocSingle() noexcept
+template<typename Allocator, u16 RegisterCount>
+static void TestAllocSingle(const char* const allocatorName) noexcept
 {
-    RegisterAllocator allocator;
+    Allocator allocator;
 
     const u16 baseRegister = allocator.AllocateRegisterBlock(RegisterCount - 1);
 
     if(baseRegister == 0xFFFF)
     {
-        ConPrinter::PrintLn("Failed to allocate {} block.", RegisterCount);
+        ConPrinter::PrintLn("Failed to allocate {} block with the {} allocator.", RegisterCount, allocatorName);
     }
 
     allocator.FreeRegisterBlock(baseRegister, RegisterCount - 1);
 
     if(!allocator.CheckFree())
     {
-        ConPrinter::PrintLn("Failed to free single {} block.", RegisterCount);
+        ConPrinter::PrintLn("Failed to free single {} block with the {} allocator.", RegisterCount, allocatorName);
     }
     else
     {
-        ConPrinter::PrintLn("Successfully allocated and freed single {} block.", RegisterCount);
+        ConPrinter::PrintLn("Successfully allocated and freed single {} block with the {} allocator.", RegisterCount, allocatorName);
     }
 }
 
-static void TestStochasticInOrderAlloc() noexcept
+template<typename Allocator>
+static void TestStochasticInOrderAlloc(const char* const allocatorName) noexcept
 {
-    RegisterAllocator allocator;
+    Allocator allocator;
 
     const u16 block0 = allocator.AllocateRegisterBlock(22);
     const u16 block1 = allocator.AllocateRegisterBlock(699);
@@ -78,47 +105,47 @@ static void TestStochasticInOrderAlloc() noexcept
 
     if(block0 == 0xFFFF)
     {
-        ConPrinter::PrintLn("Failed to allocate 23 registers for in-order block 0.");
+        ConPrinter::PrintLn("Failed to allocate 23 registers for in-order block 0 with the {} allocator.", allocatorName);
     }
 
     if(block1 == 0xFFFF)
     {
-        ConPrinter::PrintLn("Failed to allocate 700 registers for in-order block 1.");
+        ConPrinter::PrintLn("Failed to allocate 700 registers for in-order block 1 with the {} allocator.", allocatorName);
     }
 
     if(block2 == 0xFFFF)
     {
-        ConPrinter::PrintLn("Failed to allocate 260 registers for in-order block 2.");
+        ConPrinter::PrintLn("Failed to allocate 260 registers for in-order block 2 with the {} allocator.", allocatorName);
     }
 
     if(block3 == 0xFFFF)
     {
-        ConPrinter::PrintLn("Failed to allocate 1000 registers for in-order block 3.");
+        ConPrinter::PrintLn("Failed to allocate 1000 registers for in-order block 3 with the {} allocator.", allocatorName);
     }
 
     if(block4 == 0xFFFF)
     {
-        ConPrinter::PrintLn("Failed to allocate 30 registers for in-order block 4.");
+        ConPrinter::PrintLn("Failed to allocate 30 registers for in-order block 4 with the {} allocator.", allocatorName);
     }
 
     if(block0 == block1 || block0 == block2 || block0 == block3 || block0 == block4)
     {
-        ConPrinter::PrintLn("Overlapping block on block 0 detected.");
+        ConPrinter::PrintLn("Overlapping block on block 0 detected with the {} allocator.", allocatorName);
     }
 
     if(block1 == block2 || block1 == block3 || block1 == block4)
     {
-        ConPrinter::PrintLn("Overlapping block on block 1 detected.");
+        ConPrinter::PrintLn("Overlapping block on block 1 detected with the {} allocator.", allocatorName);
     }
 
     if(block2 == block3 || block2 == block4)
     {
-        ConPrinter::PrintLn("Overlapping block on block 2 detected.");
+        ConPrinter::PrintLn("Overlapping block on block 2 detected with the {} allocator.", allocatorName);
     }
 
     if(block3 == block4)
     {
-        ConPrinter::PrintLn("Overlapping block on block 3 detected.");
+        ConPrinter::PrintLn("Overlapping block on block 3 detected with the {} allocator.", allocatorName);
     }
 
     allocator.FreeRegisterBlock(block0, 22);
@@ -129,17 +156,18 @@ static void TestStochasticInOrderAlloc() noexcept
 
     if(!allocator.CheckFree())
     {
-        ConPrinter::PrintLn("Failed to free stochastic, in-order, blocks.");
+        ConPrinter::PrintLn("Failed to free stochastic, in-order, blocks with the {} allocator.", allocatorName);
     }
     else
     {
-        ConPrinter::PrintLn("Successfully allocated and freed stochastic, in-order, blocks.");
+        ConPrinter::PrintLn("Successfully allocated and freed stochastic, in-order, blocks with the {} allocator.", allocatorName);
     }
 }
 
-static void TestStochasticMixedOrderAlloc() noexcept
+template<typename Allocator>
+static void TestStochasticMixedOrderAlloc(const char* const allocatorName) noexcept
 {
-    RegisterAllocator allocator;
+    Allocator allocator;
 
     const u16 block0 = allocator.AllocateRegisterBlock(22);
     const u16 block1 = allocator.AllocateRegisterBlock(699);
@@ -147,17 +175,17 @@ static void TestStochasticMixedOrderAlloc() noexcept
 
     if(block0 == 0xFFFF)
     {
-        ConPrinter::PrintLn("Failed to allocate 23 registers for mixed-order block 0.");
+        ConPrinter::PrintLn("Failed to allocate 23 registers for mixed-order block 0 with the {} allocator.", allocatorName);
     }
 
     if(block1 == 0xFFFF)
     {
-        ConPrinter::PrintLn("Failed to allocate 700 registers for mixed-order block 1.");
+        ConPrinter::PrintLn("Failed to allocate 700 registers for mixed-order block 1 with the {} allocator.", allocatorName);
     }
 
     if(block2 == 0xFFFF)
     {
-        ConPrinter::PrintLn("Failed to allocate 260 registers for mixed-order block 2.");
+        ConPrinter::PrintLn("Failed to allocate 260 registers for mixed-order block 2 with the {} allocator.", allocatorName);
     }
 
     allocator.FreeRegisterBlock(block1, 699);
@@ -166,7 +194,7 @@ static void TestStochasticMixedOrderAlloc() noexcept
 
     if(block3 == 0xFFFF)
     {
-        ConPrinter::PrintLn("Failed to allocate 1000 registers for mixed-order block 3.");
+        ConPrinter::PrintLn("Failed to allocate 1000 registers for mixed-order block 3 with the {} allocator.", allocatorName);
     }
 
     allocator.FreeRegisterBlock(block0, 22);
@@ -175,7 +203,7 @@ static void TestStochasticMixedOrderAlloc() noexcept
 
     if(block4 == 0xFFFF)
     {
-        ConPrinter::PrintLn("Failed to allocate 30 registers for mixed-order block 4.");
+        ConPrinter::PrintLn("Failed to allocate 30 registers for mixed-order block 4 with the {} allocator.", allocatorName);
     }
 
     allocator.FreeRegisterBlock(block2, 259);
@@ -184,10 +212,452 @@ static void TestStochasticMixedOrderAlloc() noexcept
 
     if(!allocator.CheckFree())
     {
-        ConPrinter::PrintLn("Failed to free stochastic, mixed-order, blocks.");
+        ConPrinter::PrintLn("Failed to free stochastic, mixed-order, blocks with the {} allocator.", allocatorName);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully allocated and freed stochastic, mixed-order, blocks with the {} allocator.", allocatorName);
+    }
+}
+
+static void TestBitmapPlacement() noexcept
+{
+    BitmapRegisterAllocator allocator;
+
+    const u16 block0 = allocator.AllocateRegisterBlock(255);
+    const u16 block1 = allocator.AllocateRegisterBlock(1535);
+    // Only one chunk is left in the first column, a 768 block can't straddle into the second.
+    const u16 block2 = allocator.AllocateRegisterBlock(767);
+    const u16 block3 = allocator.AllocateRegisterBlock(2047);
+
+    allocator.FreeRegisterBlock(block0, 255);
+
+    // Chunk 0 is free again, but chunk 1 is not, so this goes after the 768 block.
+    const u16 block4 = allocator.AllocateRegisterBlock(511);
+
+    if(block0 != 0 || block1 != 256 || block2 != 2048 || block3 != 0xFFFF || block4 != 2816)
+    {
+        ConPrinter::PrintLn("Bitmap allocator placed blocks at {}, {}, {}, {}, and {}, expected 0, 256, 2048, 65535, and 2816.", block0, block1, block2, block3, block4);
+        return;
+    }
+
+    allocator.FreeRegisterBlock(block1, 1535);
+    allocator.FreeRegisterBlock(block2, 767);
+    allocator.FreeRegisterBlock(block4, 511);
+
+    if(!allocator.CheckFree() || allocator.FreeRegisterCount() != 4096)
+    {
+        ConPrinter::PrintLn("Bitmap allocator failed to coalesce freed blocks, {} registers free.", allocator.FreeRegisterCount());
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully placed blocks with the bitmap allocator.");
+    }
+}
+
+namespace {
+
+// Allocates by scanning every chunk, the bitmap allocator has to agree with it exactly.
+class ReferenceRegisterAllocator final
+{
+public:
+    ReferenceRegisterAllocator() noexcept
+        : m_Used{ }
+    { }
+
+    [[nodiscard]] u16 AllocateRegisterBlock(const u16 registerCount) noexcept
+    {
+        const u32 chunkCount = ChunkCount(registerCount);
+
+        for(u32 chunk = 0; chunk < 16; ++chunk)
+        {
+            if((chunk % 8) + chunkCount > 8)
+            {
+                continue;
+            }
+
+            bool free = true;
+
+            for(u32 i = 0; i < chunkCount; ++i)
+            {
+                free = free && !m_Used[chunk + i];
+            }
+
+            if(free)
+            {
+                Mark(chunk, chunkCount, true);
+                return static_cast<u16>(chunk * 256);
+            }
+        }
+
+        return 0xFFFF;
+    }
+
+    void FreeRegisterBlock(const u16 registerBase, const u16 registerCount) noexcept
+    {
+        Mark(registerBase / 256, ChunkCount(registerCount), false);
+    }
+
+    [[nodiscard]] static u32 ChunkCount(const u16 registerCount) noexcept
+    {
+        const u32 chunkCount = registerCount / 256 + 1;
+
+        return chunkCount == 5 || chunkCount == 7 ? chunkCount + 1 : chunkCount;
+    }
+private:
+    void Mark(const u32 chunk, const u32 chunkCount, const bool used) noexcept
+    {
+        for(u32 i = 0; i < chunkCount; ++i)
+        {
+            m_Used[chunk + i] = used;
+        }
+    }
+private:
+    bool m_Used[16];
+};
+
+struct LiveBlock final
+{
+    u16 Base;
+    u16 RegisterCount;
+};
+
+// Tracks which registers an allocator has handed out, to catch overlapping or out of range blocks.
+class BlockTracker final
+{
+public:
+    BlockTracker() noexcept
+        : m_Blocks{ }
+        , m_BlockCount(0)
+        , m_Owned{ }
+    { }
+
+    [[nodiscard]] bool Add(const u16 base, const u16 registerCount) noexcept
+    {
+        const u32 size = ReferenceRegisterAllocator::ChunkCount(registerCount) * 256;
+
+        if(base % 256 != 0 || (base % 2048) + size > 2048)
+        {
+            return false;
+        }
+
+        for(u32 i = base; i < base + size; ++i)
+        {
+            if(m_Owned[i])
+            {
+                return false;
+            }
+
+            m_Owned[i] = true;
+        }
+
+        m_Blocks[m_BlockCount++] = { base, registerCount };
+        return true;
+    }
+
+    LiveBlock Remove(const u32 index) noexcept
+    {
+        const LiveBlock block = m_Blocks[index];
+        m_Blocks[index] = m_Blocks[--m_BlockCount];
+
+        const u32 size = ReferenceRegisterAllocator::ChunkCount(block.RegisterCount) * 256;
+
+        for(u32 i = block.Base; i < block.Base + size; ++i)
+        {
+            m_Owned[i] = false;
+        }
+
+        return block;
+    }
+
+    [[nodiscard]] u32 BlockCount() const noexcept { return m_BlockCount; }
+private:
+    LiveBlock m_Blocks[16];
+    u32 m_BlockCount;
+    bool m_Owned[4096];
+};
+
+}
+
+static u32 NextRandom(u32& state) noexcept
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// Drives the bitmap allocator and a brute force reference with the same random stream of requests, the bitmap
+// allocator must pick exactly the block the reference does, never overlap, and coalesce back to fully free.
+static void TestRandomizedDifferential() noexcept
+{
+    static constexpr u32 OPERATION_COUNT = 200000;
+
+    BitmapRegisterAllocator bitmap;
+    ReferenceRegisterAllocator reference;
+    BlockTracker blocks;
+
+    u32 state = 0x2545F491;
+    u32 allocations = 0;
+    u32 failures = 0;
+
+    for(u32 operation = 0; operation < OPERATION_COUNT; ++operation)
+    {
+        const u32 random = NextRandom(state);
+
+        if((random & 0xFF) < 112 && blocks.BlockCount() != 0)
+        {
+            const LiveBlock block = blocks.Remove((random >> 8) % blocks.BlockCount());
+            bitmap.FreeRegisterBlock(block.Base, block.RegisterCount);
+            reference.FreeRegisterBlock(block.Base, block.RegisterCount);
+            continue;
+        }
+
+        // Favor small blocks the way real kernels do, but still hit every class.
+        const u16 registerCount = static_cast<u16>((random >> 8) % ((random & 0x100) ? 512 : 2048));
+
+        const u16 bitmapBase = bitmap.AllocateRegisterBlock(registerCount);
+        const u16 referenceBase = reference.AllocateRegisterBlock(registerCount);
+
+        if(bitmapBase != referenceBase)
+        {
+            ConPrinter::PrintLn("Bitmap allocator returned {} for {} registers at operation {}, the reference returned {}.", bitmapBase, registerCount + 1, operation, referenceBase);
+            return;
+        }
+
+        if(bitmapBase != 0xFFFF && !blocks.Add(bitmapBase, registerCount))
+        {
+            ConPrinter::PrintLn("Bitmap allocator returned an overlapping block at {} for {} registers.", bitmapBase, registerCount + 1);
+            return;
+        }
+
+        ++allocations;
+        failures += bitmapBase == 0xFFFF;
+    }
+
+    while(blocks.BlockCount() != 0)
+    {
+        const LiveBlock block = blocks.Remove(0);
+        bitmap.FreeRegisterBlock(block.Base, block.RegisterCount);
+    }
+
+    if(!bitmap.CheckFree())
+    {
+        ConPrinter::PrintLn("Randomized blocks did not coalesce back to a free register file, free chunks: 0x{XP0}.", bitmap.FreeChunks());
     }
     else
     {
-        ConPrinter::PrintLn("Successfully allocated and freed stochastic, mixed-order, blocks.");
+        ConPrinter::PrintLn("Successfully matched the reference allocator over {} randomized allocations, {} of which did not fit.", allocations, failures);
     }
 }
+
+// Gives a warp slot a register block the way the warp scheduler does when it fills a warp.
+static bool MakeWarpResident(StreamingMultiprocessor* const sm, WarpInfo& warp, const u16 registerCount) noexcept
+{
+    const u16 registerBase = sm->AllocateRegisters(registerCount);
+
+    if(registerBase == 0xFFFF)
+    {
+        return false;
+    }
+
+    warp.RegisterFileBase = registerBase;
+    warp.TotalRequiredRegisterCount = registerCount;
+    warp.RegisterFileResident = true;
+    return true;
+}
+
+static void SpillWarp(StreamingMultiprocessor* const sm, WarpInfo& warp) noexcept
+{
+    warp.RegisterFileResident = false;
+    sm->FreeRegisters(static_cast<u16>(warp.RegisterFileBase), static_cast<u16>(warp.TotalRequiredRegisterCount));
+}
+
+static u32 WarpRegisterPattern(const u32 slot, const u32 generation, const u32 registerIndex) noexcept
+{
+    return (slot << 24) ^ (generation * 0x9E3779B1u) ^ registerIndex;
+}
+
+static void WriteWarpPattern(StreamingMultiprocessor* const sm, const WarpInfo& warp, const u32 slot, const u32 generation) noexcept
+{
+    u32 values[2048];
+    const u32 registerCount = warp.TotalRequiredRegisterCount + 1;
+
+    for(u32 i = 0; i < registerCount; ++i)
+    {
+        values[i] = WarpRegisterPattern(slot, generation, i);
+    }
+
+    sm->TestWriteRegisters(warp.RegisterFileBase, registerCount, values);
+}
+
+[[nodiscard]] static bool CheckWarpPattern(const StreamingMultiprocessor* const sm, const WarpInfo& warp, const u32 slot, const u32 generation) noexcept
+{
+    u32 values[2048];
+    const u32 registerCount = warp.TotalRequiredRegisterCount + 1;
+
+    sm->TestReadRegisters(warp.RegisterFileBase, registerCount, values);
+
+    for(u32 i = 0; i < registerCount; ++i)
+    {
+        if(values[i] != WarpRegisterPattern(slot, generation, i))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void TestCompactionRecoversAllocation() noexcept
+{
+    StreamingMultiprocessor* const sm = new(::std::nothrow) StreamingMultiprocessor(nullptr, 0);
+    sm->Reset();
+    sm->SetRegisterCompactionThreshold(0);
+
+    // Fill the register file with 256 register warps, chunks 0-7 for dispatch port 0 and 8-15 for port 1.
+    for(u32 dispatchPort = 0; dispatchPort < 2; ++dispatchPort)
+    {
+        for(u32 warpIndex = 0; warpIndex < 8; ++warpIndex)
+        {
+            WarpInfo& warp = sm->TestWarpScheduler(dispatchPort).Warp(warpIndex);
+            (void) MakeWarpResident(sm, warp, 255);
+            WriteWarpPattern(sm, warp, dispatchPort * WARP_COUNT + warpIndex, 0);
+        }
+    }
+
+    // Warp 0 on port 1 is running, so the dispatch unit holds its thread base registers.
+    const u16 baseRegisters[8] = { 2048, 2048 + 64, 2048 + 128, 2048 + 192, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF };
+    sm->LoadWarp(1, 0xF, 0, baseRegisters, 0, FpMode { });
+
+    // Leave every other chunk free, 2048 registers are free but no more than 256 together.
+    for(u32 dispatchPort = 0; dispatchPort < 2; ++dispatchPort)
+    {
+        for(u32 warpIndex = 1; warpIndex < 8; warpIndex += 2)
+        {
+            SpillWarp(sm, sm->TestWarpScheduler(dispatchPort).Warp(warpIndex));
+        }
+    }
+
+    const u32 fragmentation = sm->RegisterFragmentation();
+
+    WarpInfo& largeWarp = sm->TestWarpScheduler(0).Warp(1);
+    const bool allocated = MakeWarpResident(sm, largeWarp, 1023);
+
+    bool intact = true;
+
+    for(u32 dispatchPort = 0; dispatchPort < 2; ++dispatchPort)
+    {
+        for(u32 warpIndex = 0; warpIndex < 8; warpIndex += 2)
+        {
+            intact = intact && CheckWarpPattern(sm, sm->TestWarpScheduler(dispatchPort).Warp(warpIndex), dispatchPort * WARP_COUNT + warpIndex, 0);
+        }
+    }
+
+    const WarpInfo& runningWarp = sm->TestWarpScheduler(1).Warp(0);
+    const DispatchUnit& dispatchUnit = sm->TestDispatchUnit(1);
+
+    if(fragmentation != 2048 - 256)
+    {
+        ConPrinter::PrintLn("Register fragmentation was {}, expected {}.", fragmentation, 2048 - 256);
+    }
+    else if(!allocated || sm->RegisterCompactions() != 1 || sm->RegisterCompactionRecoveredAllocations() != 1)
+    {
+        ConPrinter::PrintLn("Failed to allocate 1024 registers after compacting, {} compactions.", sm->RegisterCompactions());
+    }
+    else if(!intact)
+    {
+        ConPrinter::PrintLn("Compaction corrupted the registers of a resident warp.");
+    }
+    else if(dispatchUnit.BaseRegister(0) != runningWarp.RegisterFileBase || dispatchUnit.BaseRegister(1) != runningWarp.RegisterFileBase + 64 || dispatchUnit.BaseRegister(4) != 0xFFFF)
+    {
+        ConPrinter::PrintLn("Dispatch unit base register {} was not moved with its warp to {}.", dispatchUnit.BaseRegister(0), runningWarp.RegisterFileBase);
+    }
+    // Only port 0's warp 0 is already in place, the other 7 each move a 256 register block.
+    else if(sm->RegisterCompactionMovedRegisters() != 7 * 256 || sm->RegisterCompactionCycles() != 7 * 2 * 16 || sm->RegisterCompactionRecoveredRegisters() != 2048 - 256)
+    {
+        ConPrinter::PrintLn("Compaction moved {} registers in {} cycles, recovering {}, expected 1792, 224, and 1792.", sm->RegisterCompactionMovedRegisters(), sm->RegisterCompactionCycles(), sm->RegisterCompactionRecoveredRegisters());
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully compacted the register file to fit a large warp.");
+    }
+
+    delete sm;
+}
+
+// Warps of random sizes come and go in random slots, every warp's registers are checked when it's spilled and
+// periodically while resident, across compactions triggered both by failed allocations and by the threshold.
+static void TestRandomizedCompactionIntegrity() noexcept
+{
+    static constexpr u32 OPERATION_COUNT = 50000;
+    static constexpr u32 SLOT_COUNT = 2 * WARP_COUNT;
+
+    StreamingMultiprocessor* const sm = new(::std::nothrow) StreamingMultiprocessor(nullptr, 0);
+    sm->Reset();
+
+    u32 generations[SLOT_COUNT] { };
+    u32 state = 0x6B43A9B5;
+    u32 failedAllocations = 0;
+
+    const auto slotWarp = [sm](const u32 slot) -> WarpInfo& { return sm->TestWarpScheduler(slot / WARP_COUNT).Warp(slot % WARP_COUNT); };
+
+    for(u32 operation = 0; operation < OPERATION_COUNT; ++operation)
+    {
+        const u32 random = NextRandom(state);
+        const u32 slot = random % SLOT_COUNT;
+        WarpInfo& warp = slotWarp(slot);
+
+        if(warp.RegisterFileResident)
+        {
+            if(!CheckWarpPattern(sm, warp, slot, generations[slot]))
+            {
+                ConPrinter::PrintLn("Warp {} lost its registers before operation {}.", slot, operation);
+                delete sm;
+                return;
+            }
+
+            SpillWarp(sm, warp);
+        }
+        else
+        {
+            // Mostly small warps with the occasional large one, the large ones are what fragmentation hurts.
+            const u16 registerCount = static_cast<u16>((random >> 8) % ((random & 0x80) ? 1536 : 512));
+
+            if(MakeWarpResident(sm, warp, registerCount))
+            {
+                WriteWarpPattern(sm, warp, slot, ++generations[slot]);
+            }
+            else
+            {
+                ++failedAllocations;
+            }
+        }
+
+        if(operation % 1024 == 0)
+        {
+            for(u32 checkSlot = 0; checkSlot < SLOT_COUNT; ++checkSlot)
+            {
+                if(slotWarp(checkSlot).RegisterFileResident && !CheckWarpPattern(sm, slotWarp(checkSlot), checkSlot, generations[checkSlot]))
+                {
+                    ConPrinter::PrintLn("Warp {} lost its registers by operation {}.", checkSlot, operation);
+                    delete sm;
+                    return;
+                }
+            }
+        }
+    }
+
+    if(sm->RegisterCompactions() == 0 || sm->RegisterCompactionRecoveredAllocations() == 0)
+    {
+        ConPrinter::PrintLn("Randomized warps compacted {} times and recovered {} allocations, expected both to happen.", sm->RegisterCompactions(), sm->RegisterCompactionRecoveredAllocations());
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully kept warp registers intact over {} compactions, moving {} registers in {} cycles, recovering {} of {} failed allocations.",
+                            sm->RegisterCompactions(), sm->RegisterCompactionMovedRegisters(), sm->RegisterCompactionCycles(),
+                            sm->RegisterCompactionRecoveredAllocations(), sm->RegisterCompactionRecoveredAllocations() + failedAllocations);
+    }
+
+    delete sm;
+}
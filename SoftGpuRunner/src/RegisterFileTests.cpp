@@ -0,0 +1,715 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#include <ConPrinter.hpp>
+
+#include <RegisterFile.hpp>
+
+#include <cstring>
+#include <new>
+
+static void TestPortReadWrite() noexcept;
+static void TestPortBankMapping() noexcept;
+static void TestWriteLock() noexcept;
+static void TestReadLock() noexcept;
+static void TestSharedContestation() noexcept;
+static void TestBulkAccess() noexcept;
+static void TestBankConflict() noexcept;
+static void TestBankConflictDisabled() noexcept;
+static void TestExecutedCommandConsumed() noexcept;
+static void TestSnapshotRoundTrip() noexcept;
+static void TestSnapshotFallback() noexcept;
+
+namespace tau::test::register_file {
+
+void RunTests() noexcept
+{
+    TestPortReadWrite();
+    TestPortBankMapping();
+    TestWriteLock();
+    TestReadLock();
+    TestSharedContestation();
+    TestBulkAccess();
+    TestBankConflict();
+    TestBankConflictDisabled();
+    TestExecutedCommandConsumed();
+    TestSnapshotRoundTrip();
+    TestSnapshotFallback();
+}
+
+}
+
+struct PortResult final
+{
+    u32 Value;
+    bool Successful;
+    bool Unsuccessful;
+};
+
+static void InvokePort(RegisterFile& registerFile, const u32 port, const bool high, const RegisterFile::CommandPacket packet) noexcept
+{
+    if(high)
+    {
+        switch(port)
+        {
+            case 0: registerFile.InvokePort0High(packet); break;
+            case 1: registerFile.InvokePort1High(packet); break;
+            case 2: registerFile.InvokePort2High(packet); break;
+            case 3: registerFile.InvokePort3High(packet); break;
+            default: break;
+        }
+    }
+    else
+    {
+        switch(port)
+        {
+            case 0: registerFile.InvokePort0Low(packet); break;
+            case 1: registerFile.InvokePort1Low(packet); break;
+            case 2: registerFile.InvokePort2Low(packet); break;
+            case 3: registerFile.InvokePort3Low(packet); break;
+            default: break;
+        }
+    }
+}
+
+// Runs a single command on a port for one cycle, then parks the port so the command doesn't repeat.
+static PortResult RunCommand(RegisterFile& registerFile, const u32 port, const u32 registerIndex, const RegisterFile::ECommand command, const u32 value = 0) noexcept
+{
+    PortResult result { value, false, false };
+
+    RegisterFile::CommandPacket packet;
+    packet.Command = command;
+    packet.TargetRegister = registerIndex >> 1;
+    packet.Pad = 0;
+    packet.Value = &result.Value;
+    packet.Successful = &result.Successful;
+    packet.Unsuccessful = &result.Unsuccessful;
+
+    const bool high = (registerIndex & 0x1) != 0;
+
+    InvokePort(registerFile, port, high, packet);
+    registerFile.Clock();
+
+    packet.Command = RegisterFile::ECommand::None;
+    InvokePort(registerFile, port, high, packet);
+    registerFile.Clock();
+    registerFile.EndCycle();
+
+    return result;
+}
+
+static RegisterFile* CreateRegisterFile() noexcept
+{
+    RegisterFile* const registerFile = new(::std::nothrow) RegisterFile;
+    registerFile->Reset();
+
+    RegisterFile::CommandPacket idle { };
+    idle.Command = RegisterFile::ECommand::None;
+
+    for(u32 port = 0; port < 4; ++port)
+    {
+        InvokePort(*registerFile, port, true, idle);
+        InvokePort(*registerFile, port, false, idle);
+    }
+
+    return registerFile;
+}
+
+static void TestPortReadWrite() noexcept
+{
+    RegisterFile* const registerFile = CreateRegisterFile();
+
+    u32 failures = 0;
+
+    // Every port half writes its own registers, then each is read back through a different port.
+    for(u32 port = 0; port < 4; ++port)
+    {
+        for(u32 registerIndex = port; registerIndex < RegisterFile::REGISTER_FILE_REGISTER_COUNT; registerIndex += 61)
+        {
+            const u32 value = 0xA5000000 | (port << 16) | registerIndex;
+
+            const PortResult write = RunCommand(*registerFile, port, registerIndex, RegisterFile::ECommand::WriteRegister, value);
+            const PortResult read = RunCommand(*registerFile, (port + 1) & 0x3, registerIndex, RegisterFile::ECommand::ReadRegister);
+
+            if(!write.Successful || write.Unsuccessful || !read.Successful || read.Unsuccessful || read.Value != value)
+            {
+                ConPrinter::PrintLn("Port {} register {} read back 0x{XP0}, expected 0x{XP0}.", port, registerIndex, read.Value, value);
+                ++failures;
+            }
+        }
+    }
+
+    if(failures == 0)
+    {
+        ConPrinter::PrintLn("Successfully read and wrote registers through every port.");
+    }
+
+    delete registerFile;
+}
+
+static void TestPortBankMapping() noexcept
+{
+    RegisterFile* const registerFile = CreateRegisterFile();
+
+    u32 failures = 0;
+
+    for(u32 registerIndex = 0; registerIndex < RegisterFile::REGISTER_FILE_REGISTER_COUNT; ++registerIndex)
+    {
+        (void) RunCommand(*registerFile, registerIndex & 0x3, registerIndex, RegisterFile::ECommand::WriteRegister, registerIndex * 3 + 1);
+    }
+
+    for(u32 registerIndex = 0; registerIndex < RegisterFile::REGISTER_FILE_REGISTER_COUNT; ++registerIndex)
+    {
+        // The port halves must only reach their own banks, odd registers are in the high banks.
+        if((RegisterFile::BankOfRegister(registerIndex) & 0x1) != (registerIndex & 0x1) || RegisterFile::RowOfRegister(registerIndex) >= RegisterFile::REGISTER_FILE_BANK_REGISTER_COUNT)
+        {
+            ++failures;
+        }
+
+        if(registerFile->GetRegister(registerIndex) != registerIndex * 3 + 1)
+        {
+            ConPrinter::PrintLn("Register {} was stored as 0x{XP0}.", registerIndex, registerFile->GetRegister(registerIndex));
+            ++failures;
+        }
+    }
+
+    if(failures == 0)
+    {
+        ConPrinter::PrintLn("Successfully mapped every register to its bank.");
+    }
+
+    delete registerFile;
+}
+
+static void TestWriteLock() noexcept
+{
+    RegisterFile* const registerFile = CreateRegisterFile();
+
+    constexpr u32 registerIndex = 1237;
+
+    const PortResult checkFree = RunCommand(*registerFile, 0, registerIndex, RegisterFile::ECommand::CheckWrite);
+    const PortResult lock = RunCommand(*registerFile, 0, registerIndex, RegisterFile::ECommand::LockWrite);
+    const PortResult checkRead = RunCommand(*registerFile, 1, registerIndex, RegisterFile::ECommand::CheckRead);
+    const PortResult checkWrite = RunCommand(*registerFile, 2, registerIndex, RegisterFile::ECommand::CheckWrite);
+    const PortResult relock = RunCommand(*registerFile, 3, registerIndex, RegisterFile::ECommand::LockWrite);
+    const PortResult neighbour = RunCommand(*registerFile, 1, registerIndex - 1, RegisterFile::ECommand::CheckWrite);
+    const PortResult unlock = RunCommand(*registerFile, 0, registerIndex, RegisterFile::ECommand::Unlock);
+    const PortResult checkUnlocked = RunCommand(*registerFile, 0, registerIndex, RegisterFile::ECommand::CheckWrite);
+
+    u8 contestation = 0xCC;
+    registerFile->ReadContestation(registerIndex, 1, &contestation);
+
+    if(!checkFree.Successful || !lock.Successful || !checkRead.Unsuccessful || !checkWrite.Unsuccessful || !relock.Unsuccessful)
+    {
+        ConPrinter::PrintLn("Write lock on register {} was not exclusive.", registerIndex);
+    }
+    else if(!neighbour.Successful)
+    {
+        ConPrinter::PrintLn("Write lock on register {} leaked to register {}.", registerIndex, registerIndex - 1);
+    }
+    else if(!unlock.Successful || !checkUnlocked.Successful || contestation != 0)
+    {
+        ConPrinter::PrintLn("Write lock on register {} was not released, contestation is {}.", registerIndex, contestation);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully locked and unlocked a register for writes.");
+    }
+
+    delete registerFile;
+}
+
+static void TestReadLock() noexcept
+{
+    RegisterFile* const registerFile = CreateRegisterFile();
+
+    constexpr u32 registerIndex = 42;
+
+    const PortResult lock0 = RunCommand(*registerFile, 0, registerIndex, RegisterFile::ECommand::LockRead);
+    const PortResult lock1 = RunCommand(*registerFile, 1, registerIndex, RegisterFile::ECommand::LockRead);
+
+    u8 lockedContestation = 0;
+    registerFile->ReadContestation(registerIndex, 1, &lockedContestation);
+
+    const PortResult checkRead = RunCommand(*registerFile, 2, registerIndex, RegisterFile::ECommand::CheckRead);
+    const PortResult checkWrite = RunCommand(*registerFile, 2, registerIndex, RegisterFile::ECommand::CheckWrite);
+    const PortResult writeLock = RunCommand(*registerFile, 3, registerIndex, RegisterFile::ECommand::LockWrite);
+
+    const PortResult unlock0 = RunCommand(*registerFile, 0, registerIndex, RegisterFile::ECommand::Unlock);
+    const PortResult checkWriteHeld = RunCommand(*registerFile, 0, registerIndex, RegisterFile::ECommand::CheckWrite);
+    const PortResult unlock1 = RunCommand(*registerFile, 1, registerIndex, RegisterFile::ECommand::Unlock);
+    const PortResult checkWriteFree = RunCommand(*registerFile, 1, registerIndex, RegisterFile::ECommand::CheckWrite);
+
+    if(!lock0.Successful || !lock1.Successful || lockedContestation != 3)
+    {
+        ConPrinter::PrintLn("Two read locks produced contestation {}, expected 3.", lockedContestation);
+    }
+    else if(!checkRead.Successful || !checkWrite.Unsuccessful || !writeLock.Unsuccessful)
+    {
+        ConPrinter::PrintLn("Read locked register {} did not block writes.", registerIndex);
+    }
+    else if(!unlock0.Successful || !checkWriteHeld.Unsuccessful || !unlock1.Successful || !checkWriteFree.Successful)
+    {
+        ConPrinter::PrintLn("Read locks on register {} were not released one at a time.", registerIndex);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully shared read locks on a register.");
+    }
+
+    delete registerFile;
+}
+
+static void TestSharedContestation() noexcept
+{
+    RegisterFile* const registerFile = CreateRegisterFile();
+
+    constexpr u32 registerIndex = 77;
+
+    // A dispatch unit write locks the register directly, the ports have to see that lock.
+    registerFile->LockRegisterWrite(registerIndex);
+
+    const PortResult checkRead = RunCommand(*registerFile, 0, registerIndex, RegisterFile::ECommand::CheckRead);
+    const PortResult readLock = RunCommand(*registerFile, 1, registerIndex, RegisterFile::ECommand::LockRead);
+
+    u8 writeContestation = 0;
+    registerFile->ReadContestation(registerIndex, 1, &writeContestation);
+
+    const PortResult unlock = RunCommand(*registerFile, 2, registerIndex, RegisterFile::ECommand::Unlock);
+    const bool writeReleased = registerFile->CanWriteRegister(registerIndex);
+
+    // A port read lock blocks a dispatch unit's write, and the dispatch side release clears it.
+    const PortResult portReadLock = RunCommand(*registerFile, 3, registerIndex, RegisterFile::ECommand::LockRead);
+    const bool writeBlocked = !registerFile->CanWriteRegister(registerIndex);
+    registerFile->ReleaseRegisterContestation(registerIndex);
+
+    // Releasing an uncontested register through a port leaves it uncontested, the same as the direct release.
+    const PortResult extraUnlock = RunCommand(*registerFile, 0, registerIndex, RegisterFile::ECommand::Unlock);
+
+    u8 contestation = 0xCC;
+    registerFile->ReadContestation(registerIndex, 1, &contestation);
+
+    if(!checkRead.Unsuccessful || !readLock.Unsuccessful || writeContestation != 1)
+    {
+        ConPrinter::PrintLn("The ports ignored a direct write lock, contestation is {}.", writeContestation);
+    }
+    else if(!unlock.Successful || !writeReleased)
+    {
+        ConPrinter::PrintLn("A port unlock didn't release a direct write lock.");
+    }
+    else if(!portReadLock.Successful || !writeBlocked)
+    {
+        ConPrinter::PrintLn("A port read lock didn't block a direct write.");
+    }
+    else if(!extraUnlock.Successful || contestation != 0)
+    {
+        ConPrinter::PrintLn("Releasing register {} left contestation {}, expected 0.", registerIndex, contestation);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully shared register contestation between the ports and the dispatch units.");
+    }
+
+    delete registerFile;
+}
+
+static void TestBulkAccess() noexcept
+{
+    RegisterFile* const registerFile = CreateRegisterFile();
+
+    static constexpr u32 RANGE_BASE = 509;
+    static constexpr u32 RANGE_COUNT = 700;
+
+    u32 values[RANGE_COUNT];
+
+    for(u32 i = 0; i < RANGE_COUNT; ++i)
+    {
+        values[i] = 0x5EED0000 ^ (i * 2654435761u);
+    }
+
+    registerFile->WriteRegisters(RANGE_BASE, RANGE_COUNT, values);
+
+    u32 failures = 0;
+
+    // The range crosses every bank, each register has to be visible through its port.
+    for(u32 i = 0; i < RANGE_COUNT; i += 7)
+    {
+        const PortResult read = RunCommand(*registerFile, i & 0x3, RANGE_BASE + i, RegisterFile::ECommand::ReadRegister);
+
+        if(read.Value != values[i])
+        {
+            ConPrinter::PrintLn("Bulk written register {} read 0x{XP0} through its port, expected 0x{XP0}.", RANGE_BASE + i, read.Value, values[i]);
+            ++failures;
+        }
+    }
+
+    (void) RunCommand(*registerFile, 2, RANGE_BASE + 100, RegisterFile::ECommand::WriteRegister, 0xDEADBEEF);
+    values[100] = 0xDEADBEEF;
+
+    u32 readBack[RANGE_COUNT + 2];
+    registerFile->ReadRegisters(RANGE_BASE - 1, RANGE_COUNT + 2, readBack);
+
+    if(readBack[0] != 0 || readBack[RANGE_COUNT + 1] != 0)
+    {
+        ConPrinter::PrintLn("Bulk write spilled outside of its range.");
+        ++failures;
+    }
+
+    for(u32 i = 0; i < RANGE_COUNT; ++i)
+    {
+        if(readBack[i + 1] != values[i])
+        {
+            ++failures;
+        }
+    }
+
+    if(failures == 0)
+    {
+        ConPrinter::PrintLn("Successfully accessed a register range in bulk.");
+    }
+    else
+    {
+        ConPrinter::PrintLn("Bulk register access had {} failures.", failures);
+    }
+
+    delete registerFile;
+}
+
+static RegisterFile::CommandPacket MakeWritePacket(PortResult& result, const u32 registerIndex) noexcept
+{
+    RegisterFile::CommandPacket packet;
+    packet.Command = RegisterFile::ECommand::WriteRegister;
+    packet.TargetRegister = registerIndex >> 1;
+    packet.Pad = 0;
+    packet.Value = &result.Value;
+    packet.Successful = &result.Successful;
+    packet.Unsuccessful = &result.Unsuccessful;
+    return packet;
+}
+
+static void TestBankConflict() noexcept
+{
+    RegisterFile* const registerFile = CreateRegisterFile();
+
+    RegisterFile::CommandPacket idle { };
+    idle.Command = RegisterFile::ECommand::None;
+
+    // Registers 1, 17, 33 and 49 are all in bank 1, register 2 is in bank 2.
+    PortResult first { 0x11, false, false };
+    PortResult second { 0x22, false, false };
+    PortResult other { 0x33, false, false };
+    PortResult third { 0x44, false, false };
+    PortResult later { 0x55, false, false };
+
+    registerFile->InvokePort0High(MakeWritePacket(first, 1));
+    registerFile->InvokePort1High(MakeWritePacket(second, 17));
+    registerFile->InvokePort2Low(MakeWritePacket(other, 2));
+    registerFile->Clock();
+
+    const bool firstClockCorrect = first.Successful && other.Successful && !second.Successful && !second.Unsuccessful;
+    const bool firstClockStalls = !registerFile->IsPortStalled(0) && registerFile->IsPortStalled(1) && !registerFile->IsPortStalled(2);
+
+    // Bank 1 stays taken for the rest of the cycle, however many times the register file is clocked.
+    registerFile->InvokePort0High(idle);
+    registerFile->InvokePort2Low(idle);
+    registerFile->InvokePort3High(MakeWritePacket(later, 49));
+    registerFile->Clock();
+
+    const bool sameCycleHeld = !second.Successful && !later.Successful && registerFile->IsPortStalled(1) && registerFile->IsPortStalled(3);
+
+    registerFile->Clock();
+
+    const bool reclockHeld = !second.Successful && !later.Successful;
+
+    // The held commands go first when the cycle ends, port 1 before port 3, and port 0 moves on to another bank 1
+    // register behind them.
+    registerFile->EndCycle();
+
+    const bool retriedFirst = second.Successful && !later.Successful && !registerFile->IsPortStalled(1) && registerFile->IsPortStalled(3);
+
+    registerFile->InvokePort0High(MakeWritePacket(third, 33));
+    registerFile->InvokePort1High(idle);
+    registerFile->Clock();
+
+    const bool newCommandHeld = !third.Successful && registerFile->IsPortStalled(0);
+
+    // Both held commands want bank 1, the lower port goes first.
+    registerFile->EndCycle();
+
+    const bool lowerPortFirst = third.Successful && !later.Successful && registerFile->IsPortStalled(3);
+
+    registerFile->EndCycle();
+
+    const bool secondCycleCorrect = lowerPortFirst && later.Successful && !registerFile->IsPortStalled(0) && !registerFile->IsPortStalled(3);
+
+    if(!firstClockCorrect || !firstClockStalls)
+    {
+        ConPrinter::PrintLn("Conflicting commands on bank 1 were not serialized.");
+    }
+    else if(!sameCycleHeld || !reclockHeld)
+    {
+        ConPrinter::PrintLn("Bank 1 was granted twice in one cycle.");
+    }
+    else if(!retriedFirst || !newCommandHeld || !secondCycleCorrect)
+    {
+        ConPrinter::PrintLn("Commands held by a bank conflict did not take priority in the next cycle.");
+    }
+    else if(registerFile->GetRegister(1) != 0x11 || registerFile->GetRegister(17) != 0x22 || registerFile->GetRegister(33) != 0x44 || registerFile->GetRegister(49) != 0x55 || registerFile->GetRegister(2) != 0x33)
+    {
+        ConPrinter::PrintLn("Serialized writes stored the wrong values.");
+    }
+    else if(registerFile->BankConflicts(1) != 5 || registerFile->TotalBankConflicts() != 5)
+    {
+        ConPrinter::PrintLn("Counted {} conflicts on bank 1 and {} in total, expected 5.", registerFile->BankConflicts(1), registerFile->TotalBankConflicts());
+    }
+    else
+    {
+        registerFile->ResetStatistics();
+
+        if(registerFile->TotalBankConflicts() != 0)
+        {
+            ConPrinter::PrintLn("Resetting the register file statistics left {} bank conflicts.", registerFile->TotalBankConflicts());
+        }
+        else
+        {
+            ConPrinter::PrintLn("Successfully serialized register bank conflicts.");
+        }
+    }
+
+    delete registerFile;
+}
+
+static void TestBankConflictDisabled() noexcept
+{
+    RegisterFile* const registerFile = CreateRegisterFile();
+    registerFile->SetBankConflictModelling(false);
+
+    PortResult first { 0x11, false, false };
+    PortResult second { 0x22, false, false };
+
+    registerFile->InvokePort0High(MakeWritePacket(first, 1));
+    registerFile->InvokePort1High(MakeWritePacket(second, 17));
+    registerFile->Clock();
+
+    if(!first.Successful || !second.Successful || registerFile->IsPortStalled(1) || registerFile->TotalBankConflicts() != 0)
+    {
+        ConPrinter::PrintLn("Register bank conflicts were modelled while disabled.");
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully disabled register bank conflict modelling.");
+    }
+
+    delete registerFile;
+}
+
+// A command which has executed leaves its port, it mustn't hold its bank against later commands.
+static void TestExecutedCommandConsumed() noexcept
+{
+    RegisterFile* const registerFile = CreateRegisterFile();
+
+    RegisterFile::CommandPacket reset { };
+    reset.Command = RegisterFile::ECommand::Reset;
+
+    // Registers 1 and 17 are both in bank 1.
+    PortResult first { 0x11, false, false };
+    PortResult second { 0x22, false, false };
+
+    registerFile->InvokePort0High(MakeWritePacket(first, 1));
+    registerFile->InvokePort2Low(reset);
+    registerFile->Clock();
+    registerFile->EndCycle();
+
+    // Port 0 isn't given a new command, the write it already executed mustn't run again and take bank 1.
+    first.Value = 0x55;
+    registerFile->InvokePort1High(MakeWritePacket(second, 17));
+    registerFile->Clock();
+
+    if(!second.Successful || registerFile->IsPortStalled(1) || registerFile->TotalBankConflicts() != 0)
+    {
+        ConPrinter::PrintLn("An executed command conflicted with a later one, {} conflicts.", registerFile->TotalBankConflicts());
+    }
+    else if(registerFile->GetRegister(1) != 0x11 || registerFile->GetRegister(17) != 0x22)
+    {
+        ConPrinter::PrintLn("An executed write ran again, register 1 holds {:#x}.", registerFile->GetRegister(1));
+    }
+    else if(registerFile->IsPortStalled(2))
+    {
+        ConPrinter::PrintLn("A reset command was left stalled in its port.");
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully consumed executed register file commands.");
+    }
+
+    delete registerFile;
+}
+
+// The debugger's copy of a register file, rebuilt only from snapshot messages.
+struct SnapshotReceiver final
+{
+    u32 SmIndex;
+    u32 Registers[RegisterFile::REGISTER_FILE_REGISTER_COUNT];
+    u8 Contestation[RegisterFile::REGISTER_FILE_REGISTER_COUNT];
+};
+
+struct SnapshotMessage final
+{
+    u32 Size;
+    u32 Flags;
+    u32 RunCount;
+    bool Decoded;
+};
+
+static SnapshotMessage SendSnapshot(RegisterFile& registerFile, const u32 smIndex, SnapshotReceiver& receiver) noexcept
+{
+    SnapshotMessage message { };
+
+    RegisterFileSnapshot& snapshot = registerFile.Snapshot();
+
+    u32 registers[RegisterFile::REGISTER_FILE_REGISTER_COUNT];
+    u8 contestation[RegisterFile::REGISTER_FILE_REGISTER_COUNT];
+    registerFile.ReadRegisters(0, RegisterFile::REGISTER_FILE_REGISTER_COUNT, registers);
+    registerFile.ReadContestation(0, RegisterFile::REGISTER_FILE_REGISTER_COUNT, contestation);
+
+    message.Size = snapshot.Encode(smIndex, registers, contestation);
+
+    if(message.Size == 0)
+    {
+        return message;
+    }
+
+    const u8* const data = snapshot.Data();
+
+    u32 dataCode;
+    u32 payloadSize;
+    (void) ::std::memcpy(&dataCode, data, sizeof(dataCode));
+    (void) ::std::memcpy(&payloadSize, data + sizeof(u32), sizeof(payloadSize));
+
+    RegisterFileSnapshot::Header header;
+    (void) ::std::memcpy(&header, data + RegisterFileSnapshot::MESSAGE_HEADER_SIZE, sizeof(header));
+
+    message.Flags = header.Flags;
+    message.RunCount = header.RunCount;
+    message.Decoded = dataCode == DebugCodeReportRegisterSnapshot &&
+        payloadSize + RegisterFileSnapshot::MESSAGE_HEADER_SIZE == message.Size &&
+        RegisterFileSnapshot::Decode(data + RegisterFileSnapshot::MESSAGE_HEADER_SIZE, payloadSize, &receiver.SmIndex, receiver.Registers, receiver.Contestation);
+
+    return message;
+}
+
+static bool ReceiverMatches(RegisterFile& registerFile, const SnapshotReceiver& receiver) noexcept
+{
+    u32 registers[RegisterFile::REGISTER_FILE_REGISTER_COUNT];
+    u8 contestation[RegisterFile::REGISTER_FILE_REGISTER_COUNT];
+    registerFile.ReadRegisters(0, RegisterFile::REGISTER_FILE_REGISTER_COUNT, registers);
+    registerFile.ReadContestation(0, RegisterFile::REGISTER_FILE_REGISTER_COUNT, contestation);
+
+    return ::std::memcmp(registers, receiver.Registers, sizeof(registers)) == 0 && ::std::memcmp(contestation, receiver.Contestation, sizeof(contestation)) == 0;
+}
+
+static void TestSnapshotRoundTrip() noexcept
+{
+    RegisterFile* const registerFile = CreateRegisterFile();
+    SnapshotReceiver* const receiver = new(::std::nothrow) SnapshotReceiver { };
+
+    for(u32 i = 0; i < RegisterFile::REGISTER_FILE_REGISTER_COUNT; ++i)
+    {
+        registerFile->SetRegister(i, i * 2654435761u);
+    }
+
+    (void) RunCommand(*registerFile, 0, 77, RegisterFile::ECommand::LockWrite);
+
+    const SnapshotMessage full = SendSnapshot(*registerFile, 3, *receiver);
+
+    // Touch two separate ranges, one through a port, one with a lock, and one in bulk.
+    (void) RunCommand(*registerFile, 1, 1000, RegisterFile::ECommand::WriteRegister, 0x12345678);
+    (void) RunCommand(*registerFile, 0, 77, RegisterFile::ECommand::Unlock);
+    constexpr u32 bulkValues[3] = { 1, 2, 3 };
+    registerFile->WriteRegisters(RegisterFile::REGISTER_FILE_REGISTER_COUNT - 3, 3, bulkValues);
+
+    const SnapshotMessage delta = SendSnapshot(*registerFile, 3, *receiver);
+    const SnapshotMessage unchanged = SendSnapshot(*registerFile, 3, *receiver);
+
+    constexpr u32 deltaSize = RegisterFileSnapshot::MESSAGE_HEADER_SIZE + sizeof(RegisterFileSnapshot::Header) + 3 * sizeof(RegisterFileSnapshot::RunHeader) + 5 * RegisterFileSnapshot::RUN_REGISTER_SIZE;
+
+    registerFile->Reset();
+    const SnapshotMessage afterReset = SendSnapshot(*registerFile, 3, *receiver);
+
+    if(!full.Decoded || full.Flags != RegisterFileSnapshot::FLAG_FULL || full.RunCount != 1 || full.Size != sizeof(u32) * 2 + RegisterFileSnapshot::MAX_PAYLOAD_SIZE)
+    {
+        ConPrinter::PrintLn("Full register snapshot was malformed, {} bytes, flags {}, {} runs.", full.Size, full.Flags, full.RunCount);
+    }
+    else if(!delta.Decoded || delta.Flags != 0 || delta.RunCount != 3 || delta.Size != deltaSize)
+    {
+        ConPrinter::PrintLn("Delta register snapshot was {} bytes with {} runs, expected {} bytes with 3 runs.", delta.Size, delta.RunCount, deltaSize);
+    }
+    else if(unchanged.Size != 0)
+    {
+        ConPrinter::PrintLn("Unchanged register file produced a {} byte snapshot.", unchanged.Size);
+    }
+    else if(!afterReset.Decoded || afterReset.Flags != RegisterFileSnapshot::FLAG_FULL || receiver->SmIndex != 3 || !ReceiverMatches(*registerFile, *receiver))
+    {
+        ConPrinter::PrintLn("Register snapshots did not reproduce the register file.");
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully round tripped register file snapshots.");
+    }
+
+    delete receiver;
+    delete registerFile;
+}
+
+static void TestSnapshotFallback() noexcept
+{
+    RegisterFile* const registerFile = CreateRegisterFile();
+    SnapshotReceiver* const receiver = new(::std::nothrow) SnapshotReceiver { };
+
+    (void) SendSnapshot(*registerFile, 1, *receiver);
+
+    // Every other register changing needs a run per register, which must still be smaller than a full snapshot.
+    for(u32 i = 0; i < RegisterFile::REGISTER_FILE_REGISTER_COUNT; i += 2)
+    {
+        registerFile->SetRegister(i, ~i);
+    }
+
+    const SnapshotMessage scattered = SendSnapshot(*registerFile, 1, *receiver);
+
+    for(u32 i = 0; i < RegisterFile::REGISTER_FILE_REGISTER_COUNT; ++i)
+    {
+        registerFile->SetRegister(i, i + 1);
+    }
+
+    const SnapshotMessage everything = SendSnapshot(*registerFile, 1, *receiver);
+
+    // A payload from a newer version must be rejected rather than misread.
+    u8 payload[sizeof(RegisterFileSnapshot::Header)];
+    RegisterFileSnapshot::Header header { RegisterFileSnapshot::VERSION + 1, 1, 0, 0 };
+    (void) ::std::memcpy(payload, &header, sizeof(header));
+    u32 smIndex = 0;
+    const bool futureDecoded = RegisterFileSnapshot::Decode(payload, sizeof(payload), &smIndex, receiver->Registers, receiver->Contestation);
+
+    if(!scattered.Decoded || scattered.Flags != 0 || scattered.RunCount != RegisterFile::REGISTER_FILE_REGISTER_COUNT / 2 || scattered.Size >= everything.Size)
+    {
+        ConPrinter::PrintLn("Scattered register changes produced a {} byte snapshot with {} runs.", scattered.Size, scattered.RunCount);
+    }
+    else if(!everything.Decoded || everything.Flags != RegisterFileSnapshot::FLAG_FULL || everything.RunCount != 1 || !ReceiverMatches(*registerFile, *receiver))
+    {
+        ConPrinter::PrintLn("Changing every register did not produce a full snapshot, flags {}.", everything.Flags);
+    }
+    else if(futureDecoded)
+    {
+        ConPrinter::PrintLn("Register snapshot of version {} was accepted.", header.Version);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully fell back to full register snapshots.");
+    }
+
+    delete receiver;
+    delete registerFile;
+}
@@ -0,0 +1,242 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#include <ConPrinter.hpp>
+
+#include <Processor.hpp>
+#include <StreamingMultiprocessor.hpp>
+#include <WarpScheduler.hpp>
+#include <LoadStore.hpp>
+#include <SharedMemory.hpp>
+
+#include "KernelAssembly.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <new>
+
+static void BenchmarkMatrixMultiply(bool useSharedMemory) noexcept;
+
+namespace tau::benchmark::shared_memory {
+
+void RunBenchmarks() noexcept
+{
+    BenchmarkMatrixMultiply(false);
+    BenchmarkMatrixMultiply(true);
+}
+
+}
+
+static constexpr u32 MATRIX_SIZE = 32;
+static constexpr u32 SM_COUNT = 4;
+// Each thread computes one row of the result.
+static constexpr u32 THREADS_PER_WARP = MATRIX_SIZE / SM_COUNT;
+// Each thread copies this many rows of B into shared memory.
+static constexpr u32 COPY_ROW_COUNT = MATRIX_SIZE / THREADS_PER_WARP;
+// The result is built up 8 columns at a time, one Ld/St's worth.
+static constexpr u32 COLUMN_BLOCK = 8;
+static constexpr u32 CLOCK_LIMIT = 1 << 24;
+
+// Register layout of each thread.
+static constexpr u8 A_ADDRESS_REGISTER = 0;
+static constexpr u8 B_ADDRESS_REGISTER = 2;
+static constexpr u8 C_ADDRESS_REGISTER = 4;
+// Where the whole of B is in shared memory.
+static constexpr u8 SHARED_B_ADDRESS_REGISTER = 6;
+// The rows of B this thread copies, in global and shared memory.
+static constexpr u8 COPY_SOURCE_REGISTER = 8;
+static constexpr u8 COPY_TARGET_REGISTER = 10;
+static constexpr u8 A_ROW_REGISTER = 16;
+// Rows of B and products are double buffered, so the next load doesn't wait for the multiplies.
+static constexpr u8 B_ROW_REGISTER = A_ROW_REGISTER + MATRIX_SIZE;
+static constexpr u8 PRODUCT_REGISTER = B_ROW_REGISTER + 2 * COLUMN_BLOCK;
+// An add can't write a register it reads, so the sums go back and forth between two sets.
+static constexpr u8 ACCUMULATOR_REGISTER = PRODUCT_REGISTER + 2 * COLUMN_BLOCK;
+// Odd, so the threads' registers start in different register file banks.
+static constexpr u32 THREAD_REGISTER_COUNT = ACCUMULATOR_REGISTER + 2 * COLUMN_BLOCK + 1;
+
+struct MatrixKernelMemory final
+{
+    alignas(64) u8 Program[12 * 1024];
+    alignas(64) f32 A[MATRIX_SIZE][MATRIX_SIZE];
+    alignas(64) f32 B[MATRIX_SIZE][MATRIX_SIZE];
+    alignas(64) f32 C[MATRIX_SIZE][MATRIX_SIZE];
+    alignas(64) u32 Registers[SM_COUNT][THREADS_PER_WARP][THREAD_REGISTER_COUNT];
+};
+
+// C = A * B, with B read either straight from global memory or from a copy in shared memory.
+static void WriteKernel(MatrixKernelMemory& memory, const bool useSharedMemory) noexcept
+{
+    u8* const program = memory.Program;
+    u32 offset = 0;
+
+    // Every thread works through its own row of A, so it's held in registers.
+    for(u32 i = 0; i < MATRIX_SIZE; i += COLUMN_BLOCK)
+    {
+        offset = WriteLoadStore(program, offset, false, COLUMN_BLOCK - 1, static_cast<u8>(A_ROW_REGISTER + i), static_cast<i16>(i), A_ADDRESS_REGISTER);
+    }
+
+    // The threads copy B into shared memory between them. It's one warp, so every copy has been issued before any thread reads it back.
+    if(useSharedMemory)
+    {
+        for(u32 i = 0; i < COPY_ROW_COUNT * MATRIX_SIZE; i += COLUMN_BLOCK)
+        {
+            const u8 buffer = static_cast<u8>(B_ROW_REGISTER + (i / COLUMN_BLOCK) % 2 * COLUMN_BLOCK);
+            offset = WriteLoadStore(program, offset, false, COLUMN_BLOCK - 1, buffer, static_cast<i16>(i), COPY_SOURCE_REGISTER);
+            offset = WriteLoadStore(program, offset, true, COLUMN_BLOCK - 1, buffer, static_cast<i16>(i), COPY_TARGET_REGISTER, true);
+        }
+    }
+
+    const u8 bAddressRegister = useSharedMemory ? SHARED_B_ADDRESS_REGISTER : B_ADDRESS_REGISTER;
+
+    for(u32 column = 0; column < MATRIX_SIZE; column += COLUMN_BLOCK)
+    {
+        // The first add reads the second set.
+        program[offset++] = static_cast<u8>(EInstruction::LoadZero);
+        program[offset++] = COLUMN_BLOCK - 1;
+        program[offset++] = ACCUMULATOR_REGISTER + COLUMN_BLOCK;
+
+        for(u32 k = 0; k < MATRIX_SIZE; ++k)
+        {
+            const u8 bRow = static_cast<u8>(B_ROW_REGISTER + k % 2 * COLUMN_BLOCK);
+            const u8 product = static_cast<u8>(PRODUCT_REGISTER + k % 2 * COLUMN_BLOCK);
+            const u8 sum = static_cast<u8>(ACCUMULATOR_REGISTER + k % 2 * COLUMN_BLOCK);
+            const u8 previousSum = static_cast<u8>(ACCUMULATOR_REGISTER + (k + 1) % 2 * COLUMN_BLOCK);
+
+            offset = WriteLoadStore(program, offset, false, COLUMN_BLOCK - 1, bRow, static_cast<i16>(k * MATRIX_SIZE + column), bAddressRegister, useSharedMemory);
+
+            for(u32 i = 0; i < COLUMN_BLOCK; ++i)
+            {
+                offset = WriteBinaryOp(program, offset, EInstruction::MulF, static_cast<u8>(A_ROW_REGISTER + k), static_cast<u8>(bRow + i), static_cast<u8>(product + i));
+            }
+
+            for(u32 i = 0; i < COLUMN_BLOCK; ++i)
+            {
+                offset = WriteBinaryOp(program, offset, EInstruction::AddF, static_cast<u8>(previousSum + i), static_cast<u8>(product + i), static_cast<u8>(sum + i));
+            }
+        }
+
+        // The last add wrote the second set.
+        offset = WriteLoadStore(program, offset, true, COLUMN_BLOCK - 1, ACCUMULATOR_REGISTER + COLUMN_BLOCK, static_cast<i16>(column), C_ADDRESS_REGISTER);
+    }
+
+    program[offset] = static_cast<u8>(EInstruction::Hlt);
+}
+
+static void SetAddressRegisters(u32* const registers, const u8 registerIndex, const u64 address) noexcept
+{
+    registers[registerIndex] = static_cast<u32>(address);
+    registers[registerIndex + 1] = static_cast<u32>(address >> 32);
+}
+
+static void BenchmarkMatrixMultiply(const bool useSharedMemory) noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    MatrixKernelMemory* const memory = new(::std::nothrow) MatrixKernelMemory;
+    (void) ::std::memset(memory, 0, sizeof(*memory));
+    WriteKernel(*memory, useSharedMemory);
+
+    for(u32 row = 0; row < MATRIX_SIZE; ++row)
+    {
+        for(u32 column = 0; column < MATRIX_SIZE; ++column)
+        {
+            memory->A[row][column] = static_cast<f32>(static_cast<i32>((row + column) % 7) - 3);
+            memory->B[row][column] = static_cast<f32>(static_cast<i32>((row * column) % 5) - 2);
+        }
+    }
+
+    for(u32 sm = 0; sm < SM_COUNT; ++sm)
+    {
+        for(u32 thread = 0; thread < THREADS_PER_WARP; ++thread)
+        {
+            const u32 row = sm * THREADS_PER_WARP + thread;
+            u32* const registers = memory->Registers[sm][thread];
+
+            WriteBasePointer(&registers[A_ADDRESS_REGISTER], memory->A[row]);
+            WriteBasePointer(&registers[B_ADDRESS_REGISTER], memory->B);
+            WriteBasePointer(&registers[C_ADDRESS_REGISTER], memory->C[row]);
+            SetAddressRegisters(registers, SHARED_B_ADDRESS_REGISTER, 0);
+            WriteBasePointer(&registers[COPY_SOURCE_REGISTER], memory->B[thread * COPY_ROW_COUNT]);
+            SetAddressRegisters(registers, COPY_TARGET_REGISTER, thread * COPY_ROW_COUNT * MATRIX_SIZE);
+        }
+
+        (void) processor->TestLaunchWarp(sm, 0, reinterpret_cast<u64>(memory->Program), (1 << THREADS_PER_WARP) - 1, THREAD_REGISTER_COUNT - 1, WordAddress(memory->Registers[sm]), FpMode { });
+    }
+
+    const auto start = ::std::chrono::high_resolution_clock::now();
+
+    u64 cycles = 0;
+    bool active = true;
+
+    for(; cycles < CLOCK_LIMIT && active; ++cycles)
+    {
+        processor->Clock();
+
+        active = false;
+
+        for(u32 sm = 0; sm < SM_COUNT; ++sm)
+        {
+            active = active || processor->TestStreamingMultiprocessor(sm).TestWarpScheduler(0).ActiveWarps() != 0;
+        }
+    }
+
+    const auto end = ::std::chrono::high_resolution_clock::now();
+    const u64 nanoseconds = static_cast<u64>(::std::chrono::duration_cast<::std::chrono::nanoseconds>(end - start).count());
+
+    for(u32 sm = 0; sm < SM_COUNT; ++sm)
+    {
+        processor->FlushCache(sm);
+    }
+
+    // The inputs are small integers, so every product and partial sum is exact and the result has to match bit for bit.
+    u32 wrongElements = 0;
+
+    for(u32 row = 0; row < MATRIX_SIZE; ++row)
+    {
+        for(u32 column = 0; column < MATRIX_SIZE; ++column)
+        {
+            f32 expected = 0.0f;
+
+            for(u32 k = 0; k < MATRIX_SIZE; ++k)
+            {
+                expected += memory->A[row][k] * memory->B[k][column];
+            }
+
+            wrongElements += memory->C[row][column] != expected ? 1 : 0;
+        }
+    }
+
+    const char* const variant = useSharedMemory ? "shared memory" : "global memory";
+
+    if(active || wrongElements != 0)
+    {
+        ConPrinter::PrintLn("Matrix multiply from {} didn't finish, or computed {} elements of C wrong.", variant, wrongElements);
+    }
+
+    u64 loadMisses = 0;
+    u64 mergedLoads = 0;
+    u64 transactions = 0;
+    u64 sharedBankConflictStallCycles = 0;
+
+    for(u32 sm = 0; sm < SM_COUNT; ++sm)
+    {
+        for(u32 unit = 0; unit < 4; ++unit)
+        {
+            const LoadStore& ldSt = processor->TestStreamingMultiprocessor(sm).TestLoadStore(unit);
+            loadMisses += ldSt.LoadMisses();
+            mergedLoads += ldSt.MergedLoads();
+            transactions += ldSt.MemoryTransactions();
+            sharedBankConflictStallCycles += ldSt.SharedBankConflictStallCycles();
+        }
+    }
+
+    ConPrinter::PrintLn("Matrix multiply {}x{} from {}: {} cycles, {} line misses, {} merged loads, {} line transactions, {} shared bank conflict stall clocks, {} ns per cycle.", MATRIX_SIZE, MATRIX_SIZE, variant, cycles, loadMisses, mergedLoads, transactions, sharedBankConflictStallCycles, nanoseconds / cycles);
+
+    delete memory;
+    delete processor;
+}
@@ -0,0 +1,272 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#include <ConPrinter.hpp>
+
+#include <Processor.hpp>
+#include <StreamingMultiprocessor.hpp>
+#include <WarpScheduler.hpp>
+#include <LoadStore.hpp>
+#include <SharedMemory.hpp>
+
+#include "KernelAssembly.hpp"
+
+#include <cstring>
+#include <new>
+
+static void TestBankArbitration() noexcept;
+static void TestKernelSharedRoundTrip() noexcept;
+static void TestKernelBankConflicts(u32 threadStride, bool expectConflicts) noexcept;
+
+namespace tau::test::shared_memory {
+
+void RunTests() noexcept
+{
+    TestBankArbitration();
+    TestKernelSharedRoundTrip();
+    // Consecutive words are in consecutive banks.
+    TestKernelBankConflicts(1, false);
+    // Every thread lands on the same bank.
+    TestKernelBankConflicts(SharedMemory::BANK_COUNT, true);
+    // Padding a row by a word spreads them back out.
+    TestKernelBankConflicts(SharedMemory::BANK_COUNT + 1, false);
+}
+
+}
+
+static constexpr u32 CLOCK_LIMIT = 1 << 20;
+static constexpr u32 THREADS_PER_WARP = 4;
+// Not a multiple of the register file banks, so the threads' address registers don't conflict and they reach shared memory together.
+static constexpr u32 THREAD_REGISTER_COUNT = 17;
+
+struct SharedMemoryTestMemory final
+{
+    alignas(64) u8 Program[64];
+    alignas(64) u32 Registers[THREADS_PER_WARP][THREAD_REGISTER_COUNT];
+};
+
+// Runs a single warp of THREADS_PER_WARP threads on SM 0, returns false if it didn't finish.
+[[nodiscard]] static bool RunWarp(Processor& processor, SharedMemoryTestMemory& memory) noexcept
+{
+    (void) processor.TestLaunchWarp(0, 0, reinterpret_cast<u64>(memory.Program), (1 << THREADS_PER_WARP) - 1, THREAD_REGISTER_COUNT - 1, WordAddress(memory.Registers), FpMode { });
+
+    const WarpScheduler& scheduler = processor.TestStreamingMultiprocessor(0).TestWarpScheduler(0);
+
+    u32 clock = 0;
+
+    for(; clock < CLOCK_LIMIT && scheduler.ActiveWarps() != 0; ++clock)
+    {
+        processor.Clock();
+    }
+
+    return clock < CLOCK_LIMIT;
+}
+
+// Banks are handed out once per clock, reads of the same word share them.
+static void TestBankArbitration() noexcept
+{
+    SharedMemory* const sharedMemory = new(::std::nothrow) SharedMemory;
+    sharedMemory->Reset();
+
+    for(u32 i = 0; i < 64; ++i)
+    {
+        sharedMemory->SetWord(i, 0x5E000000u | i);
+    }
+
+    u32 values[8];
+    u32 broadcastValues[4];
+
+    const bool first = sharedMemory->Read(0, 8, values);
+    // Banks 0 to 7 again, but different words.
+    const bool sameBanks = sharedMemory->Read(SharedMemory::BANK_COUNT, 8, values);
+    const bool otherBanks = sharedMemory->Read(8, 8, values);
+    // Words 2 to 5 are already being read.
+    const bool broadcast = sharedMemory->Read(2, 4, broadcastValues);
+    const u32 written = 0x77777777;
+    const bool write = sharedMemory->Write(16, 1, &written);
+    const bool readOfWrite = sharedMemory->Read(16, 1, values);
+
+    sharedMemory->Clock();
+
+    const bool nextClock = sharedMemory->Read(SharedMemory::BANK_COUNT, 8, values);
+
+    if(!first || sameBanks || !otherBanks || !broadcast || !write || readOfWrite || !nextClock)
+    {
+        ConPrinter::PrintLn("Bank arbitration granted first {}, same banks {}, other banks {}, broadcast {}, write {}, read of write {}, next clock {}.", first, sameBanks, otherBanks, broadcast, write, readOfWrite, nextClock);
+    }
+    else if(values[0] != (0x5E000000u | SharedMemory::BANK_COUNT) || broadcastValues[0] != 0x5E000002 || broadcastValues[3] != 0x5E000005 || sharedMemory->GetWord(16) != 0x77777777)
+    {
+        ConPrinter::PrintLn("Shared memory read 0x{XP0} and broadcast 0x{XP0}, 0x{XP0}.", values[0], broadcastValues[0], broadcastValues[3]);
+    }
+    else if(sharedMemory->BankConflicts() != 2 || sharedMemory->Broadcasts() != 1 || sharedMemory->Reads() != 4 || sharedMemory->Writes() != 1)
+    {
+        ConPrinter::PrintLn("Shared memory counted {} bank conflicts, {} broadcasts, {} reads, and {} writes, expected 2, 1, 4, and 1.", sharedMemory->BankConflicts(), sharedMemory->Broadcasts(), sharedMemory->Reads(), sharedMemory->Writes());
+    }
+    else
+    {
+        // Words past the end read as all ones and don't take a bank.
+        sharedMemory->Clock();
+
+        const u32 pastEnd[4] = { 1, 2, 3, 4 };
+        (void) sharedMemory->Write(SharedMemory::WORD_COUNT - 2, 4, pastEnd);
+        sharedMemory->Clock();
+        const bool straddling = sharedMemory->Read(SharedMemory::WORD_COUNT - 2, 4, values);
+
+        if(!straddling || values[0] != 1 || values[1] != 2 || values[2] != 0xFFFFFFFF || values[3] != 0xFFFFFFFF)
+        {
+            ConPrinter::PrintLn("Access past the end of shared memory read 0x{XP0} 0x{XP0} 0x{XP0} 0x{XP0}.", values[0], values[1], values[2], values[3]);
+        }
+        else
+        {
+            ConPrinter::PrintLn("Successfully arbitrated shared memory banks.");
+        }
+    }
+
+    delete sharedMemory;
+}
+
+// Each thread stores to its own words, then loads the next thread's, without touching the caches.
+static void TestKernelSharedRoundTrip() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    SharedMemoryTestMemory* const memory = new(::std::nothrow) SharedMemoryTestMemory;
+    (void) ::std::memset(memory, 0, sizeof(*memory));
+
+    for(u32 thread = 0; thread < THREADS_PER_WARP; ++thread)
+    {
+        memory->Registers[thread][0] = thread * 4;
+
+        for(u32 i = 0; i < 4; ++i)
+        {
+            memory->Registers[thread][4 + i] = 0x5A000000u | (thread << 8) | i;
+        }
+    }
+
+    u32 offset = 0;
+    // Store r4..r7 to [r0], then load the next thread's 4 words into r8..r11.
+    offset = WriteLoadStore(memory->Program, offset, true, 3, 4, 0, 0, true);
+    offset = WriteLoadStore(memory->Program, offset, false, 3, 8, 4, 0, true);
+    memory->Program[offset] = static_cast<u8>(EInstruction::Hlt);
+
+    // The last thread reads what the host left after the first 16 words.
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+
+    for(u32 i = 0; i < 4; ++i)
+    {
+        sm.TestSharedMemory().SetWord(THREADS_PER_WARP * 4 + i, 0x5A000000u | (THREADS_PER_WARP << 8) | i);
+    }
+
+    const bool finished = RunWarp(*processor, *memory);
+
+    const WarpInfo& warp = sm.TestWarpScheduler(0).Warp(0);
+
+    u32 wrongRegisters = 0;
+
+    for(u32 thread = 0; thread < THREADS_PER_WARP; ++thread)
+    {
+        for(u32 i = 0; i < 4; ++i)
+        {
+            const u32 loaded = sm.GetRegister(static_cast<u32>(warp.RegisterFileBase) + thread * THREAD_REGISTER_COUNT + 8 + i);
+            wrongRegisters += loaded != (0x5A000000u | ((thread + 1) << 8) | i) ? 1 : 0;
+        }
+    }
+
+    u64 sharedLoads = 0;
+    u64 sharedStores = 0;
+    u64 transactions = 0;
+
+    for(u32 unit = 0; unit < 4; ++unit)
+    {
+        const LoadStore& ldSt = sm.TestLoadStore(unit);
+        sharedLoads += ldSt.SharedLoads();
+        sharedStores += ldSt.SharedStores();
+        transactions += ldSt.MemoryTransactions() + ldSt.Loads() + ldSt.Stores();
+    }
+
+    const bool otherSmUntouched = processor->TestStreamingMultiprocessor(1).TestSharedMemory().GetWord(0) == 0;
+
+    if(!finished)
+    {
+        ConPrinter::PrintLn("Shared memory round trip didn't complete in {} clocks.", CLOCK_LIMIT);
+    }
+    else if(wrongRegisters != 0)
+    {
+        ConPrinter::PrintLn("Shared memory round trip loaded {} registers incorrectly.", wrongRegisters);
+    }
+    else if(sharedLoads != THREADS_PER_WARP || sharedStores != THREADS_PER_WARP)
+    {
+        ConPrinter::PrintLn("Shared memory round trip counted {} loads and {} stores, expected {} each.", sharedLoads, sharedStores, THREADS_PER_WARP);
+    }
+    else if(transactions != 0 || sm.TestStoreBuffer().Stores() != 0 || !otherSmUntouched)
+    {
+        ConPrinter::PrintLn("Shared memory round trip made {} global accesses and {} buffered stores.", transactions, sm.TestStoreBuffer().Stores());
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully stored to and loaded from shared memory across threads.");
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// Every thread loads a word threadStride words after the one before it, at the same time.
+static void TestKernelBankConflicts(const u32 threadStride, const bool expectConflicts) noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    SharedMemoryTestMemory* const memory = new(::std::nothrow) SharedMemoryTestMemory;
+    (void) ::std::memset(memory, 0, sizeof(*memory));
+
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+
+    for(u32 thread = 0; thread < THREADS_PER_WARP; ++thread)
+    {
+        memory->Registers[thread][0] = thread * threadStride;
+        sm.TestSharedMemory().SetWord(thread * threadStride, 0xBA000000u | thread);
+    }
+
+    u32 offset = 0;
+    offset = WriteLoadStore(memory->Program, offset, false, 0, 4, 0, 0, true);
+    memory->Program[offset] = static_cast<u8>(EInstruction::Hlt);
+
+    const bool finished = RunWarp(*processor, *memory);
+
+    const WarpInfo& warp = sm.TestWarpScheduler(0).Warp(0);
+
+    u32 wrongRegisters = 0;
+
+    for(u32 thread = 0; thread < THREADS_PER_WARP; ++thread)
+    {
+        wrongRegisters += sm.GetRegister(static_cast<u32>(warp.RegisterFileBase) + thread * THREAD_REGISTER_COUNT + 4) != (0xBA000000u | thread) ? 1 : 0;
+    }
+
+    u64 stallCycles = 0;
+
+    for(u32 unit = 0; unit < 4; ++unit)
+    {
+        stallCycles += sm.TestLoadStore(unit).SharedBankConflictStallCycles();
+    }
+
+    if(!finished || wrongRegisters != 0)
+    {
+        ConPrinter::PrintLn("Shared loads with a stride of {} loaded {} registers incorrectly.", threadStride, wrongRegisters);
+    }
+    else if((stallCycles != 0) != expectConflicts || stallCycles != sm.SharedMemoryBankConflicts())
+    {
+        ConPrinter::PrintLn("Shared loads with a stride of {} stalled {} clocks on {} bank conflicts.", threadStride, stallCycles, sm.SharedMemoryBankConflicts());
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully modelled {} bank conflicts for a stride of {}.", stallCycles, threadStride);
+    }
+
+    delete memory;
+    delete processor;
+}
@@ -0,0 +1,326 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#include <ConPrinter.hpp>
+
+#include <Processor.hpp>
+#include <StreamingMultiprocessor.hpp>
+#include <WarpScheduler.hpp>
+#include <StoreBuffer.hpp>
+
+#include "KernelAssembly.hpp"
+
+#include <cstring>
+#include <new>
+
+static void TestWriteCombining() noexcept;
+static void TestStoreForwarding() noexcept;
+static void TestCapacityDrain() noexcept;
+static void TestFenceVisibility() noexcept;
+static void TestKernelStoreOrdering() noexcept;
+
+namespace tau::test::store_buffer {
+
+void RunTests() noexcept
+{
+    TestWriteCombining();
+    TestStoreForwarding();
+    TestCapacityDrain();
+    TestFenceVisibility();
+    TestKernelStoreOrdering();
+}
+
+}
+
+static constexpr u32 CLOCK_LIMIT = 1 << 20;
+static constexpr u32 LINE_WORDS = 8;
+
+struct StoreBufferTestMemory final
+{
+    alignas(64) u8 Program[64];
+    alignas(64) u32 Data[(StoreBuffer::ENTRY_COUNT + 2) * LINE_WORDS];
+    alignas(64) u32 Registers[16];
+};
+
+[[nodiscard]] static StoreBufferTestMemory* CreateMemory() noexcept
+{
+    StoreBufferTestMemory* const memory = new(::std::nothrow) StoreBufferTestMemory;
+    (void) ::std::memset(memory, 0, sizeof(*memory));
+
+    for(u32 i = 0; i < ::std::size(memory->Data); ++i)
+    {
+        memory->Data[i] = 0xDA7A0000u | i;
+    }
+
+    return memory;
+}
+
+// Single word stores filling a line one at a time go out as one full line write.
+static void TestWriteCombining() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    StoreBufferTestMemory* const memory = CreateMemory();
+
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+    const StoreBuffer& storeBuffer = sm.TestStoreBuffer();
+
+    const u64 address = WordAddress(memory->Data);
+
+    for(u32 i = 0; i < LINE_WORDS - 1; ++i)
+    {
+        sm.Write(address + i, 0x5700u + i);
+    }
+
+    const bool heldPartial = !storeBuffer.IsEmpty() && storeBuffer.FullLineDrains() == 0;
+
+    sm.Write(address + LINE_WORDS - 1, 0x5700u + LINE_WORDS - 1);
+
+    const bool drainedFull = storeBuffer.IsEmpty();
+
+    processor->FlushCache(0);
+
+    u32 wrongWords = 0;
+
+    for(u32 i = 0; i < LINE_WORDS; ++i)
+    {
+        wrongWords += memory->Data[i] != 0x5700u + i ? 1 : 0;
+    }
+
+    if(!heldPartial || !drainedFull)
+    {
+        ConPrinter::PrintLn("Store buffer held a partial line: {}, drained a full line: {}.", heldPartial, drainedFull);
+    }
+    else if(wrongWords != 0)
+    {
+        ConPrinter::PrintLn("Combined stores wrote {} words incorrectly.", wrongWords);
+    }
+    else if(storeBuffer.Stores() != 8 || storeBuffer.MergedStores() != 7 || storeBuffer.FullLineDrains() != 1 || storeBuffer.PartialLineDrains() != 0)
+    {
+        ConPrinter::PrintLn("Store buffer counted {} stores, {} merged, {} full drains, and {} partial drains, expected 8, 7, 1, and 0.", storeBuffer.Stores(), storeBuffer.MergedStores(), storeBuffer.FullLineDrains(), storeBuffer.PartialLineDrains());
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully combined 8 single word stores into a full line write.");
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// Loads see buffered stores over what's in the cache, word by word.
+static void TestStoreForwarding() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    StoreBufferTestMemory* const memory = CreateMemory();
+
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+    const StoreBuffer& storeBuffer = sm.TestStoreBuffer();
+
+    const u64 address = WordAddress(&memory->Data[LINE_WORDS]);
+
+    // Words 2, 3, and 6 of the line.
+    const u32 stored[2] = { 0xF0000002, 0xF0000003 };
+    (void) sm.WriteCoalesced(address + 2, 2, stored);
+    sm.Write(address + 6, 0xF0000006);
+    // A later store to the same word replaces the earlier one.
+    sm.Write(address + 3, 0xF0000033);
+
+    u32 values[10];
+    // Start in the line before, and run into the line after.
+    (void) sm.ReadCoalesced(address - 1, 10, values);
+    const u32 single = sm.Read(address + 6);
+
+    u32 wrongWords = 0;
+
+    for(u32 i = 0; i < 10; ++i)
+    {
+        u32 expected = memory->Data[LINE_WORDS - 1 + i];
+
+        switch(i)
+        {
+            case 3: expected = 0xF0000002; break;
+            case 4: expected = 0xF0000033; break;
+            case 7: expected = 0xF0000006; break;
+            default: break;
+        }
+
+        wrongWords += values[i] != expected ? 1 : 0;
+    }
+
+    if(wrongWords != 0 || single != 0xF0000006)
+    {
+        ConPrinter::PrintLn("Forwarded loads read {} words incorrectly, single read 0x{XP0}.", wrongWords, single);
+    }
+    else if(storeBuffer.ForwardedLoads() != 2 || storeBuffer.MergedStores() != 2 || storeBuffer.IsEmpty())
+    {
+        ConPrinter::PrintLn("Store buffer counted {} forwarded loads and {} merged stores, expected 2 and 2.", storeBuffer.ForwardedLoads(), storeBuffer.MergedStores());
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully forwarded buffered stores to loads.");
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// One more partial line than there are entries pushes the oldest out.
+static void TestCapacityDrain() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    StoreBufferTestMemory* const memory = CreateMemory();
+
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+    const StoreBuffer& storeBuffer = sm.TestStoreBuffer();
+
+    const u64 address = WordAddress(memory->Data);
+
+    for(u32 i = 0; i <= StoreBuffer::ENTRY_COUNT; ++i)
+    {
+        sm.Write(address + i * LINE_WORDS, 0xC0000000u | i);
+    }
+
+    bool oldestDrained = true;
+
+    for(u32 i = 0; i < StoreBuffer::ENTRY_COUNT; ++i)
+    {
+        oldestDrained = oldestDrained && storeBuffer.TestEntry(i).LineAddress != address;
+    }
+
+    processor->FlushCache(0);
+
+    u32 wrongWords = 0;
+
+    for(u32 i = 0; i <= StoreBuffer::ENTRY_COUNT; ++i)
+    {
+        wrongWords += memory->Data[i * LINE_WORDS] != (0xC0000000u | i) ? 1 : 0;
+        wrongWords += memory->Data[i * LINE_WORDS + 1] != (0xDA7A0000u | (i * LINE_WORDS + 1)) ? 1 : 0;
+    }
+
+    if(!oldestDrained || storeBuffer.CapacityDrains() != 1)
+    {
+        ConPrinter::PrintLn("Store buffer made {} capacity drains, expected 1 of the oldest line.", storeBuffer.CapacityDrains());
+    }
+    else if(wrongWords != 0 || storeBuffer.PartialLineDrains() != StoreBuffer::ENTRY_COUNT + 1 || !storeBuffer.IsEmpty())
+    {
+        ConPrinter::PrintLn("Store buffer wrote {} words incorrectly with {} partial drains.", wrongWords, storeBuffer.PartialLineDrains());
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully drained the oldest line when the store buffer filled.");
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// Another SM doesn't see buffered stores until the storing SM fences.
+static void TestFenceVisibility() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    StoreBufferTestMemory* const memory = CreateMemory();
+
+    StreamingMultiprocessor& writer = processor->TestStreamingMultiprocessor(0);
+    StreamingMultiprocessor& reader = processor->TestStreamingMultiprocessor(1);
+
+    const u64 address = WordAddress(&memory->Data[3]);
+    const u32 oldValue = memory->Data[3];
+
+    writer.Write(address, 0xFE4CE000);
+
+    const u32 before = reader.Read(address);
+    const u32 writerView = writer.Read(address);
+
+    processor->FlushCache(0);
+
+    const u32 after = reader.Read(address);
+
+    if(before != oldValue || writerView != 0xFE4CE000)
+    {
+        ConPrinter::PrintLn("Before the fence the other SM read 0x{XP0}, expected 0x{XP0}, and the storing SM read 0x{XP0}.", before, oldValue, writerView);
+    }
+    else if(after != 0xFE4CE000 || writer.TestStoreBuffer().Fences() != 1)
+    {
+        ConPrinter::PrintLn("After {} fences the other SM read 0x{XP0}, expected 0xFE4CE000.", writer.TestStoreBuffer().Fences(), after);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully hid buffered stores from other SMs until a fence.");
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// A kernel storing then loading the same word gets the stored value, and FlushCache publishes its stores.
+static void TestKernelStoreOrdering() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    StoreBufferTestMemory* const memory = CreateMemory();
+
+    WriteBasePointer(memory->Registers, memory->Data);
+    memory->Registers[4] = 0x0DE40001;
+    memory->Registers[5] = 0x0DE40002;
+
+    u32 offset = 0;
+    // Store r4:r5 to words 5 and 6, load word 6 back into r6.
+    const u8 program[] = {
+        static_cast<u8>(EInstruction::LoadStore), 0x40 | 0x38 | 1, 0, 4, 5, 0,
+        static_cast<u8>(EInstruction::LoadStore), 0x38, 0, 6, 6, 0,
+        static_cast<u8>(EInstruction::FlushCache),
+        static_cast<u8>(EInstruction::Hlt)
+    };
+
+    (void) ::std::memcpy(memory->Program, program, sizeof(program));
+    offset += sizeof(program);
+    (void) offset;
+
+    (void) processor->TestLaunchWarp(0, 0, reinterpret_cast<u64>(memory->Program), 0x1, 15, WordAddress(memory->Registers), FpMode { });
+
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+    const WarpScheduler& scheduler = sm.TestWarpScheduler(0);
+
+    u32 clock = 0;
+
+    for(; clock < CLOCK_LIMIT && scheduler.ActiveWarps() != 0; ++clock)
+    {
+        processor->Clock();
+    }
+
+    const WarpInfo& warp = scheduler.Warp(0);
+    const u32 loaded = sm.GetRegister(static_cast<u32>(warp.RegisterFileBase) + 6);
+
+    // No host side flush, the kernel's own FlushCache has to have written these out.
+    if(clock >= CLOCK_LIMIT)
+    {
+        ConPrinter::PrintLn("Store ordering kernel didn't complete in {} clocks.", clock);
+    }
+    else if(loaded != 0x0DE40002)
+    {
+        ConPrinter::PrintLn("Load after store read 0x{XP0}, expected 0x0DE40002.", loaded);
+    }
+    else if(memory->Data[5] != 0x0DE40001 || memory->Data[6] != 0x0DE40002 || !sm.TestStoreBuffer().IsEmpty())
+    {
+        ConPrinter::PrintLn("After FlushCache memory held 0x{XP0} 0x{XP0}, expected 0x0DE40001 0x0DE40002.", memory->Data[5], memory->Data[6]);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully forwarded a kernel's store to its load and published it with FlushCache.");
+    }
+
+    delete memory;
+    delete processor;
+}
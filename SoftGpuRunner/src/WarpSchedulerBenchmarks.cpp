@@ -0,0 +1,119 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#include <ConPrinter.hpp>
+
+#include <Processor.hpp>
+#include <StreamingMultiprocessor.hpp>
+#include <WarpScheduler.hpp>
+#include <DispatchUnit.hpp>
+#include <CoreTiming.hpp>
+
+#include "KernelAssembly.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <new>
+
+static void BenchmarkMemoryBoundKernel(EWarpSchedulingPolicy policy, const char* policyName, u32 warpCount) noexcept;
+
+namespace tau::benchmark::warp_scheduler {
+
+void RunBenchmarks() noexcept
+{
+    for(const u32 warpCount : { 1u, 4u, 8u, 16u })
+    {
+        BenchmarkMemoryBoundKernel(EWarpSchedulingPolicy::LooseRoundRobin, "loose round robin", warpCount);
+        BenchmarkMemoryBoundKernel(EWarpSchedulingPolicy::GreedyThenOldest, "greedy then oldest", warpCount);
+        BenchmarkMemoryBoundKernel(EWarpSchedulingPolicy::TwoLevel, "two level", warpCount);
+    }
+}
+
+}
+
+static constexpr u32 LOAD_COUNT = 32;
+static constexpr u32 CLOCK_LIMIT = 1 << 22;
+
+struct KernelMemory final
+{
+    alignas(64) u8 Program[512];
+    alignas(64) u32 Data[WARP_COUNT][LOAD_COUNT * 8];
+    alignas(64) u32 Registers[WARP_COUNT][16];
+};
+
+// Every load touches a new cache line and is followed by two adds which depend on it and two which don't.
+static void WriteKernel(KernelMemory& memory) noexcept
+{
+    u8* const program = memory.Program;
+    u32 offset = 0;
+
+    for(u32 i = 0; i < LOAD_COUNT; ++i)
+    {
+        offset = WriteLoadStore(program, offset, false, 0, 3, static_cast<i16>(i * 8));
+
+        const u8 adds[4][3] = { { 6, 7, 8 }, { 3, 3, 4 }, { 7, 6, 9 }, { 4, 4, 5 } };
+
+        for(const u8 (&add)[3] : adds)
+        {
+            offset = WriteAddF(program, offset, add[0], add[1], add[2]);
+        }
+    }
+
+    program[offset] = static_cast<u8>(EInstruction::Hlt);
+}
+
+static void BenchmarkMemoryBoundKernel(const EWarpSchedulingPolicy policy, const char* const policyName, const u32 warpCount) noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    KernelMemory* const memory = new(::std::nothrow) KernelMemory;
+    (void) ::std::memset(memory, 0, sizeof(*memory));
+    WriteKernel(*memory);
+
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+    sm.SetWarpSchedulingPolicy(policy);
+
+    for(u32 i = 0; i < warpCount; ++i)
+    {
+        WriteBasePointer(memory->Registers[i], memory->Data[i]);
+
+        (void) processor->TestLaunchWarp(0, 0, reinterpret_cast<u64>(memory->Program), 0x1, 15, WordAddress(memory->Registers[i]), FpMode { });
+    }
+
+    const WarpScheduler& scheduler = sm.TestWarpScheduler(0);
+
+    const auto start = ::std::chrono::high_resolution_clock::now();
+
+    for(u32 clock = 0; clock < CLOCK_LIMIT && scheduler.ActiveWarps() != 0; ++clock)
+    {
+        processor->Clock();
+    }
+
+    const auto end = ::std::chrono::high_resolution_clock::now();
+    const u64 nanoseconds = static_cast<u64>(::std::chrono::duration_cast<::std::chrono::nanoseconds>(end - start).count());
+
+    if(scheduler.CompletedWarps() != warpCount)
+    {
+        ConPrinter::PrintLn("Warp scheduler ({}) completed {} of {} memory bound warps.", policyName, scheduler.CompletedWarps(), warpCount);
+    }
+
+    const u64 cycles = scheduler.ActiveCycles();
+    u64 retiredOps = 0;
+
+    for(u32 i = 0; i < 16; ++i)
+    {
+        retiredOps += sm.TestFpCoreTiming(i).RetiredWritebacks();
+    }
+
+    // Tenths of a percent of the 16 FP capable cores retiring a result per cycle.
+    const u64 fpSaturation = retiredOps * 1000 / (16 * cycles);
+
+    ConPrinter::PrintLn("Warp scheduler {} ({} warps): {} cycles per kernel, {} cycles per warp, {}.{}% FP saturation, {} memory stall switches, {} ns per cycle.", policyName, warpCount, cycles, cycles / warpCount, fpSaturation / 10, fpSaturation % 10, scheduler.MemoryStallSwitches(), nanoseconds / cycles);
+
+    delete memory;
+    delete processor;
+}
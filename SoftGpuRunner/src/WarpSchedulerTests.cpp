@@ -0,0 +1,450 @@
+/**
+ * @file
+ *
+ * Copyright (c) 2025. Grafika Strahlen LLC
+ * All rights reserved.
+ */
+#include <ConPrinter.hpp>
+
+#include <Processor.hpp>
+#include <StreamingMultiprocessor.hpp>
+#include <WarpScheduler.hpp>
+#include <DispatchUnit.hpp>
+
+#include "KernelAssembly.hpp"
+
+#include <cstring>
+#include <new>
+
+static void TestLaunchSlots() noexcept;
+static void TestTimeSlicing() noexcept;
+static void TestSpillAndFill() noexcept;
+static void TestLoadStore() noexcept;
+static void TestMemoryStallSwitching(EWarpSchedulingPolicy policy, const char* policyName) noexcept;
+
+namespace tau::test::warp_scheduler {
+
+void RunTests() noexcept
+{
+    TestLaunchSlots();
+    TestTimeSlicing();
+    TestSpillAndFill();
+    TestLoadStore();
+    TestMemoryStallSwitching(EWarpSchedulingPolicy::LooseRoundRobin, "loose round robin");
+    TestMemoryStallSwitching(EWarpSchedulingPolicy::GreedyThenOldest, "greedy then oldest");
+    TestMemoryStallSwitching(EWarpSchedulingPolicy::TwoLevel, "two level");
+}
+
+}
+
+// Every warp runs the same program, enough Nops to span several time slices, then Hlt.
+static constexpr u32 PROGRAM_NOP_COUNT = 256;
+static constexpr u32 CLOCK_LIMIT = 1 << 20;
+
+struct WarpTestMemory final
+{
+    alignas(64) u8 Program[PROGRAM_NOP_COUNT + 4];
+    // Each warp's registers, in the layout the scheduler spills them in.
+    alignas(64) u32 Registers[WARP_COUNT][1024];
+    // What each warp's registers should hold.
+    u32 Expected[WARP_COUNT][1024];
+};
+
+static void WriteProgram(WarpTestMemory& memory) noexcept
+{
+    (void) ::std::memset(memory.Program, static_cast<u8>(EInstruction::Nop), sizeof(memory.Program));
+    memory.Program[PROGRAM_NOP_COUNT] = static_cast<u8>(EInstruction::Hlt);
+}
+
+[[nodiscard]] static u32 WarpRegisterPattern(const u32 warpIndex, const u32 generation, const u32 registerIndex) noexcept
+{
+    return (warpIndex << 24) ^ (generation << 16) ^ (registerIndex * 0x9E37u);
+}
+
+static void TestLaunchSlots() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    WarpTestMemory* const memory = new(::std::nothrow) WarpTestMemory;
+    WriteProgram(*memory);
+
+    bool launched = true;
+
+    for(u32 i = 0; i < WARP_COUNT; ++i)
+    {
+        launched = launched && processor->TestLaunchWarp(0, 0, reinterpret_cast<u64>(memory->Program), 0x3, 15, WordAddress(memory->Registers[i]), FpMode { });
+    }
+
+    const bool overflowRejected = !processor->TestLaunchWarp(0, 0, reinterpret_cast<u64>(memory->Program), 0x3, 15, WordAddress(memory->Registers[0]), FpMode { });
+    const bool emptyRejected = !processor->TestLaunchWarp(0, 1, reinterpret_cast<u64>(memory->Program), 0x0, 15, WordAddress(memory->Registers[0]), FpMode { });
+
+    const WarpInfo& warp = processor->TestStreamingMultiprocessor(0).TestWarpScheduler(0).Warp(3);
+
+    if(!launched || !overflowRejected || !emptyRejected)
+    {
+        ConPrinter::PrintLn("Warp scheduler accepted {} of the first 16 warps, and rejected a 17th: {} and an empty warp: {}.", launched, overflowRejected, emptyRejected);
+    }
+    else if(warp.TotalRequiredRegisterCount != 31 || !warp.Active || warp.RegisterFileResident)
+    {
+        ConPrinter::PrintLn("Warp 3 needs {} registers, expected 32.", warp.TotalRequiredRegisterCount + 1);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully launched 16 warps on a dispatch port.");
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// Few enough warps that they all stay resident, they still have to share the dispatch unit.
+static void TestTimeSlicing() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    WarpTestMemory* const memory = new(::std::nothrow) WarpTestMemory;
+    WriteProgram(*memory);
+
+    constexpr u32 warpCount = 4;
+
+    for(u32 i = 0; i < warpCount; ++i)
+    {
+        for(u32 j = 0; j < 64; ++j)
+        {
+            memory->Registers[i][j] = WarpRegisterPattern(i, 0, j);
+        }
+
+        (void) processor->TestLaunchWarp(0, 0, reinterpret_cast<u64>(memory->Program), 0x3, 31, WordAddress(memory->Registers[i]), FpMode { });
+    }
+
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+    const WarpScheduler& scheduler = sm.TestWarpScheduler(0);
+
+    // Check the first warp's second thread sees its own registers once it's running.
+    bool baseRegistersCorrect = false;
+    u32 clock = 0;
+
+    for(; clock < CLOCK_LIMIT && scheduler.ActiveWarps() != 0; ++clock)
+    {
+        processor->Clock();
+
+        if(!baseRegistersCorrect && scheduler.State() == WarpScheduler::EState::Running && scheduler.CurrentWarp() == 0)
+        {
+            const u32 base = sm.TestDispatchUnit(0).BaseRegister(1);
+            baseRegistersCorrect = base == static_cast<u32>(scheduler.Warp(0).RegisterFileBase + 32) && sm.GetRegister(base + 5) == WarpRegisterPattern(0, 0, 37);
+        }
+    }
+
+    if(scheduler.ActiveWarps() != 0 || scheduler.CompletedWarps() != warpCount)
+    {
+        ConPrinter::PrintLn("Warp scheduler completed {} of {} warps in {} clocks.", scheduler.CompletedWarps(), warpCount, clock);
+    }
+    else if(!baseRegistersCorrect)
+    {
+        ConPrinter::PrintLn("Warp 0's second thread was not given its own registers.");
+    }
+    else if(scheduler.WarpSwitches() < warpCount || scheduler.Spills() != 0 || scheduler.Fills() != warpCount)
+    {
+        ConPrinter::PrintLn("Warp scheduler switched {} times with {} spills and {} fills, expected at least {}, 0, and {}.", scheduler.WarpSwitches(), scheduler.Spills(), scheduler.Fills(), warpCount, warpCount);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully time sliced {} resident warps.", warpCount);
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// 16 warps of 1024 registers, only 4 fit in the register file at once.
+static void TestSpillAndFill() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    WarpTestMemory* const memory = new(::std::nothrow) WarpTestMemory;
+    WriteProgram(*memory);
+
+    for(u32 i = 0; i < WARP_COUNT; ++i)
+    {
+        for(u32 j = 0; j < 1024; ++j)
+        {
+            memory->Registers[i][j] = WarpRegisterPattern(i, 0, j);
+            memory->Expected[i][j] = memory->Registers[i][j];
+        }
+
+        (void) processor->TestLaunchWarp(0, 0, reinterpret_cast<u64>(memory->Program), 0xF, 255, WordAddress(memory->Registers[i]), FpMode { });
+    }
+
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+    const WarpScheduler& scheduler = sm.TestWarpScheduler(0);
+
+    u32 generations[WARP_COUNT] { };
+    u32 mismatches = 0;
+    u32 mismatchWarp = 0;
+    u32 maxResident = 0;
+    u32 clock = 0;
+
+    for(; clock < CLOCK_LIMIT && scheduler.ActiveWarps() != 0; ++clock)
+    {
+        processor->Clock();
+
+        u32 residentCount = 0;
+
+        for(u32 i = 0; i < WARP_COUNT; ++i)
+        {
+            const WarpInfo& warp = scheduler.Warp(i);
+
+            if(!warp.RegisterFileResident)
+            {
+                continue;
+            }
+
+            ++residentCount;
+
+            const bool transferring = (scheduler.State() == WarpScheduler::EState::Filling || scheduler.State() == WarpScheduler::EState::Spilling) && scheduler.TransferWarp() == i;
+
+            // A warp being filled is only partially there yet.
+            if(transferring && scheduler.State() == WarpScheduler::EState::Filling)
+            {
+                continue;
+            }
+
+            u32 registers[1024];
+            sm.TestReadRegisters(warp.RegisterFileBase, 1024, registers);
+
+            if(::std::memcmp(registers, memory->Expected[i], sizeof(registers)) != 0)
+            {
+                ++mismatches;
+                mismatchWarp = i;
+            }
+
+            // Every so often change a waiting warp's registers, these have to survive its next spill.
+            if(!transferring && i != scheduler.CurrentWarp() && (clock % 97) == i)
+            {
+                ++generations[i];
+
+                for(u32 j = 0; j < 1024; ++j)
+                {
+                    memory->Expected[i][j] = WarpRegisterPattern(i, generations[i], j);
+                }
+
+                sm.TestWriteRegisters(warp.RegisterFileBase, 1024, memory->Expected[i]);
+            }
+        }
+
+        if(residentCount > maxResident)
+        {
+            maxResident = residentCount;
+        }
+    }
+
+    u32 modifiedWarps = 0;
+
+    for(u32 i = 0; i < WARP_COUNT; ++i)
+    {
+        modifiedWarps += generations[i] != 0 ? 1 : 0;
+    }
+
+    if(scheduler.ActiveWarps() != 0 || scheduler.CompletedWarps() != WARP_COUNT)
+    {
+        ConPrinter::PrintLn("Warp scheduler completed {} of {} spilling warps in {} clocks.", scheduler.CompletedWarps(), WARP_COUNT, clock);
+    }
+    else if(mismatches != 0)
+    {
+        ConPrinter::PrintLn("Warp {} registers were corrupted, {} mismatches over all resident warps.", mismatchWarp, mismatches);
+    }
+    else if(maxResident != 4 || scheduler.Spills() == 0 || scheduler.Fills() <= WARP_COUNT || modifiedWarps == 0)
+    {
+        ConPrinter::PrintLn("Warp scheduler had at most {} warps resident, with {} spills, {} fills, and {} modified warps.", maxResident, scheduler.Spills(), scheduler.Fills(), modifiedWarps);
+    }
+    else if(scheduler.SpilledRegisters() != scheduler.Spills() * 1024 || scheduler.FilledRegisters() != scheduler.Fills() * 1024)
+    {
+        ConPrinter::PrintLn("Warp scheduler spilled {} and filled {} registers, expected {} and {}.", scheduler.SpilledRegisters(), scheduler.FilledRegisters(), scheduler.Spills() * 1024, scheduler.Fills() * 1024);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully spilled and filled {} warps {} times through the cache, {} cycles transferring.", WARP_COUNT, scheduler.Spills(), scheduler.TransferCycles());
+    }
+
+    delete memory;
+    delete processor;
+}
+
+struct LoadStoreTestMemory final
+{
+    alignas(64) u8 Program[64];
+    alignas(64) u32 Data[16];
+    alignas(64) u32 Registers[16];
+};
+
+// A single warp copies a pair of registers from one cache line to the next through the Ld/St units.
+static void TestLoadStore() noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    LoadStoreTestMemory* const memory = new(::std::nothrow) LoadStoreTestMemory;
+    (void) ::std::memset(memory, 0, sizeof(*memory));
+
+    u32 offset = 0;
+    offset = WriteLoadStore(memory->Program, offset, false, 1, 4, 2);
+    offset = WriteLoadStore(memory->Program, offset, true, 1, 4, 10);
+    memory->Program[offset] = static_cast<u8>(EInstruction::Hlt);
+
+    memory->Data[2] = 0x12345678;
+    memory->Data[3] = 0x9ABCDEF0;
+    WriteBasePointer(memory->Registers, memory->Data);
+
+    (void) processor->TestLaunchWarp(0, 0, reinterpret_cast<u64>(memory->Program), 0x1, 15, WordAddress(memory->Registers), FpMode { });
+
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+    const WarpScheduler& scheduler = sm.TestWarpScheduler(0);
+
+    u32 clock = 0;
+
+    for(; clock < CLOCK_LIMIT && scheduler.ActiveWarps() != 0; ++clock)
+    {
+        processor->Clock();
+    }
+
+    processor->FlushCache(0);
+
+    const LoadStore& ldSt = sm.TestLoadStore(0);
+
+    if(scheduler.ActiveWarps() != 0)
+    {
+        ConPrinter::PrintLn("Ld/St warp didn't complete in {} clocks.", clock);
+    }
+    else if(memory->Data[10] != 0x12345678 || memory->Data[11] != 0x9ABCDEF0)
+    {
+        ConPrinter::PrintLn("Ld/St copied 0x{XP0} 0x{XP0}, expected 0x12345678 0x9ABCDEF0.", memory->Data[10], memory->Data[11]);
+    }
+    else if(ldSt.Loads() + sm.TestLoadStore(1).Loads() != 1 || ldSt.Stores() + sm.TestLoadStore(1).Stores() != 1 || ldSt.LoadMisses() != 1)
+    {
+        ConPrinter::PrintLn("Ld/St unit 0 counted {} loads, {} stores, and {} misses, expected 1, 1, and 1.", ldSt.Loads(), ldSt.Stores(), ldSt.LoadMisses());
+    }
+    else if(clock < LoadStore::MISS_LATENCY_CYCLES || scheduler.Warp(0).OutstandingLoads != 0 || scheduler.WaitingWarps() != 0)
+    {
+        ConPrinter::PrintLn("Ld/St warp completed in {} clocks with {} loads outstanding, expected at least the {} cycle miss latency.", clock, scheduler.Warp(0).OutstandingLoads, LoadStore::MISS_LATENCY_CYCLES);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully loaded and stored registers in {} clocks.", clock);
+    }
+
+    delete memory;
+    delete processor;
+}
+
+// Each load touches a new cache line, and the arithmetic after it depends on it.
+static constexpr u32 MEMORY_STALL_LOAD_COUNT = 8;
+
+struct MemoryStallTestMemory final
+{
+    alignas(64) u8 Program[256];
+    alignas(64) u32 Data[WARP_COUNT][(MEMORY_STALL_LOAD_COUNT + 1) * 8];
+    alignas(64) u32 Registers[WARP_COUNT][16];
+};
+
+static void WriteMemoryStallProgram(MemoryStallTestMemory& memory) noexcept
+{
+    u32 offset = 0;
+
+    for(u32 i = 0; i < MEMORY_STALL_LOAD_COUNT; ++i)
+    {
+        offset = WriteLoadStore(memory.Program, offset, false, 0, 3, static_cast<i16>(i * 8));
+        offset = WriteAddF(memory.Program, offset, 3, 3, 4);
+        offset = WriteAddF(memory.Program, offset, 4, 4, 5);
+    }
+
+    // The last value loaded goes after the loaded lines.
+    offset = WriteLoadStore(memory.Program, offset, true, 0, 3, static_cast<i16>(MEMORY_STALL_LOAD_COUNT * 8));
+    memory.Program[offset] = static_cast<u8>(EInstruction::Hlt);
+}
+
+// Runs warpCount copies of the memory bound program, returns the cycles the scheduler had warps active.
+[[nodiscard]] static u64 RunMemoryStallKernel(const EWarpSchedulingPolicy policy, const u32 warpCount, u64* const memoryStallSwitches, u32* const failedWarps) noexcept
+{
+    Processor* const processor = new(::std::nothrow) Processor;
+    processor->Reset();
+
+    MemoryStallTestMemory* const memory = new(::std::nothrow) MemoryStallTestMemory;
+    (void) ::std::memset(memory, 0, sizeof(*memory));
+    WriteMemoryStallProgram(*memory);
+
+    StreamingMultiprocessor& sm = processor->TestStreamingMultiprocessor(0);
+    sm.SetWarpSchedulingPolicy(policy);
+
+    for(u32 i = 0; i < warpCount; ++i)
+    {
+        for(u32 j = 0; j < MEMORY_STALL_LOAD_COUNT; ++j)
+        {
+            memory->Data[i][j * 8] = WarpRegisterPattern(i, j, 3);
+        }
+
+        WriteBasePointer(memory->Registers[i], memory->Data[i]);
+
+        (void) processor->TestLaunchWarp(0, 0, reinterpret_cast<u64>(memory->Program), 0x1, 15, WordAddress(memory->Registers[i]), FpMode { });
+    }
+
+    const WarpScheduler& scheduler = sm.TestWarpScheduler(0);
+
+    for(u32 clock = 0; clock < CLOCK_LIMIT && scheduler.ActiveWarps() != 0; ++clock)
+    {
+        processor->Clock();
+    }
+
+    processor->FlushCache(0);
+
+    *failedWarps = warpCount - static_cast<u32>(scheduler.CompletedWarps());
+
+    for(u32 i = 0; i < warpCount; ++i)
+    {
+        if(memory->Data[i][MEMORY_STALL_LOAD_COUNT * 8] != WarpRegisterPattern(i, MEMORY_STALL_LOAD_COUNT - 1, 3))
+        {
+            ++*failedWarps;
+        }
+    }
+
+    *memoryStallSwitches = scheduler.MemoryStallSwitches();
+    const u64 activeCycles = scheduler.ActiveCycles();
+
+    delete memory;
+    delete processor;
+
+    return activeCycles;
+}
+
+// While one warp waits on a load the others should be issuing theirs, 8 warps shouldn't take anywhere near 8 times as long as 1.
+static void TestMemoryStallSwitching(const EWarpSchedulingPolicy policy, const char* const policyName) noexcept
+{
+    constexpr u32 warpCount = 8;
+
+    u64 singleSwitches;
+    u32 singleFailed;
+    const u64 singleCycles = RunMemoryStallKernel(policy, 1, &singleSwitches, &singleFailed);
+
+    u64 switches;
+    u32 failed;
+    const u64 cycles = RunMemoryStallKernel(policy, warpCount, &switches, &failed);
+
+    if(singleFailed != 0 || failed != 0)
+    {
+        ConPrinter::PrintLn("Warp scheduler ({}) failed {} of 1 and {} of {} memory bound warps.", policyName, singleFailed, failed, warpCount);
+    }
+    else if(singleSwitches != 0 || switches == 0)
+    {
+        ConPrinter::PrintLn("Warp scheduler ({}) switched {} times on a memory stall with 1 warp and {} times with {}.", policyName, singleSwitches, switches, warpCount);
+    }
+    else if(singleCycles < MEMORY_STALL_LOAD_COUNT * LoadStore::MISS_LATENCY_CYCLES || cycles * 2 > singleCycles * warpCount)
+    {
+        ConPrinter::PrintLn("Warp scheduler ({}) took {} cycles for 1 memory bound warp and {} for {}.", policyName, singleCycles, cycles, warpCount);
+    }
+    else
+    {
+        ConPrinter::PrintLn("Successfully hid memory latency with {} warps ({}), {} cycles against {} for 1 warp, {} switches.", warpCount, policyName, cycles, singleCycles, switches);
+    }
+}